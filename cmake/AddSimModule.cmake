@@ -0,0 +1,58 @@
+#[=======================================================================[.rst:
+AddSimModule.cmake
+--------------------
+
+This module builds a module type's simulator as a plugin for the sim host
+(``common/simulator``), which runs simulated modules of any mix of types in
+one process.
+
+Every module type's simulator reuses the same names for its tasks, messages
+and queues, so their code can't simply be linked into one executable. Each
+plugin is instead a shared object that the host opens with RTLD_LOCAL. The
+plugin is built with hidden visibility and links its core library and the
+static libraries it depends on into itself without exporting them, and binds
+its own references to its own definitions, so that two plugins never see
+each other's symbols. The only symbol a plugin exports is the one the host
+looks up by name (see ``include/common/simulator/sim_module.hpp``).
+
+Static libraries linked into a plugin have to be position independent, so
+``CMAKE_POSITION_INDEPENDENT_CODE`` must be on for them, and plugins are
+written next to the host in ``SIM_HOST_OUTPUT_DIRECTORY`` so the host can
+find them.
+
+ADD_SIM_MODULE
+^^^^^^^^^^^^^^^^
+
+``ADD_SIM_MODULE`` adds the plugin target for a module type.
+
+Input Variables
++++++++++++++++
+
+``MODULE_NAME``
+A mandatory positional argument that is the module type, which is also the
+name the host is asked to load it by (``--module <MODULE_NAME>=<socket>``)
+
+Any further arguments are the plugin's sources.
+
+Result Variables
+++++++++++++++++
+This will define a target called ``${MODULE_NAME}-sim-module``, which callers
+should give the same include directories and libraries as the module's
+simulator, and make the ``sim-host`` target depend on it.
+#]=======================================================================]
+
+function(ADD_SIM_MODULE MODULE_NAME)
+  set(PLUGIN ${MODULE_NAME}-sim-module)
+  add_library(${PLUGIN} MODULE ${ARGN})
+  set_target_properties(${PLUGIN}
+    PROPERTIES PREFIX ""
+               CXX_STANDARD 20
+               CXX_STANDARD_REQUIRED TRUE
+               C_VISIBILITY_PRESET hidden
+               CXX_VISIBILITY_PRESET hidden
+               VISIBILITY_INLINES_HIDDEN TRUE
+               LIBRARY_OUTPUT_DIRECTORY ${SIM_HOST_OUTPUT_DIRECTORY})
+  target_link_options(${PLUGIN}
+    PRIVATE -Wl,--exclude-libs,ALL -Wl,-Bsymbolic -Wl,--no-undefined)
+  add_dependencies(sim-host ${PLUGIN})
+endfunction()
@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+"""Convert M931.D trace dumps into Chrome trace-event JSON.
+
+The output can be loaded in chrome://tracing or https://ui.perfetto.dev.
+
+A dump is the sequence of responses to M931.D S<index> requests, one per
+line, e.g.
+
+    M931.D T:170 N:256 S:0 0001a2f0:0001B 0001a9c4:0001E ... OK
+
+Recording is started on the module with M931.D E and is paused by the
+first M931.D S<index> request. The dump can either be read from a file, or
+pulled directly from a module over its serial port (which requires
+pyserial).
+"""
+import argparse
+import json
+import re
+import sys
+from typing import Dict, Iterable, List, TextIO, Tuple
+
+HEADER = re.compile(r"^M931\.D T:(\d+) N:(\d+) S:(\d+)")
+EVENT = re.compile(r"([0-9a-f]{8}):([0-9a-f]{4})([BEi])")
+
+# Names of the trace points in include/common/core/trace.hpp
+EVENT_NAMES = {
+    1: "plate control tick",
+    2: "lid control tick",
+    3: "thermistor read",
+    4: "ADC conversion complete",
+    5: "motor interrupt tick",
+}
+TASK_NAMES = {
+    0: "host comms",
+    1: "system",
+    2: "thermal plate",
+    3: "lid heater",
+    4: "motor",
+    5: "motor driver",
+}
+MESSAGE_HANDLING = 0x8000
+COUNTER_RANGE = 1 << 32
+
+Event = Tuple[int, int, str]
+
+
+def parse_dump(lines: Iterable[str]) -> Tuple[int, List[Event]]:
+    """Parse dump lines into the clock rate and a list of events.
+
+    Args:
+        lines: M931.D response lines; anything else is ignored
+
+    Returns:
+        The number of clock ticks per microsecond, and the events as
+        (timestamp, id, phase) tuples, oldest first
+    """
+    ticks_per_us = 0
+    events: Dict[int, Event] = {}
+    for line in lines:
+        header = HEADER.match(line.strip())
+        if not header:
+            continue
+        ticks_per_us = int(header.group(1))
+        index = int(header.group(3))
+        for match in EVENT.finditer(line[header.end() :]):
+            events[index] = (
+                int(match.group(1), 16),
+                int(match.group(2), 16),
+                match.group(3),
+            )
+            index += 1
+    if ticks_per_us == 0:
+        raise RuntimeError("no M931.D responses found in dump")
+    return ticks_per_us, [events[i] for i in sorted(events)]
+
+
+def event_name(event_id: int) -> Tuple[str, str]:
+    """Get the name and thread name for an event id."""
+    if event_id & MESSAGE_HANDLING:
+        task = (event_id >> 8) & 0x7F
+        task_name = TASK_NAMES.get(task, f"task {task}")
+        return f"message {event_id & 0xFF}", task_name
+    name = EVENT_NAMES.get(event_id, f"event {event_id}")
+    return name, name
+
+
+def tick_delta(previous: int, timestamp: int) -> int:
+    """Get the signed number of ticks between two 32 bit timestamps.
+
+    An event that was preempted between claiming its slot and reading the
+    clock lands in the ring just before an event with an older timestamp,
+    so the delta can be slightly negative as well as wrapped.
+
+    >>> tick_delta(0xFFFFFFF0, 0x10)
+    32
+    >>> tick_delta(0x1000, 0x0F00)
+    -256
+    """
+    delta = (timestamp - previous) % COUNTER_RANGE
+    return delta - COUNTER_RANGE if delta >= COUNTER_RANGE // 2 else delta
+
+
+def to_chrome(ticks_per_us: int, events: List[Event]) -> Dict:
+    """Build a Chrome trace-event document.
+
+    Timestamps are unwrapped across 32 bit counter overflows and made
+    relative to the first event.
+
+    >>> doc = to_chrome(1, [(0xFFFFFFF0, 1, "B"), (0x20, 3, "i"),
+    ...                     (0x10, 1, "E")])
+    >>> [event["ts"] for event in doc["traceEvents"] if event["ph"] != "M"]
+    [0.0, 48.0, 32.0]
+    """
+    trace_events = []
+    threads: Dict[str, int] = {}
+    previous = None
+    elapsed = 0
+    for timestamp, event_id, phase in events:
+        if previous is not None:
+            elapsed += tick_delta(previous, timestamp)
+        previous = timestamp
+        name, thread = event_name(event_id)
+        tid = threads.setdefault(thread, len(threads) + 1)
+        entry = {
+            "name": name,
+            "ph": phase,
+            "ts": elapsed / ticks_per_us,
+            "pid": 1,
+            "tid": tid,
+        }
+        if phase == "i":
+            entry["s"] = "t"
+        trace_events.append(entry)
+    for thread, tid in threads.items():
+        trace_events.append(
+            {
+                "name": "thread_name",
+                "ph": "M",
+                "pid": 1,
+                "tid": tid,
+                "args": {"name": thread},
+            }
+        )
+    return {"traceEvents": trace_events, "displayTimeUnit": "ns"}
+
+
+def read_from_port(port: str, baud: int) -> List[str]:
+    """Pause tracing on a module and read out the whole ring.
+
+    Recording is restarted once the ring has been read.
+    """
+    import serial  # type: ignore
+
+    lines = []
+    with serial.Serial(port, baud, timeout=2) as ser:
+        start = 0
+        while True:
+            ser.write(f"M931.D S{start}\n".encode())
+            line = ser.readline().decode()
+            header = HEADER.match(line)
+            if not header:
+                raise RuntimeError(f"unexpected response: {line}")
+            lines.append(line)
+            count = len(EVENT.findall(line))
+            start += count
+            if count == 0 or start >= int(header.group(2)):
+                break
+        ser.write(b"M931.D E\n")
+        ser.readline()
+    return lines
+
+
+def main() -> None:
+    """Entry point."""
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument(
+        "-i", "--input", type=argparse.FileType("r"), help="file of M931.D responses"
+    )
+    source.add_argument("-p", "--port", type=str, help="serial port of a module")
+    parser.add_argument("-b", "--baud", type=int, default=115200)
+    parser.add_argument(
+        "-o",
+        "--output",
+        type=argparse.FileType("w"),
+        default=sys.stdout,
+        help="path of the JSON file to write; defaults to stdout",
+    )
+    args = parser.parse_args()
+
+    lines = read_from_port(args.port, args.baud) if args.port else args.input
+    ticks_per_us, events = parse_dump(lines)
+    output: TextIO = args.output
+    json.dump(to_chrome(ticks_per_us, events), output, indent=1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,177 @@
+/*
+ * A sim host runs a deck of simulated modules of any mix of types in one
+ * process. Their tasks share a small worker pool and a simulated clock, so
+ * each module only needs a thread of its own to wait for input from its
+ * socket. Each module type is loaded from its plugin (see
+ * simulator/sim_module.hpp).
+ */
+#include <dlfcn.h>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/program_options.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "simulator/sim_clock.hpp"
+#include "simulator/sim_module.hpp"
+#include "simulator/sim_worker_pool.hpp"
+
+namespace {
+
+struct HostOptions {
+    // The type and socket of each module, as "<type>=<socket>"
+    std::vector<std::string> modules;
+    // Threads in the worker pool shared by every module
+    size_t workers;
+    double speedup;
+};
+
+[[noreturn]] void options_error(
+    const boost::program_options::options_description& desc,
+    const std::string& message) {
+    std::cerr << std::endl
+              << "ERROR: " << message << std::endl
+              << std::endl;
+    std::cerr << desc << std::endl;
+    exit(1);
+}
+
+auto check_realtime_environment_variable() -> bool {
+    constexpr const char realtime_var_name[] = "USE_REALTIME_SIM";
+    constexpr const char string_true[] = "true";
+    const auto* var_value = getenv(realtime_var_name);
+
+    if (!var_value || strlen(var_value) == 0) {
+        return false;
+    }
+
+    // Convert to lowercase
+    auto var_string = std::string(var_value);
+    boost::algorithm::to_lower(var_string);
+
+    return var_string.starts_with(string_true);
+}
+
+auto get_host_options(int num_args, char* args[]) -> HostOptions {
+    auto options = HostOptions{.modules = {},
+                               .workers = 2,
+                               .speedup = sim_clock::SimClock::LOCKSTEP};
+    bool realtime = false;
+
+    boost::program_options::options_description desc("Allowed options");
+    desc.add_options()("help", "Show this help message")(
+        "module",
+        boost::program_options::value<std::vector<std::string>>(
+            &options.modules)
+            ->composing(),
+        "Add a module that takes G-Codes from a socket, as "
+        "<module type>=<socket>. May be given more than once")(
+        "workers",
+        boost::program_options::value<size_t>(&options.workers)
+            ->default_value(2),
+        "Number of threads shared by every module")(
+        "realtime", boost::program_options::bool_switch(&realtime),
+        "Thermal and motor data should run in real time")(
+        "speedup",
+        boost::program_options::value<double>(&options.speedup)
+            ->default_value(sim_clock::SimClock::LOCKSTEP),
+        "Run the simulated clock this many times faster than real time, "
+        "instead of in lockstep with the tasks. Runs at a speedup are "
+        "not repeatable");
+
+    boost::program_options::variables_map vm;
+    auto parser =
+        boost::program_options::command_line_parser(num_args, args)
+            .options(desc)
+            .style(boost::program_options::command_line_style::default_style &
+                   ~boost::program_options::command_line_style::allow_guessing)
+            .run();
+    boost::program_options::store(parser, vm);
+    boost::program_options::notify(vm);
+
+    if (vm.count("help")) {
+        std::cout << desc << std::endl;
+        exit(0);
+    }
+    if (options.modules.empty()) {
+        options_error(desc, "You must provide at least one --module option.");
+    }
+    for (const auto& module : options.modules) {
+        if (module.find('=') == std::string::npos) {
+            options_error(desc, "Malformed module " + module +
+                                    ", expected <module type>=<socket>.");
+        }
+    }
+    if (options.speedup < sim_clock::SimClock::LOCKSTEP) {
+        options_error(desc, "--speedup can't be negative");
+    }
+    if (realtime || check_realtime_environment_variable()) {
+        options.speedup = sim_clock::SimClock::REALTIME;
+    }
+    return options;
+}
+
+// Load the plugin for a module type from the host's own directory. A plugin
+// is loaded once however many of its modules there are, and never unloaded,
+// since the pool holds jobs whose code is in it until the host exits.
+auto load_module_type(const std::string& type,
+                      std::map<std::string, sim_module::AddFunction>& loaded)
+    -> sim_module::AddFunction {
+    if (auto found = loaded.find(type); found != loaded.end()) {
+        return found->second;
+    }
+    auto path = std::filesystem::read_symlink("/proc/self/exe").parent_path() /
+                (type + "-sim-module.so");
+    auto* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr) {
+        std::cerr << "ERROR: Can't load module type " << type << ": "
+                  << dlerror() << std::endl;
+        exit(1);
+    }
+    auto* add = reinterpret_cast<sim_module::AddFunction>(
+        dlsym(handle, sim_module::ADD_FUNCTION));
+    if (add == nullptr) {
+        std::cerr << "ERROR: " << path << " isn't a sim module: " << dlerror()
+                  << std::endl;
+        exit(1);
+    }
+    loaded.emplace(type, add);
+    return add;
+}
+
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int {
+    auto options = get_host_options(argc, argv);
+    auto clock = std::make_shared<sim_clock::SimClock>(options.speedup);
+    auto pool = sim_worker_pool::WorkerPool(clock, options.workers);
+
+    std::map<std::string, sim_module::AddFunction> loaded;
+    std::vector<std::unique_ptr<sim_module::SimModule>> modules;
+    for (const auto& module : options.modules) {
+        auto split = module.find('=');
+        auto add = load_module_type(module.substr(0, split), loaded);
+        modules.emplace_back(add(pool, module.substr(split + 1).c_str()));
+    }
+    pool.start();
+
+    std::vector<std::jthread> inputs;
+    for (auto& module : modules) {
+        inputs.emplace_back([&module]() { module->read_input(); });
+    }
+
+    // The host runs until every connection is closed
+    inputs.clear();
+    pool.stop();
+    // The modules' tasks are only deleted once nothing can run them
+    modules.clear();
+
+    return 0;
+}
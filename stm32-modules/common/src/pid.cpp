@@ -63,6 +63,20 @@ auto PID::reset() -> void {
     _reset_trigger = NONE;
 }
 
+auto PID::seed(double error, double iterm) -> void {
+    _last_error = error;
+    _last_iterm = std::clamp(iterm, windup_limit_low(), windup_limit_high());
+    _reset_trigger = NONE;
+}
+
+auto PID::set_gains(double kp, double ki, double kd) -> void {
+    _last_iterm = std::clamp(last_iterm() + ((_kp - kp) * last_error()),
+                             windup_limit_low(), windup_limit_high());
+    _kp = kp;
+    _ki = ki;
+    _kd = kd;
+}
+
 auto PID::arm_integrator_reset(double error, double threshold) -> void {
     if (error <= 0) {
         _reset_trigger = RISING;
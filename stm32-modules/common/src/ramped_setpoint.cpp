@@ -0,0 +1,27 @@
+#include "core/ramped_setpoint.hpp"
+
+#include <algorithm>
+
+using namespace ramped_setpoint;
+
+auto RampedSetpoint::start(double current, double target, double rate)
+    -> void {
+    _target = target;
+    _rate = std::max(rate, RAMP_INFINITE);
+    _setpoint = (_rate == RAMP_INFINITE) ? target : current;
+    _arrived = false;
+}
+
+auto RampedSetpoint::update(double time) -> double {
+    if (!ramping()) {
+        return _setpoint;
+    }
+    auto step = _rate * time;
+    if (_setpoint < _target) {
+        _setpoint = std::min(_setpoint + step, _target);
+    } else {
+        _setpoint = std::max(_setpoint - step, _target);
+    }
+    _arrived = !ramping();
+    return _setpoint;
+}
@@ -0,0 +1,126 @@
+#include "core/relay_autotune.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+using namespace relay_autotune;
+
+// Classic Ziegler-Nichols PID tuning rules
+static constexpr double ZN_KP = 0.6;
+static constexpr double ZN_TI = 0.5;
+static constexpr double ZN_TD = 0.125;
+
+auto RelayAutotune::start(const Settings& settings) -> void {
+    _settings = settings;
+    _status = Status::RUNNING;
+    _result = Result();
+    _output_is_high = true;
+    _rising_switches = 0;
+    _elapsed = 0.0F;
+    _cycle_start = 0.0F;
+    _cycle_max = settings.setpoint;
+    _cycle_min = settings.setpoint;
+    _cycles = 0;
+    _period_sum = 0.0F;
+    _amplitude_sum = 0.0F;
+    _relay_sum = 0.0F;
+    _time_high = 0.0F;
+    _time_low = 0.0F;
+    set_bias(settings.bias.value_or(
+        // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+        (settings.output_high + settings.output_low) / 2.0));
+}
+
+auto RelayAutotune::abort() -> void {
+    if (running()) {
+        _status = Status::FAILED;
+    }
+}
+
+auto RelayAutotune::update(double temperature, double sampletime) -> double {
+    if (!running()) {
+        return 0.0F;
+    }
+    _elapsed += sampletime;
+    if (_elapsed > _settings.timeout) {
+        _status = Status::FAILED;
+        return 0.0F;
+    }
+    _cycle_max = std::max(_cycle_max, temperature);
+    _cycle_min = std::min(_cycle_min, temperature);
+    if (_output_is_high) {
+        _time_high += sampletime;
+    } else {
+        _time_low += sampletime;
+    }
+
+    if (_output_is_high &&
+        temperature > _settings.setpoint + _settings.hysteresis) {
+        _output_is_high = false;
+    } else if (!_output_is_high &&
+               temperature < _settings.setpoint - _settings.hysteresis) {
+        _output_is_high = true;
+        ++_rising_switches;
+        // The first rising switch ends the initial approach, and the
+        // oscillation after it is still settling, so neither is measured
+        auto cycle_time = _time_high + _time_low;
+        if (_rising_switches > 1 && cycle_time > 0.0F) {
+            auto imbalance = (_time_high - _time_low) / cycle_time;
+            if (_rising_switches > 2 && std::abs(imbalance) < MAX_IMBALANCE) {
+                _period_sum += _elapsed - _cycle_start;
+                // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+                _amplitude_sum += (_cycle_max - _cycle_min) / 2.0;
+                _relay_sum += _relay;
+                ++_cycles;
+                if (_cycles >= MEASURED_CYCLES) {
+                    finish();
+                    return 0.0F;
+                }
+            }
+            // Move the bias towards the output that was held for longer
+            set_bias(_bias + _relay * imbalance);
+        }
+        _time_high = 0.0F;
+        _time_low = 0.0F;
+        _cycle_start = _elapsed;
+        _cycle_max = temperature;
+        _cycle_min = temperature;
+    }
+    return _output_is_high ? _bias + _relay : _bias - _relay;
+}
+
+auto RelayAutotune::set_bias(double bias) -> void {
+    auto range = _settings.output_high - _settings.output_low;
+    auto margin = MIN_RELAY_FRACTION * range;
+    _bias = std::clamp(bias, _settings.output_low + margin,
+                       _settings.output_high - margin);
+    _relay = std::min(_bias - _settings.output_low,
+                      _settings.output_high - _bias);
+    if (_settings.amplitude.has_value()) {
+        _relay = std::min(_relay, _settings.amplitude.value());
+    }
+}
+
+auto RelayAutotune::finish() -> void {
+    auto amplitude = _amplitude_sum / static_cast<double>(_cycles);
+    auto period = _period_sum / static_cast<double>(_cycles);
+    auto hysteresis = std::abs(_settings.hysteresis);
+    if (amplitude <= hysteresis || period <= 0.0F) {
+        _status = Status::FAILED;
+        return;
+    }
+    auto relay = _relay_sum / static_cast<double>(_cycles);
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+    auto oscillation = std::sqrt((amplitude * amplitude) -
+                                 (hysteresis * hysteresis));
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+    auto ultimate_gain = (4.0 * relay) / (std::numbers::pi * oscillation);
+    auto kp = ZN_KP * ultimate_gain;
+    _result = Result{.ultimate_gain = ultimate_gain,
+                     .ultimate_period = period,
+                     .kp = kp,
+                     .ki = kp / (ZN_TI * period),
+                     .kd = kp * ZN_TD * period};
+    _status = Status::DONE;
+}
@@ -0,0 +1,37 @@
+#include "core/trace.hpp"
+
+#include "core/trace_c.h"
+
+static_assert(TRACE_ID_ADC_CONVERSION_COMPLETE ==
+                  trace::EventId::ADC_CONVERSION_COMPLETE,
+              "C trace ids must match trace::EventId");
+
+namespace trace {
+
+// These are shared by every trace point in the application, so they have
+// to live at file scope.
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+static std::atomic<ClockFunction> _clock{nullptr};
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+static std::atomic<uint32_t> _ticks_per_us{0};
+
+auto install_clock(ClockFunction clock, uint32_t ticks_per_us) -> void {
+    _ticks_per_us.store(ticks_per_us, std::memory_order_relaxed);
+    _clock.store(clock, std::memory_order_release);
+}
+
+auto ticks_per_us() -> uint32_t {
+    return _ticks_per_us.load(std::memory_order_relaxed);
+}
+
+auto detail::record_enabled(uint16_t id, Phase phase) -> void {
+    auto* clock = _clock.load(std::memory_order_acquire);
+    if (clock == nullptr) {
+        return;
+    }
+    buffer.record(id, phase, clock);
+}
+
+}  // namespace trace
+
+extern "C" void trace_instant(uint16_t id) { trace::instant(id); }
@@ -106,3 +106,63 @@ TEST_CASE("AT24C0XC class functionality") {
         }
     }
 }
+
+TEST_CASE("AT24C0XC RAM shadow") {
+    using namespace at24c0xc;
+    constexpr const size_t pages = 16;
+    constexpr const uint8_t address = 0b1010100;
+    GIVEN("an AT24C0xC with data already on the device") {
+        auto policy = TestAT24C0XCPolicy<pages>();
+        auto eeprom = AT24C0xC<pages, address>();
+        policy._buffer.at(8 * 3) = 0x42;
+        REQUIRE(!eeprom.loaded());
+        WHEN("reading several pages") {
+            auto first = eeprom.read_value<uint8_t>(3, policy);
+            auto second = eeprom.read_value<uint8_t>(5, policy);
+            THEN("the whole device is read once and served from RAM") {
+                REQUIRE(first.value() == 0x42);
+                REQUIRE(second.value() == 0);
+                REQUIRE(eeprom.loaded());
+                REQUIRE(policy._reads == 1);
+            }
+        }
+        WHEN("staging values on two pages and flushing") {
+            REQUIRE(eeprom.stage_value(0, 1.0F, policy));
+            REQUIRE(eeprom.stage_value(1, 2.0F, policy));
+            REQUIRE(policy._data_writes == 0);
+            REQUIRE(eeprom.flush(policy));
+            THEN("each page is written once, as a whole page") {
+                REQUIRE(policy._data_writes == 2);
+                REQUIRE(policy._write_protect);
+                float readback = 0;
+                memcpy(&readback, &policy._buffer.at(8), sizeof(readback));
+                REQUIRE(readback == 2.0F);
+                AND_THEN("the data beyond the value is kept") {
+                    REQUIRE(policy._buffer.at(8 * 3) == 0x42);
+                }
+            }
+        }
+        WHEN("writing a value that is already stored") {
+            REQUIRE(eeprom.write_value(3, static_cast<uint8_t>(0x42), policy));
+            THEN("nothing is written") { REQUIRE(policy._data_writes == 0); }
+        }
+        WHEN("the device is busy for a while after each write") {
+            policy._busy_polls = 10;
+            REQUIRE(eeprom.write_value(2, 5.0F, policy));
+            THEN("the write waits for the device to finish") {
+                REQUIRE(policy._data_writes == 1);
+                REQUIRE(eeprom.read_value<float>(2, policy).value() == 5.0F);
+            }
+        }
+        WHEN("the device never finishes its write cycle") {
+            policy._busy_polls = AT24C0xC<pages, address>::WRITE_POLL_ATTEMPTS;
+            REQUIRE(!eeprom.write_value(2, 5.0F, policy));
+            THEN("the shadow is dropped and reloaded on the next read") {
+                REQUIRE(!eeprom.loaded());
+                policy._busy_polls = 0;
+                REQUIRE(eeprom.read_value<float>(2, policy).value() == 5.0F);
+                REQUIRE(policy._reads == 2);
+            }
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#include "catch2/catch.hpp"
+#include "core/delegate.hpp"
+
+using namespace delegate;
+
+namespace {
+
+// Stands in for a motor task, with a per-tick callback that takes the
+// policy it should act on
+struct Stepper {
+    uint32_t ticks = 0;
+    uint32_t steps = 0;
+
+    auto tick(uint32_t& pulses) -> void {
+        ++ticks;
+        if ((ticks & 0x3) == 0) {
+            ++steps;
+            ++pulses;
+        }
+    }
+
+    [[nodiscard]] auto doubled(int value) const -> int { return value * 2; }
+};
+
+auto negate(int value) -> int { return -value; }
+
+}  // namespace
+
+SCENARIO("delegates call what they are bound to") {
+    GIVEN("an empty delegate") {
+        auto callback = Delegate<void(uint32_t&)>();
+        THEN("it reports that nothing is bound") { REQUIRE(!callback); }
+    }
+    GIVEN("a delegate bound to a member function") {
+        auto stepper = Stepper();
+        auto callback =
+            Delegate<void(uint32_t&)>::bind<&Stepper::tick>(stepper);
+        REQUIRE(callback);
+        WHEN("calling it") {
+            uint32_t pulses = 0;
+            for (int i = 0; i < 8; ++i) {
+                callback(pulses);
+            }
+            THEN("the member function runs on the bound object") {
+                REQUIRE(stepper.ticks == 8);
+                REQUIRE(stepper.steps == 2);
+                REQUIRE(pulses == 2);
+            }
+        }
+        WHEN("copying it") {
+            auto copy = callback;
+            uint32_t pulses = 0;
+            copy(pulses);
+            THEN("the copy calls the same object") {
+                REQUIRE(stepper.ticks == 1);
+            }
+        }
+    }
+    GIVEN("a delegate bound to a const member function") {
+        const auto stepper = Stepper();
+        auto callback = Delegate<int(int)>::bind<&Stepper::doubled>(stepper);
+        THEN("it returns the member function's result") {
+            REQUIRE(callback(21) == 42);
+        }
+    }
+    GIVEN("a delegate bound to a free function") {
+        auto callback = Delegate<int(int)>::bind<&negate>();
+        THEN("it returns the function's result") {
+            REQUIRE(callback(5) == -5);
+        }
+    }
+    THEN("delegates are trivially copyable") {
+        STATIC_REQUIRE(std::is_trivially_copyable_v<Delegate<void()>>);
+    }
+}
@@ -0,0 +1,175 @@
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "core/i2c_bus.hpp"
+#include "test/test_i2c_bus_policy.hpp"
+
+using namespace i2c_bus;
+using namespace i2c_bus_test_policy;
+
+static constexpr uint16_t ADC_ADDRESS = 0x90;
+static constexpr uint16_t EEPROM_ADDRESS = 0xA0;
+static constexpr uint16_t LED_ADDRESS = 0xA8;
+
+struct Completion {
+    uint16_t address;
+    bool success;
+};
+
+// Records every callback, in order
+struct Recorder {
+    std::vector<Completion> completions{};
+
+    static auto callback(const Transaction& transaction, bool success,
+                         void* context) -> void {
+        static_cast<Recorder*>(context)->completions.push_back(
+            Completion{.address = transaction.address, .success = success});
+    }
+
+    auto transaction(Type type, Priority priority, uint16_t address,
+                     uint8_t* data, uint16_t length) -> Transaction {
+        return Transaction{.type = type,
+                           .priority = priority,
+                           .address = address,
+                           .mem_address = 0x10,
+                           .data = data,
+                           .length = length,
+                           .callback = callback,
+                           .context = this};
+    }
+};
+
+SCENARIO("i2c bus manager runs transactions") {
+    GIVEN("a bus manager with an ADC and an EEPROM") {
+        auto policy = I2CBusTestPolicy();
+        auto manager = BusManager<I2CBusTestPolicy, 4>(policy);
+        auto recorder = Recorder();
+        policy.add_device(ADC_ADDRESS).registers.at(0x10) = 0xAB;
+        policy.device(ADC_ADDRESS).registers.at(0x11) = 0xCD;
+        policy.add_device(EEPROM_ADDRESS);
+        REQUIRE(!manager.busy());
+        WHEN("submitting a read to an idle bus") {
+            auto buffer = std::array<uint8_t, 2>{};
+            REQUIRE(manager.submit(recorder.transaction(
+                Type::MEM_READ, Priority::SENSOR, ADC_ADDRESS, buffer.data(),
+                buffer.size())));
+            THEN("the transfer starts straight away") {
+                REQUIRE(manager.busy());
+                REQUIRE(policy.transfer_active());
+                REQUIRE(manager.pending() == 0);
+                REQUIRE(recorder.completions.empty());
+            }
+            AND_WHEN("the transfer completes") {
+                manager.complete(policy.finish());
+                THEN("the callback has the data") {
+                    REQUIRE(!manager.busy());
+                    REQUIRE(recorder.completions.size() == 1);
+                    REQUIRE(recorder.completions.at(0).success);
+                    REQUIRE(buffer == std::array<uint8_t, 2>{0xAB, 0xCD});
+                    REQUIRE(manager.completed() == 1);
+                    REQUIRE(!policy._locked);
+                }
+            }
+        }
+        WHEN("transactions arrive while the bus is busy") {
+            auto led = std::array<uint8_t, 4>{1, 2, 3, 4};
+            auto eeprom = std::array<uint8_t, 2>{5, 6};
+            auto adc = std::array<uint8_t, 2>{};
+            policy.add_device(LED_ADDRESS);
+            manager.submit(recorder.transaction(Type::MEM_WRITE,
+                                                Priority::BACKGROUND,
+                                                LED_ADDRESS, led.data(), 4));
+            manager.submit(recorder.transaction(
+                Type::MEM_WRITE, Priority::BACKGROUND, EEPROM_ADDRESS,
+                eeprom.data(), 2));
+            manager.submit(recorder.transaction(Type::MEM_READ,
+                                                Priority::SENSOR, ADC_ADDRESS,
+                                                adc.data(), 2));
+            REQUIRE(manager.pending() == 2);
+            REQUIRE(manager.high_water() == 2);
+            THEN("each one starts as soon as the last finishes") {
+                manager.complete(policy.finish());
+                REQUIRE(manager.busy());
+                manager.complete(policy.finish());
+                REQUIRE(manager.busy());
+                manager.complete(policy.finish());
+                REQUIRE(!manager.busy());
+                AND_THEN("the sensor read jumped the queue") {
+                    REQUIRE(policy._started.size() == 3);
+                    REQUIRE(policy._started.at(0).address == LED_ADDRESS);
+                    REQUIRE(policy._started.at(1).address == ADC_ADDRESS);
+                    REQUIRE(policy._started.at(2).address == EEPROM_ADDRESS);
+                    REQUIRE(recorder.completions.at(1).address ==
+                            ADC_ADDRESS);
+                }
+                AND_THEN("the writes reached the devices") {
+                    auto& regs = policy.device(LED_ADDRESS).registers;
+                    REQUIRE(regs.at(0x10) == 1);
+                    REQUIRE(regs.at(0x13) == 4);
+                    REQUIRE(policy.device(EEPROM_ADDRESS).registers.at(
+                                0x11) == 6);
+                }
+            }
+        }
+        WHEN("a priority level fills up") {
+            auto buffer = std::array<uint8_t, 1>{};
+            for (int i = 0; i < 5; ++i) {
+                REQUIRE(manager.submit(recorder.transaction(
+                    Type::READ, Priority::BACKGROUND, EEPROM_ADDRESS,
+                    buffer.data(), 1)));
+            }
+            THEN("more transactions at that priority are rejected") {
+                REQUIRE(!manager.submit(recorder.transaction(
+                    Type::READ, Priority::BACKGROUND, EEPROM_ADDRESS,
+                    buffer.data(), 1)));
+                AND_THEN("other priorities are still accepted") {
+                    REQUIRE(manager.submit(recorder.transaction(
+                        Type::READ, Priority::SENSOR, ADC_ADDRESS,
+                        buffer.data(), 1)));
+                }
+            }
+        }
+        WHEN("a transfer fails") {
+            auto buffer = std::array<uint8_t, 1>{};
+            manager.submit(recorder.transaction(Type::READ, Priority::NORMAL,
+                                                0x42, buffer.data(), 1));
+            manager.complete(policy.finish());
+            THEN("its callback reports the failure") {
+                REQUIRE(recorder.completions.size() == 1);
+                REQUIRE(!recorder.completions.at(0).success);
+                REQUIRE(manager.failed() == 1);
+                REQUIRE(!manager.busy());
+            }
+        }
+        WHEN("a transfer can't be started") {
+            auto buffer = std::array<uint8_t, 1>{};
+            auto led = std::array<uint8_t, 1>{};
+            policy.add_device(LED_ADDRESS);
+            manager.submit(recorder.transaction(Type::READ, Priority::NORMAL,
+                                                EEPROM_ADDRESS, buffer.data(),
+                                                1));
+            manager.submit(recorder.transaction(Type::READ, Priority::SENSOR,
+                                                ADC_ADDRESS, buffer.data(),
+                                                1));
+            manager.submit(recorder.transaction(
+                Type::READ, Priority::NORMAL, LED_ADDRESS, led.data(), 1));
+            policy._fail_next_start = true;
+            manager.complete(policy.finish());
+            THEN("it fails and the next one starts instead") {
+                REQUIRE(recorder.completions.size() == 2);
+                REQUIRE(!recorder.completions.at(0).success);
+                REQUIRE(recorder.completions.at(0).address == ADC_ADDRESS);
+                REQUIRE(recorder.completions.at(1).success);
+                REQUIRE(manager.busy());
+                REQUIRE(policy._started.back().address == LED_ADDRESS);
+            }
+        }
+        WHEN("completing with nothing on the bus") {
+            manager.complete(true);
+            THEN("nothing happens") {
+                REQUIRE(recorder.completions.empty());
+                REQUIRE(manager.completed() == 0);
+            }
+        }
+    }
+}
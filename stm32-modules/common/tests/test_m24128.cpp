@@ -105,3 +105,63 @@ TEST_CASE("M24128 class functionality") {
         }
     }
 }
+
+TEST_CASE("M24128 RAM shadow") {
+    using namespace m24128;
+    constexpr const uint8_t address = 0b1010100;
+    GIVEN("an M24128 that shadows two pages") {
+        auto policy = TestM24128Policy();
+        auto eeprom = M24128<address, 2>();
+        policy._buffer.at(PAGE_LENGTH + 10) = 0x42;
+        WHEN("reading both shadowed pages") {
+            auto first = eeprom.read_value<uint8_t>(0, policy);
+            auto second = eeprom.read_value<uint8_t>(1, policy);
+            THEN("both pages are read together, once") {
+                REQUIRE(first.value() == 0);
+                REQUIRE(second.value() == 0);
+                REQUIRE(policy._reads == 1);
+            }
+        }
+        WHEN("staging two values on the same page and flushing") {
+            REQUIRE(eeprom.stage_value(1, 1.0F, policy));
+            REQUIRE(eeprom.stage_value(0, 2.0F, policy));
+            REQUIRE(eeprom.stage_value(1, 3.0F, policy));
+            REQUIRE(eeprom.flush(policy));
+            THEN("each page is written once, keeping the rest of the page") {
+                REQUIRE(policy._data_writes == 2);
+                REQUIRE(policy._buffer.at(PAGE_LENGTH + 10) == 0x42);
+                float readback = 0;
+                memcpy(&readback, &policy._buffer.at(PAGE_LENGTH),
+                       sizeof(readback));
+                REQUIRE(readback == 3.0F);
+            }
+        }
+        WHEN("flushing with nothing staged") {
+            REQUIRE(eeprom.flush(policy));
+            THEN("the device isn't touched") {
+                REQUIRE(policy._data_writes == 0);
+                REQUIRE(policy._reads == 0);
+            }
+        }
+        WHEN("the device is busy for a while after each write") {
+            policy._busy_polls = 20;
+            REQUIRE(eeprom.write_value(0, 4.0F, policy));
+            THEN("the write waits for the device to finish") {
+                REQUIRE(eeprom.read_value<float>(0, policy).value() == 4.0F);
+            }
+        }
+        WHEN("writing a page past the shadow") {
+            REQUIRE(eeprom.write_value(9, 6.0F, policy));
+            THEN("it is written and read directly") {
+                REQUIRE(policy._data_writes == 1);
+                REQUIRE(eeprom.read_value<float>(9, policy).value() == 6.0F);
+                REQUIRE(!eeprom.loaded());
+            }
+        }
+        WHEN("the device never finishes its write cycle") {
+            policy._busy_polls = M24128<address, 2>::WRITE_POLL_ATTEMPTS;
+            REQUIRE(!eeprom.write_value(0, 4.0F, policy));
+            THEN("the shadow is dropped") { REQUIRE(!eeprom.loaded()); }
+        }
+    }
+}
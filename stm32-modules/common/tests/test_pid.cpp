@@ -42,6 +42,46 @@ SCENARIO("PID controller") {
                 REQUIRE(p.last_iterm() == 4.0);
             }
         }
+        WHEN("changing the gains of a running controller") {
+            p.compute(0.5);
+            auto before = p.compute(0.5);
+            p.set_gains(2.0, 1.0, 0.0);
+            THEN("the new gains are used") {
+                REQUIRE(p.kp() == 2.0);
+                REQUIRE(p.ki() == 1.0);
+                REQUIRE(p.kd() == 0.0);
+            }
+            THEN("the output doesn't jump") {
+                // The only change left is the new integral contribution
+                auto after = p.compute(0.5);
+                REQUIRE_THAT(after,
+                             Catch::Matchers::WithinAbs(before + 0.5, 0.0001));
+            }
+        }
+        WHEN("changing the gains with a large error") {
+            p.compute(3.0);
+            p.set_gains(0.0, 2.0, 3.0);
+            THEN("the integral term stays within the windup limits") {
+                REQUIRE(p.last_iterm() == 4.0);
+            }
+        }
+        WHEN("seeding the controller state") {
+            p.compute(3.0);
+            p.seed(1.0, 1.5);
+            THEN("the state is set without an integration step") {
+                REQUIRE(p.last_error() == 1.0);
+                REQUIRE(p.last_iterm() == 1.5);
+            }
+            THEN("the next output continues from the seeded state") {
+                // pterm 1, iterm 1.5 + 2, no change in error for dterm
+                REQUIRE_THAT(p.compute(1.0),
+                             Catch::Matchers::WithinAbs(4.5, 0.0001));
+            }
+        }
+        WHEN("seeding an integral term beyond the windup limits") {
+            p.seed(0.0, -10.0);
+            THEN("it is clamped") { REQUIRE(p.last_iterm() == -5.0); }
+        }
     }
     GIVEN("a PID controller with only kp") {
         auto p = PID(2.0, 0, 0, 1.0);
@@ -0,0 +1,189 @@
+#include <cstdint>
+#include <variant>
+
+#include "catch2/catch.hpp"
+#include "core/queue_aggregator.hpp"
+#include "core/queue_stats.hpp"
+#include "test/test_message_queue.hpp"
+
+struct FastMessage {
+    uint32_t payload;
+};
+
+struct SlowMessage {
+    uint32_t a, b;
+};
+
+using StatsMessage = std::variant<std::monostate, FastMessage, SlowMessage>;
+using StatsQueue = TestMessageQueue<StatsMessage, 0, 4>;
+using OtherQueue = TestMessageQueue<std::variant<FastMessage>, 1>;
+
+SCENARIO("queue statistics track sends") {
+    GIVEN("a fresh queue") {
+        StatsQueue queue("stats");
+        THEN("the statistics are empty") {
+            auto stats = queue.get_stats();
+            REQUIRE(stats.capacity == 4);
+            REQUIRE(stats.high_water == 0);
+            REQUIRE(stats.sent == 0);
+            REQUIRE(stats.send_failures == 0);
+            REQUIRE(stats.max_handling_us == 0);
+            REQUIRE(stats.max_wait_us == 0);
+            REQUIRE(stats.stack_high_water == queue_stats::STACK_UNKNOWN);
+        }
+        WHEN("sending three messages and receiving one") {
+            REQUIRE(queue.try_send(FastMessage{.payload = 1}));
+            REQUIRE(queue.try_send(FastMessage{.payload = 2}));
+            REQUIRE(queue.try_send(FastMessage{.payload = 3}));
+            StatsMessage msg;
+            REQUIRE(queue.try_recv(&msg));
+            THEN("the high water mark stays at the deepest point") {
+                auto stats = queue.get_stats();
+                REQUIRE(stats.high_water == 3);
+                REQUIRE(stats.sent == 3);
+                REQUIRE(stats.send_failures == 0);
+            }
+        }
+        WHEN("a send fails") {
+            queue.act_full = true;
+            REQUIRE(!queue.try_send(FastMessage{.payload = 1}));
+            THEN("the failure is counted and the queue is marked as full") {
+                auto stats = queue.get_stats();
+                REQUIRE(stats.send_failures == 1);
+                REQUIRE(stats.sent == 0);
+                REQUIRE(stats.high_water == 4);
+            }
+            AND_WHEN("resetting the statistics") {
+                queue.reset_stats();
+                THEN("the counters are cleared") {
+                    auto stats = queue.get_stats();
+                    REQUIRE(stats.send_failures == 0);
+                    REQUIRE(stats.high_water == 0);
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("queue statistics track handling time per message type") {
+    GIVEN("a queue with one fast and one slow message") {
+        StatsQueue queue("stats");
+        REQUIRE(queue.try_send(FastMessage{.payload = 1}));
+        REQUIRE(queue.try_send(SlowMessage{.a = 1, .b = 2}));
+        WHEN("handling the messages with different durations") {
+            StatsMessage msg;
+            queue.ticks = 100;
+            REQUIRE(queue.try_recv(&msg));
+            queue.ticks = 102;
+            REQUIRE(queue.try_recv(&msg));
+            queue.ticks = 112;
+            REQUIRE(!queue.try_recv(&msg));
+            THEN("the slowest message type is reported") {
+                auto stats = queue.get_stats();
+                REQUIRE(stats.max_handling_us == 10);
+                REQUIRE(stats.slowest_message == 2);
+            }
+        }
+        WHEN("the task has not yet come back to the queue") {
+            StatsMessage msg;
+            queue.ticks = 5;
+            REQUIRE(queue.try_recv(&msg));
+            queue.ticks = 50;
+            THEN("the open handling window is not counted") {
+                REQUIRE(queue.get_stats().max_handling_us == 0);
+            }
+        }
+    }
+    GIVEN("a stats recorder") {
+        queue_stats::QueueStats<StatsMessage, 4> stats;
+        WHEN("the tick counter wraps while handling a message") {
+            stats.record_receive(1, 0xFFFFFFFC, 0xFFFFFFFE);
+            stats.record_idle(3);
+            THEN("the elapsed time is still correct") {
+                REQUIRE(stats.handling_ticks(1) == 5);
+                REQUIRE(stats.wait_ticks() == 2);
+            }
+        }
+        WHEN("converting ticks to microseconds") {
+            stats.record_receive(2, 0, 1700);
+            stats.record_idle(1700 + 17000);
+            THEN("the snapshot divides by the tick rate") {
+                auto snapshot = stats.snapshot(170);
+                REQUIRE(snapshot.max_wait_us == 10);
+                REQUIRE(snapshot.max_handling_us == 100);
+                REQUIRE(snapshot.slowest_message == 2);
+            }
+        }
+    }
+    GIVEN("a stats recorder that is compiled out") {
+        queue_stats::QueueStats<StatsMessage, 4, false> stats;
+        WHEN("recording a message") {
+            stats.record_send(true, 1);
+            stats.record_receive(1, 0, 10);
+            stats.record_idle(20);
+            THEN("nothing is kept but the capacity") {
+                auto snapshot = stats.snapshot(1);
+                REQUIRE(snapshot.capacity == 4);
+                REQUIRE(snapshot.sent == 0);
+                REQUIRE(snapshot.max_handling_us == 0);
+                REQUIRE(snapshot.max_wait_us == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("queue statistics track how long messages wait") {
+    GIVEN("a queue with two messages sent at different times") {
+        StatsQueue queue("stats");
+        queue.ticks = 10;
+        REQUIRE(queue.try_send(FastMessage{.payload = 1}));
+        queue.ticks = 30;
+        REQUIRE(queue.try_send(SlowMessage{.a = 1, .b = 2}));
+        WHEN("receiving both messages later") {
+            StatsMessage msg;
+            queue.ticks = 40;
+            REQUIRE(queue.try_recv(&msg));
+            queue.ticks = 45;
+            REQUIRE(queue.try_recv(&msg));
+            THEN("the longest wait is the first message's") {
+                REQUIRE(queue.get_stats().max_wait_us == 30);
+            }
+        }
+    }
+    GIVEN("a message added to the backing queue directly") {
+        StatsQueue queue("stats");
+        queue.backing_deque.push_back(FastMessage{.payload = 1});
+        WHEN("receiving it") {
+            StatsMessage msg;
+            queue.ticks = 100;
+            REQUIRE(queue.try_recv(&msg));
+            THEN("it is counted as not having waited") {
+                REQUIRE(queue.get_stats().max_wait_us == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("queue aggregator collects statistics") {
+    using Aggregator =
+        queue_aggregator::QueueAggregator<StatsQueue, OtherQueue>;
+    GIVEN("an aggregator with one registered queue") {
+        StatsQueue q1("1");
+        OtherQueue q2("2");
+        Aggregator aggregator;
+        REQUIRE(aggregator.register_queue(q1));
+        REQUIRE(aggregator.send(SlowMessage{.a = 1, .b = 2}));
+        WHEN("getting all statistics") {
+            auto stats = aggregator.get_all_stats();
+            THEN("the registered queue reports its statistics") {
+                REQUIRE(stats.size() == 2);
+                REQUIRE(stats.at(0).capacity == 4);
+                REQUIRE(stats.at(0).sent == 1);
+            }
+            THEN("the unregistered queue reports nothing") {
+                REQUIRE(stats.at(1).capacity == 0);
+                REQUIRE(stats.at(1).sent == 0);
+            }
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#include "catch2/catch.hpp"
+#include "core/pid.hpp"
+#include "core/ramped_setpoint.hpp"
+
+using namespace ramped_setpoint;
+
+static constexpr double SAMPLETIME = 0.1;
+
+SCENARIO("ramped setpoint") {
+    auto subject = RampedSetpoint();
+    GIVEN("a jump to a new target") {
+        subject.start(25.0F, 90.0F);
+        THEN("the setpoint moves straight to the target") {
+            REQUIRE(!subject.ramping());
+            REQUIRE(subject.setpoint() == 90.0F);
+            REQUIRE(subject.update(SAMPLETIME) == 90.0F);
+        }
+    }
+    GIVEN("a heating ramp at 2ºC/s") {
+        subject.start(25.0F, 35.0F, 2.0F);
+        REQUIRE(subject.ramping());
+        REQUIRE(subject.setpoint() == 25.0F);
+        REQUIRE(subject.target() == 35.0F);
+        WHEN("running for 2 seconds") {
+            for (int i = 0; i < 20; ++i) {
+                subject.update(SAMPLETIME);
+            }
+            THEN("the setpoint has moved 4ºC") {
+                REQUIRE(subject.setpoint() == Approx(29.0F));
+                REQUIRE(subject.ramping());
+            }
+        }
+        WHEN("running past the end of the ramp") {
+            for (int i = 0; i < 100; ++i) {
+                subject.update(SAMPLETIME);
+            }
+            THEN("the setpoint stops at the target") {
+                REQUIRE(subject.setpoint() == 35.0F);
+                REQUIRE(!subject.ramping());
+            }
+        }
+    }
+    GIVEN("a cooling ramp at 1ºC/s") {
+        subject.start(35.0F, 30.0F, 1.0F);
+        WHEN("running for 6 seconds") {
+            for (int i = 0; i < 60; ++i) {
+                subject.update(SAMPLETIME);
+            }
+            THEN("the setpoint reaches the target") {
+                REQUIRE(subject.setpoint() == 30.0F);
+            }
+        }
+    }
+    GIVEN("a negative ramp rate") {
+        subject.start(25.0F, 35.0F, -1.0F);
+        THEN("the setpoint jumps to the target") {
+            REQUIRE(subject.rate() == RampedSetpoint::RAMP_INFINITE);
+            REQUIRE(subject.setpoint() == 35.0F);
+        }
+    }
+}
+
+SCENARIO("ramped setpoint driving a PID") {
+    GIVEN("a PID with a pure integral term") {
+        auto pid = PID(0.0F, 1.0F, 0.0F, SAMPLETIME, 100.0F, -100.0F);
+        auto subject = RampedSetpoint();
+        subject.start(25.0F, 26.0F, 1.0F);
+        WHEN("the temperature lags behind the ramp") {
+            double output = 0.0F;
+            for (int i = 0; i < 15; ++i) {
+                output = subject.compute(pid, 25.0F, SAMPLETIME);
+            }
+            THEN("the controller runs against the ramped setpoint") {
+                REQUIRE(!subject.ramping());
+                REQUIRE(output > 0.0F);
+                REQUIRE(pid.last_error() == Approx(1.0F));
+            }
+            AND_WHEN("the temperature catches up with the target") {
+                output = subject.compute(pid, 26.5F, SAMPLETIME);
+                THEN("the integral built up during the ramp is dropped") {
+                    REQUIRE(pid.last_iterm() == Approx(-0.05F));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,190 @@
+#include <cmath>
+#include <deque>
+#include <numbers>
+
+#include "catch2/catch.hpp"
+#include "core/relay_autotune.hpp"
+
+using namespace relay_autotune;
+
+static constexpr double SAMPLETIME = 0.01;
+
+/**
+ * An integrating process with dead time, dT/dt = K * (u(t - theta) - L).
+ * The load L is the output needed to hold a temperature. Under relay
+ * feedback centered on L with no hysteresis this oscillates with a period
+ * of exactly 4 * theta and an amplitude of K * d * theta.
+ */
+struct IntegratorPlant {
+    double gain;
+    double temperature;
+    std::deque<double> delay;
+    double load;
+
+    IntegratorPlant(double gain, double dead_time, double start,
+                    double load = 0.0)
+        : gain(gain),
+          temperature(start),
+          delay(static_cast<size_t>(std::round(dead_time / SAMPLETIME)),
+                0.0),
+          load(load) {}
+
+    auto step(double power) -> double {
+        delay.push_back(power);
+        temperature += gain * (delay.front() - load) * SAMPLETIME;
+        delay.pop_front();
+        return temperature;
+    }
+};
+
+SCENARIO("relay autotune") {
+    GIVEN("an idle autotune") {
+        auto autotune = RelayAutotune();
+        THEN("it is not running and has no output") {
+            REQUIRE(autotune.status() == Status::IDLE);
+            REQUIRE(autotune.update(25.0, SAMPLETIME) == 0.0);
+        }
+    }
+    GIVEN("an autotune of an integrating process with dead time") {
+        auto plant = IntegratorPlant(1.0, 2.0, 50.0);
+        auto autotune = RelayAutotune();
+        autotune.start(Settings{.setpoint = 50.0,
+                                .output_high = 1.0,
+                                .output_low = -1.0,
+                                .hysteresis = 0.0,
+                                .timeout = 600.0});
+        WHEN("running until it finishes") {
+            auto temperature = plant.temperature;
+            while (autotune.running()) {
+                auto power = autotune.update(temperature, SAMPLETIME);
+                temperature = plant.step(power);
+            }
+            THEN("the oscillation matches the analytic result") {
+                REQUIRE(autotune.status() == Status::DONE);
+                REQUIRE(autotune.cycles() == RelayAutotune::MEASURED_CYCLES);
+                auto result = autotune.result();
+                REQUIRE_THAT(result.ultimate_period,
+                             Catch::Matchers::WithinAbs(8.0, 0.05));
+                REQUIRE_THAT(result.ultimate_gain,
+                             Catch::Matchers::WithinRel(
+                                 4.0 / (std::numbers::pi * 2.0), 0.02));
+            }
+            THEN("the gains follow the Ziegler-Nichols rules") {
+                auto result = autotune.result();
+                REQUIRE_THAT(result.kp, Catch::Matchers::WithinRel(
+                                            0.6 * result.ultimate_gain, 1e-6));
+                REQUIRE_THAT(result.ki,
+                             Catch::Matchers::WithinRel(
+                                 result.kp * 2.0 / result.ultimate_period,
+                                 1e-6));
+                REQUIRE_THAT(result.kd,
+                             Catch::Matchers::WithinRel(
+                                 result.kp * result.ultimate_period / 8.0,
+                                 1e-6));
+            }
+        }
+        WHEN("aborting the autotune") {
+            static_cast<void>(autotune.update(40.0, SAMPLETIME));
+            autotune.abort();
+            THEN("it fails and drives no output") {
+                REQUIRE(autotune.status() == Status::FAILED);
+                REQUIRE(autotune.update(40.0, SAMPLETIME) == 0.0);
+            }
+        }
+    }
+    GIVEN("a process that needs a steady output to hold the setpoint") {
+        auto plant = IntegratorPlant(1.0, 2.0, 50.0, 0.3);
+        auto autotune = RelayAutotune();
+        auto settings = Settings{.setpoint = 50.0,
+                                 .output_high = 1.0,
+                                 .output_low = -1.0,
+                                 .hysteresis = 0.0,
+                                 .timeout = 600.0,
+                                 .amplitude = 0.5};
+        auto run = [&]() {
+            auto temperature = plant.temperature;
+            while (autotune.running()) {
+                auto power = autotune.update(temperature, SAMPLETIME);
+                temperature = plant.step(power);
+            }
+        };
+        WHEN("the relay starts centered on zero") {
+            autotune.start(settings);
+            REQUIRE(autotune.bias() == 0.0);
+            run();
+            THEN("the bias moves to the load") {
+                REQUIRE(autotune.status() == Status::DONE);
+                REQUIRE_THAT(autotune.bias(),
+                             Catch::Matchers::WithinAbs(0.3, 0.05));
+            }
+            THEN("the result matches the analytic result") {
+                auto result = autotune.result();
+                REQUIRE_THAT(result.ultimate_period,
+                             Catch::Matchers::WithinRel(8.0, 0.05));
+                REQUIRE_THAT(result.ultimate_gain,
+                             Catch::Matchers::WithinRel(
+                                 2.0 / std::numbers::pi, 0.05));
+            }
+        }
+        WHEN("the relay starts centered on the load") {
+            settings.bias = 0.3;
+            autotune.start(settings);
+            run();
+            THEN("the oscillation matches the analytic result") {
+                REQUIRE(autotune.status() == Status::DONE);
+                auto result = autotune.result();
+                REQUIRE_THAT(autotune.bias(),
+                             Catch::Matchers::WithinAbs(0.3, 0.01));
+                REQUIRE_THAT(result.ultimate_period,
+                             Catch::Matchers::WithinAbs(8.0, 0.05));
+                REQUIRE_THAT(result.ultimate_gain,
+                             Catch::Matchers::WithinRel(
+                                 2.0 / std::numbers::pi, 0.02));
+            }
+        }
+        WHEN("the bias would leave the output range") {
+            settings.bias = 5.0;
+            autotune.start(settings);
+            THEN("the relay still swings within the range") {
+                REQUIRE(autotune.bias() ==
+                        Approx(1.0 - RelayAutotune::MIN_RELAY_FRACTION *
+                                                2.0));
+                REQUIRE(autotune.update(40.0, SAMPLETIME) ==
+                        Approx(1.0));
+            }
+        }
+    }
+    GIVEN("an autotune with hysteresis") {
+        auto plant = IntegratorPlant(1.0, 2.0, 50.0);
+        auto autotune = RelayAutotune();
+        autotune.start(Settings{.setpoint = 50.0,
+                                .output_high = 1.0,
+                                .output_low = 0.0,
+                                .hysteresis = 0.5,
+                                .timeout = 600.0});
+        WHEN("the relay switches") {
+            THEN("it only switches once the temperature leaves the band") {
+                REQUIRE(autotune.update(50.4, SAMPLETIME) == 1.0);
+                REQUIRE(autotune.update(50.6, SAMPLETIME) == 0.0);
+                REQUIRE(autotune.update(49.6, SAMPLETIME) == 0.0);
+                REQUIRE(autotune.update(49.4, SAMPLETIME) == 1.0);
+            }
+        }
+    }
+    GIVEN("a system that never crosses the setpoint") {
+        auto autotune = RelayAutotune();
+        autotune.start(Settings{.setpoint = 50.0,
+                                .output_high = 1.0,
+                                .output_low = 0.0,
+                                .hysteresis = 0.0,
+                                .timeout = 10.0});
+        WHEN("the timeout passes") {
+            for (int i = 0; i < 1001; ++i) {
+                static_cast<void>(autotune.update(25.0, SAMPLETIME));
+            }
+            THEN("the autotune fails") {
+                REQUIRE(autotune.status() == Status::FAILED);
+            }
+        }
+    }
+}
@@ -0,0 +1,170 @@
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "simulator/sim_clock.hpp"
+#include "simulator/sim_worker_pool.hpp"
+
+using namespace sim_worker_pool;
+
+// Wait for the pool's workers to make a condition true, giving up after a
+// while so that a broken pool fails rather than hangs
+static auto eventually(const std::function<bool()>& condition) -> bool {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+SCENARIO("worker pool jobs never run on two workers at once") {
+    GIVEN("four workers and a job that is always ready") {
+        auto clock = std::make_shared<sim_clock::SimClock>();
+        auto pool = WorkerPool(clock, 4);
+        std::atomic<int> active = 0;
+        std::atomic<bool> overlapped = false;
+        std::atomic<int> runs = 0;
+        pool.add([]() { return true; },
+                 [&]() {
+                     if (++active > 1) {
+                         overlapped = true;
+                     }
+                     std::this_thread::sleep_for(std::chrono::microseconds(50));
+                     --active;
+                     ++runs;
+                 });
+        WHEN("running it many times") {
+            pool.start();
+            REQUIRE(eventually([&]() { return runs >= 200; }));
+            pool.stop();
+            THEN("only one worker ran it at a time") {
+                REQUIRE(!overlapped);
+            }
+            THEN("the clock waits for the job") {
+                REQUIRE(clock->now_ms() == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("worker pool periodic jobs keep in step with the clock") {
+    GIVEN("a lockstep pool with a job every 10 ms") {
+        auto clock = std::make_shared<sim_clock::SimClock>();
+        auto pool = WorkerPool(clock, 2);
+        std::mutex mutex;
+        std::vector<uint64_t> run_at;
+        pool.add_periodic(10, [&]() {
+            auto lock = std::lock_guard(mutex);
+            run_at.push_back(clock->now_ms());
+        });
+        auto runs = [&]() {
+            auto lock = std::lock_guard(mutex);
+            return run_at.size();
+        };
+        WHEN("the clock is five periods on when the pool starts") {
+            clock->advance_to(50);
+            pool.start();
+            REQUIRE(eventually([&]() { return runs() >= 6; }));
+            pool.stop();
+            THEN("the job catches up on every missed period") {
+                REQUIRE(std::vector(run_at.begin(), run_at.begin() + 6) ==
+                        std::vector<uint64_t>{50, 50, 50, 50, 50, 60});
+            }
+        }
+        WHEN("the pool is stopped") {
+            pool.start();
+            REQUIRE(eventually([&]() { return runs() >= 5; }));
+            pool.stop();
+            auto stopped_at = runs();
+            auto clock_stopped_at = clock->now_ms();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            THEN("the job doesn't run and the clock doesn't move") {
+                REQUIRE(runs() == stopped_at);
+                REQUIRE(clock->now_ms() == clock_stopped_at);
+            }
+            AND_WHEN("starting it again") {
+                pool.start();
+                REQUIRE(eventually([&]() { return runs() > stopped_at; }));
+                pool.stop();
+                THEN("the job runs again where it left off") {
+                    REQUIRE(run_at[stopped_at] ==
+                            run_at[stopped_at - 1] + 10);
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("worker pool jobs can sleep on a lockstep clock") {
+    GIVEN("a job that runs once and sleeps") {
+        auto clock = std::make_shared<sim_clock::SimClock>();
+        auto pool = WorkerPool(clock, 2);
+        std::atomic<bool> started = false;
+        std::atomic<uint64_t> woke_at = 0;
+        std::atomic<uint64_t> sleep_ms = 25;
+        pool.add([&]() { return !started; },
+                 [&]() {
+                     started = true;
+                     clock->sleep_ms(sleep_ms);
+                     woke_at = clock->now_ms();
+                 });
+        WHEN("running it") {
+            pool.start();
+            REQUIRE(eventually([&]() { return woke_at != 0; }));
+            pool.stop();
+            THEN("the pool moves the clock straight to its wakeup") {
+                REQUIRE(woke_at == 25);
+                REQUIRE(clock->now_ms() == 25);
+            }
+        }
+        WHEN("stopping the pool while it sleeps") {
+            sleep_ms = 1000;
+            pool.start();
+            REQUIRE(eventually([&]() { return started.load(); }));
+            pool.stop();
+            THEN("the job finishes before the pool stops") {
+                REQUIRE(woke_at == 1000);
+            }
+        }
+    }
+}
+
+SCENARIO("worker pool keeps time moving when every worker is asleep") {
+    const size_t workers = GENERATE(1, 2);
+    GIVEN("more jobs that sleep than workers") {
+        auto clock = std::make_shared<sim_clock::SimClock>();
+        auto pool = WorkerPool(clock, workers);
+        static constexpr int JOBS = 4;
+        std::atomic<int> started = 0;
+        std::atomic<int> done = 0;
+        for (int i = 0; i < JOBS; ++i) {
+            auto ran = std::make_shared<std::atomic<bool>>(false);
+            pool.add([ran]() { return !ran->load(); },
+                     [&, ran]() {
+                         *ran = true;
+                         ++started;
+                         clock->sleep_ms(10);
+                         ++done;
+                     });
+        }
+        WHEN("running them") {
+            pool.start();
+            auto finished = eventually([&]() { return done == JOBS; });
+            pool.stop();
+            THEN("every sleeper wakes up") {
+                REQUIRE(finished);
+                REQUIRE(started == JOBS);
+                REQUIRE(clock->now_ms() == 10 * ((JOBS + workers - 1) /
+                                                 workers));
+            }
+        }
+    }
+}
@@ -0,0 +1,138 @@
+#include "catch2/catch.hpp"
+#include "core/stall_calibration.hpp"
+
+using namespace stall_calibration;
+
+static constexpr Settings SETTINGS{.floor = 50,
+                                   .target_low = 100,
+                                   .target_high = 400,
+                                   .max_noise = 0.25,
+                                   .min_samples = 4,
+                                   .velocity_tolerance = 0.05,
+                                   .sgt_min = -64,
+                                   .sgt_max = 63,
+                                   .max_sweeps = 8};
+
+using TestCalibration = Calibration<4>;
+static constexpr TestCalibration::Velocities VELOCITIES{1000, 2000, 3000,
+                                                        4000};
+
+// Record the same readings at every velocity, at exactly the swept velocity
+static auto sweep(TestCalibration& calibration,
+                  const std::array<uint16_t, 4>& readings, size_t count = 8)
+    -> Verdict {
+    for (size_t point = 0; point < VELOCITIES.size(); ++point) {
+        for (size_t i = 0; i < count; ++i) {
+            calibration.record(point, VELOCITIES.at(point),
+                               readings.at(point));
+        }
+    }
+    return calibration.finish_sweep();
+}
+
+TEST_CASE("stall calibration statistics") {
+    auto stats = Statistics();
+    for (uint16_t value : {2, 4, 4, 4, 5, 5, 7, 9}) {
+        stats.add(value);
+    }
+    REQUIRE(stats.count == 8);
+    REQUIRE(stats.min == 2);
+    REQUIRE(stats.max == 9);
+    REQUIRE_THAT(stats.mean, Catch::Matchers::WithinAbs(5.0, 0.0001));
+    REQUIRE_THAT(stats.stddev(), Catch::Matchers::WithinAbs(2.138, 0.001));
+}
+
+SCENARIO("stall calibration finds a threshold and minimum velocity") {
+    GIVEN("a calibration starting from a threshold of 0") {
+        auto calibration = TestCalibration(VELOCITIES, SETTINGS);
+        calibration.start(0);
+        WHEN("readings at the measured velocity are out of tolerance") {
+            THEN("they aren't counted") {
+                REQUIRE(!calibration.record(0, 1100, 200));
+                REQUIRE(calibration.record(0, 1040, 200));
+                REQUIRE(!calibration.record(4, 1000, 200));
+                REQUIRE(calibration.statistics(0).count == 1);
+            }
+        }
+        WHEN("the slowest velocity reads below the floor") {
+            auto verdict = sweep(calibration, {30, 150, 200, 250});
+            THEN("the minimum velocity is the next one up") {
+                REQUIRE(verdict == Verdict::DONE);
+                REQUIRE(calibration.result().sgt == 0);
+                REQUIRE(calibration.result().min_velocity == 2000);
+                REQUIRE(calibration.result().home_velocity == 4000);
+            }
+        }
+        WHEN("a velocity doesn't have enough readings") {
+            auto verdict = sweep(calibration, {200, 200, 200, 200}, 3);
+            THEN("nothing is usable and the threshold is raised") {
+                REQUIRE(verdict == Verdict::SWEEP_AGAIN);
+                REQUIRE(calibration.sgt() == 1);
+                REQUIRE(calibration.statistics(0).count == 0);
+            }
+        }
+        WHEN("a velocity in the middle of the sweep is noisy") {
+            for (size_t i = 0; i < 8; ++i) {
+                auto noisy = static_cast<uint16_t>((i % 2 == 0) ? 60 : 340);
+                calibration.record(1, 2000, noisy);
+            }
+            auto verdict = sweep(calibration, {200, 200, 200, 200});
+            THEN("only the velocities above it are usable") {
+                REQUIRE(!calibration.usable(1));
+                REQUIRE(verdict == Verdict::DONE);
+                REQUIRE(calibration.result().min_velocity == 3000);
+            }
+        }
+        WHEN("the readings sit below the target band") {
+            REQUIRE(sweep(calibration, {60, 80, 90, 95}) ==
+                    Verdict::SWEEP_AGAIN);
+            REQUIRE(calibration.sgt() == 1);
+            AND_WHEN("the next sweep is inside the band") {
+                auto verdict = sweep(calibration, {120, 140, 150, 160});
+                THEN("the raised threshold is the result") {
+                    REQUIRE(verdict == Verdict::DONE);
+                    REQUIRE(calibration.result().sgt == 1);
+                    REQUIRE(calibration.result().min_velocity == 1000);
+                    REQUIRE(calibration.sweeps() == 2);
+                }
+            }
+            AND_WHEN("the next sweep overshoots the band") {
+                auto verdict = sweep(calibration, {500, 500, 500, 500});
+                THEN("the threshold doesn't step back") {
+                    REQUIRE(verdict == Verdict::DONE);
+                    REQUIRE(calibration.result().sgt == 1);
+                }
+            }
+        }
+        WHEN("the readings sit above the target band") {
+            auto verdict = sweep(calibration, {600, 700, 700, 800});
+            THEN("the threshold is lowered") {
+                REQUIRE(verdict == Verdict::SWEEP_AGAIN);
+                REQUIRE(calibration.sgt() == -1);
+            }
+        }
+    }
+    GIVEN("a calibration at the top of the threshold range") {
+        auto calibration = TestCalibration(VELOCITIES, SETTINGS);
+        calibration.start(100);
+        REQUIRE(calibration.sgt() == 63);
+        WHEN("nothing is usable") {
+            THEN("the calibration fails") {
+                REQUIRE(sweep(calibration, {0, 0, 0, 0}) == Verdict::FAILED);
+            }
+        }
+    }
+    GIVEN("a calibration that never reaches the target band") {
+        auto calibration = TestCalibration(VELOCITIES, SETTINGS);
+        calibration.start(0);
+        THEN("it stops after the most sweeps it may take") {
+            auto verdict = Verdict::SWEEP_AGAIN;
+            while (verdict == Verdict::SWEEP_AGAIN) {
+                verdict = sweep(calibration, {60, 60, 60, 60});
+            }
+            REQUIRE(verdict == Verdict::DONE);
+            REQUIRE(calibration.sweeps() == SETTINGS.max_sweeps);
+            REQUIRE(calibration.result().sgt == SETTINGS.max_sweeps - 1);
+        }
+    }
+}
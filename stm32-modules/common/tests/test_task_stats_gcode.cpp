@@ -0,0 +1,78 @@
+#include "catch2/catch.hpp"
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#include "core/task_stats_gcode.hpp"
+#pragma GCC diagnostic pop
+
+SCENARIO("GetTaskStatsDebug (M930.D) parser works",
+         "[gcode][parse][m930.d]") {
+    auto names = std::array<const char*, 2>{"A", "B"};
+    auto stats = std::array{
+        queue_stats::Snapshot{.capacity = 10,
+                              .high_water = 3,
+                              .sent = 120,
+                              .send_failures = 2,
+                              .max_handling_us = 5,
+                              .slowest_message = 4,
+                              .max_wait_us = 250,
+                              .stack_high_water = 80},
+        queue_stats::Snapshot{.capacity = 8}};
+    GIVEN("a response buffer large enough for formatted response") {
+        std::string buffer(256, 'c');
+        WHEN("writing response") {
+            auto written = gcode::GetTaskStatsDebug::write_response_into(
+                buffer.begin(), buffer.end(), names, stats);
+            THEN("the response should be written in full") {
+                REQUIRE_THAT(buffer,
+                             Catch::Matchers::StartsWith(
+                                 "M930.D A:Q3/10 S120 F2 H5@4 W250 K80 "
+                                 "B:Q0/8 S0 F0 H0@0 W0 K-1 OK\n"));
+                REQUIRE(written != buffer.begin());
+            }
+        }
+        WHEN("writing a response without queue statistics") {
+            auto written = gcode::GetTaskStatsDebug::write_response_into(
+                buffer.begin(), buffer.end(), names, stats, false);
+            THEN("the response says the statistics are off") {
+                REQUIRE_THAT(buffer,
+                             Catch::Matchers::StartsWith("M930.D OFF OK\n"));
+                REQUIRE(written == buffer.begin() + 14);
+            }
+        }
+    }
+    GIVEN("a response buffer not large enough for the formatted response") {
+        std::string buffer(32, 'c');
+        WHEN("filling response") {
+            auto written = gcode::GetTaskStatsDebug::write_response_into(
+                buffer.begin(), buffer.begin() + 12, names, stats);
+            THEN("the response should write only up to the available space") {
+                REQUIRE_THAT(buffer,
+                             Catch::Matchers::StartsWith("M930.D A:Q3"));
+                REQUIRE(buffer.at(12) == 'c');
+                REQUIRE(written == buffer.begin() + 12);
+            }
+        }
+    }
+    GIVEN("correct input") {
+        std::string input("M930.D\n");
+        WHEN("parsing the command") {
+            auto parsed =
+                gcode::GetTaskStatsDebug::parse(input.begin(), input.end());
+            THEN("the command should be correct") {
+                REQUIRE(parsed.second != input.begin());
+                REQUIRE(parsed.first.has_value());
+            }
+        }
+    }
+    GIVEN("incorrect input") {
+        std::string input("M930 \n");
+        WHEN("parsing the command") {
+            auto parsed =
+                gcode::GetTaskStatsDebug::parse(input.begin(), input.end());
+            THEN("the command should be incorrect") {
+                REQUIRE(parsed.second == input.begin());
+                REQUIRE(!parsed.first.has_value());
+            }
+        }
+    }
+}
@@ -0,0 +1,116 @@
+#include <cstdint>
+
+#include "catch2/catch.hpp"
+#include "core/trace.hpp"
+
+static uint32_t test_time = 0;
+static auto test_clock() -> uint32_t { return test_time; }
+
+// Simulates an interrupt that records its own event while the interrupted
+// event is reading the clock
+static bool preempt_next_read = false;
+static auto preempted_clock() -> uint32_t {
+    if (preempt_next_read) {
+        preempt_next_read = false;
+        test_time = 300;
+        trace::instant(trace::ADC_CONVERSION_COMPLETE);
+        test_time = 310;
+    }
+    return test_time;
+}
+
+SCENARIO("trace buffer holds the most recent events") {
+    GIVEN("a small trace buffer") {
+        trace::TraceBuffer<4> buffer;
+        WHEN("recording while disabled") {
+            buffer.record(trace::Event{.timestamp = 1, .id = 1});
+            THEN("nothing is stored") {
+                REQUIRE(buffer.count() == 0);
+                REQUIRE(buffer.total() == 0);
+            }
+        }
+        WHEN("recording fewer events than the buffer holds") {
+            buffer.set_enabled(true);
+            buffer.record(trace::Event{.timestamp = 10, .id = 1});
+            buffer.record(trace::Event{.timestamp = 20, .id = 2});
+            THEN("the events are returned oldest first") {
+                REQUIRE(buffer.count() == 2);
+                REQUIRE(buffer.at(0).timestamp == 10);
+                REQUIRE(buffer.at(1).timestamp == 20);
+            }
+        }
+        WHEN("recording more events than the buffer holds") {
+            buffer.set_enabled(true);
+            for (uint32_t i = 0; i < 6; ++i) {
+                buffer.record(trace::Event{.timestamp = i, .id = 1});
+            }
+            THEN("the oldest events are overwritten") {
+                REQUIRE(buffer.count() == 4);
+                REQUIRE(buffer.total() == 6);
+                REQUIRE(buffer.at(0).timestamp == 2);
+                REQUIRE(buffer.at(3).timestamp == 5);
+            }
+            AND_WHEN("clearing the buffer") {
+                buffer.clear();
+                THEN("it is empty") { REQUIRE(buffer.count() == 0); }
+            }
+        }
+    }
+}
+
+SCENARIO("trace scopes record begin and end events") {
+    GIVEN("an installed clock and a recording buffer") {
+        trace::install_clock(test_clock, 170);
+        auto& buffer = trace::get_buffer();
+        buffer.clear();
+        buffer.set_enabled(true);
+        WHEN("a scope is entered and left") {
+            test_time = 100;
+            {
+                auto scope = trace::Scope(trace::PLATE_CONTROL_TICK);
+                test_time = 250;
+            }
+            buffer.set_enabled(false);
+            THEN("a begin and end event are recorded with timestamps") {
+                REQUIRE(trace::ticks_per_us() == 170);
+                REQUIRE(buffer.count() == 2);
+                REQUIRE(buffer.at(0).timestamp == 100);
+                REQUIRE(buffer.at(0).id == trace::PLATE_CONTROL_TICK);
+                REQUIRE(buffer.at(0).phase == trace::Phase::BEGIN);
+                REQUIRE(buffer.at(1).timestamp == 250);
+                REQUIRE(buffer.at(1).phase == trace::Phase::END);
+            }
+        }
+        WHEN("recording is paused") {
+            buffer.set_enabled(false);
+            trace::instant(trace::ADC_CONVERSION_COMPLETE);
+            THEN("no events are recorded") { REQUIRE(buffer.count() == 0); }
+        }
+        buffer.set_enabled(false);
+        buffer.clear();
+    }
+    GIVEN("an event preempted while it is being recorded") {
+        trace::install_clock(preempted_clock, 170);
+        auto& buffer = trace::get_buffer();
+        buffer.clear();
+        buffer.set_enabled(true);
+        preempt_next_read = true;
+        trace::begin(trace::PLATE_CONTROL_TICK);
+        buffer.set_enabled(false);
+        THEN("the interrupted event keeps the slot it claimed first") {
+            REQUIRE(buffer.count() == 2);
+            REQUIRE(buffer.at(0).id == trace::PLATE_CONTROL_TICK);
+            REQUIRE(buffer.at(0).timestamp == 310);
+            REQUIRE(buffer.at(1).id == trace::ADC_CONVERSION_COMPLETE);
+            REQUIRE(buffer.at(1).timestamp == 300);
+        }
+        buffer.clear();
+        trace::install_clock(test_clock, 170);
+    }
+    GIVEN("a message handling event") {
+        auto id = trace::message_event(trace::TASK_LID_HEATER, 7);
+        THEN("the task and message index are encoded in the id") {
+            REQUIRE(id == 0x8307);
+        }
+    }
+}
@@ -1,4 +1,5 @@
 #include "FreeRTOS.h"
+#include "firmware/dwt_trace_clock.hpp"
 #include "firmware/firmware_tasks.hpp"
 #include "firmware/freertos_tasks.hpp"
 #include "firmware/motor_hardware.h"
@@ -64,6 +65,7 @@ extern "C" void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
 
 auto main() -> int {
     HardwareInit();
+    dwt_trace_clock::install(SystemCoreClock);
 
     driver_task.start(tasks::MOTOR_DRIVER_TASK_PRIORITY, "Motor Driver",
                       &aggregator);
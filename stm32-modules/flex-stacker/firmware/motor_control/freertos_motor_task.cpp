@@ -58,6 +58,22 @@ static auto _top_task = motor_task::MotorTask(
     }
 }
 
+static auto step_schedule_glue(MotorID motor_id, bool second_half) -> void {
+    switch (motor_id) {
+        case MotorID::MOTOR_L:
+            l_motor_interrupt.schedule_refill(second_half);
+            break;
+        case MotorID::MOTOR_X:
+            x_motor_interrupt.schedule_refill(second_half);
+            break;
+        case MotorID::MOTOR_Z:
+            z_motor_interrupt.schedule_refill(second_half);
+            break;
+        default:
+            break;
+    }
+}
+
 auto run(tasks::FirmwareTasks::QueueAggregator* aggregator) -> void {
     auto* handle = xTaskGetCurrentTaskHandle();
     _queue.provide_handle(handle);
@@ -66,6 +82,7 @@ auto run(tasks::FirmwareTasks::QueueAggregator* aggregator) -> void {
 
     motor_hardware_init();
     initialize_callbacks(callback_glue);
+    hw_set_step_schedule_callback(step_schedule_glue);
     auto policy = motor_policy::MotorPolicy();
     while (true) {
         _top_task.run_once(policy);
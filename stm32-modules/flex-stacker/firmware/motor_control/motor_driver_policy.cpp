@@ -1,6 +1,11 @@
 #include "firmware/motor_driver_policy.hpp"
 
+#include <algorithm>
+#include <array>
+
+#include "FreeRTOS.h"
 #include "firmware/motor_hardware.h"
+#include "task.h"
 
 using namespace motor_driver_policy;
 
@@ -15,3 +20,24 @@ auto MotorDriverPolicy::tmc2160_transmit_receive(MotorID motor_id,
     }
     return RxTxReturn();
 }
+
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+auto MotorDriverPolicy::tmc2160_transmit_receive_batch(
+    MotorID motor_id, std::span<tmc2160::MessageT> batch) -> bool {
+    std::array<tmc2160::MessageT, tmc2160::MAX_BATCH + 1> received{};
+    if (batch.size() > received.size()) {
+        return false;
+    }
+    if (!motor_spi_sendreceive_batch(motor_id, batch.front().data(),
+                                     received.front().data(), batch.size(),
+                                     tmc2160::MESSAGE_LEN)) {
+        return false;
+    }
+    std::copy(received.begin(), received.begin() + batch.size(),
+              batch.begin());
+    return true;
+}
+
+[[nodiscard]] auto MotorDriverPolicy::get_time_ms() const -> uint32_t {
+    return xTaskGetTickCount();
+}
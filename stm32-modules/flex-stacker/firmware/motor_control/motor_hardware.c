@@ -20,6 +20,8 @@ extern "C" {
 #define TIM_PRELOAD (16)
 /** Calculated TIM period.*/
 #define TIM_PERIOD (((TIM_APB_FREQ/(TIM_PRELOAD + 1)) / MOTOR_INTERRUPT_FREQ) - 1)
+/** Prescaler to count step schedules at STEP_SCHEDULE_FREQ.*/
+#define STEP_SCHEDULE_PRESCALER ((TIM_APB_FREQ / STEP_SCHEDULE_FREQ) - 1)
 
 TIM_HandleTypeDef htim17;
 TIM_HandleTypeDef htim20;
@@ -33,6 +35,12 @@ typedef struct PinConfig {
 
 typedef struct stepper_hardware_struct {
     TIM_HandleTypeDef timer;
+    /** Streams step schedules into the timer.*/
+    DMA_HandleTypeDef dma;
+    /** The timer channel and alternate function on the step pin.*/
+    uint32_t step_channel;
+    uint32_t step_af;
+    bool scheduled;
     PinConfig enable;
     PinConfig direction;
     PinConfig step;
@@ -50,10 +58,16 @@ typedef struct motor_hardware_struct {
 } motor_hardware_t;
 
 
+static step_schedule_callback_t _step_schedule_callback = NULL;
+
 static motor_hardware_t _motor_hardware = {
     .initialized = false,
     .motor_x = {
         .timer = {0},
+        .dma = {0},
+        .step_channel = TIM_CHANNEL_1,
+        .step_af = GPIO_AF1_TIM17,
+        .scheduled = false,
         .enable = {X_EN_PORT, X_EN_PIN, GPIO_PIN_SET},
         .direction = {X_DIR_PORT, X_DIR_PIN, GPIO_PIN_SET},
         .step = {X_STEP_PORT, X_STEP_PIN, GPIO_PIN_SET},
@@ -64,6 +78,10 @@ static motor_hardware_t _motor_hardware = {
     },
     .motor_z = {
         .timer = {0},
+        .dma = {0},
+        .step_channel = TIM_CHANNEL_2,
+        .step_af = GPIO_AF6_TIM20,
+        .scheduled = false,
         .enable = {Z_EN_PORT, Z_EN_PIN, GPIO_PIN_SET},
         .direction = {Z_DIR_PORT, Z_DIR_PIN, GPIO_PIN_RESET},
         .step = {Z_STEP_PORT, Z_STEP_PIN, GPIO_PIN_SET},
@@ -74,6 +92,10 @@ static motor_hardware_t _motor_hardware = {
     },
     .motor_l = {
         .timer = {0},
+        .dma = {0},
+        .step_channel = TIM_CHANNEL_4,
+        .step_af = GPIO_AF2_TIM3,
+        .scheduled = false,
         .enable = {L_EN_PORT, L_EN_PIN, GPIO_PIN_SET},
         .direction = {L_DIR_PORT, L_DIR_PIN, GPIO_PIN_SET},
         .step = {L_STEP_PORT, L_STEP_PIN, GPIO_PIN_SET},
@@ -279,6 +301,33 @@ void tim3_init(TIM_HandleTypeDef* htim) {
     HAL_NVIC_EnableIRQ(TIM3_IRQn);
 }
 
+static void step_schedule_half_complete(DMA_HandleTypeDef *hdma);
+static void step_schedule_complete(DMA_HandleTypeDef *hdma);
+
+// Circular DMA from a step schedule into the auto-reload register of a
+// step timer, on each timer update
+static void step_dma_init(DMA_HandleTypeDef* hdma, DMA_Channel_TypeDef* channel,
+                          uint32_t request, IRQn_Type irq) {
+    HAL_StatusTypeDef hal_ret;
+
+    hdma->Instance = channel;
+    hdma->Init.Request = request;
+    hdma->Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma->Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma->Init.MemInc = DMA_MINC_ENABLE;
+    hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    hdma->Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    hdma->Init.Mode = DMA_CIRCULAR;
+    hdma->Init.Priority = DMA_PRIORITY_VERY_HIGH;
+    hal_ret = HAL_DMA_Init(hdma);
+    configASSERT(hal_ret == HAL_OK);
+    hdma->XferHalfCpltCallback = step_schedule_half_complete;
+    hdma->XferCpltCallback = step_schedule_complete;
+
+    HAL_NVIC_SetPriority(irq, 10, 0);
+    HAL_NVIC_EnableIRQ(irq);
+}
+
 void motor_hardware_init(void){
     if (!_motor_hardware.initialized) {
         motor_hardware_gpio_init();
@@ -286,6 +335,15 @@ void motor_hardware_init(void){
         tim20_init(&_motor_hardware.motor_z.timer);
         tim3_init(&_motor_hardware.motor_l.timer);
 
+        __HAL_RCC_DMAMUX1_CLK_ENABLE();
+        __HAL_RCC_DMA1_CLK_ENABLE();
+        step_dma_init(&_motor_hardware.motor_x.dma, DMA1_Channel3,
+                      DMA_REQUEST_TIM17_UP, DMA1_Channel3_IRQn);
+        step_dma_init(&_motor_hardware.motor_z.dma, DMA1_Channel4,
+                      DMA_REQUEST_TIM20_UP, DMA1_Channel4_IRQn);
+        step_dma_init(&_motor_hardware.motor_l.dma, DMA1_Channel5,
+                      DMA_REQUEST_TIM3_UP, DMA1_Channel5_IRQn);
+
     }
     _motor_hardware.initialized = true;
 }
@@ -307,6 +365,15 @@ stepper_hardware_t get_motor(MotorID motor_id) {
     }
 }
 
+static stepper_hardware_t* get_motor_ptr(MotorID motor_id) {
+    switch (motor_id) {
+        case MOTOR_Z: return &_motor_hardware.motor_z;
+        case MOTOR_X: return &_motor_hardware.motor_x;
+        case MOTOR_L: return &_motor_hardware.motor_l;
+        default: return NULL;
+    }
+}
+
 static uint8_t invert_gpio_value(uint8_t setting) {
     return setting == GPIO_PIN_SET ? GPIO_PIN_RESET : GPIO_PIN_SET;
 }
@@ -335,7 +402,147 @@ bool hw_disable_motor(MotorID motor_id) {
     return true;
 }
 
+static void step_pin_init(stepper_hardware_t* motor, bool timer) {
+    GPIO_InitTypeDef init = {0};
+    init.Pin = motor->step.pin;
+    init.Mode = timer ? GPIO_MODE_AF_PP : GPIO_MODE_OUTPUT_PP;
+    init.Pull = GPIO_NOPULL;
+    init.Speed = GPIO_SPEED_FREQ_LOW;
+    init.Alternate = timer ? motor->step_af : 0;
+    HAL_GPIO_Init(motor->step.port, &init);
+}
+
+// Put the timer back the way the motor interrupt expects it
+static void stop_step_schedule(stepper_hardware_t* motor) {
+    TIM_HandleTypeDef* htim;
+    if (motor == NULL || !motor->scheduled) {
+        return;
+    }
+    htim = &motor->timer;
+    motor->scheduled = false;
+    __HAL_TIM_DISABLE_DMA(htim, TIM_DMA_UPDATE);
+    __HAL_TIM_DISABLE_IT(htim, TIM_IT_UPDATE);
+    (void)HAL_DMA_Abort(&motor->dma);
+    (void)HAL_TIM_PWM_Stop(htim, motor->step_channel);
+    step_pin_init(motor, false);
+    reset_pin(motor->step);
+    __HAL_TIM_SET_PRESCALER(htim, TIM_PRELOAD);
+    __HAL_TIM_SET_AUTORELOAD(htim, TIM_PERIOD);
+    __HAL_TIM_SET_COUNTER(htim, 0);
+    htim->Instance->CR1 |= TIM_CR1_ARPE;
+    htim->Instance->EGR = TIM_EGR_UG;
+    __HAL_TIM_CLEAR_FLAG(htim, TIM_FLAG_UPDATE);
+}
+
+bool hw_start_step_schedule(MotorID motor_id, uint16_t first_reload,
+                            uint16_t *schedule, uint16_t length) {
+    stepper_hardware_t* motor = get_motor_ptr(motor_id);
+    TIM_HandleTypeDef* htim;
+    TIM_OC_InitTypeDef oc = {0};
+    if (motor == NULL || schedule == NULL || length == 0) {
+        return false;
+    }
+    htim = &motor->timer;
+    hw_stop_motor(motor_id);
+
+    // Count in step schedule ticks, and let the DMA write the period
+    // straight into the auto-reload register just after each update
+    __HAL_TIM_SET_PRESCALER(htim, STEP_SCHEDULE_PRESCALER);
+    htim->Instance->CR1 &= ~TIM_CR1_ARPE;
+    __HAL_TIM_SET_AUTORELOAD(htim, first_reload);
+    htim->Instance->EGR = TIM_EGR_UG;
+    __HAL_TIM_CLEAR_FLAG(htim, TIM_FLAG_UPDATE);
+    // Start past the pulse, so that the first step is at the end of the
+    // first period rather than straight away
+    __HAL_TIM_SET_COUNTER(htim, STEP_PULSE_TICKS);
+
+    // Each period starts with a step pulse. The compare value is preloaded,
+    // so ending the pulses takes effect from the next period.
+    oc.OCMode = TIM_OCMODE_PWM1;
+    oc.Pulse = STEP_PULSE_TICKS;
+    oc.OCPolarity = TIM_OCPOLARITY_HIGH;
+    oc.OCNPolarity = TIM_OCNPOLARITY_HIGH;
+    oc.OCFastMode = TIM_OCFAST_DISABLE;
+    oc.OCIdleState = TIM_OCIDLESTATE_RESET;
+    oc.OCNIdleState = TIM_OCNIDLESTATE_RESET;
+    if (HAL_TIM_PWM_ConfigChannel(htim, &oc, motor->step_channel) != HAL_OK) {
+        stop_step_schedule(motor);
+        return false;
+    }
+    step_pin_init(motor, true);
+    motor->scheduled = true;
+
+    if (HAL_DMA_Start_IT(&motor->dma, (uint32_t)schedule,
+                         (uint32_t)&htim->Instance->ARR, length) != HAL_OK) {
+        stop_step_schedule(motor);
+        return false;
+    }
+    __HAL_TIM_ENABLE_DMA(htim, TIM_DMA_UPDATE);
+    hw_enable_ebrake(motor_id, false);
+    set_pin(motor->enable);
+    if (HAL_TIM_PWM_Start(htim, motor->step_channel) != HAL_OK) {
+        stop_step_schedule(motor);
+        return false;
+    }
+    return true;
+}
+
+void hw_count_step_updates(MotorID motor_id) {
+    stepper_hardware_t* motor = get_motor_ptr(motor_id);
+    if (motor == NULL || !motor->scheduled) {
+        return;
+    }
+    __HAL_TIM_CLEAR_IT(&motor->timer, TIM_IT_UPDATE);
+    __HAL_TIM_ENABLE_IT(&motor->timer, TIM_IT_UPDATE);
+}
+
+void hw_end_step_pulses(MotorID motor_id) {
+    stepper_hardware_t* motor = get_motor_ptr(motor_id);
+    if (motor == NULL || !motor->scheduled) {
+        return;
+    }
+    __HAL_TIM_SET_COMPARE(&motor->timer, motor->step_channel, 0);
+}
+
+uint16_t hw_step_schedule_remaining(MotorID motor_id) {
+    stepper_hardware_t* motor = get_motor_ptr(motor_id);
+    if (motor == NULL || !motor->scheduled) {
+        return 0;
+    }
+    return (uint16_t)__HAL_DMA_GET_COUNTER(&motor->dma);
+}
+
+void hw_set_step_schedule_callback(step_schedule_callback_t callback) {
+    _step_schedule_callback = callback;
+}
+
+static void step_schedule_dma_callback(DMA_HandleTypeDef *hdma,
+                                       bool second_half) {
+    MotorID motor_id;
+    if (hdma == &_motor_hardware.motor_x.dma) {
+        motor_id = MOTOR_X;
+    } else if (hdma == &_motor_hardware.motor_z.dma) {
+        motor_id = MOTOR_Z;
+    } else if (hdma == &_motor_hardware.motor_l.dma) {
+        motor_id = MOTOR_L;
+    } else {
+        return;
+    }
+    if (_step_schedule_callback) {
+        _step_schedule_callback(motor_id, second_half);
+    }
+}
+
+static void step_schedule_half_complete(DMA_HandleTypeDef *hdma) {
+    step_schedule_dma_callback(hdma, false);
+}
+
+static void step_schedule_complete(DMA_HandleTypeDef *hdma) {
+    step_schedule_dma_callback(hdma, true);
+}
+
 bool hw_stop_motor(MotorID motor_id) {
+    stop_step_schedule(get_motor_ptr(motor_id));
     stepper_hardware_t motor = get_motor(motor_id);
     HAL_StatusTypeDef status = HAL_OK;
     status = HAL_TIM_Base_Stop_IT(&motor.timer);
@@ -386,6 +593,21 @@ void TIM1_TRG_COM_TIM17_IRQHandler(void)
     HAL_TIM_IRQHandler(&_motor_hardware.motor_x.timer);
 }
 
+void DMA1_Channel3_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&_motor_hardware.motor_x.dma);
+}
+
+void DMA1_Channel4_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&_motor_hardware.motor_z.dma);
+}
+
+void DMA1_Channel5_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&_motor_hardware.motor_l.dma);
+}
+
 #ifdef __cplusplus
 } // extern "C"
 #endif // __cplusplus
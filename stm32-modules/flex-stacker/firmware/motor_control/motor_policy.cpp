@@ -36,3 +36,26 @@ auto MotorPolicy::check_limit_switch(MotorID motor_id, bool direction) -> bool {
 auto MotorPolicy::set_diag0_irq(bool enable) -> void {
     hw_set_diag0_irq(enable);
 }
+
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+auto MotorPolicy::start_step_schedule(MotorID motor_id, uint16_t first_reload,
+                                      uint16_t* schedule, size_t length)
+    -> bool {
+    return hw_start_step_schedule(motor_id, first_reload, schedule,
+                                  static_cast<uint16_t>(length));
+}
+
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+auto MotorPolicy::count_step_updates(MotorID motor_id) -> void {
+    hw_count_step_updates(motor_id);
+}
+
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+auto MotorPolicy::end_step_pulses(MotorID motor_id) -> void {
+    hw_end_step_pulses(motor_id);
+}
+
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+auto MotorPolicy::step_schedule_remaining(MotorID motor_id) -> uint16_t {
+    return hw_step_schedule_remaining(motor_id);
+}
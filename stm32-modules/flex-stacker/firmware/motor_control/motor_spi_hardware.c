@@ -29,6 +29,14 @@
 /** Maximum length of a SPI transaction is 5 bytes.*/
 #define MOTOR_MAX_SPI_LEN (5)
 
+/**
+ * Time the chip select stays high between datagrams, in nanoseconds. The
+ * TMC2160 only latches a datagram on the rising edge of CSN, and needs CSN
+ * high for a few cycles of its 12MHz clock (tCSH) before the next one
+ * starts. 1us covers that with margin.
+ */
+#define MOTOR_SPI_CSN_HIGH_NS (1000)
+
 
 /** Static Variables -------------------------------------------------------- */
 
@@ -38,6 +46,14 @@ struct motor_spi_hardware {
     DMA_HandleTypeDef dma_tx;
     TaskHandle_t task_to_notify;
     bool initialized;
+    /** The rest of the batch being sent, if any.*/
+    MotorID batch_motor;
+    uint8_t *batch_tx;
+    uint8_t *batch_rx;
+    uint16_t batch_remaining;
+    uint16_t batch_len;
+    /** MOTOR_SPI_CSN_HIGH_NS in core clock cycles.*/
+    uint32_t csn_high_cycles;
 };
 
 static void spi_interrupt_service(void);
@@ -52,6 +68,12 @@ static struct motor_spi_hardware _spi = {
     .dma_tx = {0},
     .task_to_notify = NULL,
     .initialized = false,
+    .batch_motor = MOTOR_Z,
+    .batch_tx = NULL,
+    .batch_rx = NULL,
+    .batch_remaining = 0,
+    .batch_len = 0,
+    .csn_high_cycles = 0,
 };
 
 /** Private Functions ------------------------------------------------------- */
@@ -62,9 +84,20 @@ static void disable_spi_nss(void) {
     HAL_GPIO_WritePin(nSPI2_NSS_L_GPIO_Port, nSPI2_NSS_L_Pin, GPIO_PIN_SET);
 }
 
+// Busy wait on the DWT cycle counter. This is called from the SPI
+// interrupt between the datagrams of a batch, and is far too short to
+// block on anything else.
+static void csn_high_delay(void) {
+    const uint32_t start = DWT->CYCCNT;
+    while ((DWT->CYCCNT - start) < _spi.csn_high_cycles) {
+    }
+}
+
 static void enable_spi_nss(MotorID motor) {
-    // Make sure all NSS pins are disabled
+    // Make sure all NSS pins are disabled, and for long enough that the
+    // last datagram has been latched
     disable_spi_nss();
+    csn_high_delay();
 
     switch(motor) {
         case MOTOR_Z:
@@ -204,6 +237,13 @@ void spi_hardware_init(void) {
     if (!_spi.initialized) {
         dma_init();
 
+        // The chip select delay counts core clock cycles
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+        _spi.csn_high_cycles = (uint32_t)(
+            ((uint64_t)SystemCoreClock * MOTOR_SPI_CSN_HIGH_NS + 999999999ULL) /
+            1000000000ULL);
+
         HAL_StatusTypeDef ret;
         _spi.handle.Instance = SPI2;
         _spi.handle.Init.Mode = SPI_MODE_MASTER;
@@ -264,6 +304,17 @@ static void spi_interrupt_service(void) {
   */
 void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
 {
+    if (_spi.batch_remaining > 0) {
+        // Latch this message into the driver and start the next one
+        enable_spi_nss(_spi.batch_motor);
+        if (HAL_SPI_TransmitReceive_DMA(hspi, _spi.batch_tx, _spi.batch_rx,
+                                        _spi.batch_len) == HAL_OK) {
+            _spi.batch_tx += _spi.batch_len;
+            _spi.batch_rx += _spi.batch_len;
+            --_spi.batch_remaining;
+            return;
+        }
+    }
     spi_interrupt_service();
 }
 
@@ -272,6 +323,7 @@ void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
  */
 void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
 {
+    _spi.batch_remaining = 0;
     spi_interrupt_service();
 }
 
@@ -308,4 +360,44 @@ bool motor_spi_sendreceive(
     return true;
 }
 
+bool motor_spi_sendreceive_batch(
+    MotorID motor_id, uint8_t *txData, uint8_t *rxData, uint16_t count,
+    uint16_t size
+) {
+    const TickType_t max_block_time = pdMS_TO_TICKS(100);
+    uint32_t notification_val = 0;
 
+    if (!_spi.initialized || (_spi.task_to_notify != NULL) || (size > MOTOR_MAX_SPI_LEN)) {
+        return false;
+    }
+    if (HAL_SPI_GetError(&_spi.handle) || HAL_SPI_GetState(&_spi.handle) != HAL_SPI_STATE_READY) {
+        return false;
+    }
+    if (count == 0) {
+        return true;
+    }
+    // The completion callback starts each message after the first
+    _spi.batch_motor = motor_id;
+    _spi.batch_tx = txData + size;
+    _spi.batch_rx = rxData + size;
+    _spi.batch_remaining = count - 1;
+    _spi.batch_len = size;
+    enable_spi_nss(motor_id);
+    _spi.task_to_notify = xTaskGetCurrentTaskHandle();
+    if (HAL_SPI_TransmitReceive_DMA(&_spi.handle, txData, rxData, size) != HAL_OK) {
+        // Transmission error
+        _spi.task_to_notify = NULL;
+        _spi.batch_remaining = 0;
+        disable_spi_nss();
+        return false;
+    }
+    notification_val = ulTaskNotifyTake(pdTRUE, max_block_time);
+    disable_spi_nss();
+    if((notification_val != 1) || (_spi.handle.RxXferCount > 0) ||
+       (_spi.batch_remaining > 0)) {
+        _spi.task_to_notify = NULL;
+        _spi.batch_remaining = 0;
+        return false;
+    }
+    return true;
+}
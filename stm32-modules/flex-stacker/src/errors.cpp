@@ -23,6 +23,15 @@ const char* const TMC2160_INVALID_VALUE = "ERR904:TMC2160 invalid value\n";
 const char* const MOTOR_ENABLE_FAILED = "ERR401:motor enable error\n";
 const char* const MOTOR_DISABLE_FAILED = "ERR402:motor disable error\n";
 const char* const MOTOR_STALL_DETECTED = "ERR403:motor stall error\n";
+const char* const MOTOR_BUSY = "ERR404:motor busy\n";
+const char* const MOTOR_STALL_NOT_CALIBRATED =
+    "ERR405:motor stall detection not calibrated for this velocity\n";
+const char* const MOTOR_STALL_CALIBRATION_FAILED =
+    "ERR406:motor stall calibration failed\n";
+const char* const MOTOR_STALL_NOT_DETECTED =
+    "ERR407:motor reached limit switch without stalling\n";
+const char* const MOTOR_STALL_BELOW_VELOCITY =
+    "ERR408:motor stalled below its stall detection velocity\n";
 
 const char* const UNKNOWN_ERROR = "ERR-1:unknown error code\n";
 
@@ -49,6 +58,11 @@ auto errors::errorstring(ErrorCode code) -> const char* {
         HANDLE_CASE(MOTOR_ENABLE_FAILED);
         HANDLE_CASE(MOTOR_DISABLE_FAILED);
         HANDLE_CASE(MOTOR_STALL_DETECTED);
+        HANDLE_CASE(MOTOR_BUSY);
+        HANDLE_CASE(MOTOR_STALL_NOT_CALIBRATED);
+        HANDLE_CASE(MOTOR_STALL_CALIBRATION_FAILED);
+        HANDLE_CASE(MOTOR_STALL_NOT_DETECTED);
+        HANDLE_CASE(MOTOR_STALL_BELOW_VELOCITY);
     }
     return UNKNOWN_ERROR;
 }
@@ -70,6 +70,37 @@ auto MovementProfile::tick() -> TickReturn {
                       .step = step};
 }
 
+auto MovementProfile::advance(ticks limit) -> AdvanceReturn {
+    // The tracker value of one whole step
+    static constexpr q31_31 step_size = static_cast<q31_31>(1) << radix;
+    ticks elapsed = 0;
+    while (elapsed < limit) {
+        auto velocity = _velocity;
+        auto accel_distance = _accel_distance;
+        auto ret = tick();
+        ++elapsed;
+        if (ret.step || ret.done) {
+            return AdvanceReturn{
+                .elapsed = elapsed, .done = ret.done, .step = ret.step};
+        }
+        // Between steps, tick() only depends on the velocity and distances.
+        // If a tick left all of them alone, every tick up to the next step
+        // will do the same, so they can be run all at once.
+        if (_velocity != velocity || _accel_distance != accel_distance ||
+            _velocity <= 0) {
+            continue;
+        }
+        auto velocity_ticks = static_cast<q31_31>(_velocity);
+        auto to_flag = step_size - (_tick_tracker % step_size);
+        // The tick that crosses the flag is left to tick()
+        auto skip = ((to_flag + velocity_ticks - 1) / velocity_ticks) - 1;
+        skip = std::min(skip, limit - elapsed);
+        _tick_tracker += skip * velocity_ticks;
+        elapsed += skip;
+    }
+    return AdvanceReturn{.elapsed = elapsed, .done = false, .step = false};
+}
+
 auto MovementProfile::fixed_distance_tick() -> void {
     // Acceleration phase
     // 1. when the velocity hasn't reached peak value
@@ -0,0 +1,149 @@
+#include <string>
+
+#include "catch2/catch.hpp"
+#include "flex-stacker/gcodes_motor.hpp"
+#include "flex-stacker/stall_homing.hpp"
+
+SCENARIO("CalibrateStallGuard parser works") {
+    GIVEN("a string to calibrate motor Z") {
+        std::string buffer = "M913 Z\n";
+        WHEN("parsing") {
+            auto parsed = gcode::CalibrateStallGuard::parse(buffer.begin(),
+                                                            buffer.end());
+            THEN("the motor is read") {
+                REQUIRE(parsed.first.has_value());
+                REQUIRE(parsed.first.value().motor_id == MotorID::MOTOR_Z);
+            }
+        }
+    }
+    GIVEN("a string without a motor") {
+        std::string buffer = "M913\n";
+        WHEN("parsing") {
+            auto parsed = gcode::CalibrateStallGuard::parse(buffer.begin(),
+                                                            buffer.end());
+            THEN("it fails") { REQUIRE(!parsed.first.has_value()); }
+        }
+    }
+    GIVEN("a calibration result") {
+        std::string buffer(64, 'c');
+        WHEN("writing it") {
+            auto written = gcode::CalibrateStallGuard::write_response_into(
+                buffer.begin(), buffer.end(), MotorID::MOTOR_X, -3, 20.0F,
+                80.0F);
+            THEN("the threshold and velocities are written") {
+                REQUIRE_THAT(buffer,
+                             Catch::Matchers::StartsWith(
+                                 "M913 X T:-3 V:20.00 H:80.00 OK\n"));
+                REQUIRE(written != buffer.begin());
+            }
+        }
+    }
+}
+
+SCENARIO("SetMotorStallGuard parser reads a minimum velocity") {
+    GIVEN("a string with a threshold and a minimum velocity") {
+        std::string buffer = "M910 L1 T-3 V20.5\n";
+        WHEN("parsing") {
+            auto parsed = gcode::SetMotorStallGuard::parse(buffer.begin(),
+                                                           buffer.end());
+            THEN("everything is read") {
+                REQUIRE(parsed.first.has_value());
+                auto& value = parsed.first.value();
+                REQUIRE(value.motor_id == MotorID::MOTOR_L);
+                REQUIRE(value.enable);
+                REQUIRE(value.sgt == -3);
+                REQUIRE(value.min_velocity.value() == Approx(20.5));
+            }
+        }
+    }
+    GIVEN("a string without a minimum velocity") {
+        std::string buffer = "M910 X0\n";
+        WHEN("parsing") {
+            auto parsed = gcode::SetMotorStallGuard::parse(buffer.begin(),
+                                                           buffer.end());
+            THEN("there is none") {
+                REQUIRE(parsed.first.has_value());
+                REQUIRE(!parsed.first.value().enable);
+                REQUIRE(!parsed.first.value().sgt.has_value());
+                REQUIRE(!parsed.first.value().min_velocity.has_value());
+            }
+        }
+    }
+}
+
+SCENARIO("MoveToStall parser works") {
+    GIVEN("a string to home motor X") {
+        std::string buffer = "G6 X0 V80 A500\n";
+        WHEN("parsing") {
+            auto parsed =
+                gcode::MoveToStall::parse(buffer.begin(), buffer.end());
+            THEN("the move is read") {
+                REQUIRE(parsed.first.has_value());
+                auto& value = parsed.first.value();
+                REQUIRE(value.motor_id == MotorID::MOTOR_X);
+                REQUIRE(!value.direction);
+                REQUIRE(value.mm_per_second.value() == Approx(80));
+                REQUIRE(value.mm_per_second_sq.value() == Approx(500));
+                REQUIRE(!value.mm_per_second_discont.has_value());
+            }
+        }
+    }
+    GIVEN("a string without a velocity") {
+        std::string buffer = "G6 Z1\n";
+        WHEN("parsing") {
+            auto parsed =
+                gcode::MoveToStall::parse(buffer.begin(), buffer.end());
+            THEN("it fails") { REQUIRE(!parsed.first.has_value()); }
+        }
+    }
+}
+
+SCENARIO("stall homing moves tell a stall from the limit switch") {
+    GIVEN("a move homing motor Z") {
+        auto homing = stall_homing::StallHoming();
+        homing.start(MotorID::MOTOR_Z, 12);
+        REQUIRE(homing.active(MotorID::MOTOR_Z));
+        REQUIRE(!homing.active(MotorID::MOTOR_X));
+        WHEN("the motor stalls at a trusted velocity") {
+            auto stopped = homing.stall(25.0F, 20.0F);
+            THEN("the move ends without an error") {
+                REQUIRE(stopped);
+                REQUIRE(!homing.active());
+                REQUIRE(homing.response_id() == 12);
+            }
+        }
+        WHEN("the move reaches the limit switch") {
+            auto error = homing.backstop();
+            THEN("it ends with an error") {
+                REQUIRE(error == errors::ErrorCode::MOTOR_STALL_NOT_DETECTED);
+                REQUIRE(!homing.active());
+            }
+        }
+        WHEN("the motor stalls below the trusted velocity") {
+            auto stopped = homing.stall(15.0F, 20.0F);
+            THEN("the move keeps going") {
+                REQUIRE(!stopped);
+                REQUIRE(homing.active(MotorID::MOTOR_Z));
+            }
+            AND_WHEN("it then reaches the limit switch") {
+                auto error = homing.backstop();
+                THEN("the ignored stall is reported") {
+                    REQUIRE(error ==
+                            errors::ErrorCode::MOTOR_STALL_BELOW_VELOCITY);
+                }
+            }
+            AND_WHEN("it then stalls at a trusted velocity") {
+                THEN("the move ends without an error") {
+                    REQUIRE(homing.stall(25.0F, 20.0F));
+                }
+            }
+            AND_WHEN("the next move reaches the limit switch") {
+                homing.start(MotorID::MOTOR_Z, 13);
+                THEN("the earlier stall isn't reported") {
+                    REQUIRE(homing.backstop() ==
+                            errors::ErrorCode::MOTOR_STALL_NOT_DETECTED);
+                }
+            }
+        }
+    }
+}
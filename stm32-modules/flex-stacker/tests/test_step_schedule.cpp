@@ -0,0 +1,237 @@
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "core/linear_motion_system.hpp"
+#include "core/step_schedule.hpp"
+#include "firmware/motor_interrupt.hpp"
+#include "flex-stacker/motor_utils.hpp"
+
+using namespace motor_util;
+using namespace motor_interrupt_controller;
+
+static constexpr uint32_t TICK_FREQ = 100000;
+
+// The X and Z axes and their default motion, as set up by the motor task
+static constexpr auto AXIS_CONFIG = lms::LinearMotionSystemConfig<
+    lms::LeadScrewConfig>{.mech_config = lms::LeadScrewConfig{
+                              .lead_screw_pitch = 9.7536,
+                              .gear_reduction_ratio = 1.0},
+                          .steps_per_rev = 200,
+                          .microstep = 16};
+static constexpr double AXIS_SPEED = 200.0;
+static constexpr double AXIS_SPEED_DISCONT = 5.0;
+
+// The tick of every step of a movement, found by ticking it one tick at a
+// time the way the motor interrupt does
+static auto ticked_steps(MovementProfile profile, uint64_t max_ticks)
+    -> std::vector<uint64_t> {
+    std::vector<uint64_t> steps{};
+    for (uint64_t tick = 1; tick <= max_ticks; ++tick) {
+        auto ret = profile.tick();
+        if (ret.step) {
+            steps.push_back(tick);
+        }
+        if (ret.done) {
+            break;
+        }
+    }
+    return steps;
+}
+
+// The tick of every step of a movement, found by advancing from step to step
+static auto advanced_steps(MovementProfile profile, uint64_t max_ticks)
+    -> std::vector<uint64_t> {
+    std::vector<uint64_t> steps{};
+    uint64_t tick = 0;
+    while (tick < max_ticks) {
+        auto ret = profile.advance(std::min<uint64_t>(997, max_ticks - tick));
+        tick += ret.elapsed;
+        if (ret.step) {
+            steps.push_back(tick);
+        }
+        if (ret.done) {
+            break;
+        }
+    }
+    return steps;
+}
+
+// The tick of every step that a timer would take by running the schedule,
+// refilling each half of the buffer as soon as the DMA is done with it.
+// Every reload value the timer is given must leave room for the pulse.
+template <size_t Length, uint16_t MinTicks = 1>
+static auto scheduled_steps(MovementProfile profile)
+    -> std::vector<uint64_t> {
+    using Schedule =
+        step_schedule::StepSchedule<MovementProfile, Length, 100, MinTicks>;
+    auto schedule = Schedule();
+    std::vector<uint64_t> steps{};
+    if (!schedule.start(profile)) {
+        return steps;
+    }
+    REQUIRE(schedule.first_reload() >= MinTicks - 1);
+    uint64_t tick = schedule.first_reload() + 1;
+    steps.push_back(tick);
+    size_t index = 0;
+    while (steps.size() < schedule.steps()) {
+        REQUIRE(schedule.buffer().at(index) >= MinTicks - 1);
+        tick += schedule.buffer().at(index) + 1;
+        steps.push_back(tick);
+        ++index;
+        if (index == Schedule::HALF) {
+            schedule.refill(false);
+        } else if (index == Length) {
+            schedule.refill(true);
+            index = 0;
+        }
+        if (schedule.finished()) {
+            REQUIRE(!schedule.stalled());
+        }
+    }
+    // Once the last step is scheduled, the rest of the buffer trails off
+    REQUIRE(schedule.finished());
+    REQUIRE(schedule.buffer().at(index) == Schedule::TRAILING_RELOAD);
+    return steps;
+}
+
+SCENARIO("movement profile advances to the next step") {
+    GIVEN("a fixed distance movement with acceleration") {
+        auto profile = MovementProfile(TICK_FREQ, 500, 20000, 50000,
+                                       MovementType::FixedDistance, 3000);
+        THEN("advancing steps on exactly the same ticks as ticking") {
+            auto ticked = ticked_steps(profile, 1000000);
+            REQUIRE(ticked.size() == 3000);
+            REQUIRE(advanced_steps(profile, 1000000) == ticked);
+        }
+    }
+    GIVEN("an open loop movement") {
+        auto profile = MovementProfile(TICK_FREQ, 100, 3000, 10000,
+                                       MovementType::OpenLoop, 0);
+        THEN("advancing steps on exactly the same ticks as ticking") {
+            auto ticked = ticked_steps(profile, 200000);
+            REQUIRE(ticked.size() > 100);
+            REQUIRE(advanced_steps(profile, 200000) == ticked);
+        }
+    }
+    GIVEN("a movement with no acceleration") {
+        auto profile = MovementProfile(TICK_FREQ, 0, 7777, 0,
+                                       MovementType::FixedDistance, 500);
+        THEN("advancing steps on exactly the same ticks as ticking") {
+            auto ticked = ticked_steps(profile, 100000);
+            REQUIRE(ticked.size() == 500);
+            REQUIRE(advanced_steps(profile, 100000) == ticked);
+        }
+    }
+    GIVEN("a movement that doesn't move") {
+        auto profile = MovementProfile(TICK_FREQ, 0, 0, 0,
+                                       MovementType::OpenLoop, 0);
+        WHEN("advancing with a limit") {
+            auto ret = profile.advance(12345);
+            THEN("it stops at the limit without stepping") {
+                REQUIRE(ret.elapsed == 12345);
+                REQUIRE(!ret.step);
+                REQUIRE(!ret.done);
+            }
+        }
+    }
+}
+
+SCENARIO("step schedules match the movement profile") {
+    GIVEN("a long movement with acceleration") {
+        auto profile = MovementProfile(TICK_FREQ, 2000, 64000, 50000,
+                                       MovementType::FixedDistance, 20000);
+        THEN("the scheduled steps are on the same ticks as ticked steps") {
+            auto ticked = ticked_steps(profile, 10000000);
+            REQUIRE(ticked.size() == 20000);
+            REQUIRE(scheduled_steps<64>(profile) == ticked);
+        }
+    }
+    GIVEN("a movement shorter than the buffer") {
+        auto profile = MovementProfile(TICK_FREQ, 1000, 5000, 20000,
+                                       MovementType::FixedDistance, 10);
+        THEN("the scheduled steps are on the same ticks as ticked steps") {
+            auto ticked = ticked_steps(profile, 1000000);
+            REQUIRE(ticked.size() == 10);
+            REQUIRE(scheduled_steps<64>(profile) == ticked);
+        }
+    }
+    GIVEN("a slow movement with a small buffer") {
+        auto profile = MovementProfile(TICK_FREQ, 3, 40, 5,
+                                       MovementType::FixedDistance, 50);
+        THEN("the scheduled steps are on the same ticks as ticked steps") {
+            auto ticked = ticked_steps(profile, 10000000);
+            REQUIRE(ticked.size() == 50);
+            REQUIRE(scheduled_steps<4>(profile) == ticked);
+        }
+    }
+    GIVEN("a movement of no steps") {
+        auto profile = MovementProfile(TICK_FREQ, 1000, 5000, 20000,
+                                       MovementType::FixedDistance, 0);
+        auto schedule = step_schedule::StepSchedule<MovementProfile, 8>();
+        THEN("the schedule doesn't start") {
+            REQUIRE(!schedule.start(profile));
+            REQUIRE(schedule.finished());
+            REQUIRE(schedule.steps() == 0);
+        }
+    }
+    GIVEN("a movement whose steps are too far apart") {
+        auto profile = MovementProfile(TICK_FREQ, 1, 1, 0,
+                                       MovementType::FixedDistance, 10);
+        auto schedule = step_schedule::StepSchedule<MovementProfile, 8>();
+        THEN("the schedule stalls") {
+            REQUIRE(!schedule.start(profile));
+            REQUIRE(schedule.finished());
+            REQUIRE(schedule.stalled());
+        }
+    }
+}
+
+SCENARIO("step schedules leave room for the step pulse") {
+    THEN("the pulse is at least as long as the driver needs") {
+        REQUIRE(STEP_PULSE_TICKS * 1000000000ULL >=
+                DRIVER_MIN_STEP_PULSE_NS * uint64_t{SCHEDULE_FREQ});
+    }
+    GIVEN("a movement at the default velocity") {
+        auto profile = MovementProfile(SCHEDULE_FREQ, 2000, DEFAULT_VELOCITY,
+                                       DEFAULT_ACCEL,
+                                       MovementType::FixedDistance, 20000);
+        THEN("it is stepped from a step schedule") {
+            REQUIRE(schedulable(2000, static_cast<uint32_t>(DEFAULT_VELOCITY)));
+        }
+        THEN("every reload is at least the step pulse") {
+            auto steps = scheduled_steps<SCHEDULE_LENGTH, SCHEDULE_MIN_TICKS>(
+                profile);
+            REQUIRE(steps.size() == 20000);
+            REQUIRE(steps.front() >= SCHEDULE_MIN_TICKS);
+            for (size_t i = 1; i < steps.size(); ++i) {
+                REQUIRE(steps.at(i) - steps.at(i - 1) >= SCHEDULE_MIN_TICKS);
+            }
+        }
+    }
+    GIVEN("a movement at the default speed of the X and Z axes") {
+        auto steps_per_mm =
+            static_cast<double>(AXIS_CONFIG.get_usteps_per_mm());
+        THEN("it is stepped from a step schedule") {
+            REQUIRE(schedulable(
+                static_cast<uint32_t>(AXIS_SPEED_DISCONT * steps_per_mm),
+                static_cast<uint32_t>(AXIS_SPEED * steps_per_mm)));
+        }
+    }
+    GIVEN("movements too slow or too fast for a schedule") {
+        THEN("they are ticked") {
+            REQUIRE(!schedulable(SCHEDULE_MIN_VELOCITY - 1, 1000));
+            REQUIRE(!schedulable(1000, SCHEDULE_MAX_VELOCITY + 1));
+        }
+    }
+    GIVEN("a movement at the fastest scheduled speed") {
+        auto profile = MovementProfile(SCHEDULE_FREQ, 2000,
+                                       SCHEDULE_MAX_VELOCITY, 50000,
+                                       MovementType::FixedDistance, 20000);
+        THEN("the scheduled steps are on the same ticks as ticked steps") {
+            auto ticked = ticked_steps(profile, 100000000);
+            REQUIRE(ticked.size() == 20000);
+            REQUIRE(scheduled_steps<SCHEDULE_LENGTH, SCHEDULE_MIN_TICKS>(
+                        profile) == ticked);
+        }
+    }
+}
@@ -0,0 +1,112 @@
+#include "catch2/catch.hpp"
+#include "flex-stacker/tmc2160.hpp"
+#include "test/test_tmc2160_policy.hpp"
+
+using namespace tmc2160;
+
+SCENARIO("tmc2160 shadows its configuration registers") {
+    GIVEN("a tmc2160 that has configured the X motor") {
+        auto policy = TestTMC2160Policy();
+        auto spi = TMC2160Interface<TestTMC2160Policy>(policy);
+        auto tmc = TMC2160();
+        auto registers = TMC2160RegisterMap{
+            .gconfig = {.en_pwm_mode = 1},
+            .ihold_irun = {.hold_current = 1,
+                           .run_current = 10,
+                           .hold_current_delay = 7},
+            .chopconf = {.toff = 3, .hstrt = 4, .hend = 1, .tbl = 2},
+            .coolconf = {.sgt = 6}};
+        REQUIRE(tmc.initialize_config(registers, spi, MOTOR_X));
+        REQUIRE(policy.get_messages() == 12);
+        REQUIRE(policy.get_batches() == 1);
+        REQUIRE(policy.read_register(MOTOR_X, Registers::IHOLD_IRUN) ==
+                0x70A01);
+        WHEN("configuring it again with the same registers") {
+            REQUIRE(tmc.initialize_config(registers, spi, MOTOR_X));
+            THEN("nothing is sent") {
+                REQUIRE(policy.get_messages() == 12);
+            }
+        }
+        WHEN("configuring another motor") {
+            REQUIRE(tmc.initialize_config(registers, spi, MOTOR_Z));
+            THEN("all of its registers are sent") {
+                REQUIRE(policy.get_messages() == 24);
+                REQUIRE(policy.read_register(MOTOR_Z, Registers::IHOLD_IRUN) ==
+                        0x70A01);
+            }
+        }
+        WHEN("updating the current") {
+            registers.ihold_irun.run_current = 20;
+            REQUIRE(tmc.update_current(registers, spi, MOTOR_X));
+            THEN("only that register is sent") {
+                REQUIRE(policy.get_messages() == 13);
+                REQUIRE(policy.read_register(MOTOR_X,
+                                             Registers::IHOLD_IRUN) ==
+                        0x71401);
+            }
+            AND_WHEN("updating it to the same value") {
+                REQUIRE(tmc.update_current(registers, spi, MOTOR_X));
+                THEN("nothing is sent") {
+                    REQUIRE(policy.get_messages() == 13);
+                }
+            }
+        }
+        WHEN("the registers are invalidated") {
+            tmc.invalidate(MOTOR_X);
+            REQUIRE(tmc.update_chopconf(registers, spi, MOTOR_X));
+            REQUIRE(tmc.initialize_config(registers, spi, MOTOR_X));
+            THEN("every register is written again, once") {
+                REQUIRE(policy.get_messages() == 24);
+            }
+        }
+        WHEN("a batch fails") {
+            policy.set_fail_batches(true);
+            registers.coolconf.sgt = 10;
+            REQUIRE(!tmc.initialize_config(registers, spi, MOTOR_X));
+            policy.set_fail_batches(false);
+            THEN("the next configuration writes every register") {
+                REQUIRE(tmc.initialize_config(registers, spi, MOTOR_X));
+                REQUIRE(policy.get_messages() == 24);
+            }
+        }
+    }
+}
+
+SCENARIO("tmc2160 interface batches register reads") {
+    GIVEN("a driver with some register values") {
+        auto policy = TestTMC2160Policy();
+        auto spi = TMC2160Interface<TestTMC2160Policy>(policy);
+        policy.write_register(MOTOR_L, Registers::DRVSTATUS, 0x1234);
+        policy.write_register(MOTOR_L, Registers::TSTEP, 0x5678);
+        policy.write_register(MOTOR_L, Registers::GSTAT, 0x3);
+        WHEN("reading them in a batch") {
+            static constexpr auto addrs = std::array{
+                Registers::DRVSTATUS, Registers::TSTEP, Registers::GSTAT};
+            auto values = std::array<RegisterSerializedType, 3>{};
+            REQUIRE(spi.read_batch(addrs, values, MOTOR_L));
+            THEN("they are read with one message more than registers") {
+                REQUIRE(values == std::array<RegisterSerializedType, 3>{
+                                      0x1234, 0x5678, 0x3});
+                REQUIRE(policy.get_messages() == 4);
+                REQUIRE(policy.get_batches() == 1);
+            }
+        }
+    }
+}
+
+SCENARIO("tmc2160 converts TSTEP into a velocity") {
+    GIVEN("a motor at 16 microsteps") {
+        static constexpr uint32_t mres = 4;
+        THEN("TSTEP counts clock cycles per 1/256 microstep") {
+            // 3200 steps/s at the input is 51200 1/256 microsteps/s
+            REQUIRE(TMC2160::tstep_to_velocity(234, mres) ==
+                    Approx(12000000.0 / (234 * 16)));
+            REQUIRE(TMC2160::tstep_to_velocity(234, mres) ==
+                    Approx(3205).epsilon(0.001));
+        }
+        THEN("a motor that hasn't stepped reads as stopped") {
+            REQUIRE(TMC2160::tstep_to_velocity(0, mres) == 0.0);
+            REQUIRE(TMC2160::tstep_to_velocity(0xFFFFF, mres) < 1.0);
+        }
+    }
+}
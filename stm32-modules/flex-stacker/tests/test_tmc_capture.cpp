@@ -0,0 +1,167 @@
+#include <array>
+#include <string>
+
+#include "catch2/catch.hpp"
+#include "flex-stacker/gcodes_motor.hpp"
+#include "flex-stacker/tmc_capture.hpp"
+
+using namespace tmc_capture;
+
+static auto sample(uint16_t n) -> Sample {
+    return Sample{.tstep = n, .sg_result = n, .cs_actual = 1};
+}
+
+SCENARIO("tmc register captures are paced and batched") {
+    GIVEN("a capture sampling every 2 ms") {
+        auto capture = Capture<16>();
+        capture.start(MotorID::MOTOR_Z, 2, 1000);
+        THEN("the first sample is due straight away") {
+            REQUIRE(capture.due(1000));
+            REQUIRE(capture.ms_until_due(1000) == 0);
+        }
+        WHEN("taking samples on time") {
+            for (uint16_t i = 0; i < BATCH_SIZE; ++i) {
+                auto now = 1000 + 2 * i;
+                REQUIRE(capture.due(now));
+                capture.record(sample(i), now);
+                REQUIRE(!capture.due(now + 1));
+                REQUIRE(capture.ms_until_due(now + 1) == 1);
+            }
+            THEN("a full batch is ready") {
+                REQUIRE(capture.batch_ready(false));
+                auto batch = capture.next_batch();
+                REQUIRE(batch.motor_id == MotorID::MOTOR_Z);
+                REQUIRE(batch.first == 0);
+                REQUIRE(batch.dropped == 0);
+                REQUIRE(batch.count == BATCH_SIZE);
+                REQUIRE(capture.sample(batch, 7).sg_result == 7);
+                AND_WHEN("sending it") {
+                    capture.mark_sent(batch);
+                    THEN("nothing is left to send") {
+                        REQUIRE(capture.unsent() == 0);
+                        REQUIRE(!capture.batch_ready(true));
+                    }
+                    THEN("its samples stay in the buffer until released") {
+                        REQUIRE(capture.buffered() == BATCH_SIZE);
+                        REQUIRE(capture.sample(batch, 0).sg_result == 0);
+                        capture.release(batch);
+                        REQUIRE(capture.buffered() == 0);
+                    }
+                    AND_WHEN("restarting before it is released") {
+                        capture.record(sample(99), 1016);
+                        capture.start(MotorID::MOTOR_X, 2, 2000);
+                        THEN("unsent samples are discarded") {
+                            REQUIRE(capture.unsent() == 0);
+                        }
+                        THEN("the sent batch is kept") {
+                            REQUIRE(capture.buffered() == BATCH_SIZE);
+                            REQUIRE(capture.sample(batch, 7).sg_result == 7);
+                        }
+                    }
+                }
+            }
+        }
+        WHEN("a sample is late by more than a period") {
+            capture.record(sample(0), 1000);
+            capture.record(sample(1), 1005);
+            THEN("the missed periods are dropped") {
+                REQUIRE(capture.dropped() == 1);
+                REQUIRE(capture.ms_until_due(1005) == 1);
+                AND_THEN("batches stop at the gap") {
+                    auto batch = capture.next_batch();
+                    REQUIRE(batch.count == 1);
+                    capture.mark_sent(batch);
+                    batch = capture.next_batch();
+                    REQUIRE(batch.first == 2);
+                    REQUIRE(capture.sample(batch, 0).sg_result == 1);
+                }
+            }
+        }
+        WHEN("a register read fails") {
+            capture.record(std::nullopt, 1000);
+            capture.record(sample(1), 1002);
+            THEN("that sample is dropped") {
+                REQUIRE(capture.dropped() == 1);
+                REQUIRE(capture.next_batch().first == 1);
+            }
+        }
+        WHEN("the buffer fills up") {
+            for (uint16_t i = 0; i < 20; ++i) {
+                capture.record(sample(i), 1000 + 2 * i);
+            }
+            THEN("new samples are dropped") {
+                REQUIRE(capture.buffered() == 16);
+                REQUIRE(capture.dropped() == 4);
+            }
+            AND_WHEN("a sent batch is released") {
+                auto batch = capture.next_batch();
+                capture.mark_sent(batch);
+                capture.release(batch);
+                capture.record(sample(20), 1040);
+                THEN("its space is used again") {
+                    REQUIRE(capture.buffered() == 16 - BATCH_SIZE + 1);
+                    REQUIRE(capture.dropped() == 4);
+                }
+            }
+        }
+        WHEN("the capture stops with a partial batch") {
+            capture.record(sample(0), 1000);
+            capture.record(sample(1), 1002);
+            capture.stop();
+            THEN("no more samples are due") { REQUIRE(!capture.due(2000)); }
+            THEN("the rest can be flushed") {
+                REQUIRE(!capture.batch_ready(false));
+                REQUIRE(capture.batch_ready(true));
+                REQUIRE(capture.next_batch().count == 2);
+            }
+        }
+    }
+}
+
+SCENARIO("StreamTMCRegisters parser works") {
+    GIVEN("a string to start streaming motor L") {
+        std::string buffer = "M912 L10\n";
+        WHEN("parsing") {
+            auto parsed = gcode::StreamTMCRegisters::parse(buffer.begin(),
+                                                           buffer.end());
+            THEN("the motor and period are read") {
+                REQUIRE(parsed.first.has_value());
+                REQUIRE(parsed.first.value().motor_id == MotorID::MOTOR_L);
+                REQUIRE(parsed.first.value().period_ms == 10);
+            }
+        }
+    }
+    GIVEN("a string without a motor") {
+        std::string buffer = "M912 \n";
+        WHEN("parsing") {
+            auto parsed = gcode::StreamTMCRegisters::parse(buffer.begin(),
+                                                           buffer.end());
+            THEN("it fails") { REQUIRE(!parsed.first.has_value()); }
+        }
+    }
+    GIVEN("a batch of samples") {
+        auto capture = Capture<16>();
+        capture.start(MotorID::MOTOR_X, 1, 0);
+        // Drop three periods before the batch
+        capture.record(std::nullopt, 0);
+        capture.record(
+            Sample{.tstep = 0xFFFFF, .sg_result = 0x3FF, .cs_actual = 0x1F},
+            3);
+        capture.record(Sample{.tstep = 0x12, .sg_result = 0x5, .cs_actual = 0x3},
+                       4);
+        auto batch = capture.next_batch();
+        REQUIRE(batch.first == 3);
+        REQUIRE(batch.count == 2);
+        WHEN("writing it") {
+            std::string buffer(128, 'c');
+            auto written = gcode::StreamTMCRegisters::write_batch_into(
+                buffer.begin(), buffer.end(), capture, batch);
+            THEN("the samples are written compactly") {
+                REQUIRE_THAT(buffer, Catch::Matchers::StartsWith(
+                                         "M912 X N:3 D:3 3ff1ffffff "
+                                         "0050300012 OK\n"));
+                REQUIRE(written != buffer.begin());
+            }
+        }
+    }
+}
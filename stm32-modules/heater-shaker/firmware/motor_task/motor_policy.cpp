@@ -14,10 +14,19 @@
 #pragma GCC diagnostic pop
 
 #include "heater-shaker/errors.hpp"
+#include "heater-shaker/shake_sequence.hpp"
 #include "motor_policy.hpp"
 
 using namespace errors;
 
+// Shake sequences are checked against these limits before they start
+static_assert(shake_sequence::MIN_RPM == MIN_APPLICATION_SPEED_RPM);
+static_assert(shake_sequence::MAX_RPM == MAX_APPLICATION_SPEED_RPM);
+static_assert(shake_sequence::MIN_RAMP_RATE_RPM_PER_S ==
+              MotorPolicy::MIN_RAMP_RATE_RPM_PER_S);
+static_assert(shake_sequence::MAX_RAMP_RATE_RPM_PER_S ==
+              MotorPolicy::MAX_RAMP_RATE_RPM_PER_S);
+
 MotorPolicy::MotorPolicy(motor_hardware_handles* handles)
     : hw_handles(handles) {}
 
@@ -93,6 +102,12 @@ auto MotorPolicy::set_ramp_rate(int32_t rpm_per_s) -> ErrorCode {
 // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
 auto MotorPolicy::delay_ticks(uint16_t ticks) -> void { vTaskDelay(ticks); }
 
+// Each tick is 1ms
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+auto MotorPolicy::get_time_ms() const -> uint32_t {
+    return xTaskGetTickCount();
+}
+
 // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
 auto MotorPolicy::plate_lock_set_power(float power) -> void {
     motor_hardware_plate_lock_on(&hw_handles->tim3, power);
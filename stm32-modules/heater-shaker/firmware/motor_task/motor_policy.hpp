@@ -38,6 +38,7 @@ class MotorPolicy {
     auto homing_solenoid_engage(uint16_t current_ma) -> void;
 
     auto delay_ticks(uint16_t ticks) -> void;
+    [[nodiscard]] auto get_time_ms() const -> uint32_t;
 
     auto plate_lock_set_power(float power) -> void;
     auto plate_lock_disable() -> void;
@@ -1,6 +1,7 @@
 
 
 #include "FreeRTOS.h"
+#include "firmware/dwt_trace_clock.hpp"
 #include "firmware/freertos_comms_task.hpp"
 #include "firmware/freertos_heater_task.hpp"
 #include "firmware/freertos_message_queue.hpp"
@@ -14,6 +15,7 @@ tasks::Tasks<FreeRTOSMessageQueue> tasks_aggregator;
 
 auto main() -> int {
     HardwareInit();
+    dwt_trace_clock::install(SystemCoreClock);
     auto system = system_control_task::start();
     auto heater = heater_control_task::start();
     auto motor = motor_control_task::start();
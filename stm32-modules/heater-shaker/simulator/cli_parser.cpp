@@ -1,9 +1,13 @@
 #include "simulator/cli_parser.hpp"
 
+#include <boost/algorithm/string.hpp>
 #include <boost/program_options.hpp>
+#include <cstdlib>
 #include <iostream>
 #include <memory>
+#include <string>
 
+#include "simulator/sim_clock.hpp"
 #include "simulator/sim_driver.hpp"
 #include "simulator/socket_sim_driver.hpp"
 #include "simulator/stdin_sim_driver.hpp"
@@ -40,10 +44,10 @@ using namespace cli_parser;
     exit(1);
 }
 
-std::shared_ptr<sim_driver::SimDriver> cli_parser::get_sim_driver(
-    int num_args, char* args[]) {
+RT cli_parser::get_sim_driver(int num_args, char* args[], double& speedup) {
     bool use_stdin = false;
     bool use_socket = false;
+    bool realtime = false;
     bool options_specified = num_args > 1;
 
     boost::program_options::options_description desc("Allowed options");
@@ -52,7 +56,15 @@ std::shared_ptr<sim_driver::SimDriver> cli_parser::get_sim_driver(
         "Use stdin to provide G-Codes")("socket",
                                         boost::program_options::value<
                                             std::string>(),
-                                        "Use socket to provide G-Codes");
+                                        "Use socket to provide G-Codes")
+        ("realtime", boost::program_options::bool_switch(&realtime),
+         "Thermal and motor data should run in real time")(
+            "speedup",
+            boost::program_options::value<double>(&speedup)->default_value(
+                sim_clock::SimClock::LOCKSTEP),
+            "Run the simulated clock this many times faster than real time, "
+            "instead of in lockstep with the tasks. Runs at a speedup are "
+            "not repeatable");
 
     boost::program_options::variables_map vm;
     /*
@@ -81,13 +93,38 @@ std::shared_ptr<sim_driver::SimDriver> cli_parser::get_sim_driver(
     if (use_stdin && use_socket) {
         both_drivers_specified_error(desc);
     }
+    if (speedup < sim_clock::SimClock::LOCKSTEP) {
+        std::cerr << std::endl
+                  << "ERROR: --speedup can't be negative" << std::endl
+                  << std::endl;
+        std::cerr << desc << std::endl;
+        exit(1);
+    }
 
     if (use_stdin) {
-        return std::make_shared<stdin_sim_driver::StdinSimDriver>();
+        return RT(std::make_shared<stdin_sim_driver::StdinSimDriver>(),
+                  realtime);
     } else if (use_socket) {
-        return std::make_shared<socket_sim_driver::SocketSimDriver>(
-            vm["socket"].as<std::string>());
+        return RT(std::make_shared<socket_sim_driver::SocketSimDriver>(
+                      vm["socket"].as<std::string>()),
+                  realtime);
     } else {
         neither_driver_error(desc);
     }
+}
+
+bool cli_parser::check_realtime_environment_variable() {
+    constexpr const char realtime_var_name[] = "USE_REALTIME_SIM";
+    constexpr const char string_true[] = "true";
+    const auto* var_value = getenv(realtime_var_name);
+
+    if (!var_value || strlen(var_value) == 0) {
+        return false;
+    }
+
+    // Convert to lowercase
+    auto var_string = std::string(var_value);
+    boost::algorithm::to_lower(var_string);
+
+    return var_string.starts_with(string_true);
 }
\ No newline at end of file
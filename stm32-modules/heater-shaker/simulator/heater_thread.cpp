@@ -1,9 +1,10 @@
 #include "simulator/heater_thread.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
+#include <deque>
 #include <memory>
-#include <stop_token>
-#include <thread>
 
 #include "core/thermistor_conversion.hpp"
 #include "heater-shaker/flash.hpp"
@@ -17,10 +18,12 @@ struct SimHeaterPolicy {
     [[nodiscard]] auto power_good() const -> bool { return true; }
     [[nodiscard]] auto try_reset_power_good() -> bool { return true; };
     auto set_power_output(double relative_power) -> HEATPAD_CIRCUIT_ERROR {
-        power = relative_power;
+        // The hardware clamps the output the same way
+        power = std::clamp(relative_power, 0.0, 1.0);
         return HEATPAD_CIRCUIT_ERROR::HEATPAD_CIRCUIT_NO_ERROR;
     };
     auto disable_power_output() -> void { power = 0; }
+    [[nodiscard]] auto get_power() const -> double { return power; }
     auto set_thermal_offsets(flash::OffsetConstants* constants) -> bool {
         sim_stored_offsets = *constants;
         return true;
@@ -30,55 +33,89 @@ struct SimHeaterPolicy {
     };
 
   private:
-    double power = 0;
+    // Read by the periodic job that steps the model
+    std::atomic<double> power = 0;
     flash::OffsetConstants sim_stored_offsets = {};
 };
 
+/**
+ * An RC model of the heater pads and the board, stepped once per control
+ * period as the ADC converts on hardware.
+ *
+ * The pads and the plate they heat are one thermal mass, with a delay
+ * before the thermistors see a change in power, so that a ramp overshoots
+ * and an autotune oscillates as they do on hardware. The board thermistor
+ * sits by the heater drive electronics, which warm it a little above
+ * ambient in proportion to the heater power.
+ */
+struct SimHeaterPads {
+    static constexpr double AMBIENT_C = 25.0;
+    static constexpr double PERIOD_S =
+        heater_thread::SimHeaterTask::CONTROL_PERIOD_S;
+    // Temperature rise of the pads over ambient at full power
+    static constexpr double PAD_GAIN_C = 100.0;
+    static constexpr double PAD_TIME_CONSTANT_S = 120.0;
+    static constexpr double PAD_DEAD_TIME_S = 3.0;
+    // The board idles a little above ambient
+    static constexpr double BOARD_IDLE_RISE_C = 5.0;
+    // Further temperature rise of the board at full power
+    static constexpr double BOARD_GAIN_C = 10.0;
+    static constexpr double BOARD_TIME_CONSTANT_S = 300.0;
+
+    double pads = AMBIENT_C;
+    double board = AMBIENT_C + BOARD_IDLE_RISE_C;
+    std::deque<double> delayed_power = std::deque<double>(
+        static_cast<size_t>(PAD_DEAD_TIME_S / PERIOD_S), 0.0);
+
+    auto step(double power) -> void {
+        delayed_power.push_back(power);
+        auto applied = delayed_power.front();
+        delayed_power.pop_front();
+        pads += (PAD_GAIN_C * applied - (pads - AMBIENT_C)) /
+                PAD_TIME_CONSTANT_S * PERIOD_S;
+        board += (BOARD_GAIN_C * power -
+                  (board - AMBIENT_C - BOARD_IDLE_RISE_C)) /
+                 BOARD_TIME_CONSTANT_S * PERIOD_S;
+    }
+};
+
 struct heater_thread::TaskControlBlock {
     TaskControlBlock()
-        : queue(SimHeaterTask::Queue()), task(SimHeaterTask(queue)) {}
+        : queue(SimHeaterTask::Queue()),
+          task(SimHeaterTask(queue)),
+          converter(SimHeaterTask::THERMISTOR_CIRCUIT_BIAS_RESISTANCE_KOHM,
+                    SimHeaterTask::ADC_BIT_DEPTH,
+                    SimHeaterTask::HEATER_PAD_NTC_DISCONNECT_THRESHOLD_ADC) {}
     SimHeaterTask::Queue queue;
     SimHeaterTask task;
+    SimHeaterPolicy policy{};
+    thermistor_conversion::Conversion<lookups::NTCG104ED104DTDSX> converter;
+    // Only touched by the periodic job
+    SimHeaterPads pads{};
 };
 
-auto run(std::stop_token st,
-         std::shared_ptr<heater_thread::TaskControlBlock> tcb) -> void {
-    auto policy = SimHeaterPolicy();
-    auto converter = thermistor_conversion::Conversion<
-        lookups::NTCG104ED104DTDSX>(
-        heater_thread::SimHeaterTask::THERMISTOR_CIRCUIT_BIAS_RESISTANCE_KOHM,
-        heater_thread::SimHeaterTask::ADC_BIT_DEPTH,
-        heater_thread::SimHeaterTask::HEATER_PAD_NTC_DISCONNECT_THRESHOLD_ADC);
-    tcb->queue.set_stop_token(st);
+// Run once per control period: step the model with the power the task last
+// chose and send the task a conversion, as the ADC does on hardware. The
+// pool doesn't run this again until the task has had a chance to respond.
+auto run(heater_thread::TaskControlBlock& tcb) -> void {
+    static constexpr uint32_t SEND_TIMEOUT_MS =
+        heater_thread::SimHeaterTask::CONTROL_PERIOD_TICKS;
+    tcb.pads.step(tcb.policy.get_power());
     auto conversion_message = messages::TemperatureConversionComplete{
-        .pad_a = converter.backconvert(25.0),
-        .pad_b = converter.backconvert(25.0),
-        .board = converter.backconvert(30),
-    };
-    tcb->queue.get_backing_queue().push(
-        messages::HeaterMessage(conversion_message));
-    while (!st.stop_requested()) {
-        auto last_setpoint = tcb->task.get_setpoint();
-        try {
-            tcb->task.run_once(policy);
-        } catch (const heater_thread::SimHeaterTask::Queue::StopDuringMsgWait&
-                     sdmw) {
-            return;
-        }
-        auto new_setpoint = tcb->task.get_setpoint();
-        if (last_setpoint != new_setpoint) {
-            auto conversion_message = messages::TemperatureConversionComplete{
-                .pad_a = converter.backconvert(tcb->task.get_setpoint()),
-                .pad_b = converter.backconvert(tcb->task.get_setpoint()),
-                .board = converter.backconvert(30)};
-            tcb->queue.get_backing_queue().push(
-                messages::HeaterMessage(conversion_message));
-        }
-    }
+        .pad_a = tcb.converter.backconvert(tcb.pads.pads),
+        .pad_b = tcb.converter.backconvert(tcb.pads.pads),
+        .board = tcb.converter.backconvert(tcb.pads.board)};
+    static_cast<void>(tcb.queue.try_send(conversion_message, SEND_TIMEOUT_MS));
 }
 
-auto heater_thread::build()
-    -> tasks::Task<std::unique_ptr<std::jthread>, SimHeaterTask> {
+auto heater_thread::build(sim_worker_pool::WorkerPool& pool)
+    -> tasks::Task<std::shared_ptr<TaskControlBlock>, SimHeaterTask> {
     auto tcb = std::make_shared<TaskControlBlock>();
-    return tasks::Task(std::make_unique<std::jthread>(run, tcb), &tcb->task);
+    // The first conversion is ready as soon as the task starts
+    run(*tcb);
+    pool.add([tcb]() { return tcb->queue.has_message(); },
+             [tcb]() { tcb->task.run_once(tcb->policy); });
+    pool.add_periodic(SimHeaterTask::CONTROL_PERIOD_TICKS,
+                      [tcb]() { run(*tcb); });
+    return tasks::Task{tcb, &tcb->task};
 }
@@ -6,28 +6,36 @@
 #include "simulator/comm_thread.hpp"
 #include "simulator/heater_thread.hpp"
 #include "simulator/motor_thread.hpp"
+#include "simulator/sim_clock.hpp"
 #include "simulator/sim_driver.hpp"
+#include "simulator/sim_worker_pool.hpp"
 #include "simulator/simulator_queue.hpp"
 #include "simulator/system_thread.hpp"
 
 using namespace std;
 
+// Threads shared by the tasks. The heater and the motor can each be busy
+// while the other handles a message.
+static constexpr size_t SIMULATOR_WORKERS = 2;
+
 int main(int argc, char *argv[]) {
-    auto sim_driver = cli_parser::get_sim_driver(argc, argv);
-    auto system = system_thread::build();
-    auto heater = heater_thread::build();
-    auto motor = motor_thread::build();
-    auto comms = comm_thread::build(std::move(sim_driver));
+    auto speedup = sim_clock::SimClock::LOCKSTEP;
+    auto cli_ret = cli_parser::get_sim_driver(argc, argv, speedup);
+    auto sim_driver = cli_ret.first;
+    auto realtime =
+        cli_ret.second || cli_parser::check_realtime_environment_variable();
+    auto clock = std::make_shared<sim_clock::SimClock>(
+        realtime ? sim_clock::SimClock::REALTIME : speedup);
+    auto pool = sim_worker_pool::WorkerPool(clock, SIMULATOR_WORKERS);
+
+    auto system = system_thread::build(pool);
+    auto heater = heater_thread::build(pool);
+    auto motor = motor_thread::build(pool);
+    auto comms = comm_thread::build(pool, sim_driver);
     auto tasks = tasks::Tasks<SimulatorMessageQueue>(heater.task, comms.task,
                                                      motor.task, system.task);
+    pool.start();
     comm_thread::handle_input(std::move(sim_driver), tasks);
-    system.handle->request_stop();
-    heater.handle->request_stop();
-    motor.handle->request_stop();
-    comms.handle->request_stop();
-    system.handle->join();
-    heater.handle->join();
-    motor.handle->join();
-    comms.handle->join();
+    pool.stop();
     return 0;
 }
@@ -1,17 +1,24 @@
 #include "simulator/motor_thread.hpp"
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
-#include <stop_token>
-#include <thread>
+#include <utility>
 
 #include "heater-shaker/errors.hpp"
 #include "heater-shaker/motor_task.hpp"
+#include "heater-shaker/shake_sequence.hpp"
 #include "heater-shaker/tasks.hpp"
+#include "simulator/sim_clock.hpp"
 #include "systemwide.h"
 
 using namespace motor_thread;
 
+/*
+ * The simulated motor ramps towards its setpoint at the ramp rate, like the
+ * motor controller does. The ramp follows the simulator clock, so the speed
+ * keeps changing between commands and the host sees it ramp when it polls.
+ */
 struct SimMotorPolicy {
   private:
     bool serial_number_set = false;
@@ -22,16 +29,21 @@ struct SimMotorPolicy {
 
   public:
     static constexpr int32_t DEFAULT_RAMP_RATE_RPM_PER_S = 1000;
-    static constexpr int32_t MAX_RAMP_RATE_RPM_PER_S = 20000;
-    static constexpr int32_t MIN_RAMP_RATE_RPM_PER_S = 1;
+    static constexpr int32_t MAX_RAMP_RATE_RPM_PER_S =
+        shake_sequence::MAX_RAMP_RATE_RPM_PER_S;
+    static constexpr int32_t MIN_RAMP_RATE_RPM_PER_S =
+        shake_sequence::MIN_RAMP_RATE_RPM_PER_S;
+
+    explicit SimMotorPolicy(std::shared_ptr<sim_clock::SimClock> clock)
+        : clock(std::move(clock)), ramp_start_ms(this->clock->now_ms()) {}
 
     auto set_rpm(int16_t rpm) -> errors::ErrorCode {
+        restart_ramp();
         rpm_setpoint = rpm;
-        rpm_current = rpm;
         return errors::ErrorCode::NO_ERROR;
     };
     [[nodiscard]] auto get_current_rpm() const -> int16_t {
-        return rpm_current;
+        return static_cast<int16_t>(rpm_at(clock->now_ms()));
     }
     [[nodiscard]] auto get_target_rpm() const -> int16_t {
         return rpm_setpoint;
@@ -44,10 +56,16 @@ struct SimMotorPolicy {
 
     auto stop() -> void {
         rpm_setpoint = 0;
-        rpm_current = 0;
+        ramp_start_rpm = 0;
+        ramp_start_ms = clock->now_ms();
     }
 
     auto set_ramp_rate(int32_t rpm_per_s) -> errors::ErrorCode {
+        if (rpm_per_s < MIN_RAMP_RATE_RPM_PER_S ||
+            rpm_per_s > MAX_RAMP_RATE_RPM_PER_S) {
+            return errors::ErrorCode::MOTOR_ILLEGAL_RAMP_RATE;
+        }
+        restart_ramp();
         ramp_rate = rpm_per_s;
         return errors::ErrorCode::NO_ERROR;
     }
@@ -58,10 +76,16 @@ struct SimMotorPolicy {
         static_cast<void>(current_ma);
     }
 
-    auto delay_ticks(uint16_t ticks) -> void { static_cast<void>(ticks); }
+    // Each tick is 1ms, as on the device
+    auto delay_ticks(uint16_t ticks) -> void { clock->sleep_ms(ticks); }
+
+    [[nodiscard]] auto get_time_ms() const -> uint32_t {
+        return static_cast<uint32_t>(clock->now_ms());
+    }
 
     auto plate_lock_set_power(float power) -> void {
         sim_plate_lock_power = power;
+        sim_plate_lock_direction = power;
         sim_plate_lock_enabled = true;
         sim_plate_lock_braked = false;
     }
@@ -82,20 +106,14 @@ struct SimMotorPolicy {
 
     auto plate_lock_braked() const -> bool { return sim_plate_lock_braked; }
 
+    // Once braked, the lock is at the end it was last driven towards; the
+    // motor task opens with positive power and closes with negative power
     auto plate_lock_open_sensor_read() const -> bool {
-        if (!sim_plate_lock_braked) {
-            return false;
-        } else {
-            return sim_plate_lock_power < 0.0 ? true : false;
-        }
+        return sim_plate_lock_braked && (sim_plate_lock_direction > 0.0);
     }
 
     auto plate_lock_closed_sensor_read() const -> bool {
-        if (!sim_plate_lock_braked) {
-            return false;
-        } else {
-            return sim_plate_lock_power > 0.0 ? true : false;
-        }
+        return sim_plate_lock_braked && (sim_plate_lock_direction < 0.0);
     }
 
     auto get_serial_number(void)
@@ -110,35 +128,50 @@ struct SimMotorPolicy {
     }
 
   private:
+    // The speed at a time since the ramp started
+    [[nodiscard]] auto rpm_at(uint64_t now_ms) const -> double {
+        auto step = static_cast<double>(ramp_rate) *
+                    static_cast<double>(now_ms - ramp_start_ms) / 1000.0;
+        auto setpoint = static_cast<double>(rpm_setpoint);
+        if (ramp_start_rpm < setpoint) {
+            return std::min(ramp_start_rpm + step, setpoint);
+        }
+        return std::max(ramp_start_rpm - step, setpoint);
+    }
+
+    // Start a new ramp from the current speed, before the setpoint or the
+    // ramp rate change
+    auto restart_ramp() -> void {
+        auto now = clock->now_ms();
+        ramp_start_rpm = rpm_at(now);
+        ramp_start_ms = now;
+    }
+
+    std::shared_ptr<sim_clock::SimClock> clock;
     int16_t rpm_setpoint = 0;
-    int16_t rpm_current = 0;
+    double ramp_start_rpm = 0;
+    uint64_t ramp_start_ms;
     int32_t ramp_rate = DEFAULT_RAMP_RATE_RPM_PER_S;
     float sim_plate_lock_power = 0;
+    float sim_plate_lock_direction = 0;
     bool sim_plate_lock_enabled = false;
     bool sim_plate_lock_braked = false;
 };
 
 struct motor_thread::TaskControlBlock {
-    TaskControlBlock()
-        : queue(SimMotorTask::Queue()), task(SimMotorTask(queue)) {}
+    explicit TaskControlBlock(std::shared_ptr<sim_clock::SimClock> clock)
+        : queue(SimMotorTask::Queue()),
+          task(SimMotorTask(queue)),
+          policy(std::move(clock)) {}
     SimMotorTask::Queue queue;
     SimMotorTask task;
+    SimMotorPolicy policy;
 };
 
-auto run(std::stop_token st, std::shared_ptr<TaskControlBlock> tcb) -> void {
-    auto policy = SimMotorPolicy();
-    tcb->queue.set_stop_token(st);
-    while (!st.stop_requested()) {
-        try {
-            tcb->task.run_once(policy);
-        } catch (const SimMotorTask::Queue::StopDuringMsgWait& sdmw) {
-            return;
-        }
-    }
-}
-
-auto motor_thread::build()
-    -> tasks::Task<std::unique_ptr<std::jthread>, SimMotorTask> {
-    auto tcb = std::make_shared<TaskControlBlock>();
-    return tasks::Task{std::make_unique<std::jthread>(run, tcb), &tcb->task};
+auto motor_thread::build(sim_worker_pool::WorkerPool& pool)
+    -> tasks::Task<std::shared_ptr<TaskControlBlock>, SimMotorTask> {
+    auto tcb = std::make_shared<TaskControlBlock>(pool.clock());
+    pool.add([tcb]() { return tcb->queue.has_message(); },
+             [tcb]() { tcb->task.run_once(tcb->policy); });
+    return tasks::Task{tcb, &tcb->task};
 }
@@ -0,0 +1,65 @@
+/*
+ * The heater-shaker simulator as a plugin for the sim host, which runs it
+ * alongside other simulated modules on a shared worker pool.
+ */
+#include <boost/system/system_error.hpp>
+#include <memory>
+
+#include "heater-shaker/tasks.hpp"
+#include "simulator/comm_thread.hpp"
+#include "simulator/heater_thread.hpp"
+#include "simulator/motor_thread.hpp"
+#include "simulator/sim_driver.hpp"
+#include "simulator/sim_module.hpp"
+#include "simulator/sim_worker_pool.hpp"
+#include "simulator/simulator_queue.hpp"
+#include "simulator/socket_sim_driver.hpp"
+#include "simulator/system_thread.hpp"
+
+namespace {
+
+class HeaterShakerModule : public sim_module::SimModule {
+  public:
+    HeaterShakerModule(sim_worker_pool::WorkerPool& pool,
+                       std::shared_ptr<sim_driver::SimDriver> driver)
+        : _driver(std::move(driver)),
+          _system(system_thread::build(pool)),
+          _heater(heater_thread::build(pool)),
+          _motor(motor_thread::build(pool)),
+          _comms(comm_thread::build(pool, _driver)),
+          _tasks(_heater.task, _comms.task, _motor.task, _system.task) {}
+
+    auto read_input() -> void override {
+        try {
+            comm_thread::handle_input(std::shared_ptr(_driver), _tasks);
+        } catch (const boost::system::system_error&) {
+            // The socket closing ends the read; the other modules keep
+            // running
+        }
+    }
+
+  private:
+    std::shared_ptr<sim_driver::SimDriver> _driver;
+    tasks::Task<std::shared_ptr<system_thread::TaskControlBlock>,
+                system_thread::SimSystemTask>
+        _system;
+    tasks::Task<std::shared_ptr<heater_thread::TaskControlBlock>,
+                heater_thread::SimHeaterTask>
+        _heater;
+    tasks::Task<std::shared_ptr<motor_thread::TaskControlBlock>,
+                motor_thread::SimMotorTask>
+        _motor;
+    tasks::Task<std::shared_ptr<comm_thread::TaskControlBlock>,
+                comm_thread::SimCommTask>
+        _comms;
+    tasks::Tasks<SimulatorMessageQueue> _tasks;
+};
+
+}  // namespace
+
+SIM_MODULE_EXPORT auto sim_module_add(sim_worker_pool::WorkerPool& pool,
+                                      const char* socket)
+    -> sim_module::SimModule* {
+    return new HeaterShakerModule(
+        pool, std::make_shared<socket_sim_driver::SocketSimDriver>(socket));
+}
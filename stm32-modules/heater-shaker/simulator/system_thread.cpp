@@ -1,13 +1,10 @@
 #include "simulator/system_thread.hpp"
 
 #include <array>
-#include <chrono>
 #include <cstdint>
 #include <cstdlib>
 #include <iterator>
 #include <memory>
-#include <stop_token>
-#include <thread>
 
 #include "heater-shaker/errors.hpp"
 #include "heater-shaker/tasks.hpp"
@@ -64,37 +61,24 @@ struct SimSystemPolicy {
 
 struct system_thread::TaskControlBlock {
     TaskControlBlock()
-        : queue(SimSystemTask::Queue()), task(SimSystemTask(queue)) {}
+        : queue(SimSystemTask::Queue()), task(SimSystemTask(queue)) {
+        // Populate the serial number on startup, if provided
+        constexpr const char serial_var_name[] = "SERIAL_NUMBER";
+        auto ret = simulator_utils::get_serial_number<
+            SYSTEM_WIDE_SERIAL_NUMBER_LENGTH>(serial_var_name);
+        if (ret.has_value()) {
+            static_cast<void>(policy.set_serial_number(ret.value()));
+        }
+    }
     SimSystemTask::Queue queue;
     SimSystemTask task;
+    SimSystemPolicy policy{};
 };
 
-auto run(std::stop_token st, std::shared_ptr<TaskControlBlock> tcb) -> void {
-    using namespace std::literals::chrono_literals;
-    auto policy = SimSystemPolicy();
-
-    // Populate the serial number on startup, if provided
-    constexpr const char serial_var_name[] = "SERIAL_NUMBER";
-    auto ret =
-        simulator_utils::get_serial_number<SYSTEM_WIDE_SERIAL_NUMBER_LENGTH>(
-            serial_var_name);
-    if (ret.has_value()) {
-        static_cast<void>(policy.set_serial_number(ret.value()));
-    }
-
-    tcb->queue.set_stop_token(st);
-
-    while (!st.stop_requested()) {
-        try {
-            tcb->task.run_once(policy);
-        } catch (const SimSystemTask::Queue::StopDuringMsgWait sdmw) {
-            return;
-        }
-    }
-}
-
-auto system_thread::build()
-    -> tasks::Task<std::unique_ptr<std::jthread>, SimSystemTask> {
+auto system_thread::build(sim_worker_pool::WorkerPool& pool)
+    -> tasks::Task<std::shared_ptr<TaskControlBlock>, SimSystemTask> {
     auto tcb = std::make_shared<TaskControlBlock>();
-    return tasks::Task(std::make_unique<std::jthread>(run, tcb), &tcb->task);
+    pool.add([tcb]() { return tcb->queue.has_message(); },
+             [tcb]() { tcb->task.run_once(tcb->policy); });
+    return tasks::Task{tcb, &tcb->task};
 }
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <vector>
+
 #include "catch2/catch.hpp"
 #include "core/pid.hpp"
 #include "heater-shaker/heater_task.hpp"
@@ -881,3 +884,209 @@ SCENARIO("heater task error handling") {
         }
     }
 }
+
+SCENARIO("heater task relay autotune") {
+    using HeaterTask = heater_task::HeaterTask<TestMessageQueue>;
+    GIVEN("an idle heater task") {
+        auto tasks = TaskBuilder::build();
+        auto &policy = tasks->get_heater_policy();
+        auto &host_queue = tasks->get_host_comms_queue();
+        double pad_temp = 40.0;
+        auto send_temp = [&]() {
+            auto adc = _converter.backconvert(pad_temp);
+            tasks->get_heater_queue().backing_deque.push_back(
+                messages::HeaterMessage(
+                    messages::TemperatureConversionComplete{
+                        .pad_a = adc,
+                        .pad_b = adc,
+                        .board = _converter.backconvert(30.0)}));
+            tasks->run_heater_task();
+        };
+        send_temp();
+        host_queue.backing_deque.clear();
+        auto get_result = [&]() {
+            host_queue.backing_deque.clear();
+            tasks->get_heater_queue().backing_deque.push_back(
+                messages::HeaterMessage(
+                    messages::GetAutotuneResultMessage{.id = 5}));
+            tasks->run_heater_task();
+            return std::get<messages::GetAutotuneResultResponse>(
+                host_queue.backing_deque.front());
+        };
+        WHEN("starting an autotune below the pad temperature") {
+            tasks->get_heater_queue().backing_deque.push_back(
+                messages::HeaterMessage(
+                    messages::StartAutotuneMessage{.id = 3, .target = 30.0}));
+            tasks->run_heater_task();
+            THEN("the task responds with an error") {
+                auto response = std::get<messages::AcknowledgePrevious>(
+                    host_queue.backing_deque.front());
+                REQUIRE(response.responding_to_id == 3);
+                REQUIRE(response.with_error ==
+                        errors::ErrorCode::HEATER_ILLEGAL_TARGET_TEMPERATURE);
+                REQUIRE(get_result().status == relay_autotune::Status::IDLE);
+            }
+        }
+        WHEN("starting an autotune above the pad temperature") {
+            tasks->get_heater_queue().backing_deque.push_back(
+                messages::HeaterMessage(
+                    messages::StartAutotuneMessage{.id = 3, .target = 50.0}));
+            tasks->run_heater_task();
+            THEN("the task acknowledges the message") {
+                auto response = std::get<messages::AcknowledgePrevious>(
+                    host_queue.backing_deque.front());
+                REQUIRE(response.responding_to_id == 3);
+                REQUIRE(response.with_error == errors::ErrorCode::NO_ERROR);
+                REQUIRE(tasks->get_heater_task().autotuning());
+            }
+            AND_WHEN("the pads oscillate under the relay") {
+                // The pads heat at 1ºC/s at full power, cool at 0.25ºC/s,
+                // and lag the heater by a second
+                std::vector<double> delayed(
+                    static_cast<size_t>(1.0 / HeaterTask::CONTROL_PERIOD_S),
+                    0.0);
+                for (int i = 0; i < 5000; ++i) {
+                    send_temp();
+                    if (!tasks->get_heater_task().autotuning()) {
+                        break;
+                    }
+                    delayed.push_back(policy.last_enable_setting()
+                                          ? policy.last_power_setting()
+                                          : 0.0);
+                    pad_temp += ((delayed.front() * 1.25) - 0.25) *
+                                HeaterTask::CONTROL_PERIOD_S;
+                    delayed.erase(delayed.begin());
+                }
+                THEN("the autotune completes and the new gains are applied") {
+                    auto response = get_result();
+                    REQUIRE(response.status == relay_autotune::Status::DONE);
+                    REQUIRE(response.cycles ==
+                            relay_autotune::RelayAutotune::MEASURED_CYCLES);
+                    REQUIRE(response.result.kp > 0.0);
+                    REQUIRE_THAT(
+                        tasks->get_heater_task().get_pid().kp(),
+                        Catch::Matchers::WithinAbs(response.result.kp, 0.0001));
+                    REQUIRE(!policy.last_enable_setting());
+                    REQUIRE(tasks->get_heater_task().get_setpoint() == 0.0);
+                }
+            }
+            AND_WHEN("the pads swing slowly just past the hysteresis") {
+                // A small, slow oscillation gives a derivative gain far too
+                // high to use. Each temperature is the first one whose
+                // reading, with the thermistor offsets, is past the
+                // hysteresis.
+                auto reading = [](double temp) {
+                    auto converted = std::get<double>(
+                        _converter.convert(_converter.backconvert(temp)));
+                    return ((1 + _thermal_offset_B) * converted) +
+                           _thermal_offset_C;
+                };
+                auto just_past = [&](double threshold, double step) {
+                    // Start a degree short of the threshold
+                    auto temp = threshold - (step * 10000);
+                    while ((reading(temp) - threshold) * step <= 0.0) {
+                        temp += step;
+                    }
+                    return temp;
+                };
+                auto high = just_past(
+                    50.0 + HeaterTask::AUTOTUNE_HYSTERESIS_C, 0.0001);
+                auto low = just_past(
+                    50.0 - HeaterTask::AUTOTUNE_HYSTERESIS_C, -0.0001);
+                // Each half of the swing lasts 250s
+                constexpr int half_period =
+                    static_cast<int>(250.0 / HeaterTask::CONTROL_PERIOD_S);
+                auto old_kd = tasks->get_heater_task().get_pid().kd();
+                host_queue.backing_deque.clear();
+                for (int i = 0; i < half_period * 20; ++i) {
+                    pad_temp = ((i / half_period) % 2 == 0) ? high : low;
+                    send_temp();
+                    if (!tasks->get_heater_task().autotuning()) {
+                        break;
+                    }
+                }
+                THEN("the result is reported and the old gains are kept") {
+                    REQUIRE(!tasks->get_heater_task().autotuning());
+                    REQUIRE(std::ranges::any_of(
+                        host_queue.backing_deque, [](const auto &msg) {
+                            auto *error =
+                                std::get_if<messages::ErrorMessage>(&msg);
+                            return (error != nullptr) &&
+                                   (error->code ==
+                                    errors::ErrorCode::
+                                        HEATER_CONSTANT_OUT_OF_RANGE);
+                        }));
+                    REQUIRE(tasks->get_heater_task().get_pid().kd() ==
+                            old_kd);
+                    auto response = get_result();
+                    REQUIRE(response.status == relay_autotune::Status::DONE);
+                    REQUIRE(response.result.kd > HeaterTask::KD_MAX);
+                }
+            }
+            AND_WHEN("setting a temperature") {
+                tasks->get_heater_queue().backing_deque.push_back(
+                    messages::HeaterMessage(messages::SetTemperatureMessage{
+                        .id = 4, .target_temperature = 45.0}));
+                tasks->run_heater_task();
+                THEN("the autotune is aborted") {
+                    REQUIRE(!tasks->get_heater_task().autotuning());
+                    REQUIRE(get_result().status ==
+                            relay_autotune::Status::FAILED);
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("heater task ramped setpoints") {
+    using HeaterTask = heater_task::HeaterTask<TestMessageQueue>;
+    GIVEN("a heater task with valid temps") {
+        auto tasks = TaskBuilder::build();
+        auto &heater = tasks->get_heater_task();
+        auto send_temp = [&]() {
+            auto adc = _converter.backconvert(40.0);
+            tasks->get_heater_queue().backing_deque.push_back(
+                messages::HeaterMessage(
+                    messages::TemperatureConversionComplete{
+                        .pad_a = adc, .pad_b = adc, .board = adc}));
+            tasks->run_heater_task();
+        };
+        send_temp();
+        WHEN("setting a temperature without a ramp rate") {
+            tasks->get_heater_queue().backing_deque.push_back(
+                messages::HeaterMessage(messages::SetTemperatureMessage{
+                    .id = 1, .target_temperature = 60.0}));
+            tasks->run_heater_task();
+            THEN("the controller setpoint jumps to the target") {
+                REQUIRE(heater.get_setpoint() == 60.0);
+                REQUIRE(!heater.get_ramp().ramping());
+                REQUIRE(heater.get_ramp().setpoint() == 60.0);
+            }
+        }
+        WHEN("setting a temperature with a 1ºC/s ramp rate") {
+            tasks->get_heater_queue().backing_deque.push_back(
+                messages::HeaterMessage(messages::SetTemperatureMessage{
+                    .id = 1, .target_temperature = 60.0, .ramp_rate = 1.0}));
+            tasks->run_heater_task();
+            auto start = heater.get_ramp().setpoint();
+            THEN("the controller setpoint starts at the pad temperature") {
+                REQUIRE(heater.get_setpoint() == 60.0);
+                REQUIRE(heater.get_ramp().ramping());
+                REQUIRE_THAT(start, Catch::Matchers::WithinAbs(40.0, 1.0));
+            }
+            AND_WHEN("running for two seconds") {
+                constexpr auto ticks =
+                    static_cast<int>(2.0 / HeaterTask::CONTROL_PERIOD_S);
+                for (int i = 0; i < ticks; ++i) {
+                    send_temp();
+                }
+                THEN("the controller setpoint has ramped by 2ºC") {
+                    REQUIRE_THAT(
+                        heater.get_ramp().setpoint(),
+                        Catch::Matchers::WithinAbs(start + 2.0, 0.001));
+                    REQUIRE(heater.get_setpoint() == 60.0);
+                }
+            }
+        }
+    }
+}
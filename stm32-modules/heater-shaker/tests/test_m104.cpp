@@ -91,4 +91,45 @@ SCENARIO("SetTemperature (M104) parser works", "[gcode][parse][m104]") {
             }
         }
     }
+
+    GIVEN("a string with a ramp rate") {
+        std::string to_parse = "M104 S60 R0.5\r\n";
+        WHEN("calling parse") {
+            auto result = gcode::SetTemperature::parse(to_parse.cbegin(),
+                                                       to_parse.cend());
+
+            THEN("the temperature and ramp rate should be parsed") {
+                REQUIRE(result.first.has_value());
+                REQUIRE(result.first.value().temperature == 60);
+                REQUIRE(result.first.value().ramp_rate == 0.5);
+                REQUIRE(result.second == to_parse.cbegin() + 13);
+            }
+        }
+    }
+
+    GIVEN("a string with a negative ramp rate") {
+        std::string to_parse = "M104 S60 R-0.5\r\n";
+        WHEN("calling parse") {
+            auto result = gcode::SetTemperature::parse(to_parse.cbegin(),
+                                                       to_parse.cend());
+
+            THEN("nothing should be parsed") {
+                REQUIRE(!result.first.has_value());
+                REQUIRE(result.second == to_parse.cbegin());
+            }
+        }
+    }
+
+    GIVEN("a string without a ramp rate") {
+        std::string to_parse = "M104 S60\r\n";
+        WHEN("calling parse") {
+            auto result = gcode::SetTemperature::parse(to_parse.cbegin(),
+                                                       to_parse.cend());
+
+            THEN("the setpoint jumps to the target") {
+                REQUIRE(result.first.has_value());
+                REQUIRE(result.first.value().ramp_rate == 0.0);
+            }
+        }
+    }
 }
@@ -0,0 +1,55 @@
+#include "catch2/catch.hpp"
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#include "heater-shaker/gcodes.hpp"
+#pragma GCC diagnostic pop
+
+SCENARIO("StartAutotune (M303) parser works", "[gcode][parse][m303]") {
+    GIVEN("a response buffer large enough for the formatted response") {
+        std::string buffer(64, 'c');
+        WHEN("filling response") {
+            auto written = gcode::StartAutotune::write_response_into(
+                buffer.begin(), buffer.end());
+            THEN("the response should be written in full") {
+                auto response_str = "M303 OK\n";
+                REQUIRE_THAT(buffer, Catch::Matchers::StartsWith(response_str));
+                REQUIRE(written == buffer.begin() + strlen(response_str));
+            }
+        }
+    }
+    GIVEN("a valid input") {
+        std::string to_parse = "M303 T72.5\r\n";
+        WHEN("calling parse") {
+            auto result = gcode::StartAutotune::parse(to_parse.cbegin(),
+                                                      to_parse.cend());
+            THEN("the target should be parsed") {
+                REQUIRE(result.first.has_value());
+                REQUIRE_THAT(result.first.value().target,
+                             Catch::Matchers::WithinAbs(72.5, 0.001));
+                REQUIRE(result.second != to_parse.cbegin());
+            }
+        }
+    }
+    GIVEN("an input with no target") {
+        std::string to_parse = "M303 T\r\n";
+        WHEN("calling parse") {
+            auto result = gcode::StartAutotune::parse(to_parse.cbegin(),
+                                                      to_parse.cend());
+            THEN("nothing should be parsed") {
+                REQUIRE(!result.first.has_value());
+                REQUIRE(result.second == to_parse.cbegin());
+            }
+        }
+    }
+    GIVEN("an input with the wrong prefix") {
+        std::string to_parse = "M304 T50\r\n";
+        WHEN("calling parse") {
+            auto result = gcode::StartAutotune::parse(to_parse.cbegin(),
+                                                      to_parse.cend());
+            THEN("nothing should be parsed") {
+                REQUIRE(!result.first.has_value());
+                REQUIRE(result.second == to_parse.cbegin());
+            }
+        }
+    }
+}
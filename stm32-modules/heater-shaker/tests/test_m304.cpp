@@ -0,0 +1,53 @@
+#include "catch2/catch.hpp"
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#include "heater-shaker/gcodes.hpp"
+#pragma GCC diagnostic pop
+
+SCENARIO("GetAutotuneResult (M304) parser works", "[gcode][parse][m304]") {
+    auto result = relay_autotune::Result{.ultimate_gain = 0.25,
+                                         .ultimate_period = 96.5,
+                                         .kp = 0.15,
+                                         .ki = 0.0031,
+                                         .kd = 1.8094};
+    GIVEN("a response buffer large enough for the formatted response") {
+        std::string buffer(128, 'c');
+        WHEN("filling response") {
+            auto written = gcode::GetAutotuneResult::write_response_into(
+                buffer.begin(), buffer.end(), relay_autotune::Status::DONE, 4,
+                result);
+            THEN("the response should be written in full") {
+                auto response_str =
+                    "M304 R:DONE C:4 U:0.2500 T:96.50 P:0.1500 I:0.0031 "
+                    "D:1.8094 OK\n";
+                REQUIRE_THAT(buffer, Catch::Matchers::StartsWith(response_str));
+                REQUIRE(written == buffer.begin() + strlen(response_str));
+            }
+        }
+    }
+    GIVEN("a response buffer not large enough for the formatted response") {
+        std::string buffer(16, 'c');
+        WHEN("filling response") {
+            auto written = gcode::GetAutotuneResult::write_response_into(
+                buffer.begin(), buffer.begin() + 7,
+                relay_autotune::Status::RUNNING, 1, result);
+            THEN("the response should write only up to the available space") {
+                std::string response = "M304 Rcccccccccc";
+                response.at(6) = '\0';
+                REQUIRE_THAT(buffer, Catch::Matchers::Equals(response));
+                REQUIRE(written == buffer.begin() + 7);
+            }
+        }
+    }
+    GIVEN("a valid input") {
+        std::string to_parse = "M304\r\n";
+        WHEN("calling parse") {
+            auto res = gcode::GetAutotuneResult::parse(to_parse.cbegin(),
+                                                       to_parse.cend());
+            THEN("a valid gcode should be produced") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(res.second != to_parse.cbegin());
+            }
+        }
+    }
+}
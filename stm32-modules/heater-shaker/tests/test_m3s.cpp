@@ -0,0 +1,141 @@
+#include <array>
+
+#include "catch2/catch.hpp"
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#include "heater-shaker/gcodes.hpp"
+#pragma GCC diagnostic pop
+
+SCENARIO("RunShakeSequence (M3.S) parser works", "[gcode][parse][m3.s]") {
+    GIVEN("a string with prefix only") {
+        std::string to_parse = "M3.S\r\n";
+        WHEN("calling parse") {
+            auto result = gcode::RunShakeSequence::parse(to_parse.cbegin(),
+                                                         to_parse.cend());
+            THEN("nothing should be parsed") {
+                REQUIRE(!result.first.has_value());
+                REQUIRE(result.second == to_parse.cbegin());
+            }
+        }
+    }
+
+    GIVEN("a string with one segment") {
+        std::string to_parse = "M3.S S500 A1000 D2000\r\n";
+        WHEN("calling parse") {
+            auto result = gcode::RunShakeSequence::parse(to_parse.cbegin(),
+                                                         to_parse.cend());
+            THEN("the segment is parsed and runs once") {
+                REQUIRE(result.first.has_value());
+                auto sequence = result.first.value().sequence;
+                REQUIRE(sequence.count == 1);
+                REQUIRE(sequence.cycles == 1);
+                REQUIRE(sequence.segments.at(0).rpm == 500);
+                REQUIRE(sequence.segments.at(0).ramp_rate == 1000);
+                REQUIRE(sequence.segments.at(0).duration_ms == 2000);
+                REQUIRE(result.second == to_parse.cbegin() + 21);
+            }
+        }
+    }
+
+    GIVEN("a string with cycles and several segments") {
+        std::string to_parse =
+            "M3.S C10 S1500 A2000 D3000 S0 A4000 D500 S300 A100 D0\r\n";
+        WHEN("calling parse") {
+            auto result = gcode::RunShakeSequence::parse(to_parse.cbegin(),
+                                                         to_parse.cend());
+            THEN("every segment is parsed in order") {
+                REQUIRE(result.first.has_value());
+                auto sequence = result.first.value().sequence;
+                REQUIRE(sequence.cycles == 10);
+                REQUIRE(sequence.count == 3);
+                REQUIRE(sequence.segments.at(0).rpm == 1500);
+                REQUIRE(sequence.segments.at(1).rpm == 0);
+                REQUIRE(sequence.segments.at(1).ramp_rate == 4000);
+                REQUIRE(sequence.segments.at(1).duration_ms == 500);
+                REQUIRE(sequence.segments.at(2).rpm == 300);
+                REQUIRE(sequence.segments.at(2).duration_ms == 0);
+                REQUIRE(sequence.valid());
+                REQUIRE(sequence.limits_error() ==
+                        errors::ErrorCode::NO_ERROR);
+            }
+        }
+    }
+
+    GIVEN("a string with more segments than a sequence holds") {
+        std::string to_parse =
+            "M3.S S1 A1 D1 S2 A1 D1 S3 A1 D1 S4 A1 D1 S5 A1 D1 S6 A1 D1 "
+            "S7 A1 D1 S8 A1 D1 S9 A1 D1\r\n";
+        WHEN("calling parse") {
+            auto result = gcode::RunShakeSequence::parse(to_parse.cbegin(),
+                                                         to_parse.cend());
+            THEN("parsing stops after the last segment that fits") {
+                REQUIRE(result.first.has_value());
+                auto sequence = result.first.value().sequence;
+                REQUIRE(sequence.count == shake_sequence::MAX_SEGMENTS);
+                REQUIRE(sequence.segments.at(7).rpm == 8);
+                REQUIRE(result.second == to_parse.cbegin() + 76);
+            }
+        }
+    }
+
+    GIVEN("a segment missing its duration") {
+        std::string to_parse = "M3.S S500 A1000 D2000 S200 A1000\r\n";
+        WHEN("calling parse") {
+            auto result = gcode::RunShakeSequence::parse(to_parse.cbegin(),
+                                                         to_parse.cend());
+            THEN("nothing should be parsed") {
+                REQUIRE(!result.first.has_value());
+                REQUIRE(result.second == to_parse.cbegin());
+            }
+        }
+    }
+
+    GIVEN("a segment with a ramp rate of 0") {
+        std::string to_parse = "M3.S S500 A0 D2000\r\n";
+        WHEN("calling parse") {
+            auto result = gcode::RunShakeSequence::parse(to_parse.cbegin(),
+                                                         to_parse.cend());
+            THEN("nothing should be parsed") {
+                REQUIRE(!result.first.has_value());
+                REQUIRE(result.second == to_parse.cbegin());
+            }
+        }
+    }
+
+    GIVEN("a sequence of 0 cycles") {
+        std::string to_parse = "M3.S C0 S500 A1000 D2000\r\n";
+        WHEN("calling parse") {
+            auto result = gcode::RunShakeSequence::parse(to_parse.cbegin(),
+                                                         to_parse.cend());
+            THEN("nothing should be parsed") {
+                REQUIRE(!result.first.has_value());
+                REQUIRE(result.second == to_parse.cbegin());
+            }
+        }
+    }
+
+    GIVEN("a SetRPM command") {
+        std::string to_parse = "M3 S500\r\n";
+        WHEN("calling parse") {
+            auto result = gcode::RunShakeSequence::parse(to_parse.cbegin(),
+                                                         to_parse.cend());
+            THEN("nothing should be parsed") {
+                REQUIRE(!result.first.has_value());
+            }
+        }
+    }
+}
+
+SCENARIO("RunShakeSequence (M3.S) response works", "[gcode][response][m3.s]") {
+    GIVEN("a response buffer large enough for the formatted response") {
+        std::string buffer(64, 'c');
+        WHEN("filling response") {
+            auto written = gcode::RunShakeSequence::write_response_into(
+                buffer.begin(), buffer.end());
+            THEN("the response should be written in full") {
+                REQUIRE_THAT(buffer, Catch::Matchers::StartsWith("M3.S OK\n"));
+                REQUIRE(written != buffer.begin());
+            }
+        }
+    }
+}
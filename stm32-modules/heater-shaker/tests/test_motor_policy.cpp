@@ -70,8 +70,13 @@ auto TestMotorPolicy::test_get_last_delay() const -> uint16_t {
 
 auto TestMotorPolicy::delay_ticks(uint16_t ticks) -> void {
     last_delay = ticks;
+    time_ms += ticks;
 }
 
+auto TestMotorPolicy::get_time_ms() const -> uint32_t { return time_ms; }
+
+auto TestMotorPolicy::test_advance_time(uint32_t ms) -> void { time_ms += ms; }
+
 auto TestMotorPolicy::plate_lock_set_power(float power) -> void {
     plate_lock_power = power;
     plate_lock_enabled = true;
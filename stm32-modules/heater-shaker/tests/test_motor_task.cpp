@@ -1577,3 +1577,200 @@ SCENARIO("motor task debug plate lock handling", "[motor][debug]") {
         }
     }
 }
+
+SCENARIO("motor task shake sequences", "[motor][sequence]") {
+    GIVEN("a motor task with the plate lock closed") {
+        auto tasks = TaskBuilder::build();
+        auto& policy = tasks->get_motor_policy();
+        auto& motor_queue = tasks->get_motor_queue().backing_deque;
+        auto& comms_queue = tasks->get_host_comms_queue().backing_deque;
+        auto run_once = [&]() { tasks->get_motor_task().run_once(policy); };
+        motor_queue.push_back(
+            messages::PlateLockComplete{.open = false, .closed = true});
+        run_once();
+        policy.test_set_current_rpm(1000);
+        auto sequence = shake_sequence::Sequence{.count = 2, .cycles = 2};
+        sequence.segments.at(0) = shake_sequence::Segment{
+            .rpm = 1500, .ramp_rate = 2000, .duration_ms = 100};
+        sequence.segments.at(1) = shake_sequence::Segment{
+            .rpm = 500, .ramp_rate = 1000, .duration_ms = 60};
+        auto message =
+            messages::RunShakeSequenceMessage{.id = 77, .sequence = sequence};
+
+        WHEN("running the sequence") {
+            motor_queue.push_back(message);
+            run_once();
+            THEN("the first segment starts straight away") {
+                REQUIRE(policy.get_target_rpm() == 1500);
+                REQUIRE(policy.test_get_ramp_rate() == 2000);
+                REQUIRE(tasks->get_motor_task().get_state() ==
+                        motor_task::State::RUNNING);
+                REQUIRE(tasks->get_motor_task().shake_sequence_active());
+                REQUIRE(comms_queue.empty());
+                REQUIRE(std::holds_alternative<
+                        messages::CheckShakeSequenceMessage>(
+                    motor_queue.front()));
+            }
+            AND_WHEN("the first segment has lasted its duration") {
+                run_once();
+                REQUIRE(policy.test_get_last_delay() == 50);
+                run_once();
+                REQUIRE(policy.get_target_rpm() == 1500);
+                run_once();
+                THEN("the second segment starts") {
+                    REQUIRE(policy.get_target_rpm() == 500);
+                    REQUIRE(policy.test_get_ramp_rate() == 1000);
+                }
+                AND_WHEN("the second segment has lasted its duration") {
+                    run_once();
+                    REQUIRE(policy.test_get_last_delay() == 50);
+                    run_once();
+                    REQUIRE(policy.test_get_last_delay() == 10);
+                    run_once();
+                    THEN("the next cycle starts") {
+                        REQUIRE(policy.get_target_rpm() == 1500);
+                        REQUIRE(comms_queue.empty());
+                    }
+                }
+            }
+            AND_WHEN("time passes between checks") {
+                policy.test_advance_time(80);
+                run_once();
+                THEN("it counts towards the segment") {
+                    REQUIRE(policy.test_get_last_delay() == 20);
+                    run_once();
+                    REQUIRE(policy.get_target_rpm() == 500);
+                }
+            }
+            AND_WHEN("a check comes after the segment should have ended") {
+                policy.test_advance_time(130);
+                run_once();
+                THEN("the next segment is timed from when it was due") {
+                    REQUIRE(policy.get_target_rpm() == 500);
+                    run_once();
+                    REQUIRE(policy.test_get_last_delay() == 30);
+                }
+            }
+            AND_WHEN("every cycle has run") {
+                size_t runs = 0;
+                while (!motor_queue.empty() && runs < 100) {
+                    run_once();
+                    ++runs;
+                }
+                THEN("the sequence is acknowledged at the last speed") {
+                    REQUIRE(runs == 12);
+                    REQUIRE(!tasks->get_motor_task().shake_sequence_active());
+                    REQUIRE(policy.get_target_rpm() == 500);
+                    REQUIRE(comms_queue.size() == 1);
+                    auto ack = std::get<messages::AcknowledgePrevious>(
+                        comms_queue.front());
+                    REQUIRE(ack.responding_to_id == 77);
+                    REQUIRE(ack.with_error == errors::ErrorCode::NO_ERROR);
+                }
+            }
+            AND_WHEN("a set-rpm message arrives during the sequence") {
+                motor_queue.push_back(
+                    messages::SetRPMMessage{.id = 5, .target_rpm = 800});
+                run_once();
+                run_once();
+                THEN("the sequence is interrupted") {
+                    REQUIRE(!tasks->get_motor_task().shake_sequence_active());
+                    REQUIRE(policy.get_target_rpm() == 800);
+                    REQUIRE(comms_queue.size() == 2);
+                    auto ack = std::get<messages::AcknowledgePrevious>(
+                        comms_queue.front());
+                    REQUIRE(ack.responding_to_id == 77);
+                    REQUIRE(ack.with_error ==
+                            errors::ErrorCode::MOTOR_SEQUENCE_INTERRUPTED);
+                    ack = std::get<messages::AcknowledgePrevious>(
+                        comms_queue.back());
+                    REQUIRE(ack.responding_to_id == 5);
+                    REQUIRE(ack.with_error == errors::ErrorCode::NO_ERROR);
+                }
+                AND_THEN("the check left from the sequence is ignored") {
+                    REQUIRE(motor_queue.size() == 1);
+                    run_once();
+                    REQUIRE(motor_queue.empty());
+                    REQUIRE(policy.get_target_rpm() == 800);
+                }
+            }
+            AND_WHEN("a motor error occurs during the sequence") {
+                motor_queue.push_front(messages::MotorSystemErrorMessage{
+                    .errors = static_cast<uint16_t>(
+                        1u << errors::MotorErrorOffset::SW_ERROR)});
+                run_once();
+                THEN("the sequence ends with the error") {
+                    REQUIRE(!tasks->get_motor_task().shake_sequence_active());
+                    auto ack = std::get<messages::AcknowledgePrevious>(
+                        comms_queue.front());
+                    REQUIRE(ack.responding_to_id == 77);
+                    REQUIRE(ack.with_error ==
+                            errors::ErrorCode::MOTOR_BLDC_DRIVER_ERROR);
+                }
+            }
+        }
+        WHEN("a segment can't start") {
+            motor_queue.push_back(message);
+            run_once();
+            policy.test_set_rpm_return_code(
+                errors::ErrorCode::MOTOR_ILLEGAL_SPEED);
+            while (!motor_queue.empty()) {
+                run_once();
+            }
+            THEN("the motor stops and the sequence ends with the error") {
+                REQUIRE(policy.get_target_rpm() == 0);
+                auto ack = std::get<messages::AcknowledgePrevious>(
+                    comms_queue.front());
+                REQUIRE(ack.responding_to_id == 77);
+                REQUIRE(ack.with_error ==
+                        errors::ErrorCode::MOTOR_ILLEGAL_SPEED);
+            }
+        }
+        WHEN("a later segment is faster than the motor can go") {
+            message.sequence.segments.at(1).rpm =
+                shake_sequence::MAX_RPM + 1;
+            motor_queue.push_back(message);
+            run_once();
+            THEN("the sequence is rejected before it starts") {
+                REQUIRE(motor_queue.empty());
+                REQUIRE(!tasks->get_motor_task().shake_sequence_active());
+                REQUIRE(policy.get_target_rpm() == 0);
+                auto ack = std::get<messages::AcknowledgePrevious>(
+                    comms_queue.front());
+                REQUIRE(ack.responding_to_id == 77);
+                REQUIRE(ack.with_error ==
+                        errors::ErrorCode::MOTOR_ILLEGAL_SPEED);
+            }
+        }
+        WHEN("a later segment ramps faster than the motor can") {
+            message.sequence.segments.at(1).ramp_rate =
+                shake_sequence::MAX_RAMP_RATE_RPM_PER_S + 1;
+            motor_queue.push_back(message);
+            run_once();
+            THEN("the sequence is rejected before it starts") {
+                REQUIRE(motor_queue.empty());
+                REQUIRE(!tasks->get_motor_task().shake_sequence_active());
+                REQUIRE(policy.get_target_rpm() == 0);
+                auto ack = std::get<messages::AcknowledgePrevious>(
+                    comms_queue.front());
+                REQUIRE(ack.responding_to_id == 77);
+                REQUIRE(ack.with_error ==
+                        errors::ErrorCode::MOTOR_ILLEGAL_RAMP_RATE);
+            }
+        }
+        WHEN("running an empty sequence") {
+            motor_queue.push_back(messages::RunShakeSequenceMessage{
+                .id = 78, .sequence = shake_sequence::Sequence{}});
+            run_once();
+            THEN("it is rejected") {
+                REQUIRE(motor_queue.empty());
+                REQUIRE(!tasks->get_motor_task().shake_sequence_active());
+                auto ack = std::get<messages::AcknowledgePrevious>(
+                    comms_queue.front());
+                REQUIRE(ack.responding_to_id == 78);
+                REQUIRE(ack.with_error ==
+                        errors::ErrorCode::MOTOR_ILLEGAL_SPEED);
+            }
+        }
+    }
+}
@@ -7,6 +7,7 @@
 
 #include <array>
 #include <cstring>  // For memcpy
+#include <optional>
 
 #include "core/bit_utils.hpp"
 
@@ -48,6 +49,15 @@ concept AT24C0xC_Policy = requires(Policy &policy, uint8_t addr,
  * to the EEPROM, so long as it is serializable into 8 or less
  * bytes.
  *
+ * The whole device is shadowed in RAM. The first access reads
+ * every page in one sequential read, and reads are served from
+ * the shadow after that. Writes are staged into the shadow and
+ * flushed as whole pages, so several values staged together cost
+ * one write-protect toggle, and pages whose contents did not
+ * change are never written. After each page write the device is
+ * polled for an ACK, which is how it signals the end of its
+ * internal write cycle.
+ *
  * @tparam PAGES Number of data pages. Must be 16 or 32.
  * @tparam ADDRESS The I2C address for this device. Pass
  * in the <b>7-bit value</b> specified in the datasheet,
@@ -58,6 +68,10 @@ template <size_t PAGES, uint8_t ADDRESS>
 class AT24C0xC {
   public:
     static const constexpr uint8_t MAX_ADDR = 0x80;
+    /** How many times to poll for the end of a write cycle. Each poll
+     * takes a few tens of microseconds, and a write cycle takes at most
+     * 5 milliseconds.*/
+    static constexpr size_t WRITE_POLL_ATTEMPTS = 250;
     // Either a 1024 or 2048 bit device
     static_assert((PAGES == 16) || (PAGES == 32),
                   "EEPROM size must be 1024 or 2048 bits");
@@ -79,24 +93,70 @@ class AT24C0xC {
     template <typename T, AT24C0xC_Policy Policy>
     requires std::is_trivially_copyable_v<T>
     auto write_value(uint8_t page, T value, Policy &policy) -> bool {
+        return stage_value(page, value, policy) && flush(policy);
+    }
+
+    /**
+     * @brief Serialize a value of type T into the shadow of a page,
+     * without writing it to the EEPROM yet.
+     *
+     * @tparam Policy Instance of policy for sending/receiving over I2C
+     * @tparam T The type to write. Must be serializable to an 8 byte
+     * or less value.
+     * @param page The page number to write to.
+     * @param value The value to write to \c page
+     * @param policy Instance of \c T, used to load the shadow if needed
+     * @return true on success, false if the page is out of range or the
+     * shadow could not be loaded
+     */
+    template <typename T, AT24C0xC_Policy Policy>
+    requires std::is_trivially_copyable_v<T>
+    auto stage_value(uint8_t page, T value, Policy &policy) -> bool {
         // The type to be written must be serializable to a single page
         static_assert(sizeof(T) <= PAGE_LENGTH,
                       "Type T must be 8 bytes max to serialize");
-        using BufferT = std::array<uint8_t, PAGE_LENGTH + 1>;
         // Check memory bounds
-        if (page > PAGES) {
+        if (page >= PAGES || !load(policy)) {
             return false;
         }
-        // Actual address is based on the byte.
-        BufferT buffer;
-        buffer.at(0) = page * PAGE_LENGTH;
+        auto *start = &_shadow.at(page * PAGE_LENGTH);
         // Because T must be trivially copyable, this is not a dangerous copy
-        std::memcpy(&(buffer[1]), &value, sizeof(value));
-
-        policy.set_write_protect(false);
-        auto ret = policy.i2c_write(_address, buffer.begin(), buffer.size());
-        policy.set_write_protect(true);
+        if (std::memcmp(start, &value, sizeof(value)) != 0) {
+            std::memcpy(start, &value, sizeof(value));
+            _dirty.at(page) = true;
+        }
+        return true;
+    }
 
+    /**
+     * @brief Write every page with staged changes to the EEPROM.
+     *
+     * @tparam Policy Instance of policy for sending/receiving over I2C
+     * @param policy Instance of \c T
+     * @return true on success, false if any page could not be written.
+     * On failure the shadow is reloaded from the EEPROM on the next access.
+     */
+    template <AT24C0xC_Policy Policy>
+    auto flush(Policy &policy) -> bool {
+        bool protect_off = false;
+        bool ret = true;
+        for (size_t page = 0; ret && page < PAGES; ++page) {
+            if (!_dirty.at(page)) {
+                continue;
+            }
+            if (!protect_off) {
+                policy.set_write_protect(false);
+                protect_off = true;
+            }
+            ret = write_page(page, policy);
+            _dirty.at(page) = false;
+        }
+        if (protect_off) {
+            policy.set_write_protect(true);
+        }
+        if (!ret) {
+            invalidate();
+        }
         return ret;
     }
 
@@ -114,33 +174,79 @@ class AT24C0xC {
     [[nodiscard]] auto read_value(uint8_t page, Policy &policy)
         -> std::optional<T> {
         using RT = std::optional<T>;
-        using BufferT = std::array<uint8_t, PAGE_LENGTH>;
         // Check memory bounds
-        if (page >= PAGES) {
+        if (page >= PAGES || !load(policy)) {
             return std::nullopt;
         }
+        T value;
+        memcpy(&value, &_shadow.at(page * PAGE_LENGTH), sizeof(value));
+        return RT(value);
+    }
+
+    /**
+     * @brief Fill the shadow from the EEPROM with one sequential read, if
+     * it isn't already loaded.
+     *
+     * @return true if the shadow is loaded
+     */
+    template <AT24C0xC_Policy Policy>
+    auto load(Policy &policy) -> bool {
+        if (_loaded) {
+            return true;
+        }
         // Must write the address before reading everything else
-        if (!policy.i2c_write(_address, page * PAGE_LENGTH)) {
-            return std::nullopt;
+        if (!policy.i2c_write(_address, static_cast<uint8_t>(0))) {
+            return false;
         }
-
-        BufferT buffer = {0};
-        if (!policy.i2c_read(_address, buffer.begin(), buffer.size())) {
-            return std::nullopt;
+        if (!policy.i2c_read(_address, _shadow.begin(), _shadow.size())) {
+            return false;
         }
-        T value;
-        memcpy(&value, &buffer[0], sizeof(value));
-        return RT(value);
+        _dirty.fill(false);
+        _loaded = true;
+        return true;
+    }
+
+    /** Forget the shadow, so that it is read again on the next access.*/
+    auto invalidate() -> void {
+        _loaded = false;
+        _dirty.fill(false);
     }
 
+    [[nodiscard]] auto loaded() const -> bool { return _loaded; }
+
     [[nodiscard]] auto size() const -> size_t { return _size; }
 
   private:
+    template <AT24C0xC_Policy Policy>
+    auto write_page(size_t page, Policy &policy) -> bool {
+        using BufferT = std::array<uint8_t, PAGE_LENGTH + 1>;
+        // Actual address is based on the byte.
+        BufferT buffer;
+        buffer.at(0) = static_cast<uint8_t>(page * PAGE_LENGTH);
+        std::memcpy(&buffer.at(1), &_shadow.at(page * PAGE_LENGTH),
+                    PAGE_LENGTH);
+        if (!policy.i2c_write(_address, buffer.begin(), buffer.size())) {
+            return false;
+        }
+        // The device doesn't ACK its address until the write is done
+        for (size_t i = 0; i < WRITE_POLL_ATTEMPTS; ++i) {
+            if (policy.i2c_write(_address, buffer.at(0))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     // Total size of the EEPROM
     static constexpr const size_t _size = PAGES * PAGE_LENGTH;
     // I2C address of the EEPROM, shifted 1 bit left from the
     // datasheet.
     static constexpr const uint8_t _address = ADDRESS << 1;
+
+    std::array<uint8_t, _size> _shadow{};
+    // Pages whose shadow has changes that aren't written yet
+    std::array<bool, PAGES> _dirty{};
+    bool _loaded = false;
 };
 
 }  // namespace at24c0xc
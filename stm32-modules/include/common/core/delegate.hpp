@@ -0,0 +1,85 @@
+/**
+ * @file delegate.hpp
+ * @brief A callback that binds a function or member function at compile
+ * time, for calling from interrupts.
+ *
+ * @details A std::function type-erases whatever it is given. Binding a
+ * lambda may allocate, and every call goes through the type-erasure
+ * machinery before it reaches the actual function. A Delegate instead takes
+ * the function to call as a template argument, so the binding is fixed at
+ * compile time. It stores nothing but an object pointer and a pointer to a
+ * stub function that is instantiated for the bound function, which the
+ * compiler inlines into the stub. Calling a Delegate is therefore a single
+ * call through a function pointer, and it never allocates.
+ *
+ * Delegates are trivially copyable, so they can be copied into a structure
+ * that is read from an interrupt without any locking beyond what a pair of
+ * pointers needs.
+ */
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+namespace delegate {
+
+template <typename Signature>
+class Delegate;
+
+template <typename R, typename... Args>
+class Delegate<R(Args...)> {
+  public:
+    /** An empty delegate, which must not be called.*/
+    Delegate() = default;
+
+    /**
+     * @brief Bind a member function of an object.
+     * @tparam Method The member function, such as \c &Class::function
+     * @param object The object to call \c Method on. It must outlive the
+     * delegate.
+     */
+    template <auto Method, typename T>
+    [[nodiscard]] static auto bind(T& object) -> Delegate {
+        // The stub casts back to T, so a const object stays const
+        return Delegate(const_cast<void*>(static_cast<const void*>(&object)),
+                        &call_member<T, Method>);
+    }
+
+    /**
+     * @brief Bind a free or static member function.
+     * @tparam Function The function to call
+     */
+    template <auto Function>
+    [[nodiscard]] static auto bind() -> Delegate {
+        return Delegate(nullptr, &call_function<Function>);
+    }
+
+    /** Call the bound function. The delegate must not be empty.*/
+    auto operator()(Args... args) const -> R {
+        return _stub(_object, std::forward<Args>(args)...);
+    }
+
+    /** Whether a function is bound.*/
+    explicit operator bool() const { return _stub != nullptr; }
+
+  private:
+    using Stub = R (*)(void*, Args...);
+
+    Delegate(void* object, Stub stub) : _object(object), _stub(stub) {}
+
+    template <typename T, auto Method>
+    static auto call_member(void* object, Args... args) -> R {
+        return (static_cast<T*>(object)->*Method)(std::forward<Args>(args)...);
+    }
+
+    template <auto Function>
+    static auto call_function(void* object, Args... args) -> R {
+        static_cast<void>(object);
+        return Function(std::forward<Args>(args)...);
+    }
+
+    void* _object = nullptr;
+    Stub _stub = nullptr;
+};
+
+}  // namespace delegate
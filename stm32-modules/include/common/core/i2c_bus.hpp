@@ -0,0 +1,246 @@
+/**
+ * @file i2c_bus.hpp
+ * @brief A shared, asynchronous manager for a single I2C bus.
+ *
+ * @details Device drivers that share a bus used to each block on their own
+ * transfers, so a slow LED or EEPROM write could hold off a thermistor read
+ * for as long as it took. The BusManager instead queues transactions from
+ * any number of tasks and runs them one after another:
+ * - every transaction is submitted with a priority, and the next
+ *   transaction to run is always the oldest one of the highest priority
+ *   that is waiting. Sensor reads therefore only ever wait for the single
+ *   transfer already on the wire.
+ * - when a transfer completes, the completion handler (normally called
+ *   from the transfer-complete interrupt) starts the next transaction
+ *   straight away, before running the callback of the one that finished,
+ *   so the bus stays busy back to back.
+ * - each transaction carries a plain function pointer and context as its
+ *   completion callback, which is safe to call from interrupt context.
+ *
+ * Data buffers are owned by the submitter, which lets the hardware move
+ * the data with DMA without any copies. A buffer must stay valid until the
+ * callback of its transaction has run.
+ *
+ * The hardware is abstracted behind a policy, which starts transfers and
+ * provides a short critical section that excludes the completion handler.
+ * Background transactions can be starved by a constant stream of higher
+ * priority ones; in practice sensor reads leave plenty of idle time.
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+
+namespace i2c_bus {
+
+/** Transaction priorities, from the most to the least urgent.*/
+enum class Priority : uint8_t {
+    SENSOR = 0, /**< Sensor reads that feed a control loop.*/
+    NORMAL,     /**< Anything else that a task is waiting on.*/
+    BACKGROUND, /**< LED and EEPROM updates that can wait.*/
+};
+
+static constexpr size_t PRIORITY_LEVELS = 3;
+
+enum class Type : uint8_t {
+    WRITE,     /**< Write the data to the device.*/
+    READ,      /**< Read the data from the device.*/
+    MEM_WRITE, /**< Write a register address, then the data.*/
+    MEM_READ,  /**< Write a register address, then read the data.*/
+};
+
+struct Transaction;
+
+/**
+ * @brief Called once a transaction has finished, whether or not it
+ * succeeded. May be called from interrupt context.
+ */
+using Callback = void (*)(const Transaction& transaction, bool success,
+                          void* context);
+
+struct Transaction {
+    Type type = Type::WRITE;
+    Priority priority = Priority::NORMAL;
+    /** The device address, already shifted for the hardware.*/
+    uint16_t address = 0;
+    /** The register address for MEM_WRITE and MEM_READ transactions.*/
+    uint8_t mem_address = 0;
+    /** The data to write, or the buffer to read into.*/
+    uint8_t* data = nullptr;
+    uint16_t length = 0;
+    Callback callback = nullptr;
+    void* context = nullptr;
+};
+
+template <typename Policy>
+concept BusPolicy = requires(Policy& p, const Transaction& t) {
+    // Start a transfer, which must finish by calling the manager's
+    // complete(). Returns false if the transfer could not be started.
+    { p.i2c_bus_start(t) } -> std::same_as<bool>;
+    // Enter and leave a critical section that excludes the completion
+    // handler and any other task using the bus
+    { p.i2c_bus_lock() } -> std::same_as<void>;
+    { p.i2c_bus_unlock() } -> std::same_as<void>;
+};
+
+/**
+ * @brief Queues and runs the transactions of one I2C bus.
+ * @tparam Policy The hardware policy for the bus
+ * @tparam Depth The number of transactions that can wait at each priority
+ */
+template <BusPolicy Policy, size_t Depth = 8>
+requires(Depth > 0) class BusManager {
+  public:
+    explicit BusManager(Policy& policy) : _policy(policy) {}
+    BusManager(const BusManager&) = delete;
+    auto operator=(const BusManager&) -> BusManager& = delete;
+    BusManager(BusManager&&) = delete;
+    auto operator=(BusManager&&) -> BusManager& = delete;
+    ~BusManager() = default;
+
+    /**
+     * @brief Queue a transaction, and start it if the bus is idle.
+     * @return True if the transaction was accepted, in which case its
+     * callback will always be called. False if its priority level is full.
+     */
+    auto submit(const Transaction& transaction) -> bool {
+        _policy.i2c_bus_lock();
+        auto& queue = _queues.at(static_cast<size_t>(transaction.priority));
+        bool accepted = queue.push(transaction);
+        if (accepted) {
+            _high_water = std::max(_high_water, pending_locked());
+        }
+        _policy.i2c_bus_unlock();
+        if (!accepted) {
+            return false;
+        }
+        dispatch();
+        return true;
+    }
+
+    /**
+     * @brief Finish the transfer that is on the bus and start the next
+     * one. Called by the hardware when a transfer completes or fails.
+     * @param success Whether the transfer succeeded
+     */
+    auto complete(bool success) -> void {
+        _policy.i2c_bus_lock();
+        if (!_busy) {
+            _policy.i2c_bus_unlock();
+            return;
+        }
+        auto finished = _active;
+        _busy = false;
+        if (success) {
+            ++_completed;
+        } else {
+            ++_failed;
+        }
+        _policy.i2c_bus_unlock();
+        dispatch();
+        notify(finished, success);
+    }
+
+    /** Whether a transfer is on the bus.*/
+    [[nodiscard]] auto busy() const -> bool { return _busy; }
+    /** The number of transactions waiting to start.*/
+    [[nodiscard]] auto pending() -> size_t {
+        _policy.i2c_bus_lock();
+        auto ret = pending_locked();
+        _policy.i2c_bus_unlock();
+        return ret;
+    }
+    /** The most transactions that have been waiting at once.*/
+    [[nodiscard]] auto high_water() const -> size_t { return _high_water; }
+    [[nodiscard]] auto completed() const -> uint32_t { return _completed; }
+    [[nodiscard]] auto failed() const -> uint32_t { return _failed; }
+
+  private:
+    class Queue {
+      public:
+        auto push(const Transaction& transaction) -> bool {
+            if (_size == Depth) {
+                return false;
+            }
+            _slots.at((_head + _size) % Depth) = transaction;
+            ++_size;
+            return true;
+        }
+        auto pop(Transaction& transaction) -> bool {
+            if (_size == 0) {
+                return false;
+            }
+            transaction = _slots.at(_head);
+            _head = (_head + 1) % Depth;
+            --_size;
+            return true;
+        }
+        [[nodiscard]] auto size() const -> size_t { return _size; }
+
+      private:
+        std::array<Transaction, Depth> _slots{};
+        size_t _head = 0;
+        size_t _size = 0;
+    };
+
+    // Start the next waiting transaction if the bus is idle. Transactions
+    // that fail to start are finished here, and the next one is tried.
+    auto dispatch() -> void {
+        while (true) {
+            _policy.i2c_bus_lock();
+            if (_busy || !pop_next()) {
+                _policy.i2c_bus_unlock();
+                return;
+            }
+            _busy = true;
+            _policy.i2c_bus_unlock();
+            if (_policy.i2c_bus_start(_active)) {
+                return;
+            }
+            _policy.i2c_bus_lock();
+            auto failed = _active;
+            _busy = false;
+            ++_failed;
+            _policy.i2c_bus_unlock();
+            notify(failed, false);
+        }
+    }
+
+    auto pop_next() -> bool {
+        for (auto& queue : _queues) {
+            if (queue.pop(_active)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    [[nodiscard]] auto pending_locked() const -> size_t {
+        size_t ret = 0;
+        for (const auto& queue : _queues) {
+            ret += queue.size();
+        }
+        return ret;
+    }
+
+    static auto notify(const Transaction& transaction, bool success)
+        -> void {
+        if (transaction.callback != nullptr) {
+            transaction.callback(transaction, success, transaction.context);
+        }
+    }
+
+    Policy& _policy;
+    std::array<Queue, PRIORITY_LEVELS> _queues{};
+    // The transaction on the bus, valid while _busy is set
+    Transaction _active{};
+    bool _busy = false;
+    size_t _high_water = 0;
+    uint32_t _completed = 0;
+    uint32_t _failed = 0;
+};
+
+}  // namespace i2c_bus
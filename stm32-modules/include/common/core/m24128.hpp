@@ -9,6 +9,7 @@
 #include <array>
 #include <concepts>
 #include <cstring>
+#include <optional>
 
 #include "core/bit_utils.hpp"
 
@@ -41,7 +42,22 @@ concept M24128_Serializable =
     // The type must be trivially serializable so memcpy is valid
     std::is_trivially_copyable_v<T>;
 
-template <uint8_t ADDRESS>
+/**
+ * @brief Driver for the M24128 EEPROM.
+ *
+ * The first SHADOW_PAGES pages, which hold everything the firmware
+ * stores, are shadowed in RAM. They are read in one sequential read on
+ * first access and served from the shadow after that. Writes to them are
+ * staged into the shadow and flushed as whole pages, only when their
+ * contents changed, with one write-protect toggle per flush. After each
+ * page write the device is polled for an ACK, which is how it signals the
+ * end of its internal write cycle. Pages past the shadow are accessed
+ * directly.
+ *
+ * @tparam ADDRESS The 7-bit I2C address of the device
+ * @tparam SHADOW_PAGES How many pages to shadow in RAM
+ */
+template <uint8_t ADDRESS, size_t SHADOW_PAGES = 1>
 class M24128 {
   private:
     static constexpr size_t ADDRESS_BYTES = 2;
@@ -51,21 +67,71 @@ class M24128 {
 
   public:
     static const constexpr uint16_t PAGES = 128;
+    /** How many times to poll for the end of a write cycle. Each poll
+     * takes a few tens of microseconds, and a write cycle takes at most
+     * 5 milliseconds.*/
+    static constexpr size_t WRITE_POLL_ATTEMPTS = 250;
+
+    static_assert(SHADOW_PAGES > 0 && SHADOW_PAGES <= PAGES,
+                  "Shadow must cover between one page and the whole device");
 
     template <M24128_Serializable T, M24128_Policy Policy>
     auto write_value(uint8_t page, T value, Policy &policy) -> bool {
-        constexpr size_t Length = sizeof(T) + ADDRESS_BYTES;
+        if (page >= SHADOW_PAGES) {
+            return write_direct(page, value, policy);
+        }
+        return stage_value(page, value, policy) && flush(policy);
+    }
 
-        if (!populate_address(page)) {
+    /**
+     * @brief Serialize a value into the shadow of a page, without writing
+     * it to the EEPROM yet.
+     * @return true on success, false if the page isn't shadowed or the
+     * shadow could not be loaded
+     */
+    template <M24128_Serializable T, M24128_Policy Policy>
+    auto stage_value(uint8_t page, T value, Policy &policy) -> bool {
+        if (page >= SHADOW_PAGES || !load(policy)) {
             return false;
         }
+        auto *start = &_shadow.at(page * PAGE_LENGTH);
         // Because T must be trivially copyable, this is not a dangerous copy
-        std::memcpy(&(_buffer[ADDRESS_BYTES]), &value, sizeof(value));
-
-        policy.set_write_protect(false);
-        auto ret = policy.i2c_write(_address, _buffer.begin(), Length);
-        policy.set_write_protect(true);
+        if (std::memcmp(start, &value, sizeof(value)) != 0) {
+            std::memcpy(start, &value, sizeof(value));
+            _dirty.at(page) = true;
+        }
+        return true;
+    }
 
+    /**
+     * @brief Write every shadowed page with staged changes to the EEPROM.
+     * @return true on success, false if any page could not be written.
+     * On failure the shadow is reloaded from the EEPROM on the next access.
+     */
+    template <M24128_Policy Policy>
+    auto flush(Policy &policy) -> bool {
+        bool protect_off = false;
+        bool ret = true;
+        for (size_t page = 0; ret && page < SHADOW_PAGES; ++page) {
+            if (!_dirty.at(page)) {
+                continue;
+            }
+            if (!protect_off) {
+                policy.set_write_protect(false);
+                protect_off = true;
+            }
+            populate_address(page);
+            std::memcpy(&_buffer.at(ADDRESS_BYTES),
+                        &_shadow.at(page * PAGE_LENGTH), PAGE_LENGTH);
+            ret = write_buffer(_buffer.size(), policy);
+            _dirty.at(page) = false;
+        }
+        if (protect_off) {
+            policy.set_write_protect(true);
+        }
+        if (!ret) {
+            invalidate();
+        }
         return ret;
     }
 
@@ -74,10 +140,19 @@ class M24128 {
         -> std::optional<T> {
         using RT = std::optional<T>;
 
-        if (!populate_address(page)) {
+        if (page >= PAGES) {
             return std::nullopt;
         }
+        T value{};
+        if (page < SHADOW_PAGES) {
+            if (!load(policy)) {
+                return std::nullopt;
+            }
+            memcpy(&value, &_shadow.at(page * PAGE_LENGTH), sizeof(value));
+            return RT(value);
+        }
 
+        populate_address(page);
         // Must write the address before reading everything else
         if (!policy.i2c_write(_address, _buffer.begin(), ADDRESS_BYTES)) {
             return std::nullopt;
@@ -86,29 +161,90 @@ class M24128 {
         if (!policy.i2c_read(_address, _buffer.begin(), PAGE_LENGTH)) {
             return std::nullopt;
         }
-        T value{};
         memcpy(&value, &_buffer[0], sizeof(value));
         return RT(value);
     }
 
+    /**
+     * @brief Fill the shadow from the EEPROM with one sequential read, if
+     * it isn't already loaded.
+     * @return true if the shadow is loaded
+     */
+    template <M24128_Policy Policy>
+    auto load(Policy &policy) -> bool {
+        if (_loaded) {
+            return true;
+        }
+        populate_address(0);
+        if (!policy.i2c_write(_address, _buffer.begin(), ADDRESS_BYTES)) {
+            return false;
+        }
+        if (!policy.i2c_read(_address, _shadow.begin(), _shadow.size())) {
+            return false;
+        }
+        _dirty.fill(false);
+        _loaded = true;
+        return true;
+    }
+
+    /** Forget the shadow, so that it is read again on the next access.*/
+    auto invalidate() -> void {
+        _loaded = false;
+        _dirty.fill(false);
+    }
+
+    [[nodiscard]] auto loaded() const -> bool { return _loaded; }
+
   private:
-    auto populate_address(uint8_t page) -> bool {
-        if (page > PAGES) {
+    template <M24128_Serializable T, M24128_Policy Policy>
+    auto write_direct(uint8_t page, T value, Policy &policy) -> bool {
+        if (page >= PAGES) {
             return false;
         }
-        uint16_t start_addr = page * PAGE_LENGTH;
+        populate_address(page);
+        // Because T must be trivially copyable, this is not a dangerous copy
+        std::memcpy(&(_buffer[ADDRESS_BYTES]), &value, sizeof(value));
+
+        policy.set_write_protect(false);
+        auto ret = write_buffer(sizeof(T) + ADDRESS_BYTES, policy);
+        policy.set_write_protect(true);
+
+        return ret;
+    }
+
+    // Write the first \p length bytes of the buffer, which starts with
+    // the address, then wait for the write cycle to finish
+    template <M24128_Policy Policy>
+    auto write_buffer(size_t length, Policy &policy) -> bool {
+        if (!policy.i2c_write(_address, _buffer.begin(), length)) {
+            return false;
+        }
+        // The device doesn't ACK its address until the write is done
+        for (size_t i = 0; i < WRITE_POLL_ATTEMPTS; ++i) {
+            if (policy.i2c_write(_address, _buffer.begin(), ADDRESS_BYTES)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    auto populate_address(size_t page) -> void {
+        auto start_addr = static_cast<uint16_t>(page * PAGE_LENGTH);
         // MSB is first, followed by LSB
 
         // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
         _buffer.at(0) = static_cast<uint8_t>((start_addr & 0xFF00) >> 8);
         // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
         _buffer.at(1) = static_cast<uint8_t>((start_addr)&0xFF);
-
-        return true;
     }
 
     using Buffer = std::array<uint8_t, PAGE_LENGTH + 2>;
-    Buffer _buffer;  // Keep a static buffer to avoid reallocating on the stack
+    Buffer _buffer{};  // Keep a static buffer to avoid reallocating on the
+                       // stack
+    std::array<uint8_t, SHADOW_PAGES * PAGE_LENGTH> _shadow{};
+    // Pages whose shadow has changes that aren't written yet
+    std::array<bool, SHADOW_PAGES> _dirty{};
+    bool _loaded = false;
 };
 
 }  // namespace m24128
\ No newline at end of file
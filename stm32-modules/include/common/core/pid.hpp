@@ -48,6 +48,28 @@ class PID {
      */
     auto compute(double error, double sampletime) -> double;
     auto reset() -> void;
+    /**
+     * @brief Set the state of the controller directly, as if its last
+     * input had been \ref error and its integral term \ref iterm. This
+     * hands control over from another source (e.g. a feed-forward) without
+     * a bump in the output and without running an extra integration step.
+     *
+     * @param[in] error The error to use as the previous input
+     * @param[in] iterm The integral term to start from. Clamped to the
+     * windup limits.
+     */
+    auto seed(double error, double iterm) -> void;
+    /**
+     * @brief Change the gains of a running controller without a bump in
+     * its output. The integral term absorbs the change in the proportional
+     * term for the last error, so the next output picks up where the old
+     * gains left off.
+     *
+     * @param[in] kp New proportional constant
+     * @param[in] ki New integral constant
+     * @param[in] kd New derivative constant
+     */
+    auto set_gains(double kp, double ki, double kd) -> void;
     [[nodiscard]] auto kp() const -> double;
     [[nodiscard]] auto ki() const -> double;
     [[nodiscard]] auto kd() const -> double;
@@ -6,12 +6,15 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <memory>
 #include <optional>
 #include <tuple>
+#include <utility>
 #include <variant>
 
+#include "core/queue_stats.hpp"
 #include "hal/message_queue.hpp"
 
 namespace queue_aggregator {
@@ -226,6 +229,17 @@ class QueueAggregator {
         return send_from_isr_to<idx>(msg);
     }
 
+    /**
+     * @brief Get the instrumentation statistics for every registered queue
+     *
+     * @return An array of statistics, indexed by queue address. Queues
+     * that have not been registered report a capacity of 0.
+     */
+    [[nodiscard]] auto get_all_stats() const
+        -> std::array<queue_stats::Snapshot, TaskCount> {
+        return get_all_stats_impl(std::make_index_sequence<TaskCount>());
+    }
+
   private:
     /**
      * @brief Wrapper class for holding a pointer to a queue with
@@ -315,6 +329,15 @@ class QueueAggregator {
         return std::get<get_queue_idx<Queue>()>(_handles)._handle != nullptr;
     }
 
+    template <size_t... Idx>
+    [[nodiscard]] auto get_all_stats_impl(
+        std::index_sequence<Idx...> /*unused*/) const
+        -> std::array<queue_stats::Snapshot, TaskCount> {
+        return {(std::get<Idx>(_handles)._handle == nullptr
+                     ? queue_stats::Snapshot{}
+                     : std::get<Idx>(_handles)._handle->get_stats())...};
+    }
+
     // SendHelper uses the internal send_to function...
     template <size_t N>
     friend struct SendHelper;
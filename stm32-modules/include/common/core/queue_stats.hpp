@@ -0,0 +1,289 @@
+/**
+ * @file queue_stats.hpp
+ * @brief Opt-in instrumentation for task message queues.
+ *
+ * @details The statistics are only compiled in when QUEUE_STATS_ENABLED is
+ * defined (the ENABLE_QUEUE_STATS cmake option for firmware; host builds
+ * always define it). Without it, QueueStats is empty and every recording
+ * call is a no-op, and queues carry their messages without timestamps.
+ *
+ * When enabled, each MessageQueue implementation owns a QueueStats
+ * instance and feeds it from its send and receive paths:
+ * - every send attempt records whether it succeeded and the resulting queue
+ *   depth, which gives a high-water mark and a count of dropped messages
+ * - every message is stamped when it is enqueued, and the time it waited
+ *   in the queue is recorded when it is received
+ * - every receive opens a "handling window" tagged with the variant index
+ *   of the message that was received; the window is closed the next time
+ *   the owning task comes back to the queue. The longest window for each
+ *   message type is kept, which is the time the task spent handling it.
+ *
+ * All counters are relaxed atomics so they may be updated from interrupt
+ * context (or other threads in the simulator) and read from the host
+ * comms task without locking. Times are recorded in whatever tick unit the
+ * owning queue uses - DWT cycles in firmware, microseconds in the
+ * simulator - and converted to microseconds in the snapshot. A 32 bit
+ * cycle count wraps after about 25 seconds at 170MHz, so longer intervals
+ * are not reported correctly.
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <variant>
+
+namespace queue_stats {
+
+#if defined(QUEUE_STATS_ENABLED)
+static constexpr bool ENABLED = true;
+#else
+static constexpr bool ENABLED = false;
+#endif
+
+/** Number of distinct message types that may be sent through a queue.*/
+template <typename M>
+struct message_type_count : std::integral_constant<size_t, 1> {};
+
+template <typename... Ts>
+struct message_type_count<std::variant<Ts...>>
+    : std::integral_constant<size_t, sizeof...(Ts)> {};
+
+/** Value returned for a stack high water mark that is not available.*/
+static constexpr uint32_t STACK_UNKNOWN = 0xFFFFFFFF;
+
+/** A point-in-time copy of the statistics for a single queue.*/
+struct Snapshot {
+    // Number of messages the queue can hold
+    uint32_t capacity = 0;
+    // Largest number of messages that have been waiting at once
+    uint32_t high_water = 0;
+    // Number of messages successfully sent
+    uint32_t sent = 0;
+    // Number of send attempts that failed because the queue was full
+    uint32_t send_failures = 0;
+    // Longest time spent handling a single message, in microseconds
+    uint32_t max_handling_us = 0;
+    // Variant index of the message that took max_handling_us
+    uint32_t slowest_message = 0;
+    // Longest time a message waited in the queue, in microseconds
+    uint32_t max_wait_us = 0;
+    // Minimum free stack of the receiving task, in words
+    uint32_t stack_high_water = STACK_UNKNOWN;
+};
+
+/**
+ * A message as it is stored in an instrumented queue, with the time it
+ * was enqueued.
+ */
+template <typename Message>
+struct Stamped {
+    Message message;
+    uint32_t enqueued;
+};
+
+/** The type a queue should store for a message: stamped only if enabled.*/
+template <typename Message>
+using Entry = std::conditional_t<ENABLED, Stamped<Message>, Message>;
+
+template <typename Message, size_t Capacity, bool Enabled = ENABLED>
+class QueueStats {
+  public:
+    static constexpr size_t MESSAGE_TYPES =
+        message_type_count<Message>::value;
+    static constexpr uint32_t NO_MESSAGE = 0xFFFFFFFF;
+
+    QueueStats() = default;
+    QueueStats(const QueueStats&) = delete;
+    auto operator=(const QueueStats&) -> QueueStats& = delete;
+    QueueStats(QueueStats&&) = delete;
+    auto operator=(QueueStats&&) -> QueueStats& = delete;
+    ~QueueStats() = default;
+
+    /**
+     * @brief Record the result of a send attempt.
+     * @param sent True if the message was enqueued
+     * @param depth Number of messages in the queue after the attempt
+     */
+    auto record_send(bool sent, size_t depth) -> void {
+        if (!sent) {
+            _send_failures.fetch_add(1, std::memory_order_relaxed);
+            depth = Capacity;
+        } else {
+            _sent.fetch_add(1, std::memory_order_relaxed);
+        }
+        raise(_high_water, static_cast<uint32_t>(std::min(depth, Capacity)));
+    }
+
+    /**
+     * @brief Record that the owning task has come back to its queue. This
+     * closes the handling window of the previously received message, if
+     * there was one.
+     * @param now The current tick count
+     */
+    auto record_idle(uint32_t now) -> void {
+        auto index = _current.exchange(NO_MESSAGE, std::memory_order_relaxed);
+        if (index >= MESSAGE_TYPES) {
+            return;
+        }
+        auto elapsed = now - _window_start.load(std::memory_order_relaxed);
+        raise(_handling_ticks.at(index), elapsed);
+    }
+
+    /**
+     * @brief Record that a message was received, opening its handling
+     * window and recording how long it waited in the queue.
+     * @param index The variant index of the received message
+     * @param enqueued The tick count when the message was sent
+     * @param now The current tick count
+     */
+    auto record_receive(size_t index, uint32_t enqueued, uint32_t now)
+        -> void {
+        raise(_wait_ticks, now - enqueued);
+        _window_start.store(now, std::memory_order_relaxed);
+        _current.store(static_cast<uint32_t>(index),
+                       std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the longest handling time seen for one message type
+     * @param index The variant index of the message type
+     */
+    [[nodiscard]] auto handling_ticks(size_t index) const -> uint32_t {
+        if (index >= MESSAGE_TYPES) {
+            return 0;
+        }
+        return _handling_ticks.at(index).load(std::memory_order_relaxed);
+    }
+
+    /** Get the longest time a message has waited in the queue, in ticks.*/
+    [[nodiscard]] auto wait_ticks() const -> uint32_t {
+        return _wait_ticks.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Copy out the statistics.
+     * @param ticks_per_us The tick rate of the owning queue's clock
+     */
+    [[nodiscard]] auto snapshot(uint32_t ticks_per_us) const -> Snapshot {
+        ticks_per_us = std::max(ticks_per_us, static_cast<uint32_t>(1));
+        Snapshot ret{
+            .capacity = static_cast<uint32_t>(Capacity),
+            .high_water = _high_water.load(std::memory_order_relaxed),
+            .sent = _sent.load(std::memory_order_relaxed),
+            .send_failures = _send_failures.load(std::memory_order_relaxed),
+            .max_wait_us = wait_ticks() / ticks_per_us};
+        uint32_t slowest_ticks = 0;
+        for (size_t i = 0; i < MESSAGE_TYPES; ++i) {
+            auto ticks = handling_ticks(i);
+            if (ticks > slowest_ticks) {
+                slowest_ticks = ticks;
+                ret.slowest_message = static_cast<uint32_t>(i);
+            }
+        }
+        ret.max_handling_us = slowest_ticks / ticks_per_us;
+        return ret;
+    }
+
+    /** Clear all of the accumulated statistics.*/
+    auto reset() -> void {
+        _high_water.store(0, std::memory_order_relaxed);
+        _sent.store(0, std::memory_order_relaxed);
+        _send_failures.store(0, std::memory_order_relaxed);
+        _wait_ticks.store(0, std::memory_order_relaxed);
+        for (auto& slot : _handling_ticks) {
+            slot.store(0, std::memory_order_relaxed);
+        }
+    }
+
+  private:
+    static auto raise(std::atomic<uint32_t>& slot, uint32_t value) -> void {
+        auto prev = slot.load(std::memory_order_relaxed);
+        while (prev < value && !slot.compare_exchange_weak(
+                                   prev, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    std::atomic<uint32_t> _high_water{0};
+    std::atomic<uint32_t> _sent{0};
+    std::atomic<uint32_t> _send_failures{0};
+    std::atomic<uint32_t> _wait_ticks{0};
+    std::atomic<uint32_t> _current{NO_MESSAGE};
+    std::atomic<uint32_t> _window_start{0};
+    std::array<std::atomic<uint32_t>, MESSAGE_TYPES> _handling_ticks{};
+};
+
+/**
+ * Statistics compiled out: nothing is stored and nothing is recorded, and
+ * the snapshot only reports the queue capacity.
+ */
+template <typename Message, size_t Capacity>
+class QueueStats<Message, Capacity, false> {
+  public:
+    auto record_send(bool /*sent*/, size_t /*depth*/) -> void {}
+    auto record_idle(uint32_t /*now*/) -> void {}
+    auto record_receive(size_t /*index*/, uint32_t /*enqueued*/,
+                        uint32_t /*now*/) -> void {}
+    [[nodiscard]] auto handling_ticks(size_t /*index*/) const -> uint32_t {
+        return 0;
+    }
+    [[nodiscard]] auto wait_ticks() const -> uint32_t { return 0; }
+    [[nodiscard]] auto snapshot(uint32_t /*ticks_per_us*/) const
+        -> Snapshot {
+        return Snapshot{.capacity = static_cast<uint32_t>(Capacity)};
+    }
+    auto reset() -> void {}
+};
+
+/**
+ * @brief Get the variant index of a message, for use with QueueStats.
+ */
+template <typename Message>
+[[nodiscard]] auto message_index(const Message& message) -> size_t {
+    if constexpr (requires { message.index(); }) {
+        return message.index();
+    } else {
+        static_cast<void>(message);
+        return 0;
+    }
+}
+
+/** Wrap a message for storage in a queue, stamping it if enabled.*/
+template <typename Message>
+[[nodiscard]] auto to_entry(const Message& message, uint32_t now)
+    -> Entry<Message> {
+    if constexpr (ENABLED) {
+        return Stamped<Message>{.message = message, .enqueued = now};
+    } else {
+        static_cast<void>(now);
+        return message;
+    }
+}
+
+/** Get the message back out of a queue entry.*/
+template <typename Message>
+[[nodiscard]] auto from_entry(const Entry<Message>& entry) -> const Message& {
+    if constexpr (ENABLED) {
+        return entry.message;
+    } else {
+        return entry;
+    }
+}
+
+/** Get the enqueue time of a queue entry, or now if it is not stamped.*/
+template <typename Message>
+[[nodiscard]] auto enqueued_at(const Entry<Message>& entry, uint32_t now)
+    -> uint32_t {
+    if constexpr (ENABLED) {
+        static_cast<void>(now);
+        return entry.enqueued;
+    } else {
+        static_cast<void>(entry);
+        return now;
+    }
+}
+
+}  // namespace queue_stats
@@ -0,0 +1,96 @@
+/**
+ * @file ramped_setpoint.hpp
+ * @brief A setpoint generator that moves a controller's setpoint towards
+ * its target at a fixed rate.
+ *
+ * @details Jumping a PID setpoint straight to a distant target saturates
+ * the output and winds up the integral term, which then has to unwind as
+ * the temperature overshoots. Ramping the setpoint instead keeps the error
+ * small for the whole move, so the controller tracks the ramp and settles
+ * at the target with little overshoot.
+ *
+ * The setpoint is advanced by the caller once per control tick. While a
+ * ramp is in progress the integral term slowly builds up to hold the
+ * temperature on the ramp, so when the ramp reaches its target the
+ * controller's integrator reset is armed. The integral is then dropped as
+ * soon as the temperature catches up with the target.
+ */
+#pragma once
+
+#include <concepts>
+
+namespace ramped_setpoint {
+
+/**
+ * A PID controller that a ramped setpoint can drive. Both the common PID
+ * and the ot_utils PID satisfy this.
+ */
+template <typename Controller>
+concept RampController = requires(Controller& pid, double value) {
+    pid.arm_integrator_reset(value);
+    { pid.compute(value, value) } -> std::same_as<double>;
+};
+
+class RampedSetpoint {
+  public:
+    /** This ramp rate moves the setpoint straight to the target.*/
+    static constexpr double RAMP_INFINITE = 0.0F;
+
+    /**
+     * @brief Start moving towards a new target.
+     * @param current The temperature to start the ramp from, in ºC
+     * @param target The final setpoint, in ºC
+     * @param rate The ramp rate in ºC/s, or RAMP_INFINITE to jump straight
+     * to the target
+     */
+    auto start(double current, double target, double rate = RAMP_INFINITE)
+        -> void;
+
+    /**
+     * @brief Advance the setpoint by one control tick.
+     * @param time The time since the last tick, in seconds
+     * @return The new setpoint, in ºC
+     */
+    auto update(double time) -> double;
+
+    /**
+     * @brief Advance the setpoint and run a PID controller against it.
+     * When a ramp reaches its target, the integrator reset of the
+     * controller is armed before it runs.
+     * @param pid The controller to run
+     * @param temperature The measured temperature, in ºC
+     * @param time The time since the last tick, in seconds
+     * @return The controller output
+     */
+    template <RampController Controller>
+    auto compute(Controller& pid, double temperature, double time)
+        -> double {
+        update(time);
+        auto error = _setpoint - temperature;
+        if (_arrived) {
+            _arrived = false;
+            pid.arm_integrator_reset(error);
+        }
+        return pid.compute(error, time);
+    }
+
+    /** The setpoint the controller should currently hold, in ºC.*/
+    [[nodiscard]] auto setpoint() const -> double { return _setpoint; }
+    /** The final setpoint, in ºC.*/
+    [[nodiscard]] auto target() const -> double { return _target; }
+    /** The ramp rate, in ºC/s.*/
+    [[nodiscard]] auto rate() const -> double { return _rate; }
+    [[nodiscard]] auto ramping() const -> bool {
+        return _setpoint != _target;
+    }
+
+  private:
+    double _setpoint = 0.0F;
+    double _target = 0.0F;
+    double _rate = RAMP_INFINITE;
+    // Set on the tick that a ramp reaches its target, until the
+    // controller has been told about it
+    bool _arrived = false;
+};
+
+}  // namespace ramped_setpoint
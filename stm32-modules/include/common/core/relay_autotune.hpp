@@ -0,0 +1,154 @@
+/**
+ * @file relay_autotune.hpp
+ * @brief Relay feedback (Åström-Hägglund) autotuning for PID controllers.
+ *
+ * @details While autotuning, the controller output is replaced by a relay
+ * that switches between a high and a low output whenever the measured
+ * temperature crosses the target. This drives the system into a stable
+ * oscillation. The period of that oscillation is the ultimate period Tu,
+ * and its amplitude gives the ultimate gain Ku:
+ *
+ * > Ku = 4d / (pi * sqrt(a^2 - e^2))
+ *
+ * where d is half the difference between the relay outputs, a is half the
+ * peak-to-peak amplitude of the oscillation, and e is the relay hysteresis.
+ *
+ * The formula assumes a symmetric oscillation. A system far from ambient
+ * needs a steady output just to hold the setpoint, so a relay centered on
+ * zero would heat much faster than it cools (or the other way around). The
+ * relay is therefore biased: it switches between bias + d and bias - d, and
+ * after each oscillation the bias moves towards whichever output was held
+ * for longer, until the time spent high and low is equal. The relay may
+ * start from a known bias, such as a model of the holding power.
+ * PID gains are then calculated with the classic Ziegler-Nichols rules,
+ * in the form used by the PID class (the integral and derivative gains are
+ * scaled by time in seconds).
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace relay_autotune {
+
+enum class Status : uint8_t {
+    IDLE,    /**< No autotune has been run.*/
+    RUNNING, /**< The relay is driving the system.*/
+    DONE,    /**< Autotune completed and a result is available.*/
+    FAILED,  /**< Autotune timed out or did not oscillate.*/
+};
+
+/** Get a printable name for an autotune status.*/
+[[nodiscard]] constexpr auto status_name(Status status) -> const char* {
+    switch (status) {
+        case Status::IDLE:
+            return "IDLE";
+        case Status::RUNNING:
+            return "RUNNING";
+        case Status::DONE:
+            return "DONE";
+        case Status::FAILED:
+            return "FAILED";
+    }
+    return "UNKNOWN";
+}
+
+struct Result {
+    /** The ultimate gain, in output units per ºC.*/
+    double ultimate_gain = 0.0F;
+    /** The ultimate period, in seconds.*/
+    double ultimate_period = 0.0F;
+    double kp = 0.0F;
+    double ki = 0.0F;
+    double kd = 0.0F;
+};
+
+struct Settings {
+    /** The temperature to oscillate around, in ºC.*/
+    double setpoint;
+    /** Highest output the relay may drive.*/
+    double output_high;
+    /** Lowest output the relay may drive.*/
+    double output_low;
+    /** Distance past the setpoint required to switch the relay, in ºC.*/
+    double hysteresis;
+    /** Maximum time the autotune can take, in seconds.*/
+    double timeout;
+    /** Initial center of the relay. Defaults to the middle of the range.*/
+    std::optional<double> bias = std::nullopt;
+    /** Largest half-difference between the relay outputs. Defaults to as
+     * much as the range allows around the bias.*/
+    std::optional<double> amplitude = std::nullopt;
+};
+
+class RelayAutotune {
+  public:
+    /** Number of oscillations averaged into the result. The first
+     * oscillation is always discarded, since it starts from wherever the
+     * system happened to be.*/
+    static constexpr size_t MEASURED_CYCLES = 4;
+    /** An oscillation is only measured if the difference between the time
+     * spent high and low is less than this fraction of its period, i.e.
+     * once the bias has settled.*/
+    static constexpr double MAX_IMBALANCE = 0.05;
+    /** The bias is kept far enough from the output limits that the relay
+     * can still swing by this fraction of the output range each way.*/
+    static constexpr double MIN_RELAY_FRACTION = 0.1;
+
+    /**
+     * @brief Start a new autotune, discarding any previous result.
+     */
+    auto start(const Settings& settings) -> void;
+
+    /**
+     * @brief Stop a running autotune. The status becomes FAILED.
+     */
+    auto abort() -> void;
+
+    /**
+     * @brief Feed a new temperature reading into the autotune.
+     * @param temperature The measured temperature, in ºC
+     * @param sampletime The time since the last reading, in seconds
+     * @return The output to drive the system with. Once the autotune is
+     * no longer running, this is 0.
+     */
+    auto update(double temperature, double sampletime) -> double;
+
+    [[nodiscard]] auto status() const -> Status { return _status; }
+    [[nodiscard]] auto running() const -> bool {
+        return _status == Status::RUNNING;
+    }
+    [[nodiscard]] auto result() const -> const Result& { return _result; }
+    /** The number of oscillations measured so far.*/
+    [[nodiscard]] auto cycles() const -> size_t { return _cycles; }
+    /** The current center of the relay.*/
+    [[nodiscard]] auto bias() const -> double { return _bias; }
+
+  private:
+    auto finish() -> void;
+    auto set_bias(double bias) -> void;
+
+    Settings _settings{};
+    Status _status = Status::IDLE;
+    Result _result{};
+    bool _output_is_high = true;
+    // How many times the relay has switched from low to high. Each of
+    // these marks the start of an oscillation.
+    size_t _rising_switches = 0;
+    double _elapsed = 0.0F;
+    double _cycle_start = 0.0F;
+    double _cycle_max = 0.0F;
+    double _cycle_min = 0.0F;
+    size_t _cycles = 0;
+    double _period_sum = 0.0F;
+    double _amplitude_sum = 0.0F;
+    double _relay_sum = 0.0F;
+    double _bias = 0.0F;
+    double _relay = 0.0F;
+    // Time spent at each output during the current oscillation
+    double _time_high = 0.0F;
+    double _time_low = 0.0F;
+};
+
+}  // namespace relay_autotune
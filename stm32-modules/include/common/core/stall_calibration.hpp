@@ -0,0 +1,227 @@
+/**
+ * @file stall_calibration.hpp
+ * @brief Finds a StallGuard threshold and minimum velocity for a motor from
+ * its SG_RESULT readings while it runs freely at a range of velocities.
+ *
+ * @details StallGuard measures the load on a motor as SG_RESULT, which falls
+ * towards 0 as the load rises; the driver flags a stall when it reaches 0.
+ * The threshold (SGT) shifts the whole range of SG_RESULT, and the reading
+ * is only meaningful above a minimum velocity. Both depend on the motor, its
+ * mechanics and its current, so they differ from unit to unit.
+ *
+ * A calibration sweeps the motor through a list of velocities, slowest
+ * first, with stall detection disabled, and records statistics of the
+ * SG_RESULT readings taken while the motor is cruising at each of them. A
+ * velocity is usable if every reading there stayed above a floor and the
+ * readings were steady. The minimum velocity is the slowest velocity from
+ * which every faster velocity is usable too.
+ *
+ * The threshold is then nudged one step at a time, with a new sweep after
+ * each step, until the lowest mean reading in the usable range sits inside
+ * a target band: high enough above 0 that running freely never looks like
+ * a stall, and low enough that a stall pulls it down to 0. A threshold
+ * that would step back the way it came is kept as it is, so a calibration
+ * can't oscillate between two thresholds.
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace stall_calibration {
+
+/** Running statistics of SG_RESULT readings.*/
+struct Statistics {
+    uint32_t count = 0;
+    uint16_t min = std::numeric_limits<uint16_t>::max();
+    uint16_t max = 0;
+    double mean = 0.0F;
+    // Sum of squared differences from the mean (Welford's method)
+    double m2 = 0.0F;
+
+    auto add(uint16_t value) -> void {
+        ++count;
+        min = std::min(min, value);
+        max = std::max(max, value);
+        auto delta = static_cast<double>(value) - mean;
+        mean += delta / static_cast<double>(count);
+        m2 += delta * (static_cast<double>(value) - mean);
+    }
+
+    [[nodiscard]] auto stddev() const -> double {
+        if (count < 2) {
+            return 0.0F;
+        }
+        return std::sqrt(m2 / static_cast<double>(count - 1));
+    }
+};
+
+struct Settings {
+    /** The lowest reading allowed at a usable velocity.*/
+    uint16_t floor;
+    /** The band for the lowest mean reading in the usable range.*/
+    uint16_t target_low;
+    uint16_t target_high;
+    /** The largest standard deviation at a usable velocity, as a
+     * fraction of the mean.*/
+    double max_noise;
+    /** The fewest readings needed at a usable velocity.*/
+    uint32_t min_samples;
+    /** How far a measured velocity may be from the one being swept for a
+     * reading to count, as a fraction of the swept velocity.*/
+    double velocity_tolerance;
+    /** The range of the threshold register.*/
+    int sgt_min;
+    int sgt_max;
+    /** The most sweeps a calibration may take.*/
+    uint8_t max_sweeps;
+};
+
+struct Result {
+    /** The StallGuard threshold.*/
+    int sgt = 0;
+    /** The slowest velocity at which stall detection can be trusted.*/
+    double min_velocity = 0.0F;
+    /** The fastest calibrated velocity, for homing against a stall.*/
+    double home_velocity = 0.0F;
+};
+
+enum class Verdict : uint8_t {
+    SWEEP_AGAIN, /**< The threshold changed; run the sweep again.*/
+    DONE,        /**< A result is available.*/
+    FAILED,      /**< No threshold gives a usable range of velocities.*/
+};
+
+/**
+ * @brief Collects the readings of each sweep and works out the result.
+ * @tparam Points The number of velocities in a sweep
+ */
+template <size_t Points>
+requires(Points > 0) class Calibration {
+  public:
+    using Velocities = std::array<double, Points>;
+
+    /**
+     * @param velocities The velocities to sweep, slowest first
+     * @param settings The limits for judging the readings
+     */
+    Calibration(const Velocities& velocities, const Settings& settings)
+        : _velocities(velocities), _settings(settings) {}
+
+    /** Start a new calibration from a threshold.*/
+    auto start(int sgt) -> void {
+        _sgt = std::clamp(sgt, _settings.sgt_min, _settings.sgt_max);
+        _last_step = 0;
+        _sweeps = 0;
+        _result = Result{};
+        clear();
+    }
+
+    /**
+     * @brief Record a reading taken during a sweep.
+     * @param point The index of the velocity being swept
+     * @param velocity The velocity the motor was measured at, which must
+     * be within the tolerance of the swept velocity for the reading to
+     * count. Readings while accelerating are ignored this way.
+     * @param sg_result The reading
+     * @return True if the reading was counted
+     */
+    auto record(size_t point, double velocity, uint16_t sg_result) -> bool {
+        if (point >= Points) {
+            return false;
+        }
+        auto target = _velocities.at(point);
+        if (std::abs(velocity - target) >
+            target * _settings.velocity_tolerance) {
+            return false;
+        }
+        _stats.at(point).add(sg_result);
+        return true;
+    }
+
+    /**
+     * @brief Judge the readings of the sweep that just finished. Unless
+     * the verdict is SWEEP_AGAIN, the calibration is over.
+     */
+    auto finish_sweep() -> Verdict {
+        ++_sweeps;
+        auto first = first_usable();
+        if (first == Points) {
+            // Nothing is usable, so raise the readings off the floor
+            return step(1) ? Verdict::SWEEP_AGAIN : Verdict::FAILED;
+        }
+        auto lowest = std::numeric_limits<double>::max();
+        for (size_t i = first; i < Points; ++i) {
+            lowest = std::min(lowest, _stats.at(i).mean);
+        }
+        if ((lowest < _settings.target_low) && step(1)) {
+            return Verdict::SWEEP_AGAIN;
+        }
+        if ((lowest > _settings.target_high) && step(-1)) {
+            return Verdict::SWEEP_AGAIN;
+        }
+        _result = Result{.sgt = _sgt,
+                         .min_velocity = _velocities.at(first),
+                         .home_velocity = _velocities.back()};
+        return Verdict::DONE;
+    }
+
+    /** Whether a velocity is usable, given the readings so far.*/
+    [[nodiscard]] auto usable(size_t point) const -> bool {
+        const auto& stats = _stats.at(point);
+        return (stats.count >= _settings.min_samples) &&
+               (stats.min >= _settings.floor) &&
+               (stats.stddev() <= stats.mean * _settings.max_noise);
+    }
+
+    [[nodiscard]] auto sgt() const -> int { return _sgt; }
+    [[nodiscard]] auto sweeps() const -> uint8_t { return _sweeps; }
+    [[nodiscard]] auto result() const -> const Result& { return _result; }
+    [[nodiscard]] auto velocity(size_t point) const -> double {
+        return _velocities.at(point);
+    }
+    [[nodiscard]] auto statistics(size_t point) const -> const Statistics& {
+        return _stats.at(point);
+    }
+
+  private:
+    auto clear() -> void { _stats.fill(Statistics{}); }
+
+    // The start of the run of usable velocities at the top of the sweep,
+    // or Points if the fastest isn't usable
+    [[nodiscard]] auto first_usable() const -> size_t {
+        size_t first = Points;
+        while (first > 0 && usable(first - 1)) {
+            --first;
+        }
+        return first;
+    }
+
+    // Move the threshold one step for the next sweep, if it may move
+    auto step(int direction) -> bool {
+        auto next = _sgt + direction;
+        if ((_last_step == -direction) || (next < _settings.sgt_min) ||
+            (next > _settings.sgt_max) ||
+            (_sweeps >= _settings.max_sweeps)) {
+            return false;
+        }
+        _sgt = next;
+        _last_step = direction;
+        clear();
+        return true;
+    }
+
+    Velocities _velocities;
+    Settings _settings;
+    std::array<Statistics, Points> _stats{};
+    int _sgt = 0;
+    int _last_step = 0;
+    uint8_t _sweeps = 0;
+    Result _result{};
+};
+
+}  // namespace stall_calibration
@@ -0,0 +1,167 @@
+/**
+ * @file step_schedule.hpp
+ * @brief Generates the intervals between the steps of a movement ahead of
+ * time, for a timer to step the motor without an interrupt per tick.
+ *
+ * @details Motor movements are normally run by calling a profile's tick()
+ * from a timer interrupt at the profile's tick frequency, which means an
+ * interrupt every few microseconds even when the motor is cruising and only
+ * steps every few dozen ticks. A StepSchedule instead runs the profile ahead
+ * of the motor and writes the number of ticks between each pair of steps
+ * into a buffer, which is streamed into the auto-reload register of a step
+ * timer by DMA. Each timer period starts with a step pulse, so the timer
+ * steps the motor by itself.
+ *
+ * The DMA runs over the buffer in a circle. When it has finished with one
+ * half of the buffer it is refilled by refill(), while the DMA works
+ * through the other half, so the only interrupts are one per half of the
+ * buffer.
+ *
+ * The first period of the timer runs until the first step, and is loaded
+ * directly before the timer starts; entry \c n of the buffer (counting
+ * across refills) is the period from step \c n+1 to step \c n+2. Once the
+ * last step is scheduled, every remaining entry is a short trailing
+ * period. The owner must stop the step pulses before the end of the period
+ * that follows the last step: the total number of steps is available from
+ * steps() once finished() is set, which is always at least half a buffer
+ * of steps before the last one is taken.
+ *
+ * Reload values are 16 bits, so the gap between any two steps must be at
+ * most MAX_INTERVAL ticks. If the profile doesn't step for that long, the
+ * schedule ends early and stalled() is set.
+ *
+ * A timer can't run a period shorter than its step pulse, so no period is
+ * shorter than MinTicks. A step that the profile takes sooner than that
+ * after the one before is put back to MinTicks, which slows the movement
+ * down; movements that step that often should be ticked instead.
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+
+namespace step_schedule {
+
+template <typename Profile>
+concept StepProfile = requires(Profile& p, uint64_t limit) {
+    // Run ticks until the next step, the end of the movement, or limit
+    // ticks, and return how many ticks were run and the result of the last
+    { p.advance(limit).elapsed } -> std::convertible_to<uint64_t>;
+    { p.advance(limit).step } -> std::convertible_to<bool>;
+    { p.advance(limit).done } -> std::convertible_to<bool>;
+};
+
+/**
+ * @brief Precomputes step intervals from a movement profile.
+ * @tparam Profile The movement profile to run
+ * @tparam Length The number of entries in the buffer
+ * @tparam TrailingTicks The length of the periods after the last step
+ * @tparam MinTicks The length of the shortest period
+ */
+template <StepProfile Profile, size_t Length, uint16_t TrailingTicks = 100,
+          uint16_t MinTicks = 1>
+requires(Length >= 2 && Length % 2 == 0 && MinTicks > 0 &&
+         TrailingTicks >= MinTicks) class StepSchedule {
+  public:
+    using Reload = uint16_t;
+    using Buffer = std::array<Reload, Length>;
+
+    static constexpr size_t HALF = Length / 2;
+    /** The longest gap between two steps, in ticks.*/
+    static constexpr uint32_t MAX_INTERVAL = UINT16_MAX + 1;
+    /** The reload value of every period after the last step.*/
+    static constexpr Reload TRAILING_RELOAD = TrailingTicks - 1;
+
+    /**
+     * @brief Start a schedule for a movement, and fill the whole buffer.
+     * @param profile The profile of the movement, which must have just been
+     * reset. It must outlive the schedule.
+     * @return True if the movement takes any steps, in which case the timer
+     * should start with first_reload() and then stream the buffer.
+     */
+    auto start(Profile& profile) -> bool {
+        _profile = &profile;
+        _steps = 0;
+        _finished = false;
+        _stalled = false;
+        _first = TRAILING_RELOAD;
+        auto first = next_interval();
+        if (first == 0) {
+            return false;
+        }
+        _first = to_reload(first);
+        fill(0, Length);
+        return true;
+    }
+
+    /**
+     * @brief Refill the half of the buffer that the DMA has just finished
+     * with, called from its half and full transfer interrupts.
+     * @param second_half True to refill the second half of the buffer,
+     * after the whole buffer has been transferred
+     */
+    auto refill(bool second_half) -> void {
+        fill(second_half ? HALF : 0, HALF);
+    }
+
+    /** The reload value for the period before the first step.*/
+    [[nodiscard]] auto first_reload() const -> Reload { return _first; }
+    [[nodiscard]] auto buffer() -> Buffer& { return _buffer; }
+    [[nodiscard]] auto buffer() const -> const Buffer& { return _buffer; }
+    /** The number of steps that have been scheduled.*/
+    [[nodiscard]] auto steps() const -> uint32_t { return _steps; }
+    /** Whether the last step of the movement has been scheduled.*/
+    [[nodiscard]] auto finished() const -> bool { return _finished; }
+    /** Whether the schedule ended because the steps were too far apart.*/
+    [[nodiscard]] auto stalled() const -> bool { return _stalled; }
+
+  private:
+    auto fill(size_t offset, size_t count) -> void {
+        for (size_t i = offset; i < offset + count; ++i) {
+            auto interval = next_interval();
+            _buffer.at(i) =
+                (interval == 0) ? TRAILING_RELOAD : to_reload(interval);
+        }
+    }
+
+    static auto to_reload(uint32_t interval) -> Reload {
+        return static_cast<Reload>(std::max<uint32_t>(interval, MinTicks) - 1);
+    }
+
+    // The ticks until the next step, or 0 once there are no more
+    auto next_interval() -> uint32_t {
+        if (_finished || _profile == nullptr) {
+            return 0;
+        }
+        uint64_t elapsed = 0;
+        while (elapsed < MAX_INTERVAL) {
+            auto ret = _profile->advance(MAX_INTERVAL - elapsed);
+            elapsed += ret.elapsed;
+            if (ret.done) {
+                _finished = true;
+            }
+            if (ret.step) {
+                ++_steps;
+                return static_cast<uint32_t>(elapsed);
+            }
+            if (ret.done) {
+                return 0;
+            }
+        }
+        _finished = true;
+        _stalled = true;
+        return 0;
+    }
+
+    Profile* _profile = nullptr;
+    Buffer _buffer{};
+    Reload _first = TRAILING_RELOAD;
+    uint32_t _steps = 0;
+    bool _finished = false;
+    bool _stalled = false;
+};
+
+}  // namespace step_schedule
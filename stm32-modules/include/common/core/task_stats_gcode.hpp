@@ -0,0 +1,87 @@
+/**
+ * @file task_stats_gcode.hpp
+ * @brief The M930.D debug gcode, shared by every module that reports
+ * message queue statistics.
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <iterator>
+#include <optional>
+#include <utility>
+
+#include "core/gcode_parser.hpp"
+#include "core/queue_stats.hpp"
+#include "core/utility.hpp"
+
+namespace gcode {
+
+struct GetTaskStatsDebug {
+    /**
+     * GetTaskStatsDebug uses M930.D to report the instrumentation gathered
+     * by each task's message queue. For every task, the response contains
+     *
+     *   <name>:Q<high water>/<capacity> S<sent> F<failed sends>
+     *   H<max handling us>@<slowest message index> W<max queue wait us>
+     *   K<min free stack>
+     *
+     * The slowest message index is the index of the message type in the
+     * task's message variant. Free stack is in words, or -1 if the stack
+     * of the task is not known (e.g. in the simulator).
+     *
+     * If the firmware was built without queue statistics, the response is
+     * M930.D OFF OK
+     */
+    using ParseResult = std::optional<GetTaskStatsDebug>;
+    static constexpr auto prefix = std::array{'M', '9', '3', '0', '.', 'D'};
+
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        auto working = prefix_matches(input, limit, prefix);
+        if (working == input) {
+            return std::make_pair(ParseResult(), input);
+        }
+        return std::make_pair(ParseResult(GetTaskStatsDebug()), working);
+    }
+
+    template <typename InputIt, typename InLimit, size_t N>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputIt, InLimit>
+    static auto write_response_into(
+        InputIt buf, InLimit limit, const std::array<const char*, N>& names,
+        const std::array<queue_stats::Snapshot, N>& stats,
+        bool enabled = queue_stats::ENABLED) -> InputIt {
+        if (!enabled) {
+            return write_string_to_iterpair(buf, limit, "M930.D OFF OK\n");
+        }
+        buf = write_string_to_iterpair(buf, limit, "M930.D");
+        for (size_t i = 0; i < N; ++i) {
+            const auto& task = stats.at(i);
+            auto stack = (task.stack_high_water == queue_stats::STACK_UNKNOWN)
+                             ? -1
+                             : static_cast<int>(task.stack_high_water);
+            auto res = snprintf(
+                &*buf, (limit - buf), " %s:Q%u/%u S%u F%u H%u@%u W%u K%d",
+                names.at(i), static_cast<unsigned>(task.high_water),
+                static_cast<unsigned>(task.capacity),
+                static_cast<unsigned>(task.sent),
+                static_cast<unsigned>(task.send_failures),
+                static_cast<unsigned>(task.max_handling_us),
+                static_cast<unsigned>(task.slowest_message),
+                static_cast<unsigned>(task.max_wait_us), stack);
+            if (res <= 0) {
+                return buf;
+            }
+            buf += std::min(static_cast<decltype(limit - buf)>(res),
+                            (limit - buf));
+        }
+        return write_string_to_iterpair(buf, limit, " OK\n");
+    }
+};
+
+}  // namespace gcode
@@ -0,0 +1,204 @@
+/**
+ * @file trace.hpp
+ * @brief Lightweight timestamped event tracing for profiling hot paths.
+ *
+ * @details Trace points record begin/end/instant events into a fixed RAM
+ * ring buffer. Timestamps come from a clock function that the application
+ * installs at startup: the DWT cycle counter in firmware (see
+ * firmware/dwt_trace_clock.hpp) or std::chrono in the simulator and tests
+ * (see simulator/chrono_trace_clock.hpp). Recording is off until it is
+ * started over the M931.D debug gcode; the enabled check is inline, so
+ * trace points cost a single branch in normal operation.
+ *
+ * The ring is written from any context - tasks and interrupts alike - by
+ * atomically claiming a slot and then reading the clock. An event that is
+ * preempted between the two can sit just before a newer event with an
+ * older timestamp, which the converter accounts for.
+ *
+ * The ring is read out over M931.D after recording has been paused, and
+ * converted to Chrome trace-event JSON with scripts/trace_to_chrome.py.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace trace {
+
+enum class Phase : uint8_t {
+    BEGIN = 'B',
+    END = 'E',
+    INSTANT = 'i',
+};
+
+struct Event {
+    uint32_t timestamp = 0;
+    uint16_t id = 0;
+    Phase phase = Phase::INSTANT;
+};
+
+/**
+ * Identifiers of the trace points across all products. Message handling is
+ * traced as MESSAGE_HANDLING | (task << 8) | message variant index.
+ */
+enum EventId : uint16_t {
+    PLATE_CONTROL_TICK = 1,
+    LID_CONTROL_TICK = 2,
+    THERMISTOR_READ = 3,
+    ADC_CONVERSION_COMPLETE = 4,
+    MOTOR_INTERRUPT_TICK = 5,
+    MESSAGE_HANDLING = 0x8000,
+};
+
+/** Task identifiers for message handling trace events.*/
+enum TaskId : uint8_t {
+    TASK_HOST_COMMS = 0,
+    TASK_SYSTEM = 1,
+    TASK_THERMAL_PLATE = 2,
+    TASK_LID_HEATER = 3,
+    TASK_MOTOR = 4,
+    TASK_MOTOR_DRIVER = 5,
+};
+
+[[nodiscard]] constexpr auto message_event(TaskId task, size_t index)
+    -> uint16_t {
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+    return MESSAGE_HANDLING | static_cast<uint16_t>(task << 8) |
+           static_cast<uint16_t>(index & 0xFF);
+}
+
+using ClockFunction = uint32_t (*)();
+
+/**
+ * @brief Fixed size ring of trace events. Once full, the oldest events are
+ * overwritten.
+ * @tparam N The number of events to hold. Must be a power of two.
+ */
+template <size_t N>
+class TraceBuffer {
+  public:
+    static_assert(N > 0 && (N & (N - 1)) == 0,
+                  "Trace buffer size must be a power of two");
+    static constexpr size_t DEPTH = N;
+
+    /**
+     * @brief Add an event to the ring, if recording is enabled. Safe to
+     * call from interrupt context.
+     */
+    auto record(const Event& event) -> void {
+        if (!_enabled.load(std::memory_order_relaxed)) {
+            return;
+        }
+        auto slot = _head.fetch_add(1, std::memory_order_relaxed);
+        _events.at(slot & (N - 1)) = event;
+    }
+
+    /**
+     * @brief Add an event stamped with the current time, if recording is
+     * enabled. The slot is claimed before the clock is read so that
+     * timestamps only run backwards across a preemption, never forwards.
+     * Safe to call from interrupt context.
+     */
+    auto record(uint16_t id, Phase phase, ClockFunction clock) -> void {
+        if (!_enabled.load(std::memory_order_relaxed)) {
+            return;
+        }
+        auto slot = _head.fetch_add(1, std::memory_order_relaxed);
+        _events.at(slot & (N - 1)) =
+            Event{.timestamp = clock(), .id = id, .phase = phase};
+    }
+
+    /** Number of valid events in the ring.*/
+    [[nodiscard]] auto count() const -> size_t {
+        auto head = _head.load(std::memory_order_relaxed);
+        return (head < N) ? head : N;
+    }
+
+    /** Total number of events recorded since the last clear, which may
+     * be more than the ring holds.*/
+    [[nodiscard]] auto total() const -> size_t {
+        return _head.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get an event, oldest first. Only meaningful while recording
+     * is paused.
+     * @param index The index of the event, from 0 to count()
+     */
+    [[nodiscard]] auto at(size_t index) const -> Event {
+        auto head = _head.load(std::memory_order_relaxed);
+        auto oldest = (head < N) ? 0 : head;
+        return _events.at((oldest + index) & (N - 1));
+    }
+
+    auto set_enabled(bool enabled) -> void {
+        _enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] auto enabled() const -> bool {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+
+    auto clear() -> void { _head.store(0, std::memory_order_relaxed); }
+
+  private:
+    std::array<Event, N> _events{};
+    std::atomic<size_t> _head{0};
+    std::atomic_bool _enabled{false};
+};
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+static constexpr size_t TRACE_DEPTH = 256;
+using Buffer = TraceBuffer<TRACE_DEPTH>;
+
+namespace detail {
+// Shared by every trace point in the application. It lives in the header
+// so that the enabled check in record() can be inlined.
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+inline Buffer buffer{};
+
+/** Stamp and store an event. Called only while recording is enabled.*/
+auto record_enabled(uint16_t id, Phase phase) -> void;
+}  // namespace detail
+
+/**
+ * @brief Install the timestamp source. This does not start recording.
+ * @param clock Function returning a free-running 32 bit tick count
+ * @param ticks_per_us The number of clock ticks in one microsecond
+ */
+auto install_clock(ClockFunction clock, uint32_t ticks_per_us) -> void;
+
+/** Get the tick rate of the installed clock, or 0 if none is installed.*/
+[[nodiscard]] auto ticks_per_us() -> uint32_t;
+
+/** Get the global trace buffer.*/
+[[nodiscard]] inline auto get_buffer() -> Buffer& { return detail::buffer; }
+
+/** Record an event with the current timestamp. No-op without a clock.*/
+inline auto record(uint16_t id, Phase phase) -> void {
+    if (detail::buffer.enabled()) {
+        detail::record_enabled(id, phase);
+    }
+}
+
+inline auto begin(uint16_t id) -> void { record(id, Phase::BEGIN); }
+inline auto end(uint16_t id) -> void { record(id, Phase::END); }
+inline auto instant(uint16_t id) -> void { record(id, Phase::INSTANT); }
+
+/** Records a begin event on construction and an end event on destruction.*/
+class Scope {
+  public:
+    explicit Scope(uint16_t id) : _id(id) { begin(_id); }
+    Scope(const Scope&) = delete;
+    auto operator=(const Scope&) -> Scope& = delete;
+    Scope(Scope&&) = delete;
+    auto operator=(Scope&&) -> Scope& = delete;
+    ~Scope() { end(_id); }
+
+  private:
+    uint16_t _id;
+};
+
+}  // namespace trace
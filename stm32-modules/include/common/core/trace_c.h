@@ -0,0 +1,27 @@
+/**
+ * @file trace_c.h
+ * @brief C interface to the trace buffer in trace.hpp, for trace points in
+ * C hardware files such as interrupt handlers.
+ */
+#ifndef TRACE_C_H_
+#define TRACE_C_H_
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+#include <stdint.h>
+
+// These must match trace::EventId in trace.hpp
+#define TRACE_ID_ADC_CONVERSION_COMPLETE (4)
+
+/**
+ * @brief Record an instant trace event. Safe to call from an ISR, and does
+ * nothing if no trace clock is installed.
+ * @param id The trace::EventId of the event
+ */
+void trace_instant(uint16_t id);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+#endif  /* TRACE_C_H_ */
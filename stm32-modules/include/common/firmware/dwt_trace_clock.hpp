@@ -0,0 +1,46 @@
+/**
+ * @file dwt_trace_clock.hpp
+ * @brief Trace timestamp source built on the Cortex-M DWT cycle counter.
+ *
+ * @details The DWT and core debug registers are at the same addresses on
+ * every Cortex-M3/M4 part, so they are accessed directly rather than
+ * through a device-specific CMSIS header.
+ */
+#pragma once
+
+#include <cstdint>
+
+#include "core/trace.hpp"
+
+namespace dwt_trace_clock {
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+static constexpr uintptr_t DEMCR_ADDRESS = 0xE000EDFC;
+static constexpr uintptr_t DWT_CTRL_ADDRESS = 0xE0001000;
+static constexpr uintptr_t DWT_CYCCNT_ADDRESS = 0xE0001004;
+static constexpr uint32_t DEMCR_TRCENA = (1 << 24);
+static constexpr uint32_t DWT_CTRL_CYCCNTENA = (1 << 0);
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+
+[[nodiscard]] inline auto reg(uintptr_t address) -> volatile uint32_t& {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast,performance-no-int-to-ptr)
+    return *reinterpret_cast<volatile uint32_t*>(address);
+}
+
+/** Read the free-running cycle counter.*/
+inline auto now() -> uint32_t { return reg(DWT_CYCCNT_ADDRESS); }
+
+/**
+ * @brief Enable the cycle counter and install it as the trace clock. Call
+ * this once at startup, after the system clock is configured.
+ * @param core_clock_hz The core clock frequency, i.e. SystemCoreClock
+ */
+inline auto install(uint32_t core_clock_hz) -> void {
+    static constexpr uint32_t HZ_PER_MHZ = 1000000;
+    reg(DEMCR_ADDRESS) = reg(DEMCR_ADDRESS) | DEMCR_TRCENA;
+    reg(DWT_CYCCNT_ADDRESS) = 0;
+    reg(DWT_CTRL_ADDRESS) = reg(DWT_CTRL_ADDRESS) | DWT_CTRL_CYCCNTENA;
+    trace::install_clock(now, core_clock_hz / HZ_PER_MHZ);
+}
+
+}  // namespace dwt_trace_clock
@@ -7,6 +7,9 @@
 #include <array>
 
 #include "FreeRTOS.h"
+#include "core/queue_stats.hpp"
+#include "core/trace.hpp"
+#include "firmware/dwt_trace_clock.hpp"
 #include "queue.h"
 #include "task.h"
 
@@ -16,6 +19,9 @@ template <typename M, size_t Idx = 0, size_t queue_size = 10>
 class FreeRTOSMessageQueue {
   public:
     using Message = M;
+    using Stats = queue_stats::QueueStats<Message, queue_size>;
+    // With statistics enabled, messages carry their DWT enqueue time
+    using Entry = queue_stats::Entry<Message>;
 
     // https://bugs.llvm.org/show_bug.cgi?id=37902
     // NOLINTNEXTLINE(cppcoreguidelines-pro-type-member-init)
@@ -26,10 +32,11 @@ class FreeRTOSMessageQueue {
     explicit FreeRTOSMessageQueue(uint8_t notification_bit)
         : queue_control_structure(),
           backing(),
-          queue(xQueueCreateStatic(queue_size, sizeof(Message), backing.data(),
+          queue(xQueueCreateStatic(queue_size, sizeof(Entry), backing.data(),
                                    &queue_control_structure)),
           receiver_handle(nullptr),
-          sent_bit(notification_bit) {}
+          sent_bit(notification_bit),
+          stats() {}
 
     // For use with queue_aggregator
     struct Tag {};
@@ -46,25 +53,51 @@ class FreeRTOSMessageQueue {
     ~FreeRTOSMessageQueue() = default;
     [[nodiscard]] auto try_send(const Message& message,
                                 const uint32_t timeout_ticks = 0) -> bool {
-        auto sent = xQueueSendToBack(queue, &message, timeout_ticks) == pdTRUE;
-        return sent;
+        if constexpr (queue_stats::ENABLED) {
+            auto entry = queue_stats::to_entry(message, dwt_trace_clock::now());
+            auto sent =
+                xQueueSendToBack(queue, &entry, timeout_ticks) == pdTRUE;
+            stats.record_send(sent, uxQueueMessagesWaiting(queue));
+            return sent;
+        } else {
+            return xQueueSendToBack(queue, &message, timeout_ticks) == pdTRUE;
+        }
     }
 
     [[nodiscard]] auto try_send_from_isr(const Message& message) -> bool {
         BaseType_t higher_woken = pdFALSE;
-        auto sent = xQueueSendFromISR(queue, &message, &higher_woken);
+        BaseType_t sent = pdFALSE;
+        if constexpr (queue_stats::ENABLED) {
+            auto entry = queue_stats::to_entry(message, dwt_trace_clock::now());
+            sent = xQueueSendFromISR(queue, &entry, &higher_woken);
+            stats.record_send(sent == pdTRUE,
+                              uxQueueMessagesWaitingFromISR(queue));
+        } else {
+            sent = xQueueSendFromISR(queue, &message, &higher_woken);
+        }
         portYIELD_FROM_ISR(  // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
             higher_woken);
         return sent;
     }
     [[nodiscard]] auto try_recv(Message* message, uint32_t timeout_ticks = 0)
         -> bool {
-        return xQueueReceive(queue, message, timeout_ticks) == pdTRUE;
+        if constexpr (queue_stats::ENABLED) {
+            stats.record_idle(dwt_trace_clock::now());
+            Entry entry{};
+            auto got_message =
+                xQueueReceive(queue, &entry, timeout_ticks) == pdTRUE;
+            if (got_message) {
+                *message = entry.message;
+                stats.record_receive(queue_stats::message_index(*message),
+                                     entry.enqueued, dwt_trace_clock::now());
+            }
+            return got_message;
+        } else {
+            return xQueueReceive(queue, message, timeout_ticks) == pdTRUE;
+        }
     }
     auto recv(Message* message) -> void {
-        BaseType_t got_message = pdFALSE;
-        while (got_message == pdFALSE) {
-            got_message = xQueueReceive(queue, message, portMAX_DELAY);
+        while (!try_recv(message, portMAX_DELAY)) {
         }
     }
     [[nodiscard]] auto has_message() const -> bool {
@@ -72,10 +105,25 @@ class FreeRTOSMessageQueue {
     }
     void provide_handle(TaskHandle_t handle) { receiver_handle = handle; }
 
+    /**
+     * @brief Get the statistics for this queue, including the stack high
+     * water mark of the receiving task if a handle has been provided.
+     */
+    [[nodiscard]] auto get_stats() const -> queue_stats::Snapshot {
+        auto ret = stats.snapshot(trace::ticks_per_us());
+        if (receiver_handle != nullptr) {
+            ret.stack_high_water = static_cast<uint32_t>(
+                uxTaskGetStackHighWaterMark(receiver_handle));
+        }
+        return ret;
+    }
+    auto reset_stats() -> void { stats.reset(); }
+
   private:
     StaticQueue_t queue_control_structure;
-    std::array<uint8_t, queue_size * sizeof(Message)> backing;
+    std::array<uint8_t, queue_size * sizeof(Entry)> backing;
     QueueHandle_t queue;
     TaskHandle_t receiver_handle;
     uint8_t sent_bit;
+    Stats stats;
 };
@@ -7,6 +7,8 @@
 #pragma once
 #include <concepts>
 
+#include "core/queue_stats.hpp"
+
 template <class MQ, typename MessageType>
 concept MessageQueue = requires(MQ mq, MessageType mt, const MQ cmq,
                                 const MessageType cmt) {
@@ -28,4 +30,7 @@ concept MessageQueue = requires(MQ mq, MessageType mt, const MQ cmq,
 
     // Queues must have a const method to check whether there are messages.
     { cmq.has_message() } -> std::same_as<bool>;
+
+    // Queues must provide instrumentation for debugging task timing.
+    { cmq.get_stats() } -> std::same_as<queue_stats::Snapshot>;
 };
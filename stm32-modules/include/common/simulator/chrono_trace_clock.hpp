@@ -0,0 +1,29 @@
+/**
+ * @file chrono_trace_clock.hpp
+ * @brief Trace timestamp source for simulator builds, with microsecond
+ * ticks from std::chrono::steady_clock.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "core/trace.hpp"
+
+namespace chrono_trace_clock {
+
+/** Microseconds since the first call, wrapping at 32 bits.*/
+inline auto now() -> uint32_t {
+    using namespace std::chrono;
+    static const auto start = steady_clock::now();
+    return static_cast<uint32_t>(
+        duration_cast<microseconds>(steady_clock::now() - start).count());
+}
+
+/** Install the steady clock as the trace clock.*/
+inline auto install() -> void {
+    static_cast<void>(now());
+    trace::install_clock(now, 1);
+}
+
+}  // namespace chrono_trace_clock
@@ -0,0 +1,152 @@
+/**
+ * @file sim_clock.hpp
+ * @brief A clock for simulated time, shared by the tasks of a simulator so
+ * that their physical models agree on how much time has passed.
+ *
+ * @details The clock runs in one of two ways:
+ *
+ * - In lockstep, time only moves when it is advanced. The worker pool
+ * advances it once every task has handled what it was given and is waiting
+ * for time to pass, straight to the next time something is waiting for, so
+ * a simulation runs as fast as the tasks can keep up with and every run of
+ * it sees the same sequence of events. This is the default.
+ * - Scaled, it runs a fixed factor faster than the steady clock, a factor of
+ * one being real time. Every part of the simulator still sees the same
+ * relative timing, but how much work the tasks get done between two ticks
+ * depends on how busy the host is, so two runs may differ.
+ *
+ * Timestamps are in milliseconds, the length of a FreeRTOS tick on hardware.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <thread>
+
+namespace sim_clock {
+
+class SimClock {
+  public:
+    using Clock = std::chrono::steady_clock;
+    /** The speedup that selects lockstep time.*/
+    static constexpr double LOCKSTEP = 0.0;
+    /** The speedup of real time.*/
+    static constexpr double REALTIME = 1.0;
+
+    /**
+     * @brief Create a clock at simulated time 0.
+     * @param speedup How much faster than real time the clock runs, or
+     * LOCKSTEP to only move it when it is advanced
+     */
+    explicit SimClock(double speedup = LOCKSTEP)
+        : _speedup(std::max(speedup, LOCKSTEP)), _start(Clock::now()) {}
+
+    [[nodiscard]] auto lockstep() const -> bool {
+        return _speedup == LOCKSTEP;
+    }
+    [[nodiscard]] auto realtime() const -> bool {
+        return _speedup == REALTIME;
+    }
+
+    /** Milliseconds of simulated time since the clock was created.*/
+    [[nodiscard]] auto now_ms() const -> uint64_t {
+        if (lockstep()) {
+            return _now_ms.load();
+        }
+        using Millis = std::chrono::duration<double, std::milli>;
+        auto real = std::chrono::duration_cast<Millis>(Clock::now() - _start);
+        return static_cast<uint64_t>(real.count() * _speedup);
+    }
+
+    /** Block the calling thread until a simulated time.*/
+    auto sleep_until_ms(uint64_t ms) -> void {
+        if (!lockstep()) {
+            using Millis = std::chrono::duration<double, std::milli>;
+            auto real = Millis(static_cast<double>(ms) / _speedup);
+            std::this_thread::sleep_until(
+                _start + std::chrono::duration_cast<Clock::duration>(real));
+            return;
+        }
+        auto lock = std::unique_lock(_mutex);
+        auto sleeper = _sleepers.insert(ms);
+        if (_on_sleep) {
+            lock.unlock();
+            _on_sleep();
+            lock.lock();
+        }
+        _advanced.wait(lock, [this, ms]() { return _now_ms.load() >= ms; });
+        _sleepers.erase(sleeper);
+    }
+
+    /** Block the calling thread for a length of simulated time.*/
+    auto sleep_ms(uint64_t ms) -> void { sleep_until_ms(now_ms() + ms); }
+
+    /**
+     * @brief In lockstep, set a function that every thread going to sleep
+     * calls once it counts as a sleeper, so that whatever advances the
+     * clock can do so even when the threads it would otherwise use to do it
+     * are the ones asleep. Only set or clear it while nothing is sleeping.
+     */
+    auto on_sleep(std::function<void()> hook) -> void {
+        auto lock = std::unique_lock(_mutex);
+        _on_sleep = std::move(hook);
+    }
+
+    /**
+     * @brief In lockstep, the number of threads asleep until a time that
+     * hasn't come yet. Threads that have been woken but haven't run yet
+     * aren't counted.
+     */
+    [[nodiscard]] auto sleepers() const -> size_t {
+        auto lock = std::unique_lock(_mutex);
+        return std::distance(_sleepers.upper_bound(_now_ms.load()),
+                             _sleepers.end());
+    }
+
+    /** In lockstep, the earliest time a sleeping thread is waiting for.*/
+    [[nodiscard]] auto next_wakeup() const -> std::optional<uint64_t> {
+        auto lock = std::unique_lock(_mutex);
+        auto next = _sleepers.upper_bound(_now_ms.load());
+        if (next == _sleepers.end()) {
+            return std::nullopt;
+        }
+        return *next;
+    }
+
+    /**
+     * @brief In lockstep, move simulated time forward and wake every thread
+     * sleeping until then. Time never moves backwards.
+     */
+    auto advance_to(uint64_t ms) -> void {
+        {
+            auto lock = std::unique_lock(_mutex);
+            if (ms <= _now_ms.load()) {
+                return;
+            }
+            _now_ms.store(ms);
+        }
+        _advanced.notify_all();
+    }
+
+  private:
+    double _speedup;
+    Clock::time_point _start;
+    // Only used in lockstep
+    std::atomic<uint64_t> _now_ms = 0;
+    mutable std::mutex _mutex{};
+    std::condition_variable _advanced{};
+    // The times each sleeping thread is waiting for
+    std::multiset<uint64_t> _sleepers{};
+    std::function<void()> _on_sleep{};
+};
+
+}  // namespace sim_clock
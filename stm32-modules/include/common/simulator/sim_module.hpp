@@ -0,0 +1,54 @@
+/**
+ * @file sim_module.hpp
+ * @brief The interface between the sim host and the simulated modules it
+ * loads, so that a single process can run a deck of mixed module types on
+ * one worker pool.
+ *
+ * @details Every module type's simulator is also built as a plugin, a
+ * shared object named `<module type>-sim-module.so`. The sim host opens
+ * each plugin with RTLD_LOCAL, and plugins are built with hidden visibility
+ * and linked so that they only bind to their own copies of their symbols.
+ * Module types can then keep reusing the same names for their tasks,
+ * messages and queues without colliding. The only symbol a plugin exports
+ * is its ADD_FUNCTION, which the host looks up by name.
+ */
+#pragma once
+
+#include "simulator/sim_worker_pool.hpp"
+
+namespace sim_module {
+
+/** One simulated module, whose tasks run on the host's worker pool.*/
+class SimModule {
+  public:
+    SimModule() = default;
+    SimModule(const SimModule&) = delete;
+    auto operator=(const SimModule&) -> SimModule& = delete;
+    SimModule(SimModule&&) = delete;
+    auto operator=(SimModule&&) -> SimModule& = delete;
+    virtual ~SimModule() = default;
+
+    /**
+     * @brief Pass input from the module's socket to its tasks until the
+     * socket closes. The host calls this on a thread of its own, once the
+     * pool has started. Errors from the socket only end this module's
+     * input, so they're handled here rather than thrown out of the plugin.
+     */
+    virtual auto read_input() -> void = 0;
+};
+
+/**
+ * @brief Create a module, add its tasks to a pool that hasn't started yet,
+ * and connect it to a socket (`<scheme>://<host>:<port>`). The module is
+ * deleted by the host once the pool has stopped.
+ */
+using AddFunction = SimModule* (*)(sim_worker_pool::WorkerPool& pool,
+                                   const char* socket);
+
+/** The name every plugin exports its AddFunction under.*/
+static constexpr const char* ADD_FUNCTION = "sim_module_add";
+
+}  // namespace sim_module
+
+/** Marks a plugin's AddFunction, the one symbol a plugin exports.*/
+#define SIM_MODULE_EXPORT extern "C" __attribute__((visibility("default")))
@@ -0,0 +1,237 @@
+/**
+ * @file sim_worker_pool.hpp
+ * @brief A small pool of threads that runs the tasks of simulated modules,
+ * so that a simulator hosting a whole deck doesn't need a thread for every
+ * task of every module.
+ *
+ * @details A job is either driven by messages, in which case it runs
+ * whenever it reports that it's ready (usually because its queue has a
+ * message waiting), or periodic, in which case it runs once every period of
+ * the shared simulated clock. A job never runs on two workers at once, so a
+ * task and its policy only need to be as thread safe as they are when they
+ * have a thread to themselves.
+ *
+ * With a lockstep clock, the pool is what moves time on. Once every
+ * running job is asleep on the clock and no free worker has anything to
+ * run, the clock advances straight to the next periodic job or sleeper.
+ * Usually the next worker to find nothing to do advances it, but when
+ * every worker is asleep in a job, the last job to go to sleep does, to
+ * the next sleeper's wakeup; jobs that came due in the meantime run late,
+ * and periodic jobs catch up. With a scaled clock, workers wait briefly
+ * whenever they find nothing to do.
+ *
+ * Jobs must not block waiting for something only another job can provide,
+ * other than simulated time, and every job must be added before the pool is
+ * started.
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "simulator/sim_clock.hpp"
+
+namespace sim_worker_pool {
+
+class WorkerPool {
+  public:
+    using Ready = std::function<bool()>;
+    using Work = std::function<void()>;
+
+    /** The longest a worker waits after finding nothing to do.*/
+    static constexpr auto IDLE_SLEEP = std::chrono::milliseconds(1);
+
+    WorkerPool(std::shared_ptr<sim_clock::SimClock> clock, size_t workers)
+        : _clock(std::move(clock)),
+          _worker_count(std::max<size_t>(workers, 1)) {
+        if (_clock->lockstep()) {
+            _clock->on_sleep([this]() { sleeping(); });
+        }
+    }
+    WorkerPool(const WorkerPool&) = delete;
+    auto operator=(const WorkerPool&) -> WorkerPool& = delete;
+    WorkerPool(WorkerPool&&) = delete;
+    auto operator=(WorkerPool&&) -> WorkerPool& = delete;
+    ~WorkerPool() {
+        stop();
+        _clock->on_sleep(nullptr);
+    }
+
+    [[nodiscard]] auto clock() const -> std::shared_ptr<sim_clock::SimClock> {
+        return _clock;
+    }
+
+    /** Add a job that runs whenever ready() returns true.*/
+    auto add(Ready ready, Work work) -> void {
+        _jobs.emplace_back(std::move(ready), std::move(work), 0);
+    }
+
+    /** Add a job that runs once every period of simulated time.*/
+    auto add_periodic(uint64_t period_ms, Work work) -> void {
+        auto& job = _jobs.emplace_back(nullptr, std::move(work), period_ms);
+        job.next_ms = _clock->now_ms() + period_ms;
+    }
+
+    auto start() -> void {
+        for (size_t i = 0; i < _worker_count; ++i) {
+            _workers.emplace_back(
+                [this, i](std::stop_token st) { run(st, i); });
+        }
+    }
+
+    /** Stop every worker, letting the jobs they're running finish.*/
+    auto stop() -> void {
+        for (auto& worker : _workers) {
+            worker.request_stop();
+        }
+        if (_clock->lockstep()) {
+            // A job asleep on the clock only finishes once the clock moves
+            // on, and the stopping workers won't move it any more
+            auto lock = std::unique_lock(_mutex);
+            while (_running > 0) {
+                if (_running == _clock->sleepers()) {
+                    _clock->advance_to(_clock->next_wakeup().value_or(0));
+                }
+                _changed.wait_for(lock, IDLE_SLEEP);
+            }
+        }
+        _workers.clear();
+    }
+
+  private:
+    struct Job {
+        Job(Ready ready, Work work, uint64_t period_ms)
+            : ready(std::move(ready)),
+              work(std::move(work)),
+              period_ms(period_ms) {}
+
+        Ready ready;
+        Work work;
+        uint64_t period_ms;
+        uint64_t next_ms = 0;
+        bool busy = false;
+    };
+
+    // Whether a job should run now. Periodic jobs that have fallen behind
+    // run once for every period missed, so their models keep in step with
+    // the clock.
+    auto due(Job& job) -> bool {
+        if (job.period_ms == 0) {
+            return job.ready();
+        }
+        if (_clock->now_ms() < job.next_ms) {
+            return false;
+        }
+        job.next_ms += job.period_ms;
+        return true;
+    }
+
+    // Find a job that should run now and isn't running, and mark it busy
+    auto claim(size_t first) -> Job* {
+        for (size_t i = 0; i < _jobs.size(); ++i) {
+            auto& job = _jobs[(first + i) % _jobs.size()];
+            if (!job.busy && due(job)) {
+                job.busy = true;
+                ++_running;
+                return &job;
+            }
+        }
+        return nullptr;
+    }
+
+    // Whether a job that isn't running should run now, without taking its
+    // turn
+    auto pending(const Job& job) -> bool {
+        if (job.busy) {
+            return false;
+        }
+        if (job.period_ms == 0) {
+            return job.ready();
+        }
+        return _clock->now_ms() >= job.next_ms;
+    }
+
+    // With nothing left to run at the current time, move a lockstep clock
+    // on to the next time a periodic job or a sleeping job is waiting for.
+    // If every worker is asleep in a job, nothing else can run until one of
+    // them wakes, so the clock moves straight to the next wakeup. Returns
+    // whether the clock moved.
+    auto advance() -> bool {
+        if (_running != _clock->sleepers()) {
+            return false;
+        }
+        auto next = _clock->next_wakeup();
+        if (_running < _worker_count) {
+            if (std::ranges::any_of(
+                    _jobs, [this](const Job& job) { return pending(job); })) {
+                return false;
+            }
+            auto now = _clock->now_ms();
+            for (const auto& job : _jobs) {
+                if (job.period_ms != 0 && job.next_ms > now) {
+                    next = std::min(next.value_or(job.next_ms), job.next_ms);
+                }
+            }
+        }
+        if (!next.has_value()) {
+            return false;
+        }
+        _clock->advance_to(next.value());
+        return true;
+    }
+
+    // Called by each thread going to sleep on a lockstep clock. A worker
+    // asleep in a job can't advance the clock, so if it's the last one to
+    // go to sleep, it advances it before it sleeps.
+    auto sleeping() -> void {
+        auto lock = std::unique_lock(_mutex);
+        if (advance()) {
+            _changed.notify_all();
+        }
+    }
+
+    auto run(const std::stop_token& st, size_t index) -> void {
+        // Each worker starts its scan at a different job, so they don't all
+        // favour the first one
+        auto first = index * _jobs.size() / _worker_count;
+        auto lock = std::unique_lock(_mutex);
+        while (!st.stop_requested()) {
+            auto* job = claim(first);
+            if (job != nullptr) {
+                lock.unlock();
+                job->work();
+                lock.lock();
+                job->busy = false;
+                --_running;
+                _changed.notify_all();
+            } else if (!_clock->lockstep() || !advance()) {
+                _changed.wait_for(lock, IDLE_SLEEP);
+            }
+        }
+    }
+
+    std::shared_ptr<sim_clock::SimClock> _clock;
+    size_t _worker_count;
+    // A deque, so that jobs don't move as more are added
+    std::deque<Job> _jobs{};
+    // Guards the state of every job and the count of running jobs
+    std::mutex _mutex{};
+    // Signalled whenever a job finishes
+    std::condition_variable _changed{};
+    size_t _running = 0;
+    std::vector<std::jthread> _workers{};
+};
+
+}  // namespace sim_worker_pool
@@ -1,20 +1,27 @@
 #pragma once
 
+#include <atomic>
 #include <boost/lockfree/queue.hpp>
 #include <chrono>
 #include <exception>
 #include <limits>
 #include <thread>
 
+#include "core/queue_stats.hpp"
+
 template <typename M, size_t queue_size = 8>
 class SimulatorMessageQueue {
   public:
     using clock = std::chrono::steady_clock;
     using Message = M;
+    // With statistics enabled, messages carry their enqueue time
+    using Entry = queue_stats::Entry<Message>;
     using QueueType =
-        boost::lockfree::queue<Message, boost::lockfree::capacity<queue_size>>;
+        boost::lockfree::queue<Entry, boost::lockfree::capacity<queue_size>>;
+    using Stats = queue_stats::QueueStats<Message, queue_size>;
     class StopDuringMsgWait : public std::exception {};
-    SimulatorMessageQueue() : queue(queue_size), mythread_stop_token() {}
+    SimulatorMessageQueue()
+        : queue(queue_size), mythread_stop_token(), depth(0), stats() {}
 
     struct Tag {};
 
@@ -24,15 +31,22 @@ class SimulatorMessageQueue {
     [[nodiscard]] auto try_send(const Message& message,
                                 const uint32_t timeout_ticks = 0) -> bool {
         auto at_start = clock::now();
+        auto entry = queue_stats::to_entry(message, now_us());
         bool sent_message = false;
         while (!sent_message) {
             using namespace std::literals::chrono_literals;
-            sent_message = queue.push(message);
+            // Count the message before it can be received, so that the
+            // receiver's decrement never takes the depth below zero
+            auto depth_with_message = ++depth;
+            sent_message = queue.push(entry);
             if (sent_message) {
+                stats.record_send(true, depth_with_message);
                 return sent_message;
             }
+            --depth;
             if ((clock::now() - at_start) >
                 std::chrono::milliseconds(timeout_ticks)) {
+                stats.record_send(false, queue_size);
                 return false;
             }
             std::this_thread::sleep_for(1ms);
@@ -50,11 +64,19 @@ class SimulatorMessageQueue {
             throw std::invalid_argument("null message pointer");
         }
         auto at_start = clock::now();
+        stats.record_idle(now_us());
+        Entry entry{};
         bool got_message = false;
         while (!got_message) {
             using namespace std::literals::chrono_literals;
-            got_message = queue.pop(*message);
+            got_message = queue.pop(entry);
             if (got_message) {
+                --depth;
+                *message = queue_stats::from_entry<Message>(entry);
+                auto now = now_us();
+                stats.record_receive(
+                    queue_stats::message_index(*message),
+                    queue_stats::enqueued_at<Message>(entry, now), now);
                 return got_message;
             }
             if ((clock::now() - at_start) >
@@ -76,7 +98,26 @@ class SimulatorMessageQueue {
 
     [[nodiscard]] auto has_message() const -> bool { return !queue.empty(); }
 
+    /**
+     * @brief Get the statistics for this queue. Stack usage is not tracked
+     * in the simulator.
+     */
+    [[nodiscard]] auto get_stats() const -> queue_stats::Snapshot {
+        return stats.snapshot(1);
+    }
+    auto reset_stats() -> void { stats.reset(); }
+
   private:
+    static auto now_us() -> uint32_t {
+        return static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                clock::now().time_since_epoch())
+                .count());
+    }
+
     QueueType queue;
     std::stop_token mythread_stop_token;
+    // Tracked separately because the lockfree queue can't report its size
+    std::atomic<size_t> depth;
+    Stats stats;
 };
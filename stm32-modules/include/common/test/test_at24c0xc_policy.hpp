@@ -31,6 +31,9 @@ class TestAT24C0XCPolicy {
     auto i2c_write(uint8_t addr, Input data, size_t len) -> bool {
         // Ignore address for test purposes
         static_cast<void>(addr);
+        if (write_cycle_busy()) {
+            return false;
+        }
         if (len > 0) {
             if (*data >= _buffer.size()) {
                 // Out of bounds write attempt
@@ -47,6 +50,10 @@ class TestAT24C0XCPolicy {
                     _data_pointer -= PAGE_LENGTH;
                 }
             }
+            if (len > 1) {
+                ++_data_writes;
+                _busy_remaining = _busy_polls;
+            }
         }
 
         return true;
@@ -57,6 +64,9 @@ class TestAT24C0XCPolicy {
     auto i2c_write(uint8_t addr, uint8_t data_addr) {
         // Ignore address for test purposes
         static_cast<void>(addr);
+        if (write_cycle_busy()) {
+            return false;
+        }
         if (data_addr < _buffer.size()) {
             _data_pointer = data_addr;
             return true;
@@ -68,6 +78,10 @@ class TestAT24C0XCPolicy {
     auto i2c_read(uint8_t addr, Input data, size_t len) -> bool {
         // Ignore address for test purposes
         static_cast<void>(addr);
+        if (write_cycle_busy()) {
+            return false;
+        }
+        ++_reads;
         // Data pointer is held over from the last transaction
         for (size_t i = 0; i < len; ++i, ++data) {
             *data = _buffer[_data_pointer++];
@@ -86,6 +100,23 @@ class TestAT24C0XCPolicy {
     Buffer _buffer;
     size_t _data_pointer;
     bool _write_protect;
+    // Number of writes that carried data, and number of reads
+    size_t _data_writes = 0;
+    size_t _reads = 0;
+    // How many transfers the device NACKs after each data write, as if
+    // it were busy with its internal write cycle
+    size_t _busy_polls = 0;
+
+  private:
+    auto write_cycle_busy() -> bool {
+        if (_busy_remaining > 0) {
+            --_busy_remaining;
+            return true;
+        }
+        return false;
+    }
+
+    size_t _busy_remaining = 0;
 };
 
 }  // namespace at24c0xc_test_policy
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "core/i2c_bus.hpp"
+
+namespace i2c_bus_test_policy {
+
+/**
+ * A host-side I2C bus for testing the bus manager and anything that
+ * submits transactions to it. Each device on the bus is a 256-byte
+ * register file with an auto-incrementing address pointer, like an EEPROM.
+ *
+ * Transfers do not finish on their own: call finish() to run the
+ * transfer that is on the bus against the devices, then pass its result
+ * to the manager's complete(), just as the transfer-complete interrupt
+ * would.
+ */
+class I2CBusTestPolicy {
+  public:
+    struct Device {
+        std::array<uint8_t, 256> registers{};
+        uint8_t pointer = 0;
+    };
+
+    // --- Policy fulfillment -----------
+
+    auto i2c_bus_start(const i2c_bus::Transaction& transaction) -> bool {
+        if (_active.has_value()) {
+            throw std::runtime_error("Started a transfer on a busy bus");
+        }
+        if (_fail_next_start) {
+            _fail_next_start = false;
+            return false;
+        }
+        _active = transaction;
+        _started.push_back(transaction);
+        return true;
+    }
+
+    auto i2c_bus_lock() -> void {
+        if (_locked) {
+            throw std::runtime_error("Can't wait on the bus lock in tests");
+        }
+        _locked = true;
+    }
+
+    auto i2c_bus_unlock() -> void { _locked = false; }
+
+    // --- Test integration -------------
+
+    auto add_device(uint16_t address) -> Device& {
+        return _devices[address];
+    }
+
+    auto device(uint16_t address) -> Device& { return _devices.at(address); }
+
+    /** Whether a transfer has been started and not finished.*/
+    [[nodiscard]] auto transfer_active() const -> bool {
+        return _active.has_value();
+    }
+
+    /**
+     * @brief Run the transfer on the bus against the devices.
+     * @return Whether the transfer succeeded. It fails if no device has
+     * its address, or if _fail_next_transfer is set.
+     */
+    auto finish() -> bool {
+        if (!_active.has_value()) {
+            throw std::runtime_error("No transfer to finish");
+        }
+        auto transaction = _active.value();
+        _active.reset();
+        if (_fail_next_transfer) {
+            _fail_next_transfer = false;
+            return false;
+        }
+        auto found = _devices.find(transaction.address);
+        if (found == _devices.end()) {
+            return false;
+        }
+        auto& device = found->second;
+        auto* data = transaction.data;
+        auto length = transaction.length;
+        switch (transaction.type) {
+            case i2c_bus::Type::WRITE:
+                // The first byte of a plain write sets the pointer
+                if (length > 0) {
+                    device.pointer = *data;
+                    ++data;
+                    --length;
+                }
+                write(device, data, length);
+                break;
+            case i2c_bus::Type::MEM_WRITE:
+                device.pointer = transaction.mem_address;
+                write(device, data, length);
+                break;
+            case i2c_bus::Type::MEM_READ:
+                device.pointer = transaction.mem_address;
+                read(device, data, length);
+                break;
+            case i2c_bus::Type::READ:
+                read(device, data, length);
+                break;
+        }
+        return true;
+    }
+
+    bool _fail_next_start = false;
+    bool _fail_next_transfer = false;
+    bool _locked = false;
+    // Every transfer that was started, in order
+    std::vector<i2c_bus::Transaction> _started{};
+
+  private:
+    static auto write(Device& device, const uint8_t* data, uint16_t length)
+        -> void {
+        for (uint16_t i = 0; i < length; ++i) {
+            device.registers.at(device.pointer++) = data[i];
+        }
+    }
+
+    static auto read(Device& device, uint8_t* data, uint16_t length)
+        -> void {
+        for (uint16_t i = 0; i < length; ++i) {
+            data[i] = device.registers.at(device.pointer++);
+        }
+    }
+
+    std::map<uint16_t, Device> _devices{};
+    std::optional<i2c_bus::Transaction> _active{};
+};
+
+}  // namespace i2c_bus_test_policy
@@ -30,6 +30,9 @@ class TestM24128Policy {
     auto i2c_write(uint8_t addr, Input data, size_t len) -> bool {
         // Ignore address for test purposes
         static_cast<void>(addr);
+        if (write_cycle_busy()) {
+            return false;
+        }
 
         if (len >= 2) {
             _data_pointer = (*data) << 8;
@@ -40,6 +43,10 @@ class TestM24128Policy {
         } else {
             return true;
         }
+        if (len > 0) {
+            ++_data_writes;
+            _busy_remaining = _busy_polls;
+        }
 
         if (_data_pointer >= _buffer.size()) {
             // Out of bounds write attempt
@@ -63,6 +70,10 @@ class TestM24128Policy {
     auto i2c_read(uint8_t addr, Input data, size_t len) -> bool {
         // Ignore address for test purposes
         static_cast<void>(addr);
+        if (write_cycle_busy()) {
+            return false;
+        }
+        ++_reads;
         // Data pointer is held over from the last transaction
         for (size_t i = 0; i < len; ++i, ++data) {
             *data = _buffer[_data_pointer++];
@@ -81,6 +92,23 @@ class TestM24128Policy {
     Buffer _buffer;
     size_t _data_pointer;
     bool _write_protect;
+    // Number of writes that carried data, and number of reads
+    size_t _data_writes = 0;
+    size_t _reads = 0;
+    // How many transfers the device NACKs after each data write, as if
+    // it were busy with its internal write cycle
+    size_t _busy_polls = 0;
+
+  private:
+    auto write_cycle_busy() -> bool {
+        if (_busy_remaining > 0) {
+            --_busy_remaining;
+            return true;
+        }
+        return false;
+    }
+
+    size_t _busy_remaining = 0;
 };
 
 }  // namespace m24128_test_policy
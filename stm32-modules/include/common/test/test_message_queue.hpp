@@ -3,6 +3,8 @@
 #include <deque>
 #include <stdexcept>
 
+#include "core/queue_stats.hpp"
+
 // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
 template <typename M, size_t Index = 0, size_t queue_size = 10>
 class TestMessageQueue {
@@ -12,18 +14,23 @@ class TestMessageQueue {
     bool act_full;
     std::string name;
     const static size_t index = Index;
+    // Tests can advance this to simulate time spent handling messages
+    uint32_t ticks = 0;
 
     struct Tag {};
 
     explicit TestMessageQueue(const std::string& name)
-        : backing_deque(), act_full(false), name(name) {}
+        : backing_deque(), act_full(false), name(name), stats() {}
 
     [[nodiscard]] auto try_send(const Message& message,
                                 const uint32_t timeout_ticks = 0) -> bool {
         if (act_full) {
+            stats.record_send(false, queue_size);
             return false;
         }
         backing_deque.push_back(message);
+        enqueue_ticks.push_back(ticks);
+        stats.record_send(true, backing_deque.size());
         return true;
     }
 
@@ -35,10 +42,13 @@ class TestMessageQueue {
 
     [[nodiscard]] auto try_recv(Message* message, uint32_t timeout_ticks = 0)
         -> bool {
+        stats.record_idle(ticks);
         if (backing_deque.empty()) {
             return false;
         } else {
             *message = backing_deque.front();
+            stats.record_receive(queue_stats::message_index(*message),
+                                 pop_enqueue_tick(), ticks);
             backing_deque.pop_front();
             return true;
         }
@@ -49,11 +59,36 @@ class TestMessageQueue {
             throw new std::runtime_error(
                 "don't do something that calls recv() with an empty buffer");
         }
+        stats.record_idle(ticks);
         *message = backing_deque.front();
+        stats.record_receive(queue_stats::message_index(*message),
+                             pop_enqueue_tick(), ticks);
         backing_deque.pop_front();
     }
 
     [[nodiscard]] auto has_message() const -> bool {
         return !backing_deque.empty();
     }
+
+    [[nodiscard]] auto get_stats() const -> queue_stats::Snapshot {
+        return stats.snapshot(1);
+    }
+    auto reset_stats() -> void { stats.reset(); }
+
+  private:
+    // Tests also push to and pop from backing_deque directly, which leaves
+    // the enqueue times out of step. A message without a matching enqueue
+    // time is counted as not having waited.
+    auto pop_enqueue_tick() -> uint32_t {
+        if (enqueue_ticks.size() != backing_deque.size()) {
+            enqueue_ticks.clear();
+            return ticks;
+        }
+        auto enqueued = enqueue_ticks.front();
+        enqueue_ticks.pop_front();
+        return enqueued;
+    }
+
+    std::deque<uint32_t> enqueue_ticks{};
+    queue_stats::QueueStats<Message, queue_size> stats;
 };
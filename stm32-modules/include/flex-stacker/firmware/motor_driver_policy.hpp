@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <optional>
+#include <span>
 
 #include "flex-stacker/tmc2160_interface.hpp"
 #include "systemwide.h"
@@ -12,6 +14,10 @@ class MotorDriverPolicy {
     using RxTxReturn = std::optional<tmc2160::MessageT>;
     auto tmc2160_transmit_receive(MotorID motor_id, tmc2160::MessageT& data)
         -> RxTxReturn;
+    auto tmc2160_transmit_receive_batch(MotorID motor_id,
+                                        std::span<tmc2160::MessageT> batch)
+        -> bool;
+    [[nodiscard]] auto get_time_ms() const -> uint32_t;
 };
 
 }  // namespace motor_driver_policy
@@ -9,10 +9,49 @@ extern "C" {
 
 #include "systemwide.h"
 
+/**
+ * Frequency that step schedules count at. This is much finer than the
+ * motor interrupt, so that scheduled steps can be closer together than the
+ * fastest moves need.
+ */
+#define STEP_SCHEDULE_FREQ (1000000)
+/**
+ * Shortest step pulse the TMC2160 accepts, in nanoseconds. The step input
+ * must be high for at least one driver clock plus 20ns, which is about
+ * 105ns on its internal 12MHz clock.
+ */
+#define DRIVER_MIN_STEP_PULSE_NS (110)
+/**
+ * Width of a step pulse from a step schedule, in step schedule ticks: the
+ * driver's minimum rounded up to whole ticks. Every reload value of a step
+ * schedule must be at least this, so that each period has a low part after
+ * its pulse.
+ */
+#define STEP_PULSE_TICKS                                                      \
+    (((DRIVER_MIN_STEP_PULSE_NS * (STEP_SCHEDULE_FREQ / 1000)) + 999999) /    \
+     1000000)
+
 void motor_hardware_init(void);
 void spi_hardware_init(void);
 bool motor_spi_sendreceive(MotorID motor_id, uint8_t *tx_data, uint8_t *rx_data,
                            uint16_t len);
+/**
+ * @brief Send several messages of \c len bytes to one motor driver back to
+ * back. The chip select is raised for the driver's minimum CSN high time
+ * between messages from the transfer complete interrupt, so the caller
+ * only blocks once for the whole batch.
+ */
+bool motor_spi_sendreceive_batch(MotorID motor_id, uint8_t *tx_data,
+                                 uint8_t *rx_data, uint16_t count,
+                                 uint16_t len);
+
+/**
+ * @brief Called from the DMA interrupt when a step schedule has finished
+ * with half of its buffer.
+ * @param motor_id The motor being stepped
+ * @param second_half True if the DMA has finished the second half
+ */
+typedef void (*step_schedule_callback_t)(MotorID motor_id, bool second_half);
 
 void hw_step_motor(MotorID motor_id);
 bool hw_enable_motor(MotorID motor_id);
@@ -22,6 +61,30 @@ void hw_set_direction(MotorID, bool direction);
 bool hw_read_limit_switch(MotorID motor_id, bool direction);
 void hw_set_diag0_irq(bool enable);
 
+/**
+ * @brief Start stepping a motor from a step schedule. The timer runs the
+ * first period, then DMA streams the schedule into its auto-reload register
+ * in a circle, calling step_schedule_callback as each half is finished
+ * with. Every timer period starts with a step pulse.
+ * @param motor_id The motor to step
+ * @param first_reload The reload value of the period before the first step
+ * @param schedule The reload values of the following periods
+ * @param length The number of entries in \c schedule, which must be even
+ * @return True if the schedule was started
+ */
+bool hw_start_step_schedule(MotorID motor_id, uint16_t first_reload,
+                            uint16_t *schedule, uint16_t length);
+/** Call the motor interrupt callback on every update of a step schedule.*/
+void hw_count_step_updates(MotorID motor_id);
+/** Stop step pulses from the next period of a step schedule.*/
+void hw_end_step_pulses(MotorID motor_id);
+/**
+ * @brief The number of transfers left before the DMA of a step schedule
+ * wraps back to the start of the schedule, read from the DMA channel.
+ */
+uint16_t hw_step_schedule_remaining(MotorID motor_id);
+void hw_set_step_schedule_callback(step_schedule_callback_t callback);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
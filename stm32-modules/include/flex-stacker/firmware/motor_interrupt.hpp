@@ -2,6 +2,8 @@
 #include <atomic>
 #include <cstdint>
 
+#include "core/step_schedule.hpp"
+#include "core/trace.hpp"
 #include "firmware/motor_hardware.h"
 #include "firmware/motor_policy.hpp"
 #include "flex-stacker/motor_utils.hpp"
@@ -17,6 +19,45 @@ static constexpr int DEFAULT_MOTOR_FREQ = 50;
 static constexpr double DEFAULT_VELOCITY = 64000;  // steps per second
 static constexpr double DEFAULT_ACCEL = 50000;     // steps per second^2
 
+// Fixed distance movements are stepped by a timer from a step schedule
+// streamed in by DMA, rather than by an interrupt per tick. The schedule
+// counts at its own, finer frequency, so its movements are profiled at that
+// frequency rather than the motor interrupt's.
+static constexpr uint32_t SCHEDULE_FREQ = STEP_SCHEDULE_FREQ;
+// The steps of a schedule must be no further apart than its longest
+// reload, so movements that start slower than this are still ticked.
+static constexpr uint32_t SCHEDULE_MIN_VELOCITY =
+    (SCHEDULE_FREQ + UINT16_MAX) / (UINT16_MAX + 1);  // steps per second
+// Each period of the step timer needs a tick after its pulse, so movements
+// that step more often than that at any point are still ticked too.
+static constexpr uint16_t SCHEDULE_MIN_TICKS = STEP_PULSE_TICKS + 1;
+static constexpr uint32_t SCHEDULE_MAX_VELOCITY =
+    SCHEDULE_FREQ / SCHEDULE_MIN_TICKS;  // steps per second
+static constexpr size_t SCHEDULE_LENGTH = 64;
+// One millisecond between the updates that watch for the end of a schedule
+static constexpr uint16_t SCHEDULE_TRAILING_TICKS = SCHEDULE_FREQ / 1000;
+
+/**
+ * @brief Whether a fixed distance movement is stepped from a step schedule
+ * rather than by the motor interrupt.
+ * @param steps_per_sec_discont The starting velocity of the movement
+ * @param steps_per_sec The peak velocity of the movement
+ */
+[[nodiscard]] constexpr auto schedulable(uint32_t steps_per_sec_discont,
+                                         uint32_t steps_per_sec) -> bool {
+    return steps_per_sec_discont >= SCHEDULE_MIN_VELOCITY &&
+           steps_per_sec_discont <= SCHEDULE_MAX_VELOCITY &&
+           steps_per_sec <= SCHEDULE_MAX_VELOCITY;
+}
+
+static_assert(schedulable(SCHEDULE_MIN_VELOCITY,
+                          static_cast<uint32_t>(DEFAULT_VELOCITY)),
+              "Moves at the default velocity must be scheduled");
+
+using Schedule =
+    step_schedule::StepSchedule<motor_util::MovementProfile, SCHEDULE_LENGTH,
+                                SCHEDULE_TRAILING_TICKS, SCHEDULE_MIN_TICKS>;
+
 class MotorInterruptController {
   public:
     explicit MotorInterruptController(MotorID id, MotorPolicy* policy)
@@ -32,9 +73,13 @@ class MotorInterruptController {
     ~MotorInterruptController() = default;
 
     auto tick() -> bool {
+        auto trace_scope = trace::Scope(trace::MOTOR_INTERRUPT_TICK);
         if (!_initialized) {
             return false;
         }
+        if (_scheduled) {
+            return schedule_update();
+        }
         auto ret = _profile.tick();
         if (ret.step && !stop_condition_met()) {
             _policy->step(_id);
@@ -60,11 +105,21 @@ class MotorInterruptController {
         -> void {
         _stop = false;
         set_direction(direction);
+        _response_id = move_id;
+        if (schedulable(steps_per_sec_discont, steps_per_sec)) {
+            _profile = motor_util::MovementProfile(
+                SCHEDULE_FREQ, steps_per_sec_discont, steps_per_sec,
+                step_per_sec_sq, motor_util::MovementType::FixedDistance,
+                steps);
+            if (_schedule.start(_profile)) {
+                start_schedule();
+                return;
+            }
+        }
         _profile = motor_util::MovementProfile(
             TIMER_FREQ, steps_per_sec_discont, steps_per_sec, step_per_sec_sq,
             motor_util::MovementType::FixedDistance, steps);
         _policy->enable_motor(_id);
-        _response_id = move_id;
     }
     auto start_movement(uint32_t move_id, bool direction,
                         uint32_t steps_per_sec_discont, uint32_t steps_per_sec,
@@ -79,6 +134,7 @@ class MotorInterruptController {
     }
     auto stop_movement(uint32_t move_id, bool disable_motor) -> void {
         _stop = true;
+        _scheduled = false;
         disable_motor ? _policy->disable_motor(_id) : _policy->stop_motor(_id);
         _response_id = move_id;
     }
@@ -93,6 +149,12 @@ class MotorInterruptController {
     [[nodiscard]] auto get_response_id() const -> uint32_t {
         return _response_id;
     }
+    /** The velocity of a movement that isn't scheduled, in steps/s.*/
+    [[nodiscard]] auto velocity() const -> double {
+        return static_cast<double>(_profile.current_velocity()) /
+               static_cast<double>(1ULL << motor_util::MovementProfile::radix) *
+               TIMER_FREQ;
+    }
     auto stop_condition_met() -> bool {
         if (_stop) {
             return true;
@@ -105,7 +167,87 @@ class MotorInterruptController {
 
     auto set_diag0_irq(bool enable) -> void { _policy->set_diag0_irq(enable); }
 
+    /**
+     * @brief Refill the step schedule, called when the DMA has finished
+     * with half of it.
+     * @param second_half True if the DMA has just finished the second half
+     */
+    auto schedule_refill(bool second_half) -> void {
+        if (!_scheduled) {
+            return;
+        }
+        _schedule.refill(second_half);
+        sync_transfers();
+        if (_schedule.finished() && !_counting) {
+            start_counting();
+        }
+    }
+
   private:
+    auto start_schedule() -> void {
+        _scheduled = true;
+        _counting = false;
+        _pulses_ended = false;
+        _transfers = 0;
+        _dma_position = 0;
+        _policy->start_step_schedule(_id, _schedule.first_reload(),
+                                     _schedule.buffer().data(),
+                                     _schedule.buffer().size());
+        if (_schedule.finished()) {
+            start_counting();
+        }
+    }
+
+    // Bring the count of DMA transfers up to date from the position of the
+    // DMA channel. Each transfer happens on a timer update, so this is also
+    // the count of updates so far. Reading the channel rather than counting
+    // interrupts keeps the count right however late an interrupt runs, as
+    // long as the DMA hasn't gone all the way round the schedule since the
+    // last read.
+    auto sync_transfers() -> void {
+        auto length = static_cast<uint32_t>(_schedule.buffer().size());
+        auto remaining = _policy->step_schedule_remaining(_id);
+        auto position = (length - remaining) % length;
+        _transfers += (position + length - _dma_position) % length;
+        _dma_position = position;
+    }
+
+    // Each update starts a step, so the pulses are stopped from the period
+    // after the last one
+    auto end_pulses_after_last_step() -> void {
+        if (!_pulses_ended && _transfers >= _schedule.steps()) {
+            _policy->end_step_pulses(_id);
+            _pulses_ended = true;
+        }
+    }
+
+    // Once the last step is scheduled, watch every timer update for it
+    auto start_counting() -> void {
+        _counting = true;
+        _policy->count_step_updates(_id);
+        sync_transfers();
+        end_pulses_after_last_step();
+    }
+
+    // Called on every timer update once the last step is scheduled. The
+    // motor is stopped once the period after the last step is over.
+    auto schedule_update() -> bool {
+        if (!_counting) {
+            return false;
+        }
+        sync_transfers();
+        end_pulses_after_last_step();
+        if (_transfers <= _schedule.steps()) {
+            return false;
+        }
+        _scheduled = false;
+        _policy->stop_motor(_id);
+        if (_id == MotorID::MOTOR_Z) {
+            _policy->disable_motor(_id);
+        }
+        return true;
+    }
+
     MotorID _id;
     MotorPolicy* _policy;
     std::atomic_bool _initialized;
@@ -115,6 +257,16 @@ class MotorInterruptController {
     uint32_t _response_id = 0;
     bool _direction = false;
     bool _stop = false;
+    Schedule _schedule{};
+    // Whether the current movement is stepped by the schedule
+    std::atomic_bool _scheduled = false;
+    // Whether the last step is scheduled and updates are being watched
+    bool _counting = false;
+    bool _pulses_ended = false;
+    // DMA transfers, and so timer updates, since the schedule started
+    uint32_t _transfers = 0;
+    // Where the DMA was in the schedule when the transfers were counted
+    uint32_t _dma_position = 0;
 };
 
 }  // namespace motor_interrupt_controller
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 #include "systemwide.h"
@@ -15,6 +16,11 @@ class MotorPolicy {
     auto set_direction(MotorID motor_id, bool direction) -> void;
     auto check_limit_switch(MotorID motor_id, bool direction) -> bool;
     auto set_diag0_irq(bool enable) -> void;
+    auto start_step_schedule(MotorID motor_id, uint16_t first_reload,
+                             uint16_t* schedule, size_t length) -> bool;
+    auto count_step_updates(MotorID motor_id) -> void;
+    auto end_step_pulses(MotorID motor_id) -> void;
+    auto step_schedule_remaining(MotorID motor_id) -> uint16_t;
 };
 
 }  // namespace motor_policy
@@ -26,7 +26,12 @@ enum class ErrorCode {
     // 4xx - Motor Errors
     MOTOR_ENABLE_FAILED = 401,
     MOTOR_DISABLE_FAILED = 402,
-    MOTOR_STALL_DETECTED = 403
+    MOTOR_STALL_DETECTED = 403,
+    MOTOR_BUSY = 404,
+    MOTOR_STALL_NOT_CALIBRATED = 405,
+    MOTOR_STALL_CALIBRATION_FAILED = 406,
+    MOTOR_STALL_NOT_DETECTED = 407,
+    MOTOR_STALL_BELOW_VELOCITY = 408
 };
 
 auto errorstring(ErrorCode code) -> const char*;
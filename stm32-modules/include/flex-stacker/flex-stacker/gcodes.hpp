@@ -16,6 +16,7 @@
 #include <utility>
 
 #include "core/gcode_parser.hpp"
+#include "core/task_stats_gcode.hpp"
 #include "core/utility.hpp"
 #include "flex-stacker/errors.hpp"
 #include "flex-stacker/gcodes_motor.hpp"
@@ -232,4 +233,99 @@ struct GetBoardRevision {
     }
 };
 
+struct GetTraceDebug {
+    /**
+     * GetTraceDebug uses M931.D to control and read out the trace buffer
+     * (see core/trace.hpp).
+     *
+     * M931.D E\n clears the buffer and starts recording.
+     *
+     * M931.D S<index>\n pauses recording and returns up to
+     * EVENTS_PER_RESPONSE events starting at <index>, oldest first:
+     *
+     *   M931.D T:<ticks per us> N:<event count> S:<index> <events> OK
+     *
+     * where each event is <timestamp>:<id><phase>, with the timestamp and
+     * id in hex and the phase one of B (begin), E (end) or i (instant).
+     * Plain M931.D is the same as M931.D S0.
+     */
+    using ParseResult = std::optional<GetTraceDebug>;
+    static constexpr auto prefix = std::array{'M', '9', '3', '1', '.', 'D'};
+    static constexpr auto start_prefix = std::array{' ', 'E'};
+    static constexpr auto index_prefix = std::array{' ', 'S'};
+    static constexpr const char* start_response = "M931.D OK\n";
+    static constexpr size_t EVENTS_PER_RESPONSE = 8;
+
+    bool start_recording = false;
+    uint16_t index = 0;
+
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        auto working = prefix_matches(input, limit, prefix);
+        if (working == input) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto after_start = prefix_matches(working, limit, start_prefix);
+        if (after_start != working) {
+            return std::make_pair(
+                ParseResult(GetTraceDebug{.start_recording = true}),
+                after_start);
+        }
+        auto after_index = prefix_matches(working, limit, index_prefix);
+        if (after_index != working) {
+            auto index = parse_value<uint16_t>(after_index, limit);
+            if (!index.first.has_value()) {
+                return std::make_pair(ParseResult(), input);
+            }
+            return std::make_pair(
+                ParseResult(GetTraceDebug{.index = index.first.value()}),
+                index.second);
+        }
+        return std::make_pair(ParseResult(GetTraceDebug()), working);
+    }
+
+    template <typename InputIt, typename InLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputIt, InLimit>
+    static auto write_response_into(InputIt buf, InLimit limit) -> InputIt {
+        return write_string_to_iterpair(buf, limit, start_response);
+    }
+
+    template <typename InputIt, typename InLimit, typename TraceBuffer>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputIt, InLimit>
+    auto write_response_into(InputIt buf, InLimit limit,
+                             const TraceBuffer& trace,
+                             uint32_t ticks_per_us) const -> InputIt {
+        auto count = trace.count();
+        auto res = snprintf(&*buf, (limit - buf), "M931.D T:%u N:%u S:%u",
+                            static_cast<unsigned>(ticks_per_us),
+                            static_cast<unsigned>(count),
+                            static_cast<unsigned>(index));
+        if (res <= 0) {
+            return buf;
+        }
+        buf += std::min(static_cast<decltype(limit - buf)>(res),
+                        (limit - buf));
+        auto end = std::min(count, static_cast<size_t>(index) +
+                                       EVENTS_PER_RESPONSE);
+        for (size_t i = index; i < end; ++i) {
+            auto event = trace.at(i);
+            res = snprintf(&*buf, (limit - buf), " %08x:%04x%c",
+                           static_cast<unsigned>(event.timestamp),
+                           static_cast<unsigned>(event.id),
+                           static_cast<char>(event.phase));
+            if (res <= 0) {
+                return buf;
+            }
+            buf += std::min(static_cast<decltype(limit - buf)>(res),
+                            (limit - buf));
+        }
+        return write_string_to_iterpair(buf, limit, " OK\n");
+    }
+};
+
 }  // namespace gcode
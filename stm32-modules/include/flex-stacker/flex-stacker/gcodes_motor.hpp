@@ -17,6 +17,7 @@
 #include "core/gcode_parser.hpp"
 #include "core/utility.hpp"
 #include "flex-stacker/errors.hpp"
+#include "flex-stacker/tmc_capture.hpp"
 #include "systemwide.h"
 
 namespace gcode {
@@ -786,9 +787,18 @@ struct GetMoveParams {
 };
 
 struct SetMotorStallGuard {
+    /**
+     * SetMotorStallGuard uses M910 to configure StallGuard on a motor.
+     *
+     * M910 X<enable> T<sgt> V<velocity>\n enables or disables stall
+     * detection on the X motor, with an optional threshold and the slowest
+     * velocity in mm/s at which a stall is trusted. The threshold and
+     * velocity are the ones reported by M913.
+     */
     MotorID motor_id;
     bool enable;
     std::optional<int32_t> sgt;
+    std::optional<float> min_velocity;
 
     using ParseResult = std::optional<SetMotorStallGuard>;
     static constexpr auto prefix = std::array{'M', '9', '1', '0', ' '};
@@ -803,14 +813,16 @@ struct SetMotorStallGuard {
         bool present = false;
         int value = 0;
     };
+    using VelArg = Arg<float, 'V'>;
 
     template <typename InputIt, typename Limit>
     requires std::forward_iterator<InputIt> &&
         std::sized_sentinel_for<Limit, InputIt>
     static auto parse(const InputIt& input, Limit limit)
         -> std::pair<ParseResult, InputIt> {
-        auto res = gcode::SingleParser<XArg, ZArg, LArg, SGTArg>::parse_gcode(
-            input, limit, prefix);
+        auto res =
+            gcode::SingleParser<XArg, ZArg, LArg, SGTArg,
+                                VelArg>::parse_gcode(input, limit, prefix);
         if (!res.first.has_value()) {
             return std::make_pair(ParseResult(), input);
         }
@@ -818,6 +830,7 @@ struct SetMotorStallGuard {
             .motor_id = MotorID::MOTOR_X,
             .enable = false,
             .sgt = std::nullopt,
+            .min_velocity = std::nullopt,
         };
 
         auto arguments = res.first.value();
@@ -836,6 +849,9 @@ struct SetMotorStallGuard {
         if (std::get<3>(arguments).present) {
             ret.sgt = std::get<3>(arguments).value;
         }
+        if (std::get<4>(arguments).present) {
+            ret.min_velocity = std::get<4>(arguments).value;
+        }
         return std::make_pair(ret, res.second);
     }
 
@@ -898,4 +914,246 @@ struct GetMotorStallGuard {
     }
 };
 
+struct StreamTMCRegisters {
+    /**
+     * StreamTMCRegisters uses M912 to stream the load and step registers of
+     * a motor's driver to the host, for tuning StallGuard.
+     *
+     * M912 X<period>\n starts sampling the X motor every <period> ms, and
+     * M912 X0\n stops it. Z and L select the other motors.
+     *
+     * Samples are sent in batches, without being requested, as
+     *
+     *   M912 <motor> N:<first> D:<dropped> <samples> OK
+     *
+     * where <first> is the number of the first sample in the batch counted
+     * from the start of the stream, <dropped> is the total number of samples
+     * dropped so far, and each sample is SG_RESULT, CS_ACTUAL and TSTEP as
+     * 3, 2 and 5 hex digits with no separator.
+     */
+    MotorID motor_id;
+    uint32_t period_ms;
+
+    using ParseResult = std::optional<StreamTMCRegisters>;
+    static constexpr auto prefix = std::array{'M', '9', '1', '2', ' '};
+    static constexpr const char* response = "M912 OK\n";
+
+    using XArg = Arg<uint32_t, 'X'>;
+    using ZArg = Arg<uint32_t, 'Z'>;
+    using LArg = Arg<uint32_t, 'L'>;
+
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        auto res = gcode::SingleParser<XArg, ZArg, LArg>::parse_gcode(
+            input, limit, prefix);
+        if (!res.first.has_value()) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto ret =
+            StreamTMCRegisters{.motor_id = MotorID::MOTOR_X, .period_ms = 0};
+
+        auto arguments = res.first.value();
+        if (std::get<0>(arguments).present) {
+            ret.period_ms = std::get<0>(arguments).value;
+        } else if (std::get<1>(arguments).present) {
+            ret.motor_id = MotorID::MOTOR_Z;
+            ret.period_ms = std::get<1>(arguments).value;
+        } else if (std::get<2>(arguments).present) {
+            ret.motor_id = MotorID::MOTOR_L;
+            ret.period_ms = std::get<2>(arguments).value;
+        } else {
+            return std::make_pair(ParseResult(), input);
+        }
+        return std::make_pair(ret, res.second);
+    }
+
+    template <typename InputIt, typename InLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputIt, InLimit>
+    static auto write_response_into(InputIt buf, InLimit limit) -> InputIt {
+        return write_string_to_iterpair(buf, limit, response);
+    }
+
+    template <typename InputIt, typename InLimit, size_t Capacity>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputIt, InLimit>
+    static auto write_batch_into(InputIt buf, InLimit limit,
+                                 const tmc_capture::Capture<Capacity>& capture,
+                                 const tmc_capture::Batch& batch) -> InputIt {
+        auto res = snprintf(&*buf, (limit - buf), "M912 %s N:%lu D:%lu",
+                            motor_id_to_char(batch.motor_id),
+                            static_cast<unsigned long>(batch.first),
+                            static_cast<unsigned long>(batch.dropped));
+        if (res <= 0) {
+            return buf;
+        }
+        buf += std::min(static_cast<decltype(limit - buf)>(res),
+                        (limit - buf));
+        for (size_t i = 0; i < batch.count; ++i) {
+            const auto& sample = capture.sample(batch, i);
+            res = snprintf(&*buf, (limit - buf), " %03x%02x%05lx",
+                           static_cast<unsigned>(sample.sg_result),
+                           static_cast<unsigned>(sample.cs_actual),
+                           static_cast<unsigned long>(sample.tstep));
+            if (res <= 0) {
+                return buf;
+            }
+            buf += std::min(static_cast<decltype(limit - buf)>(res),
+                            (limit - buf));
+        }
+        return write_string_to_iterpair(buf, limit, " OK\n");
+    }
+};
+
+struct CalibrateStallGuard {
+    /**
+     * CalibrateStallGuard uses M913 to find the StallGuard threshold of a
+     * motor. The motor moves to its retract limit switch and then back and
+     * forth between the limit switches at a range of velocities, while the
+     * threshold is adjusted until the unloaded motor reads well clear of a
+     * stall. Nothing may block the axis while it runs.
+     *
+     * M913 X\n calibrates the X motor, and Z and L select the others. The
+     * response is
+     *
+     *   M913 <motor> T:<sgt> V:<min velocity> H:<home velocity> OK
+     *
+     * where the velocities are in mm/s. Pass the threshold and the minimum
+     * velocity to M910 to enable stall detection with them, and home against
+     * a stall with G6 at the home velocity.
+     */
+    MotorID motor_id;
+    using ParseResult = std::optional<CalibrateStallGuard>;
+    static constexpr auto prefix = std::array{'M', '9', '1', '3'};
+
+    using ArgX = ArgNoVal<'X'>;
+    using ArgZ = ArgNoVal<'Z'>;
+    using ArgL = ArgNoVal<'L'>;
+
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        MotorID motor = MotorID::MOTOR_X;
+        auto res = gcode::SingleParser<ArgX, ArgZ, ArgL>::parse_gcode(
+            input, limit, prefix);
+        if (!res.first.has_value()) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto arguments = res.first.value();
+        if (std::get<1>(arguments).present) {
+            motor = MotorID::MOTOR_Z;
+        } else if (std::get<2>(arguments).present) {
+            motor = MotorID::MOTOR_L;
+        } else if (!std::get<0>(arguments).present) {
+            return std::make_pair(ParseResult(), input);
+        }
+        return std::make_pair(
+            ParseResult(CalibrateStallGuard{.motor_id = motor}), res.second);
+    }
+
+    template <typename InputIt, typename InLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputIt, InLimit>
+    static auto write_response_into(InputIt buf, InLimit limit,
+                                    MotorID motor_id, int threshold,
+                                    float min_velocity, float home_velocity)
+        -> InputIt {
+        auto res =
+            snprintf(&*buf, (limit - buf), "M913 %s T:%d V:%.2f H:%.2f OK\n",
+                     motor_id_to_char(motor_id), threshold,
+                     static_cast<double>(min_velocity),
+                     static_cast<double>(home_velocity));
+        if (res <= 0) {
+            return buf;
+        }
+        return buf + std::min(static_cast<decltype(limit - buf)>(res),
+                              (limit - buf));
+    }
+};
+
+struct MoveToStall {
+    /**
+     * MoveToStall uses G6 to move a motor until it stalls, for homing without
+     * a limit switch. It takes the same arguments as G5, and stall detection
+     * must be enabled on the motor with M910, with a minimum velocity below
+     * the velocity of the move. The limit switch in the direction of travel
+     * still ends the move if the motor never stalls, and the move is then
+     * acknowledged with ERR407, or with ERR408 if the motor stalled below
+     * the minimum velocity on the way.
+     */
+    MotorID motor_id;
+    bool direction;
+    std::optional<float> mm_per_second, mm_per_second_sq, mm_per_second_discont;
+
+    using ParseResult = std::optional<MoveToStall>;
+    static constexpr auto prefix = std::array{'G', '6', ' '};
+    static constexpr const char* response = "G6 OK\n";
+
+    using XArg = Arg<int, 'X'>;
+    using ZArg = Arg<int, 'Z'>;
+    using LArg = Arg<int, 'L'>;
+    using VelArg = Arg<float, 'V'>;
+    using AccelArg = Arg<float, 'A'>;
+    using DiscontArg = Arg<float, 'D'>;
+
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        auto res =
+            gcode::SingleParser<XArg, ZArg, LArg, VelArg, AccelArg,
+                                DiscontArg>::parse_gcode(input, limit, prefix);
+        if (!res.first.has_value()) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto ret = MoveToStall{
+            .motor_id = MotorID::MOTOR_X,
+            .direction = false,
+            .mm_per_second = std::nullopt,
+            .mm_per_second_sq = std::nullopt,
+            .mm_per_second_discont = std::nullopt,
+        };
+
+        auto arguments = res.first.value();
+        if (std::get<0>(arguments).present) {
+            ret.direction = static_cast<bool>(std::get<0>(arguments).value);
+        } else if (std::get<1>(arguments).present) {
+            ret.motor_id = MotorID::MOTOR_Z;
+            ret.direction = static_cast<bool>(std::get<1>(arguments).value);
+        } else if (std::get<2>(arguments).present) {
+            ret.motor_id = MotorID::MOTOR_L;
+            ret.direction = static_cast<bool>(std::get<2>(arguments).value);
+        } else {
+            return std::make_pair(ParseResult(), input);
+        }
+
+        if (std::get<3>(arguments).present) {
+            ret.mm_per_second = std::get<3>(arguments).value;
+        } else {
+            return std::make_pair(ParseResult(), input);
+        }
+
+        if (std::get<4>(arguments).present) {
+            ret.mm_per_second_sq = std::get<4>(arguments).value;
+        }
+        if (std::get<5>(arguments).present) {
+            ret.mm_per_second_discont = std::get<5>(arguments).value;
+        }
+        return std::make_pair(ret, res.second);
+    }
+
+    template <typename InputIt, typename InLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputIt, InLimit>
+    static auto write_response_into(InputIt buf, InLimit limit) -> InputIt {
+        return write_string_to_iterpair(buf, limit, response);
+    }
+};
+
 }  // namespace gcode
@@ -11,6 +11,7 @@
 
 #include "core/ack_cache.hpp"
 #include "core/gcode_parser.hpp"
+#include "core/trace.hpp"
 #include "core/version.hpp"
 #include "flex-stacker/errors.hpp"
 #include "flex-stacker/gcodes.hpp"
@@ -45,19 +46,23 @@ class HostCommsTask {
         gcode::SetHoldCurrent, gcode::EnableMotor, gcode::DisableMotor,
         gcode::MoveMotorInSteps, gcode::MoveToLimitSwitch, gcode::MoveMotorInMm,
         gcode::GetLimitSwitches, gcode::SetMicrosteps, gcode::GetMoveParams,
-        gcode::SetMotorStallGuard, gcode::GetMotorStallGuard>;
+        gcode::SetMotorStallGuard, gcode::GetMotorStallGuard,
+        gcode::StreamTMCRegisters, gcode::CalibrateStallGuard,
+        gcode::MoveToStall, gcode::GetTaskStatsDebug, gcode::GetTraceDebug>;
     using AckOnlyCache =
         AckCache<8, gcode::EnterBootloader, gcode::SetSerialNumber,
                  gcode::SetTMCRegister, gcode::SetRunCurrent,
                  gcode::SetHoldCurrent, gcode::EnableMotor, gcode::DisableMotor,
                  gcode::MoveMotorInSteps, gcode::MoveToLimitSwitch,
                  gcode::MoveMotorInMm, gcode::SetMicrosteps,
-                 gcode::SetMotorStallGuard>;
+                 gcode::SetMotorStallGuard, gcode::StreamTMCRegisters,
+                 gcode::MoveToStall>;
     using GetSystemInfoCache = AckCache<8, gcode::GetSystemInfo>;
     using GetTMCRegisterCache = AckCache<8, gcode::GetTMCRegister>;
     using GetLimitSwitchesCache = AckCache<8, gcode::GetLimitSwitches>;
     using GetMoveParamsCache = AckCache<8, gcode::GetMoveParams>;
     using GetMotorStallGuardCache = AckCache<8, gcode::GetMotorStallGuard>;
+    using CalibrateStallGuardCache = AckCache<8, gcode::CalibrateStallGuard>;
 
   public:
     static constexpr size_t TICKS_TO_WAIT_ON_SEND = 10;
@@ -76,7 +81,9 @@ class HostCommsTask {
           // NOLINTNEXTLINE(readability-redundant-member-init)
           get_move_params_cache(),
           // NOLINTNEXTLINE(readability-redundant-member-init)
-          get_motor_stall_guard_cache() {}
+          get_motor_stall_guard_cache(),
+          // NOLINTNEXTLINE(readability-redundant-member-init)
+          calibrate_stall_guard_cache() {}
     HostCommsTask(const HostCommsTask& other) = delete;
     auto operator=(const HostCommsTask& other) -> HostCommsTask& = delete;
     HostCommsTask(HostCommsTask&& other) noexcept = delete;
@@ -710,7 +717,9 @@ class HostCommsTask {
             messages::SetMotorStallGuardMessage{.id = id,
                                                 .motor_id = gcode.motor_id,
                                                 .enable = gcode.enable,
-                                                .sgt = gcode.sgt};
+                                                .sgt = gcode.sgt,
+                                                .min_velocity =
+                                                    gcode.min_velocity};
         if (!task_registry->send(message, TICKS_TO_WAIT_ON_SEND)) {
             auto wrote_to = errors::write_into(
                 tx_into, tx_limit, errors::ErrorCode::INTERNAL_QUEUE_FULL);
@@ -765,6 +774,161 @@ class HostCommsTask {
             cache_entry);
     }
 
+    template <typename InputIt, typename InputLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputLimit, InputIt>
+    auto visit_gcode(const gcode::CalibrateStallGuard& gcode, InputIt tx_into,
+                     InputLimit tx_limit) -> std::pair<bool, InputIt> {
+        auto id = calibrate_stall_guard_cache.add(gcode);
+        if (id == 0) {
+            return std::make_pair(
+                false, errors::write_into(tx_into, tx_limit,
+                                          errors::ErrorCode::GCODE_CACHE_FULL));
+        }
+        auto message = messages::CalibrateStallGuardMessage{
+            .id = id, .motor_id = gcode.motor_id};
+        if (!task_registry->send(message, TICKS_TO_WAIT_ON_SEND)) {
+            auto wrote_to = errors::write_into(
+                tx_into, tx_limit, errors::ErrorCode::INTERNAL_QUEUE_FULL);
+            calibrate_stall_guard_cache.remove_if_present(id);
+            return std::make_pair(false, wrote_to);
+        }
+        return std::make_pair(true, tx_into);
+    }
+
+    template <typename InputIt, typename InputLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputLimit, InputIt>
+    auto visit_message(const messages::CalibrateStallGuardResponse& response,
+                       InputIt tx_into, InputLimit tx_limit) -> InputIt {
+        auto cache_entry = calibrate_stall_guard_cache.remove_if_present(
+            response.responding_to_id);
+        return std::visit(
+            [tx_into, tx_limit, response](auto cache_element) {
+                using T = std::decay_t<decltype(cache_element)>;
+                if constexpr (std::is_same_v<std::monostate, T>) {
+                    return errors::write_into(
+                        tx_into, tx_limit,
+                        errors::ErrorCode::BAD_MESSAGE_ACKNOWLEDGEMENT);
+                } else if (response.with_error !=
+                           errors::ErrorCode::NO_ERROR) {
+                    return errors::write_into(tx_into, tx_limit,
+                                              response.with_error);
+                } else {
+                    return cache_element.write_response_into(
+                        tx_into, tx_limit, response.motor_id, response.sgt,
+                        response.min_velocity, response.home_velocity);
+                }
+            },
+            cache_entry);
+    }
+
+    template <typename InputIt, typename InputLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputLimit, InputIt>
+    auto visit_gcode(const gcode::MoveToStall& gcode, InputIt tx_into,
+                     InputLimit tx_limit) -> std::pair<bool, InputIt> {
+        auto id = ack_only_cache.add(gcode);
+        if (id == 0) {
+            return std::make_pair(
+                false, errors::write_into(tx_into, tx_limit,
+                                          errors::ErrorCode::GCODE_CACHE_FULL));
+        }
+        auto message = messages::MoveToStallMessage{
+            .id = id,
+            .motor_id = gcode.motor_id,
+            .direction = gcode.direction,
+            .mm_per_second = gcode.mm_per_second,
+            .mm_per_second_sq = gcode.mm_per_second_sq,
+            .mm_per_second_discont = gcode.mm_per_second_discont};
+        if (!task_registry->send(message, TICKS_TO_WAIT_ON_SEND)) {
+            auto wrote_to = errors::write_into(
+                tx_into, tx_limit, errors::ErrorCode::INTERNAL_QUEUE_FULL);
+            ack_only_cache.remove_if_present(id);
+            return std::make_pair(false, wrote_to);
+        }
+        return std::make_pair(true, tx_into);
+    }
+
+    template <typename InputIt, typename InputLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputLimit, InputIt>
+    auto visit_gcode(const gcode::StreamTMCRegisters& gcode, InputIt tx_into,
+                     InputLimit tx_limit) -> std::pair<bool, InputIt> {
+        auto id = ack_only_cache.add(gcode);
+        if (id == 0) {
+            return std::make_pair(
+                false, errors::write_into(tx_into, tx_limit,
+                                          errors::ErrorCode::GCODE_CACHE_FULL));
+        }
+        auto sent = false;
+        if (gcode.period_ms == 0) {
+            sent = task_registry->send(
+                messages::StopPollTMCRegisterMessage{.id = id},
+                TICKS_TO_WAIT_ON_SEND);
+        } else {
+            sent = task_registry->send(
+                messages::PollTMCRegisterMessage{.id = id,
+                                                 .motor_id = gcode.motor_id,
+                                                 .period_ms = gcode.period_ms},
+                TICKS_TO_WAIT_ON_SEND);
+        }
+        if (!sent) {
+            auto wrote_to = errors::write_into(
+                tx_into, tx_limit, errors::ErrorCode::INTERNAL_QUEUE_FULL);
+            ack_only_cache.remove_if_present(id);
+            return std::make_pair(false, wrote_to);
+        }
+        return std::make_pair(true, tx_into);
+    }
+
+    template <typename InputIt, typename InputLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputLimit, InputIt>
+    auto visit_message(const messages::TMCCaptureBatchMessage& message,
+                       InputIt tx_into, InputLimit tx_limit) -> InputIt {
+        auto wrote_to = gcode::StreamTMCRegisters::write_batch_into(
+            tx_into, tx_limit, *message.capture, message.batch);
+        message.capture->release(message.batch);
+        return wrote_to;
+    }
+
+    template <typename InputIt, typename InputLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputLimit, InputIt>
+    auto visit_gcode(const gcode::GetTaskStatsDebug& gcode, InputIt tx_into,
+                     InputLimit tx_limit) -> std::pair<bool, InputIt> {
+        // Queue statistics are kept atomically by each queue, so they can
+        // be read directly without messaging the other tasks.
+        std::array<const char*, Aggregator::TaskCount> names{};
+        names.at(Queues::MotorDriverAddress) = "Driver";
+        names.at(Queues::MotorAddress) = "Motor";
+        names.at(Queues::HostCommsAddress) = "Comms";
+        auto wrote_to = gcode.write_response_into(
+            tx_into, tx_limit, names, task_registry->get_all_stats());
+        return std::make_pair(true, wrote_to);
+    }
+
+    template <typename InputIt, typename InputLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputLimit, InputIt>
+    auto visit_gcode(const gcode::GetTraceDebug& gcode, InputIt tx_into,
+                     InputLimit tx_limit) -> std::pair<bool, InputIt> {
+        auto& buffer = trace::get_buffer();
+        if (gcode.start_recording) {
+            buffer.clear();
+            buffer.set_enabled(true);
+            return std::make_pair(
+                true, gcode.write_response_into(tx_into, tx_limit));
+        }
+        // The ring is read out over several commands, so stop recording
+        // to keep it consistent until the next start.
+        buffer.set_enabled(false);
+        auto wrote_to = gcode.write_response_into(tx_into, tx_limit, buffer,
+                                                  trace::ticks_per_us());
+        return std::make_pair(true, wrote_to);
+    }
+
     // Our error handler just writes an error and bails
     template <typename InputIt, typename InputLimit>
     requires std::forward_iterator<InputIt> &&
@@ -785,6 +949,7 @@ class HostCommsTask {
     GetLimitSwitchesCache get_limit_switches_cache;
     GetMoveParamsCache get_move_params_cache;
     GetMotorStallGuardCache get_motor_stall_guard_cache;
+    CalibrateStallGuardCache calibrate_stall_guard_cache;
     bool may_connect_latch = true;
 };
 
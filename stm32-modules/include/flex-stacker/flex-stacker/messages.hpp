@@ -6,6 +6,7 @@
 #include <variant>
 
 #include "flex-stacker/errors.hpp"
+#include "flex-stacker/tmc_capture.hpp"
 #include "systemwide.h"
 
 namespace messages {
@@ -116,16 +117,25 @@ struct GetTMCRegisterMessage {
     uint8_t reg;
 };
 
+// Start streaming the load and step registers of a motor to the host
 struct PollTMCRegisterMessage {
     uint32_t id;
     MotorID motor_id;
-    uint8_t reg;
+    uint32_t period_ms;
 };
 
 struct StopPollTMCRegisterMessage {
     uint32_t id;
 };
 
+// A batch of samples from a register stream, sent without being requested.
+// The samples stay in the capture's ring buffer, and the receiver must
+// release the batch once it has written them out.
+struct TMCCaptureBatchMessage {
+    tmc_capture::Capture<>* capture;
+    tmc_capture::Batch batch;
+};
+
 struct GetTMCRegisterResponse {
     uint32_t responding_to_id;
     MotorID motor_id;
@@ -212,6 +222,10 @@ struct GetMoveParamsResponse {
 // Message to enable/disable the diag0 pin
 struct SetDiag0IRQMessage {
     bool enable;
+    MotorID motor_id = MotorID::MOTOR_X;
+    // The slowest velocity, in mm/s, at which a stall of this motor is
+    // trusted when homing against one
+    std::optional<float> min_velocity = std::nullopt;
 };
 
 // Message sent when there is an irq on the diag0 line
@@ -225,6 +239,7 @@ struct SetMotorStallGuardMessage {
     MotorID motor_id = MotorID::MOTOR_X;
     bool enable = false;
     std::optional<int32_t> sgt = std::nullopt;
+    std::optional<float> min_velocity = std::nullopt;
 };
 
 struct GetMotorStallGuardMessage {
@@ -239,11 +254,52 @@ struct GetMotorStallGuardResponse {
     int sgt;
 };
 
+struct CalibrateStallGuardMessage {
+    uint32_t id = 0;
+    MotorID motor_id = MotorID::MOTOR_X;
+};
+
+struct CalibrateStallGuardResponse {
+    uint32_t responding_to_id;
+    MotorID motor_id;
+    errors::ErrorCode with_error = errors::ErrorCode::NO_ERROR;
+    int sgt = 0;
+    float min_velocity = 0.0F;
+    float home_velocity = 0.0F;
+};
+
+// Sent by the motor task to have the driver read StallGuard at a fixed
+// period with a threshold under test. A period of 0 stops the readings and
+// restores the configured threshold.
+struct StallSamplingMessage {
+    MotorID motor_id = MotorID::MOTOR_X;
+    int32_t sgt = 0;
+    uint32_t period_ms = 0;
+};
+
+// One StallGuard reading taken for a calibration
+struct StallSampleMessage {
+    MotorID motor_id;
+    uint16_t sg_result;
+    // Step rate of the motor when the reading was taken, in steps/s
+    float velocity;
+};
+
+struct MoveToStallMessage {
+    uint32_t id = 0;
+    MotorID motor_id = MotorID::MOTOR_X;
+    bool direction = false;
+    std::optional<float> mm_per_second = std::nullopt;
+    std::optional<float> mm_per_second_sq = std::nullopt;
+    std::optional<float> mm_per_second_discont = std::nullopt;
+};
+
 using HostCommsMessage =
     ::std::variant<std::monostate, IncomingMessageFromHost, ForceUSBDisconnect,
                    ErrorMessage, AcknowledgePrevious, GetSystemInfoResponse,
                    GetTMCRegisterResponse, GetLimitSwitchesResponses,
-                   GetMoveParamsResponse, GetMotorStallGuardResponse>;
+                   GetMoveParamsResponse, GetMotorStallGuardResponse,
+                   TMCCaptureBatchMessage, CalibrateStallGuardResponse>;
 
 using SystemMessage =
     ::std::variant<std::monostate, AcknowledgePrevious, GetSystemInfoMessage,
@@ -253,12 +309,14 @@ using MotorDriverMessage =
     ::std::variant<std::monostate, SetTMCRegisterMessage, GetTMCRegisterMessage,
                    PollTMCRegisterMessage, StopPollTMCRegisterMessage,
                    SetMotorCurrentMessage, SetMicrostepsMessage,
-                   SetMotorStallGuardMessage, GetMotorStallGuardMessage>;
+                   SetMotorStallGuardMessage, GetMotorStallGuardMessage,
+                   StallSamplingMessage>;
 
 using MotorMessage = ::std::variant<
     std::monostate, MotorEnableMessage, MoveMotorInStepsMessage,
     MoveToLimitSwitchMessage, StopMotorMessage, MoveCompleteMessage,
     GetLimitSwitchesMessage, MoveMotorInMmMessage, SetMicrostepsMessage,
-    GetMoveParamsMessage, SetDiag0IRQMessage, GPIOInterruptMessage>;
+    GetMoveParamsMessage, SetDiag0IRQMessage, GPIOInterruptMessage,
+    CalibrateStallGuardMessage, StallSampleMessage, MoveToStallMessage>;
 
 };  // namespace messages
@@ -5,6 +5,12 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <optional>
+
 #include "core/ack_cache.hpp"
 #include "core/fixed_point.hpp"
 #include "core/queue_aggregator.hpp"
@@ -17,6 +23,7 @@
 #include "flex-stacker/tmc2160.hpp"
 #include "flex-stacker/tmc2160_interface.hpp"
 #include "flex-stacker/tmc2160_registers.hpp"
+#include "flex-stacker/tmc_capture.hpp"
 #include "hal/message_queue.hpp"
 #include "messages.hpp"
 #include "systemwide.h"
@@ -25,6 +32,13 @@ namespace motor_driver_task {
 
 using Message = messages::MotorDriverMessage;
 
+template <typename Policy>
+concept MotorDriverPolicy = tmc2160::TMC2160InterfacePolicy<Policy> &&
+    requires(Policy& p) {
+    // The time in milliseconds, which paces register streaming
+    { p.get_time_ms() } -> std::same_as<uint32_t>;
+};
+
 static constexpr tmc2160::TMC2160RegisterMap motor_z_config{
     .gconfig = {.diag0_error = 0, .diag0_stall = 0},
     .short_conf = {.s2vs_level = 0x6,
@@ -141,7 +155,10 @@ class MotorDriverTask {
         }
     }
 
-    template <tmc2160::TMC2160InterfacePolicy Policy>
+    // How long to wait before retrying to send the end of a stream
+    static constexpr uint32_t CAPTURE_RETRY_MS = 5;
+
+    template <MotorDriverPolicy Policy>
     auto run_once(Policy& policy) -> void {
         if (!_task_registry) {
             return;
@@ -165,14 +182,48 @@ class MotorDriverTask {
 
         auto message = Message(std::monostate());
 
-        _message_queue.recv(&message);
+        // While streaming or sampling, wake up in time for each sample
+        if (_capture.running() || _stall_sampling.running) {
+            static_cast<void>(_message_queue.try_recv(
+                &message, ms_until_due(policy.get_time_ms())));
+        } else if (_capture.unsent() > 0) {
+            static_cast<void>(
+                _message_queue.try_recv(&message, CAPTURE_RETRY_MS));
+        } else {
+            _message_queue.recv(&message);
+        }
+        _now_ms = policy.get_time_ms();
         auto visit_helper = [this, &tmc2160_interface](auto& message) -> void {
             this->visit_message(message, tmc2160_interface);
         };
         std::visit(visit_helper, message);
+        service_capture(tmc2160_interface);
+        service_stall_sampling(tmc2160_interface);
     }
 
   private:
+    // StallGuard readings taken for a calibration in the motor task
+    struct StallSampling {
+        bool running = false;
+        MotorID motor_id = MotorID::MOTOR_X;
+        uint32_t period_ms = 0;
+        uint32_t next_ms = 0;
+    };
+
+    /** The time until the next register stream or calibration sample.*/
+    [[nodiscard]] auto ms_until_due(uint32_t now_ms) const -> uint32_t {
+        auto wait = std::numeric_limits<uint32_t>::max();
+        if (_capture.running()) {
+            wait = _capture.ms_until_due(now_ms);
+        }
+        if (_stall_sampling.running) {
+            auto until =
+                static_cast<int32_t>(_stall_sampling.next_ms - now_ms);
+            wait = std::min(wait, static_cast<uint32_t>(std::max(until, 0)));
+        }
+        return wait;
+    }
+
     template <tmc2160::TMC2160InterfacePolicy Policy>
     auto visit_message(const std::monostate& m,
                        tmc2160::TMC2160Interface<Policy>& tmc2160_interface)
@@ -191,6 +242,8 @@ class MotorDriverTask {
         } else {
             auto result = tmc2160_interface.write(tmc2160::Registers(m.reg),
                                                   m.data, m.motor_id);
+            // The register may no longer match what we last wrote to it
+            _tmc2160.invalidate(m.motor_id);
             if (!result) {
                 response.with_error = errors::ErrorCode::TMC2160_WRITE_ERROR;
             }
@@ -227,16 +280,115 @@ class MotorDriverTask {
     auto visit_message(const messages::PollTMCRegisterMessage& m,
                        tmc2160::TMC2160Interface<Policy>& tmc2160_interface)
         -> void {
-        static_cast<void>(m);
         static_cast<void>(tmc2160_interface);
+        _capture.start(m.motor_id, m.period_ms, _now_ms);
+        static_cast<void>(_task_registry->send_to_address(
+            messages::AcknowledgePrevious{.responding_to_id = m.id},
+            Queues::HostCommsAddress));
     }
 
     template <tmc2160::TMC2160InterfacePolicy Policy>
     auto visit_message(const messages::StopPollTMCRegisterMessage& m,
                        tmc2160::TMC2160Interface<Policy>& tmc2160_interface)
         -> void {
-        static_cast<void>(m);
         static_cast<void>(tmc2160_interface);
+        _capture.stop();
+        static_cast<void>(_task_registry->send_to_address(
+            messages::AcknowledgePrevious{.responding_to_id = m.id},
+            Queues::HostCommsAddress));
+    }
+
+    /**
+     * @brief Take a register stream sample if one is due, and pass on any
+     * full batches. Once the stream stops, what is left is sent as a
+     * partial batch.
+     */
+    template <tmc2160::TMC2160InterfacePolicy Policy>
+    auto service_capture(tmc2160::TMC2160Interface<Policy>& tmc2160_interface)
+        -> void {
+        if (_capture.due(_now_ms)) {
+            auto sample = std::optional<tmc_capture::Sample>();
+            auto regs = _tmc2160.get_driver_status_and_tstep(
+                tmc2160_interface, _capture.motor_id());
+            if (regs.has_value()) {
+                sample = tmc_capture::Sample{
+                    .tstep = regs.value().second,
+                    .sg_result =
+                        static_cast<uint16_t>(regs.value().first.sg_result),
+                    .cs_actual =
+                        static_cast<uint8_t>(regs.value().first.cs_actual)};
+            }
+            _capture.record(sample, _now_ms);
+        }
+        while (_capture.batch_ready(!_capture.running())) {
+            auto batch = _capture.next_batch();
+            if (!_task_registry->send_to_address(
+                    messages::TMCCaptureBatchMessage{.capture = &_capture,
+                                                     .batch = batch},
+                    Queues::HostCommsAddress)) {
+                // Keep the samples until the host catches up
+                return;
+            }
+            _capture.mark_sent(batch);
+        }
+    }
+
+    /**
+     * @brief Start or stop the StallGuard readings for a calibration. While
+     * they run, the motor uses the threshold under test and doesn't signal
+     * stalls, and afterwards its configured StallGuard settings are
+     * restored.
+     */
+    template <tmc2160::TMC2160InterfacePolicy Policy>
+    auto visit_message(const messages::StallSamplingMessage& m,
+                       tmc2160::TMC2160Interface<Policy>& tmc2160_interface)
+        -> void {
+        auto registers = driver_conf_from_id(m.motor_id);
+        if (m.period_ms == 0) {
+            _stall_sampling.running = false;
+        } else {
+            if (_tmc2160.verify_sgt_value(m.sgt)) {
+                registers.coolconf.sgt = m.sgt;
+            }
+            registers.gconfig.diag0_stall = 0;
+            _stall_sampling = StallSampling{.running = true,
+                                            .motor_id = m.motor_id,
+                                            .period_ms = m.period_ms,
+                                            .next_ms = _now_ms};
+        }
+        // A failed write shows up as a calibration that never settles
+        static_cast<void>(_tmc2160.update_coolconf(registers, tmc2160_interface,
+                                                   m.motor_id));
+        static_cast<void>(_tmc2160.update_gconfig(registers, tmc2160_interface,
+                                                  m.motor_id));
+    }
+
+    /**
+     * @brief Take a calibration reading if one is due and pass it on to the
+     * motor task, with the step rate it was taken at.
+     */
+    template <tmc2160::TMC2160InterfacePolicy Policy>
+    auto service_stall_sampling(
+        tmc2160::TMC2160Interface<Policy>& tmc2160_interface) -> void {
+        if (!_stall_sampling.running ||
+            static_cast<int32_t>(_now_ms - _stall_sampling.next_ms) < 0) {
+            return;
+        }
+        // Missed periods are skipped rather than caught up on
+        _stall_sampling.next_ms = _now_ms + _stall_sampling.period_ms;
+        auto regs = _tmc2160.get_driver_status_and_tstep(
+            tmc2160_interface, _stall_sampling.motor_id);
+        if (!regs.has_value()) {
+            return;
+        }
+        auto mres = driver_conf_from_id(_stall_sampling.motor_id).chopconf.mres;
+        auto sample = messages::StallSampleMessage{
+            .motor_id = _stall_sampling.motor_id,
+            .sg_result = static_cast<uint16_t>(regs.value().first.sg_result),
+            .velocity = static_cast<float>(tmc2160::TMC2160::tstep_to_velocity(
+                regs.value().second, mres))};
+        static_cast<void>(
+            _task_registry->send_to_address(sample, Queues::MotorAddress));
     }
 
     template <tmc2160::TMC2160InterfacePolicy Policy>
@@ -287,8 +439,11 @@ class MotorDriverTask {
             .responding_to_id = m.id,
             .with_error = errors::ErrorCode::NO_ERROR};
 
-        if (_tmc2160.verify_sgt_value(m.sgt)) {
-            driver_conf_from_id(m.motor_id).coolconf.sgt = m.sgt.value();
+        if (_tmc2160.verify_sgt_value(m.sgt) &&
+            m.min_velocity.value_or(1.0F) > 0.0F) {
+            if (m.sgt.has_value()) {
+                driver_conf_from_id(m.motor_id).coolconf.sgt = m.sgt.value();
+            }
             driver_conf_from_id(m.motor_id).gconfig.diag0_stall =
                 static_cast<int>(m.enable);
         } else {
@@ -304,7 +459,10 @@ class MotorDriverTask {
         }
 
         if (response.with_error == errors::ErrorCode::NO_ERROR) {
-            auto message = messages::SetDiag0IRQMessage{.enable = m.enable};
+            auto message =
+                messages::SetDiag0IRQMessage{.enable = m.enable,
+                                             .motor_id = m.motor_id,
+                                             .min_velocity = m.min_velocity};
             static_cast<void>(
                 _task_registry->send_to_address(message, Queues::MotorAddress));
         }
@@ -339,6 +497,9 @@ class MotorDriverTask {
     Queue& _message_queue;
     Aggregator* _task_registry;
     bool _initialized;
+    uint32_t _now_ms = 0;
+    tmc_capture::Capture<> _capture{};
+    StallSampling _stall_sampling{};
 
     tmc2160::TMC2160 _tmc2160{};
     // same motor current config for all three motors
@@ -4,16 +4,21 @@
  *
  */
 #pragma once
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <optional>
 
 #include "core/ack_cache.hpp"
 #include "core/linear_motion_system.hpp"
 #include "core/queue_aggregator.hpp"
+#include "core/stall_calibration.hpp"
 #include "core/version.hpp"
 #include "firmware/motor_interrupt.hpp"
 #include "firmware/motor_policy.hpp"
 #include "flex-stacker/errors.hpp"
 #include "flex-stacker/messages.hpp"
+#include "flex-stacker/stall_homing.hpp"
 #include "flex-stacker/tasks.hpp"
 #include "flex-stacker/tmc2160_registers.hpp"
 #include "hal/message_queue.hpp"
@@ -58,6 +63,10 @@ struct MotorState {
     float accel_mm_per_sec_sq;
     // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
     float speed_mm_per_sec_discont;
+    // The slowest velocity in mm/s at which a stall is trusted, if stall
+    // detection is enabled and calibrated
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    std::optional<float> stall_min_velocity = std::nullopt;
     [[nodiscard]] auto get_speed() const -> float {
         return speed_mm_per_sec * steps_per_mm;
     }
@@ -89,6 +98,47 @@ struct LState {
     static constexpr float DEFAULT_SPEED_DISCONT = 5.0;
 };
 
+// Structure to encapsulate a StallGuard calibration of one motor
+struct StallCalibrationState {
+    // Velocities swept by a calibration, in mm/s
+    static constexpr std::array<double, 6> VELOCITIES = {10, 20, 30,
+                                                         40, 60, 80};
+    using Calibration = stall_calibration::Calibration<VELOCITIES.size()>;
+    // Limits for judging SG_RESULT, which reads from 0 to 1023, while the
+    // motor runs freely
+    static constexpr stall_calibration::Settings SETTINGS = {
+        .floor = 50,
+        .target_low = 100,
+        .target_high = 400,
+        .max_noise = 0.25,
+        .min_samples = 10,
+        .velocity_tolerance = 0.05,
+        .sgt_min = -64,
+        .sgt_max = 63,
+        .max_sweeps = 8};
+    // Threshold the first sweep runs with
+    static constexpr int START_SGT = 0;
+    // Acceleration of the sweep movements, in mm/s^2. The fastest velocity
+    // is reached after 6.4mm, which leaves most of the axis at speed.
+    static constexpr float ACCELERATION = 500.0;
+    // Period of StallGuard readings during a sweep, in ms
+    static constexpr uint32_t SAMPLE_PERIOD_MS = 10;
+    enum class Status {
+        IDLE,     /**< Not calibrating.*/
+        HOMING,   /**< Moving to the retract limit switch.*/
+        SWEEPING, /**< Running between the limit switches at each velocity
+                       in turn.*/
+    };
+    Status status = Status::IDLE;
+    // When the calibration is complete, respond to this ID
+    uint32_t response_id = 0;
+    MotorID motor_id = MotorID::MOTOR_X;
+    // The index of the velocity being swept
+    size_t point = 0;
+    // Direction of the current movement
+    bool direction = false;
+};
+
 template <template <class> class QueueImpl>
 requires MessageQueue<QueueImpl<Message>, Message>
 class MotorTask {
@@ -252,12 +302,53 @@ class MotorTask {
                             motor_state(m.motor_id).get_accel());
     }
 
+    template <MotorControlPolicy Policy>
+    auto visit_message(const messages::MoveToStallMessage& m, Policy& policy)
+        -> void {
+        static_cast<void>(policy);
+        auto& state = motor_state(m.motor_id);
+        auto velocity = m.mm_per_second.value_or(state.speed_mm_per_sec);
+        auto error = errors::ErrorCode::NO_ERROR;
+        if (busy()) {
+            error = errors::ErrorCode::MOTOR_BUSY;
+        } else if (!state.stall_min_velocity.has_value() ||
+                   velocity < state.stall_min_velocity.value()) {
+            error = errors::ErrorCode::MOTOR_STALL_NOT_CALIBRATED;
+        }
+        if (error != errors::ErrorCode::NO_ERROR) {
+            static_cast<void>(_task_registry->send_to_address(
+                messages::AcknowledgePrevious{.responding_to_id = m.id,
+                                              .with_error = error},
+                Queues::HostCommsAddress));
+            return;
+        }
+        state.speed_mm_per_sec = velocity;
+        if (m.mm_per_second_sq.has_value()) {
+            state.accel_mm_per_sec_sq = m.mm_per_second_sq.value();
+        }
+        if (m.mm_per_second_discont.has_value()) {
+            state.speed_mm_per_sec_discont = m.mm_per_second_discont.value();
+        }
+        _homing.start(m.motor_id, m.id);
+        // The limit switch still ends the move if the motor never stalls
+        controller_from_id(m.motor_id)
+            .start_movement(m.id, m.direction, state.get_speed_discont(),
+                            state.get_speed(), state.get_accel());
+    }
+
     template <MotorControlPolicy Policy>
     auto visit_message(const messages::StopMotorMessage& m, Policy& policy)
         -> void {
         static_cast<void>(m);
         static_cast<void>(policy);
         controller_from_id(m.motor_id).stop_movement(m.id, true);
+        if (_homing.active(m.motor_id)) {
+            _homing.cancel();
+        }
+        if (calibrating(m.motor_id)) {
+            finish_calibration(
+                errors::ErrorCode::MOTOR_STALL_CALIBRATION_FAILED);
+        }
     }
 
     template <MotorControlPolicy Policy>
@@ -286,9 +377,18 @@ class MotorTask {
     auto visit_message(const messages::MoveCompleteMessage& m, Policy& policy)
         -> void {
         static_cast<void>(policy);
+        if (calibrating(m.motor_id)) {
+            advance_calibration();
+            return;
+        }
         auto response = messages::AcknowledgePrevious{
             .responding_to_id =
                 controller_from_id(m.motor_id).get_response_id()};
+        // A G6 move that ends here ran into the limit switch rather than
+        // stalling
+        if (_homing.active(m.motor_id)) {
+            response.with_error = _homing.backstop();
+        }
         static_cast<void>(_task_registry->send_to_address(
             response, Queues::HostCommsAddress));
     }
@@ -345,6 +445,12 @@ class MotorTask {
         static_cast<void>(policy);
         // NOTE: The diag0 pin is shared by all motors.
         _x_controller.set_diag0_irq(m.enable);
+        auto& state = motor_state(m.motor_id);
+        if (!m.enable) {
+            state.stall_min_velocity = std::nullopt;
+        } else if (m.min_velocity.has_value()) {
+            state.stall_min_velocity = m.min_velocity;
+        }
     }
 
     template <MotorControlPolicy Policy>
@@ -352,15 +458,160 @@ class MotorTask {
         -> void {
         static_cast<void>(m);
         static_cast<void>(policy);
+        if (_homing.active()) {
+            auto& controller = controller_from_id(_homing.motor_id());
+            auto& state = motor_state(_homing.motor_id());
+            // StallGuard isn't trusted below the calibrated velocity, so a
+            // stall flagged while the move is still accelerating doesn't end
+            // it
+            if (!_homing.stall(controller.velocity(),
+                               state.stall_min_velocity.value_or(0.0F) *
+                                   state.steps_per_mm)) {
+                return;
+            }
+            controller.stop_movement(_homing.response_id(), false);
+            static_cast<void>(_task_registry->send_to_address(
+                messages::AcknowledgePrevious{.responding_to_id =
+                                                  _homing.response_id()},
+                Queues::HostCommsAddress));
+            return;
+        }
         _z_controller.stop_movement(0, true);
         _x_controller.stop_movement(0, false);
         _l_controller.stop_movement(0, false);
+        if (_calibration.status != StallCalibrationState::Status::IDLE) {
+            finish_calibration(errors::ErrorCode::MOTOR_STALL_DETECTED);
+        }
         auto msg = messages::ErrorMessage{
             .code = errors::ErrorCode::MOTOR_STALL_DETECTED};
         static_cast<void>(
             _task_registry->send_to_address(msg, Queues::HostCommsAddress));
     }
 
+    template <MotorControlPolicy Policy>
+    auto visit_message(const messages::CalibrateStallGuardMessage& m,
+                       Policy& policy) -> void {
+        static_cast<void>(policy);
+        if (busy()) {
+            static_cast<void>(_task_registry->send_to_address(
+                messages::CalibrateStallGuardResponse{
+                    .responding_to_id = m.id,
+                    .motor_id = m.motor_id,
+                    .with_error = errors::ErrorCode::MOTOR_BUSY},
+                Queues::HostCommsAddress));
+            return;
+        }
+        _calibration = StallCalibrationState{
+            .status = StallCalibrationState::Status::HOMING,
+            .response_id = m.id,
+            .motor_id = m.motor_id,
+            .point = 0,
+            .direction = false};
+        _stall_calibration.start(StallCalibrationState::START_SGT);
+        if (!sample_stall_guard(StallCalibrationState::SAMPLE_PERIOD_MS)) {
+            finish_calibration(errors::ErrorCode::INTERNAL_QUEUE_FULL);
+            return;
+        }
+        start_calibration_move();
+    }
+
+    template <MotorControlPolicy Policy>
+    auto visit_message(const messages::StallSampleMessage& m, Policy& policy)
+        -> void {
+        static_cast<void>(policy);
+        if (_calibration.status != StallCalibrationState::Status::SWEEPING ||
+            _calibration.motor_id != m.motor_id) {
+            return;
+        }
+        // Readings taken away from the velocity being swept don't count
+        static_cast<void>(_stall_calibration.record(
+            _calibration.point,
+            m.velocity / motor_state(m.motor_id).steps_per_mm, m.sg_result));
+    }
+
+    [[nodiscard]] auto busy() const -> bool {
+        return _homing.active() ||
+               (_calibration.status != StallCalibrationState::Status::IDLE);
+    }
+
+    [[nodiscard]] auto calibrating(MotorID motor_id) const -> bool {
+        return (_calibration.status != StallCalibrationState::Status::IDLE) &&
+               (_calibration.motor_id == motor_id);
+    }
+
+    // Start or stop the driver's StallGuard readings, with the threshold
+    // under test
+    auto sample_stall_guard(uint32_t period_ms) -> bool {
+        return _task_registry->send_to_address(
+            messages::StallSamplingMessage{.motor_id = _calibration.motor_id,
+                                           .sgt = _stall_calibration.sgt(),
+                                           .period_ms = period_ms},
+            Queues::MotorDriverAddress);
+    }
+
+    // Homing runs at the slowest velocity, and each sweep movement at the
+    // velocity being swept
+    auto start_calibration_move() -> void {
+        auto& state = motor_state(_calibration.motor_id);
+        auto velocity = static_cast<uint32_t>(
+            _stall_calibration.velocity(_calibration.point) *
+            state.steps_per_mm);
+        controller_from_id(_calibration.motor_id)
+            .start_movement(
+                _calibration.response_id, _calibration.direction,
+                std::min(velocity,
+                         static_cast<uint32_t>(state.get_speed_discont())),
+                velocity,
+                static_cast<uint32_t>(StallCalibrationState::ACCELERATION *
+                                      state.steps_per_mm));
+    }
+
+    // Called when a calibration movement reaches its limit switch
+    auto advance_calibration() -> void {
+        if (_calibration.status == StallCalibrationState::Status::HOMING) {
+            _calibration.status = StallCalibrationState::Status::SWEEPING;
+            _calibration.point = 0;
+        } else if (++_calibration.point ==
+                   StallCalibrationState::VELOCITIES.size()) {
+            switch (_stall_calibration.finish_sweep()) {
+                case stall_calibration::Verdict::SWEEP_AGAIN:
+                    _calibration.point = 0;
+                    if (!sample_stall_guard(
+                            StallCalibrationState::SAMPLE_PERIOD_MS)) {
+                        finish_calibration(
+                            errors::ErrorCode::INTERNAL_QUEUE_FULL);
+                        return;
+                    }
+                    break;
+                case stall_calibration::Verdict::DONE:
+                    finish_calibration(errors::ErrorCode::NO_ERROR);
+                    return;
+                default:
+                    finish_calibration(
+                        errors::ErrorCode::MOTOR_STALL_CALIBRATION_FAILED);
+                    return;
+            }
+        }
+        _calibration.direction = !_calibration.direction;
+        start_calibration_move();
+    }
+
+    // Restore the driver's StallGuard settings and report the result
+    auto finish_calibration(errors::ErrorCode error) -> void {
+        static_cast<void>(sample_stall_guard(0));
+        _calibration.status = StallCalibrationState::Status::IDLE;
+        const auto& result = _stall_calibration.result();
+        static_cast<void>(_task_registry->send_to_address(
+            messages::CalibrateStallGuardResponse{
+                .responding_to_id = _calibration.response_id,
+                .motor_id = _calibration.motor_id,
+                .with_error = error,
+                .sgt = result.sgt,
+                .min_velocity = static_cast<float>(result.min_velocity),
+                .home_velocity = static_cast<float>(result.home_velocity)},
+            Queues::HostCommsAddress));
+    }
+
     Queue& _message_queue;
     Aggregator* _task_registry;
     Controller& _x_controller;
@@ -391,6 +642,10 @@ class MotorTask {
         .accel_mm_per_sec_sq = LState::DEFAULT_SPEED,
         .speed_mm_per_sec_discont = LState::DEFAULT_SPEED_DISCONT,
     };
+    StallCalibrationState _calibration{};
+    StallCalibrationState::Calibration _stall_calibration{
+        StallCalibrationState::VELOCITIES, StallCalibrationState::SETTINGS};
+    stall_homing::StallHoming _homing{};
 };
 
 };  // namespace motor_task
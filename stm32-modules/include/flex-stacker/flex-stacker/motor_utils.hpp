@@ -52,6 +52,12 @@ class MovementProfile {
         bool step;  // If true, motor should step
     };
 
+    struct AdvanceReturn {
+        ticks elapsed;  // The number of ticks that were run
+        bool done;      // If true, this movement is done
+        bool step;      // If true, the last tick that was run stepped
+    };
+
     /**
      * @brief Construct a new Movement Profile object
      *
@@ -82,6 +88,18 @@ class MovementProfile {
      */
     auto tick() -> TickReturn __attribute__((optimize(3)));
 
+    /**
+     * @brief Run ticks until the next step, the end of the movement, or
+     * \c limit ticks, whichever comes first. This gives exactly the same
+     * result as calling \c tick() that many times, but skips straight over
+     * runs of ticks where the velocity is constant.
+     *
+     * @param limit The most ticks to run. Must be at least 1.
+     * @return AdvanceReturn with the number of ticks that were run, and the
+     * result of the last one
+     */
+    auto advance(ticks limit) -> AdvanceReturn;
+
     auto fixed_distance_tick() -> void;
 
     /** Returns the current motor velocity in steps_per_tick.*/
@@ -0,0 +1,91 @@
+/**
+ * @file stall_homing.hpp
+ * @brief Tracks a G6 move, which homes a motor by running it until it
+ * stalls, and decides how it ends.
+ *
+ * @details StallGuard flags a stall through the shared DIAG0 interrupt. It
+ * isn't trusted below the minimum velocity found by calibration, so a stall
+ * flagged while the move is still accelerating doesn't end it. The limit
+ * switch in the direction of travel is a backstop: it ends the move if the
+ * motor never stalls at a trusted velocity.
+ *
+ * The host has to be able to tell those endings apart, since a move that
+ * ran into the backstop didn't find the stall the host was homing to. A
+ * trusted stall is acknowledged without an error. Reaching the backstop is
+ * acknowledged with MOTOR_STALL_NOT_DETECTED, or MOTOR_STALL_BELOW_VELOCITY
+ * if a stall was flagged too slowly to be trusted on the way there.
+ */
+#pragma once
+
+#include <cstdint>
+
+#include "flex-stacker/errors.hpp"
+#include "systemwide.h"
+
+namespace stall_homing {
+
+class StallHoming {
+  public:
+    /** Start tracking a move of a motor, to acknowledge with response_id.*/
+    auto start(MotorID motor_id, uint32_t response_id) -> void {
+        _active = true;
+        _motor_id = motor_id;
+        _response_id = response_id;
+        _ignored_stall = false;
+    }
+
+    /** Stop tracking the move, without acknowledging it.*/
+    auto cancel() -> void { _active = false; }
+
+    [[nodiscard]] auto active() const -> bool { return _active; }
+
+    [[nodiscard]] auto active(MotorID motor_id) const -> bool {
+        return _active && (_motor_id == motor_id);
+    }
+
+    [[nodiscard]] auto motor_id() const -> MotorID { return _motor_id; }
+
+    [[nodiscard]] auto response_id() const -> uint32_t {
+        return _response_id;
+    }
+
+    /**
+     * @brief Handle a stall flagged while the move runs.
+     * @param velocity The motor's velocity
+     * @param min_velocity The slowest velocity a stall is trusted at, in
+     * the same units
+     * @return True if the move ends at the stall, and should be acknowledged
+     * without an error
+     */
+    auto stall(float velocity, float min_velocity) -> bool {
+        if (!_active) {
+            return false;
+        }
+        if (velocity < min_velocity) {
+            _ignored_stall = true;
+            return false;
+        }
+        _active = false;
+        return true;
+    }
+
+    /**
+     * @brief Handle the move ending without a trusted stall, which means the
+     * motor reached the limit switch.
+     * @return The error to acknowledge the move with
+     */
+    auto backstop() -> errors::ErrorCode {
+        _active = false;
+        return _ignored_stall ? errors::ErrorCode::MOTOR_STALL_BELOW_VELOCITY
+                              : errors::ErrorCode::MOTOR_STALL_NOT_DETECTED;
+    }
+
+  private:
+    bool _active = false;
+    MotorID _motor_id = MotorID::MOTOR_X;
+    uint32_t _response_id = 0;
+    // Whether a stall was flagged below the trusted velocity during the move
+    bool _ignored_stall = false;
+};
+
+}  // namespace stall_homing
@@ -4,12 +4,15 @@
  */
 #pragma once
 
+#include <array>
 #include <cmath>
 #include <concepts>
 #include <cstdint>
 #include <functional>
 #include <numbers>
 #include <optional>
+#include <span>
+#include <utility>
 
 #include "core/bit_utils.hpp"
 #include "systemwide.h"
@@ -22,58 +25,59 @@ using namespace std::numbers;
 
 class TMC2160 {
   public:
+    /**
+     * @brief Write a register map to one of the drivers. Only the registers
+     * that have changed since they were last written to that driver are
+     * sent, all in a single chained transfer.
+     * @return True if the registers were written succesfully
+     */
     template <tmc2160::TMC2160InterfacePolicy Policy>
     auto initialize_config(const TMC2160RegisterMap& registers,
                            tmc2160::TMC2160Interface<Policy>& policy,
                            MotorID motor_id) -> bool {
-        if (!set_register(verify_gconf(registers.gconfig), policy, motor_id)) {
-            return false;
-        }
-        if (!set_register(verify_shortconf(registers.short_conf), policy,
-                          motor_id)) {
-            return false;
-        }
-        if (!set_register(verify_drvconf(registers.drvconf), policy,
-                          motor_id)) {
-            return false;
-        }
-        if (!set_register(verify_glob_scaler(registers.glob_scale), policy,
-                          motor_id)) {
-            return false;
-        }
-        if (!set_register(verify_ihold_irun(registers.ihold_irun), policy,
-                          motor_id)) {
-            return false;
-        }
-        if (!set_register(verify_tpowerdown(PowerDownDelay::reg_to_seconds(
-                              registers.tpowerdown.time)),
-                          policy, motor_id)) {
-            return false;
-        }
-        if (!set_register(registers.tpwmthrs, policy, motor_id)) {
-            return false;
-        }
-        if (!set_register(registers.tcoolthrs, policy, motor_id)) {
-            return false;
-        }
-        if (!set_register(registers.thigh, policy, motor_id)) {
-            return false;
-        }
-        if (!set_register(verify_chopconf(registers.chopconf), policy,
-                          motor_id)) {
-            return false;
-        }
-        if (!set_register(verify_coolconf(registers.coolconf), policy,
-                          motor_id)) {
-            return false;
+        auto values = std::array<RegisterSerializedType, CONFIG_REGISTERS>{
+            serialize(verify_gconf(registers.gconfig)),
+            serialize(verify_shortconf(registers.short_conf)),
+            serialize(verify_drvconf(registers.drvconf)),
+            serialize(verify_glob_scaler(registers.glob_scale)),
+            serialize(verify_ihold_irun(registers.ihold_irun)),
+            serialize(verify_tpowerdown(
+                PowerDownDelay::reg_to_seconds(registers.tpowerdown.time))),
+            serialize(registers.tpwmthrs),
+            serialize(registers.tcoolthrs),
+            serialize(registers.thigh),
+            serialize(verify_chopconf(registers.chopconf)),
+            serialize(verify_coolconf(registers.coolconf)),
+            serialize(verify_pwmconf(registers.pwmconf))};
+
+        auto& shadow = _shadows.at(motor_id);
+        auto writes = std::array<RegisterWrite, CONFIG_REGISTERS>{};
+        size_t count = 0;
+        for (size_t i = 0; i < CONFIG_REGISTERS; ++i) {
+            if (!shadow.valid.at(i) || shadow.values.at(i) != values.at(i)) {
+                writes.at(count++) = RegisterWrite{
+                    .addr = CONFIG_ADDRESSES.at(i), .value = values.at(i)};
+            }
         }
-        if (!set_register(verify_pwmconf(registers.pwmconf), policy,
-                          motor_id)) {
+        if (!policy.write_batch(std::span(writes.data(), count), motor_id)) {
+            // Some of the batch may have been written, so nothing is known
+            invalidate(motor_id);
             return false;
         }
+        shadow.values = values;
+        shadow.valid.fill(true);
         return true;
     }
 
+    /**
+     * @brief Forget which register values have been written to a driver,
+     * so that the next write to each of its registers is always sent. Use
+     * this if the driver's registers may have been changed behind our back.
+     */
+    auto invalidate(MotorID motor_id) -> void {
+        _shadows.at(motor_id).valid.fill(false);
+    }
+
     template <tmc2160::TMC2160InterfacePolicy Policy>
     auto update_current(const TMC2160RegisterMap& registers,
                         tmc2160::TMC2160Interface<Policy>& policy,
@@ -105,6 +109,31 @@ class TMC2160 {
                             motor_id);
     }
 
+    /**
+     * @brief Read DRV_STATUS and TSTEP from one driver together, in a
+     * single chained transfer of three messages.
+     * @return DRV_STATUS and the TSTEP value, or nothing if they couldn't
+     * be read
+     */
+    template <tmc2160::TMC2160InterfacePolicy Policy>
+    auto get_driver_status_and_tstep(tmc2160::TMC2160Interface<Policy>& policy,
+                                     MotorID motor_id)
+        -> std::optional<std::pair<DriveStatus, RegisterSerializedType>> {
+        using RT =
+            std::optional<std::pair<DriveStatus, RegisterSerializedType>>;
+        static constexpr auto addrs =
+            std::array{Registers::DRVSTATUS, Registers::TSTEP};
+        auto values = std::array<RegisterSerializedType, addrs.size()>{};
+        if (!policy.read_batch(addrs, values, motor_id)) {
+            return RT();
+        }
+        // Ignore the typical linter warning because we're only using
+        // this on __packed structures that mimic hardware registers
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        auto status = *reinterpret_cast<DriveStatus*>(&values.at(0));
+        return RT(std::make_pair(status, values.at(1) & TSTEP_MASK));
+    }
+
     static auto verify_gconf(GConfig reg) -> GConfig {
         reg.test_mode = 0;
         return reg;
@@ -169,6 +198,26 @@ class TMC2160 {
         return true;
     }
 
+    // The internal clock of the driver, which TSTEP is counted in
+    static constexpr double CLOCK_FREQUENCY_HZ = 12000000.0;
+
+    /**
+     * @brief Convert a TSTEP reading into the step rate at the step input.
+     * TSTEP is the number of clock cycles between 1/256 microsteps, and
+     * each input step is 2^mres of those.
+     * @param tstep The TSTEP reading
+     * @param mres The microstep resolution in CHOPCONF
+     * @return The velocity in steps/s
+     */
+    [[nodiscard]] static constexpr auto tstep_to_velocity(uint32_t tstep,
+                                                          uint32_t mres)
+        -> double {
+        if (tstep == 0) {
+            return 0.0;
+        }
+        return CLOCK_FREQUENCY_HZ / static_cast<double>(tstep << mres);
+    }
+
     // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
     [[nodiscard]] auto convert_peak_current_to_tmc2160_value(
         float peak_c, const GlobalScaler& glob_scale,
@@ -199,6 +248,51 @@ class TMC2160 {
     }
 
   private:
+    // The registers that initialize_config writes, in the order it writes
+    // them
+    static constexpr size_t CONFIG_REGISTERS = 12;
+    static constexpr std::array<Registers, CONFIG_REGISTERS> CONFIG_ADDRESSES{
+        Registers::GCONF,         Registers::SHORT_CONF, Registers::DRV_CONF,
+        Registers::GLOBAL_SCALER, Registers::IHOLD_IRUN, Registers::TPOWERDOWN,
+        Registers::TPWMTHRS,      Registers::TCOOLTHRS,  Registers::THIGH,
+        Registers::CHOPCONF,      Registers::COOLCONF,   Registers::PWMCONF};
+    static_assert(CONFIG_REGISTERS <= MAX_BATCH,
+                  "The configuration must fit in one batch");
+    static constexpr size_t MOTORS = 3;
+    // TSTEP is a 20 bit register
+    static constexpr RegisterSerializedType TSTEP_MASK = (1 << 20) - 1;
+
+    // The last value written to each configuration register of a driver,
+    // which is only known to be on the driver if its flag is set
+    struct Shadow {
+        std::array<RegisterSerializedType, CONFIG_REGISTERS> values{};
+        std::array<bool, CONFIG_REGISTERS> valid{};
+    };
+
+    // The value that is sent to the TMC2160 for a register
+    template <TMC2160Register Reg>
+    static auto serialize(Reg reg) -> RegisterSerializedType {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Warray-bounds"
+        // Ignore the typical linter warning because we're only using
+        // this on __packed structures that mimic hardware registers
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        auto value = *reinterpret_cast<RegisterSerializedTypeA*>(&reg);
+#pragma GCC diagnostic pop
+        return value & Reg::value_mask;
+    }
+
+    // The index of a configuration register in a shadow, or CONFIG_REGISTERS
+    // if it isn't one
+    static auto shadow_index(Registers addr) -> size_t {
+        for (size_t i = 0; i < CONFIG_REGISTERS; ++i) {
+            if (CONFIG_ADDRESSES.at(i) == addr) {
+                return i;
+            }
+        }
+        return CONFIG_REGISTERS;
+    }
+
     /**
      * @brief Set a register on the TMC2160
      *
@@ -207,19 +301,30 @@ class TMC2160 {
      * @param[in] policy Instance of the abstraction policy to use
      * @param[in] reg The register to write
      * @return True if the register could be written, false otherwise.
-     * Attempts to write to an unwirteable register will throw a static
-     * assertion.
+     * A register that is known to hold the value already is not written
+     * again. Attempts to write to an unwirteable register will throw a
+     * static assertion.
      */
     template <TMC2160Register Reg, tmc2160::TMC2160InterfacePolicy Policy>
     requires WritableRegister<Reg>
     auto set_register(Reg reg, tmc2160::TMC2160Interface<Policy>& policy,
                       MotorID motor_id) -> bool {
-        // Ignore the typical linter warning because we're only using
-        // this on __packed structures that mimic hardware registers
-        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-        auto value = *reinterpret_cast<RegisterSerializedTypeA*>(&reg);
-        value &= Reg::value_mask;
-        return policy.write(Reg::address, value, motor_id);
+        auto value = serialize(reg);
+        auto& shadow = _shadows.at(motor_id);
+        auto index = shadow_index(Reg::address);
+        if (index < CONFIG_REGISTERS && shadow.valid.at(index) &&
+            shadow.values.at(index) == value) {
+            return true;
+        }
+        if (!policy.write(Reg::address, value, motor_id)) {
+            invalidate(motor_id);
+            return false;
+        }
+        if (index < CONFIG_REGISTERS) {
+            shadow.values.at(index) = value;
+            shadow.valid.at(index) = true;
+        }
+        return true;
     }
     /**
      * @brief Read a register on the TMC2160
@@ -244,6 +349,8 @@ class TMC2160 {
         // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
         return RT(*reinterpret_cast<Reg*>(&ret.value()));
     }
+
+    std::array<Shadow, MOTORS> _shadows{};
 };
 
 }  // namespace tmc2160
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <optional>
+#include <span>
 
 #include "core/bit_utils.hpp"
 #include "flex-stacker/tmc2160_registers.hpp"
@@ -13,17 +14,33 @@ static constexpr size_t MESSAGE_LEN = 5;
 // The type of a single TMC2160 message.
 using MessageT = std::array<uint8_t, MESSAGE_LEN>;
 
+// The most register accesses that can be chained in one batch.
+static constexpr size_t MAX_BATCH = 12;
+
 // Flag for whether this is a read or write
 enum class WriteFlag { READ = 0x00, WRITE = 0x80 };
 
+// A single register write in a batch
+struct RegisterWrite {
+    Registers addr;
+    RegisterSerializedType value;
+};
+
 template <typename P>
 concept TMC2160InterfacePolicy = requires(P p, MotorID motor_id,
-                                          MessageT& message) {
+                                          MessageT& message,
+                                          std::span<MessageT> batch) {
     // A function to read & write to a register. addr should include the
     // read/write bit.
     {
         p.tmc2160_transmit_receive(motor_id, message)
         } -> std::same_as<std::optional<MessageT>>;
+    // Send several messages to one driver back to back in one chained
+    // transfer, toggling the chip select between each one. Each message is
+    // replaced with the reply to it.
+    {
+        p.tmc2160_transmit_receive_batch(motor_id, batch)
+        } -> std::same_as<bool>;
 };
 
 /**
@@ -106,15 +123,90 @@ class TMC2160Interface {
         if (!ret.has_value()) {
             return RT();
         }
-        auto* iter = ret.value().begin();
-        std::advance(iter, 1);
+        return RT(reply_value(ret.value()));
+    }
 
-        RegisterSerializedType retval = 0;
-        iter = bit_utils::bytes_to_int(iter, ret.value().end(), retval);
-        return RT(retval);
+    /**
+     * @brief Write to several registers of one driver in a single chained
+     * transfer.
+     *
+     * @param[in] writes The registers to write, in order. There may be at
+     * most MAX_BATCH of them.
+     * @param[in] motor_id The driver to write to
+     * @return True on success, false on error to write
+     */
+    auto write_batch(std::span<const RegisterWrite> writes, MotorID motor_id)
+        -> bool {
+        if (writes.size() > MAX_BATCH) {
+            return false;
+        }
+        if (writes.empty()) {
+            return true;
+        }
+        std::array<MessageT, MAX_BATCH> messages{};
+        for (size_t i = 0; i < writes.size(); ++i) {
+            auto message = build_message(writes[i].addr, WriteFlag::WRITE,
+                                         writes[i].value);
+            if (!message.has_value()) {
+                return false;
+            }
+            messages.at(i) = message.value();
+        }
+        return _policy.tmc2160_transmit_receive_batch(
+            motor_id, std::span(messages.data(), writes.size()));
+    }
+
+    /**
+     * @brief Read several registers of one driver in a single chained
+     * transfer. Each reply holds the register requested by the message
+     * before it, so this takes one more message than there are registers,
+     * rather than the two per register of separate reads.
+     *
+     * @param[in] addrs The registers to read. There may be at most
+     * MAX_BATCH of them.
+     * @param[out] values The values that were read, in the same order
+     * @param[in] motor_id The driver to read from
+     * @return True on success, false on error to read
+     */
+    auto read_batch(std::span<const Registers> addrs,
+                    std::span<RegisterSerializedType> values, MotorID motor_id)
+        -> bool {
+        if (addrs.size() > MAX_BATCH || values.size() < addrs.size()) {
+            return false;
+        }
+        if (addrs.empty()) {
+            return true;
+        }
+        std::array<MessageT, MAX_BATCH + 1> messages{};
+        for (size_t i = 0; i < addrs.size(); ++i) {
+            auto message = build_message(addrs[i], WriteFlag::READ, 0);
+            if (!message.has_value()) {
+                return false;
+            }
+            messages.at(i) = message.value();
+        }
+        // Repeat the last read to clock its value out
+        messages.at(addrs.size()) = messages.at(addrs.size() - 1);
+        if (!_policy.tmc2160_transmit_receive_batch(
+                motor_id, std::span(messages.data(), addrs.size() + 1))) {
+            return false;
+        }
+        for (size_t i = 0; i < addrs.size(); ++i) {
+            values[i] = reply_value(messages.at(i + 1));
+        }
+        return true;
     }
 
   private:
+    // Get the register contents from a reply, skipping the status byte
+    static auto reply_value(const MessageT& reply) -> RegisterSerializedType {
+        const auto* iter = reply.begin();
+        std::advance(iter, 1);
+        RegisterSerializedType retval = 0;
+        static_cast<void>(bit_utils::bytes_to_int(iter, reply.end(), retval));
+        return retval;
+    }
+
     Policy& _policy;
 };
 
@@ -0,0 +1,220 @@
+/**
+ * @file tmc_capture.hpp
+ * @brief Buffers samples of the TMC2160 load and step registers while they
+ * are streamed to the host.
+ *
+ * @details Tuning StallGuard needs SG_RESULT, CS_ACTUAL and TSTEP sampled at
+ * a steady rate while a motor moves. Each sample is a batch of SPI
+ * datagrams, and the SPI driver blocks the calling task until its DMA is
+ * done, so samples can't be read from the motor interrupt or from the step
+ * schedule's DMA callbacks. The motor driver task takes them instead, on a
+ * fixed period of its millisecond clock, which also paces them the same way
+ * whether a movement is ticked or stepped from a schedule.
+ *
+ * Sending each sample to the host as its own response is too slow to keep
+ * up, so samples are recorded into a ring buffer and handed to the host
+ * comms task BATCH_SIZE at a time. The message only says where the batch is
+ * in the ring: host comms writes the samples straight out of it and then
+ * releases them. If the host can't keep up, samples wait in the ring; once
+ * that is full, new samples are dropped and counted, and the sample numbers
+ * in each batch show where the gaps are.
+ *
+ * The motor driver task is the only writer of a Capture. Host comms only
+ * calls sample() and release(), for batches it has been sent.
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "systemwide.h"
+
+namespace tmc_capture {
+
+/** The registers captured on each sample.*/
+struct Sample {
+    // TSTEP, the time between the last two steps in driver clocks
+    uint32_t tstep = 0;
+    // SG_RESULT from DRV_STATUS, the StallGuard load measurement
+    uint16_t sg_result = 0;
+    // CS_ACTUAL from DRV_STATUS, the current scale from CoolStep
+    uint8_t cs_actual = 0;
+};
+
+/** The number of samples sent to the host at a time.*/
+static constexpr size_t BATCH_SIZE = 8;
+/** The number of samples the motor driver task buffers.*/
+static constexpr size_t DEFAULT_CAPACITY = 256;
+
+/** Where a batch of consecutive samples is in the ring buffer.*/
+struct Batch {
+    MotorID motor_id = MotorID::MOTOR_X;
+    // The number of the first sample since the capture started. Sample n
+    // was taken n sample periods after the start.
+    uint32_t first = 0;
+    // The number of samples dropped since the capture started
+    uint32_t dropped = 0;
+    // The position of the first sample in the ring, counted from when the
+    // capture was built rather than wrapped to its capacity
+    uint32_t index = 0;
+    uint8_t count = 0;
+};
+
+/**
+ * @brief Paces and buffers a capture of one motor.
+ * @tparam Capacity The number of samples that can wait to be sent. Ring
+ * positions wrap at 2^32, so this must be a power of two.
+ */
+template <size_t Capacity = DEFAULT_CAPACITY>
+requires(Capacity >= BATCH_SIZE && (Capacity & (Capacity - 1)) == 0) class
+    Capture {
+  public:
+    /**
+     * @brief Start a new capture, discarding anything left from the last
+     * that hasn't been sent. Batches that were already sent stay in the
+     * ring until they are released.
+     * @param motor_id The motor to sample
+     * @param period_ms The time between samples, at least 1 ms
+     * @param now_ms The current time. The first sample is due straight away.
+     */
+    auto start(MotorID motor_id, uint32_t period_ms, uint32_t now_ms)
+        -> void {
+        _motor_id = motor_id;
+        _period_ms = (period_ms == 0) ? 1 : period_ms;
+        _next_ms = now_ms;
+        _taken = 0;
+        _dropped = 0;
+        _write = _sent;
+        _running = true;
+    }
+
+    /**
+     * @brief Stop sampling. Samples that are already buffered can still be
+     * sent with next_batch().
+     */
+    auto stop() -> void { _running = false; }
+
+    [[nodiscard]] auto running() const -> bool { return _running; }
+    [[nodiscard]] auto motor_id() const -> MotorID { return _motor_id; }
+    /** The samples in the ring, including sent ones not yet released.*/
+    [[nodiscard]] auto buffered() const -> size_t {
+        return _write - _read.load(std::memory_order_acquire);
+    }
+    /** The samples that haven't been sent yet.*/
+    [[nodiscard]] auto unsent() const -> size_t { return _write - _sent; }
+    [[nodiscard]] auto dropped() const -> uint32_t { return _dropped; }
+
+    /** Whether a sample should be taken now.*/
+    [[nodiscard]] auto due(uint32_t now_ms) const -> bool {
+        return _running && static_cast<int32_t>(now_ms - _next_ms) >= 0;
+    }
+
+    /** The time until the next sample is due, or 0 if it is due already.*/
+    [[nodiscard]] auto ms_until_due(uint32_t now_ms) const -> uint32_t {
+        if (due(now_ms)) {
+            return 0;
+        }
+        return _next_ms - now_ms;
+    }
+
+    /**
+     * @brief Record the sample for the period that is due, or drop it if
+     * the register read failed (pass nothing) or the buffer is full. If the
+     * caller fell more than a period behind, the missed periods are counted
+     * as dropped so that sample numbers stay on the same time base.
+     */
+    auto record(std::optional<Sample> sample, uint32_t now_ms) -> void {
+        if (!due(now_ms)) {
+            return;
+        }
+        auto missed = (now_ms - _next_ms) / _period_ms;
+        _dropped += missed;
+        _taken += missed;
+        _next_ms += (missed + 1) * _period_ms;
+        if (sample.has_value() && buffered() < Capacity) {
+            _samples.at(_write % Capacity) =
+                Entry{.number = _taken, .sample = sample.value()};
+            ++_write;
+        } else {
+            ++_dropped;
+        }
+        ++_taken;
+    }
+
+    /**
+     * @brief Check whether there is a batch to send.
+     * @param flush If true, send a partial batch rather than waiting for a
+     * full one, such as when the capture has stopped
+     */
+    [[nodiscard]] auto batch_ready(bool flush) const -> bool {
+        return (unsent() >= BATCH_SIZE) || (flush && unsent() > 0);
+    }
+
+    /**
+     * @brief Find the oldest unsent samples, without marking them as sent,
+     * so that they can be kept if the batch can't be sent. The batch stops
+     * at a gap in the sample numbers.
+     */
+    [[nodiscard]] auto next_batch() const -> Batch {
+        auto batch = Batch{
+            .motor_id = _motor_id, .dropped = _dropped, .index = _sent};
+        if (unsent() == 0) {
+            return batch;
+        }
+        batch.first = entry(_sent).number;
+        while (batch.count < BATCH_SIZE && batch.count < unsent()) {
+            if (entry(_sent + batch.count).number !=
+                batch.first + batch.count) {
+                break;
+            }
+            ++batch.count;
+        }
+        return batch;
+    }
+
+    /** Mark a batch from next_batch() as sent to host comms.*/
+    auto mark_sent(const Batch& batch) -> void {
+        _sent += std::min(static_cast<size_t>(batch.count), unsent());
+    }
+
+    /** A sample of a batch that was sent, until the batch is released.*/
+    [[nodiscard]] auto sample(const Batch& batch, size_t i) const
+        -> const Sample& {
+        return entry(batch.index + i).sample;
+    }
+
+    /** Free the space of a batch that was sent, once it is written out.*/
+    auto release(const Batch& batch) -> void {
+        _read.fetch_add(batch.count, std::memory_order_release);
+    }
+
+  private:
+    struct Entry {
+        uint32_t number = 0;
+        Sample sample = {};
+    };
+
+    [[nodiscard]] auto entry(uint32_t index) const -> const Entry& {
+        return _samples.at(index % Capacity);
+    }
+
+    std::array<Entry, Capacity> _samples{};
+    // Ring positions: samples before _read are free, samples from _read to
+    // _sent are with host comms, and samples from _sent to _write are
+    // waiting to be sent
+    std::atomic<uint32_t> _read = 0;
+    uint32_t _sent = 0;
+    uint32_t _write = 0;
+    MotorID _motor_id = MotorID::MOTOR_X;
+    uint32_t _period_ms = 1;
+    uint32_t _next_ms = 0;
+    uint32_t _taken = 0;
+    uint32_t _dropped = 0;
+    bool _running = false;
+};
+
+}  // namespace tmc_capture
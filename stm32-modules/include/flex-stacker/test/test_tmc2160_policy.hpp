@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <map>
+#include <optional>
+#include <span>
+
+#include "core/bit_utils.hpp"
+#include "flex-stacker/tmc2160_interface.hpp"
+#include "systemwide.h"
+
+/**
+ * A host-side set of TMC2160 drivers, one per motor. Each driver is a map
+ * of registers that returns the register requested by the previous message,
+ * like the real driver does.
+ */
+class TestTMC2160Policy {
+  public:
+    using RxTxReturn = std::optional<tmc2160::MessageT>;
+
+    auto tmc2160_transmit_receive(MotorID motor_id, tmc2160::MessageT& data)
+        -> RxTxReturn {
+        auto& driver = _drivers.at(motor_id);
+        auto iter = data.begin();
+        uint8_t addr = 0;
+        tmc2160::RegisterSerializedType value = 0;
+        iter = bit_utils::bytes_to_int(iter, data.end(), addr);
+        iter = bit_utils::bytes_to_int(iter, data.end(), value);
+
+        auto mode = addr & static_cast<uint8_t>(tmc2160::WriteFlag::WRITE);
+        addr &= ~static_cast<uint8_t>(tmc2160::WriteFlag::WRITE);
+        if (mode != 0) {
+            driver.registers[addr] = value;
+        }
+        tmc2160::MessageT ret{};
+        auto out = ret.begin();
+        out = bit_utils::int_to_bytes(static_cast<uint8_t>(0), out, ret.end());
+        out = bit_utils::int_to_bytes(driver.cache, out, ret.end());
+        driver.cache = driver.registers[addr];
+        ++_messages;
+        return RxTxReturn(ret);
+    }
+
+    auto tmc2160_transmit_receive_batch(MotorID motor_id,
+                                        std::span<tmc2160::MessageT> batch)
+        -> bool {
+        ++_batches;
+        if (_fail_batches) {
+            return false;
+        }
+        for (auto& message : batch) {
+            auto ret = tmc2160_transmit_receive(motor_id, message);
+            if (!ret.has_value()) {
+                return false;
+            }
+            message = ret.value();
+        }
+        return true;
+    }
+
+    // -------------- Test integration methods
+    auto read_register(MotorID motor_id, tmc2160::Registers reg)
+        -> tmc2160::RegisterSerializedType {
+        return _drivers.at(motor_id).registers[static_cast<uint8_t>(reg)];
+    }
+    auto write_register(MotorID motor_id, tmc2160::Registers reg,
+                        tmc2160::RegisterSerializedType value) -> void {
+        _drivers.at(motor_id).registers[static_cast<uint8_t>(reg)] = value;
+    }
+    // The number of messages sent, and the number of batches they were in
+    [[nodiscard]] auto get_messages() const -> size_t { return _messages; }
+    [[nodiscard]] auto get_batches() const -> size_t { return _batches; }
+    auto set_fail_batches(bool fail) -> void { _fail_batches = fail; }
+
+  private:
+    struct Driver {
+        std::map<uint8_t, tmc2160::RegisterSerializedType> registers{};
+        tmc2160::RegisterSerializedType cache = 0;
+    };
+
+    std::array<Driver, 3> _drivers{};
+    size_t _messages = 0;
+    size_t _batches = 0;
+    bool _fail_batches = false;
+};
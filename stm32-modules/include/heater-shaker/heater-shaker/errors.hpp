@@ -49,6 +49,7 @@ enum class ErrorCode {
     PLATE_LOCK_NOT_CLOSED = 126,
     MOTOR_HOMING = 127,
     FAULTY_LATCH_SENSORS = 128,
+    MOTOR_SEQUENCE_INTERRUPTED = 129,
     HEATER_THERMISTOR_A_DISCONNECTED = 201,
     HEATER_THERMISTOR_A_SHORT = 202,
     HEATER_THERMISTOR_A_OVERTEMP = 203,
@@ -19,8 +19,11 @@
 #include <utility>
 
 #include "core/gcode_parser.hpp"
+#include "core/relay_autotune.hpp"
+#include "core/task_stats_gcode.hpp"
 #include "core/utility.hpp"
 #include "heater-shaker/errors.hpp"
+#include "heater-shaker/shake_sequence.hpp"
 #include "systemwide.h"
 
 namespace gcode {
@@ -66,16 +69,112 @@ struct SetRPM {
     }
 };
 
+struct RunShakeSequence {
+    /*
+    ** RunShakeSequence runs a list of speed segments on the device, so that
+    ** alternating or pulsed mixing keeps its timing without the host
+    ** changing the speed for every segment. Each segment ramps to its speed
+    ** at its ramp rate (in RPM/s) and lasts for its duration (in ms,
+    ** including the ramp). The segments repeat for C cycles, 1 by default,
+    ** and the motor keeps the speed of the last segment once they are done.
+    ** The response is sent when the sequence finishes.
+    ** Format: M3.S [C<cycles>] S<rpm> A<ramp rate> D<ms> [S.. A.. D..]...
+    ** Example: M3.S C10 S1500 A2000 D3000 S500 A2000 D1000 alternates
+    ** between 1500 and 500 RPM ten times
+    */
+    using ParseResult = std::optional<RunShakeSequence>;
+    static constexpr auto prefix = std::array{'M', '3', '.', 'S'};
+    static constexpr auto cycles_prefix = std::array{' ', 'C'};
+    static constexpr auto rpm_prefix = std::array{' ', 'S'};
+    static constexpr auto ramp_prefix = std::array{' ', 'A'};
+    static constexpr auto duration_prefix = std::array{' ', 'D'};
+    static constexpr const char* response = "M3.S OK\n";
+    shake_sequence::Sequence sequence;
+
+    template <typename InputIt, typename InLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InLimit, InputIt>
+    static auto write_response_into(InputIt buf, InLimit limit) -> InputIt {
+        return write_string_to_iterpair(buf, limit, response);
+    }
+
+    template <typename InputIt, typename Limit>
+    requires std::contiguous_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        auto working = prefix_matches(input, limit, prefix);
+        if (working == input) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto ret = RunShakeSequence{.sequence = shake_sequence::Sequence{}};
+
+        auto after_prefix = prefix_matches(working, limit, cycles_prefix);
+        if (after_prefix != working) {
+            auto cycles_res = parse_value<uint16_t>(after_prefix, limit);
+            if (!cycles_res.first.has_value() ||
+                cycles_res.first.value() == 0) {
+                return std::make_pair(ParseResult(), input);
+            }
+            ret.sequence.cycles = cycles_res.first.value();
+            working = cycles_res.second;
+        }
+
+        while (ret.sequence.count < shake_sequence::MAX_SEGMENTS) {
+            after_prefix = prefix_matches(working, limit, rpm_prefix);
+            if (after_prefix == working) {
+                break;
+            }
+            auto rpm_res = parse_value<int16_t>(after_prefix, limit);
+            if (!rpm_res.first.has_value() || rpm_res.first.value() < 0) {
+                return std::make_pair(ParseResult(), input);
+            }
+            after_prefix = prefix_matches(rpm_res.second, limit, ramp_prefix);
+            if (after_prefix == rpm_res.second) {
+                return std::make_pair(ParseResult(), input);
+            }
+            auto ramp_res = parse_value<int32_t>(after_prefix, limit);
+            if (!ramp_res.first.has_value() || ramp_res.first.value() <= 0) {
+                return std::make_pair(ParseResult(), input);
+            }
+            after_prefix =
+                prefix_matches(ramp_res.second, limit, duration_prefix);
+            if (after_prefix == ramp_res.second) {
+                return std::make_pair(ParseResult(), input);
+            }
+            auto duration_res = parse_value<uint32_t>(after_prefix, limit);
+            if (!duration_res.first.has_value()) {
+                return std::make_pair(ParseResult(), input);
+            }
+            ret.sequence.segments.at(ret.sequence.count) =
+                shake_sequence::Segment{
+                    .rpm = rpm_res.first.value(),
+                    .ramp_rate = ramp_res.first.value(),
+                    .duration_ms = duration_res.first.value()};
+            ++ret.sequence.count;
+            working = duration_res.second;
+        }
+        if (ret.sequence.count == 0) {
+            return std::make_pair(ParseResult(), input);
+        }
+        return std::make_pair(ParseResult(ret), working);
+    }
+};
+
 struct SetTemperature {
     /*
     ** SetTemperature uses a standard set-tool-temperature gcode, M104
-    ** Format: M104 S<temp>
+    ** Format: M104 S<temp> [R<ramp rate>]
     ** Example: M104 S25 sets target temperature to 25C
+    ** Example: M104 S60 R0.5 ramps the setpoint to 60C at 0.5C/s
+    ** Without a ramp rate (or with R0), the setpoint jumps to the target.
     */
     using ParseResult = std::optional<SetTemperature>;
     static constexpr auto prefix = std::array{'M', '1', '0', '4', ' ', 'S'};
+    static constexpr auto ramp_prefix = std::array{' ', 'R'};
     static constexpr const char* response = "M104 OK\n";
     double temperature;
+    double ramp_rate = 0.0F;
 
     template <typename InputIt, typename InLimit>
     requires std::forward_iterator<InputIt> &&
@@ -104,9 +203,17 @@ struct SetTemperature {
             return std::make_pair(ParseResult(), input);
         }
 
-        return std::make_pair(
-            ParseResult(SetTemperature{.temperature = value_res.first.value()}),
-            value_res.second);
+        auto ret = SetTemperature{.temperature = value_res.first.value()};
+        working = prefix_matches(value_res.second, limit, ramp_prefix);
+        if (working == value_res.second) {
+            return std::make_pair(ParseResult(ret), value_res.second);
+        }
+        auto ramp_res = parse_value<float>(working, limit);
+        if (!ramp_res.first.has_value() || ramp_res.first.value() < 0) {
+            return std::make_pair(ParseResult(), input);
+        }
+        ret.ramp_rate = ramp_res.first.value();
+        return std::make_pair(ParseResult(ret), ramp_res.second);
     }
 };
 
@@ -470,6 +577,97 @@ struct SetPIDConstants {
     }
 };
 
+struct StartAutotune {
+    /**
+     * StartAutotune uses M303 because smoothieware does. It starts a relay
+     * feedback autotune of the heater PID around the target temperature.
+     * When the autotune completes, the new constants are applied to the
+     * heater. Parameters:
+     * Txxx.xx - the temperature to tune around
+     *
+     * Example: M303 T70\r\n
+     * */
+    double target;
+
+    using ParseResult = std::optional<StartAutotune>;
+    static constexpr auto prefix = std::array{'M', '3', '0', '3', ' ', 'T'};
+    static constexpr const char* response = "M303 OK\n";
+
+    template <typename InputIt, typename InLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputIt, InLimit>
+    static auto write_response_into(InputIt buf, InLimit limit) -> InputIt {
+        return write_string_to_iterpair(buf, limit, response);
+    }
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        auto working = prefix_matches(input, limit, prefix);
+        if (working == input) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto value_res = parse_value<float>(working, limit);
+        if (!value_res.first.has_value()) {
+            return std::make_pair(ParseResult(), input);
+        }
+        return std::make_pair(
+            ParseResult(StartAutotune{.target = value_res.first.value()}),
+            value_res.second);
+    }
+};
+
+struct GetAutotuneResult {
+    /**
+     * GetAutotuneResult uses M304. It reports the progress and result of
+     * the last autotune started with M303:
+     *
+     * M304 R:<status> C:<cycles> U:<ultimate gain> T:<ultimate period>
+     * P:<kp> I:<ki> D:<kd> OK
+     *
+     * The status is one of IDLE, RUNNING, DONE or FAILED, and the
+     * constants are only valid once the status is DONE.
+     * */
+    using ParseResult = std::optional<GetAutotuneResult>;
+    static constexpr auto prefix = std::array{'M', '3', '0', '4'};
+
+    template <typename InputIt, typename InLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputIt, InLimit>
+    static auto write_response_into(InputIt buf, InLimit limit,
+                                    relay_autotune::Status status,
+                                    size_t cycles,
+                                    const relay_autotune::Result& result)
+        -> InputIt {
+        auto res = snprintf(
+            &*buf, (limit - buf),
+            "M304 R:%s C:%u U:%0.4f T:%0.2f P:%0.4f I:%0.4f D:%0.4f OK\n",
+            relay_autotune::status_name(status),
+            static_cast<unsigned int>(cycles),
+            static_cast<float>(result.ultimate_gain),
+            static_cast<float>(result.ultimate_period),
+            static_cast<float>(result.kp), static_cast<float>(result.ki),
+            static_cast<float>(result.kd));
+        if (res <= 0) {
+            return buf;
+        }
+        return buf + std::min(static_cast<decltype(limit - buf)>(res),
+                              (limit - buf));
+    }
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        auto working = prefix_matches(input, limit, prefix);
+        if (working == input) {
+            return std::make_pair(ParseResult(), input);
+        }
+        return std::make_pair(ParseResult(GetAutotuneResult()), working);
+    }
+};
+
 struct SetHeaterPowerTest {
     /**
      * SetHeaterPowerTest is a testing command to directly command heater power
@@ -9,6 +9,8 @@
 #include <variant>
 
 #include "core/pid.hpp"
+#include "core/ramped_setpoint.hpp"
+#include "core/relay_autotune.hpp"
 #include "core/thermistor_conversion.hpp"
 #include "hal/message_queue.hpp"
 #include "heater-shaker/errors.hpp"
@@ -49,6 +51,7 @@ struct State {
         ERROR,
         CONTROLLING,
         POWER_TEST,
+        AUTOTUNING,
     };
     Status system_status;
     enum LEDStatus {
@@ -126,6 +129,8 @@ class HeaterTask {
     static constexpr double KD_MIN = -200;
     static constexpr double KD_MAX = 200;
     static constexpr double HOLDING_THRESHOLD = 2.5F;
+    static constexpr double AUTOTUNE_HYSTERESIS_C = 0.5F;
+    static constexpr double AUTOTUNE_TIMEOUT_S = 3600.0F;
     // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
     static constexpr double CONTROL_PERIOD_S =
         static_cast<uint32_t>(CONTROL_PERIOD_TICKS) * 0.001;
@@ -227,6 +232,13 @@ class HeaterTask {
     }
 
     [[nodiscard]] auto get_pid() const -> const PID& { return pid; }
+    [[nodiscard]] auto get_ramp() const
+        -> const ramped_setpoint::RampedSetpoint& {
+        return ramp;
+    }
+    [[nodiscard]] auto autotuning() const -> bool {
+        return state.system_status == State::AUTOTUNING;
+    }
 
   private:
     template <typename Policy>
@@ -265,7 +277,12 @@ class HeaterTask {
                     errors::ErrorCode::HEATER_ILLEGAL_TARGET_TEMPERATURE;
             } else {
                 setpoint = msg.target_temperature;
-                pid.arm_integrator_reset(setpoint.value() - pad_temperature());
+                ramp.start(pad_temperature(), setpoint.value(), msg.ramp_rate);
+                if (!ramp.ramping()) {
+                    pid.arm_integrator_reset(setpoint.value() -
+                                             pad_temperature());
+                }
+                autotune.abort();
                 state.system_status = State::CONTROLLING;
             }
         }
@@ -286,6 +303,7 @@ class HeaterTask {
                        Policy& policy) -> void {
         policy.disable_power_output();
         setpoint = std::nullopt;
+        autotune.abort();
         auto response =
             messages::AcknowledgePrevious{.responding_to_id = msg.id};
         if (state.system_status == State::ERROR) {
@@ -339,8 +357,7 @@ class HeaterTask {
                        Policy& policy) -> void {
         auto response =
             messages::AcknowledgePrevious{.responding_to_id = msg.id};
-        if ((msg.kp < KP_MIN) || (msg.kp > KP_MAX) || (msg.ki < KI_MIN) ||
-            (msg.ki > KI_MAX) || (msg.kd < KD_MIN) || (msg.kd > KD_MAX)) {
+        if (!pid_constants_in_range(msg.kp, msg.ki, msg.kd)) {
             response.with_error =
                 errors::ErrorCode::HEATER_CONSTANT_OUT_OF_RANGE;
         } else {
@@ -405,38 +422,64 @@ class HeaterTask {
             state.system_status = State::ERROR;
             setpoint = std::nullopt;
         }
+        if (state.system_status != State::AUTOTUNING) {
+            // Any error stops an autotune in progress
+            autotune.abort();
+        }
         // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
         if (state.system_status == State::CONTROLLING) {
-            HEATPAD_CIRCUIT_ERROR error = policy.set_power_output(
-                pid.compute(setpoint.value() - pad_temperature()));
-            if (error != HEATPAD_CIRCUIT_ERROR::HEATPAD_CIRCUIT_NO_ERROR) {
-                state.system_status = State::ERROR;
-                setpoint = std::nullopt;
-                auto error_message = messages::ErrorMessage{};
-                if (error == HEATPAD_CIRCUIT_ERROR::HEATPAD_CIRCUIT_OPEN) {
-                    error_message.code =
-                        errors::ErrorCode::HEATER_HARDWARE_OPEN_CIRCUIT;
-                    state.error_bitmap |= State::OPEN_CIRCUIT_ERROR;
-                } else if (error ==
-                           HEATPAD_CIRCUIT_ERROR::HEATPAD_CIRCUIT_SHORTED) {
-                    error_message.code =
-                        errors::ErrorCode::HEATER_HARDWARE_SHORT_CIRCUIT;
-                    state.error_bitmap |= State::SHORT_CIRCUIT_ERROR;
-                } else if (error ==
-                           HEATPAD_CIRCUIT_ERROR::HEATPAD_CIRCUIT_OVERCURRENT) {
-                    error_message.code =
-                        errors::ErrorCode::HEATER_HARDWARE_OVERCURRENT_CIRCUIT;
-                    state.error_bitmap |= State::OVERCURRENT_CIRCUIT_ERROR;
-                }
-                static_cast<void>(
-                    task_registry->comms->get_message_queue().try_send(
-                        error_message));
-            }
+            set_power_output(
+                policy, ramp.compute(pid, pad_temperature(), CONTROL_PERIOD_S));
+        } else if (state.system_status == State::AUTOTUNING) {
+            update_autotune(policy);
         } else if (state.system_status != State::POWER_TEST) {
             policy.disable_power_output();
         }
     }
 
+    template <typename Policy>
+    requires HeaterExecutionPolicy<Policy>
+    auto visit_message(const messages::StartAutotuneMessage& msg,
+                       Policy& policy) -> void {
+        try_latch_disarm(policy);
+        auto response =
+            messages::AcknowledgePrevious{.responding_to_id = msg.id};
+        if (state.system_status == State::ERROR) {
+            response.with_error = most_relevant_error();
+        } else if (msg.target > MAX_CONTROLLABLE_TEMPERATURE ||
+                   msg.target <= pad_temperature()) {
+            // The heater can't cool, so the target must be above the
+            // current temperature
+            response.with_error =
+                errors::ErrorCode::HEATER_ILLEGAL_TARGET_TEMPERATURE;
+        } else {
+            autotune.start(
+                relay_autotune::Settings{.setpoint = msg.target,
+                                         .output_high = 1.0F,
+                                         .output_low = 0.0F,
+                                         .hysteresis = AUTOTUNE_HYSTERESIS_C,
+                                         .timeout = AUTOTUNE_TIMEOUT_S});
+            setpoint = msg.target;
+            state.system_status = State::AUTOTUNING;
+        }
+        static_cast<void>(task_registry->comms->get_message_queue().try_send(
+            messages::HostCommsMessage(response)));
+    }
+
+    template <typename Policy>
+    requires HeaterExecutionPolicy<Policy>
+    auto visit_message(const messages::GetAutotuneResultMessage& msg,
+                       Policy& policy) -> void {
+        static_cast<void>(policy);
+        auto response =
+            messages::GetAutotuneResultResponse{.responding_to_id = msg.id,
+                                                .status = autotune.status(),
+                                                .cycles = autotune.cycles(),
+                                                .result = autotune.result()};
+        static_cast<void>(task_registry->comms->get_message_queue().try_send(
+            messages::HostCommsMessage(response)));
+    }
+
     template <typename Policy>
     requires HeaterExecutionPolicy<Policy>
     auto visit_message(const messages::SetPowerTestMessage& msg, Policy& policy)
@@ -600,10 +643,86 @@ class HeaterTask {
         return false;
     }
 
+    /**
+     * @brief Set the heater power while controlling, and handle any error
+     * reported by the heater pad circuit.
+     */
+    template <typename Policy>
+    requires HeaterExecutionPolicy<Policy>
+    auto set_power_output(Policy& policy, double power) -> void {
+        HEATPAD_CIRCUIT_ERROR error = policy.set_power_output(power);
+        if (error != HEATPAD_CIRCUIT_ERROR::HEATPAD_CIRCUIT_NO_ERROR) {
+            state.system_status = State::ERROR;
+            setpoint = std::nullopt;
+            autotune.abort();
+            auto error_message = messages::ErrorMessage{};
+            if (error == HEATPAD_CIRCUIT_ERROR::HEATPAD_CIRCUIT_OPEN) {
+                error_message.code =
+                    errors::ErrorCode::HEATER_HARDWARE_OPEN_CIRCUIT;
+                state.error_bitmap |= State::OPEN_CIRCUIT_ERROR;
+            } else if (error ==
+                       HEATPAD_CIRCUIT_ERROR::HEATPAD_CIRCUIT_SHORTED) {
+                error_message.code =
+                    errors::ErrorCode::HEATER_HARDWARE_SHORT_CIRCUIT;
+                state.error_bitmap |= State::SHORT_CIRCUIT_ERROR;
+            } else if (error ==
+                       HEATPAD_CIRCUIT_ERROR::HEATPAD_CIRCUIT_OVERCURRENT) {
+                error_message.code =
+                    errors::ErrorCode::HEATER_HARDWARE_OVERCURRENT_CIRCUIT;
+                state.error_bitmap |= State::OVERCURRENT_CIRCUIT_ERROR;
+            }
+            static_cast<void>(
+                task_registry->comms->get_message_queue().try_send(
+                    error_message));
+        }
+    }
+
+    /** Check PID constants against the limits for setting them.*/
+    [[nodiscard]] static auto pid_constants_in_range(double kp, double ki,
+                                                     double kd) -> bool {
+        return (kp >= KP_MIN) && (kp <= KP_MAX) && (ki >= KI_MIN) &&
+               (ki <= KI_MAX) && (kd >= KD_MIN) && (kd <= KD_MAX);
+    }
+
+    /**
+     * @brief Run the relay autotune from a new pad temperature. Once the
+     * autotune finishes the heater is turned off, and a successful result
+     * is applied to the heater PID. A result outside the limits for setting
+     * the constants by hand is reported as an error instead.
+     */
+    template <typename Policy>
+    requires HeaterExecutionPolicy<Policy>
+    auto update_autotune(Policy& policy) -> void {
+        auto power = autotune.update(pad_temperature(), CONTROL_PERIOD_S);
+        if (autotune.running()) {
+            set_power_output(policy, power);
+            return;
+        }
+        policy.disable_power_output();
+        setpoint = std::nullopt;
+        state.system_status = State::IDLE;
+        if (autotune.status() == relay_autotune::Status::DONE) {
+            const auto& result = autotune.result();
+            if (!pid_constants_in_range(result.kp, result.ki, result.kd)) {
+                auto error_message = messages::HostCommsMessage(
+                    messages::ErrorMessage{
+                        .code =
+                            errors::ErrorCode::HEATER_CONSTANT_OUT_OF_RANGE});
+                static_cast<void>(
+                    task_registry->comms->get_message_queue().try_send(
+                        error_message));
+                return;
+            }
+            pid = PID(result.kp, result.ki, result.kd, CONTROL_PERIOD_S, 1.0,
+                      -1.0);
+        }
+    }
+
     auto update_state_and_leds() -> void {
         auto old_led_status = state.led_status;
         auto message = messages::UpdateLEDStateMessage{};
-        if (state.system_status == State::CONTROLLING) {
+        if (state.system_status == State::CONTROLLING ||
+            state.system_status == State::AUTOTUNING) {
             if (pad_temperature() > HOT_TO_TOUCH_THRESHOLD) {
                 state.led_status = State::HOT_TO_TOUCH_OR_HOLDING;
                 message.mode = LED_MODE::SOLID_HOT;
@@ -716,6 +835,8 @@ class HeaterTask {
     TemperatureSensor board;
     State state;
     PID pid;
+    relay_autotune::RelayAutotune autotune{};
+    ramped_setpoint::RampedSetpoint ramp{};
     std::optional<double> setpoint;
     flash::Flash _flash;
     flash::OffsetConstants _offset_constants;
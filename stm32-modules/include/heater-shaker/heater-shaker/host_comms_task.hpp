@@ -48,7 +48,9 @@ class HostCommsTask {
         gcode::GetPlateLockStateDebug, gcode::SetLEDDebug,
         gcode::IdentifyModuleStartLED, gcode::IdentifyModuleStopLED,
         gcode::SetOffsetConstants, gcode::GetOffsetConstants,
-        gcode::DeactivateHeater>;
+        gcode::DeactivateHeater, gcode::GetTaskStatsDebug,
+        gcode::StartAutotune, gcode::GetAutotuneResult,
+        gcode::RunShakeSequence>;
     using AckOnlyCache =
         AckCache<8, gcode::SetRPM, gcode::SetTemperature,
                  gcode::SetAcceleration, gcode::SetPIDConstants,
@@ -57,7 +59,8 @@ class HostCommsTask {
                  gcode::OpenPlateLock, gcode::ClosePlateLock,
                  gcode::SetSerialNumber, gcode::SetLEDDebug,
                  gcode::IdentifyModuleStartLED, gcode::IdentifyModuleStopLED,
-                 gcode::SetOffsetConstants, gcode::DeactivateHeater>;
+                 gcode::SetOffsetConstants, gcode::DeactivateHeater,
+                 gcode::StartAutotune, gcode::RunShakeSequence>;
     using GetTempCache = AckCache<8, gcode::GetTemperature>;
     using GetTempDebugCache = AckCache<8, gcode::GetTemperatureDebug>;
     using GetRPMCache = AckCache<8, gcode::GetRPM>;
@@ -66,6 +69,7 @@ class HostCommsTask {
     using GetPlateLockStateDebugCache =
         AckCache<8, gcode::GetPlateLockStateDebug>;
     using GetOffsetConstantsCache = AckCache<8, gcode::GetOffsetConstants>;
+    using GetAutotuneResultCache = AckCache<8, gcode::GetAutotuneResult>;
 
   public:
     static constexpr size_t TICKS_TO_WAIT_ON_SEND = 10;
@@ -88,7 +92,9 @@ class HostCommsTask {
           // NOLINTNEXTLINE(readability-redundant-member-init)
           get_plate_lock_state_debug_cache(),
           // NOLINTNEXTLINE(readability-redundant-member-init)
-          get_offset_constants_cache() {}
+          get_offset_constants_cache(),
+          // NOLINTNEXTLINE(readability-redundant-member-init)
+          get_autotune_result_cache() {}
     HostCommsTask(const HostCommsTask& other) = delete;
     auto operator=(const HostCommsTask& other) -> HostCommsTask& = delete;
     HostCommsTask(HostCommsTask&& other) noexcept = delete;
@@ -438,6 +444,29 @@ class HostCommsTask {
             cache_entry);
     }
 
+    template <typename InputIt, typename InputLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputLimit, InputIt>
+    auto visit_message(const messages::GetAutotuneResultResponse& response,
+                       InputIt tx_into, InputLimit tx_limit) -> InputIt {
+        auto cache_entry = get_autotune_result_cache.remove_if_present(
+            response.responding_to_id);
+        return std::visit(
+            [tx_into, tx_limit, response](auto cache_element) {
+                using T = std::decay_t<decltype(cache_element)>;
+                if constexpr (std::is_same_v<std::monostate, T>) {
+                    return errors::write_into(
+                        tx_into, tx_limit,
+                        errors::ErrorCode::BAD_MESSAGE_ACKNOWLEDGEMENT);
+                } else {
+                    return cache_element.write_response_into(
+                        tx_into, tx_limit, response.status, response.cycles,
+                        response.result);
+                }
+            },
+            cache_entry);
+    }
+
     /**
      * visit_gcode() is a set of member function overloads, each of which is
      * called when we parse the appropriate gcode out of the receive buffer.
@@ -690,6 +719,29 @@ class HostCommsTask {
         return std::make_pair(true, tx_into);
     }
 
+    template <typename InputIt, typename InputLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputLimit, InputIt>
+    auto visit_gcode(const gcode::RunShakeSequence& gcode, InputIt tx_into,
+                     InputLimit tx_limit) -> std::pair<bool, InputIt> {
+        auto id = ack_only_cache.add(gcode);
+        if (id == 0) {
+            return std::make_pair(
+                false, errors::write_into(tx_into, tx_limit,
+                                          errors::ErrorCode::GCODE_CACHE_FULL));
+        }
+        auto message = messages::RunShakeSequenceMessage{
+            .id = id, .sequence = gcode.sequence};
+        if (!task_registry->motor->get_message_queue().try_send(
+                message, TICKS_TO_WAIT_ON_SEND)) {
+            auto wrote_to = errors::write_into(
+                tx_into, tx_limit, errors::ErrorCode::INTERNAL_QUEUE_FULL);
+            ack_only_cache.remove_if_present(id);
+            return std::make_pair(false, wrote_to);
+        }
+        return std::make_pair(true, tx_into);
+    }
+
     template <typename InputIt, typename InputLimit>
     requires std::forward_iterator<InputIt> &&
         std::sized_sentinel_for<InputLimit, InputIt>
@@ -747,7 +799,9 @@ class HostCommsTask {
                                           errors::ErrorCode::GCODE_CACHE_FULL));
         }
         auto message = messages::SetTemperatureMessage{
-            .id = id, .target_temperature = gcode.temperature};
+            .id = id,
+            .target_temperature = gcode.temperature,
+            .ramp_rate = gcode.ramp_rate};
         if (!task_registry->heater->get_message_queue().try_send(
                 message, TICKS_TO_WAIT_ON_SEND)) {
             auto wrote_to = errors::write_into(
@@ -1043,6 +1097,70 @@ class HostCommsTask {
         return std::make_pair(true, tx_into);
     }
 
+    template <typename InputIt, typename InputLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputLimit, InputIt>
+    auto visit_gcode(const gcode::StartAutotune& gcode, InputIt tx_into,
+                     InputLimit tx_limit) -> std::pair<bool, InputIt> {
+        auto id = ack_only_cache.add(gcode);
+        if (id == 0) {
+            return std::make_pair(
+                false, errors::write_into(tx_into, tx_limit,
+                                          errors::ErrorCode::GCODE_CACHE_FULL));
+        }
+        auto message =
+            messages::StartAutotuneMessage{.id = id, .target = gcode.target};
+        if (!task_registry->heater->get_message_queue().try_send(
+                message, TICKS_TO_WAIT_ON_SEND)) {
+            auto wrote_to = errors::write_into(
+                tx_into, tx_limit, errors::ErrorCode::INTERNAL_QUEUE_FULL);
+            ack_only_cache.remove_if_present(id);
+            return std::make_pair(false, wrote_to);
+        }
+        return std::make_pair(true, tx_into);
+    }
+
+    template <typename InputIt, typename InputLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputLimit, InputIt>
+    auto visit_gcode(const gcode::GetAutotuneResult& gcode, InputIt tx_into,
+                     InputLimit tx_limit) -> std::pair<bool, InputIt> {
+        auto id = get_autotune_result_cache.add(gcode);
+        if (id == 0) {
+            return std::make_pair(
+                false, errors::write_into(tx_into, tx_limit,
+                                          errors::ErrorCode::GCODE_CACHE_FULL));
+        }
+        auto message = messages::GetAutotuneResultMessage{.id = id};
+        if (!task_registry->heater->get_message_queue().try_send(
+                message, TICKS_TO_WAIT_ON_SEND)) {
+            auto wrote_to = errors::write_into(
+                tx_into, tx_limit, errors::ErrorCode::INTERNAL_QUEUE_FULL);
+            get_autotune_result_cache.remove_if_present(id);
+            return std::make_pair(false, wrote_to);
+        }
+        return std::make_pair(true, tx_into);
+    }
+
+    template <typename InputIt, typename InputLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputLimit, InputIt>
+    auto visit_gcode(const gcode::GetTaskStatsDebug& gcode, InputIt tx_into,
+                     InputLimit tx_limit) -> std::pair<bool, InputIt> {
+        // Queue statistics are kept atomically by each queue, so they can
+        // be read directly without messaging the other tasks.
+        static constexpr std::array<const char*, 4> names{"Comms", "Heater",
+                                                          "Motor", "System"};
+        auto stats = std::array{
+            message_queue.get_stats(),
+            task_registry->heater->get_message_queue().get_stats(),
+            task_registry->motor->get_message_queue().get_stats(),
+            task_registry->system->get_message_queue().get_stats()};
+        auto wrote_to =
+            gcode.write_response_into(tx_into, tx_limit, names, stats);
+        return std::make_pair(true, wrote_to);
+    }
+
     Queue& message_queue;
     tasks::Tasks<QueueImpl>* task_registry;
     AckOnlyCache ack_only_cache;
@@ -1053,6 +1171,7 @@ class HostCommsTask {
     GetPlateLockStateCache get_plate_lock_state_cache;
     GetPlateLockStateDebugCache get_plate_lock_state_debug_cache;
     GetOffsetConstantsCache get_offset_constants_cache;
+    GetAutotuneResultCache get_autotune_result_cache;
     bool may_connect_latch = true;
 };
 
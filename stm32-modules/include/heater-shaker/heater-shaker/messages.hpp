@@ -1,11 +1,14 @@
 #pragma once
 #include <array>
 #include <concepts>
+#include <cstddef>
 #include <cstdint>
 #include <optional>
 #include <variant>
 
+#include "core/relay_autotune.hpp"
 #include "heater-shaker/errors.hpp"
+#include "heater-shaker/shake_sequence.hpp"
 #include "systemwide.h"
 
 namespace messages {
@@ -49,12 +52,19 @@ struct SetTemperatureMessage {
     uint32_t id;
     double target_temperature;
     bool from_system = false;
+    // Rate to ramp the setpoint at in ºC/s, or 0 to jump to the target
+    double ramp_rate = 0.0F;
 };
 
 struct GetTemperatureMessage {
     uint32_t id;
 };
 
+struct RunShakeSequenceMessage {
+    uint32_t id;
+    shake_sequence::Sequence sequence;
+};
+
 struct GetTemperatureDebugMessage {
     uint32_t id;
 };
@@ -156,6 +166,13 @@ struct CheckHomingStatusMessage {
     bool from_startup = false;
 };
 
+// Used internally to the motor task to time the segments of a shake sequence
+struct CheckShakeSequenceMessage {
+    // The sequence this check belongs to, so that checks left over from an
+    // interrupted sequence are ignored
+    uint32_t run;
+};
+
 struct ErrorMessage {
     errors::ErrorCode code;
 };
@@ -273,6 +290,22 @@ struct DeactivateHeaterMessage {
     uint32_t id;
 };
 
+struct StartAutotuneMessage {
+    uint32_t id;
+    double target;
+};
+
+struct GetAutotuneResultMessage {
+    uint32_t id;
+};
+
+struct GetAutotuneResultResponse {
+    uint32_t responding_to_id;
+    relay_autotune::Status status;
+    size_t cycles;
+    relay_autotune::Result result;
+};
+
 struct AcknowledgePrevious {
     uint32_t responding_to_id;
     errors::ErrorCode with_error = errors::ErrorCode::NO_ERROR;
@@ -288,14 +321,16 @@ using HeaterMessage =
                    TemperatureConversionComplete, GetTemperatureDebugMessage,
                    SetPIDConstantsMessage, SetPowerTestMessage,
                    HandleNTCSetupError, SetOffsetConstantsMessage,
-                   GetOffsetConstantsMessage, DeactivateHeaterMessage>;
+                   GetOffsetConstantsMessage, DeactivateHeaterMessage,
+                   StartAutotuneMessage, GetAutotuneResultMessage>;
 using MotorMessage = ::std::variant<
     std::monostate, MotorSystemErrorMessage, SetRPMMessage, GetRPMMessage,
     SetAccelerationMessage, CheckHomingStatusMessage, BeginHomingMessage,
     ActuateSolenoidMessage, SetPlateLockPowerMessage, OpenPlateLockMessage,
     ClosePlateLockMessage, SetPIDConstantsMessage, PlateLockComplete,
     GetPlateLockStateMessage, GetPlateLockStateDebugMessage,
-    CheckPlateLockStatusMessage>;
+    CheckPlateLockStatusMessage, RunShakeSequenceMessage,
+    CheckShakeSequenceMessage>;
 using SystemMessage =
     ::std::variant<std::monostate, EnterBootloaderMessage, AcknowledgePrevious,
                    SetSerialNumberMessage, GetSystemInfoMessage, SetLEDMessage,
@@ -307,5 +342,6 @@ using HostCommsMessage =
                    ErrorMessage, GetTemperatureResponse, GetRPMResponse,
                    GetTemperatureDebugResponse, ForceUSBDisconnectMessage,
                    GetPlateLockStateResponse, GetPlateLockStateDebugResponse,
-                   GetSystemInfoResponse, GetOffsetConstantsResponse>;
+                   GetSystemInfoResponse, GetOffsetConstantsResponse,
+                   GetAutotuneResultResponse>;
 };  // namespace messages
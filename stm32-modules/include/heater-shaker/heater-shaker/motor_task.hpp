@@ -9,6 +9,7 @@
 
 #include "hal/message_queue.hpp"
 #include "heater-shaker/messages.hpp"
+#include "heater-shaker/shake_sequence.hpp"
 #include "heater-shaker/tasks.hpp"
 #include "systemwide.h"
 namespace tasks {
@@ -53,6 +54,7 @@ concept MotorExecutionPolicy = requires(Policy& p, const Policy& cp) {
     {p.homing_solenoid_engage(122)};
     // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
     {p.delay_ticks(10)};
+    { p.get_time_ms() } -> std::same_as<uint32_t>;
     // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
     {p.plate_lock_set_power(0.1)};
     {p.plate_lock_disable()};
@@ -85,6 +87,23 @@ struct PlateLockState {
     PlateLockTaskStatus status;
 };
 
+/*
+ * The progress through a shake sequence. Each run of a sequence gets a new
+ * run number so that checks queued by a sequence that was interrupted are
+ * ignored by the one that replaced it.
+ */
+struct ShakeSequenceState {
+    shake_sequence::Sequence sequence;
+    uint32_t response_id;
+    uint32_t run;
+    uint8_t segment;
+    uint16_t cycle;
+    // When the current segment started, from the policy's clock. Any
+    // kickstart counts towards the segment.
+    uint32_t segment_start_ms;
+    bool active;
+};
+
 constexpr size_t RESPONSE_LENGTH = 128;
 using Message = ::messages::MotorMessage;
 template <template <class> class QueueImpl>
@@ -96,6 +115,9 @@ class MotorTask {
         200;  // needed to ensure motor setup complete at startup before homing
     static constexpr const uint16_t MOTOR_START_WAIT_TICKS = 1000;
     static constexpr const uint16_t SOLENOID_ENGAGE_WAIT_TICKS = 1000;
+    // The longest wait between checks of a shake sequence, so that other
+    // messages are still handled promptly during long segments
+    static constexpr const uint32_t SHAKE_SEQUENCE_CHECK_TICKS = 50;
     static constexpr const uint16_t POST_HOMING_WAIT_TICKS =
         500;  // needed to ensure motor control deactivated before subsequent
               // SetRPM commands
@@ -128,6 +150,13 @@ class MotorTask {
           message_queue(q),
           task_registry(nullptr),
           setpoint(0),
+          shake{.sequence = shake_sequence::Sequence{},
+                .response_id = 0,
+                .run = 0,
+                .segment = 0,
+                .cycle = 0,
+                .segment_start_ms = 0,
+                .active = false},
           _homing_rotation_limit_low_rpm(200),
           _homing_rotation_limit_high_rpm(250),
           _serial_initialized(false) {}
@@ -147,6 +176,9 @@ class MotorTask {
     [[nodiscard]] auto get_homing_speed() const -> uint16_t {
         return _homing_rotation_limit_low_rpm;
     }
+    [[nodiscard]] auto shake_sequence_active() const -> bool {
+        return shake.active;
+    }
     void provide_tasks(tasks::Tasks<QueueImpl>* other_tasks) {
         task_registry = other_tasks;
     }
@@ -175,22 +207,33 @@ class MotorTask {
         static_cast<void>(policy);
     }
 
+    // Why the motor can't be started right now, if it can't
     template <typename Policy>
-    auto visit_message(const messages::SetRPMMessage& msg, Policy& policy)
-        -> void {
-        auto error = errors::ErrorCode::NO_ERROR;
+    auto spin_up_error(Policy& policy) const -> errors::ErrorCode {
         if (current_error !=
             errors::ErrorCode::NO_ERROR) {  // motor-control error
                                             // supercedes illegal-speed
                                             // and unable-to-move errors
-            error = current_error;
-        } else if ((!policy.plate_lock_closed_sensor_read()) &&
-                   (plate_lock_state.status != PlateLockState::IDLE_CLOSED)) {
-            error = errors::ErrorCode::PLATE_LOCK_NOT_CLOSED;
-        } else if ((state.status == State::HOMING_MOVING_TO_HOME_SPEED) ||
-                   (state.status == State::HOMING_COASTING_TO_STOP)) {
-            error = errors::ErrorCode::MOTOR_HOMING;
-        } else {
+            return current_error;
+        }
+        if ((!policy.plate_lock_closed_sensor_read()) &&
+            (plate_lock_state.status != PlateLockState::IDLE_CLOSED)) {
+            return errors::ErrorCode::PLATE_LOCK_NOT_CLOSED;
+        }
+        if ((state.status == State::HOMING_MOVING_TO_HOME_SPEED) ||
+            (state.status == State::HOMING_COASTING_TO_STOP)) {
+            return errors::ErrorCode::MOTOR_HOMING;
+        }
+        return errors::ErrorCode::NO_ERROR;
+    }
+
+    template <typename Policy>
+    auto visit_message(const messages::SetRPMMessage& msg, Policy& policy)
+        -> void {
+        auto error = spin_up_error(policy);
+        if (error == errors::ErrorCode::NO_ERROR) {
+            finish_shake_sequence(
+                errors::ErrorCode::MOTOR_SEQUENCE_INTERRUPTED);
             policy.homing_solenoid_disengage();
             if ((msg.target_rpm < MOTOR_KICKSTART_RPM) &&
                 (msg.target_rpm > 0) &&
@@ -296,6 +339,7 @@ class MotorTask {
                     state.status = State::ERROR;
                     setpoint = 0;
                     current_error = code;
+                    finish_shake_sequence(code);
                     static_cast<void>(
                         task_registry->comms->get_message_queue().try_send(
                             messages::HostCommsMessage(
@@ -413,6 +457,8 @@ class MotorTask {
                         .with_error =
                             errors::ErrorCode::PLATE_LOCK_NOT_CLOSED}));
         } else {
+            finish_shake_sequence(
+                errors::ErrorCode::MOTOR_SEQUENCE_INTERRUPTED);
             state.status = State::HOMING_MOVING_TO_HOME_SPEED;
             policy.homing_solenoid_disengage();
             policy.set_rpm(MOTOR_KICKSTART_RPM);
@@ -445,6 +491,125 @@ class MotorTask {
         }
     }
 
+    /**
+     * A shake sequence is timed the same way as homing: rather than
+     * blocking for the length of each segment, the task sends itself a
+     * CheckShakeSequenceMessage after each short wait and moves on to the
+     * next segment once the current one has lasted long enough. A sequence
+     * with any segment outside the motor's limits is refused before it
+     * starts. The host is acknowledged once every cycle of the sequence is
+     * done, or with an error if the sequence is interrupted by another speed
+     * command, by homing, or by a motor error.
+     */
+    template <typename Policy>
+    auto visit_message(const messages::RunShakeSequenceMessage& msg,
+                       Policy& policy) -> void {
+        auto error = spin_up_error(policy);
+        if ((error == errors::ErrorCode::NO_ERROR) && !msg.sequence.valid()) {
+            error = errors::ErrorCode::MOTOR_ILLEGAL_SPEED;
+        }
+        if (error == errors::ErrorCode::NO_ERROR) {
+            error = msg.sequence.limits_error();
+        }
+        if (error == errors::ErrorCode::NO_ERROR) {
+            finish_shake_sequence(
+                errors::ErrorCode::MOTOR_SEQUENCE_INTERRUPTED);
+            auto start_ms = policy.get_time_ms();
+            shake = ShakeSequenceState{.sequence = msg.sequence,
+                                       .response_id = msg.id,
+                                       .run = shake.run + 1,
+                                       .segment = 0,
+                                       .cycle = 0,
+                                       .segment_start_ms = start_ms,
+                                       .active = true};
+            error = start_shake_segment(policy);
+            if (error == errors::ErrorCode::NO_ERROR) {
+                static_cast<void>(get_message_queue().try_send(
+                    messages::CheckShakeSequenceMessage{.run = shake.run}));
+                return;
+            }
+            shake.active = false;
+        }
+        static_cast<void>(task_registry->comms->get_message_queue().try_send(
+            messages::AcknowledgePrevious{.responding_to_id = msg.id,
+                                          .with_error = error}));
+    }
+
+    template <typename Policy>
+    auto visit_message(const messages::CheckShakeSequenceMessage& msg,
+                       Policy& policy) -> void {
+        if (!shake.active || (msg.run != shake.run)) {
+            return;
+        }
+        const auto& segment = shake.sequence.segments.at(shake.segment);
+        // Unsigned, so this stays right when the clock wraps
+        auto elapsed = policy.get_time_ms() - shake.segment_start_ms;
+        if (elapsed < segment.duration_ms) {
+            auto wait = std::min(segment.duration_ms - elapsed,
+                                 SHAKE_SEQUENCE_CHECK_TICKS);
+            policy.delay_ticks(static_cast<uint16_t>(wait));
+            static_cast<void>(get_message_queue().try_send(
+                messages::CheckShakeSequenceMessage{.run = shake.run}));
+            return;
+        }
+        // The next segment starts when this one was due to end, so that a
+        // late check doesn't push back the rest of the sequence
+        shake.segment_start_ms += segment.duration_ms;
+        ++shake.segment;
+        if (shake.segment >= shake.sequence.count) {
+            shake.segment = 0;
+            ++shake.cycle;
+        }
+        if (shake.cycle >= shake.sequence.cycles) {
+            // The motor keeps the speed of the last segment
+            finish_shake_sequence(errors::ErrorCode::NO_ERROR);
+            return;
+        }
+        auto error = start_shake_segment(policy);
+        if (error != errors::ErrorCode::NO_ERROR) {
+            policy.set_rpm(0);
+            setpoint = 0;
+            finish_shake_sequence(error);
+            return;
+        }
+        static_cast<void>(get_message_queue().try_send(
+            messages::CheckShakeSequenceMessage{.run = shake.run}));
+    }
+
+    // Ramp towards the speed of the current segment of the shake sequence
+    template <typename Policy>
+    auto start_shake_segment(Policy& policy) -> errors::ErrorCode {
+        const auto& segment = shake.sequence.segments.at(shake.segment);
+        auto error = policy.set_ramp_rate(segment.ramp_rate);
+        if (error != errors::ErrorCode::NO_ERROR) {
+            return error;
+        }
+        policy.homing_solenoid_disengage();
+        if ((segment.rpm < MOTOR_KICKSTART_RPM) && (segment.rpm > 0) &&
+            (setpoint == 0)) {
+            policy.set_rpm(MOTOR_KICKSTART_RPM);
+            policy.delay_ticks(MOTOR_START_WAIT_TICKS);
+        }
+        error = policy.set_rpm(segment.rpm);
+        if (error == errors::ErrorCode::NO_ERROR) {
+            setpoint = segment.rpm;
+            state.status = State::RUNNING;
+        }
+        return error;
+    }
+
+    // Acknowledge the running shake sequence, if there is one, and stop
+    // timing it. The motor is left as it is.
+    auto finish_shake_sequence(errors::ErrorCode error) -> void {
+        if (!shake.active) {
+            return;
+        }
+        shake.active = false;
+        static_cast<void>(task_registry->comms->get_message_queue().try_send(
+            messages::AcknowledgePrevious{
+                .responding_to_id = shake.response_id, .with_error = error}));
+    }
+
     template <typename Policy>
     auto visit_message(const messages::ActuateSolenoidMessage& msg,
                        Policy& policy) -> void {
@@ -665,6 +830,7 @@ class MotorTask {
     uint32_t polling_time = 0;
     errors::ErrorCode current_error = errors::ErrorCode::NO_ERROR;
     int16_t setpoint;
+    ShakeSequenceState shake;
     int16_t _homing_rotation_limit_low_rpm;
     int16_t _homing_rotation_limit_high_rpm;
     bool _serial_initialized;
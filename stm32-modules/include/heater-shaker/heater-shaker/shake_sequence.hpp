@@ -0,0 +1,65 @@
+/*
+ * A shake sequence is a list of segments that the motor task runs on its own,
+ * so that mixing protocols with alternating or pulsed speeds keep their timing
+ * without the host sending a new speed for every change.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "heater-shaker/errors.hpp"
+
+namespace shake_sequence {
+
+struct Segment {
+    // Target speed for the segment, which may be 0 to pause
+    int16_t rpm;
+    // Ramp rate to reach the target speed, in RPM/s
+    int32_t ramp_rate;
+    // Length of the segment, in milliseconds. This includes the time spent
+    // ramping to the target speed.
+    uint32_t duration_ms;
+};
+
+// The most segments a sequence can hold
+static constexpr size_t MAX_SEGMENTS = 8;
+
+// The speeds and ramp rates the motor accepts. Every segment is checked
+// against these before a sequence starts, so that a bad segment is rejected
+// up front rather than stopping the motor partway through the sequence.
+static constexpr int16_t MIN_RPM = 0;
+static constexpr int16_t MAX_RPM = 4110;
+static constexpr int32_t MIN_RAMP_RATE_RPM_PER_S = 1;
+static constexpr int32_t MAX_RAMP_RATE_RPM_PER_S = 20000;
+
+struct Sequence {
+    std::array<Segment, MAX_SEGMENTS> segments{};
+    // Number of valid entries in segments
+    uint8_t count = 0;
+    // Number of times to run through the segments
+    uint16_t cycles = 1;
+
+    [[nodiscard]] auto valid() const -> bool {
+        return (count > 0) && (count <= MAX_SEGMENTS) && (cycles > 0);
+    }
+
+    // The error the motor would give for the first segment it can't run,
+    // or NO_ERROR if it can run all of them
+    [[nodiscard]] auto limits_error() const -> errors::ErrorCode {
+        for (size_t i = 0; (i < count) && (i < MAX_SEGMENTS); ++i) {
+            const auto& segment = segments.at(i);
+            if ((segment.rpm < MIN_RPM) || (segment.rpm > MAX_RPM)) {
+                return errors::ErrorCode::MOTOR_ILLEGAL_SPEED;
+            }
+            if ((segment.ramp_rate < MIN_RAMP_RATE_RPM_PER_S) ||
+                (segment.ramp_rate > MAX_RAMP_RATE_RPM_PER_S)) {
+                return errors::ErrorCode::MOTOR_ILLEGAL_RAMP_RATE;
+            }
+        }
+        return errors::ErrorCode::NO_ERROR;
+    }
+};
+
+}  // namespace shake_sequence
@@ -4,5 +4,21 @@
 #include "simulator/sim_driver.hpp"
 
 namespace cli_parser {
-std::shared_ptr<sim_driver::SimDriver> get_sim_driver(int, char**);
-}
\ No newline at end of file
+/**
+ * First value is the sim input driver, second input is a boolean
+ * set to true if the sim should run in realtime and false if it
+ * should run in simulated time
+ */
+using RT = std::pair<std::shared_ptr<sim_driver::SimDriver>, bool>;
+
+/**
+ * Parse the inputs and determine 1) what kind of input should be
+ * used 2) whether the simulation should be realtime or accelerated.
+ * The speedup of the simulated clock is written to the last argument,
+ * and is sim_clock::SimClock::LOCKSTEP unless one was given.
+ */
+RT get_sim_driver(int, char**, double&);
+
+bool check_realtime_environment_variable();
+
+}  // namespace cli_parser
@@ -1,13 +1,18 @@
 #pragma once
 #include <memory>
-#include <thread>
 
 #include "heater-shaker/heater_task.hpp"
 #include "heater-shaker/tasks.hpp"
+#include "simulator/sim_worker_pool.hpp"
 #include "simulator/simulator_queue.hpp"
 
 namespace heater_thread {
 using SimHeaterTask = heater_task::HeaterTask<SimulatorMessageQueue>;
 struct TaskControlBlock;
-auto build() -> tasks::Task<std::unique_ptr<std::jthread>, SimHeaterTask>;
+/**
+ * Add the heater task to a worker pool. It handles its messages as they
+ * arrive, and the heater pads are converted once every control period.
+ */
+auto build(sim_worker_pool::WorkerPool& pool)
+    -> tasks::Task<std::shared_ptr<TaskControlBlock>, SimHeaterTask>;
 };  // namespace heater_thread
@@ -1,13 +1,15 @@
 #pragma once
 #include <memory>
-#include <thread>
 
 #include "heater-shaker/motor_task.hpp"
 #include "heater-shaker/tasks.hpp"
+#include "simulator/sim_worker_pool.hpp"
 #include "simulator/simulator_queue.hpp"
 
 namespace motor_thread {
 using SimMotorTask = motor_task::MotorTask<SimulatorMessageQueue>;
 struct TaskControlBlock;
-auto build() -> tasks::Task<std::unique_ptr<std::jthread>, SimMotorTask>;
+/** Add the motor task to a worker pool, timed by the pool's clock.*/
+auto build(sim_worker_pool::WorkerPool& pool)
+    -> tasks::Task<std::shared_ptr<TaskControlBlock>, SimMotorTask>;
 };  // namespace motor_thread
@@ -1,13 +1,14 @@
 #pragma once
 #include <memory>
-#include <thread>
 
 #include "heater-shaker/system_task.hpp"
 #include "heater-shaker/tasks.hpp"
+#include "simulator/sim_worker_pool.hpp"
 #include "simulator/simulator_queue.hpp"
 
 namespace system_thread {
 using SimSystemTask = system_task::SystemTask<SimulatorMessageQueue>;
 struct TaskControlBlock;
-auto build() -> tasks::Task<std::unique_ptr<std::jthread>, SimSystemTask>;
+auto build(sim_worker_pool::WorkerPool& pool)
+    -> tasks::Task<std::shared_ptr<TaskControlBlock>, SimSystemTask>;
 };  // namespace system_thread
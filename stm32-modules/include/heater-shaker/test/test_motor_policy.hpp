@@ -28,6 +28,7 @@ class TestMotorPolicy {
     auto homing_solenoid_engage(uint16_t current_ma) -> void;
 
     auto delay_ticks(uint16_t ticks) -> void;
+    [[nodiscard]] auto get_time_ms() const -> uint32_t;
 
     auto plate_lock_set_power(float power) -> void;
     auto plate_lock_disable() -> void;
@@ -44,6 +45,8 @@ class TestMotorPolicy {
     auto test_set_rpm_return_code(errors::ErrorCode code) -> void;
     auto test_set_ramp_rate_return_code(errors::ErrorCode code) -> void;
     [[nodiscard]] auto test_get_last_delay() const -> uint16_t;
+    // Time passes only through delay_ticks unless advanced here
+    auto test_advance_time(uint32_t ms) -> void;
 
     [[nodiscard]] auto test_plate_lock_get_power() const -> float;
     [[nodiscard]] auto test_plate_lock_enabled() const -> bool;
@@ -70,6 +73,7 @@ class TestMotorPolicy {
     bool solenoid_engaged = false;
     uint16_t solenoid_current = 0;
     uint16_t last_delay = 0;
+    uint32_t time_ms = 0;
     float plate_lock_power = 0;
     bool plate_lock_enabled = false;
     double overridden_ki = 0.0;
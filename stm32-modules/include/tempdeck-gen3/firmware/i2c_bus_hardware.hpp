@@ -0,0 +1,73 @@
+/**
+ * @file i2c_bus_hardware.hpp
+ * @brief Connects the shared I2C bus manager to the I2C hardware.
+ * @details The thermal bus is shared by the ADS1115 thermistor ADC and the
+ * EEPROM, so it is owned by an i2c_bus::BusManager. The thermistor reads
+ * go ahead of any EEPROM writes that are waiting, and each transfer is
+ * started from the completion interrupt of the last one. The LED driver has
+ * a bus of its own and keeps using the blocking functions in i2c_hardware.h.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "core/i2c_bus.hpp"
+#include "firmware/i2c_hardware.h"
+
+namespace i2c_bus_hardware {
+
+class I2CBusPolicy {
+  public:
+    explicit I2CBusPolicy(I2C_BUS bus) : _bus(bus) {}
+
+    auto i2c_bus_start(const i2c_bus::Transaction& transaction) -> bool;
+    auto i2c_bus_lock() -> void;
+    auto i2c_bus_unlock() -> void;
+
+  private:
+    I2C_BUS _bus;
+    // Interrupt mask to restore when the lock is released
+    uint32_t _saved_mask = 0;
+};
+
+using BusManager = i2c_bus::BusManager<I2CBusPolicy>;
+
+/**
+ * @brief Initialize the I2C hardware and hand the thermal bus over to its
+ * manager. Every task that uses the thermal bus should call this first.
+ */
+auto initialize() -> void;
+
+/** The manager that owns the thermal bus.*/
+auto thermal_bus() -> BusManager&;
+
+/**
+ * @brief Runs transactions from a task, blocking until each one finishes.
+ * @details The result of each transaction is stored in this object by its
+ * callback, so it must outlive any transaction that it submits. Each task
+ * should keep its own instance, typically in its policy.
+ */
+class BlockingTransfer {
+  public:
+    /** How long to wait for a transaction, including time in the queue.*/
+    static constexpr uint32_t TIMEOUT_MS = 100;
+
+    /**
+     * @brief Submit a transaction and wait for it to finish.
+     * @param bus The bus to run the transaction on
+     * @param transaction The transaction. Its callback and context are
+     * replaced.
+     * @return True if the transaction succeeded
+     */
+    auto run(BusManager& bus, i2c_bus::Transaction transaction) -> bool;
+
+  private:
+    static auto done(const i2c_bus::Transaction& transaction, bool success,
+                     void* context) -> void;
+
+    void* _task = nullptr;
+    std::atomic_bool _success = false;
+};
+
+}  // namespace i2c_bus_hardware
@@ -16,6 +16,21 @@ typedef enum I2C_BUS {
 
 #define IS_I2C_BUS(bus) (bus == I2C_BUS_THERMAL || bus == I2C_BUS_LED)
 
+/** Transfer types for i2c_hardware_start_transfer. These match the order of
+ * i2c_bus::Type.*/
+typedef enum I2C_TRANSFER_TYPE {
+    I2C_TRANSFER_WRITE,
+    I2C_TRANSFER_READ,
+    I2C_TRANSFER_MEM_WRITE,
+    I2C_TRANSFER_MEM_READ,
+} I2C_TRANSFER_TYPE;
+
+/**
+ * @brief Called from interrupt context when a transfer started with
+ * i2c_hardware_start_transfer finishes.
+ */
+typedef void (*i2c_hardware_complete_callback)(I2C_BUS bus, bool success);
+
 void i2c_hardware_init();
 
 /**
@@ -83,6 +98,34 @@ bool i2c_hardware_read_data(I2C_BUS bus, uint16_t addr, uint8_t *data,
 bool i2c_hardware_mem_write(I2C_BUS bus, uint16_t addr, uint8_t reg,
                             uint8_t *data, uint16_t len);
 
+/**
+ * @brief Route the completion of every transfer on a bus that no task is
+ * blocking on to a callback. This hands the bus over to an asynchronous
+ * bus manager, so the blocking functions above should not be used on
+ * that bus afterwards.
+ * @param callback The callback, or NULL to stop routing completions
+ */
+void i2c_hardware_set_complete_callback(
+    I2C_BUS bus, i2c_hardware_complete_callback callback);
+
+/**
+ * @brief Start a transfer without waiting for it to finish. The transfer
+ * uses DMA on busses that have it, and interrupts otherwise. The completion
+ * callback of the bus is called once it finishes.
+ * @note Callable from interrupt context
+ *
+ * @param type The type of transfer
+ * @param addr I2C device address
+ * @param reg The register address, for memory transfers
+ * @param data The data to write, or the buffer to read into. Must stay
+ * valid until the transfer finishes.
+ * @param len Number of bytes in \c data
+ * @return True if the transfer was started, false otherwise
+ */
+bool i2c_hardware_start_transfer(I2C_BUS bus, I2C_TRANSFER_TYPE type,
+                                 uint16_t addr, uint8_t reg, uint8_t *data,
+                                 uint16_t len);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
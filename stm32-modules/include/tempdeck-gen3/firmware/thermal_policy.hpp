@@ -3,7 +3,7 @@
 #include <cstdint>
 #include <iterator>
 
-#include "firmware/i2c_hardware.h"
+#include "firmware/i2c_bus_hardware.hpp"
 
 namespace thermal_policy {
 
@@ -31,15 +31,26 @@ class ThermalPolicy {
 
     auto i2c_write(uint8_t addr, uint8_t data) -> bool;
 
+    // The EEPROM shares the thermal bus with the thermistor ADC, so its
+    // transfers wait behind any thermistor reads
+
     template <ByteIterator Input>
     auto i2c_write(uint8_t addr, Input data, size_t length) -> bool {
-        return i2c_hardware_write_data(I2C_BUS_THERMAL, addr, &(*data), length);
+        return eeprom_transfer(i2c_bus::Type::WRITE, addr, &(*data), length);
     }
 
     template <ByteIterator Output>
     auto i2c_read(uint8_t addr, Output data, size_t length) -> bool {
-        return i2c_hardware_read_data(I2C_BUS_THERMAL, addr, &(*data), length);
+        return eeprom_transfer(i2c_bus::Type::READ, addr, &(*data), length);
     }
+
+  private:
+    auto eeprom_transfer(i2c_bus::Type type, uint8_t addr, uint8_t* data,
+                         size_t length) -> bool;
+
+    i2c_bus_hardware::BlockingTransfer _transfer{};
+    // Single-byte writes go through here, so the data outlives the call
+    uint8_t _byte = 0;
 };
 
 }  // namespace thermal_policy
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <cstdint>
 #include <optional>
 
+#include "firmware/i2c_bus_hardware.hpp"
 #include "ot_utils/freertos/freertos_synchronization.hpp"
 
 class ThermistorPolicy {
@@ -12,7 +14,10 @@ class ThermistorPolicy {
     explicit ThermistorPolicy()
         : _initialized(false),
           // NOLINTNEXTLINE(readability-redundant-member-init)
-          _mutex() {}
+          _mutex(),
+          // NOLINTNEXTLINE(readability-redundant-member-init)
+          _transfer(),
+          _buffer() {}
 
     [[nodiscard]] auto get_time_ms() const -> uint32_t;
     auto sleep_ms(uint32_t ms) -> void;
@@ -28,5 +33,10 @@ class ThermistorPolicy {
 
   private:
     std::atomic_bool _initialized;
+    // Guards the sequence of transfers and the conversion of one read,
+    // not the bus itself
     ot_utils::freertos_synchronization::FreeRTOSMutex _mutex;
+    i2c_bus_hardware::BlockingTransfer _transfer;
+    // Register data, which the bus moves with DMA
+    std::array<uint8_t, 2> _buffer;
 };
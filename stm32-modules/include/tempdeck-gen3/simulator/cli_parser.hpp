@@ -13,9 +13,11 @@ using RT = std::pair<std::shared_ptr<sim_driver::SimDriver>, bool>;
 
 /**
  * Parse the inputs and determine 1) what kind of input should be
- * used 2) whether the simulation should be realtime or accelerated
+ * used 2) whether the simulation should be realtime or accelerated.
+ * The speedup of the simulated clock is written to the last argument,
+ * and is sim_clock::SimClock::LOCKSTEP unless one was given.
  */
-RT get_sim_driver(int, char**);
+RT get_sim_driver(int, char**, double&);
 
 bool check_realtime_environment_variable();
 
@@ -0,0 +1,106 @@
+/**
+ * @file sim_thermal_model.hpp
+ * @brief A thermal model of the Tempdeck plate and heatsink for the
+ * simulator, driven by the peltier and fan power.
+ *
+ * @details The plate and the heatsink are each a single thermal mass. The
+ * peltier pumps heat between them in proportion to its power, in either
+ * direction, and its resistive losses warm both sides. Some heat also leaks
+ * back through the peltier from the hotter side. The plate loses a little
+ * heat to the air around it, and the heatsink loses heat to the air much
+ * faster when the fan is running.
+ *
+ * The thermal task sets the powers from its thread and the thermistor task
+ * steps the model and reads it from its own, so every access is locked.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+class SimThermalModel {
+  public:
+    using Celsius = double;
+
+    static constexpr Celsius AMBIENT_C = 23.0;
+    // Heat capacity of each side, in J/K
+    static constexpr double PLATE_CAPACITY = 150.0;
+    static constexpr double HEATSINK_CAPACITY = 400.0;
+    // Heat pumped by the peltier at full power, in W
+    static constexpr double PELTIER_PUMP_MAX_W = 40.0;
+    // Resistive losses in the peltier at full power, in W, split evenly
+    // between the two sides
+    static constexpr double PELTIER_LOSS_MAX_W = 30.0;
+    // Thermal conductances, in W/K
+    static constexpr double PELTIER_CONDUCTANCE = 0.3;
+    static constexpr double PLATE_TO_AIR_CONDUCTANCE = 0.2;
+    static constexpr double HEATSINK_TO_AIR_CONDUCTANCE = 0.5;
+    static constexpr double FAN_CONDUCTANCE_MAX = 4.0;
+    // Peltier current at full power, in mA
+    static constexpr double PELTIER_CURRENT_MAX_MA = 4000.0;
+    // The longest step taken at once, in seconds
+    static constexpr double MAX_STEP_S = 0.1;
+
+    /**
+     * @brief Set the peltier power, from -1 (full cooling) to 1 (full
+     * heating).
+     */
+    auto set_peltier_power(double power) -> void {
+        auto lock = std::lock_guard(_mutex);
+        _peltier = std::clamp(power, -1.0, 1.0);
+    }
+
+    /** Set the fan power, from 0 to 1.*/
+    auto set_fan_power(double power) -> void {
+        auto lock = std::lock_guard(_mutex);
+        _fan = std::clamp(power, 0.0, 1.0);
+    }
+
+    /** Advance the model by a length of time in seconds.*/
+    auto step(double seconds) -> void {
+        auto lock = std::lock_guard(_mutex);
+        while (seconds > 0.0) {
+            auto dt = std::min(seconds, MAX_STEP_S);
+            step_once(dt);
+            seconds -= dt;
+        }
+    }
+
+    [[nodiscard]] auto plate() const -> Celsius {
+        auto lock = std::lock_guard(_mutex);
+        return _plate;
+    }
+
+    [[nodiscard]] auto heatsink() const -> Celsius {
+        auto lock = std::lock_guard(_mutex);
+        return _heatsink;
+    }
+
+    /** The current through the peltier, in mA.*/
+    [[nodiscard]] auto peltier_current_ma() const -> double {
+        auto lock = std::lock_guard(_mutex);
+        return std::abs(_peltier) * PELTIER_CURRENT_MAX_MA;
+    }
+
+  private:
+    auto step_once(double dt) -> void {
+        auto pumped = _peltier * PELTIER_PUMP_MAX_W;
+        auto loss = _peltier * _peltier * PELTIER_LOSS_MAX_W / 2.0;
+        auto leak = (_heatsink - _plate) * PELTIER_CONDUCTANCE;
+        auto plate_to_air = (_plate - AMBIENT_C) * PLATE_TO_AIR_CONDUCTANCE;
+        auto heatsink_to_air =
+            (_heatsink - AMBIENT_C) *
+            (HEATSINK_TO_AIR_CONDUCTANCE + _fan * FAN_CONDUCTANCE_MAX);
+
+        _plate += (pumped + loss + leak - plate_to_air) / PLATE_CAPACITY * dt;
+        _heatsink += (-pumped + loss - leak - heatsink_to_air) /
+                     HEATSINK_CAPACITY * dt;
+    }
+
+    mutable std::mutex _mutex{};
+    double _peltier = 0.0;
+    double _fan = 0.0;
+    Celsius _plate = AMBIENT_C;
+    Celsius _heatsink = AMBIENT_C;
+};
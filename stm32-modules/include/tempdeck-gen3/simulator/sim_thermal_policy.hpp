@@ -2,19 +2,29 @@
 
 #include <cmath>
 #include <cstdint>
+#include <memory>
 
+#include "simulator/sim_thermal_model.hpp"
 #include "test/test_m24128_policy.hpp"
 
 struct SimThermalPolicy : public m24128_test_policy::TestM24128Policy {
+    explicit SimThermalPolicy(std::shared_ptr<SimThermalModel> model)
+        : _model(std::move(model)) {}
+
     auto enable_peltier() -> void { _enabled = true; }
 
-    auto disable_peltier() -> void { _enabled = false; }
+    auto disable_peltier() -> void {
+        _enabled = false;
+        _power = 0.0F;
+        _model->set_peltier_power(_power);
+    }
 
     auto set_peltier_heat_power(double power) -> bool {
         if (!_enabled) {
             return false;
         }
         _power = std::min(1.0, std::abs(power));
+        _model->set_peltier_power(_power);
         return true;
     }
 
@@ -23,11 +33,13 @@ struct SimThermalPolicy : public m24128_test_policy::TestM24128Policy {
             return false;
         }
         _power = -std::min(1.0, std::abs(power));
+        _model->set_peltier_power(_power);
         return true;
     }
 
     auto set_fan_power(double power) -> bool {
         _fan = std::clamp(power, double(0.0), double(1.0));
+        _model->set_fan_power(_fan);
         return true;
     }
 
@@ -38,6 +50,7 @@ struct SimThermalPolicy : public m24128_test_policy::TestM24128Policy {
     }
 
   private:
+    std::shared_ptr<SimThermalModel> _model;
     bool _enabled = false;
     double _power = 0.0F;  // Positive for heat, negative for cool
     double _fan = 0.0F;
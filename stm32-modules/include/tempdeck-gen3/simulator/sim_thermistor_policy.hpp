@@ -1,24 +1,44 @@
 #pragma once
 
 #include <atomic>
-#include <chrono>
+#include <memory>
 #include <thread>
 
+#include "simulator/sim_clock.hpp"
+#include "simulator/sim_thermal_model.hpp"
+#include "simulator/simulator_queue.hpp"
+#include "tempdeck-gen3/thermal_task.hpp"
 #include "test/test_ads1115_policy.hpp"
+#include "thermistor_lookups.hpp"
 
 struct SimThermistorPolicy {
-    explicit SimThermistorPolicy(bool realtime = false)
-        : _realtime(realtime), _written() {}
-
-    [[nodiscard]] auto get_time_ms() const -> uint32_t { return _time_ms; }
-    auto sleep_ms(uint32_t time_ms) {
-        if (_realtime) {
-            using namespace std::chrono_literals;
-            auto time = 1ms * time_ms;
-            std::this_thread::sleep_for(time);
-        }
-        _time_ms += time_ms;
+    using ThermalTask = thermal_task::ThermalTask<SimulatorMessageQueue>;
+
+    // Registers of the ADS1115
+    static constexpr uint8_t CONVERSION_REGISTER = 0x00;
+    static constexpr uint8_t CONFIG_REGISTER = 0x01;
+    // The input multiplexer field of the config register. Single-ended
+    // reads of pins 0-3 are mux settings 4-7.
+    static constexpr uint16_t CONFIG_MUX_SHIFT = 12;
+    static constexpr uint16_t CONFIG_MUX_MASK = 0x7;
+    static constexpr uint16_t CONFIG_MUX_FIRST_PIN = 4;
+    // Pins of the thermistors, as read by the thermistor task
+    static constexpr uint16_t PLATE_1_PIN = 0;
+    static constexpr uint16_t PLATE_2_PIN = 1;
+    static constexpr uint16_t HEATSINK_PIN = 2;
+
+    SimThermistorPolicy(std::shared_ptr<SimThermalModel> model,
+                        std::shared_ptr<sim_clock::SimClock> clock)
+        : _model(std::move(model)),
+          _clock(std::move(clock)),
+          _written(),
+          _converter(ThermalTask::THERMISTOR_CIRCUIT_BIAS_RESISTANCE_KOHM,
+                     ThermalTask::ADC_BIT_MAX, false) {}
+
+    [[nodiscard]] auto get_time_ms() const -> uint32_t {
+        return static_cast<uint32_t>(_clock->now_ms());
     }
+    auto sleep_ms(uint32_t time_ms) -> void { _clock->sleep_ms(time_ms); }
 
     auto ads1115_mark_initialized() -> void { _initialized = true; }
 
@@ -53,6 +73,10 @@ struct SimThermistorPolicy {
 
     auto ads1115_i2c_read_16(uint8_t reg) -> std::optional<uint16_t> {
         using Ret = std::optional<uint16_t>;
+        if (reg == CONVERSION_REGISTER &&
+            _written.find(CONFIG_REGISTER) != _written.end()) {
+            return Ret(conversion(_written.at(CONFIG_REGISTER)));
+        }
         if (_written.find(reg) != _written.end()) {
             return Ret(_written.at(reg));
         }
@@ -60,17 +84,34 @@ struct SimThermistorPolicy {
     }
 
     auto get_imeas_adc_reading() -> uint32_t {
-        // TODO - add simulator current feedback
-        return 0;
+        using thermal_task::PeltierReadback;
+        return PeltierReadback::milliamps_to_adc(_model->peltier_current_ma());
     }
 
-    uint32_t _time_ms = 0;
-
   private:
-    bool _realtime;
+    // The result of a read of the pin selected in the config register
+    [[nodiscard]] auto conversion(uint16_t config) const -> uint16_t {
+        auto mux = (config >> CONFIG_MUX_SHIFT) & CONFIG_MUX_MASK;
+        if (mux < CONFIG_MUX_FIRST_PIN) {
+            return 0;
+        }
+        switch (mux - CONFIG_MUX_FIRST_PIN) {
+            case PLATE_1_PIN:
+            case PLATE_2_PIN:
+                return _converter.backconvert(_model->plate());
+            case HEATSINK_PIN:
+                return _converter.backconvert(_model->heatsink());
+            default:
+                return 0;
+        }
+    }
+
+    std::shared_ptr<SimThermalModel> _model;
+    std::shared_ptr<sim_clock::SimClock> _clock;
     std::atomic_bool _initialized = false;
     std::atomic_bool _locked = false;
     std::atomic_bool _read_armed = false;
     // Written registers - addr : value
     std::map<uint8_t, uint16_t> _written;
+    thermistor_conversion::Conversion<lookups::KS103J2G> _converter;
 };
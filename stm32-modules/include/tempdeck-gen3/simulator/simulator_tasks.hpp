@@ -6,9 +6,9 @@
 #pragma once
 
 #include <memory>
-#include <thread>
 
 #include "simulator/sim_driver.hpp"
+#include "simulator/sim_worker_pool.hpp"
 #include "simulator/simulator_queue.hpp"
 #include "tempdeck-gen3/tasks.hpp"
 
@@ -16,27 +16,15 @@ namespace tasks {
 
 using SimTasks = Tasks<SimulatorMessageQueue>;
 
-auto run_comms_task(std::stop_token st,
-                    std::shared_ptr<SimTasks::HostCommsQueue> queue_ptr,
-                    std::shared_ptr<SimTasks::QueueAggregator> aggregator,
-                    std::shared_ptr<sim_driver::SimDriver> driver) -> void;
-
-auto run_system_task(std::stop_token st,
-                     std::shared_ptr<SimTasks::SystemQueue> queue_ptr,
-                     std::shared_ptr<SimTasks::QueueAggregator> aggregator)
-    -> void;
-
-auto run_ui_task(std::stop_token st,
-                 std::shared_ptr<SimTasks::UIQueue> queue_ptr,
-                 std::shared_ptr<SimTasks::QueueAggregator> aggregator) -> void;
-
-auto run_thermal_task(std::stop_token st,
-                      std::shared_ptr<SimTasks::ThermalQueue> queue_ptr,
-                      std::shared_ptr<SimTasks::QueueAggregator> aggregator)
-    -> void;
-
-auto run_thermistor_task(std::stop_token st,
-                         std::shared_ptr<SimTasks::QueueAggregator> aggregator)
-    -> void;
+/**
+ * @brief Add a Tempdeck's tasks to a worker pool, which may be shared with
+ * other modules. The thermistors are read once per read period of the
+ * pool's clock.
+ * @return The aggregator of the new Tempdeck, for passing it input from the
+ * driver
+ */
+auto add_to_pool(sim_worker_pool::WorkerPool& pool,
+                 std::shared_ptr<sim_driver::SimDriver> driver)
+    -> std::shared_ptr<SimTasks::QueueAggregator>;
 
 };  // namespace tasks
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "core/gcode_parser.hpp"
+#include "core/task_stats_gcode.hpp"
 #include "core/utility.hpp"
 #include "systemwide.h"
 
@@ -271,9 +272,11 @@ struct GetThermalPowerDebug {
 
 /**
  * @brief SetTemperature is a command to set a temperature target for the
- * peltiers. There is one parameter, the target temp.
+ * peltiers. The parameters are the target temp and an optional ramp rate
+ * in ºC/s. Without a ramp rate (or with R0), the setpoint jumps straight
+ * to the target.
  *
- * M104 S[temp]\n
+ * M104 S[temp] R[rate]\n
  *
  */
 struct SetTemperature {
@@ -287,21 +290,34 @@ struct SetTemperature {
         bool present = false;
         float value = 0.0F;
     };
+    struct RampRateArg {
+        static constexpr auto prefix = std::array{'R'};
+        static constexpr bool required = false;
+        bool present = false;
+        float value = 0.0F;
+    };
 
     double target;
+    double ramp_rate = 0.0F;
 
     template <typename InputIt, typename Limit>
     requires std::forward_iterator<InputIt> &&
         std::sized_sentinel_for<Limit, InputIt>
     static auto parse(const InputIt& input, Limit limit)
         -> std::pair<ParseResult, InputIt> {
-        auto res =
-            gcode::SingleParser<TargetArg>::parse_gcode(input, limit, prefix);
+        auto res = gcode::SingleParser<TargetArg, RampRateArg>::parse_gcode(
+            input, limit, prefix);
         if (!res.first.has_value()) {
             return std::make_pair(ParseResult(), input);
         }
         auto arguments = res.first.value();
         auto ret = SetTemperature{.target = std::get<0>(arguments).value};
+        if (std::get<1>(arguments).present) {
+            if (std::get<1>(arguments).value < 0.0F) {
+                return std::make_pair(ParseResult(), input);
+            }
+            ret.ramp_rate = std::get<1>(arguments).value;
+        }
         return std::make_pair(ret, res.second);
     }
 
@@ -36,7 +36,8 @@ class HostCommsTask {
         gcode::GetTemperatureDebug, gcode::SetTemperature, gcode::DeactivateAll,
         gcode::SetPeltierDebug, gcode::SetFanManual, gcode::SetFanAutomatic,
         gcode::SetPIDConstants, gcode::SetOffsetConstants,
-        gcode::GetOffsetConstants, gcode::GetThermalPowerDebug>;
+        gcode::GetOffsetConstants, gcode::GetThermalPowerDebug,
+        gcode::GetTaskStatsDebug>;
     using AckOnlyCache =
         // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
         AckCache<10, gcode::EnterBootloader, gcode::SetSerialNumber,
@@ -472,8 +473,8 @@ class HostCommsTask {
                 false, errors::write_into(tx_into, tx_limit,
                                           errors::ErrorCode::GCODE_CACHE_FULL));
         }
-        auto message =
-            messages::SetTemperatureMessage{.id = id, .target = gcode.target};
+        auto message = messages::SetTemperatureMessage{
+            .id = id, .target = gcode.target, .ramp_rate = gcode.ramp_rate};
         if (!task_registry->send(message, TICKS_TO_WAIT_ON_SEND)) {
             auto wrote_to = errors::write_into(
                 tx_into, tx_limit, errors::ErrorCode::INTERNAL_QUEUE_FULL);
@@ -638,6 +639,24 @@ class HostCommsTask {
         return std::make_pair(true, tx_into);
     }
 
+    template <typename InputIt, typename InputLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputLimit, InputIt>
+    auto visit_gcode(const gcode::GetTaskStatsDebug& gcode, InputIt tx_into,
+                     InputLimit tx_limit) -> std::pair<bool, InputIt> {
+        // Queue statistics are kept atomically by each queue, so they can
+        // be read directly without messaging the other tasks.
+        using Addresses = tasks::Tasks<QueueImpl>;
+        std::array<const char*, Aggregator::TaskCount> names{};
+        names.at(Addresses::HostAddress) = "Comms";
+        names.at(Addresses::SystemAddress) = "System";
+        names.at(Addresses::UIAddress) = "UI";
+        names.at(Addresses::ThermalAddress) = "Thermal";
+        auto wrote_to = gcode.write_response_into(
+            tx_into, tx_limit, names, task_registry->get_all_stats());
+        return std::make_pair(true, wrote_to);
+    }
+
     // Our error handler just writes an error and bails
     template <typename InputIt, typename InputLimit>
     requires std::forward_iterator<InputIt> &&
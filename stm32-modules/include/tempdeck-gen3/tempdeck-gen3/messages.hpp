@@ -136,8 +136,10 @@ struct SetFanAutomaticMessage {
 };
 
 struct SetTemperatureMessage {
-    uint32_t id;
-    double target;
+    uint32_t id = 0;
+    double target = 0.0F;
+    // Rate to ramp the setpoint at in ºC/s, or 0 to jump to the target
+    double ramp_rate = 0.0F;
 };
 
 struct SetPIDConstantsMessage {
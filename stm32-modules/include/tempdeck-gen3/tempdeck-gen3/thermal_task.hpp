@@ -2,6 +2,7 @@
 
 #include <optional>
 
+#include "core/ramped_setpoint.hpp"
 #include "core/thermistor_conversion.hpp"
 #include "hal/message_queue.hpp"
 #include "ot_utils/core/pid.hpp"
@@ -189,6 +190,10 @@ class ThermalTask {
 
     [[nodiscard]] auto get_pid() const -> ot_utils::pid::PID { return _pid; }
 
+    [[nodiscard]] auto get_ramp() const -> ramped_setpoint::RampedSetpoint {
+        return _ramp;
+    }
+
   private:
     template <ThermalPolicy Policy>
     auto visit_message(const std::monostate& message, Policy& policy) -> void {
@@ -293,6 +298,8 @@ class ThermalTask {
                 -PELTIER_WINDUP_LIMIT);
         }
         _pid.reset();
+        _ramp.start(_plate_avg.value_or(message.target), message.target,
+                    message.ramp_rate);
 
         auto response =
             messages::AcknowledgePrevious{.responding_to_id = message.id};
@@ -462,8 +469,8 @@ class ThermalTask {
                 _peltier.target_set = false;
                 policy.disable_peltier();
             } else {
-                auto power = _pid.compute(_peltier.target - _plate_avg.value(),
-                                          sampletime);
+                auto power =
+                    _ramp.compute(_pid, _plate_avg.value(), sampletime);
                 _peltier.power = std::clamp(power, -1.0, 1.0);
                 policy.enable_peltier();
                 bool ret = false;
@@ -545,6 +552,7 @@ class ThermalTask {
     Fan _fan;
     Peltier _peltier;
     ot_utils::pid::PID _pid;
+    ramped_setpoint::RampedSetpoint _ramp{};
     eeprom::Eeprom<EEPROM_ADDRESS> _eeprom;
     eeprom::OffsetConstants _offset_constants;
 };
@@ -28,12 +28,17 @@ typedef void (*motor_step_callback_t)(void);
 // Void return and no parameters
 typedef void (*motor_error_callback_t)(MotorError_t);
 
+// Returns the speed of the next step in RPM, or 0 to keep the current speed
+typedef float (*motor_rate_callback_t)(void);
+
 // This structure is used to define callbacks out of motor interrupts
 typedef struct {
     motor_step_callback_t lid_stepper_complete;
     motor_step_callback_t seal_stepper_tick;
     motor_error_callback_t seal_stepper_error;
     motor_step_callback_t seal_stepper_limit_switch;
+    // Optional. Called before every lid step to get the step's speed.
+    motor_rate_callback_t lid_stepper_rate;
 } motor_hardware_callbacks;
 
 // ----------------------------------------------------------------------------
@@ -81,6 +86,14 @@ bool motor_hardware_lid_stepper_check_fault(void);
  */
 bool motor_hardware_lid_stepper_reset(void);
 
+/**
+ * @brief Set the speed of lid stepper movements. This is the speed of any
+ * step that the rate callback doesn't set a speed for.
+ *
+ * @param rpm The speed in RPM
+ * @return True if the speed was set, false if the lid is moving or the
+ * speed is out of range
+ */
 bool motor_hardware_lid_stepper_set_rpm(double rpm);
 
 /**
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <cstdint>
+#include <span>
 
+#include "core/delegate.hpp"
 #include "firmware/motor_hardware.h"
 #include "thermocycler-gen2/errors.hpp"
+#include "thermocycler-gen2/motor_utils.hpp"
 #include "thermocycler-gen2/tmc2130.hpp"
 
 /**
@@ -20,8 +23,16 @@
  *
  */
 class MotorPolicy {
-    std::function<void()> _seal_callback;
+  public:
+    using Callback = delegate::Delegate<void(MotorPolicy&)>;
+
+  private:
+    Callback _seal_callback;
     bool _shared_seal_switch_lines;
+    // Profile for the next lid movement that isn't an overdrive
+    motor_util::LidProfile _next_lid_profile{};
+    // Profile of the lid movement in progress, read from the lid interrupt
+    motor_util::LidProfile _lid_profile{};
 
   public:
     using RxTxReturn = std::optional<tmc2130::MessageT>;
@@ -57,6 +68,19 @@ class MotorPolicy {
      * @param overdrive True to ignore the endstop switches for this movement
      */
     auto lid_stepper_start(int32_t steps, bool overdrive) -> void;
+    /**
+     * @brief Set the velocity profile of the next lid stepper movement
+     * that isn't an overdrive. Other movements run at the set RPM.
+     */
+    auto lid_stepper_set_profile(const motor_util::LidProfile& profile)
+        -> void;
+    /**
+     * @brief Get the speed of the next lid step. Called from the lid
+     * stepper interrupt.
+     *
+     * @return The speed in RPM, or 0 to keep the set RPM
+     */
+    auto lid_stepper_next_rpm() -> float { return _lid_profile.next_rpm(); }
     /**
      * @brief Stop any movement on the lid stepper.
      *
@@ -110,7 +134,7 @@ class MotorPolicy {
      * @param callback Function to call on every tick
      * @return True if seal stepper could be started, false otherwise
      */
-    auto seal_stepper_start(std::function<void()> callback) -> bool;
+    auto seal_stepper_start(Callback callback) -> bool;
     /**
      * @brief Stop any active seal stepper movement
      */
@@ -124,6 +148,16 @@ class MotorPolicy {
      * transmission failed
      */
     auto tmc2130_transmit_receive(tmc2130::MessageT& data) -> RxTxReturn;
+    /**
+     * @brief Send and receive several messages over SPI to tmc2130 in one
+     * chained transfer
+     *
+     * @param batch Messages to send to the TMC2130, each of which is
+     * replaced with the data received for it
+     * @return True on success, false if transmission failed
+     */
+    auto tmc2130_transmit_receive_batch(std::span<tmc2130::MessageT> batch)
+        -> bool;
     /**
      * @brief Set the enable pin for the TMC2130 to enabled or not
      *
@@ -190,5 +224,5 @@ class MotorPolicy {
      * @brief Call the seal callback function
      *
      */
-    auto seal_tick() -> void { _seal_callback(); }
+    auto seal_tick() -> void { _seal_callback(*this); }
 };
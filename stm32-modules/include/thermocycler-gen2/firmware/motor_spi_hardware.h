@@ -25,6 +25,22 @@ void motor_spi_initialize(void);
  */
 bool motor_spi_sendreceive(uint8_t *in, uint8_t *out, size_t len);
 
+/**
+ * @brief Sends & receives several messages back to back over the SPI bus.
+ * The chip select is raised for the driver's minimum CSN high time between
+ * messages from the transfer complete interrupt, so the calling task only
+ * blocks once for the whole batch.
+ *
+ * @param[in] in The messages to write. Must contain \c count messages of
+ * \c len bytes each.
+ * @param[out] out Returns the \c count messages read from the TMC2130
+ * @param[in] count The number of messages
+ * @param[in] len The length of each message
+ * @return True on success, false on any error to write/read
+ */
+bool motor_spi_sendreceive_batch(uint8_t *in, uint8_t *out, size_t count,
+                                 size_t len);
+
 /** @brief This function handles SPI2 global interrupt. */
 void SPI2_IRQHandler(void);
 
@@ -1,6 +1,7 @@
 #include <memory>
 #include <string>
 
+#include "simulator/periodic_data_thread.hpp"
 #include "simulator/sim_driver.hpp"
 
 namespace cli_parser {
@@ -13,9 +14,13 @@ using RT = std::pair<std::shared_ptr<sim_driver::SimDriver>, bool>;
 
 /**
  * Parse the inputs and determine 1) what kind of input should be
- * used 2) whether the simulation should be realtime or accelerated
+ * used 2) whether the simulation should be realtime or accelerated.
+ * The settings for the simulated sample are written to the third argument,
+ * and the speedup of the simulated clock to the last one. The speedup is
+ * sim_clock::SimClock::LOCKSTEP unless one was given.
  */
-RT get_sim_driver(int, char**);
+RT get_sim_driver(int, char**, periodic_data_thread::SampleOptions&,
+                  double&);
 
 bool check_realtime_environment_variable();
 
@@ -1,8 +1,8 @@
 #pragma once
 #include <memory>
-#include <thread>
 
 #include "simulator/periodic_data_thread.hpp"
+#include "simulator/sim_worker_pool.hpp"
 #include "simulator/simulator_queue.hpp"
 #include "thermocycler-gen2/lid_heater_task.hpp"
 #include "thermocycler-gen2/tasks.hpp"
@@ -11,6 +11,7 @@ namespace lid_heater_thread {
 using SimLidHeaterTask = lid_heater_task::LidHeaterTask<SimulatorMessageQueue>;
 struct TaskControlBlock;
 auto build(
+    sim_worker_pool::WorkerPool& pool,
     std::shared_ptr<periodic_data_thread::PeriodicDataThread> periodic_data)
-    -> tasks::Task<std::unique_ptr<std::jthread>, SimLidHeaterTask>;
+    -> tasks::Task<std::shared_ptr<TaskControlBlock>, SimLidHeaterTask>;
 };  // namespace lid_heater_thread
@@ -1,7 +1,7 @@
 #pragma once
 #include <memory>
-#include <thread>
 
+#include "simulator/sim_worker_pool.hpp"
 #include "simulator/simulator_queue.hpp"
 #include "thermocycler-gen2/motor_task.hpp"
 #include "thermocycler-gen2/tasks.hpp"
@@ -9,5 +9,6 @@
 namespace motor_thread {
 using SimMotorTask = motor_task::MotorTask<SimulatorMessageQueue>;
 struct TaskControlBlock;
-auto build() -> tasks::Task<std::unique_ptr<std::jthread>, SimMotorTask>;
+auto build(sim_worker_pool::WorkerPool& pool)
+    -> tasks::Task<std::shared_ptr<TaskControlBlock>, SimMotorTask>;
 };  // namespace motor_thread
@@ -1,15 +1,18 @@
 /**
  * @file periodic_data_thread.hpp
  * @brief Interface for the Periodic Data task, which generates any periodic
- * simulated message data for the Thermocycler simulator.
+ * simulated message data for the Thermocycler simulator. It runs as a
+ * periodic job of the simulator's worker pool.
  */
 #pragma once
 
-#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
-#include <thread>
 #include <variant>
 
+#include "simulator/sim_thermal_model.hpp"
+#include "simulator/sim_worker_pool.hpp"
 #include "simulator/simulator_queue.hpp"
 #include "thermocycler-gen2/tasks.hpp"
 
@@ -28,14 +31,36 @@ struct PeltierPower {
 
 struct StartMotorMovement {};
 
-using PeriodicDataMessage = std::variant<std::monostate, HeatPadPower,
-                                         PeltierPower, StartMotorMovement>;
+// The plate task's estimate of the sample temperature
+struct SampleEstimate {
+    Temperature temperature;
+};
+
+using PeriodicDataMessage =
+    std::variant<std::monostate, HeatPadPower, PeltierPower,
+                 StartMotorMovement, SampleEstimate>;
 
 using PeriodicDataQueue = SimulatorMessageQueue<PeriodicDataMessage>;
 
+// Settings for the simulated sample in the plate wells
+struct SampleOptions {
+    // Volume of the simulated sample, in microliters
+    double volume_ul = 25.0F;
+    // Periodically log the simulated sample next to the plate task's
+    // estimate of it
+    bool log = false;
+};
+
 class PeriodicDataThread {
   public:
-    PeriodicDataThread(bool realtime = true);
+    /**
+     * Simulated time step. The plate and lid tasks pick their own sampling
+     * periods, so this must evenly divide all of the periods they may
+     * choose.
+     */
+    static constexpr uint32_t TICK_PERIOD_MS = 10;
+
+    explicit PeriodicDataThread(SampleOptions sample = {});
 
     // Send a message to this PeriodicDataThread
     auto send_message(PeriodicDataMessage msg) -> bool;
@@ -44,13 +69,9 @@ class PeriodicDataThread {
     auto provide_tasks(tasks::Tasks<SimulatorMessageQueue>* other_tasks)
         -> void;
 
-    // Should be initiated in its own jthread
-    auto run(std::stop_token& st) -> void;
-
-    // Thread safe method to signal that lid thread processed data
-    auto signal_lid_thread_ready() -> void;
-    // Thread safe method to signal that lid thread processed data
-    auto signal_plate_thread_ready() -> void;
+    // Run once per tick period: take in any new control values, and send
+    // the lid and plate tasks new temperatures when their periods are up
+    auto tick(uint32_t now_ms) -> void;
 
   private:
     // The further from room temperature an element is, the stronger
@@ -63,27 +84,33 @@ class PeriodicDataThread {
                             std::chrono::milliseconds delta) -> double;
     auto update_heat_pad() -> bool;
     auto update_peltiers() -> bool;
+    // Move the simulated sample towards the plate temperature
+    auto update_sample(Temperature plate_temp, std::chrono::milliseconds delta)
+        -> void;
+    // Log the simulated sample, if enabled and it is time to
+    auto log_sample(Temperature plate_temp) -> void;
     auto run_motor() -> void;
 
     Power _heat_pad_power;
     PeltierPower _peltiers_power;
     Temperature _lid_temp, _left_temp, _center_temp, _right_temp;
+    sim_thermal_model::Sample _sample;
+    Temperature _sample_estimate;
+    SampleOptions _sample_options;
+    uint32_t _tick_sample_log;  // Last time the sample was logged
     uint32_t _tick_peltiers;  // Last time a peltier message was sent
     uint32_t _tick_heater;    // Last time a heater message was sent
     uint32_t _current_tick;
     PeriodicDataQueue _queue;
     tasks::Tasks<SimulatorMessageQueue>* _task_registry;
-    bool _realtime;
-    // This really wants to be an std::latch, but that isn't available
-    // in gcc10. Bummer :(
-    std::atomic_bool _init_latch;
-    // If one of these flags is set, wait until the respective thread signals
-    // that it read the temperature update
-    std::atomic_bool _waiting_for_lid_thread{false};
-    std::atomic_bool _waiting_for_plate_thread{false};
 };
 
-auto build(bool realtime) -> std::pair<std::unique_ptr<std::jthread>,
-                                       std::shared_ptr<PeriodicDataThread>>;
+/**
+ * Add the periodic data job to a worker pool. In lockstep, the pool only
+ * moves on to the next tick once the lid and plate tasks have handled the
+ * temperatures of this one.
+ */
+auto build(sim_worker_pool::WorkerPool& pool, SampleOptions sample = {})
+    -> std::shared_ptr<PeriodicDataThread>;
 
 };  // namespace periodic_data_thread
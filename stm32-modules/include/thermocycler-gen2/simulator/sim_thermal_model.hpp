@@ -0,0 +1,131 @@
+/**
+ * @file sim_thermal_model.hpp
+ * @brief The thermal model the simulator uses for the lid heater and the
+ * plate peltiers.
+ *
+ * @details Each thermal element heats in proportion to its power and is
+ * drawn back to room temperature in proportion to its distance from it.
+ * The model is kept free of the simulator threads so that host tests can
+ * drive the control code against the same plant as the simulator.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+#include "thermocycler-gen2/plate_model.hpp"
+
+namespace sim_thermal_model {
+
+/** Default starting temperature for all thermistors.*/
+static constexpr const double AMBIENT_TEMPERATURE = 23.0F;
+/** Gain term for peltier outputs, from experimental data.*/
+static constexpr const double PELTIER_GAIN = 3.2F;
+/** Gain term for lid heater output, from experimental data.*/
+static constexpr const double HEAT_PAD_GAIN = 0.72;
+/**
+ * Gain term for bringing temperature back down to ambient. Scaled against
+ * the difference between a temperature and its ambient condition. The
+ * constant is derived from rough modeling against the lid heater cooling
+ * from 100ºC to ambient temperature.
+ */
+static constexpr const double AMBIENT_TEMPERATURE_GAIN = 0.0015;
+
+/**
+ * @brief Get the temperature change from driving an element.
+ * @param gain The gain term of the element
+ * @param power The power of the element, from -1 to 1
+ * @param seconds The time since the last update
+ */
+[[nodiscard]] constexpr auto gain_effect(double gain, double power,
+                                         double seconds) -> double {
+    return seconds * gain * power;
+}
+
+/**
+ * @brief Get the temperature change from the draw back to room
+ * temperature, which is stronger the further an element is from it.
+ * @param temp The temperature of the element
+ * @param seconds The time since the last update
+ */
+[[nodiscard]] constexpr auto ambient_effect(double temp, double seconds)
+    -> double {
+    return (AMBIENT_TEMPERATURE - temp) * AMBIENT_TEMPERATURE_GAIN * seconds;
+}
+
+/**
+ * @brief Advance the temperature of a plate peltier.
+ * @param temp The temperature of the peltier
+ * @param power The power of the peltier, from -1 to 1
+ * @param seconds The time since the last update
+ * @return The new temperature
+ */
+[[nodiscard]] constexpr auto step_peltier(double temp, double power,
+                                          double seconds) -> double {
+    return temp + gain_effect(PELTIER_GAIN, power, seconds) +
+           ambient_effect(temp, seconds);
+}
+
+/**
+ * The plate model that the simulated peltiers follow exactly. The
+ * simulator has no lag between the peltiers and the thermistors, so there
+ * is no dead time.
+ */
+static constexpr const plate_model::PlateModel PELTIER_MODEL{
+    .gain = PELTIER_GAIN / AMBIENT_TEMPERATURE_GAIN,
+    .time_constant = 1.0 / AMBIENT_TEMPERATURE_GAIN,
+    .dead_time = 0.0F};
+
+/*
+ * The simulated sample has its own physics, with constants that differ from
+ * the firmware's SampleEstimator. If the simulator used the estimator's own
+ * constants, the estimate would match it by construction and checking one
+ * against the other would prove nothing.
+ */
+
+/** Lag of the simulated well walls behind the plate, in seconds.*/
+static constexpr const double SAMPLE_WALL_TIME_CONSTANT = 2.0F;
+/** Lag of the simulated liquid behind the walls, in seconds per uL.*/
+static constexpr const double SAMPLE_TIME_CONSTANT_PER_UL = 0.12F;
+/**
+ * How strongly the heated lid pulls the simulated liquid towards its own
+ * temperature, relative to the wall. The liquid settles slightly above
+ * the plate when the lid is hotter than it.
+ */
+static constexpr const double SAMPLE_LID_COUPLING = 0.01F;
+
+/** The state of the simulated sample.*/
+struct Sample {
+    double wall;
+    double liquid;
+};
+
+/**
+ * @brief Advance the simulated sample. The walls follow the plate, and the
+ * liquid follows the walls and, weakly, the lid.
+ * @param sample The sample to update
+ * @param plate_temp The temperature of the plate
+ * @param lid_temp The temperature of the lid heater
+ * @param volume_ul The volume of the sample, in microliters
+ * @param seconds The time since the last update
+ * @return The new sample state
+ */
+[[nodiscard]] inline auto step_sample(Sample sample, double plate_temp,
+                                      double lid_temp, double volume_ul,
+                                      double seconds) -> Sample {
+    sample.wall += (plate_temp - sample.wall) *
+                   (1.0 - std::exp(-seconds / SAMPLE_WALL_TIME_CONSTANT));
+    auto liquid_time_constant =
+        SAMPLE_TIME_CONSTANT_PER_UL * std::max(volume_ul, 0.0);
+    auto surroundings = (sample.wall + (SAMPLE_LID_COUPLING * lid_temp)) /
+                        (1.0 + SAMPLE_LID_COUPLING);
+    if (liquid_time_constant > 0.0F) {
+        sample.liquid += (surroundings - sample.liquid) *
+                         (1.0 - std::exp(-seconds / liquid_time_constant));
+    } else {
+        sample.liquid = sample.wall;
+    }
+    return sample;
+}
+
+}  // namespace sim_thermal_model
@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <map>
+#include <span>
 
 #include "core/bit_utils.hpp"
 #include "thermocycler-gen2/tmc2130.hpp"
@@ -76,6 +77,18 @@ class SimTMC2130Policy {
         return RT(ret);
     }
 
+    auto tmc2130_transmit_receive_batch(std::span<tmc2130::MessageT> batch)
+        -> bool {
+        for (auto& message : batch) {
+            auto ret = tmc2130_transmit_receive(message);
+            if (!ret.has_value()) {
+                return false;
+            }
+            message = ret.value();
+        }
+        return true;
+    }
+
     auto tmc2130_set_enable(bool enable) -> bool {
         _enable = enable;
         return true;
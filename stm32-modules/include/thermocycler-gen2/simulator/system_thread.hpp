@@ -1,7 +1,7 @@
 #pragma once
 #include <memory>
-#include <thread>
 
+#include "simulator/sim_worker_pool.hpp"
 #include "simulator/simulator_queue.hpp"
 #include "thermocycler-gen2/system_task.hpp"
 #include "thermocycler-gen2/tasks.hpp"
@@ -9,5 +9,6 @@
 namespace system_thread {
 using SimSystemTask = system_task::SystemTask<SimulatorMessageQueue>;
 struct TaskControlBlock;
-auto build() -> tasks::Task<std::unique_ptr<std::jthread>, SimSystemTask>;
+auto build(sim_worker_pool::WorkerPool& pool)
+    -> tasks::Task<std::shared_ptr<TaskControlBlock>, SimSystemTask>;
 };  // namespace system_thread
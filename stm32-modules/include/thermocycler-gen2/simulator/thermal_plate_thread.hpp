@@ -1,8 +1,8 @@
 #pragma once
 #include <memory>
-#include <thread>
 
 #include "simulator/periodic_data_thread.hpp"
+#include "simulator/sim_worker_pool.hpp"
 #include "simulator/simulator_queue.hpp"
 #include "thermocycler-gen2/tasks.hpp"
 #include "thermocycler-gen2/thermal_plate_task.hpp"
@@ -12,6 +12,7 @@ using SimThermalPlateTask =
     thermal_plate_task::ThermalPlateTask<SimulatorMessageQueue>;
 struct TaskControlBlock;
 auto build(
+    sim_worker_pool::WorkerPool& pool,
     std::shared_ptr<periodic_data_thread::PeriodicDataThread> periodic_data)
-    -> tasks::Task<std::unique_ptr<std::jthread>, SimThermalPlateTask>;
+    -> tasks::Task<std::shared_ptr<TaskControlBlock>, SimThermalPlateTask>;
 };  // namespace thermal_plate_thread
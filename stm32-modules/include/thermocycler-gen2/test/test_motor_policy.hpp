@@ -1,12 +1,12 @@
 #pragma once
 
-#include <functional>
-
+#include "core/delegate.hpp"
 #include "test/test_tmc2130_policy.hpp"
+#include "thermocycler-gen2/motor_utils.hpp"
 
 class TestMotorPolicy : public TestTMC2130Policy {
   public:
-    using Callback = std::function<void()>;
+    using Callback = delegate::Delegate<void(TestMotorPolicy&)>;
 
     TestMotorPolicy() : TestTMC2130Policy(), _callback() {}
 
@@ -24,6 +24,10 @@ class TestMotorPolicy : public TestTMC2130Policy {
         _actual_angle += steps;
         _lid_moving = false;
     }
+    auto lid_stepper_set_profile(const motor_util::LidProfile& profile)
+        -> void {
+        _lid_profile = profile;
+    }
     auto lid_stepper_stop() -> void { _lid_moving = false; }
 
     auto lid_stepper_check_fault() -> bool { return _lid_fault; }
@@ -86,7 +90,7 @@ class TestMotorPolicy : public TestTMC2130Policy {
 
     auto tick() -> void {
         if (_seal_moving) {
-            _callback();
+            _callback(*this);
         }
     }
     auto solenoid_engaged() -> bool { return _solenoid_engaged; }
@@ -118,6 +122,10 @@ class TestMotorPolicy : public TestTMC2130Policy {
 
     auto get_lid_rpm() -> double { return _lid_rpm; }
 
+    auto get_lid_profile() -> const motor_util::LidProfile& {
+        return _lid_profile;
+    }
+
     auto set_switch_lines_shared(bool shared) -> void {
         _shared_switch_lines = shared;
     }
@@ -138,6 +146,7 @@ class TestMotorPolicy : public TestTMC2130Policy {
     bool _extension_switch_armed = false;
     bool _retraction_switch_armed = false;
     double _lid_rpm = 0;
+    motor_util::LidProfile _lid_profile{};
     // Default to shared switch lines (pre-DVT)
     bool _shared_switch_lines = true;
     Callback _callback;
@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <map>
+#include <span>
 
 #include "core/bit_utils.hpp"
 #include "thermocycler-gen2/tmc2130.hpp"
@@ -74,9 +75,26 @@ class TestTMC2130Policy {
             _registers[addr] = 0x00;
         }
         _has_been_written = true;
+        ++_messages;
         return RT(ret);
     }
 
+    auto tmc2130_transmit_receive_batch(std::span<tmc2130::MessageT> batch)
+        -> bool {
+        ++_batches;
+        if (_fail_batches) {
+            return false;
+        }
+        for (auto& message : batch) {
+            auto ret = tmc2130_transmit_receive(message);
+            if (!ret.has_value()) {
+                return false;
+            }
+            message = ret.value();
+        }
+        return true;
+    }
+
     auto tmc2130_set_enable(bool enable) -> bool {
         _enable = enable;
         return true;
@@ -120,6 +138,10 @@ class TestTMC2130Policy {
     auto get_tmc2130_direction() -> bool { return _direction == 1; }
     auto get_tmc2130_enabled() -> bool { return _enable; }
     auto has_been_written() -> bool { return _has_been_written; }
+    // The number of messages sent, and the number of batches they were in
+    auto get_messages() -> size_t { return _messages; }
+    auto get_batches() -> size_t { return _batches; }
+    auto set_fail_batches(bool fail) -> void { _fail_batches = fail; }
 
   private:
     auto get_status() -> uint8_t { return 0x00; }
@@ -131,4 +153,7 @@ class TestTMC2130Policy {
     signed int _direction = 1;
     long _steps = 0;
     bool _has_been_written = false;
+    size_t _messages = 0;
+    size_t _batches = 0;
+    bool _fail_batches = false;
 };
@@ -1,15 +1,21 @@
 /**
  * @file eeprom.hpp
  * @brief Implements an EEPROm class that is specialized towards
- * holding the Thermal Offset Constants for the Thermocycler plate.
+ * holding the Thermal Offset Constants, the thermal model, the PID
+ * constants and the PID gain schedule for the Thermocycler plate.
  */
 
 #pragma once
 
+#include <array>
 #include <cstddef>
 #include <cstdint>
+#include <optional>
 
 #include "core/at24c0xc.hpp"
+#include "core/stall_calibration.hpp"
+#include "thermocycler-gen2/gain_schedule.hpp"
+#include "thermocycler-gen2/plate_model.hpp"
 
 namespace eeprom {
 
@@ -39,6 +45,13 @@ struct OffsetConstants {
     double br, cr;  // B and C for right
 };
 
+/**
+ * @brief PID constants for the peltiers, as found by autotuning.
+ */
+struct PIDConstants {
+    double kp, ki, kd;
+};
+
 /**
  * @brief Encapsulates interactions with the EEPROM on the Thermocycler
  * mainboard. Allows reading and writing the thermal offset constants.
@@ -91,38 +104,42 @@ class Eeprom {
     auto write_offset_constants(OffsetConstants constants, Policy& policy)
         -> bool {
         // Write the constants
-        auto ret = _eeprom.template write_value(
+        auto ret = _eeprom.template stage_value(
             static_cast<uint8_t>(EEPROMPageMap::CONST_A), constants.a, policy);
         if (ret) {
-            ret = _eeprom.template write_value(
+            ret = _eeprom.template stage_value(
                 static_cast<uint8_t>(EEPROMPageMap::CONST_BL), constants.bl,
                 policy);
         }
         if (ret) {
-            ret = _eeprom.template write_value(
+            ret = _eeprom.template stage_value(
                 static_cast<uint8_t>(EEPROMPageMap::CONST_CL), constants.cl,
                 policy);
         }
         if (ret) {
-            ret = _eeprom.template write_value(
+            ret = _eeprom.template stage_value(
                 static_cast<uint8_t>(EEPROMPageMap::CONST_BC), constants.bc,
                 policy);
         }
         if (ret) {
-            ret = _eeprom.template write_value(
+            ret = _eeprom.template stage_value(
                 static_cast<uint8_t>(EEPROMPageMap::CONST_CC), constants.cc,
                 policy);
         }
         if (ret) {
-            ret = _eeprom.template write_value(
+            ret = _eeprom.template stage_value(
                 static_cast<uint8_t>(EEPROMPageMap::CONST_BR), constants.br,
                 policy);
         }
         if (ret) {
-            ret = _eeprom.template write_value(
+            ret = _eeprom.template stage_value(
                 static_cast<uint8_t>(EEPROMPageMap::CONST_CR), constants.cr,
                 policy);
         }
+        // Write the staged values in one batch, before the flag
+        if (ret) {
+            ret = _eeprom.flush(policy);
+        }
         if (ret) {
             // Flag that the constants are good
             ret = _eeprom.template write_value(
@@ -138,6 +155,297 @@ class Eeprom {
         return ret;
     }
 
+    /**
+     * @brief Get the plate model parameters from the EEPROM
+     *
+     * @tparam Policy for reading from EEPROM
+     * @param defaults PlateModel containing default values to return
+     *                 in the case that the EEPROM is not written.
+     * @param policy Instance of Policy
+     * @return PlateModel containing the model parameters, or the default
+     * values if the EEPROM doesn't have programmed values.
+     */
+    template <at24c0xc::AT24C0xC_Policy Policy>
+    [[nodiscard]] auto get_plate_model(const plate_model::PlateModel& defaults,
+                                       Policy& policy)
+        -> plate_model::PlateModel {
+        auto ret = defaults;
+        auto flag = _eeprom.template read_value<uint32_t>(
+            static_cast<uint8_t>(EEPROMPageMap::MODEL_FLAG), policy);
+        if (flag.has_value() &&
+            flag.value() == static_cast<uint32_t>(EEPROMFlag::MODEL_WRITTEN)) {
+            ret.gain = read_const(EEPROMPageMap::MODEL_GAIN, policy);
+            ret.time_constant =
+                read_const(EEPROMPageMap::MODEL_TIME_CONSTANT, policy);
+            ret.dead_time = read_const(EEPROMPageMap::MODEL_DEAD_TIME, policy);
+        }
+        return ret;
+    }
+
+    /**
+     * @brief Write new plate model parameters to the EEPROM
+     *
+     * @tparam Policy for writing to the EEPROM
+     * @param model PlateModel containing the parameters to be written
+     * @param policy Instance of Policy
+     * @return True if the parameters were written, false otherwise
+     */
+    template <at24c0xc::AT24C0xC_Policy Policy>
+    auto write_plate_model(const plate_model::PlateModel& model,
+                           Policy& policy) -> bool {
+        auto ret = _eeprom.template stage_value(
+            static_cast<uint8_t>(EEPROMPageMap::MODEL_GAIN), model.gain,
+            policy);
+        if (ret) {
+            ret = _eeprom.template stage_value(
+                static_cast<uint8_t>(EEPROMPageMap::MODEL_TIME_CONSTANT),
+                model.time_constant, policy);
+        }
+        if (ret) {
+            ret = _eeprom.template stage_value(
+                static_cast<uint8_t>(EEPROMPageMap::MODEL_DEAD_TIME),
+                model.dead_time, policy);
+        }
+        // Write the staged values before the flag
+        if (ret) {
+            ret = _eeprom.flush(policy);
+        }
+        if (ret) {
+            ret = _eeprom.template write_value(
+                static_cast<uint8_t>(EEPROMPageMap::MODEL_FLAG),
+                static_cast<uint32_t>(EEPROMFlag::MODEL_WRITTEN), policy);
+        }
+        if (!ret) {
+            static_cast<void>(_eeprom.template write_value(
+                static_cast<uint8_t>(EEPROMPageMap::MODEL_FLAG),
+                static_cast<uint32_t>(EEPROMFlag::INVALID), policy));
+        }
+        return ret;
+    }
+
+    /**
+     * @brief Get the peltier PID constants from the EEPROM
+     *
+     * @tparam Policy for reading from EEPROM
+     * @param defaults PIDConstants containing default values to return
+     *                 in the case that the EEPROM is not written.
+     * @param policy Instance of Policy
+     * @return PIDConstants containing the constants, or the default
+     * values if the EEPROM doesn't have programmed values.
+     */
+    template <at24c0xc::AT24C0xC_Policy Policy>
+    [[nodiscard]] auto get_pid_constants(const PIDConstants& defaults,
+                                         Policy& policy) -> PIDConstants {
+        auto ret = defaults;
+        auto flag = _eeprom.template read_value<uint32_t>(
+            static_cast<uint8_t>(EEPROMPageMap::PID_FLAG), policy);
+        if (flag.has_value() &&
+            flag.value() == static_cast<uint32_t>(EEPROMFlag::PID_WRITTEN)) {
+            ret.kp = read_const(EEPROMPageMap::PID_KP, policy);
+            ret.ki = read_const(EEPROMPageMap::PID_KI, policy);
+            ret.kd = read_const(EEPROMPageMap::PID_KD, policy);
+        }
+        return ret;
+    }
+
+    /**
+     * @brief Write new peltier PID constants to the EEPROM
+     *
+     * @tparam Policy for writing to the EEPROM
+     * @param constants PIDConstants containing the constants to be written
+     * @param policy Instance of Policy
+     * @return True if the constants were written, false otherwise
+     */
+    template <at24c0xc::AT24C0xC_Policy Policy>
+    auto write_pid_constants(const PIDConstants& constants, Policy& policy)
+        -> bool {
+        auto ret = _eeprom.template stage_value(
+            static_cast<uint8_t>(EEPROMPageMap::PID_KP), constants.kp, policy);
+        if (ret) {
+            ret = _eeprom.template stage_value(
+                static_cast<uint8_t>(EEPROMPageMap::PID_KI), constants.ki,
+                policy);
+        }
+        if (ret) {
+            ret = _eeprom.template stage_value(
+                static_cast<uint8_t>(EEPROMPageMap::PID_KD), constants.kd,
+                policy);
+        }
+        // Write the staged values before the flag
+        if (ret) {
+            ret = _eeprom.flush(policy);
+        }
+        if (ret) {
+            ret = _eeprom.template write_value(
+                static_cast<uint8_t>(EEPROMPageMap::PID_FLAG),
+                static_cast<uint32_t>(EEPROMFlag::PID_WRITTEN), policy);
+        }
+        if (!ret) {
+            static_cast<void>(_eeprom.template write_value(
+                static_cast<uint8_t>(EEPROMPageMap::PID_FLAG),
+                static_cast<uint32_t>(EEPROMFlag::INVALID), policy));
+        }
+        return ret;
+    }
+
+    /**
+     * @brief Get the peltier PID gain schedule from the EEPROM
+     *
+     * @tparam Policy for reading from EEPROM
+     * @param defaults GainSchedule to return in the case that the EEPROM
+     *                 doesn't have a schedule programmed.
+     * @param policy Instance of Policy
+     * @return GainSchedule containing the stored gains, or the default
+     * schedule if the EEPROM doesn't have programmed values.
+     */
+    template <at24c0xc::AT24C0xC_Policy Policy>
+    [[nodiscard]] auto get_gain_schedule(
+        const gain_schedule::GainSchedule& defaults, Policy& policy)
+        -> gain_schedule::GainSchedule {
+        auto flag = _eeprom.template read_value<uint32_t>(
+            static_cast<uint8_t>(EEPROMPageMap::SCHEDULE_FLAG), policy);
+        if (!flag.has_value() ||
+            flag.value() !=
+                static_cast<uint32_t>(EEPROMFlag::SCHEDULE_WRITTEN)) {
+            return defaults;
+        }
+        ScheduleValues values{};
+        for (size_t page = 0; page < SCHEDULE_PAGES; ++page) {
+            auto pair = _eeprom.template read_value<SchedulePage>(
+                static_cast<uint8_t>(
+                    static_cast<size_t>(EEPROMPageMap::SCHEDULE_START) + page),
+                policy);
+            if (!pair.has_value()) {
+                return defaults;
+            }
+            values.at(page * 2) = pair.value().at(0);
+            values.at((page * 2) + 1) = pair.value().at(1);
+        }
+        auto ret = gain_schedule::GainSchedule();
+        auto value = values.cbegin();
+        for (auto& gains : ret.table()) {
+            gains.kp = *value++;
+            gains.ki = *value++;
+            gains.kd = *value++;
+        }
+        return ret;
+    }
+
+    /**
+     * @brief Write a new peltier PID gain schedule to the EEPROM. The
+     * gains are stored with single precision to fit the whole table in
+     * the EEPROM.
+     *
+     * @tparam Policy for writing to the EEPROM
+     * @param schedule GainSchedule containing the gains to be written
+     * @param policy Instance of Policy
+     * @return True if the schedule was written, false otherwise
+     */
+    template <at24c0xc::AT24C0xC_Policy Policy>
+    auto write_gain_schedule(const gain_schedule::GainSchedule& schedule,
+                             Policy& policy) -> bool {
+        ScheduleValues values{};
+        auto value = values.begin();
+        for (const auto& gains : schedule.table()) {
+            *value++ = static_cast<float>(gains.kp);
+            *value++ = static_cast<float>(gains.ki);
+            *value++ = static_cast<float>(gains.kd);
+        }
+        bool ret = true;
+        for (size_t page = 0; ret && (page < SCHEDULE_PAGES); ++page) {
+            auto pair = SchedulePage{values.at(page * 2),
+                                     values.at((page * 2) + 1)};
+            ret = _eeprom.template stage_value(
+                static_cast<uint8_t>(
+                    static_cast<size_t>(EEPROMPageMap::SCHEDULE_START) + page),
+                pair, policy);
+        }
+        // Write the staged values before the flag
+        if (ret) {
+            ret = _eeprom.flush(policy);
+        }
+        if (ret) {
+            ret = _eeprom.template write_value(
+                static_cast<uint8_t>(EEPROMPageMap::SCHEDULE_FLAG),
+                static_cast<uint32_t>(EEPROMFlag::SCHEDULE_WRITTEN), policy);
+        }
+        if (!ret) {
+            static_cast<void>(_eeprom.template write_value(
+                static_cast<uint8_t>(EEPROMPageMap::SCHEDULE_FLAG),
+                static_cast<uint32_t>(EEPROMFlag::INVALID), policy));
+        }
+        return ret;
+    }
+
+    /**
+     * @brief Get the seal StallGuard calibration from the EEPROM
+     *
+     * @tparam Policy for reading from EEPROM
+     * @param policy Instance of Policy
+     * @return The calibration, or nothing if the seal hasn't been
+     * calibrated.
+     */
+    template <at24c0xc::AT24C0xC_Policy Policy>
+    [[nodiscard]] auto get_seal_calibration(Policy& policy)
+        -> std::optional<stall_calibration::Result> {
+        auto flag = _eeprom.template read_value<uint32_t>(
+            static_cast<uint8_t>(EEPROMPageMap::SEAL_FLAG), policy);
+        if (!flag.has_value() ||
+            flag.value() != static_cast<uint32_t>(EEPROMFlag::SEAL_WRITTEN)) {
+            return std::nullopt;
+        }
+        auto velocities = _eeprom.template read_value<SealVelocities>(
+            static_cast<uint8_t>(EEPROMPageMap::SEAL_VELOCITIES), policy);
+        auto sgt = _eeprom.template read_value<int32_t>(
+            static_cast<uint8_t>(EEPROMPageMap::SEAL_THRESHOLD), policy);
+        if (!velocities.has_value() || !sgt.has_value()) {
+            return std::nullopt;
+        }
+        return stall_calibration::Result{
+            .sgt = sgt.value(),
+            .min_velocity = velocities.value().at(0),
+            .home_velocity = velocities.value().at(1)};
+    }
+
+    /**
+     * @brief Write a new seal StallGuard calibration to the EEPROM
+     *
+     * @tparam Policy for writing to the EEPROM
+     * @param calibration The calibration to be written
+     * @param policy Instance of Policy
+     * @return True if the calibration was written, false otherwise
+     */
+    template <at24c0xc::AT24C0xC_Policy Policy>
+    auto write_seal_calibration(const stall_calibration::Result& calibration,
+                                Policy& policy) -> bool {
+        auto velocities =
+            SealVelocities{static_cast<float>(calibration.min_velocity),
+                           static_cast<float>(calibration.home_velocity)};
+        auto ret = _eeprom.template stage_value(
+            static_cast<uint8_t>(EEPROMPageMap::SEAL_VELOCITIES), velocities,
+            policy);
+        if (ret) {
+            ret = _eeprom.template stage_value(
+                static_cast<uint8_t>(EEPROMPageMap::SEAL_THRESHOLD),
+                static_cast<int32_t>(calibration.sgt), policy);
+        }
+        // Write the staged values before the flag
+        if (ret) {
+            ret = _eeprom.flush(policy);
+        }
+        if (ret) {
+            ret = _eeprom.template write_value(
+                static_cast<uint8_t>(EEPROMPageMap::SEAL_FLAG),
+                static_cast<uint32_t>(EEPROMFlag::SEAL_WRITTEN), policy);
+        }
+        if (!ret) {
+            static_cast<void>(_eeprom.template write_value(
+                static_cast<uint8_t>(EEPROMPageMap::SEAL_FLAG),
+                static_cast<uint32_t>(EEPROMFlag::INVALID), policy));
+        }
+        return ret;
+    }
+
     /**
      * @brief Check if the EEPROM has been read since initialization.
      *
@@ -158,17 +466,61 @@ class Eeprom {
         CONST_CC = 5,  // Value of the C constant for the center channel
         CONST_BR = 6,  // Value of the B constant for the right channel
         CONST_CR = 7,  // Value of the C constant for the right channel
+        MODEL_GAIN = 8,           // Plate model steady-state gain
+        MODEL_TIME_CONSTANT = 9,  // Plate model time constant
+        MODEL_DEAD_TIME = 10,     // Plate model dead time
+        // Flag indicating whether the plate model has been written.
+        // See \ref EEPROMFlag
+        MODEL_FLAG = 11,
+        PID_KP = 12,  // Peltier proportional constant
+        PID_KI = 13,  // Peltier integral constant
+        PID_KD = 14,  // Peltier derivative constant
+        // Flag indicating whether the PID constants have been written.
+        // See \ref EEPROMFlag
+        PID_FLAG = 15,
+        // First of the pages holding the gain schedule, two gains per page
+        SCHEDULE_START = 16,
+        // Flag indicating whether the gain schedule has been written.
+        // See \ref EEPROMFlag
+        SCHEDULE_FLAG = 25,
+        // Seal StallGuard minimum and homing velocities
+        SEAL_VELOCITIES = 26,
+        SEAL_THRESHOLD = 27,  // Seal StallGuard threshold
+        // Flag indicating whether the seal calibration has been written.
+        // See \ref EEPROMFlag
+        SEAL_FLAG = 28,
     };
 
     // Enumeration of the EEPROM_CONST_FLAG values
     enum class EEPROMFlag {
         CONSTANTS_WRITTEN = 3,  // Values of all constants are written (7 total)
+        MODEL_WRITTEN = 4,      // Values of the plate model are written
+        PID_WRITTEN = 5,        // Values of the PID constants are written
+        SCHEDULE_WRITTEN = 6,   // Values of the gain schedule are written
+        SEAL_WRITTEN = 7,       // Values of the seal calibration are written
         INVALID = 0xFF          // No values are written
     };
 
     static_assert(sizeof(EEPROMPageMap) == sizeof(uint8_t),
                   "EEPROM API requires uint8_t page address");
 
+    // Every gain in the schedule, in table order, stored two per page
+    using ScheduleValues =
+        std::array<float, gain_schedule::GainSchedule::ENTRIES * 3>;
+    using SchedulePage = std::array<float, 2>;
+    static constexpr size_t SCHEDULE_PAGES =
+        std::tuple_size_v<ScheduleValues> / 2;
+    static_assert(static_cast<size_t>(EEPROMPageMap::SCHEDULE_START) +
+                          SCHEDULE_PAGES ==
+                      static_cast<size_t>(EEPROMPageMap::SCHEDULE_FLAG),
+                  "Gain schedule pages must fit before the schedule flag");
+    static_assert(static_cast<size_t>(EEPROMPageMap::SCHEDULE_FLAG) < PAGES,
+                  "Gain schedule must fit in the EEPROM");
+    static_assert(static_cast<size_t>(EEPROMPageMap::SEAL_FLAG) < PAGES,
+                  "Seal calibration must fit in the EEPROM");
+    // Minimum and homing velocities of the seal calibration
+    using SealVelocities = std::array<float, 2>;
+
     /** Default value for all constants.*/
     static constexpr double OFFSET_DEFAULT_CONST = 0.0F;
 
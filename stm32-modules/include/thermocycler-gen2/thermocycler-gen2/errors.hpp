@@ -52,6 +52,8 @@ enum class ErrorCode {
     THERMAL_CONSTANT_OUT_OF_RANGE = 406,
     THERMAL_TARGET_BAD = 407,
     THERMAL_DRIFT = 408,
+    THERMAL_PROTOCOL_INVALID = 409,
+    THERMAL_PROTOCOL_ABORTED = 410,
     // 5xx - Mechanical subsystem errors
     LID_MOTOR_BUSY = 501,
     LID_MOTOR_FAULT = 502,
@@ -62,6 +64,7 @@ enum class ErrorCode {
     LID_CLOSED = 507,
     SEAL_MOTOR_SWITCH = 508,
     UNEXPECTED_LID_STATE = 509,
+    SEAL_MOTOR_CALIBRATION = 510,
 };
 
 auto errorstring(ErrorCode code) -> const char*;
@@ -0,0 +1,83 @@
+/**
+ * @file gain_schedule.hpp
+ * @brief Defines the GainSchedule class, a table of peltier PID gains
+ * indexed by temperature zone and by whether the plate is heating or
+ * cooling.
+ * @details The peltiers pump heat much more efficiently near the heatsink
+ * temperature than at either end of the plate's range, and they behave
+ * differently when heating and cooling, so a single set of gains is a
+ * compromise everywhere. The plate control looks up the gains for the
+ * zone of each peltier's current target and the direction of the last
+ * move, and switches to them without a bump in the output.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace gain_schedule {
+
+/** Temperature zones that gains are scheduled over. These match the
+ * zones the plate control uses for the fan.*/
+enum class Zone : uint8_t {
+    COLD = 0, /**< Below the heatsink.*/
+    WARM = 1, /**< Around the heatsink.*/
+    HOT = 2,  /**< Well above the heatsink.*/
+};
+
+static constexpr size_t ZONE_COUNT = 3;
+
+struct Gains {
+    double kp = 0.0F;
+    double ki = 0.0F;
+    double kd = 0.0F;
+
+    auto operator==(const Gains& other) const -> bool = default;
+};
+
+class GainSchedule {
+  public:
+    /** Number of entries in the table.*/
+    static constexpr size_t ENTRIES = ZONE_COUNT * 2;
+
+    GainSchedule() = default;
+    /** Create a schedule that uses the same gains everywhere.*/
+    explicit GainSchedule(const Gains& gains) { set_all(gains); }
+
+    /** Check whether a raw zone index is valid.*/
+    [[nodiscard]] static constexpr auto valid_zone(int zone) -> bool {
+        return (zone >= 0) && (zone < static_cast<int>(ZONE_COUNT));
+    }
+
+    /** Get the gains for a zone and direction.*/
+    [[nodiscard]] auto get(Zone zone, bool heating) const -> const Gains& {
+        return _table.at(index(zone, heating));
+    }
+
+    /** Set the gains for a zone and direction.*/
+    auto set(Zone zone, bool heating, const Gains& gains) -> void {
+        _table.at(index(zone, heating)) = gains;
+    }
+
+    /** Set every entry of the table to the same gains.*/
+    auto set_all(const Gains& gains) -> void { _table.fill(gains); }
+
+    /** Raw access to the table, for storage.*/
+    [[nodiscard]] auto table() const -> const std::array<Gains, ENTRIES>& {
+        return _table;
+    }
+    [[nodiscard]] auto table() -> std::array<Gains, ENTRIES>& {
+        return _table;
+    }
+
+  private:
+    [[nodiscard]] static constexpr auto index(Zone zone, bool heating)
+        -> size_t {
+        return (static_cast<size_t>(zone) * 2) + (heating ? 0 : 1);
+    }
+
+    std::array<Gains, ENTRIES> _table{};
+};
+
+}  // namespace gain_schedule
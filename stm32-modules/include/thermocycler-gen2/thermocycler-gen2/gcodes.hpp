@@ -19,10 +19,16 @@
 #include <utility>
 
 #include "core/gcode_parser.hpp"
+#include "core/relay_autotune.hpp"
+#include "core/stall_calibration.hpp"
+#include "core/task_stats_gcode.hpp"
 #include "core/utility.hpp"
 #include "systemwide.h"
 #include "thermocycler-gen2/errors.hpp"
+#include "thermocycler-gen2/gain_schedule.hpp"
 #include "thermocycler-gen2/motor_utils.hpp"
+#include "thermocycler-gen2/pcr_protocol.hpp"
+#include "thermocycler-gen2/thermistor_stats.hpp"
 #include "thermocycler-gen2/tmc2130_registers.hpp"
 
 namespace gcode {
@@ -1011,6 +1017,49 @@ struct SetSealParameter {
     }
 };
 
+struct CalibrateSealStall {
+    /**
+     * @brief CalibrateSealStall uses M244.D. Sweeps the seal stepper through
+     * a range of velocities to find its StallGuard threshold and minimum
+     * velocity, which are saved to the EEPROM and used to home the seal
+     * against a stall. The lid must be open.
+     *
+     * Syntax: M244.D\n
+     * Returns: M244.D T:<threshold> M:<min velocity> H:<home velocity> OK\n
+     * with velocities in steps/second
+     */
+    using ParseResult = std::optional<CalibrateSealStall>;
+    static constexpr auto prefix = std::array{'M', '2', '4', '4', '.', 'D'};
+
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        auto working = prefix_matches(input, limit, prefix);
+        if (working == input) {
+            return std::make_pair(ParseResult(), input);
+        }
+        return std::make_pair(ParseResult(CalibrateSealStall()), working);
+    }
+
+    template <typename InputIt, typename InputLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputLimit, InputIt>
+    static auto write_response_into(
+        InputIt buf, InputLimit limit,
+        const stall_calibration::Result& calibration) -> InputIt {
+        auto res = snprintf(&*buf, (limit - buf),
+                            "M244.D T:%i M:%.0f H:%.0f OK\n", calibration.sgt,
+                            calibration.min_velocity,
+                            calibration.home_velocity);
+        if (res <= 0) {
+            return buf;
+        }
+        return buf + res;
+    }
+};
+
 struct SetLidTemperature {
     /**
      * SetLidTemperature uses M140. Only parameter is optional and it is
@@ -1219,6 +1268,9 @@ struct SetPIDConstants {
      * - L = left peltier
      * - C = center peltier
      * - R = right peltier
+     *
+     * Peltier constants replace the whole gain schedule (see M305), and are
+     * saved to the EEPROM along with it.
      */
     using ParseResult = std::optional<SetPIDConstants>;
     static constexpr auto prefix = std::array{'M', '3', '0', '1'};
@@ -1229,10 +1281,726 @@ struct SetPIDConstants {
     static constexpr auto prefix_d = std::array{' ', 'D'};
     static constexpr const char* response = "M301 OK\n";
 
-    PidSelection selection;
-    double const_p;
-    double const_i;
-    double const_d;
+    PidSelection selection;
+    double const_p;
+    double const_i;
+    double const_d;
+
+    template <typename InputIt, typename InLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputIt, InLimit>
+    static auto write_response_into(InputIt buf, InLimit limit) -> InputIt {
+        return write_string_to_iterpair(buf, limit, response);
+    }
+
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        // For backwards compatability, default selection is Peltiers
+        PidSelection selection_val = PidSelection::PELTIERS;
+        auto working = prefix_matches(input, limit, prefix_with_selection);
+        if (working == input) {
+            // User skipped the selection
+            working = prefix_matches(input, limit, prefix);
+            if (working == input) {
+                return std::make_pair(ParseResult(), input);
+            }
+        } else {
+            // User made a selection
+            switch (*working) {
+                case 'H':
+                    selection_val = PidSelection::HEATER;
+                    break;
+                case 'P':
+                    selection_val = PidSelection::PELTIERS;
+                    break;
+                case 'F':
+                    selection_val = PidSelection::FANS;
+                    break;
+                default:
+                    return std::make_pair(ParseResult(), input);
+            }
+            std::advance(working, 1);
+            if (working == limit) {
+                return std::make_pair(ParseResult(), input);
+            }
+        }
+
+        auto old_working = working;
+        working = prefix_matches(old_working, limit, prefix_p);
+        if (working == old_working) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto p = parse_value<float>(working, limit);
+        if (!p.first.has_value()) {
+            return std::make_pair(ParseResult(), input);
+        }
+        old_working = p.second;
+
+        working = prefix_matches(old_working, limit, prefix_i);
+        if (working == old_working) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto i = parse_value<float>(working, limit);
+        if (!p.first.has_value()) {
+            return std::make_pair(ParseResult(), input);
+        }
+        old_working = i.second;
+
+        working = prefix_matches(old_working, limit, prefix_d);
+        if (working == old_working) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto d = parse_value<float>(working, limit);
+        if (!p.first.has_value()) {
+            return std::make_pair(ParseResult(), input);
+        }
+        working = d.second;
+
+        return std::make_pair(
+            ParseResult(SetPIDConstants{.selection = selection_val,
+                                        .const_p = p.first.value(),
+                                        .const_i = i.first.value(),
+                                        .const_d = d.first.value()}),
+            working);
+    }
+};
+
+/**
+ * Uses M303. Starts a relay feedback autotune of the PID constants for
+ * either the peltiers or the lid heater. The target should be close to the
+ * temperature the system is usually controlled at. The autotune runs in
+ * the background, and its progress and results are read with M304. Once
+ * it completes, the new constants are used immediately.
+ *
+ * M303 S<selection> T<target> [W<write>]
+ *
+ * Selection may be:
+ * - P = peltiers
+ * - H = lid heater
+ *
+ * If W1 is given, the peltier constants are also written to the EEPROM and
+ * loaded at startup. This is not available for the lid heater.
+ *
+ * Format: M303 SP T70 W1\n
+ */
+struct StartAutotune {
+    using ParseResult = std::optional<StartAutotune>;
+    static constexpr auto prefix = std::array{'M', '3', '0', '3', ' ', 'S'};
+    static constexpr auto prefix_t = std::array{' ', 'T'};
+    static constexpr auto prefix_w = std::array{' ', 'W'};
+    static constexpr const char* response = "M303 OK\n";
+
+    PidSelection selection = PidSelection::PELTIERS;
+    double target = 0.0F;
+    bool write = false;
+
+    template <typename InputIt, typename InLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputIt, InLimit>
+    static auto write_response_into(InputIt buf, InLimit limit) -> InputIt {
+        return write_string_to_iterpair(buf, limit, response);
+    }
+
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        auto working = prefix_matches(input, limit, prefix);
+        if (working == input || working == limit) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto ret = StartAutotune();
+        switch (*working) {
+            case 'H':
+                ret.selection = PidSelection::HEATER;
+                break;
+            case 'P':
+                ret.selection = PidSelection::PELTIERS;
+                break;
+            default:
+                return std::make_pair(ParseResult(), input);
+        }
+        std::advance(working, 1);
+
+        auto after_prefix = prefix_matches(working, limit, prefix_t);
+        if (after_prefix == working) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto target = parse_value<float>(after_prefix, limit);
+        if (!target.first.has_value()) {
+            return std::make_pair(ParseResult(), input);
+        }
+        ret.target = target.first.value();
+        working = target.second;
+
+        after_prefix = prefix_matches(working, limit, prefix_w);
+        if (after_prefix != working) {
+            auto write = parse_value<int>(after_prefix, limit);
+            if (!write.first.has_value()) {
+                return std::make_pair(ParseResult(), input);
+            }
+            ret.write = write.first.value() != 0;
+            working = write.second;
+        }
+        if (ret.write && ret.selection != PidSelection::PELTIERS) {
+            return std::make_pair(ParseResult(), input);
+        }
+        return std::make_pair(ParseResult(ret), working);
+    }
+};
+
+/**
+ * Uses M304. Gets the progress and result of the last autotune started
+ * with M303 for either the peltiers or the lid heater.
+ *
+ * Format: M304 S<selection>\n
+ *
+ * Returns: M304 S:<selection> R:<status> C:<cycles> U:<ultimate gain>
+ * T:<ultimate period> P:<kp> I:<ki> D:<kd> OK\n
+ *
+ * The status is one of IDLE, RUNNING, DONE or FAILED. The cycles are the
+ * number of oscillations measured so far, and the constants are only
+ * valid once the status is DONE.
+ */
+struct GetAutotuneResult {
+    using ParseResult = std::optional<GetAutotuneResult>;
+    static constexpr auto prefix = std::array{'M', '3', '0', '4', ' ', 'S'};
+
+    PidSelection selection = PidSelection::PELTIERS;
+
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        auto working = prefix_matches(input, limit, prefix);
+        if (working == input || working == limit) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto ret = GetAutotuneResult();
+        switch (*working) {
+            case 'H':
+                ret.selection = PidSelection::HEATER;
+                break;
+            case 'P':
+                ret.selection = PidSelection::PELTIERS;
+                break;
+            default:
+                return std::make_pair(ParseResult(), input);
+        }
+        std::advance(working, 1);
+        return std::make_pair(ParseResult(ret), working);
+    }
+
+    template <typename InputIt, typename InputLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputLimit, InputIt>
+    static auto write_response_into(InputIt buf, InputLimit limit,
+                                    PidSelection selection,
+                                    relay_autotune::Status status,
+                                    size_t cycles,
+                                    const relay_autotune::Result& result)
+        -> InputIt {
+        auto res = snprintf(
+            &*buf, (limit - buf),
+            "M304 S:%c R:%s C:%u U:%0.4f T:%0.2f P:%0.4f I:%0.4f D:%0.4f OK\n",
+            (selection == PidSelection::HEATER) ? 'H' : 'P',
+            relay_autotune::status_name(status),
+            static_cast<unsigned int>(cycles),
+            static_cast<float>(result.ultimate_gain),
+            static_cast<float>(result.ultimate_period),
+            static_cast<float>(result.kp), static_cast<float>(result.ki),
+            static_cast<float>(result.kd));
+        if (res <= 0) {
+            return buf;
+        }
+        return buf + std::min(static_cast<decltype(limit - buf)>(res),
+                              (limit - buf));
+    }
+};
+
+/**
+ * Uses M305. Sets one entry of the peltier PID gain schedule and saves
+ * the whole schedule to the EEPROM. The plate switches to the new gains
+ * smoothly, so this can be sent while the plate is controlling.
+ *
+ * M305 Z<zone> C<direction> P<proportional> I<integral> D<derivative>
+ *
+ * - Zone is 0 for cold (below 23ºC), 1 for warm and 2 for hot (32ºC and
+ * above). The zone is picked from each peltier's current target.
+ * - Direction is 0 for steps that heat the plate and 1 for steps that
+ * cool it.
+ *
+ * Sending M301 for the peltiers sets every entry of the schedule to the
+ * same gains, and saves that schedule to the EEPROM in place of this one.
+ *
+ * Format: M305 Z0 C1 P0.4 I0.08 D0.3\n
+ */
+struct SetGainSchedule {
+    using ParseResult = std::optional<SetGainSchedule>;
+    static constexpr auto prefix = std::array{'M', '3', '0', '5', ' ', 'Z'};
+    static constexpr auto prefix_c = std::array{' ', 'C'};
+    static constexpr auto prefix_p = std::array{' ', 'P'};
+    static constexpr auto prefix_i = std::array{' ', 'I'};
+    static constexpr auto prefix_d = std::array{' ', 'D'};
+    static constexpr const char* response = "M305 OK\n";
+
+    uint8_t zone;
+    bool heating;
+    double const_p;
+    double const_i;
+    double const_d;
+
+    template <typename InputIt, typename InLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputIt, InLimit>
+    static auto write_response_into(InputIt buf, InLimit limit) -> InputIt {
+        return write_string_to_iterpair(buf, limit, response);
+    }
+
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        auto working = prefix_matches(input, limit, prefix);
+        if (working == input) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto zone = parse_value<int>(working, limit);
+        if (!zone.first.has_value() ||
+            !gain_schedule::GainSchedule::valid_zone(zone.first.value())) {
+            return std::make_pair(ParseResult(), input);
+        }
+
+        working = prefix_matches(zone.second, limit, prefix_c);
+        if (working == zone.second) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto direction = parse_value<int>(working, limit);
+        if (!direction.first.has_value() ||
+            (direction.first.value() != 0 && direction.first.value() != 1)) {
+            return std::make_pair(ParseResult(), input);
+        }
+
+        working = prefix_matches(direction.second, limit, prefix_p);
+        if (working == direction.second) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto p = parse_value<float>(working, limit);
+        if (!p.first.has_value()) {
+            return std::make_pair(ParseResult(), input);
+        }
+
+        working = prefix_matches(p.second, limit, prefix_i);
+        if (working == p.second) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto i = parse_value<float>(working, limit);
+        if (!i.first.has_value()) {
+            return std::make_pair(ParseResult(), input);
+        }
+
+        working = prefix_matches(i.second, limit, prefix_d);
+        if (working == i.second) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto d = parse_value<float>(working, limit);
+        if (!d.first.has_value()) {
+            return std::make_pair(ParseResult(), input);
+        }
+
+        return std::make_pair(
+            ParseResult(SetGainSchedule{
+                .zone = static_cast<uint8_t>(zone.first.value()),
+                .heating = direction.first.value() == 0,
+                .const_p = p.first.value(),
+                .const_i = i.first.value(),
+                .const_d = d.first.value()}),
+            d.second);
+    }
+};
+
+/**
+ * Uses M306. Gets one entry of the peltier PID gain schedule. See M305
+ * for the meaning of the arguments.
+ *
+ * Format: M306 Z<zone> C<direction>\n
+ *
+ * Returns: M306 Z:<zone> C:<direction> P:<kp> I:<ki> D:<kd> OK\n
+ */
+struct GetGainSchedule {
+    using ParseResult = std::optional<GetGainSchedule>;
+    static constexpr auto prefix = std::array{'M', '3', '0', '6', ' ', 'Z'};
+    static constexpr auto prefix_c = std::array{' ', 'C'};
+
+    uint8_t zone;
+    bool heating;
+
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        auto working = prefix_matches(input, limit, prefix);
+        if (working == input) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto zone = parse_value<int>(working, limit);
+        if (!zone.first.has_value() ||
+            !gain_schedule::GainSchedule::valid_zone(zone.first.value())) {
+            return std::make_pair(ParseResult(), input);
+        }
+        working = prefix_matches(zone.second, limit, prefix_c);
+        if (working == zone.second) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto direction = parse_value<int>(working, limit);
+        if (!direction.first.has_value() ||
+            (direction.first.value() != 0 && direction.first.value() != 1)) {
+            return std::make_pair(ParseResult(), input);
+        }
+        return std::make_pair(
+            ParseResult(GetGainSchedule{
+                .zone = static_cast<uint8_t>(zone.first.value()),
+                .heating = direction.first.value() == 0}),
+            direction.second);
+    }
+
+    template <typename InputIt, typename InputLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputLimit, InputIt>
+    static auto write_response_into(InputIt buf, InputLimit limit,
+                                    uint8_t zone, bool heating, double kp,
+                                    double ki, double kd) -> InputIt {
+        auto res = snprintf(&*buf, (limit - buf),
+                            "M306 Z:%u C:%i P:%0.4f I:%0.4f D:%0.4f OK\n",
+                            static_cast<unsigned int>(zone),
+                            static_cast<int>(!heating), static_cast<float>(kp),
+                            static_cast<float>(ki), static_cast<float>(kd));
+        if (res <= 0) {
+            return buf;
+        }
+        return buf + std::min(static_cast<decltype(limit - buf)>(res),
+                              (limit - buf));
+    }
+};
+
+/**
+ * Uses M560. Discards the stored PCR protocol and starts a new, empty one.
+ * Stages and steps are then added with M561 and M562, and the protocol is
+ * run with M563.
+ *
+ * M560 [L<lid temperature>] [V<volume>]
+ *
+ * - L is the lid target for the whole run, in ºC. If it is not given, or
+ * is 0, the lid is left alone.
+ * - V is the sample volume in microliters. If it is not given, the
+ * firmware picks a default.
+ *
+ * Format: M560 L105 V25\n
+ */
+struct NewProtocol {
+    using ParseResult = std::optional<NewProtocol>;
+    static constexpr auto prefix = std::array{'M', '5', '6', '0'};
+    static constexpr auto lid_prefix = std::array{' ', 'L'};
+    static constexpr auto volume_prefix = std::array{' ', 'V'};
+    static constexpr const char* response = "M560 OK\n";
+
+    // If no volume is specified, set to a negative number and let
+    // the rest of the firmware decide a default value
+    constexpr static double default_volume = -1.0F;
+
+    double lid_temperature = 0.0F;
+    double volume = default_volume;
+
+    template <typename InputIt, typename InLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputIt, InLimit>
+    static auto write_response_into(InputIt buf, InLimit limit) -> InputIt {
+        return write_string_to_iterpair(buf, limit, response);
+    }
+
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        auto working = prefix_matches(input, limit, prefix);
+        if (working == input) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto ret = NewProtocol();
+
+        auto after_prefix = prefix_matches(working, limit, lid_prefix);
+        if (after_prefix != working) {
+            auto lid = parse_value<float>(after_prefix, limit);
+            if (!lid.first.has_value()) {
+                return std::make_pair(ParseResult(), input);
+            }
+            ret.lid_temperature = lid.first.value();
+            working = lid.second;
+        }
+
+        after_prefix = prefix_matches(working, limit, volume_prefix);
+        if (after_prefix != working) {
+            auto vol = parse_value<float>(after_prefix, limit);
+            if (!vol.first.has_value()) {
+                return std::make_pair(ParseResult(), input);
+            }
+            ret.volume = vol.first.value();
+            working = vol.second;
+        }
+        return std::make_pair(ParseResult(ret), working);
+    }
+};
+
+/**
+ * Uses M561. Appends a stage to the stored PCR protocol. Steps added with
+ * M562 after this belong to the new stage, and are repeated for the given
+ * number of cycles.
+ *
+ * Format: M561 C<cycles>\n
+ */
+struct AddProtocolStage {
+    using ParseResult = std::optional<AddProtocolStage>;
+    static constexpr auto prefix = std::array{'M', '5', '6', '1', ' ', 'C'};
+    static constexpr const char* response = "M561 OK\n";
+
+    uint32_t cycles = 0;
+
+    template <typename InputIt, typename InLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputIt, InLimit>
+    static auto write_response_into(InputIt buf, InLimit limit) -> InputIt {
+        return write_string_to_iterpair(buf, limit, response);
+    }
+
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        auto working = prefix_matches(input, limit, prefix);
+        if (working == input) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto cycles = parse_value<int>(working, limit);
+        if (!cycles.first.has_value() || cycles.first.value() <= 0) {
+            return std::make_pair(ParseResult(), input);
+        }
+        return std::make_pair(
+            ParseResult(AddProtocolStage{
+                .cycles = static_cast<uint32_t>(cycles.first.value())}),
+            cycles.second);
+    }
+};
+
+/**
+ * Uses M562. Appends a step to the last stage of the stored PCR protocol.
+ *
+ * M562 S<temperature> H<hold time> [R<ramp rate>]
+ *
+ * - S is the plate target in ºC
+ * - H is how long to hold the target once it is reached, in seconds. This
+ * must be more than 0.
+ * - R is the rate to ramp towards the target in ºC/s. If it is not given,
+ * or is 0, the plate moves as fast as it can.
+ *
+ * Format: M562 S95 H30 R2.5\n
+ */
+struct AddProtocolStep {
+    using ParseResult = std::optional<AddProtocolStep>;
+    static constexpr auto prefix = std::array{'M', '5', '6', '2', ' ', 'S'};
+    static constexpr auto hold_prefix = std::array{' ', 'H'};
+    static constexpr auto ramp_prefix = std::array{' ', 'R'};
+    static constexpr const char* response = "M562 OK\n";
+
+    double temperature = 0.0F;
+    double hold_time = 0.0F;
+    double ramp_rate = 0.0F;
+
+    template <typename InputIt, typename InLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputIt, InLimit>
+    static auto write_response_into(InputIt buf, InLimit limit) -> InputIt {
+        return write_string_to_iterpair(buf, limit, response);
+    }
+
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        auto working = prefix_matches(input, limit, prefix);
+        if (working == input) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto ret = AddProtocolStep();
+        auto temperature = parse_value<float>(working, limit);
+        if (!temperature.first.has_value()) {
+            return std::make_pair(ParseResult(), input);
+        }
+        ret.temperature = temperature.first.value();
+        working = temperature.second;
+
+        auto after_prefix = prefix_matches(working, limit, hold_prefix);
+        if (after_prefix == working) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto hold = parse_value<float>(after_prefix, limit);
+        if (!hold.first.has_value()) {
+            return std::make_pair(ParseResult(), input);
+        }
+        ret.hold_time = hold.first.value();
+        working = hold.second;
+
+        after_prefix = prefix_matches(working, limit, ramp_prefix);
+        if (after_prefix != working) {
+            auto ramp = parse_value<float>(after_prefix, limit);
+            if (!ramp.first.has_value()) {
+                return std::make_pair(ParseResult(), input);
+            }
+            ret.ramp_rate = ramp.first.value();
+            working = ramp.second;
+        }
+        return std::make_pair(ParseResult(ret), working);
+    }
+};
+
+/**
+ * Uses M563. Starts running the stored PCR protocol from its first step.
+ * The plate steps through the protocol on its own, and the lid is set to
+ * the protocol's lid temperature. Progress is read with M564.
+ *
+ * A running protocol is stopped by any command that changes the plate
+ * target or deactivates the plate (M104, M14, M18), and by plate errors.
+ * When the protocol completes, the plate keeps holding the temperature of
+ * the final step.
+ *
+ * M563 [P<preheat>]
+ *
+ * - P1 preheats the lid. The lid starts heating right away, and the plate
+ * waits to start the first step until the lid is about as far from its
+ * target, in time, as the plate is from the first step. Both then reach
+ * their targets at about the same time. The protocol reports PREHEATING
+ * until then. This does nothing if the protocol has no lid temperature.
+ *
+ * Format: M563 P1\n
+ */
+struct StartProtocol {
+    using ParseResult = std::optional<StartProtocol>;
+    static constexpr auto prefix = std::array{'M', '5', '6', '3'};
+    static constexpr auto preheat_prefix = std::array{' ', 'P'};
+    static constexpr const char* response = "M563 OK\n";
+
+    bool preheat = false;
+
+    template <typename InputIt, typename InLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputIt, InLimit>
+    static auto write_response_into(InputIt buf, InLimit limit) -> InputIt {
+        return write_string_to_iterpair(buf, limit, response);
+    }
+
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        auto working = prefix_matches(input, limit, prefix);
+        if (working == input) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto ret = StartProtocol();
+
+        auto after_prefix = prefix_matches(working, limit, preheat_prefix);
+        if (after_prefix != working) {
+            auto preheat = parse_value<int>(after_prefix, limit);
+            if (!preheat.first.has_value() ||
+                (preheat.first.value() != 0 && preheat.first.value() != 1)) {
+                return std::make_pair(ParseResult(), input);
+            }
+            ret.preheat = preheat.first.value() == 1;
+            working = preheat.second;
+        }
+        return std::make_pair(ParseResult(ret), working);
+    }
+};
+
+/**
+ * Uses M564. Gets the progress of the PCR protocol started with M563.
+ *
+ * Format: M564\n
+ *
+ * Returns: M564 R:<status> S:<stage> P:<step> C:<cycle>/<cycles>
+ * H:<remaining hold> OK\n
+ *
+ * The status is one of IDLE, PREHEATING, RUNNING, COMPLETE or ABORTED. The
+ * stage, step and cycle count from 1, and the step counts from the start of
+ * its stage. The remaining hold time is in seconds, and is 0 unless the
+ * protocol is running.
+ */
+struct GetProtocolStatus {
+    using ParseResult = std::optional<GetProtocolStatus>;
+    static constexpr auto prefix = std::array{'M', '5', '6', '4'};
+
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        auto working = prefix_matches(input, limit, prefix);
+        if (working == input) {
+            return std::make_pair(ParseResult(), input);
+        }
+        return std::make_pair(ParseResult(GetProtocolStatus()), working);
+    }
+
+    template <typename InputIt, typename InputLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputLimit, InputIt>
+    static auto write_response_into(InputIt buf, InputLimit limit,
+                                    const pcr_protocol::Progress& progress,
+                                    double hold_remaining) -> InputIt {
+        auto res = snprintf(&*buf, (limit - buf),
+                            "M564 R:%s S:%u P:%u C:%u/%u H:%0.1f OK\n",
+                            pcr_protocol::status_name(progress.status),
+                            static_cast<unsigned int>(progress.stage + 1),
+                            static_cast<unsigned int>(progress.step + 1),
+                            static_cast<unsigned int>(progress.cycle + 1),
+                            static_cast<unsigned int>(progress.cycles),
+                            static_cast<float>(hold_remaining));
+        if (res <= 0) {
+            return buf;
+        }
+        return buf + std::min(static_cast<decltype(limit - buf)>(res),
+                              (limit - buf));
+    }
+};
+
+/**
+ * Uses M118. Chooses when the hold timer of a plate step starts.
+ *
+ * M118 S<mode>
+ *
+ * - S0 starts the hold once the plate thermistors settle at the target.
+ * This is the default.
+ * - S1 starts the hold once the estimated sample temperature reaches the
+ * target. The estimate uses the volume given with M104 or M560.
+ *
+ * Format: M118 S1\n
+ */
+struct SetSampleHold {
+    using ParseResult = std::optional<SetSampleHold>;
+    static constexpr auto prefix = std::array{'M', '1', '1', '8', ' ', 'S'};
+    static constexpr const char* response = "M118 OK\n";
+
+    bool enable = false;
 
     template <typename InputIt, typename InLimit>
     requires std::forward_iterator<InputIt> &&
@@ -1246,73 +2014,60 @@ struct SetPIDConstants {
         std::sized_sentinel_for<Limit, InputIt>
     static auto parse(const InputIt& input, Limit limit)
         -> std::pair<ParseResult, InputIt> {
-        // For backwards compatability, default selection is Peltiers
-        PidSelection selection_val = PidSelection::PELTIERS;
-        auto working = prefix_matches(input, limit, prefix_with_selection);
+        auto working = prefix_matches(input, limit, prefix);
         if (working == input) {
-            // User skipped the selection
-            working = prefix_matches(input, limit, prefix);
-            if (working == input) {
-                return std::make_pair(ParseResult(), input);
-            }
-        } else {
-            // User made a selection
-            switch (*working) {
-                case 'H':
-                    selection_val = PidSelection::HEATER;
-                    break;
-                case 'P':
-                    selection_val = PidSelection::PELTIERS;
-                    break;
-                case 'F':
-                    selection_val = PidSelection::FANS;
-                    break;
-                default:
-                    return std::make_pair(ParseResult(), input);
-            }
-            std::advance(working, 1);
-            if (working == limit) {
-                return std::make_pair(ParseResult(), input);
-            }
-        }
-
-        auto old_working = working;
-        working = prefix_matches(old_working, limit, prefix_p);
-        if (working == old_working) {
             return std::make_pair(ParseResult(), input);
         }
-        auto p = parse_value<float>(working, limit);
-        if (!p.first.has_value()) {
+        auto mode = parse_value<int>(working, limit);
+        if (!mode.first.has_value() ||
+            (mode.first.value() != 0 && mode.first.value() != 1)) {
             return std::make_pair(ParseResult(), input);
         }
-        old_working = p.second;
+        return std::make_pair(
+            ParseResult(SetSampleHold{.enable = mode.first.value() == 1}),
+            mode.second);
+    }
+};
 
-        working = prefix_matches(old_working, limit, prefix_i);
-        if (working == old_working) {
-            return std::make_pair(ParseResult(), input);
-        }
-        auto i = parse_value<float>(working, limit);
-        if (!p.first.has_value()) {
-            return std::make_pair(ParseResult(), input);
-        }
-        old_working = i.second;
+/**
+ * Uses M120. Gets the estimated temperature of the sample in the plate,
+ * and whether holds are timed from it (see M118). The estimate is only
+ * updated while the plate is controlling a temperature.
+ *
+ * Format: M120\n
+ *
+ * Returns: M120 T:<sample temperature> S:<mode> OK\n
+ */
+struct GetSampleEstimate {
+    using ParseResult = std::optional<GetSampleEstimate>;
+    static constexpr auto prefix = std::array{'M', '1', '2', '0'};
 
-        working = prefix_matches(old_working, limit, prefix_d);
-        if (working == old_working) {
-            return std::make_pair(ParseResult(), input);
-        }
-        auto d = parse_value<float>(working, limit);
-        if (!p.first.has_value()) {
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        auto working = prefix_matches(input, limit, prefix);
+        if (working == input) {
             return std::make_pair(ParseResult(), input);
         }
-        working = d.second;
+        return std::make_pair(ParseResult(GetSampleEstimate()), working);
+    }
 
-        return std::make_pair(
-            ParseResult(SetPIDConstants{.selection = selection_val,
-                                        .const_p = p.first.value(),
-                                        .const_i = i.first.value(),
-                                        .const_d = d.first.value()}),
-            working);
+    template <typename InputIt, typename InputLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputLimit, InputIt>
+    static auto write_response_into(InputIt buf, InputLimit limit,
+                                    double sample_temp, bool sample_hold)
+        -> InputIt {
+        auto res = snprintf(&*buf, (limit - buf), "M120 T:%0.2f S:%i OK\n",
+                            static_cast<float>(sample_temp),
+                            static_cast<int>(sample_hold));
+        if (res <= 0) {
+            return buf;
+        }
+        return buf + std::min(static_cast<decltype(limit - buf)>(res),
+                              (limit - buf));
     }
 };
 
@@ -1487,6 +2242,112 @@ struct GetOffsetConstants {
     }
 };
 
+/**
+ * Uses M150. Sets the thermal model of the plate that is used for
+ * feed-forward control of temperature steps, and saves it to the EEPROM.
+ * The model is first order plus dead time, with three parameters:
+ * - K is the steady-state rise over ambient at full power, in ºC
+ * - T is the time constant, in seconds
+ * - D is the dead time, in seconds
+ *
+ * Setting all three to 0 disables feed-forward control.
+ *
+ * Format: M150 K120.5 T45.2 D1.8\n
+ */
+struct SetPlateModel {
+    using ParseResult = std::optional<SetPlateModel>;
+    static constexpr auto prefix = std::array{'M', '1', '5', '0'};
+    static constexpr auto prefix_k = std::array{' ', 'K'};
+    static constexpr auto prefix_t = std::array{' ', 'T'};
+    static constexpr auto prefix_d = std::array{' ', 'D'};
+    static constexpr const char* response = "M150 OK\n";
+
+    double gain = 0.0F;
+    double time_constant = 0.0F;
+    double dead_time = 0.0F;
+
+    template <typename InputIt, typename InLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputIt, InLimit>
+    static auto write_response_into(InputIt buf, InLimit limit) -> InputIt {
+        return write_string_to_iterpair(buf, limit, response);
+    }
+
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        auto working = prefix_matches(input, limit, prefix);
+        if (working == input) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto ret = SetPlateModel();
+        auto parse_field = [&working, limit](const auto& field_prefix,
+                                             double& value) -> bool {
+            auto after_prefix = prefix_matches(working, limit, field_prefix);
+            if (after_prefix == working) {
+                return false;
+            }
+            auto parsed = parse_value<float>(after_prefix, limit);
+            if (!parsed.first.has_value()) {
+                return false;
+            }
+            value = parsed.first.value();
+            working = parsed.second;
+            return true;
+        };
+        if (!parse_field(prefix_k, ret.gain) ||
+            !parse_field(prefix_t, ret.time_constant) ||
+            !parse_field(prefix_d, ret.dead_time)) {
+            return std::make_pair(ParseResult(), input);
+        }
+        return std::make_pair(ParseResult(ret), working);
+    }
+};
+
+/**
+ * Uses M151. Returns the thermal model of the plate (see SetPlateModel).
+ *
+ * Format: M151\n
+ *
+ * Returns: M151 K:[gain] T:[time constant] D:[dead time] OK\n
+ */
+struct GetPlateModel {
+    using ParseResult = std::optional<GetPlateModel>;
+    static constexpr auto prefix = std::array{'M', '1', '5', '1'};
+
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        auto working = prefix_matches(input, limit, prefix);
+        if (working == input) {
+            return std::make_pair(ParseResult(), input);
+        }
+        return std::make_pair(ParseResult(GetPlateModel()), working);
+    }
+
+    template <typename InputIt, typename InputLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputLimit, InputIt>
+    static auto write_response_into(InputIt buf, InputLimit limit, double gain,
+                                    double time_constant, double dead_time)
+        -> InputIt {
+        auto res = snprintf(&*buf, (limit - buf),
+                            "M151 K:%0.3f T:%0.3f D:%0.3f OK\n",
+                            static_cast<float>(gain),
+                            static_cast<float>(time_constant),
+                            static_cast<float>(dead_time));
+        if (res <= 0) {
+            return buf;
+        }
+        return buf + std::min(static_cast<decltype(limit - buf)>(res),
+                              (limit - buf));
+    }
+};
+
 /**
  * @brief Uses M126, same as gen 1 thermocycler. Opens the lid.
  *
@@ -1788,4 +2649,202 @@ struct SetLightsDebug {
     }
 };
 
+struct GetTraceDebug {
+    /**
+     * GetTraceDebug uses M931.D to control and read out the trace buffer
+     * (see core/trace.hpp).
+     *
+     * M931.D E\n clears the buffer and starts recording.
+     *
+     * M931.D S<index>\n pauses recording and returns up to
+     * EVENTS_PER_RESPONSE events starting at <index>, oldest first:
+     *
+     *   M931.D T:<ticks per us> N:<event count> S:<index> <events> OK
+     *
+     * where each event is <timestamp>:<id><phase>, with the timestamp and
+     * id in hex and the phase one of B (begin), E (end) or i (instant).
+     * Plain M931.D is the same as M931.D S0.
+     */
+    using ParseResult = std::optional<GetTraceDebug>;
+    static constexpr auto prefix = std::array{'M', '9', '3', '1', '.', 'D'};
+    static constexpr auto start_prefix = std::array{' ', 'E'};
+    static constexpr auto index_prefix = std::array{' ', 'S'};
+    static constexpr const char* start_response = "M931.D OK\n";
+    static constexpr size_t EVENTS_PER_RESPONSE = 8;
+
+    bool start_recording = false;
+    uint16_t index = 0;
+
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        auto working = prefix_matches(input, limit, prefix);
+        if (working == input) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto after_start = prefix_matches(working, limit, start_prefix);
+        if (after_start != working) {
+            return std::make_pair(
+                ParseResult(GetTraceDebug{.start_recording = true}),
+                after_start);
+        }
+        auto after_index = prefix_matches(working, limit, index_prefix);
+        if (after_index != working) {
+            auto index = parse_value<uint16_t>(after_index, limit);
+            if (!index.first.has_value()) {
+                return std::make_pair(ParseResult(), input);
+            }
+            return std::make_pair(
+                ParseResult(GetTraceDebug{.index = index.first.value()}),
+                index.second);
+        }
+        return std::make_pair(ParseResult(GetTraceDebug()), working);
+    }
+
+    template <typename InputIt, typename InLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputIt, InLimit>
+    static auto write_response_into(InputIt buf, InLimit limit) -> InputIt {
+        return write_string_to_iterpair(buf, limit, start_response);
+    }
+
+    template <typename InputIt, typename InLimit, typename TraceBuffer>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputIt, InLimit>
+    auto write_response_into(InputIt buf, InLimit limit,
+                             const TraceBuffer& trace,
+                             uint32_t ticks_per_us) const -> InputIt {
+        auto count = trace.count();
+        auto res = snprintf(&*buf, (limit - buf), "M931.D T:%u N:%u S:%u",
+                            static_cast<unsigned>(ticks_per_us),
+                            static_cast<unsigned>(count),
+                            static_cast<unsigned>(index));
+        if (res <= 0) {
+            return buf;
+        }
+        buf += std::min(static_cast<decltype(limit - buf)>(res),
+                        (limit - buf));
+        auto end = std::min(count, static_cast<size_t>(index) +
+                                       EVENTS_PER_RESPONSE);
+        for (size_t i = index; i < end; ++i) {
+            auto event = trace.at(i);
+            res = snprintf(&*buf, (limit - buf), " %08x:%04x%c",
+                           static_cast<unsigned>(event.timestamp),
+                           static_cast<unsigned>(event.id),
+                           static_cast<char>(event.phase));
+            if (res <= 0) {
+                return buf;
+            }
+            buf += std::min(static_cast<decltype(limit - buf)>(res),
+                            (limit - buf));
+        }
+        return write_string_to_iterpair(buf, limit, " OK\n");
+    }
+};
+
+struct GetThermistorStatsDebug {
+    /**
+     * GetThermistorStatsDebug uses M932.D to report the uniformity
+     * statistics of the plate thermistors over their most recent readings
+     * (see thermistor_stats.hpp). The statistics are gathered on every
+     * plate reading, whether or not the plate is being controlled.
+     *
+     * M932.D\n reports the statistics. M932.D R\n reports them and then
+     * clears them, so the next report only covers later readings.
+     *
+     * Returns:
+     *
+     *   M932.D N:<readings> S:<spread> BL:<stats> FL:<stats> BC:<stats>
+     *   FC:<stats> BR:<stats> FR:<stats> P:<pair spreads> OK
+     *
+     * where each <stats> is <mean>,<stddev>,<min>,<max> over the window for
+     * one thermistor (back/front, left/center/right), S is the same for the
+     * spread between the hottest and coldest thermistor, and the pair
+     * spreads are the differences between the thermistor means in the order
+     * BL-FL, BL-BC, BL-FC, ... BR-FR.
+     */
+    using ParseResult = std::optional<GetThermistorStatsDebug>;
+    using Summary = thermistor_stats::ThermistorStats::Summary;
+    static constexpr auto prefix = std::array{'M', '9', '3', '2', '.', 'D'};
+    static constexpr auto reset_prefix = std::array{' ', 'R'};
+    static constexpr std::array<const char*,
+                                thermistor_stats::ThermistorStats::CHANNELS>
+        names{"BL", "FL", "BC", "FC", "BR", "FR"};
+
+    bool reset = false;
+
+    template <typename InputIt, typename Limit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<Limit, InputIt>
+    static auto parse(const InputIt& input, Limit limit)
+        -> std::pair<ParseResult, InputIt> {
+        auto working = prefix_matches(input, limit, prefix);
+        if (working == input) {
+            return std::make_pair(ParseResult(), input);
+        }
+        auto after_reset = prefix_matches(working, limit, reset_prefix);
+        if (after_reset != working) {
+            return std::make_pair(
+                ParseResult(GetThermistorStatsDebug{.reset = true}),
+                after_reset);
+        }
+        return std::make_pair(ParseResult(GetThermistorStatsDebug()),
+                              working);
+    }
+
+    template <typename InputIt, typename InLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputIt, InLimit>
+    static auto write_response_into(InputIt buf, InLimit limit,
+                                    const Summary& stats) -> InputIt {
+        auto res = snprintf(&*buf, (limit - buf), "M932.D N:%u",
+                            static_cast<unsigned>(stats.samples));
+        if (res <= 0) {
+            return buf;
+        }
+        buf += std::min(static_cast<decltype(limit - buf)>(res),
+                        (limit - buf));
+        buf = write_channel(buf, limit, "S", stats.spread);
+        for (size_t i = 0; i < names.size(); ++i) {
+            buf = write_channel(buf, limit, names.at(i),
+                                stats.thermistors.at(i));
+        }
+        buf = write_string_to_iterpair(buf, limit, " P:");
+        const char* separator = "";
+        for (size_t i = 0; i < names.size(); ++i) {
+            for (size_t j = i + 1; j < names.size(); ++j) {
+                res = snprintf(&*buf, (limit - buf), "%s%0.2f", separator,
+                               stats.thermistors.at(i).mean -
+                                   stats.thermistors.at(j).mean);
+                if (res <= 0) {
+                    return buf;
+                }
+                buf += std::min(static_cast<decltype(limit - buf)>(res),
+                                (limit - buf));
+                separator = ",";
+            }
+        }
+        return write_string_to_iterpair(buf, limit, " OK\n");
+    }
+
+  private:
+    template <typename InputIt, typename InLimit>
+    requires std::forward_iterator<InputIt> &&
+        std::sized_sentinel_for<InputIt, InLimit>
+    static auto write_channel(InputIt buf, InLimit limit, const char* name,
+                              const thermistor_stats::ChannelSummary& channel)
+        -> InputIt {
+        auto res = snprintf(&*buf, (limit - buf), " %s:%0.2f,%0.3f,%0.2f,%0.2f",
+                            name, channel.mean, channel.stddev, channel.min,
+                            channel.max);
+        if (res <= 0) {
+            return buf;
+        }
+        return buf + std::min(static_cast<decltype(limit - buf)>(res),
+                              (limit - buf));
+    }
+};
+
 }  // namespace gcode
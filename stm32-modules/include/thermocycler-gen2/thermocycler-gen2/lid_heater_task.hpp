@@ -4,16 +4,21 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
 #include <concepts>
 #include <cstddef>
 #include <variant>
 
 #include "core/pid.hpp"
+#include "core/relay_autotune.hpp"
 #include "core/thermistor_conversion.hpp"
+#include "core/trace.hpp"
 #include "hal/message_queue.hpp"
 #include "thermistor_lookups.hpp"
 #include "thermocycler-gen2/errors.hpp"
+#include "thermocycler-gen2/lid_preheat.hpp"
 #include "thermocycler-gen2/messages.hpp"
 #include "thermocycler-gen2/tasks.hpp"
 #include "thermocycler-gen2/thermal_general.hpp"
@@ -47,7 +52,8 @@ struct State {
         IDLE,        /**< Not doing anything.*/
         ERROR,       /**< Experiencing an error.*/
         CONTROLLING, /**< Controlling temperature (PID).*/
-        HEATER_TEST  /**< Testing PWM output (debug command).*/
+        HEATER_TEST, /**< Testing PWM output (debug command).*/
+        AUTOTUNING   /**< Running a relay autotune of the heater PID.*/
     };
     Status system_status;
     uint16_t error_bitmap;
@@ -66,7 +72,14 @@ class LidHeaterTask {
     using Queue = QueueImpl<Message>;
     using Milliseconds = std::chrono::milliseconds;
     using Seconds = std::chrono::duration<double, std::chrono::seconds::period>;
+    // Nominal control period, which the PID gains are specified against
     static constexpr const uint32_t CONTROL_PERIOD_TICKS = 100;
+    // Control period while the lid is far from its setpoint
+    static constexpr const uint32_t RAMP_CONTROL_PERIOD_TICKS = 50;
+    // Control period while holding a temperature or idle
+    static constexpr const uint32_t HOLD_CONTROL_PERIOD_TICKS = 200;
+    // Distance from the setpoint at which the lid is considered to be ramping
+    static constexpr double RAMP_BAND_C = 2.0;
     static constexpr double THERMISTOR_CIRCUIT_BIAS_RESISTANCE_KOHM = 10.0;
     static constexpr uint16_t ADC_BIT_MAX = 0x5DC0;
     // TODO most of these defaults will have to change
@@ -80,6 +93,10 @@ class LidHeaterTask {
     static constexpr double KD_MIN = -200;
     static constexpr double KD_MAX = 200;
     static constexpr double OVERTEMP_LIMIT_C = 115;
+    // The lid can only heat, so the relay switches the heater on and off
+    static constexpr double AUTOTUNE_MAX_TARGET_C = 110.0F;
+    static constexpr double AUTOTUNE_HYSTERESIS_C = 0.5F;
+    static constexpr double AUTOTUNE_TIMEOUT_S = 1800.0F;
     // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
     static constexpr const double CONTROL_PERIOD_SECONDS =
         CONTROL_PERIOD_TICKS * 0.001;
@@ -116,6 +133,15 @@ class LidHeaterTask {
         return _last_update;
     }
 
+    /**
+     * @brief Get the period that the thermistor should currently be
+     * sampled at. This is read by the thermistor sampling task, so it is
+     * safe to call from a different thread than the one running the task.
+     */
+    [[nodiscard]] auto get_control_period_ticks() const -> uint32_t {
+        return _control_period_ticks.load(std::memory_order_relaxed);
+    }
+
     /**
      * run_once() runs one spin of the task. This means it
      * - Waits for a message, either a thermistor update or
@@ -138,11 +164,18 @@ class LidHeaterTask {
         // frequency.
 
         static_cast<void>(_message_queue.recv(&message));
+        auto handling = trace::Scope(
+            trace::message_event(trace::TASK_LID_HEATER, message.index()));
         std::visit(
             [this, &policy](const auto& msg) -> void {
                 this->visit_message(msg, policy);
             },
             message);
+        update_control_period();
+        // A plate protocol hears about an error before its preheat is
+        // cancelled, so it can report why it stopped
+        release_protocol_if_idle();
+        cancel_preheat_if_idle();
     }
 
   private:
@@ -157,6 +190,7 @@ class LidHeaterTask {
     requires LidHeaterExecutionPolicy<Policy>
     auto visit_message(const messages::LidTempReadComplete& msg, Policy& policy)
         -> void {
+        auto tick = trace::Scope(trace::LID_CONTROL_TICK);
         constexpr Milliseconds time_overflow_amount = Milliseconds(
             std::numeric_limits<decltype(msg.timestamp_ms)>::max());
         auto old_error_bitmap = _state.error_bitmap;
@@ -167,6 +201,7 @@ class LidHeaterTask {
             if (_state.error_bitmap != 0) {
                 // We entered an error state. Disable power output.
                 _state.system_status = State::ERROR;
+                _autotune.abort();
                 policy.set_heater_power(0.0F);
             } else {
                 // We went from an error state to no error state... so go idle
@@ -174,20 +209,25 @@ class LidHeaterTask {
             }
         }
 
+        auto time_delta = current_time - _last_update;
+        if (time_delta.count() < 0) {
+            time_delta += time_overflow_amount;
+        }
+        auto elapsed = std::chrono::duration_cast<Seconds>(time_delta).count();
         // If we're in a controlling state, we now update the heater output
         if (_state.system_status == State::CONTROLLING) {
-            auto time_delta = current_time - _last_update;
-            if (time_delta.count() < 0) {
-                time_delta += time_overflow_amount;
-            }
-            auto power = update_control(
-                std::chrono::duration_cast<Seconds>(time_delta).count());
+            auto power = update_control(elapsed);
             auto ret = policy.set_heater_power(power);
             if (!ret) {
                 policy.set_heater_power(0.0F);
                 _state.system_status = State::ERROR;
                 _state.error_bitmap |= State::HEATER_POWER_ERROR;
             }
+            if (_preheat.update(_thermistor.temp_c, _setpoint_c, elapsed)) {
+                send_preheat_done(true);
+            }
+        } else if (_state.system_status == State::AUTOTUNING) {
+            update_autotune(policy, elapsed);
         } else if (_state.system_status != State::HEATER_TEST) {
             policy.set_heater_power(0.0F);
         }
@@ -238,7 +278,8 @@ class LidHeaterTask {
                 _task_registry->comms->get_message_queue().try_send(response));
             return;
         }
-        if (_state.system_status == State::CONTROLLING) {
+        if (_state.system_status == State::CONTROLLING ||
+            _state.system_status == State::AUTOTUNING) {
             // Send busy error
             response.with_error = errors::ErrorCode::THERMAL_LID_BUSY;
             static_cast<void>(
@@ -264,10 +305,17 @@ class LidHeaterTask {
                        Policy& policy) -> void {
         auto response =
             messages::AcknowledgePrevious{.responding_to_id = msg.id};
+        // The newest target decides who the lid is heating for
+        _heating_for_protocol = msg.from_plate;
         if (_state.system_status == State::ERROR) {
-            response.with_error = most_relevant_error();
-            static_cast<void>(
-                _task_registry->comms->get_message_queue().try_send(response));
+            if (!msg.from_plate) {
+                response.with_error = most_relevant_error();
+                static_cast<void>(
+                    _task_registry->comms->get_message_queue().try_send(
+                        response));
+            }
+            release_protocol_if_idle();
+            refuse_preheat(msg);
             return;
         }
         if (_state.system_status == State::HEATER_TEST) {
@@ -276,13 +324,20 @@ class LidHeaterTask {
                 response.with_error = errors::ErrorCode::THERMAL_HEATER_ERROR;
                 _state.system_status = State::ERROR;
                 _state.error_bitmap |= State::HEATER_POWER_ERROR;
-                static_cast<void>(
-                    _task_registry->comms->get_message_queue().try_send(
-                        response));
+                if (!msg.from_plate) {
+                    static_cast<void>(
+                        _task_registry->comms->get_message_queue().try_send(
+                            response));
+                }
+                release_protocol_if_idle();
+                refuse_preheat(msg);
                 return;
             }
         }
 
+        // A new target takes over from any autotune in progress
+        _autotune.abort();
+
         if (msg.setpoint <= 0.0F) {
             _setpoint_c = 0.0F;
             _state.system_status = State::IDLE;
@@ -290,15 +345,35 @@ class LidHeaterTask {
             _setpoint_c = msg.setpoint;
             _state.system_status = State::CONTROLLING;
             _pid.reset();
+            if (msg.from_plate && msg.preheat_lead_time >= 0.0F) {
+                _preheat.start(msg.preheat_lead_time);
+            }
         }
 
-        static_cast<void>(
-            _task_registry->comms->get_message_queue().try_send(response));
+        if (!msg.from_plate) {
+            static_cast<void>(
+                _task_registry->comms->get_message_queue().try_send(response));
+        }
     }
 
     template <LidHeaterExecutionPolicy Policy>
     auto visit_message(const messages::DeactivateLidHeatingMessage& msg,
                        Policy& policy) -> void {
+        if (msg.from_plate) {
+            // The host may have taken over the lid since the protocol
+            // started, in which case it stays on
+            if (_heating_for_protocol &&
+                _state.system_status == State::CONTROLLING) {
+                _heating_for_protocol = false;
+                _state.system_status = State::IDLE;
+                if (!policy.set_heater_power(0.0F)) {
+                    _state.system_status = State::ERROR;
+                    _state.error_bitmap |= State::HEATER_POWER_ERROR;
+                }
+            }
+            return;
+        }
+        _heating_for_protocol = false;
         auto response =
             messages::AcknowledgePrevious{.responding_to_id = msg.id};
 
@@ -311,6 +386,7 @@ class LidHeaterTask {
         }
 
         auto ret = policy.set_heater_power(0.0F);
+        _autotune.abort();
         _state.system_status = State::IDLE;
 
         if (!ret) {
@@ -335,6 +411,7 @@ class LidHeaterTask {
             messages::DeactivateAllResponse{.responding_to_id = msg.id};
 
         static_cast<void>(policy.set_heater_power(0.0F));
+        _autotune.abort();
         if (_state.system_status != State::ERROR) {
             _state.system_status = State::IDLE;
         }
@@ -350,7 +427,8 @@ class LidHeaterTask {
         auto response =
             messages::AcknowledgePrevious{.responding_to_id = msg.id};
 
-        if (_state.system_status == State::CONTROLLING) {
+        if (_state.system_status == State::CONTROLLING ||
+            _state.system_status == State::AUTOTUNING) {
             response.with_error = errors::ErrorCode::THERMAL_LID_BUSY;
             static_cast<void>(
                 _task_registry->comms->get_message_queue().try_send(response));
@@ -392,6 +470,47 @@ class LidHeaterTask {
             _task_registry->comms->get_message_queue().try_send(response));
     }
 
+    template <LidHeaterExecutionPolicy Policy>
+    auto visit_message(const messages::StartAutotuneMessage& msg,
+                       Policy& policy) -> void {
+        static_cast<void>(policy);
+        auto response =
+            messages::AcknowledgePrevious{.responding_to_id = msg.id};
+        if (_state.system_status == State::ERROR) {
+            response.with_error = most_relevant_error();
+        } else if (_state.system_status != State::IDLE) {
+            response.with_error = errors::ErrorCode::THERMAL_LID_BUSY;
+        } else if (msg.target <= _thermistor.temp_c ||
+                   msg.target > AUTOTUNE_MAX_TARGET_C) {
+            // The lid can't cool, so the target must be above ambient
+            response.with_error = errors::ErrorCode::THERMAL_TARGET_BAD;
+        } else {
+            _autotune.start(
+                relay_autotune::Settings{.setpoint = msg.target,
+                                         .output_high = 1.0F,
+                                         .output_low = 0.0F,
+                                         .hysteresis = AUTOTUNE_HYSTERESIS_C,
+                                         .timeout = AUTOTUNE_TIMEOUT_S});
+            _state.system_status = State::AUTOTUNING;
+        }
+        static_cast<void>(
+            _task_registry->comms->get_message_queue().try_send(response));
+    }
+
+    template <LidHeaterExecutionPolicy Policy>
+    auto visit_message(const messages::GetAutotuneResultMessage& msg,
+                       Policy& policy) -> void {
+        static_cast<void>(policy);
+        auto response = messages::GetAutotuneResultResponse{
+            .responding_to_id = msg.id,
+            .selection = PidSelection::HEATER,
+            .status = _autotune.status(),
+            .cycles = _autotune.cycles(),
+            .result = _autotune.result()};
+        static_cast<void>(
+            _task_registry->comms->get_message_queue().try_send(response));
+    }
+
     auto handle_temperature_conversion(uint16_t conversion_result,
                                        Thermistor& thermistor) -> void {
         auto visitor = [this, &thermistor](const auto value) -> void {
@@ -459,6 +578,101 @@ class LidHeaterTask {
         return errors::ErrorCode::NO_ERROR;
     }
 
+    /**
+     * @brief Pick the sampling period for the current control state. The
+     * lid is sampled faster while it is heating towards its setpoint. The
+     * PID is driven with the measured time between readings, so it is
+     * unaffected by the period changing.
+     */
+    auto update_control_period() -> void {
+        auto period = HOLD_CONTROL_PERIOD_TICKS;
+        if (_state.system_status == State::CONTROLLING &&
+            std::abs(_setpoint_c - _thermistor.temp_c) > RAMP_BAND_C) {
+            period = RAMP_CONTROL_PERIOD_TICKS;
+        }
+        if (_state.system_status == State::AUTOTUNING) {
+            period = RAMP_CONTROL_PERIOD_TICKS;
+        }
+        _control_period_ticks.store(period, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Let the plate know whether it can start moving, if it is
+     * waiting for the lid to preheat.
+     * @param at_temperature Whether the lid is on its way to its target
+     */
+    auto send_preheat_done(bool at_temperature) -> void {
+        _preheat.stop();
+        static_cast<void>(
+            _task_registry->thermal_plate->get_message_queue().try_send(
+                messages::LidPreheatDoneMessage{.at_temperature =
+                                                    at_temperature}));
+    }
+
+    /**
+     * @brief Release a plate that asked for a preheat the lid can't start,
+     * so it doesn't wait forever.
+     */
+    auto refuse_preheat(const messages::SetLidTemperatureMessage& msg)
+        -> void {
+        if (msg.from_plate && msg.preheat_lead_time >= 0.0F) {
+            send_preheat_done(false);
+        }
+    }
+
+    /**
+     * @brief Release a plate waiting on the lid if the lid stopped
+     * heating for any reason, so the plate doesn't wait forever.
+     */
+    auto cancel_preheat_if_idle() -> void {
+        if (_preheat.waiting() &&
+            _state.system_status != State::CONTROLLING) {
+            send_preheat_done(false);
+        }
+    }
+
+    /**
+     * @brief Stop heating for a plate protocol once the lid is no longer
+     * controlling. If it stopped because of an error, the plate is told
+     * so it can abort the protocol.
+     */
+    auto release_protocol_if_idle() -> void {
+        if (!_heating_for_protocol ||
+            _state.system_status == State::CONTROLLING) {
+            return;
+        }
+        _heating_for_protocol = false;
+        if (_state.system_status == State::ERROR) {
+            static_cast<void>(
+                _task_registry->thermal_plate->get_message_queue().try_send(
+                    messages::LidProtocolErrorMessage{}));
+        }
+    }
+
+    /**
+     * @brief Update the relay autotune when the system is in the
+     * AUTOTUNING state. Once the autotune finishes the heater is turned
+     * off, and a successful result is applied to the heater PID.
+     */
+    template <LidHeaterExecutionPolicy Policy>
+    auto update_autotune(Policy& policy, double time_delta) -> void {
+        auto power = _autotune.update(_thermistor.temp_c, time_delta);
+        if (!_autotune.running()) {
+            _state.system_status = State::IDLE;
+            if (_autotune.status() == relay_autotune::Status::DONE) {
+                const auto& result = _autotune.result();
+                _pid = PID(result.kp, result.ki, result.kd,
+                           CONTROL_PERIOD_SECONDS, 1.0, -1.0);
+            }
+        }
+        if (!policy.set_heater_power(power)) {
+            policy.set_heater_power(0.0F);
+            _autotune.abort();
+            _state.system_status = State::ERROR;
+            _state.error_bitmap |= State::HEATER_POWER_ERROR;
+        }
+    }
+
     [[nodiscard]] auto update_control(double time_delta) -> double {
         auto proportional_band = 1.0;
         if (_pid.kp() != 0.0) {
@@ -483,6 +697,11 @@ class LidHeaterTask {
     PID _pid;
     double _setpoint_c;
     Milliseconds _last_update;
+    relay_autotune::RelayAutotune _autotune{};
+    lid_preheat::LidPreheat _preheat{};
+    // Whether the current target was set by a plate protocol
+    bool _heating_for_protocol = false;
+    std::atomic<uint32_t> _control_period_ticks{HOLD_CONTROL_PERIOD_TICKS};
 };
 
 }  // namespace lid_heater_task
@@ -0,0 +1,78 @@
+/**
+ * @file lid_preheat.hpp
+ * @brief Defines the LidPreheat class, which lets the lid heater tell a
+ * waiting plate when to start moving so that both reach their targets at
+ * about the same time.
+ * @details The lid heats far slower than the plate, so a protocol that
+ * waits for the lid before starting the plate spends most of that time
+ * with the plate sitting still. Instead, the plate tells the lid how long
+ * it needs to reach its first step (the lead time), and the lid releases
+ * the plate once its own estimated time to target drops to the lead time.
+ *
+ * The lid's time to target is estimated from its measured heating rate,
+ * which is filtered to ride out thermistor noise. A lid that is close to
+ * its target always releases the plate, since the heater backs off there
+ * and the rate stops being a good predictor.
+ */
+#pragma once
+
+namespace lid_preheat {
+
+class LidPreheat {
+  public:
+    /** Time constant of the heating rate filter, in seconds.*/
+    static constexpr double RATE_TIME_CONSTANT = 5.0F;
+    /** Heating rate below which the lid is not considered to be making
+     * progress, in ºC/s.*/
+    static constexpr double MIN_RATE = 0.01F;
+    /** Distance from the target at which the lid always releases the
+     * plate, in ºC.*/
+    static constexpr double ARRIVAL_BAND = 2.0F;
+
+    /**
+     * @brief Start waiting for the lid on behalf of the plate.
+     * @param lead_time How long the plate needs to reach its target, in
+     * seconds
+     */
+    auto start(double lead_time) -> void;
+
+    /**
+     * @brief Stop waiting, without releasing the plate.
+     */
+    auto stop() -> void { _waiting = false; }
+
+    /**
+     * @brief Feed a new lid temperature into the estimate. Call this for
+     * every reading while the lid is heating towards a target.
+     * @param temperature The lid temperature, in ºC
+     * @param target The lid target, in ºC
+     * @param time The time since the last reading, in seconds
+     * @return True exactly once, on the reading where the plate should be
+     * released. Waiting stops at that point.
+     */
+    auto update(double temperature, double target, double time) -> bool;
+
+    /**
+     * @brief Estimate how long the lid needs to reach its target.
+     * @param temperature The lid temperature, in ºC
+     * @param target The lid target, in ºC
+     * @return The time in seconds, or a negative number if the lid isn't
+     * heating fast enough to tell
+     */
+    [[nodiscard]] auto time_to_target(double temperature, double target) const
+        -> double;
+
+    [[nodiscard]] auto waiting() const -> bool { return _waiting; }
+    [[nodiscard]] auto lead_time() const -> double { return _lead_time; }
+    /** The filtered lid heating rate, in ºC/s.*/
+    [[nodiscard]] auto rate() const -> double { return _rate; }
+
+  private:
+    bool _waiting = false;
+    bool _have_temperature = false;
+    double _lead_time = 0.0F;
+    double _last_temperature = 0.0F;
+    double _rate = 0.0F;
+};
+
+}  // namespace lid_preheat
@@ -4,10 +4,14 @@
 #include <cstdint>
 #include <variant>
 
+#include "core/relay_autotune.hpp"
+#include "core/stall_calibration.hpp"
 #include "systemwide.h"
 #include "thermocycler-gen2/colors.hpp"
 #include "thermocycler-gen2/errors.hpp"
 #include "thermocycler-gen2/motor_utils.hpp"
+#include "thermocycler-gen2/pcr_protocol.hpp"
+#include "thermocycler-gen2/thermistor_stats.hpp"
 #include "thermocycler-gen2/tmc2130_registers.hpp"
 
 namespace messages {
@@ -193,6 +197,29 @@ struct SetSealParameterMessage {
     int32_t value;
 };
 
+struct CalibrateSealStallMessage {
+    uint32_t id;
+};
+
+struct CalibrateSealStallResponse {
+    uint32_t responding_to_id;
+    stall_calibration::Result calibration;
+    errors::ErrorCode with_error = errors::ErrorCode::NO_ERROR;
+};
+
+// Sent from the seal tick interrupt when a StallGuard reading is due
+struct SealStallSampleMessage {};
+
+// A seal StallGuard calibration to save to the EEPROM
+struct SaveSealCalibrationMessage {
+    stall_calibration::Result calibration;
+};
+
+// A seal StallGuard calibration loaded from the EEPROM
+struct SealCalibrationMessage {
+    stall_calibration::Result calibration;
+};
+
 struct GetPlateTempMessage {
     uint32_t id;
 };
@@ -246,11 +273,30 @@ struct SetHeaterDebugMessage {
 struct SetLidTemperatureMessage {
     uint32_t id;
     double setpoint;
+    // Sent by the plate task when a protocol starts, so no response is sent
+    bool from_plate = false;
+    // How long the plate needs to reach the first step of a protocol that
+    // waits for the lid to preheat, in seconds. Negative when the plate
+    // isn't waiting.
+    double preheat_lead_time = -1.0F;
+};
+
+// Sent by the lid to a plate waiting for it to preheat
+struct LidPreheatDoneMessage {
+    // False if the lid stopped heating before it got close to its target
+    bool at_temperature;
 };
 
+// Sent by the lid to the plate when it stops heating for a protocol
+// because of an error
+struct LidProtocolErrorMessage {};
+
 struct DeactivateLidHeatingMessage {
     uint32_t id;
     bool from_system = false;
+    // Sent by the plate task when its protocol ends. Only turns the lid off
+    // if it is still heating for that protocol, and no response is sent.
+    bool from_plate = false;
 };
 
 struct SetPlateTemperatureMessage {
@@ -297,6 +343,121 @@ struct GetOffsetConstantsResponse {
     double a, bl, cl, bc, cc, br, cr;
 };
 
+struct SetPlateModelMessage {
+    uint32_t id;
+    double gain;
+    double time_constant;
+    double dead_time;
+};
+
+struct GetPlateModelMessage {
+    uint32_t id;
+};
+
+struct GetPlateModelResponse {
+    uint32_t responding_to_id;
+    double gain, time_constant, dead_time;
+};
+
+struct StartAutotuneMessage {
+    uint32_t id;
+    double target;
+    bool write;
+};
+
+struct GetAutotuneResultMessage {
+    uint32_t id;
+};
+
+struct GetAutotuneResultResponse {
+    uint32_t responding_to_id;
+    PidSelection selection;
+    relay_autotune::Status status;
+    size_t cycles;
+    relay_autotune::Result result;
+};
+
+struct NewProtocolMessage {
+    uint32_t id;
+    double lid_temperature;
+    double volume;
+};
+
+struct AddProtocolStageMessage {
+    uint32_t id;
+    uint32_t cycles;
+};
+
+struct AddProtocolStepMessage {
+    uint32_t id;
+    pcr_protocol::Step step;
+};
+
+struct StartProtocolMessage {
+    uint32_t id;
+    bool preheat = false;
+};
+
+struct GetProtocolStatusMessage {
+    uint32_t id;
+};
+
+struct GetProtocolStatusResponse {
+    uint32_t responding_to_id;
+    pcr_protocol::Progress progress;
+    double hold_remaining;
+};
+
+struct SetSampleHoldMessage {
+    uint32_t id;
+    bool enable;
+};
+
+struct GetSampleEstimateMessage {
+    uint32_t id;
+};
+
+struct GetSampleEstimateResponse {
+    uint32_t responding_to_id;
+    double sample_temp;
+    bool sample_hold;
+};
+
+struct SetGainScheduleMessage {
+    uint32_t id;
+    uint8_t zone;
+    bool heating;
+    double p;
+    double i;
+    double d;
+};
+
+struct GetGainScheduleMessage {
+    uint32_t id;
+    uint8_t zone;
+    bool heating;
+};
+
+struct GetGainScheduleResponse {
+    uint32_t responding_to_id;
+    uint8_t zone;
+    bool heating;
+    double p;
+    double i;
+    double d;
+};
+
+struct GetThermistorStatsMessage {
+    uint32_t id;
+    // Clear the statistics once they have been reported
+    bool reset;
+};
+
+struct GetThermistorStatsResponse {
+    uint32_t responding_to_id;
+    thermistor_stats::ThermistorStats::Summary stats;
+};
+
 struct UpdateUIMessage {
     // Empty struct
 };
@@ -423,7 +584,10 @@ using HostCommsMessage = ::std::variant<
     GetPlateTempResponse, GetLidTempResponse, GetSealDriveStatusResponse,
     GetLidStatusResponse, GetPlatePowerResponse, GetLidPowerResponse,
     GetOffsetConstantsResponse, SealStepperDebugResponse, DeactivateAllResponse,
-    GetLidSwitchesResponse, GetFrontButtonResponse>;
+    GetLidSwitchesResponse, GetFrontButtonResponse, GetPlateModelResponse,
+    GetAutotuneResultResponse, GetProtocolStatusResponse,
+    GetSampleEstimateResponse, GetGainScheduleResponse,
+    GetThermistorStatsResponse, CalibrateSealStallResponse>;
 using ThermalPlateMessage =
     ::std::variant<std::monostate, ThermalPlateTempReadComplete,
                    GetPlateTemperatureDebugMessage, SetPeltierDebugMessage,
@@ -431,16 +595,27 @@ using ThermalPlateMessage =
                    SetPlateTemperatureMessage, DeactivatePlateMessage,
                    SetPIDConstantsMessage, SetFanAutomaticMessage,
                    GetThermalPowerMessage, SetOffsetConstantsMessage,
-                   GetOffsetConstantsMessage, DeactivateAllMessage>;
+                   GetOffsetConstantsMessage, DeactivateAllMessage,
+                   SetPlateModelMessage, GetPlateModelMessage,
+                   StartAutotuneMessage, GetAutotuneResultMessage,
+                   NewProtocolMessage, AddProtocolStageMessage,
+                   AddProtocolStepMessage, StartProtocolMessage,
+                   GetProtocolStatusMessage, SetSampleHoldMessage,
+                   GetSampleEstimateMessage, SetGainScheduleMessage,
+                   GetGainScheduleMessage, LidPreheatDoneMessage,
+                   LidProtocolErrorMessage, GetThermistorStatsMessage,
+                   SaveSealCalibrationMessage>;
 using LidHeaterMessage = ::std::variant<
     std::monostate, LidTempReadComplete, GetLidTemperatureDebugMessage,
     SetHeaterDebugMessage, GetLidTempMessage, SetLidTemperatureMessage,
     DeactivateLidHeatingMessage, SetPIDConstantsMessage, GetThermalPowerMessage,
-    DeactivateAllMessage, SetLidFansMessage>;
+    DeactivateAllMessage, SetLidFansMessage, StartAutotuneMessage,
+    GetAutotuneResultMessage>;
 using MotorMessage = ::std::variant<
     std::monostate, ActuateSolenoidMessage, LidStepperDebugMessage,
     LidStepperComplete, SealStepperDebugMessage, SealStepperComplete,
     GetSealDriveStatusMessage, SetSealParameterMessage, GetLidStatusMessage,
     OpenLidMessage, CloseLidMessage, PlateLiftMessage, FrontButtonPressMessage,
-    GetLidSwitchesMessage>;
+    GetLidSwitchesMessage, CalibrateSealStallMessage, SealStallSampleMessage,
+    SealCalibrationMessage>;
 };  // namespace messages
@@ -4,12 +4,15 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <concepts>
-#include <functional>
 #include <optional>
 #include <variant>
 
+#include "core/delegate.hpp"
+#include "core/stall_calibration.hpp"
+#include "core/trace.hpp"
 #include "hal/message_queue.hpp"
 #include "thermocycler-gen2/messages.hpp"
 #include "thermocycler-gen2/motor_utils.hpp"
@@ -43,8 +46,9 @@ namespace motor_task {
  * task of its event by sending a message.
  */
 template <typename Policy>
-concept MotorExecutionPolicy = requires(Policy& p,
-                                        std::function<void()> callback) {
+concept MotorExecutionPolicy = requires(
+    Policy& p, delegate::Delegate<void(Policy&)> callback,
+    const motor_util::LidProfile& profile) {
     // A function to set the stepper DAC as a register value
     // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
     {p.lid_stepper_set_dac(1)};
@@ -52,6 +56,9 @@ concept MotorExecutionPolicy = requires(Policy& p,
     // and a boolean argument for whether this is an overdrive movement.
     // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
     {p.lid_stepper_start(1, true)};
+    // A function to set the velocity profile of the next lid stepper
+    // movement that isn't an overdrive. Other movements run at the RPM.
+    {p.lid_stepper_set_profile(profile)};
     // A function to stop a stepper movement
     {p.lid_stepper_stop()};
     // A function to check for a fault in the stepper movement
@@ -70,7 +77,7 @@ concept MotorExecutionPolicy = requires(Policy& p,
     // A function to read the Lid Open Switch
     { p.lid_read_open_switch() } -> std::same_as<bool>;
     // A function to start a seal stepper movement, with a callback for each
-    // tick
+    // tick. The callback is called from the tick interrupt with the policy.
     { p.seal_stepper_start(callback) } -> std::same_as<bool>;
     // A function to stop a seal stepper movement
     {p.seal_stepper_stop()};
@@ -129,6 +136,16 @@ struct LidStepperState {
     constexpr static double PLATE_LIFT_VELOCITY_RPM = 40.0F;
     // Velocity for all lid movements other than plate lift
     constexpr static double LID_DEFAULT_VELOCITY_RPM = 125.0F;
+    // Movements from one switch to the other start slower than the default
+    // velocity and accelerate past it, then slow back down to the default
+    // velocity before they reach the far switch.
+    constexpr static double LID_PROFILE_START_RPM = 60.0F;
+    constexpr static double LID_PROFILE_PEAK_RPM = 200.0F;
+    // In RPM per second
+    constexpr static double LID_PROFILE_ACCELERATION = 400.0F;
+    // The switches are about 90º apart, so this leaves some margin to be
+    // back at the default velocity before the far switch
+    constexpr static double LID_PROFILE_FAST_DEGREES = 80.0F;
     // States for lid stepper
     enum Status {
         IDLE,            /**< Not moving.*/
@@ -165,6 +182,11 @@ struct SealStepperState {
     // the full extension, plus some spare distance to ensure a stall.
     constexpr static signed long FULL_RETRACT_MICROSTEPS =
         (FULL_EXTEND_MICROSTEPS * -1);
+    // When homing against a stall without the retraction switch pressed,
+    // the fewest steps a seal starting fully extended must take for the
+    // stall to count as the end of its travel
+    constexpr static signed long HOME_STALL_MIN_MICROSTEPS =
+        (FULL_RETRACT_MICROSTEPS / 20) * 19;
     // Distance to back off after triggering a limit switch
     constexpr static double SWITCH_BACKOFF_MM = 1.0F;
     // Distance to RETRACT to back off a limit switch
@@ -201,6 +223,46 @@ struct SealStepperState {
     bool direction;
 };
 
+// Structure to encapsulate a StallGuard calibration of the seal stepper
+struct SealCalibrationState {
+    // Velocities swept by a calibration, in steps/second
+    constexpr static std::array<double, 6> VELOCITIES = {
+        40000, 80000, 120000, 160000, 200000, 240000};
+    using Calibration = stall_calibration::Calibration<VELOCITIES.size()>;
+    // Limits for judging SG_RESULT, which reads from 0 to 1023, while the
+    // seal runs freely
+    constexpr static stall_calibration::Settings SETTINGS = {
+        .floor = 50,
+        .target_low = 100,
+        .target_high = 400,
+        .max_noise = 0.25,
+        .min_samples = 10,
+        .velocity_tolerance = 0.05,
+        .sgt_min = -64,
+        .sgt_max = 63,
+        .max_sweeps = 8};
+    // Distance of each sweep movement. Movements alternate direction from
+    // just off the retraction switch. Seal movements don't decelerate, and
+    // at the default acceleration the fastest velocity is reached after
+    // 576000 steps, which leaves it most of a second at speed.
+    constexpr static signed long SWEEP_MICROSTEPS = 800000;
+    // Rate of StallGuard readings during a sweep, in Hz
+    constexpr static uint32_t SAMPLE_FREQUENCY = 100;
+    enum class Status {
+        IDLE,     /**< Not calibrating.*/
+        HOMING,   /**< Retracting the seal to the limit switch.*/
+        BACKOFF,  /**< Extending the seal off of the limit switch.*/
+        SWEEPING, /**< Running the seal at each velocity in turn.*/
+    };
+    Status status;
+    // When the calibration is complete, respond to this ID
+    uint32_t response_id;
+    // The index of the velocity being swept
+    size_t point;
+    // Direction of the next sweep movement
+    bool extending;
+};
+
 // Structure to encapsulate state of the overall lid system
 struct LidState {
     // Lid action state machine. Individual hinge/seal motor actions are
@@ -278,7 +340,20 @@ class MotorTask {
           _seal_velocity(SealStepperState::DEFAULT_VELOCITY),
           _seal_acceleration(SealStepperState::DEFAULT_ACCEL),
           _nudge_degrees(0),
-          _seal_position(motor_util::SealStepper::Status::UNKNOWN) {}
+          _seal_position(motor_util::SealStepper::Status::UNKNOWN),
+          _seal_calibration{.status = SealCalibrationState::Status::IDLE,
+                            .response_id = INVALID_ID,
+                            .point = 0,
+                            .extending = true},
+          _stall_calibration(SealCalibrationState::VELOCITIES,
+                             SealCalibrationState::SETTINGS),
+          _seal_stall(),
+          _seal_sampling(false),
+          _sample_ticks(0),
+          _seal_fast_homing(false),
+          _seal_home_start(motor_util::SealStepper::Status::UNKNOWN),
+          _saved_sgt(SealStepperState::DEFAULT_STALLGUARD_THRESHOLD),
+          _saved_tcoolthrs(SealStepperState::DISABLED_SG_MIN_VELOCITY) {}
     MotorTask(const MotorTask& other) = delete;
     auto operator=(const MotorTask& other) -> MotorTask& = delete;
     MotorTask(MotorTask&& other) noexcept = delete;
@@ -304,6 +379,8 @@ class MotorTask {
         // anywhere up to the provided timeout, which drives the controller
         // frequency.
         static_cast<void>(_message_queue.recv(&message));
+        auto handling = trace::Scope(
+            trace::message_event(trace::TASK_MOTOR, message.index()));
         std::visit(
             [this, &policy](const auto& msg) -> void {
                 this->visit_message(msg, policy);
@@ -422,11 +499,22 @@ class MotorTask {
             static_cast<void>(policy.tmc2130_set_enable(false));
             using namespace messages;
             auto with_error = errors::ErrorCode::NO_ERROR;
+            bool homing = _seal_fast_homing;
+            if (!end_seal_home(policy)) {
+                with_error = errors::ErrorCode::SEAL_MOTOR_SPI_ERROR;
+            }
             switch (msg.reason) {
                 case SealStepperComplete::CompletionReason::STALL:
                     // Don't send an error because a stall is expected in some
                     // conditions. The number of steps will tell whether this
                     // stall was too early or not.
+                    if (homing && !seal_home_stall_valid(policy)) {
+                        // Something stopped the seal partway, so it can't
+                        // be trusted to be out of the way of the hinge
+                        with_error = errors::ErrorCode::SEAL_MOTOR_STALL;
+                        _seal_position =
+                            motor_util::SealStepper::Status::UNKNOWN;
+                    }
                     break;
                 case SealStepperComplete::CompletionReason::ERROR:
                     // TODO clear the error
@@ -437,7 +525,10 @@ class MotorTask {
                     break;
             }
             _seal_stepper_state.status = SealStepperState::Status::IDLE;
-            if (with_error == errors::ErrorCode::NO_ERROR) {
+            if (_seal_calibration.status !=
+                SealCalibrationState::Status::IDLE) {
+                handle_seal_calibration_end(msg.reason, with_error, policy);
+            } else if (with_error == errors::ErrorCode::NO_ERROR) {
                 with_error = handle_lid_state_end(policy);
             } else {
                 // Send error response on behalf of the lid state machine
@@ -482,13 +573,10 @@ class MotorTask {
                        Policy& policy) -> void {
         auto response =
             messages::GetSealDriveStatusResponse{.responding_to_id = msg.id};
-        auto status = _tmc2130.get_driver_status(policy);
+        auto status = _tmc2130.get_driver_status_and_tstep(policy);
         if (status.has_value()) {
-            response.status = status.value();
-        }
-        auto tstep = _tmc2130.get_tstep(policy);
-        if (tstep.has_value()) {
-            response.tstep = tstep.value();
+            response.status = status.value().first;
+            response.tstep = status.value().second;
         }
         static_cast<void>(_task_registry->comms->get_message_queue().try_send(
             messages::HostCommsMessage(response)));
@@ -662,6 +750,68 @@ class MotorTask {
             _task_registry->comms->get_message_queue().try_send(response));
     }
 
+    template <MotorExecutionPolicy Policy>
+    auto visit_message(const messages::CalibrateSealStallMessage& msg,
+                       Policy& policy) -> void {
+        auto error = errors::ErrorCode::NO_ERROR;
+        if (is_any_motor_moving()) {
+            error = errors::ErrorCode::SEAL_MOTOR_BUSY;
+        } else if (get_lid_position(policy) !=
+                   motor_util::LidStepper::Position::OPEN) {
+            // The seal has to run freely, so it can't be calibrated
+            // against the plate
+            error = errors::ErrorCode::LID_CLOSED;
+        }
+        if (error != errors::ErrorCode::NO_ERROR) {
+            auto response = messages::CalibrateSealStallResponse{
+                .responding_to_id = msg.id, .with_error = error};
+            static_cast<void>(
+                _task_registry->comms->get_message_queue().try_send(
+                    messages::HostCommsMessage(response)));
+            return;
+        }
+        _seal_calibration.response_id = msg.id;
+        error = start_seal_calibration(policy);
+        if (error != errors::ErrorCode::NO_ERROR) {
+            finish_seal_calibration(error, policy);
+        }
+    }
+
+    template <MotorExecutionPolicy Policy>
+    auto visit_message(const messages::SealStallSampleMessage& msg,
+                       Policy& policy) -> void {
+        static_cast<void>(msg);
+        // A sample may arrive just after its sweep movement finished
+        if (!_seal_sampling ||
+            _seal_stepper_state.status != SealStepperState::Status::MOVING) {
+            return;
+        }
+        auto status = _tmc2130.get_driver_status_and_tstep(policy);
+        if (!status.has_value()) {
+            return;
+        }
+        // Readings while accelerating are rejected by their velocity
+        static_cast<void>(_stall_calibration.record(
+            _seal_calibration.point,
+            motor_util::SealStepper::tstep_to_velocity(
+                status.value().second.value),
+            status.value().first.sg_result));
+    }
+
+    template <MotorExecutionPolicy Policy>
+    auto visit_message(const messages::SealCalibrationMessage& msg,
+                       Policy& policy) -> void {
+        static_cast<void>(policy);
+        const auto& settings = SealCalibrationState::SETTINGS;
+        if ((msg.calibration.sgt < settings.sgt_min) ||
+            (msg.calibration.sgt > settings.sgt_max) ||
+            (msg.calibration.min_velocity <= 0.0F) ||
+            (msg.calibration.home_velocity < msg.calibration.min_velocity)) {
+            return;
+        }
+        _seal_stall = msg.calibration;
+    }
+
     // Callback for each tick() during a seal stepper movement
     template <MotorExecutionPolicy Policy>
     auto seal_step_callback(Policy& policy) -> void {
@@ -669,6 +819,13 @@ class MotorTask {
         if (ret.step) {
             policy.tmc2130_step_pulse();
         }
+        if (_seal_sampling &&
+            (++_sample_ticks >= policy.MotorTickFrequency /
+                                    SealCalibrationState::SAMPLE_FREQUENCY)) {
+            _sample_ticks = 0;
+            static_cast<void>(get_message_queue().try_send_from_isr(
+                messages::SealStallSampleMessage{}));
+        }
         if (ret.done) {
             policy.seal_stepper_stop();
             // Send a 'done' message to ourselves
@@ -685,9 +842,12 @@ class MotorTask {
      * @param[in] steps Number of steps to move. This is \e signed, positive
      * values move forwards and negative values move backwards.
      * @param[in] policy Instance of the policy for motor control.
+     * @param[in] velocity Velocity to move at, if not the configured seal
+     * velocity.
      */
     template <MotorExecutionPolicy Policy>
-    auto start_seal_movement(long steps, bool arm_limit_switch, Policy& policy)
+    auto start_seal_movement(long steps, bool arm_limit_switch, Policy& policy,
+                             std::optional<double> velocity = std::nullopt)
         -> errors::ErrorCode {
         if (_seal_stepper_state.status != SealStepperState::Status::IDLE) {
             return errors::ErrorCode::SEAL_MOTOR_BUSY;
@@ -695,7 +855,8 @@ class MotorTask {
 
         // Movement profile gets constructed with default parameters
         _seal_profile = motor_util::MovementProfile(
-            policy.MotorTickFrequency, 0, _seal_velocity, _seal_acceleration,
+            policy.MotorTickFrequency, 0, velocity.value_or(_seal_velocity),
+            _seal_acceleration,
             motor_util::MovementType::FixedDistance, std::abs(steps));
 
         _seal_stepper_state.direction = steps > 0;
@@ -747,11 +908,13 @@ class MotorTask {
             return errors::ErrorCode::SEAL_MOTOR_FAULT;
         }
 
+        _sample_ticks = 0;
         _seal_stepper_state.status = SealStepperState::Status::MOVING;
         _seal_position = motor_util::SealStepper::Status::UNKNOWN;
 
         ret = policy.seal_stepper_start(
-            [&] { this->seal_step_callback(policy); });
+            delegate::Delegate<void(Policy&)>::template bind<
+                &MotorTask::template seal_step_callback<Policy>>(*this));
         if (!ret) {
             _seal_stepper_state.status = SealStepperState::Status::IDLE;
             return errors::ErrorCode::SEAL_MOTOR_FAULT;
@@ -784,6 +947,239 @@ class MotorTask {
         return errors::ErrorCode::NO_ERROR;
     }
 
+    /**
+     * @brief Start a StallGuard calibration of the seal. The seal is homed
+     * to the retraction switch, backed off of it, and then run back and
+     * forth once at each calibration velocity while SG_RESULT is sampled,
+     * with stall detection disabled. The sweep repeats until the
+     * calibration settles on a threshold.
+     * @param policy Instance of the policy for motor control
+     * @return errors::ErrorCode
+     */
+    template <MotorExecutionPolicy Policy>
+    auto start_seal_calibration(Policy& policy) -> errors::ErrorCode {
+        auto& registers = _tmc2130.get_register_map();
+        _saved_sgt = registers.coolconf.sgt;
+        _saved_tcoolthrs = registers.tcoolthrs.threshold;
+        _stall_calibration.start(_saved_sgt);
+        registers.coolconf.sgt = _stall_calibration.sgt();
+        registers.tcoolthrs.threshold =
+            SealStepperState::DISABLED_SG_MIN_VELOCITY;
+        if (!_tmc2130.write_config(policy)) {
+            return errors::ErrorCode::SEAL_MOTOR_SPI_ERROR;
+        }
+        _seal_calibration.point = 0;
+        _seal_calibration.extending = true;
+        if (policy.seal_read_retraction_switch()) {
+            _seal_calibration.status = SealCalibrationState::Status::BACKOFF;
+            return start_seal_movement(
+                SealStepperState::SWITCH_BACKOFF_MICROSTEPS_EXTEND, false,
+                policy);
+        }
+        _seal_calibration.status = SealCalibrationState::Status::HOMING;
+        return start_seal_movement(SealStepperState::FULL_RETRACT_MICROSTEPS,
+                                   true, policy);
+    }
+
+    /**
+     * @brief Start the sweep movement at the current calibration velocity.
+     * Movements alternate between extending and retracting so that the
+     * seal stays between its switches.
+     */
+    template <MotorExecutionPolicy Policy>
+    auto start_seal_sweep(Policy& policy) -> errors::ErrorCode {
+        _seal_calibration.status = SealCalibrationState::Status::SWEEPING;
+        auto steps = SealCalibrationState::SWEEP_MICROSTEPS;
+        if (_seal_calibration.extending) {
+            steps *= -1;
+        }
+        _seal_calibration.extending = !_seal_calibration.extending;
+        auto error = start_seal_movement(
+            steps, true, policy,
+            _stall_calibration.velocity(_seal_calibration.point));
+        _seal_sampling = (error == errors::ErrorCode::NO_ERROR);
+        return error;
+    }
+
+    /**
+     * @brief Move a seal calibration on after one of its movements ends.
+     * @param reason Why the movement ended
+     * @param error Any error from the end of the movement
+     * @param policy Instance of the policy for motor control
+     */
+    template <MotorExecutionPolicy Policy>
+    auto handle_seal_calibration_end(
+        messages::SealStepperComplete::CompletionReason reason,
+        errors::ErrorCode error, Policy& policy) -> void {
+        using Reason = messages::SealStepperComplete::CompletionReason;
+        _seal_sampling = false;
+        if (error != errors::ErrorCode::NO_ERROR) {
+            finish_seal_calibration(error, policy);
+            return;
+        }
+        switch (_seal_calibration.status) {
+            case SealCalibrationState::Status::HOMING:
+                if (reason != Reason::LIMIT) {
+                    error = errors::ErrorCode::SEAL_MOTOR_SWITCH;
+                    break;
+                }
+                _seal_calibration.status =
+                    SealCalibrationState::Status::BACKOFF;
+                error = start_seal_movement(
+                    SealStepperState::SWITCH_BACKOFF_MICROSTEPS_EXTEND, false,
+                    policy);
+                break;
+            case SealCalibrationState::Status::BACKOFF:
+                error = start_seal_sweep(policy);
+                break;
+            case SealCalibrationState::Status::SWEEPING:
+                if (reason != Reason::DONE) {
+                    // The sweeps stay clear of both switches
+                    error = errors::ErrorCode::SEAL_MOTOR_SWITCH;
+                    break;
+                }
+                error = next_seal_sweep(policy);
+                break;
+            case SealCalibrationState::Status::IDLE:
+                break;
+        }
+        if (error != errors::ErrorCode::NO_ERROR) {
+            finish_seal_calibration(error, policy);
+        }
+    }
+
+    template <MotorExecutionPolicy Policy>
+    auto next_seal_sweep(Policy& policy) -> errors::ErrorCode {
+        ++_seal_calibration.point;
+        if (_seal_calibration.point < SealCalibrationState::VELOCITIES.size()) {
+            return start_seal_sweep(policy);
+        }
+        _seal_calibration.point = 0;
+        switch (_stall_calibration.finish_sweep()) {
+            case stall_calibration::Verdict::SWEEP_AGAIN:
+                _tmc2130.get_register_map().coolconf.sgt =
+                    _stall_calibration.sgt();
+                if (!_tmc2130.write_config(policy)) {
+                    return errors::ErrorCode::SEAL_MOTOR_SPI_ERROR;
+                }
+                return start_seal_sweep(policy);
+            case stall_calibration::Verdict::DONE:
+                finish_seal_calibration(errors::ErrorCode::NO_ERROR, policy);
+                return errors::ErrorCode::NO_ERROR;
+            case stall_calibration::Verdict::FAILED:
+            default:
+                return errors::ErrorCode::SEAL_MOTOR_CALIBRATION;
+        }
+    }
+
+    /**
+     * @brief End a seal calibration, restore the StallGuard registers and
+     * respond. A successful calibration is kept for homing and saved to the
+     * EEPROM.
+     */
+    template <MotorExecutionPolicy Policy>
+    auto finish_seal_calibration(errors::ErrorCode error, Policy& policy)
+        -> void {
+        _seal_sampling = false;
+        _seal_calibration.status = SealCalibrationState::Status::IDLE;
+        auto response = messages::CalibrateSealStallResponse{
+            .responding_to_id = _seal_calibration.response_id,
+            .with_error = error};
+        _seal_calibration.response_id = INVALID_ID;
+        auto& registers = _tmc2130.get_register_map();
+        registers.coolconf.sgt = _saved_sgt;
+        registers.tcoolthrs.threshold = _saved_tcoolthrs;
+        if (!_tmc2130.write_config(policy) &&
+            (error == errors::ErrorCode::NO_ERROR)) {
+            response.with_error = errors::ErrorCode::SEAL_MOTOR_SPI_ERROR;
+        }
+        if (response.with_error == errors::ErrorCode::NO_ERROR) {
+            // Every other sweep retracts, so the last one ends where the
+            // first one started, just off the retraction switch
+            _seal_position = motor_util::SealStepper::Status::RETRACTED;
+            _seal_stall = _stall_calibration.result();
+            response.calibration = _seal_stall.value();
+            static_cast<void>(
+                _task_registry->thermal_plate->get_message_queue().try_send(
+                    messages::SaveSealCalibrationMessage{
+                        .calibration = _seal_stall.value()}));
+        } else {
+            _seal_position = motor_util::SealStepper::Status::UNKNOWN;
+        }
+        static_cast<void>(_task_registry->comms->get_message_queue().try_send(
+            messages::HostCommsMessage(response)));
+    }
+
+    /**
+     * @brief Start retracting the seal to home it. Once StallGuard is
+     * calibrated, the seal retracts at the calibrated homing velocity with
+     * stall detection enabled above the calibrated minimum velocity, so it
+     * stops on a stall as well as on the retraction switch. Otherwise it
+     * retracts to the switch at the configured seal velocity.
+     * @param policy Instance of the policy for motor control
+     * @return errors::ErrorCode
+     */
+    template <MotorExecutionPolicy Policy>
+    auto start_seal_home(Policy& policy) -> errors::ErrorCode {
+        if (!_seal_stall.has_value()) {
+            return start_seal_movement(
+                SealStepperState::FULL_RETRACT_MICROSTEPS, true, policy);
+        }
+        _seal_home_start = _seal_position;
+        auto& registers = _tmc2130.get_register_map();
+        _saved_sgt = registers.coolconf.sgt;
+        _saved_tcoolthrs = registers.tcoolthrs.threshold;
+        registers.coolconf.sgt = _seal_stall.value().sgt;
+        registers.tcoolthrs.threshold =
+            motor_util::SealStepper::velocity_to_tstep(
+                _seal_stall.value().min_velocity);
+        _seal_fast_homing = true;
+        if (!_tmc2130.write_config(policy)) {
+            static_cast<void>(end_seal_home(policy));
+            return errors::ErrorCode::SEAL_MOTOR_SPI_ERROR;
+        }
+        auto error =
+            start_seal_movement(SealStepperState::FULL_RETRACT_MICROSTEPS, true,
+                                policy, _seal_stall.value().home_velocity);
+        if (error != errors::ErrorCode::NO_ERROR) {
+            static_cast<void>(end_seal_home(policy));
+        }
+        return error;
+    }
+
+    /**
+     * @brief Restore the StallGuard registers after homing against a stall.
+     * Does nothing for any other movement.
+     * @return False if the registers couldn't be written
+     */
+    template <MotorExecutionPolicy Policy>
+    auto end_seal_home(Policy& policy) -> bool {
+        if (!_seal_fast_homing) {
+            return true;
+        }
+        _seal_fast_homing = false;
+        auto& registers = _tmc2130.get_register_map();
+        registers.coolconf.sgt = _saved_sgt;
+        registers.tcoolthrs.threshold = _saved_tcoolthrs;
+        return _tmc2130.write_config(policy);
+    }
+
+    /**
+     * @brief Whether a stall while homing the seal is the seal reaching the
+     * end of its travel. Either the retraction switch is pressed, or the
+     * seal started fully extended and has moved about its full travel.
+     */
+    template <MotorExecutionPolicy Policy>
+    [[nodiscard]] auto seal_home_stall_valid(Policy& policy) const -> bool {
+        if (policy.seal_read_retraction_switch()) {
+            return true;
+        }
+        return (_seal_home_start == motor_util::SealStepper::Status::ENGAGED) &&
+               (_seal_profile.current_distance() >=
+                static_cast<motor_util::MovementProfile::ticks>(
+                    SealStepperState::HOME_STALL_MIN_MICROSTEPS));
+    }
+
     template <MotorExecutionPolicy Policy>
     [[nodiscard]] auto get_lid_position(Policy& policy) const
         -> motor_util::LidStepper::Position {
@@ -821,6 +1217,9 @@ class MotorTask {
         if (_state.status != LidState::Status::IDLE) {
             return true;
         }
+        if (_seal_calibration.status != SealCalibrationState::Status::IDLE) {
+            return true;
+        }
         return false;
     }
 
@@ -968,6 +1367,10 @@ class MotorTask {
         // Update velocity for this movement
         std::ignore = policy.lid_stepper_set_rpm(
             LidStepperState::LID_DEFAULT_VELOCITY_RPM);
+        policy.lid_stepper_set_profile(lid_switch_profile(
+            _lid_stepper_state.position ==
+                motor_util::LidStepper::Position::CLOSED ||
+            policy.lid_read_closed_switch()));
         // Now start a lid motor movement to the endstop
         policy.lid_stepper_set_dac(LID_STEPPER_RUN_CURRENT);
         policy.lid_stepper_start(LidStepperState::FULL_OPEN_DEGREES, false);
@@ -988,6 +1391,10 @@ class MotorTask {
         // Update velocity for this movement
         std::ignore = policy.lid_stepper_set_rpm(
             LidStepperState::LID_DEFAULT_VELOCITY_RPM);
+        policy.lid_stepper_set_profile(lid_switch_profile(
+            _lid_stepper_state.position ==
+                motor_util::LidStepper::Position::OPEN ||
+            policy.lid_read_open_switch()));
         // Now start a lid motor movement to closed position
         policy.lid_stepper_set_dac(LID_STEPPER_RUN_CURRENT);
         policy.lid_stepper_start(LidStepperState::FULL_CLOSE_DEGREES, false);
@@ -998,6 +1405,27 @@ class MotorTask {
         return true;
     }
 
+    /**
+     * @brief Get the velocity profile for a movement to a switch.
+     *
+     * @param from_switch Whether the lid is starting from the other switch.
+     * Otherwise, the distance to the switch isn't known, so the movement
+     * can't safely run faster than the default velocity.
+     */
+    [[nodiscard]] static auto lid_switch_profile(bool from_switch)
+        -> motor_util::LidProfile {
+        if (!from_switch) {
+            return motor_util::LidProfile();
+        }
+        return motor_util::LidProfile(
+            LidStepperState::LID_PROFILE_START_RPM,
+            LidStepperState::LID_PROFILE_PEAK_RPM,
+            LidStepperState::LID_DEFAULT_VELOCITY_RPM,
+            LidStepperState::LID_PROFILE_ACCELERATION,
+            motor_util::LidStepper::angle_to_microsteps(
+                LidStepperState::LID_PROFILE_FAST_DEGREES));
+    }
+
     template <MotorExecutionPolicy Policy>
     auto start_lid_hinge_plate_lift(uint32_t response_id, Policy& policy)
         -> bool {
@@ -1057,9 +1485,9 @@ class MotorTask {
                     messages::UpdateMotorState::MotorState::IDLE;
                 break;
             case LidState::Status::OPENING_RETRACT_SEAL:
-                // The seal stepper is retracted to the limit switch
-                error = start_seal_movement(
-                    SealStepperState::FULL_RETRACT_MICROSTEPS, true, policy);
+                // The seal stepper is retracted to the limit switch, or to a
+                // stall if StallGuard has been calibrated
+                error = start_seal_home(policy);
                 state_for_system_task =
                     messages::UpdateMotorState::MotorState::OPENING_OR_CLOSING;
                 break;
@@ -1079,9 +1507,9 @@ class MotorTask {
                     messages::UpdateMotorState::MotorState::OPENING_OR_CLOSING;
                 break;
             case LidState::Status::CLOSING_RETRACT_SEAL:
-                // The seal stepper is retracted to a stall
-                error = start_seal_movement(
-                    SealStepperState::FULL_RETRACT_MICROSTEPS, true, policy);
+                // The seal stepper is retracted to the limit switch, or to a
+                // stall if StallGuard has been calibrated
+                error = start_seal_home(policy);
                 state_for_system_task =
                     messages::UpdateMotorState::MotorState::OPENING_OR_CLOSING;
                 break;
@@ -1376,5 +1804,20 @@ class MotorTask {
      * need a similar variable for that motor.
      */
     motor_util::SealStepper::Status _seal_position;
+    SealCalibrationState _seal_calibration;
+    SealCalibrationState::Calibration _stall_calibration;
+    // The StallGuard calibration used for homing, once there is one
+    std::optional<stall_calibration::Result> _seal_stall;
+    // Set while SG_RESULT should be sampled. Read from the tick interrupt.
+    std::atomic<bool> _seal_sampling;
+    // Ticks since the last sample, only used from the tick interrupt
+    uint32_t _sample_ticks;
+    // Set while the seal homes against a stall
+    bool _seal_fast_homing;
+    // Where the seal was when the current homing movement started
+    motor_util::SealStepper::Status _seal_home_start;
+    // StallGuard registers to restore after a calibration or homing
+    int _saved_sgt;
+    uint32_t _saved_tcoolthrs;
 };
 };  // namespace motor_task
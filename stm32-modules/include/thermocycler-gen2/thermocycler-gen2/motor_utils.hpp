@@ -8,6 +8,7 @@
 #pragma once
 
 #include <algorithm>
+#include <cmath>
 #include <concepts>
 
 #include "core/fixed_point.hpp"
@@ -39,6 +40,10 @@ class LidStepper {
         1.0F / DEGREES_TO_MICROSTEPS;
 
   public:
+    // Microsteps per second at 1 RPM. The lid timer runs at 1280/3 Hz per
+    // RPM and toggles the step line on every tick, so a step takes two.
+    constexpr static double MICROSTEPS_PER_SECOND_PER_RPM = 640.0 / 3.0;
+
     /** Possible states of the lid stepper.*/
     enum class Position { BETWEEN, CLOSED, OPEN, UNKNOWN };
 
@@ -275,4 +280,67 @@ class MovementProfile {
     static constexpr q31_31 _tick_flag = (1 << radix);
 };
 
+/**
+ * @brief A trapezoidal velocity profile for the lid hinge, worked out one
+ * step at a time.
+ *
+ * @details The lid stepper can't start at its top speed without stalling,
+ * but once it is moving it can run faster than it can start. A profile
+ * starts at \c start_rpm, accelerates towards \c peak_rpm, and decelerates
+ * again so that it is back down to \c approach_rpm after \c fast_steps
+ * steps. Past that point it holds \c approach_rpm, which must be slow
+ * enough for the lid to stop dead when it reaches a switch. Moves towards
+ * a switch set \c fast_steps a little short of where the switch is
+ * expected, so the lid always meets the switch at the approach speed.
+ *
+ * Speeds follow v^2 = v0^2 + 2as in the step domain, so each step costs
+ * two square roots and no state beyond the step count. Everything is in
+ * single precision, since the hardware asks for the speed of each step
+ * from its timer interrupt. Like MovementProfile, this class doesn't move
+ * the motor itself.
+ */
+class LidProfile {
+  public:
+    /** A profile that is disabled, leaving the speed as it was.*/
+    LidProfile() = default;
+    /**
+     * @brief Construct a new Lid Profile
+     *
+     * @param start_rpm Speed of the first step
+     * @param peak_rpm Top speed
+     * @param approach_rpm Speed after \c fast_steps steps
+     * @param acceleration Acceleration and deceleration in RPM per second
+     * @param fast_steps Number of steps before the approach speed must be
+     * reached. If zero, or if any speed is invalid, the profile is disabled.
+     */
+    LidProfile(double start_rpm, double peak_rpm, double approach_rpm,
+               double acceleration, uint32_t fast_steps);
+
+    /** Go back to the first step.*/
+    auto reset() -> void { _step = 0; }
+    /** Whether this profile sets any speeds.*/
+    [[nodiscard]] auto enabled() const -> bool { return _fast_steps > 0; }
+    /**
+     * @brief Get the speed of the next step, and move on to the step
+     * after it.
+     * @return The speed in RPM, or 0 if the profile is disabled
+     */
+    auto next_rpm() -> float;
+    /** The speed of any step of the profile, in RPM.*/
+    [[nodiscard]] auto rpm_at(uint32_t step) const -> float;
+    /** The number of steps handed out since the last reset.*/
+    [[nodiscard]] auto steps() const -> uint32_t { return _step; }
+    [[nodiscard]] auto fast_steps() const -> uint32_t { return _fast_steps; }
+    [[nodiscard]] auto approach_rpm() const -> float { return _approach_rpm; }
+
+  private:
+    float _start_rpm = 0.0F;
+    float _peak_rpm = 0.0F;
+    float _approach_rpm = 0.0F;
+    // Twice the acceleration, in RPM^2 per step
+    float _two_accel = 0.0F;
+    uint32_t _fast_steps = 0;
+    uint32_t _step = 0;
+};
+
 }  // namespace motor_util
@@ -0,0 +1,178 @@
+/**
+ * @file pcr_protocol.hpp
+ * @brief Defines the ProtocolEngine class, which stores a PCR profile and
+ * steps through it on the thermal plate without any host involvement.
+ * @details A profile is a list of stages that run in order. Each stage is
+ * a list of steps that is repeated for the stage's number of cycles, and
+ * each step is a target temperature, a hold time and an optional ramp rate.
+ * The profile also carries a lid temperature and a sample volume that apply
+ * to the whole run.
+ *
+ * The engine only tracks where in the profile the run is. The thermal plate
+ * task feeds each step into its PlateControl, and calls advance() once the
+ * hold time of the current step has elapsed. When the last step of the last
+ * cycle of the last stage finishes, the run is complete and the plate keeps
+ * holding the final temperature until it is given a new target.
+ *
+ * A run can also start by preheating. The engine then waits in the
+ * PREHEATING status, while the lid heats up, until it is started.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace pcr_protocol {
+
+enum class Status : uint8_t {
+    IDLE,       /**< No run has been started.*/
+    PREHEATING, /**< Waiting for the lid before the first step.*/
+    RUNNING,    /**< The profile is being executed.*/
+    COMPLETE,   /**< Every step of the profile has been run.*/
+    ABORTED,    /**< The run was stopped before it completed.*/
+};
+
+/** Get a printable name for a protocol status.*/
+[[nodiscard]] constexpr auto status_name(Status status) -> const char* {
+    switch (status) {
+        case Status::IDLE:
+            return "IDLE";
+        case Status::PREHEATING:
+            return "PREHEATING";
+        case Status::RUNNING:
+            return "RUNNING";
+        case Status::COMPLETE:
+            return "COMPLETE";
+        case Status::ABORTED:
+            return "ABORTED";
+    }
+    return "UNKNOWN";
+}
+
+struct Step {
+    /** The plate target, in ºC.*/
+    double temperature = 0.0F;
+    /** How long to hold the target once it is reached, in seconds.*/
+    double hold_time = 0.0F;
+    /** Ramp rate towards the target in ºC/s, or 0 to move at full power.*/
+    double ramp_rate = 0.0F;
+};
+
+struct Stage {
+    /** Index of the first step of this stage in the step list.*/
+    size_t first_step = 0;
+    size_t step_count = 0;
+    uint32_t cycles = 0;
+};
+
+/** Where in the profile a run currently is. All indices start at 0.*/
+struct Progress {
+    Status status = Status::IDLE;
+    size_t stage = 0;
+    size_t step = 0;
+    uint32_t cycle = 0;
+    /** Total number of cycles in the current stage.*/
+    uint32_t cycles = 0;
+};
+
+class ProtocolEngine {
+  public:
+    static constexpr size_t MAX_STAGES = 8;
+    static constexpr size_t MAX_STEPS = 32;
+    static constexpr uint32_t MAX_CYCLES = 999;
+    static constexpr double MIN_TEMPERATURE_C = 4.0F;
+    static constexpr double MAX_TEMPERATURE_C = 99.0F;
+    static constexpr double MAX_LID_TEMPERATURE_C = 110.0F;
+
+    /**
+     * @brief Discard the stored profile and start a new, empty one.
+     * @param lid_temperature The lid target for the run in ºC, or 0 to
+     * leave the lid alone
+     * @param volume_ul The sample volume, in microliters
+     * @return True if the profile was cleared, false if a run is in
+     * progress or the lid temperature is invalid
+     */
+    auto clear(double lid_temperature, double volume_ul) -> bool;
+
+    /**
+     * @brief Append an empty stage to the profile. Steps added after this
+     * belong to the new stage.
+     * @param cycles How many times the steps of the stage are repeated
+     * @return True if the stage was added, false if a run is in progress,
+     * the profile is full or the cycle count is invalid
+     */
+    auto add_stage(uint32_t cycles) -> bool;
+
+    /**
+     * @brief Append a step to the last stage of the profile.
+     * @return True if the step was added, false if a run is in progress,
+     * there is no stage yet, the profile is full or the step is invalid
+     */
+    auto add_step(const Step& step) -> bool;
+
+    /**
+     * @brief Start running the stored profile from the beginning. This
+     * also ends a preheat.
+     * @return The first step to run, or nothing if the profile is empty,
+     * has a stage without any steps, or is already running
+     */
+    auto start() -> std::optional<Step>;
+
+    /**
+     * @brief Get ready to run the stored profile, and wait for start() to
+     * be called once the lid is hot.
+     * @return The first step that will run, or nothing if the profile
+     * could not be started
+     */
+    auto preheat() -> std::optional<Step>;
+
+    /**
+     * @brief Move on from the current step once its hold has elapsed.
+     * @return The next step to run, or nothing if the run just completed
+     * or was not running
+     */
+    auto advance() -> std::optional<Step>;
+
+    /**
+     * @brief Stop the current run or preheat. Does nothing if neither is
+     * in progress.
+     */
+    auto abort() -> void;
+
+    [[nodiscard]] auto status() const -> Status { return _progress.status; }
+    [[nodiscard]] auto running() const -> bool {
+        return _progress.status == Status::RUNNING;
+    }
+    [[nodiscard]] auto preheating() const -> bool {
+        return _progress.status == Status::PREHEATING;
+    }
+    /** Whether a run is either preheating or running.*/
+    [[nodiscard]] auto active() const -> bool {
+        return running() || preheating();
+    }
+    [[nodiscard]] auto progress() const -> const Progress& {
+        return _progress;
+    }
+    [[nodiscard]] auto lid_temperature() const -> double {
+        return _lid_temperature;
+    }
+    [[nodiscard]] auto volume() const -> double { return _volume_ul; }
+    [[nodiscard]] auto stage_count() const -> size_t { return _stage_count; }
+    [[nodiscard]] auto step_count() const -> size_t { return _step_count; }
+
+  private:
+    [[nodiscard]] auto current_step() const -> Step;
+    [[nodiscard]] auto startable() const -> bool;
+
+    std::array<Stage, MAX_STAGES> _stages{};
+    std::array<Step, MAX_STEPS> _steps{};
+    size_t _stage_count = 0;
+    size_t _step_count = 0;
+    double _lid_temperature = 0.0F;
+    double _volume_ul = 0.0F;
+    Progress _progress{};
+};
+
+}  // namespace pcr_protocol
@@ -10,7 +10,11 @@
 #include <optional>
 
 #include "core/pid.hpp"
+#include "thermocycler-gen2/gain_schedule.hpp"
+#include "thermocycler-gen2/plate_model.hpp"
+#include "thermocycler-gen2/sample_estimator.hpp"
 #include "thermocycler-gen2/thermal_general.hpp"
+#include "thermocycler-gen2/thermistor_stats.hpp"
 
 namespace plate_control {
 
@@ -39,6 +43,9 @@ class PlateControl {
     static constexpr size_t THERM_PER_PELTIER = 2;
     /** Max ∆T to be considered "at" the setpoint.*/
     static constexpr double SETPOINT_THRESHOLD = 2.0F;
+    /** Max ∆T of the estimated sample to start the hold timer, when holds
+     * are timed from the sample temperature.*/
+    static constexpr double SAMPLE_SETPOINT_THRESHOLD = 0.5F;
 
     /** Degrees C *under* the threshold to set the fan.*/
     static constexpr double FAN_SETPOINT_OFFSET = (-2.0F);
@@ -71,6 +78,13 @@ class PlateControl {
                                                                      0.55};
     /** Min & max power settings when holding at a hot temp.*/
     static constexpr std::pair<double, double> FAN_POWER_LIMITS_HOT{0.30, 0.55};
+    /** Fan power added for each unit of average peltier cooling power.
+     * Heat pumped out of the plate reaches the heatsink thermistor well
+     * after it reaches the heatsink, so the fan starts working on it as
+     * soon as the peltiers do.*/
+    static constexpr double FAN_FEEDFORWARD_GAIN = 0.25F;
+    /** Max fan power while ramping down with feed-forward.*/
+    static constexpr double FAN_POWER_RAMP_DOWN_MAX = 0.8F;
     /** Slope for overshoot & undershoot, in C/µL */
     static constexpr double OVERSHOOT_DEGREES_PER_MICROLITER = (2.0F / 50.0F);
     /** Minimum volume to trigger overshoot/undershoot */
@@ -97,6 +111,10 @@ class PlateControl {
     static constexpr double WINDUP_RESET_THRESHOLD = 3.0F;
     /** Maximum time in seconds for overshoot to apply.*/
     static constexpr double MAX_HOLD_TIME_FOR_OVERSHOOT = 120.0F;
+    /** Rough average heating and cooling rates of a full power step, in
+     *  ºC/s, used to estimate ramp times without a plate model.*/
+    static constexpr double HEATING_RATE_ESTIMATE = 3.0F;
+    static constexpr double COOLING_RATE_ESTIMATE = 2.0F;
     /** When HEATING to a target below ambient temperature, adjust
      *  the initial overshoot/undershoot target by this amount to
      *  reduce the effects of over-overshooting.*/
@@ -154,6 +172,19 @@ class PlateControl {
                         double hold_time = HOLD_INFINITE,
                         double ramp_rate = RAMP_INFINITE) -> bool;
 
+    /**
+     * @brief Estimate how long the plate will take to reach a new target
+     * from its current temperature.
+     * @param[in] setpoint The new target, in ºC
+     * @param[in] ramp_rate The ramp rate the target will be set with, in
+     * ºC/s, or RAMP_INFINITE for a full power step
+     * @return The estimated time in seconds. Full power steps use the plate
+     * model if there is one, and the rough rate estimates otherwise.
+     */
+    [[nodiscard]] auto estimate_ramp_time(double setpoint,
+                                          double ramp_rate = RAMP_INFINITE)
+        const -> Seconds;
+
     /**
      * @brief This function will return the correct fan PWM to be set if
      * the fan is in idle mode, as a percentage from 0 to 1.0.
@@ -165,6 +196,87 @@ class PlateControl {
      */
     [[nodiscard]] auto fan_idle_power() const -> double;
 
+    /**
+     * @brief Get the fan power that the feed-forward term adds during
+     * active control, based on how hard the peltiers were driven to cool
+     * the plate in the last update.
+     * @return The feed-forward fan power, from 0 to FAN_FEEDFORWARD_GAIN
+     */
+    [[nodiscard]] auto fan_feedforward() const -> double;
+
+    /**
+     * @brief Configure the plate model used for feed-forward control. With
+     * a valid model, large steps drive the peltiers at full power for the
+     * time the model predicts it takes to reach the target and then wait
+     * out the dead time at holding power, rather than aiming for a
+     * volume-based overshoot target. At the end of the feed-forward, the
+     * PID integrator starts from the holding power predicted by the model.
+     * @param[in] model The plate model. An invalid model disables
+     * feed-forward control.
+     */
+    auto set_model(const plate_model::PlateModel &model) -> void {
+        _model = model;
+    }
+
+    /** Return the configured plate model.*/
+    [[nodiscard]] auto model() const -> plate_model::PlateModel {
+        return _model;
+    }
+
+    /**
+     * @brief Configure the PID gain schedule. Before every PID update, each
+     * peltier switches to the gains for the zone of its current target and
+     * the direction of the last move, without a bump in its output. Until
+     * a schedule is set, the peltier PIDs are left as they are.
+     * @param[in] schedule The gain schedule
+     */
+    auto set_gain_schedule(const gain_schedule::GainSchedule &schedule)
+        -> void {
+        _schedule = schedule;
+    }
+
+    /** Return the configured gain schedule, if there is one.*/
+    [[nodiscard]] auto schedule() const
+        -> const std::optional<gain_schedule::GainSchedule> & {
+        return _schedule;
+    }
+
+    /** Get the gain schedule zone that a temperature falls into.*/
+    [[nodiscard]] auto schedule_zone(double temp) const -> gain_schedule::Zone;
+
+    /**
+     * @brief Choose when the hold timer of a step starts. By default it
+     * starts once the plate thermistors have settled at the setpoint. When
+     * timing from the sample, it starts as soon as the estimated sample
+     * temperature reaches the setpoint, which is usually earlier since the
+     * overshoot used to speed up the sample is no longer waited out.
+     * @param[in] enable True to time holds from the estimated sample
+     */
+    auto set_sample_hold(bool enable) -> void { _sample_hold = enable; }
+
+    /** Return whether holds are timed from the estimated sample.*/
+    [[nodiscard]] auto sample_hold() const -> bool { return _sample_hold; }
+
+    /** Return the estimated temperature of the sample, in ºC.*/
+    [[nodiscard]] auto sample_temp() const -> double {
+        return _sample.sample_temp();
+    }
+
+    /**
+     * @brief Restart the sample estimate from the next thermistor reading.
+     * Call this when control starts after the plate has been idle, since
+     * the estimate is only updated while controlling.
+     */
+    auto reset_sample_estimate() -> void { _sample.reset(); }
+
+    /**
+     * @brief Check whether the hold of the current step has elapsed.
+     * @return True once a finite hold time has counted down to zero. When
+     * holds are timed from the plate thermistors, the plate must also be
+     * in steady state.
+     */
+    [[nodiscard]] auto hold_complete() const -> bool;
+
     /** Return the current temperature target.*/
     [[nodiscard]] auto setpoint() const -> double { return _setpoint; }
 
@@ -198,6 +310,17 @@ class PlateControl {
      */
     [[nodiscard]] auto thermistor_drift_check() const -> bool;
 
+    /**
+     * @brief Check for thermistor drift, using the latest reading that was
+     * added to a set of thermistor statistics rather than looking at every
+     * thermistor again.
+     * @param stats Statistics that are updated with every plate reading
+     * @return true if the thermistors are \b within spec, false if the
+     *         drift between any two thermistors is over 4ºC
+     */
+    [[nodiscard]] auto thermistor_drift_check(
+        const thermistor_stats::ThermistorStats &stats) const -> bool;
+
     /**
      * @brief Get the temperature of every peltier
      *
@@ -245,6 +368,15 @@ class PlateControl {
     }
 
   private:
+    /**
+     * @brief Decide whether a spread between the plate thermistors is
+     * acceptable in the current state.
+     * @param spread The difference between the hottest and coldest
+     * thermistor, in ºC
+     * @param hottest The hottest thermistor, in ºC
+     */
+    [[nodiscard]] auto drift_within_spec(double spread, double hottest) const
+        -> bool;
     /**
      * @brief Apply a ramp to the target temperature of an element.
      * @param[in] peltier The peltier to ramp target temperature of
@@ -266,6 +398,27 @@ class PlateControl {
      * @return The new power value for the fan
      */
     auto update_fan(Seconds time) -> double;
+    /**
+     * @brief Hand a peltier over from feed-forward to feedback control.
+     * The PID's error history is seeded with the current error, so the
+     * derivative term doesn't kick on the first update, and its integrator
+     * with the model's holding power, which the feed-forward was applying.
+     * @param[in] peltier The peltier to hand over
+     */
+    auto end_feedforward(thermal_general::Peltier &peltier) -> void;
+    /**
+     * @brief Feed the latest thermistor readings of a peltier into its
+     * zone filter, which provides the PID input.
+     * @param[in] peltier The peltier to update
+     * @param[in] time The time that has passed since the last update
+     */
+    auto update_zone(thermal_general::Peltier &peltier, Seconds time) -> void;
+    /**
+     * @brief Switch a peltier to the scheduled gains for its current
+     * target, if a gain schedule is configured.
+     * @param[in] peltier The peltier to update
+     */
+    auto apply_schedule(thermal_general::Peltier &peltier) -> void;
     /**
      * @brief Reset a peltier for a new setpoint. Sets the target
      * temperature to the current average plate temperature and
@@ -384,6 +537,25 @@ class PlateControl {
     Seconds _uniformity_error_timer = 0.0F;
     Seconds _hold_time = 0.0F;            // Total hold time
     Seconds _remaining_hold_time = 0.0F;  // Hold time left, out of _hold_time
+    // Model of the plate for feed-forward control. Disabled by default.
+    plate_model::PlateModel _model = plate_model::PlateModel();
+    // Remaining time in a feed-forward step: the full power drive followed
+    // by the model's dead time at holding power.
+    Seconds _feedforward_time = 0.0F;
+    // Observer for the temperature of the liquid in the wells
+    sample_estimator::SampleEstimator _sample =
+        sample_estimator::SampleEstimator();
+    double _volume_ul = 0.0F;
+    // Average peltier power from the last update, fed to the observer
+    double _last_power = 0.0F;
+    // Whether holds are timed from the estimated sample temperature
+    bool _sample_hold = false;
+    // Latched once the estimated sample reaches the setpoint
+    bool _sample_at_setpoint = false;
+    // Gains for each zone and direction. Disabled by default.
+    std::optional<gain_schedule::GainSchedule> _schedule = std::nullopt;
+    // Whether the last new target was above the plate temperature
+    bool _heating = true;
 };
 
 }  // namespace plate_control
@@ -0,0 +1,77 @@
+/**
+ * @file plate_model.hpp
+ * @brief Defines the PlateModel struct, a first-order-plus-dead-time model
+ * of the thermal plate that is used for feed-forward control.
+ * @details The plate temperature T responds to a peltier power u (in the
+ * range [-1, 1]) as
+ *
+ * > tau * dT/dt = K * u(t - theta) - (T - T_ambient)
+ *
+ * where K is the steady-state gain in ºC per unit of power, tau is the time
+ * constant in seconds and theta is the dead time in seconds between a change
+ * in power and the thermistors starting to respond. The parameters are
+ * identified per unit and stored in the EEPROM.
+ */
+#pragma once
+
+namespace plate_model {
+
+struct PlateModel {
+    /** Steady-state temperature rise over ambient at full power, in ºC.*/
+    double gain = 0.0F;
+    /** Time constant of the response, in seconds.*/
+    double time_constant = 0.0F;
+    /** Delay before the thermistors respond to a power change, in seconds.*/
+    double dead_time = 0.0F;
+
+    /**
+     * @brief Check whether this model can be used. An unprogrammed model
+     * has all parameters set to zero, which disables feed-forward.
+     */
+    [[nodiscard]] auto valid() const -> bool;
+
+    /**
+     * @brief Get the temperature the plate settles at for a constant power.
+     * @param power The power setting, from -1 to 1
+     * @param ambient The temperature the plate exchanges heat with, in ºC
+     */
+    [[nodiscard]] auto steady_state(double power, double ambient) const
+        -> double;
+
+    /**
+     * @brief Get the power that holds the plate at a temperature.
+     * @param target The temperature to hold, in ºC
+     * @param ambient The temperature the plate exchanges heat with, in ºC
+     * @return The holding power, clamped to [-1, 1]. 0 if the model
+     * is not valid.
+     */
+    [[nodiscard]] auto holding_power(double target, double ambient) const
+        -> double;
+
+    /**
+     * @brief Get how long to drive the peltiers at full power so that the
+     * plate lands on a new target. Switching to the holding power after
+     * this time lands the plate on the target, after the dead time.
+     * @param start The current plate temperature, in ºC
+     * @param target The target plate temperature, in ºC
+     * @param ambient The temperature the plate exchanges heat with, in ºC
+     * @return The full power duration in seconds, or a negative number if
+     * the model is not valid or the target cannot be reached at full power.
+     */
+    [[nodiscard]] auto full_power_duration(double start, double target,
+                                           double ambient) const -> double;
+
+    /**
+     * @brief Predict the plate temperature after driving a constant power,
+     * starting from a settled plate.
+     * @param start The plate temperature when the power is applied, in ºC
+     * @param power The power setting, from -1 to 1
+     * @param ambient The temperature the plate exchanges heat with, in ºC
+     * @param time The time since the power was applied, in seconds
+     * @return The predicted temperature in ºC
+     */
+    [[nodiscard]] auto predict(double start, double power, double ambient,
+                               double time) const -> double;
+};
+
+}  // namespace plate_model
@@ -0,0 +1,81 @@
+/**
+ * @file sample_estimator.hpp
+ * @brief Defines the SampleEstimator class, a small state observer that
+ * estimates the temperature of the liquid in the plate wells.
+ * @details The thermistors are embedded in the plate block, so during a
+ * step the liquid lags behind what they read. The observer keeps three
+ * states:
+ *
+ * - The block temperature, predicted from the peltier power with the plate
+ * model (when one is configured) and corrected towards the average of the
+ * plate thermistors. This filters thermistor noise without adding lag.
+ * - The well wall temperature, which follows the estimated block
+ * temperature with a first-order lag.
+ * - The sample temperature, which follows the wall with a first-order lag
+ * whose time constant scales with the sample volume.
+ */
+#pragma once
+
+#include "thermocycler-gen2/plate_model.hpp"
+
+namespace sample_estimator {
+
+class SampleEstimator {
+  public:
+    /** How strongly the block estimate is pulled towards the thermistor
+     * readings, in 1/s. Without a plate model, the block estimate lags a
+     * ramp by the ramp rate divided by this. The block estimate is meant
+     * to follow the thermistors closely: the lag of the sample behind
+     * them comes from the wall and liquid states, not from this gain.*/
+    static constexpr double OBSERVER_GAIN = 10.0F;
+    /** Lag through the plastic wall of the wells, in seconds.*/
+    static constexpr double WALL_TIME_CONSTANT = 1.5F;
+    /** Lag of the liquid itself, in seconds per microliter.*/
+    static constexpr double TIME_CONSTANT_PER_MICROLITER = 0.1F;
+
+    /**
+     * @brief Get the time constant of the liquid lag for a volume.
+     * @param volume_ul The sample volume, in microliters
+     * @return The time constant in seconds
+     */
+    [[nodiscard]] static auto liquid_time_constant(double volume_ul)
+        -> double;
+
+    /**
+     * @brief Forget the current estimate. The next update starts the
+     * estimate from the thermistor reading, which assumes the sample has
+     * settled to the block temperature.
+     */
+    auto reset() -> void { _initialized = false; }
+
+    /**
+     * @brief Feed a new set of readings into the observer.
+     * @param block_temp The average plate thermistor temperature, in ºC
+     * @param power The average peltier power over the last period, -1 to 1
+     * @param ambient The temperature the plate exchanges heat with, in ºC
+     * @param volume_ul The sample volume, in microliters
+     * @param model The plate model. If it is not valid, the block estimate
+     * only follows the thermistors.
+     * @param time The time since the last update, in seconds
+     * @return The new sample temperature estimate, in ºC
+     */
+    auto update(double block_temp, double power, double ambient,
+                double volume_ul, const plate_model::PlateModel& model,
+                double time) -> double;
+
+    [[nodiscard]] auto initialized() const -> bool { return _initialized; }
+    /** The estimated block temperature, in ºC.*/
+    [[nodiscard]] auto block_temp() const -> double { return _block_temp; }
+    /** The estimated well wall temperature, in ºC.*/
+    [[nodiscard]] auto wall_temp() const -> double { return _wall_temp; }
+    /** The estimated sample temperature, in ºC.*/
+    [[nodiscard]] auto sample_temp() const -> double { return _sample_temp; }
+
+  private:
+    bool _initialized = false;
+    double _block_temp = 0.0F;
+    double _wall_temp = 0.0F;
+    double _sample_temp = 0.0F;
+};
+
+}  // namespace sample_estimator
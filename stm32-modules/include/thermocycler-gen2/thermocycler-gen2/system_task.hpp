@@ -9,6 +9,7 @@
 #include "core/ack_cache.hpp"
 #include "core/version.hpp"
 #include "core/xt1511.hpp"
+#include "core/trace.hpp"
 #include "hal/message_queue.hpp"
 #include "systemwide.h"
 #include "thermocycler-gen2/colors.hpp"
@@ -256,6 +257,8 @@ class SystemTask {
     auto run_once(Policy& policy) -> void {
         auto message = Message(std::monostate());
         _message_queue.recv(&message);
+        auto handling = trace::Scope(
+            trace::message_event(trace::TASK_SYSTEM, message.index()));
 
         auto visit_helper = [this, &policy](auto& message) -> void {
             this->visit_message(message, policy);
@@ -11,6 +11,7 @@
 #include "systemwide.h"
 #include "thermocycler-gen2/errors.hpp"
 #include "thermocycler-gen2/peltier_filter.hpp"
+#include "thermocycler-gen2/zone_filter.hpp"
 
 namespace thermal_general {
 
@@ -63,11 +64,20 @@ struct Peltier {
     PID pid;  // Current PID loop
     // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
     peltier_filter::PeltierFilter filter = peltier_filter::PeltierFilter();
+    // NOLINTNEXTLINE(misc-non-private-member-variables-in-classes)
+    zone_filter::ZoneFilter zone = zone_filter::ZoneFilter();
 
     /** Get the current temperature of this peltier.*/
     [[nodiscard]] auto current_temp() const -> double {
         return (thermistors.first.temp_c + thermistors.second.temp_c) / 2;
     }
+    /**
+     * Get the filtered temperature of this peltier, for use as the control
+     * input. Falls back to the raw average until the filter has started.
+     */
+    [[nodiscard]] auto control_temp() const -> double {
+        return zone.initialized() ? zone.temp() : current_temp();
+    }
     /**
      * Get the difference in temperature between the front/back thermistors
      * for this peltier.
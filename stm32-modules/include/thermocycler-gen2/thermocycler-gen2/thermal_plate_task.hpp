@@ -4,6 +4,7 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <concepts>
 #include <cstddef>
@@ -12,11 +13,15 @@
 #include <variant>
 
 #include "core/pid.hpp"
+#include "core/relay_autotune.hpp"
 #include "core/thermistor_conversion.hpp"
+#include "core/trace.hpp"
 #include "hal/message_queue.hpp"
 #include "thermocycler-gen2/eeprom.hpp"
 #include "thermocycler-gen2/errors.hpp"
+#include "thermocycler-gen2/gain_schedule.hpp"
 #include "thermocycler-gen2/messages.hpp"
+#include "thermocycler-gen2/pcr_protocol.hpp"
 #include "thermocycler-gen2/plate_control.hpp"
 #include "thermocycler-gen2/tasks.hpp"
 #include "thermocycler-gen2/thermal_general.hpp"
@@ -70,7 +75,8 @@ struct State {
         IDLE,        /**< Not doing anything.*/
         ERROR,       /**< Experiencing an error*/
         CONTROLLING, /**< Controlling temperature (PID)*/
-        PWM_TEST     /**< Testing PWM output (debug command)*/
+        PWM_TEST,    /**< Testing PWM output (debug command)*/
+        AUTOTUNING   /**< Running a relay autotune of the peltier PID*/
     };
     Status system_status;
     uint16_t error_bitmap;
@@ -93,7 +99,13 @@ class ThermalPlateTask {
     using Queue = QueueImpl<Message>;
     using Milliseconds = std::chrono::milliseconds;
     using Seconds = std::chrono::duration<double, std::chrono::seconds::period>;
+    // Nominal control period, which the PID gains are specified against
     static constexpr const uint32_t CONTROL_PERIOD_TICKS = 50;
+    // Control period while ramping or settling out an overshoot. This is
+    // bounded by the time to convert all seven thermistors (~4ms each).
+    static constexpr const uint32_t RAMP_CONTROL_PERIOD_TICKS = 40;
+    // Control period while holding a temperature or idle
+    static constexpr const uint32_t HOLD_CONTROL_PERIOD_TICKS = 100;
     static constexpr double THERMISTOR_CIRCUIT_BIAS_RESISTANCE_KOHM = 10.0;
     static constexpr uint16_t ADC_BIT_MAX = 0x5DC0;
     static constexpr uint8_t PLATE_THERM_COUNT = 7;
@@ -113,6 +125,17 @@ class ThermalPlateTask {
     static constexpr double KD_MIN = -200;
     static constexpr double KD_MAX = 200;
     static constexpr double OVERTEMP_LIMIT_C = 115;
+    // Autotune targets are restricted to the normal operating range
+    static constexpr double AUTOTUNE_MIN_TARGET_C = 4.0F;
+    static constexpr double AUTOTUNE_MAX_TARGET_C = 99.0F;
+    // The relay swings the peltiers by half power either side of its bias,
+    // which starts at the modelled holding power for the target
+    static constexpr double AUTOTUNE_RELAY_POWER = 0.5F;
+    static constexpr double AUTOTUNE_HYSTERESIS_C = 0.2F;
+    static constexpr double AUTOTUNE_TIMEOUT_S = 1800.0F;
+    // Fixed fan power while autotuning, so the fan loop doesn't interact
+    // with the oscillation being measured
+    static constexpr double AUTOTUNE_FAN_POWER = 0.5F;
     // If no volume is specified, this is the default
     static constexpr double DEFAULT_VOLUME_UL = 25.0F;
     // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
@@ -230,6 +253,24 @@ class ThermalPlateTask {
         return _last_update;
     }
 
+    /**
+     * @brief Get the estimated sample temperature. This is not thread
+     * safe, and is intended for the simulator to check the estimate
+     * between runs of the task.
+     */
+    [[nodiscard]] auto get_sample_temp() const -> double {
+        return _plate_control.sample_temp();
+    }
+
+    /**
+     * @brief Get the period that the thermistors should currently be
+     * sampled at. This is read by the thermistor sampling task, so it is
+     * safe to call from a different thread than the one running the task.
+     */
+    [[nodiscard]] auto get_control_period_ticks() const -> uint32_t {
+        return _control_period_ticks.load(std::memory_order_relaxed);
+    }
+
     /**
      * run_once() runs one spin of the task. This means it
      * - Waits for a message, either a thermistor update or
@@ -250,6 +291,24 @@ class ThermalPlateTask {
         // If the EEPROM data hasn't been read, read it before doing
         // anything else.
         if (!_eeprom.initialized()) {
+            _plate_control.set_model(
+                _eeprom.get_plate_model(_plate_control.model(), policy));
+            auto pid = _eeprom.get_pid_constants(
+                eeprom::PIDConstants{
+                    .kp = DEFAULT_KP, .ki = DEFAULT_KI, .kd = DEFAULT_KD},
+                policy);
+            set_peltier_pids(pid.kp, pid.ki, pid.kd);
+            _plate_control.set_gain_schedule(_eeprom.get_gain_schedule(
+                gain_schedule::GainSchedule(gain_schedule::Gains{
+                    .kp = pid.kp, .ki = pid.ki, .kd = pid.kd}),
+                policy));
+            auto seal = _eeprom.get_seal_calibration(policy);
+            if (seal.has_value()) {
+                static_cast<void>(
+                    _task_registry->motor->get_message_queue().try_send(
+                        messages::SealCalibrationMessage{
+                            .calibration = seal.value()}));
+            }
             _offset_constants =
                 _eeprom.get_offset_constants(_offset_constants, policy);
         }
@@ -259,11 +318,14 @@ class ThermalPlateTask {
         // frequency.
 
         static_cast<void>(_message_queue.recv(&message));
+        auto handling = trace::Scope(
+            trace::message_event(trace::TASK_THERMAL_PLATE, message.index()));
         std::visit(
             [this, &policy](const auto& msg) -> void {
                 this->visit_message(msg, policy);
             },
             message);
+        update_control_period();
     }
 
   private:
@@ -278,6 +340,7 @@ class ThermalPlateTask {
     requires ThermalPlateExecutionPolicy<Policy>
     auto visit_message(const messages::ThermalPlateTempReadComplete& msg,
                        Policy& policy) -> void {
+        auto tick = trace::Scope(trace::PLATE_CONTROL_TICK);
         constexpr Milliseconds time_overflow_amount = Milliseconds(
             std::numeric_limits<decltype(msg.timestamp_ms)>::max());
         auto old_error_bitmap = _state.error_bitmap;
@@ -306,11 +369,12 @@ class ThermalPlateTask {
         handle_temperature_conversion(
             msg.back_center, _thermistors[THERM_BACK_CENTER], true, heatsink,
             _offset_constants.a, _offset_constants.bc, _offset_constants.cc);
+        _thermistor_stats.update(_plate_control.get_peltier_temps());
 
         if (_state.system_status == State::CONTROLLING &&
             _plate_control.status() ==
                 plate_control::PlateStatus::STEADY_STATE) {
-            if (!_plate_control.thermistor_drift_check()) {
+            if (!_plate_control.thermistor_drift_check(_thermistor_stats)) {
                 _state.error_bitmap |= State::DRIFT_ERROR;
             }
         }
@@ -320,6 +384,8 @@ class ThermalPlateTask {
             if (_state.error_bitmap != 0) {
                 // We entered an error state. Disable power output.
                 _state.system_status = State::ERROR;
+                _autotune.abort();
+                abort_protocol();
                 policy.set_enabled(false);
                 reset_peltier_filters();
             } else {
@@ -329,14 +395,19 @@ class ThermalPlateTask {
             send_current_error();
         }
 
+        auto time_delta = current_time - _last_update;
+        if (time_delta.count() < 0) {
+            time_delta += time_overflow_amount;
+        }
         if (_state.system_status == State::CONTROLLING) {
-            auto time_delta = current_time - _last_update;
-            if (time_delta.count() < 0) {
-                time_delta += time_overflow_amount;
-            }
+            update_protocol();
             update_control(policy,
                            std::chrono::duration_cast<Seconds>(time_delta));
             send_current_state();
+        } else if (_state.system_status == State::AUTOTUNING) {
+            update_autotune(policy,
+                            std::chrono::duration_cast<Seconds>(time_delta));
+            send_current_state();
         } else if (_state.system_status == State::IDLE) {
             send_current_state();
             auto fan_power = _plate_control.fan_idle_power();
@@ -416,7 +487,8 @@ class ThermalPlateTask {
                 _task_registry->comms->get_message_queue().try_send(response));
             return;
         }
-        if (_state.system_status == State::CONTROLLING) {
+        if (_state.system_status == State::CONTROLLING ||
+            _state.system_status == State::AUTOTUNING) {
             // Send busy error
             response.with_error = errors::ErrorCode::THERMAL_PLATE_BUSY;
             static_cast<void>(
@@ -550,6 +622,10 @@ class ThermalPlateTask {
             }
         }
 
+        // A new target takes over from any autotune or protocol in progress
+        _autotune.abort();
+        abort_protocol();
+
         double volume_ul = (msg.volume < 0.0F) ? DEFAULT_VOLUME_UL : msg.volume;
 
         if (msg.setpoint <= 0.0F) {
@@ -557,6 +633,9 @@ class ThermalPlateTask {
             policy.set_enabled(false);
             reset_peltier_filters();
         } else {
+            if (_state.system_status != State::CONTROLLING) {
+                _plate_control.reset_sample_estimate();
+            }
             if (_plate_control.set_new_target(msg.setpoint, volume_ul,
                                               msg.hold_time)) {
                 _state.system_status = State::CONTROLLING;
@@ -584,6 +663,8 @@ class ThermalPlateTask {
 
         policy.set_enabled(false);
         reset_peltier_filters();
+        _autotune.abort();
+        abort_protocol();
         _state.system_status = State::IDLE;
 
         if (msg.from_system) {
@@ -603,6 +684,8 @@ class ThermalPlateTask {
 
         policy.set_enabled(false);
         reset_peltier_filters();
+        _autotune.abort();
+        abort_protocol();
         if (_state.system_status != State::ERROR) {
             _state.system_status = State::IDLE;
         }
@@ -613,18 +696,17 @@ class ThermalPlateTask {
     template <ThermalPlateExecutionPolicy Policy>
     auto visit_message(const messages::SetPIDConstantsMessage& msg,
                        Policy& policy) -> void {
-        static_cast<void>(policy);
         auto response =
             messages::AcknowledgePrevious{.responding_to_id = msg.id};
 
-        if (_state.system_status == State::CONTROLLING) {
+        if (_state.system_status == State::CONTROLLING ||
+            _state.system_status == State::AUTOTUNING) {
             response.with_error = errors::ErrorCode::THERMAL_PLATE_BUSY;
             static_cast<void>(
                 _task_registry->comms->get_message_queue().try_send(response));
             return;
         }
-        if ((msg.p < KP_MIN) || (msg.p > KP_MAX) || (msg.i < KI_MIN) ||
-            (msg.i > KI_MAX) || (msg.d < KD_MIN) || (msg.d > KD_MAX)) {
+        if (!pid_constants_in_range(msg.p, msg.i, msg.d)) {
             response.with_error =
                 errors::ErrorCode::THERMAL_CONSTANT_OUT_OF_RANGE;
             static_cast<void>(
@@ -637,12 +719,12 @@ class ThermalPlateTask {
                 PID(msg.p, msg.i, msg.d, CONTROL_PERIOD_SECONDS, 1.0, -1.0);
         } else {
             // For now, all peltiers share the same PID values...
-            _peltier_right.pid =
-                PID(msg.p, msg.i, msg.d, CONTROL_PERIOD_SECONDS, 1.0, -1.0);
-            _peltier_left.pid =
-                PID(msg.p, msg.i, msg.d, CONTROL_PERIOD_SECONDS, 1.0, -1.0);
-            _peltier_center.pid =
-                PID(msg.p, msg.i, msg.d, CONTROL_PERIOD_SECONDS, 1.0, -1.0);
+            set_peltier_pids(msg.p, msg.i, msg.d);
+            // ...which replace any gain schedule, in the EEPROM too so that
+            // a schedule set before doesn't come back at boot
+            if (!save_peltier_pids(msg.p, msg.i, msg.d, policy)) {
+                response.with_error = errors::ErrorCode::SYSTEM_EEPROM_ERROR;
+            }
         }
 
         static_cast<void>(
@@ -728,6 +810,335 @@ class ThermalPlateTask {
             _task_registry->comms->get_message_queue().try_send(response));
     }
 
+    template <ThermalPlateExecutionPolicy Policy>
+    auto visit_message(const messages::SetPlateModelMessage& msg,
+                       Policy& policy) -> void {
+        auto response =
+            messages::AcknowledgePrevious{.responding_to_id = msg.id};
+        auto model = plate_model::PlateModel{.gain = msg.gain,
+                                             .time_constant = msg.time_constant,
+                                             .dead_time = msg.dead_time};
+        bool disabled = (model.gain == 0.0F) && (model.time_constant == 0.0F) &&
+                        (model.dead_time == 0.0F);
+        if (!disabled && !model.valid()) {
+            response.with_error =
+                errors::ErrorCode::THERMAL_CONSTANT_OUT_OF_RANGE;
+        } else {
+            _plate_control.set_model(model);
+            if (!_eeprom.template write_plate_model(model, policy)) {
+                response.with_error = errors::ErrorCode::SYSTEM_EEPROM_ERROR;
+            }
+        }
+
+        static_cast<void>(
+            _task_registry->comms->get_message_queue().try_send(response));
+    }
+
+    template <ThermalPlateExecutionPolicy Policy>
+    auto visit_message(const messages::GetPlateModelMessage& msg,
+                       Policy& policy) -> void {
+        static_cast<void>(policy);
+        auto model = _plate_control.model();
+        auto response = messages::GetPlateModelResponse{
+            .responding_to_id = msg.id,
+            .gain = model.gain,
+            .time_constant = model.time_constant,
+            .dead_time = model.dead_time};
+
+        static_cast<void>(
+            _task_registry->comms->get_message_queue().try_send(response));
+    }
+
+    template <ThermalPlateExecutionPolicy Policy>
+    auto visit_message(const messages::StartAutotuneMessage& msg,
+                       Policy& policy) -> void {
+        static_cast<void>(policy);
+        auto response =
+            messages::AcknowledgePrevious{.responding_to_id = msg.id};
+        if (_state.system_status == State::ERROR) {
+            response.with_error = most_relevant_error();
+        } else if (_state.system_status != State::IDLE) {
+            response.with_error = errors::ErrorCode::THERMAL_PLATE_BUSY;
+        } else if (msg.target < AUTOTUNE_MIN_TARGET_C ||
+                   msg.target > AUTOTUNE_MAX_TARGET_C) {
+            response.with_error = errors::ErrorCode::THERMAL_TARGET_BAD;
+        } else {
+            _autotune.start(relay_autotune::Settings{
+                .setpoint = msg.target,
+                .output_high = 1.0F,
+                .output_low = -1.0F,
+                .hysteresis = AUTOTUNE_HYSTERESIS_C,
+                .timeout = AUTOTUNE_TIMEOUT_S,
+                .bias = _plate_control.model().holding_power(
+                    msg.target, _thermistors[THERM_HEATSINK].temp_c),
+                .amplitude = AUTOTUNE_RELAY_POWER});
+            _autotune_write = msg.write;
+            reset_peltier_filters();
+            _state.system_status = State::AUTOTUNING;
+        }
+        static_cast<void>(
+            _task_registry->comms->get_message_queue().try_send(response));
+    }
+
+    template <ThermalPlateExecutionPolicy Policy>
+    auto visit_message(const messages::GetAutotuneResultMessage& msg,
+                       Policy& policy) -> void {
+        static_cast<void>(policy);
+        auto response = messages::GetAutotuneResultResponse{
+            .responding_to_id = msg.id,
+            .selection = PidSelection::PELTIERS,
+            .status = _autotune.status(),
+            .cycles = _autotune.cycles(),
+            .result = _autotune.result()};
+        static_cast<void>(
+            _task_registry->comms->get_message_queue().try_send(response));
+    }
+
+    template <ThermalPlateExecutionPolicy Policy>
+    auto visit_message(const messages::NewProtocolMessage& msg,
+                       Policy& policy) -> void {
+        static_cast<void>(policy);
+        auto response =
+            messages::AcknowledgePrevious{.responding_to_id = msg.id};
+        double volume_ul = (msg.volume < 0.0F) ? DEFAULT_VOLUME_UL : msg.volume;
+        if (!_protocol.clear(msg.lid_temperature, volume_ul)) {
+            response.with_error = errors::ErrorCode::THERMAL_PROTOCOL_INVALID;
+        }
+        static_cast<void>(
+            _task_registry->comms->get_message_queue().try_send(response));
+    }
+
+    template <ThermalPlateExecutionPolicy Policy>
+    auto visit_message(const messages::AddProtocolStageMessage& msg,
+                       Policy& policy) -> void {
+        static_cast<void>(policy);
+        auto response =
+            messages::AcknowledgePrevious{.responding_to_id = msg.id};
+        if (!_protocol.add_stage(msg.cycles)) {
+            response.with_error = errors::ErrorCode::THERMAL_PROTOCOL_INVALID;
+        }
+        static_cast<void>(
+            _task_registry->comms->get_message_queue().try_send(response));
+    }
+
+    template <ThermalPlateExecutionPolicy Policy>
+    auto visit_message(const messages::AddProtocolStepMessage& msg,
+                       Policy& policy) -> void {
+        static_cast<void>(policy);
+        auto response =
+            messages::AcknowledgePrevious{.responding_to_id = msg.id};
+        if (!_protocol.add_step(msg.step)) {
+            response.with_error = errors::ErrorCode::THERMAL_PROTOCOL_INVALID;
+        }
+        static_cast<void>(
+            _task_registry->comms->get_message_queue().try_send(response));
+    }
+
+    template <ThermalPlateExecutionPolicy Policy>
+    auto visit_message(const messages::StartProtocolMessage& msg,
+                       Policy& policy) -> void {
+        static_cast<void>(policy);
+        auto response =
+            messages::AcknowledgePrevious{.responding_to_id = msg.id};
+        if (_state.system_status == State::ERROR) {
+            response.with_error = most_relevant_error();
+        } else if (_state.system_status != State::IDLE &&
+                   _state.system_status != State::CONTROLLING) {
+            response.with_error = errors::ErrorCode::THERMAL_PLATE_BUSY;
+        } else {
+            bool preheat =
+                msg.preheat && (_protocol.lid_temperature() > 0.0F);
+            auto step = preheat ? _protocol.preheat() : _protocol.start();
+            if (step.has_value()) {
+                auto lid_message = messages::SetLidTemperatureMessage{
+                    .id = 0,
+                    .setpoint = _protocol.lid_temperature(),
+                    .from_plate = true};
+                if (preheat) {
+                    // The plate stays as it is until the lid says to go
+                    lid_message.preheat_lead_time =
+                        _plate_control.estimate_ramp_time(
+                            step.value().temperature, step.value().ramp_rate);
+                } else {
+                    start_first_protocol_step(step.value());
+                }
+                if (_protocol.lid_temperature() > 0.0F) {
+                    auto sent =
+                        _task_registry->lid_heater->get_message_queue()
+                            .try_send(lid_message);
+                    if (!sent && preheat) {
+                        // The lid will never say to go, so don't wait
+                        abort_protocol();
+                        response.with_error =
+                            errors::ErrorCode::INTERNAL_QUEUE_FULL;
+                    }
+                }
+            } else {
+                response.with_error =
+                    errors::ErrorCode::THERMAL_PROTOCOL_INVALID;
+            }
+        }
+        static_cast<void>(
+            _task_registry->comms->get_message_queue().try_send(response));
+    }
+
+    template <ThermalPlateExecutionPolicy Policy>
+    auto visit_message(const messages::LidPreheatDoneMessage& msg,
+                       Policy& policy) -> void {
+        static_cast<void>(policy);
+        if (!_protocol.preheating()) {
+            return;
+        }
+        // The plate may have been put to other use, like an autotune, while
+        // it was waiting
+        bool plate_free = _state.system_status == State::IDLE ||
+                          _state.system_status == State::CONTROLLING;
+        if (!msg.at_temperature || !plate_free) {
+            abort_protocol();
+            return;
+        }
+        auto step = _protocol.start();
+        if (step.has_value()) {
+            start_first_protocol_step(step.value());
+        }
+    }
+
+    template <ThermalPlateExecutionPolicy Policy>
+    auto visit_message(const messages::LidProtocolErrorMessage& msg,
+                       Policy& policy) -> void {
+        static_cast<void>(msg);
+        static_cast<void>(policy);
+        if (!_protocol.active()) {
+            return;
+        }
+        // The lid has already reported its own error. The plate keeps
+        // holding its current target.
+        abort_protocol();
+        static_cast<void>(_task_registry->comms->get_message_queue().try_send(
+            messages::ErrorMessage{
+                .code = errors::ErrorCode::THERMAL_PROTOCOL_ABORTED}));
+    }
+
+    template <ThermalPlateExecutionPolicy Policy>
+    auto visit_message(const messages::GetProtocolStatusMessage& msg,
+                       Policy& policy) -> void {
+        static_cast<void>(policy);
+        auto response = messages::GetProtocolStatusResponse{
+            .responding_to_id = msg.id,
+            .progress = _protocol.progress(),
+            .hold_remaining = 0.0F};
+        if (_protocol.running()) {
+            response.hold_remaining = _plate_control.get_hold_time().first;
+        }
+        static_cast<void>(
+            _task_registry->comms->get_message_queue().try_send(response));
+    }
+
+    template <ThermalPlateExecutionPolicy Policy>
+    auto visit_message(const messages::SetSampleHoldMessage& msg,
+                       Policy& policy) -> void {
+        static_cast<void>(policy);
+        _plate_control.set_sample_hold(msg.enable);
+        auto response =
+            messages::AcknowledgePrevious{.responding_to_id = msg.id};
+        static_cast<void>(
+            _task_registry->comms->get_message_queue().try_send(response));
+    }
+
+    template <ThermalPlateExecutionPolicy Policy>
+    auto visit_message(const messages::GetSampleEstimateMessage& msg,
+                       Policy& policy) -> void {
+        static_cast<void>(policy);
+        auto response = messages::GetSampleEstimateResponse{
+            .responding_to_id = msg.id,
+            .sample_temp = _plate_control.sample_temp(),
+            .sample_hold = _plate_control.sample_hold()};
+        static_cast<void>(
+            _task_registry->comms->get_message_queue().try_send(response));
+    }
+
+    template <ThermalPlateExecutionPolicy Policy>
+    auto visit_message(const messages::GetThermistorStatsMessage& msg,
+                       Policy& policy) -> void {
+        static_cast<void>(policy);
+        auto response = messages::GetThermistorStatsResponse{
+            .responding_to_id = msg.id, .stats = _thermistor_stats.summary()};
+        if (msg.reset) {
+            _thermistor_stats.reset();
+        }
+        static_cast<void>(
+            _task_registry->comms->get_message_queue().try_send(response));
+    }
+
+    template <ThermalPlateExecutionPolicy Policy>
+    auto visit_message(const messages::SaveSealCalibrationMessage& msg,
+                       Policy& policy) -> void {
+        // The motor task owns the calibration, but the EEPROM lives here
+        if (!_eeprom.template write_seal_calibration(msg.calibration,
+                                                     policy)) {
+            auto error_message = messages::HostCommsMessage(
+                messages::ErrorMessage{
+                    .code = errors::ErrorCode::SYSTEM_EEPROM_ERROR});
+            static_cast<void>(
+                _task_registry->comms->get_message_queue().try_send(
+                    error_message));
+        }
+    }
+
+    template <ThermalPlateExecutionPolicy Policy>
+    auto visit_message(const messages::SetGainScheduleMessage& msg,
+                       Policy& policy) -> void {
+        auto response =
+            messages::AcknowledgePrevious{.responding_to_id = msg.id};
+        if (!gain_schedule::GainSchedule::valid_zone(msg.zone) ||
+            !pid_constants_in_range(msg.p, msg.i, msg.d)) {
+            response.with_error =
+                errors::ErrorCode::THERMAL_CONSTANT_OUT_OF_RANGE;
+        } else {
+            // Start from the gains currently in use if no schedule has
+            // been configured yet
+            auto schedule = _plate_control.schedule().value_or(
+                gain_schedule::GainSchedule(gain_schedule::Gains{
+                    .kp = _peltier_left.pid.kp(),
+                    .ki = _peltier_left.pid.ki(),
+                    .kd = _peltier_left.pid.kd()}));
+            schedule.set(static_cast<gain_schedule::Zone>(msg.zone),
+                         msg.heating,
+                         gain_schedule::Gains{
+                             .kp = msg.p, .ki = msg.i, .kd = msg.d});
+            _plate_control.set_gain_schedule(schedule);
+            if (!_eeprom.template write_gain_schedule(schedule, policy)) {
+                response.with_error = errors::ErrorCode::SYSTEM_EEPROM_ERROR;
+            }
+        }
+        static_cast<void>(
+            _task_registry->comms->get_message_queue().try_send(response));
+    }
+
+    template <ThermalPlateExecutionPolicy Policy>
+    auto visit_message(const messages::GetGainScheduleMessage& msg,
+                       Policy& policy) -> void {
+        static_cast<void>(policy);
+        auto gains = gain_schedule::Gains{.kp = _peltier_left.pid.kp(),
+                                          .ki = _peltier_left.pid.ki(),
+                                          .kd = _peltier_left.pid.kd()};
+        const auto& schedule = _plate_control.schedule();
+        if (schedule.has_value() &&
+            gain_schedule::GainSchedule::valid_zone(msg.zone)) {
+            gains = schedule.value().get(
+                static_cast<gain_schedule::Zone>(msg.zone), msg.heating);
+        }
+        auto response =
+            messages::GetGainScheduleResponse{.responding_to_id = msg.id,
+                                              .zone = msg.zone,
+                                              .heating = msg.heating,
+                                              .p = gains.kp,
+                                              .i = gains.ki,
+                                              .d = gains.kd};
+        static_cast<void>(
+            _task_registry->comms->get_message_queue().try_send(response));
+    }
+
     template <ThermalPlateExecutionPolicy Policy>
     auto visit_message(const messages::GetOffsetConstantsMessage& msg,
                        Policy& policy) -> void {
@@ -888,6 +1299,189 @@ class ThermalPlateTask {
         return true;
     }
 
+    /**
+     * @brief Update the relay autotune when the system is in the
+     * AUTOTUNING state. All three peltiers are driven together from the
+     * average plate temperature. Once the autotune finishes, the plate
+     * goes idle and a successful result is applied to the peltier PIDs
+     * (and written to the EEPROM, if that was requested).
+     * @param[in] policy The thermal plate policy
+     * @param[in] elapsed_time The amount of time that has passed since the
+     * last thermistor reading, in seconds
+     */
+    template <ThermalPlateExecutionPolicy Policy>
+    auto update_autotune(Policy& policy, Seconds elapsed_time) -> void {
+        auto power =
+            _autotune.update(average_plate_temp(), elapsed_time.count());
+        if (!_autotune.running()) {
+            policy.set_enabled(false);
+            reset_peltier_filters();
+            _state.system_status = State::IDLE;
+            if (_autotune.status() == relay_autotune::Status::DONE) {
+                finish_autotune(policy);
+            }
+            return;
+        }
+        policy.set_enabled(true);
+        auto ret =
+            set_peltier_power(_peltier_left, power, elapsed_time, policy);
+        if (ret) {
+            ret =
+                set_peltier_power(_peltier_right, power, elapsed_time, policy);
+        }
+        if (ret) {
+            ret =
+                set_peltier_power(_peltier_center, power, elapsed_time, policy);
+        }
+        if (!ret) {
+            policy.set_enabled(false);
+            _autotune.abort();
+            _state.system_status = State::ERROR;
+            _state.error_bitmap |= State::PELTIER_ERROR;
+            return;
+        }
+        if (!_fans.manual_control) {
+            if (!policy.set_fan(AUTOTUNE_FAN_POWER)) {
+                policy.set_enabled(false);
+                _autotune.abort();
+                _state.system_status = State::ERROR;
+                _state.error_bitmap |= State::FAN_ERROR;
+            }
+        }
+    }
+
+    /**
+     * @brief Check PID constants against the limits for setting them.
+     */
+    [[nodiscard]] static auto pid_constants_in_range(double p, double i,
+                                                     double d) -> bool {
+        return (p >= KP_MIN) && (p <= KP_MAX) && (i >= KI_MIN) &&
+               (i <= KI_MAX) && (d >= KD_MIN) && (d <= KD_MAX);
+    }
+
+    /**
+     * @brief Apply the gains from a completed autotune to the peltiers.
+     * A result outside the limits for setting the gains by hand comes from
+     * an oscillation that couldn't be measured properly, so it is reported
+     * as an error and the old gains are kept.
+     */
+    template <ThermalPlateExecutionPolicy Policy>
+    auto finish_autotune(Policy& policy) -> void {
+        const auto& result = _autotune.result();
+        if (!pid_constants_in_range(result.kp, result.ki, result.kd)) {
+            auto error_message =
+                messages::HostCommsMessage(messages::ErrorMessage{
+                    .code = errors::ErrorCode::THERMAL_CONSTANT_OUT_OF_RANGE});
+            static_cast<void>(
+                _task_registry->comms->get_message_queue().try_send(
+                    error_message));
+            return;
+        }
+        set_peltier_pids(result.kp, result.ki, result.kd);
+        if (!_autotune_write) {
+            return;
+        }
+        if (!save_peltier_pids(result.kp, result.ki, result.kd, policy)) {
+            auto error_message = messages::HostCommsMessage(
+                messages::ErrorMessage{
+                    .code = errors::ErrorCode::SYSTEM_EEPROM_ERROR});
+            static_cast<void>(
+                _task_registry->comms->get_message_queue().try_send(
+                    error_message));
+        }
+    }
+
+    /**
+     * @brief Move a running protocol on to its next step once the hold
+     * time of the current step has elapsed. Call this when the state is
+     * CONTROLLING, before updating the control loop.
+     */
+    auto update_protocol() -> void {
+        if (!_protocol.running() || !_plate_control.hold_complete()) {
+            return;
+        }
+        auto step = _protocol.advance();
+        if (step.has_value()) {
+            start_protocol_step(step.value());
+        } else {
+            release_lid();
+        }
+    }
+
+    /**
+     * @brief Stop any protocol in progress, and turn off the lid if it was
+     * heating for it.
+     */
+    auto abort_protocol() -> void {
+        if (_protocol.active()) {
+            release_lid();
+        }
+        _protocol.abort();
+    }
+
+    /**
+     * @brief Tell the lid that the protocol no longer needs it. The lid
+     * only turns off if it is still heating for the protocol.
+     */
+    auto release_lid() -> void {
+        if (_protocol.lid_temperature() > 0.0F) {
+            static_cast<void>(
+                _task_registry->lid_heater->get_message_queue().try_send(
+                    messages::DeactivateLidHeatingMessage{.id = 0,
+                                                          .from_plate = true}));
+        }
+    }
+
+    /**
+     * @brief Start controlling the plate for the first step of a protocol.
+     */
+    auto start_first_protocol_step(const pcr_protocol::Step& step) -> void {
+        if (_state.system_status != State::CONTROLLING) {
+            _plate_control.reset_sample_estimate();
+        }
+        start_protocol_step(step);
+        _state.system_status = State::CONTROLLING;
+    }
+
+    /**
+     * @brief Hand a protocol step to the plate control.
+     */
+    auto start_protocol_step(const pcr_protocol::Step& step) -> void {
+        static_cast<void>(_plate_control.set_new_target(
+            step.temperature, _protocol.volume(), step.hold_time,
+            step.ramp_rate));
+    }
+
+    /**
+     * @brief Store gains shared by every peltier in the EEPROM, along with
+     * a gain schedule that uses them everywhere, since a saved schedule
+     * would override the new constants at boot.
+     * @return True if both were written
+     */
+    template <ThermalPlateExecutionPolicy Policy>
+    auto save_peltier_pids(double kp, double ki, double kd, Policy& policy)
+        -> bool {
+        auto constants = eeprom::PIDConstants{.kp = kp, .ki = ki, .kd = kd};
+        auto schedule = gain_schedule::GainSchedule(
+            gain_schedule::Gains{.kp = kp, .ki = ki, .kd = kd});
+        return _eeprom.template write_pid_constants(constants, policy) &&
+               _eeprom.template write_gain_schedule(schedule, policy);
+    }
+
+    /**
+     * @brief Give every peltier the same gains, and replace the gain
+     * schedule with one that uses those gains everywhere.
+     */
+    auto set_peltier_pids(double kp, double ki, double kd) -> void {
+        _peltier_right.pid =
+            PID(kp, ki, kd, CONTROL_PERIOD_SECONDS, 1.0, -1.0);
+        _peltier_left.pid = PID(kp, ki, kd, CONTROL_PERIOD_SECONDS, 1.0, -1.0);
+        _peltier_center.pid =
+            PID(kp, ki, kd, CONTROL_PERIOD_SECONDS, 1.0, -1.0);
+        _plate_control.set_gain_schedule(gain_schedule::GainSchedule(
+            gain_schedule::Gains{.kp = kp, .ki = ki, .kd = kd}));
+    }
+
     /**
      * @brief Updates the power of a peltier, and intended to be called for
      * closed-loop control. Accepts a power setting, applies a small filter,
@@ -957,6 +1551,9 @@ class ThermalPlateTask {
                 state =
                     (ramping) ? PlateState::COOLING : PlateState::AT_COLD_TEMP;
             }
+        } else if (_state.system_status == State::AUTOTUNING) {
+            // The plate never settles while autotuning, so show it as ramping
+            state = PlateState::HEATING;
         }
 
         auto message = messages::UpdatePlateState{.state = state};
@@ -982,10 +1579,35 @@ class ThermalPlateTask {
         return (const_a * heatsink_temp) + ((1.0F + const_b) * temp) + const_c;
     }
 
+    /**
+     * @brief Pick the sampling period for the current control state. The
+     * plate is sampled faster while the temperature is moving so ramps are
+     * tracked closely, and slower while holding to free up the ADC bus.
+     * The PID loops are all driven with the measured time between readings,
+     * so they are unaffected by the period changing.
+     */
+    auto update_control_period() -> void {
+        auto period = HOLD_CONTROL_PERIOD_TICKS;
+        if (_state.system_status == State::CONTROLLING &&
+            _plate_control.status() !=
+                plate_control::PlateStatus::STEADY_STATE) {
+            period = RAMP_CONTROL_PERIOD_TICKS;
+        }
+        // The autotune measures the oscillation period, so it is sampled
+        // at the faster rate throughout
+        if (_state.system_status == State::AUTOTUNING) {
+            period = RAMP_CONTROL_PERIOD_TICKS;
+        }
+        _control_period_ticks.store(period, std::memory_order_relaxed);
+    }
+
     auto reset_peltier_filters() {
         _peltier_left.filter.reset();
         _peltier_right.filter.reset();
         _peltier_center.filter.reset();
+        _peltier_left.zone.reset();
+        _peltier_right.zone.reset();
+        _peltier_center.zone.reset();
     }
 
     Queue& _message_queue;
@@ -1001,6 +1623,11 @@ class ThermalPlateTask {
     eeprom::Eeprom<EEPROM_PAGES, EEPROM_ADDRESS> _eeprom;
     eeprom::OffsetConstants _offset_constants;
     Milliseconds _last_update;
+    relay_autotune::RelayAutotune _autotune{};
+    bool _autotune_write = false;
+    pcr_protocol::ProtocolEngine _protocol{};
+    thermistor_stats::ThermistorStats _thermistor_stats{};
+    std::atomic<uint32_t> _control_period_ticks{HOLD_CONTROL_PERIOD_TICKS};
 };
 
 }  // namespace thermal_plate_task
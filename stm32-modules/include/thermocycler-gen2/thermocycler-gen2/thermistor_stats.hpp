@@ -0,0 +1,255 @@
+/**
+ * @file thermistor_stats.hpp
+ * @brief Defines the ThermistorStats class, which keeps running uniformity
+ * statistics for the plate thermistors.
+ * @details Every plate temperature reading is fed in, whether or not the
+ * plate is being controlled. For each thermistor, and for the spread
+ * between the hottest and coldest thermistor, the statistics cover the
+ * last WINDOW readings:
+ *
+ * - The mean and variance are updated with a sliding-window form of
+ * Welford's algorithm: each new reading replaces the oldest one in a single
+ * O(1) step. Rounding error from the sliding update is cleared by
+ * recomputing both exactly once per window, which keeps the cost O(1) per
+ * reading on average.
+ * - The minimum and maximum are tracked with a monotonic wedge, a queue of
+ * the readings that could still become the extreme of the window. Each
+ * reading enters and leaves the wedge at most once, so this is O(1) per
+ * reading on average as well.
+ *
+ * The mean spread between any pair of thermistors over the window is the
+ * difference of their means, so it doesn't need any state of its own.
+ *
+ * Everything is stored in fixed-size arrays, so nothing is allocated.
+ * Samples are stored as floats, which is plenty for thermistor readings
+ * and halves the memory used by each window.
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace thermistor_stats {
+
+/**
+ * @brief Statistics of one signal over a sliding window of its most recent
+ * samples.
+ * @tparam N The number of samples in the window
+ */
+template <size_t N>
+requires(N > 1 && N <= UINT8_MAX) class WindowStats {
+  public:
+    /** Forget every sample.*/
+    auto reset() -> void {
+        _count = 0;
+        _next = 0;
+        _mean = 0.0F;
+        _m2 = 0.0F;
+        _min_wedge.clear();
+        _max_wedge.clear();
+    }
+
+    /**
+     * @brief Add a new sample to the window, pushing out the oldest one
+     * once the window is full.
+     */
+    auto add(double reading) -> void {
+        // Work with the value as it will be stored, so that it leaves the
+        // window exactly as it entered
+        double value = static_cast<float>(reading);
+        auto slot = _next;
+        if (_count == N) {
+            // The oldest sample is in this slot, so it must leave the
+            // wedges before it is overwritten
+            _min_wedge.expire(slot);
+            _max_wedge.expire(slot);
+        }
+        if (_count < N) {
+            ++_count;
+            auto delta = value - _mean;
+            _mean += delta / static_cast<double>(_count);
+            _m2 += delta * (value - _mean);
+        } else {
+            double oldest = _samples.at(slot);
+            auto old_mean = _mean;
+            _mean += (value - oldest) / static_cast<double>(N);
+            _m2 += (value - oldest) * (value - _mean + oldest - old_mean);
+        }
+        _samples.at(slot) = static_cast<float>(value);
+        _min_wedge.push(_samples, slot,
+                        [](float a, float b) { return a <= b; });
+        _max_wedge.push(_samples, slot,
+                        [](float a, float b) { return a >= b; });
+        _next = (slot + 1) % N;
+        if (_count == N && _next == 0) {
+            resync();
+        }
+    }
+
+    /** The number of samples in the window.*/
+    [[nodiscard]] auto count() const -> size_t { return _count; }
+    [[nodiscard]] auto mean() const -> double { return _mean; }
+    /** The population variance of the window.*/
+    [[nodiscard]] auto variance() const -> double {
+        if (_count == 0) {
+            return 0.0F;
+        }
+        return std::max(_m2 / static_cast<double>(_count), 0.0);
+    }
+    [[nodiscard]] auto stddev() const -> double {
+        return std::sqrt(variance());
+    }
+    [[nodiscard]] auto min() const -> double { return extreme(_min_wedge); }
+    [[nodiscard]] auto max() const -> double { return extreme(_max_wedge); }
+    /** The most recent sample.*/
+    [[nodiscard]] auto latest() const -> double {
+        if (_count == 0) {
+            return 0.0F;
+        }
+        return _samples.at((_next + N - 1) % N);
+    }
+
+  private:
+    // A ring of the slots of samples whose values are in monotonic order,
+    // so the front is always the extreme of the window
+    class Wedge {
+      public:
+        auto clear() -> void {
+            _head = 0;
+            _size = 0;
+        }
+
+        // Drop the front if it is the sample in a slot that is about to be
+        // overwritten
+        auto expire(size_t slot) -> void {
+            if (_size > 0 && front() == slot) {
+                _head = (_head + 1) % N;
+                --_size;
+            }
+        }
+
+        // Drop every sample that the new one makes redundant, then add it
+        template <typename Dominates>
+        auto push(const std::array<float, N>& samples, size_t slot,
+                  Dominates dominates) -> void {
+            auto value = samples.at(slot);
+            while (_size > 0 && dominates(value, samples.at(back()))) {
+                --_size;
+            }
+            _slots.at((_head + _size) % N) = static_cast<uint8_t>(slot);
+            ++_size;
+        }
+
+        [[nodiscard]] auto empty() const -> bool { return _size == 0; }
+        [[nodiscard]] auto front() const -> size_t { return _slots.at(_head); }
+
+      private:
+        [[nodiscard]] auto back() const -> size_t {
+            return _slots.at((_head + _size - 1) % N);
+        }
+
+        std::array<uint8_t, N> _slots{};
+        size_t _head = 0;
+        size_t _size = 0;
+    };
+
+    [[nodiscard]] auto extreme(const Wedge& wedge) const -> double {
+        if (wedge.empty()) {
+            return 0.0F;
+        }
+        return _samples.at(wedge.front());
+    }
+
+    // Recompute the mean and variance from scratch
+    auto resync() -> void {
+        double sum = 0.0F;
+        for (auto sample : _samples) {
+            sum += sample;
+        }
+        _mean = sum / static_cast<double>(N);
+        _m2 = 0.0F;
+        for (auto sample : _samples) {
+            _m2 += (sample - _mean) * (sample - _mean);
+        }
+    }
+
+    std::array<float, N> _samples{};
+    size_t _count = 0;
+    // The slot the next sample goes in, which holds the oldest sample once
+    // the window is full
+    size_t _next = 0;
+    double _mean = 0.0F;
+    double _m2 = 0.0F;
+    Wedge _min_wedge{};
+    Wedge _max_wedge{};
+};
+
+/** A compact copy of the statistics of one signal.*/
+struct ChannelSummary {
+    float mean = 0.0F;
+    float stddev = 0.0F;
+    float min = 0.0F;
+    float max = 0.0F;
+};
+
+class ThermistorStats {
+  public:
+    /** The number of plate thermistors, in the order they are added:
+     * back left, front left, back center, front center, back right,
+     * front right.*/
+    static constexpr size_t CHANNELS = 6;
+    /** The number of readings the statistics cover. At the default control
+     * period, this is a little over 3 seconds.*/
+    static constexpr size_t WINDOW = 64;
+    using Channel = WindowStats<WINDOW>;
+    using Temperatures = std::array<double, CHANNELS>;
+
+    /** Everything needed to report the statistics, in a form that is small
+     * enough to pass between tasks.*/
+    struct Summary {
+        uint32_t samples = 0;
+        ChannelSummary spread{};
+        std::array<ChannelSummary, CHANNELS> thermistors{};
+    };
+
+    /** Forget every reading.*/
+    auto reset() -> void;
+
+    /**
+     * @brief Add a new reading of every plate thermistor.
+     * @param temperatures The plate thermistor temperatures, in ºC
+     */
+    auto update(const Temperatures& temperatures) -> void;
+
+    /** The statistics of one thermistor.*/
+    [[nodiscard]] auto thermistor(size_t index) const -> const Channel& {
+        return _thermistors.at(index);
+    }
+    /** The statistics of the spread between the hottest and coldest
+     * thermistor of each reading.*/
+    [[nodiscard]] auto spread() const -> const Channel& { return _spread; }
+    /** The hottest thermistor of the latest reading, in ºC.*/
+    [[nodiscard]] auto hottest() const -> double { return _hottest; }
+    /**
+     * @brief Get the mean spread between two thermistors over the window.
+     * @return The mean of the first thermistor minus the mean of the second,
+     * in ºC
+     */
+    [[nodiscard]] auto pair_spread(size_t first, size_t second) const
+        -> double;
+    /** The total number of readings since the last reset.*/
+    [[nodiscard]] auto samples() const -> uint32_t { return _samples; }
+
+    [[nodiscard]] auto summary() const -> Summary;
+
+  private:
+    std::array<Channel, CHANNELS> _thermistors{};
+    Channel _spread{};
+    double _hottest = 0.0F;
+    uint32_t _samples = 0;
+};
+
+}  // namespace thermistor_stats
@@ -4,10 +4,13 @@
  */
 #pragma once
 
+#include <array>
 #include <concepts>
 #include <cstdint>
 #include <functional>
 #include <optional>
+#include <span>
+#include <utility>
 
 #include "core/bit_utils.hpp"
 #include "systemwide.h"
@@ -31,67 +34,82 @@ class TMC2130 {
   public:
     TMC2130() = delete;
     TMC2130(const TMC2130RegisterMap& registers)
-        : _registers(registers), _spi(), _initialized(false) {}
+        : _registers(registers),
+          _spi(),
+          _initialized(false),
+          _shadow(),
+          _shadow_valid() {}
 
+    /**
+     * @brief Write the register map to the TMC2130. Only the registers that
+     * have changed since they were last written are sent, all in a single
+     * chained transfer.
+     * @param policy Instance of abstraction policy to use
+     * @return True if the registers were written succesfully
+     */
     template <TMC2130Policy Policy>
     auto write_config(Policy& policy) -> bool {
-        if (!set_gconf(_registers.gconfig, policy)) {
-            return false;
-        }
-        if (!set_current_control(_registers.ihold_irun, policy)) {
-            return false;
-        }
-        if (!set_power_down_delay(
-                PowerDownDelay::reg_to_seconds(_registers.tpowerdown.time),
-                policy)) {
-            return false;
-        }
-        if (!set_cool_threshold(_registers.tcoolthrs, policy)) {
-            return false;
-        }
-        if (!set_thigh(_registers.thigh, policy)) {
-            return false;
-        }
-        if (!set_chop_config(_registers.chopconf, policy)) {
-            return false;
-        }
-        if (!set_cool_config(_registers.coolconf, policy)) {
-            return false;
-        }
-        _initialized = true;
-        return true;
+        return write_config(TMC2130RegisterMap(_registers), policy);
     }
 
+    /**
+     * @brief Write a new register map to the TMC2130. Only the registers
+     * that have changed since they were last written are sent, all in a
+     * single chained transfer.
+     * @param registers The new register map
+     * @param policy Instance of abstraction policy to use
+     * @return True if the registers were written succesfully. On failure,
+     * the register map is left as it was.
+     */
     template <TMC2130Policy Policy>
     auto write_config(const TMC2130RegisterMap& registers, Policy& policy)
         -> bool {
-        if (!set_gconf(registers.gconfig, policy)) {
-            return false;
-        }
-        if (!set_current_control(registers.ihold_irun, policy)) {
-            return false;
-        }
-        if (!set_power_down_delay(
-                PowerDownDelay::reg_to_seconds(registers.tpowerdown.time),
-                policy)) {
-            return false;
-        }
-        if (!set_cool_threshold(registers.tcoolthrs, policy)) {
-            return false;
-        }
-        if (!set_thigh(registers.thigh, policy)) {
-            return false;
-        }
-        if (!set_chop_config(registers.chopconf, policy)) {
-            return false;
+        auto sanitized = registers;
+        sanitized.gconfig = verify_gconf(registers.gconfig);
+        sanitized.ihold_irun = verify_ihold_irun(registers.ihold_irun);
+        sanitized.tpowerdown = verify_tpowerdown(
+            PowerDownDelay::reg_to_seconds(registers.tpowerdown.time));
+        sanitized.coolconf = verify_coolconf(registers.coolconf);
+        auto values = std::array<RegisterSerializedType, CONFIG_REGISTERS>{
+            serialize(sanitized.gconfig),   serialize(sanitized.ihold_irun),
+            serialize(sanitized.tpowerdown), serialize(sanitized.tcoolthrs),
+            serialize(sanitized.thigh),      serialize(sanitized.chopconf),
+            serialize(sanitized.coolconf)};
+
+        auto writes = std::array<RegisterWrite, CONFIG_REGISTERS>{};
+        size_t count = 0;
+        for (size_t i = 0; i < CONFIG_REGISTERS; ++i) {
+            if (!_shadow_valid.at(i) || _shadow.at(i) != values.at(i)) {
+                writes.at(count++) =
+                    RegisterWrite{.addr = CONFIG_ADDRESSES.at(i),
+                                  .value = values.at(i)};
+            }
         }
-        if (!set_cool_config(registers.coolconf, policy)) {
+        if (!_spi.write_batch(std::span(writes.data(), count), policy)) {
+            // Some of the batch may have been written, so nothing is known
+            invalidate();
             return false;
         }
+        _shadow = values;
+        _shadow_valid.fill(true);
+        _registers.gconfig = sanitized.gconfig;
+        _registers.ihold_irun = sanitized.ihold_irun;
+        _registers.tpowerdown = sanitized.tpowerdown;
+        _registers.tcoolthrs = sanitized.tcoolthrs;
+        _registers.thigh = sanitized.thigh;
+        _registers.chopconf = sanitized.chopconf;
+        _registers.coolconf = sanitized.coolconf;
         _initialized = true;
         return true;
     }
 
+    /**
+     * @brief Forget which register values have been written, so that the
+     * next write_config writes every register. Use this if the TMC2130 may
+     * have lost its configuration.
+     */
+    auto invalidate() -> void { _shadow_valid.fill(false); }
+
     /**
      * @brief Check if the TMC2130 has been initialized.
      * @return true if the registers have been written at least once,
@@ -109,8 +127,7 @@ class TMC2130 {
      */
     template <TMC2130Policy Policy>
     auto set_gconf(GConfig reg, Policy& policy) -> bool {
-        reg.enc_commutation = 0;
-        reg.test_mode = 0;
+        reg = verify_gconf(reg);
         if (set_register(policy, reg)) {
             _registers.gconfig = reg;
             return true;
@@ -126,8 +143,7 @@ class TMC2130 {
      */
     template <TMC2130Policy Policy>
     auto set_current_control(CurrentControl reg, Policy& policy) -> bool {
-        reg.bit_padding_1 = 0;
-        reg.bit_padding_2 = 0;
+        reg = verify_ihold_irun(reg);
         if (set_register(policy, reg)) {
             _registers.ihold_irun = reg;
             return true;
@@ -142,8 +158,7 @@ class TMC2130 {
      */
     template <TMC2130Policy Policy>
     auto set_power_down_delay(double time, Policy& policy) -> bool {
-        PowerDownDelay temp_reg = {.time =
-                                       PowerDownDelay::seconds_to_reg(time)};
+        auto temp_reg = verify_tpowerdown(time);
         if (set_register(policy, temp_reg)) {
             _registers.tpowerdown = temp_reg;
             return true;
@@ -203,11 +218,7 @@ class TMC2130 {
      */
     template <TMC2130Policy Policy>
     auto set_cool_config(CoolConfig reg, Policy& policy) -> bool {
-        // Assert that bits that MUST be 0 are actually 0
-        reg.padding_1 = 0;
-        reg.padding_2 = 0;
-        reg.padding_3 = 0;
-        reg.padding_4 = 0;
+        reg = verify_coolconf(reg);
         if (set_register(policy, reg)) {
             _registers.coolconf = reg;
             return true;
@@ -273,6 +284,25 @@ class TMC2130 {
         return read_register<TStep>(policy);
     }
 
+    /**
+     * @brief Get the DRV_STATUS and TSTEP registers together, in a single
+     * chained transfer of three messages rather than four.
+     * @return The registers, or nothing if they couldn't be read.
+     */
+    template <TMC2130Policy Policy>
+    [[nodiscard]] auto get_driver_status_and_tstep(Policy& policy)
+        -> std::optional<std::pair<DriveStatus, TStep>> {
+        using RT = std::optional<std::pair<DriveStatus, TStep>>;
+        static constexpr auto addrs =
+            std::array{Registers::DRVSTATUS, Registers::TSTEP};
+        auto values = std::array<RegisterSerializedType, addrs.size()>{};
+        if (!_spi.read_batch(addrs, values, policy)) {
+            return RT();
+        }
+        return RT(std::make_pair(deserialize<DriveStatus>(values.at(0)),
+                                 deserialize<TStep>(values.at(1))));
+    }
+
     /**
      * @brief Get the register map
      */
@@ -281,6 +311,71 @@ class TMC2130 {
     }
 
   private:
+    // The registers that write_config writes, in the order it writes them
+    static constexpr size_t CONFIG_REGISTERS = 7;
+    static constexpr std::array<Registers, CONFIG_REGISTERS> CONFIG_ADDRESSES{
+        Registers::GCONF,     Registers::IHOLD_IRUN, Registers::TPOWERDOWN,
+        Registers::TCOOLTHRS, Registers::THIGH,      Registers::CHOPCONF,
+        Registers::COOLCONF};
+    static_assert(CONFIG_REGISTERS <= MAX_BATCH,
+                  "The configuration must fit in one batch");
+
+    static auto verify_gconf(GConfig reg) -> GConfig {
+        reg.enc_commutation = 0;
+        reg.test_mode = 0;
+        return reg;
+    }
+
+    static auto verify_ihold_irun(CurrentControl reg) -> CurrentControl {
+        reg.bit_padding_1 = 0;
+        reg.bit_padding_2 = 0;
+        return reg;
+    }
+
+    static auto verify_tpowerdown(double time) -> PowerDownDelay {
+        return PowerDownDelay{.time = PowerDownDelay::seconds_to_reg(time)};
+    }
+
+    static auto verify_coolconf(CoolConfig reg) -> CoolConfig {
+        // Assert that bits that MUST be 0 are actually 0
+        reg.padding_1 = 0;
+        reg.padding_2 = 0;
+        reg.padding_3 = 0;
+        reg.padding_4 = 0;
+        return reg;
+    }
+
+    // The value that is sent to the TMC2130 for a register
+    template <TMC2130Register Reg>
+    static auto serialize(Reg reg) -> RegisterSerializedType {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Warray-bounds"
+        // Ignore the typical linter warning because we're only using
+        // this on __packed structures that mimic hardware registers
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        auto value = *reinterpret_cast<RegisterSerializedTypeA*>(&reg);
+#pragma GCC diagnostic pop
+        return value & Reg::value_mask;
+    }
+
+    template <TMC2130Register Reg>
+    static auto deserialize(RegisterSerializedType value) -> Reg {
+        // Ignore the typical linter warning because we're only using
+        // this on __packed structures that mimic hardware registers
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        return *reinterpret_cast<Reg*>(&value);
+    }
+
+    // Record a value that was written to one of the configuration registers
+    auto remember(Registers addr, RegisterSerializedType value) -> void {
+        for (size_t i = 0; i < CONFIG_REGISTERS; ++i) {
+            if (CONFIG_ADDRESSES.at(i) == addr) {
+                _shadow.at(i) = value;
+                _shadow_valid.at(i) = true;
+            }
+        }
+    }
+
     /**
      * @brief Set a register on the TMC2130
      *
@@ -295,15 +390,13 @@ class TMC2130 {
     template <TMC2130Register Reg, TMC2130Policy Policy>
     requires WritableRegister<Reg>
     auto set_register(Policy& policy, Reg reg) -> bool {
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Warray-bounds"
-        // Ignore the typical linter warning because we're only using
-        // this on __packed structures that mimic hardware registers
-        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-        auto value = *reinterpret_cast<RegisterSerializedTypeA*>(&reg);
-#pragma GCC diagnostic pop
-        value &= Reg::value_mask;
-        return _spi.write(Reg::address, value, policy);
+        auto value = serialize(reg);
+        if (!_spi.write(Reg::address, value, policy)) {
+            invalidate();
+            return false;
+        }
+        remember(Reg::address, value);
+        return true;
     }
     /**
      * @brief Read a register on the TMC2130
@@ -322,14 +415,15 @@ class TMC2130 {
         if (!ret.has_value()) {
             return RT();
         }
-        // Ignore the typical linter warning because we're only using
-        // this on __packed structures that mimic hardware registers
-        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-        return RT(*reinterpret_cast<Reg*>(&ret.value()));
+        return RT(deserialize<Reg>(ret.value()));
     }
 
     TMC2130RegisterMap _registers = {};
     TMC2130Interface _spi = {};
     bool _initialized;
+    // The last value written to each configuration register, which is only
+    // known to be on the TMC2130 if its flag is set
+    std::array<RegisterSerializedType, CONFIG_REGISTERS> _shadow{};
+    std::array<bool, CONFIG_REGISTERS> _shadow_valid{};
 };
 }  // namespace tmc2130
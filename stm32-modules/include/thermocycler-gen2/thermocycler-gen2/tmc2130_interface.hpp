@@ -6,6 +6,7 @@
 #pragma once
 
 #include <optional>
+#include <span>
 
 #include "thermocycler-gen2/tmc2130_registers.hpp"
 
@@ -16,17 +17,31 @@ static constexpr size_t MESSAGE_LEN = 5;
 // The type of a single TMC2130 message.
 using MessageT = std::array<uint8_t, MESSAGE_LEN>;
 
+// The most register accesses that can be chained in one batch.
+static constexpr size_t MAX_BATCH = 8;
+
 // Flag for whether this is a read or write
 enum class WriteFlag { READ = 0x00, WRITE = 0x80 };
 
+// A single register write in a batch
+struct RegisterWrite {
+    Registers addr;
+    RegisterSerializedType value;
+};
+
 // Hardware abstraction policy for the TMC2130 communication.
 template <typename Policy>
-concept TMC2130InterfacePolicy = requires(Policy& p, MessageT& data) {
+concept TMC2130InterfacePolicy = requires(Policy& p, MessageT& data,
+                                          std::span<MessageT> batch) {
     // A function to read & write to a register. addr should include the
     // read/write bit.
     {
         p.tmc2130_transmit_receive(data)
         } -> std::same_as<std::optional<MessageT>>;
+    // Send several messages back to back in one chained transfer, toggling
+    // the chip select between each one. Each message is replaced with the
+    // reply to it.
+    { p.tmc2130_transmit_receive_batch(batch) } -> std::same_as<bool>;
 };
 
 /**
@@ -102,12 +117,91 @@ class TMC2130Interface {
         if (!ret.has_value()) {
             return RT();
         }
-        auto* iter = ret.value().begin();
-        std::advance(iter, 1);
+        return RT(reply_value(ret.value()));
+    }
+
+    /**
+     * @brief Write to several registers in a single chained transfer.
+     *
+     * @tparam Policy Type used for bus-level SPI comms
+     * @param[in] writes The registers to write, in order. There may be at
+     * most MAX_BATCH of them.
+     * @param[in] policy Instance of \c Policy
+     * @return True on success, false on error to write
+     */
+    template <TMC2130InterfacePolicy Policy>
+    auto write_batch(std::span<const RegisterWrite> writes, Policy& policy)
+        -> bool {
+        if (writes.size() > MAX_BATCH) {
+            return false;
+        }
+        if (writes.empty()) {
+            return true;
+        }
+        std::array<MessageT, MAX_BATCH> messages{};
+        for (size_t i = 0; i < writes.size(); ++i) {
+            auto message = build_message(writes[i].addr, WriteFlag::WRITE,
+                                         writes[i].value);
+            if (!message.has_value()) {
+                return false;
+            }
+            messages.at(i) = message.value();
+        }
+        return policy.tmc2130_transmit_receive_batch(
+            std::span(messages.data(), writes.size()));
+    }
+
+    /**
+     * @brief Read several registers in a single chained transfer. Each
+     * reply holds the register requested by the message before it, so this
+     * takes one more message than there are registers, rather than the two
+     * per register of separate reads.
+     *
+     * @tparam Policy Type used for bus-level SPI comms
+     * @param[in] addrs The registers to read. There may be at most
+     * MAX_BATCH of them.
+     * @param[out] values The values that were read, in the same order
+     * @param[in] policy Instance of \c Policy
+     * @return True on success, false on error to read
+     */
+    template <TMC2130InterfacePolicy Policy>
+    auto read_batch(std::span<const Registers> addrs,
+                    std::span<RegisterSerializedType> values, Policy& policy)
+        -> bool {
+        if (addrs.size() > MAX_BATCH || values.size() < addrs.size()) {
+            return false;
+        }
+        if (addrs.empty()) {
+            return true;
+        }
+        std::array<MessageT, MAX_BATCH + 1> messages{};
+        for (size_t i = 0; i < addrs.size(); ++i) {
+            auto message = build_message(addrs[i], WriteFlag::READ, 0);
+            if (!message.has_value()) {
+                return false;
+            }
+            messages.at(i) = message.value();
+        }
+        // Repeat the last read to clock its value out
+        messages.at(addrs.size()) = messages.at(addrs.size() - 1);
+        if (!policy.tmc2130_transmit_receive_batch(
+                std::span(messages.data(), addrs.size() + 1))) {
+            return false;
+        }
+        for (size_t i = 0; i < addrs.size(); ++i) {
+            values[i] = reply_value(messages.at(i + 1));
+        }
+        return true;
+    }
 
+  private:
+    // Get the register contents from a reply, skipping the status byte
+    static auto reply_value(const MessageT& reply) -> RegisterSerializedType {
+        const auto* iter = reply.begin();
+        std::advance(iter, 1);
         RegisterSerializedType retval = 0;
-        iter = bit_utils::bytes_to_int(iter, ret.value().end(), retval);
-        return RT(retval);
+        static_cast<void>(bit_utils::bytes_to_int(iter, reply.end(), retval));
+        return retval;
     }
 };
 
@@ -0,0 +1,75 @@
+/**
+ * @file zone_filter.hpp
+ * @brief Defines the ZoneFilter class, a small Kalman filter that fuses the
+ * front and back thermistors of one peltier zone into a single temperature
+ * estimate for the control loop.
+ * @details The filter state is the zone temperature and an unmodeled rate
+ * of change. Each update predicts the temperature forward, using the plate
+ * model with the peltier power and the heatsink temperature as inputs when
+ * a model is configured, and then corrects it with each of the two
+ * thermistor readings in turn. Tracking the rate lets the estimate follow
+ * a ramp without falling behind, so it is less noisy than the average of
+ * the two thermistors without lagging it.
+ *
+ * The raw readings are still used for every safety and uniformity check.
+ */
+#pragma once
+
+#include "thermocycler-gen2/plate_model.hpp"
+
+namespace zone_filter {
+
+class ZoneFilter {
+  public:
+    /** Variance of a single thermistor reading, in ºC^2.*/
+    static constexpr double MEASUREMENT_VARIANCE = 0.01F;
+    /** How quickly the temperature can change beyond the prediction,
+     * in ºC^2/s.*/
+    static constexpr double TEMPERATURE_PROCESS_NOISE = 0.002F;
+    /** How quickly the unmodeled rate can change, in (ºC/s)^2/s.*/
+    static constexpr double RATE_PROCESS_NOISE = 0.5F;
+    /** Uncertainty of the rate when the filter starts, in (ºC/s)^2.*/
+    static constexpr double INITIAL_RATE_VARIANCE = 1.0F;
+
+    /**
+     * @brief Forget the current estimate. The next update restarts the
+     * filter from the average of the thermistors. This should be called
+     * whenever a peltier is disabled.
+     */
+    auto reset() -> void { _initialized = false; }
+
+    /**
+     * @brief Feed a new pair of readings into the filter.
+     * @param front The front thermistor temperature, in ºC
+     * @param back The back thermistor temperature, in ºC
+     * @param power The power applied to the peltier since the last update,
+     * from -1 to 1
+     * @param heatsink The heatsink temperature, in ºC
+     * @param model The plate model. If it is not valid, the temperature is
+     * predicted from the tracked rate alone.
+     * @param time The time since the last update, in seconds
+     * @return The new temperature estimate, in ºC
+     */
+    auto update(double front, double back, double power, double heatsink,
+                const plate_model::PlateModel& model, double time) -> double;
+
+    [[nodiscard]] auto initialized() const -> bool { return _initialized; }
+    /** The estimated zone temperature, in ºC.*/
+    [[nodiscard]] auto temp() const -> double { return _temp; }
+    /** The estimated unmodeled rate of change, in ºC/s.*/
+    [[nodiscard]] auto rate() const -> double { return _rate; }
+
+  private:
+    auto correct(double measurement) -> void;
+
+    bool _initialized = false;
+    double _temp = 0.0F;
+    double _rate = 0.0F;
+    // Covariance of the estimate. The matrix is symmetric, so only one of
+    // the off-diagonal terms is stored.
+    double _p_temp = 0.0F;
+    double _p_cross = 0.0F;
+    double _p_rate = 0.0F;
+};
+
+}  // namespace zone_filter
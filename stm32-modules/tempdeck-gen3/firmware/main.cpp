@@ -1,5 +1,6 @@
 
 #include "FreeRTOS.h"
+#include "firmware/dwt_trace_clock.hpp"
 #include "firmware/firmware_tasks.hpp"
 #include "firmware/freertos_comms_task.hpp"
 #include "firmware/freertos_system_task.hpp"
@@ -49,6 +50,7 @@ static auto thermal_task =
 
 auto main() -> int {
     HardwareInit();
+    dwt_trace_clock::install(SystemCoreClock);
     host_task.start(tasks::HOST_TASK_PRIORITY, "HostComms", &aggregator);
     system_task.start(tasks::SYSTEM_TASK_PRIORITY, "System", &aggregator);
     ui_task.start(tasks::UI_TASK_PRIORITY, "UI", &aggregator);
@@ -0,0 +1,74 @@
+#include "firmware/i2c_bus_hardware.hpp"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+namespace i2c_bus_hardware {
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+static I2CBusPolicy _thermal_policy(I2C_BUS_THERMAL);
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables)
+static BusManager _thermal_bus(_thermal_policy);
+
+static auto on_transfer_complete(I2C_BUS bus, bool success) -> void {
+    if (bus == I2C_BUS_THERMAL) {
+        _thermal_bus.complete(success);
+    }
+}
+
+auto initialize() -> void {
+    i2c_hardware_init();
+    i2c_hardware_set_complete_callback(I2C_BUS_THERMAL, on_transfer_complete);
+}
+
+auto thermal_bus() -> BusManager& { return _thermal_bus; }
+
+auto I2CBusPolicy::i2c_bus_start(const i2c_bus::Transaction& transaction)
+    -> bool {
+    // The hardware transfer types are declared in the same order
+    return i2c_hardware_start_transfer(
+        _bus, static_cast<I2C_TRANSFER_TYPE>(transaction.type),
+        transaction.address, transaction.mem_address, transaction.data,
+        transaction.length);
+}
+
+// Masking interrupts up to the syscall priority keeps out both the I2C
+// interrupts and the scheduler, and works from tasks and interrupts alike
+auto I2CBusPolicy::i2c_bus_lock() -> void {
+    _saved_mask = taskENTER_CRITICAL_FROM_ISR();
+}
+
+auto I2CBusPolicy::i2c_bus_unlock() -> void {
+    taskEXIT_CRITICAL_FROM_ISR(_saved_mask);
+}
+
+auto BlockingTransfer::run(BusManager& bus, i2c_bus::Transaction transaction)
+    -> bool {
+    _task = xTaskGetCurrentTaskHandle();
+    _success = false;
+    transaction.callback = done;
+    transaction.context = this;
+    if (!bus.submit(transaction)) {
+        return false;
+    }
+    auto notification_val = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TIMEOUT_MS));
+    return (notification_val == 1) && _success;
+}
+
+auto BlockingTransfer::done(const i2c_bus::Transaction& transaction,
+                            bool success, void* context) -> void {
+    static_cast<void>(transaction);
+    auto* self = static_cast<BlockingTransfer*>(context);
+    self->_success = success;
+    auto* task = static_cast<TaskHandle_t>(self->_task);
+    // A transaction that fails to start finishes in the submitting task
+    if (xPortIsInsideInterrupt() == pdFALSE) {
+        xTaskNotifyGive(task);
+        return;
+    }
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    vTaskNotifyGiveFromISR(task, &higher_priority_task_woken);
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+}  // namespace i2c_bus_hardware
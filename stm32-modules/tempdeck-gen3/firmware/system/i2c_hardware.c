@@ -34,6 +34,11 @@
 #define I2C3_SCL_PIN (GPIO_PIN_8)
 #define I2C3_SCL_PORT (GPIOA)
 
+/* The thermal bus moves its data with DMA. DMA1 channel 1 belongs to the
+ * internal ADC. */
+#define I2C1_DMA_RX_CHANNEL (DMA1_Channel2)
+#define I2C1_DMA_TX_CHANNEL (DMA1_Channel3)
+
 /** Private typedef */
 
 typedef struct {
@@ -47,6 +52,12 @@ typedef struct {
     StaticSemaphore_t semaphore_data;
     // Buffer for I2C data
     uint8_t buffer[I2C_BUF_MAX];
+    // Whether asynchronous transfers on this bus use DMA
+    bool use_dma;
+    DMA_HandleTypeDef dma_rx;
+    DMA_HandleTypeDef dma_tx;
+    // Called when a transfer that no task is waiting on finishes
+    _Atomic i2c_hardware_complete_callback complete_callback;
 } I2C_Instance;
 
 typedef struct {
@@ -65,7 +76,11 @@ static I2C_Hardware i2c_hardware = {
             .task_to_notify = NULL,
             .semaphore = NULL,
             .semaphore_data = {},
-            .buffer = {0}
+            .buffer = {0},
+            .use_dma = true,
+            .dma_rx = {},
+            .dma_tx = {},
+            .complete_callback = NULL
         },
         {
             .instance = I2C3,
@@ -73,7 +88,11 @@ static I2C_Hardware i2c_hardware = {
             .task_to_notify = NULL,
             .semaphore = NULL,
             .semaphore_data = {},
-            .buffer = {0}
+            .buffer = {0},
+            .use_dma = false,
+            .dma_rx = {},
+            .dma_tx = {},
+            .complete_callback = NULL
         }
     },
     .initialized = false,
@@ -87,7 +106,11 @@ static I2C_Hardware i2c_hardware = {
  * 
  */
 static void i2c_instance_init(I2C_Instance *instance);
-static void handle_i2c_callback(I2C_HandleTypeDef *handle);
+static void i2c_dma_init(I2C_Instance *instance, DMA_Channel_TypeDef *rx,
+                         uint32_t rx_request, DMA_Channel_TypeDef *tx,
+                         uint32_t tx_request, IRQn_Type rx_irq,
+                         IRQn_Type tx_irq);
+static void handle_i2c_callback(I2C_HandleTypeDef *handle, bool success);
 static inline I2C_Instance*
     i2c_get_struct_from_hal_instance(I2C_TypeDef *instance);
 
@@ -328,6 +351,61 @@ bool i2c_hardware_mem_write(I2C_BUS bus, uint16_t addr, uint8_t reg,
     return (notification_val == 1) && (hal_ret == HAL_OK);
 }
 
+void i2c_hardware_set_complete_callback(I2C_BUS bus,
+                                        i2c_hardware_complete_callback callback) {
+    if(!IS_I2C_BUS(bus)) {
+        return;
+    }
+    i2c_hardware.i2c[bus].complete_callback = callback;
+}
+
+bool i2c_hardware_start_transfer(I2C_BUS bus, I2C_TRANSFER_TYPE type,
+                                 uint16_t addr, uint8_t reg, uint8_t *data,
+                                 uint16_t len) {
+    HAL_StatusTypeDef hal_ret = HAL_ERROR;
+
+    if(!IS_I2C_BUS(bus)) {
+        return false;
+    }
+
+    I2C_Instance *instance = &i2c_hardware.i2c[bus];
+    I2C_HandleTypeDef *handle = &instance->handle;
+
+    if(!i2c_hardware.initialized || data == NULL) {
+        return false;
+    }
+
+    switch(type) {
+        case I2C_TRANSFER_WRITE:
+            hal_ret = instance->use_dma
+                ? HAL_I2C_Master_Transmit_DMA(handle, addr, data, len)
+                : HAL_I2C_Master_Transmit_IT(handle, addr, data, len);
+            break;
+        case I2C_TRANSFER_READ:
+            hal_ret = instance->use_dma
+                ? HAL_I2C_Master_Receive_DMA(handle, addr, data, len)
+                : HAL_I2C_Master_Receive_IT(handle, addr, data, len);
+            break;
+        case I2C_TRANSFER_MEM_WRITE:
+            hal_ret = instance->use_dma
+                ? HAL_I2C_Mem_Write_DMA(handle, addr, (uint16_t)reg,
+                                        REGISTER_ADDR_LEN, data, len)
+                : HAL_I2C_Mem_Write_IT(handle, addr, (uint16_t)reg,
+                                       REGISTER_ADDR_LEN, data, len);
+            break;
+        case I2C_TRANSFER_MEM_READ:
+            hal_ret = instance->use_dma
+                ? HAL_I2C_Mem_Read_DMA(handle, addr, (uint16_t)reg,
+                                       REGISTER_ADDR_LEN, data, len)
+                : HAL_I2C_Mem_Read_IT(handle, addr, (uint16_t)reg,
+                                      REGISTER_ADDR_LEN, data, len);
+            break;
+        default:
+            break;
+    }
+    return hal_ret == HAL_OK;
+}
+
 /*
  * Static functions 
  */
@@ -363,14 +441,57 @@ static void i2c_instance_init(I2C_Instance *instance) {
     configASSERT(ret == HAL_OK);
 }
 
+static void i2c_dma_init(I2C_Instance *instance, DMA_Channel_TypeDef *rx,
+                         uint32_t rx_request, DMA_Channel_TypeDef *tx,
+                         uint32_t tx_request, IRQn_Type rx_irq,
+                         IRQn_Type tx_irq) {
+    DMA_HandleTypeDef *dmas[2] = {&instance->dma_rx, &instance->dma_tx};
+
+    __HAL_RCC_DMAMUX1_CLK_ENABLE();
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    instance->dma_rx.Instance = rx;
+    instance->dma_rx.Init.Request = rx_request;
+    instance->dma_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    instance->dma_tx.Instance = tx;
+    instance->dma_tx.Init.Request = tx_request;
+    instance->dma_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    for(uint8_t i = 0; i < 2; ++i) {
+        dmas[i]->Init.PeriphInc = DMA_PINC_DISABLE;
+        dmas[i]->Init.MemInc = DMA_MINC_ENABLE;
+        dmas[i]->Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+        dmas[i]->Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+        dmas[i]->Init.Mode = DMA_NORMAL;
+        dmas[i]->Init.Priority = DMA_PRIORITY_HIGH;
+        if(HAL_DMA_Init(dmas[i]) != HAL_OK) {
+            configASSERT(false);
+        }
+    }
+    __HAL_LINKDMA(&instance->handle, hdmarx, instance->dma_rx);
+    __HAL_LINKDMA(&instance->handle, hdmatx, instance->dma_tx);
+
+    HAL_NVIC_SetPriority(rx_irq, 6, 0);
+    HAL_NVIC_EnableIRQ(rx_irq);
+    HAL_NVIC_SetPriority(tx_irq, 6, 0);
+    HAL_NVIC_EnableIRQ(tx_irq);
+}
+
 // Interrupt handling is the same for every type of transmission
-static void handle_i2c_callback(I2C_HandleTypeDef *handle) {
+static void handle_i2c_callback(I2C_HandleTypeDef *handle, bool success) {
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
     // Need to look up our struct based on the hardware handle...
     I2C_Instance *instance = 
         i2c_get_struct_from_hal_instance(handle->Instance);
-    if( (instance == NULL) ||
-        instance->task_to_notify == NULL ) {
+    if(instance == NULL) {
+        return;
+    }
+    if(instance->task_to_notify == NULL) {
+        // Nobody is blocking on this transfer, so it must belong to the
+        // bus manager
+        i2c_hardware_complete_callback callback = instance->complete_callback;
+        if(callback != NULL) {
+            callback((I2C_BUS)(instance - i2c_hardware.i2c), success);
+        }
         return;
     }
     vTaskNotifyGiveFromISR(instance->task_to_notify, 
@@ -418,6 +539,11 @@ void HAL_I2C_MspInit(I2C_HandleTypeDef* hi2c)
 
         /* Peripheral clock enable */
         __HAL_RCC_I2C1_CLK_ENABLE();
+        /* I2C1 DMA Init */
+        i2c_dma_init(&i2c_hardware.i2c[I2C_BUS_THERMAL],
+                     I2C1_DMA_RX_CHANNEL, DMA_REQUEST_I2C1_RX,
+                     I2C1_DMA_TX_CHANNEL, DMA_REQUEST_I2C1_TX,
+                     DMA1_Channel2_IRQn, DMA1_Channel3_IRQn);
         /* I2C1 interrupt Init */
         HAL_NVIC_SetPriority(I2C1_EV_IRQn, 6, 0);
         HAL_NVIC_EnableIRQ(I2C1_EV_IRQn);
@@ -476,24 +602,24 @@ void HAL_I2C_MspDeInit(I2C_HandleTypeDef* hi2c)
 /** Overwritten HAL functions */
 
 void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *i2c_handle){
-    handle_i2c_callback(i2c_handle);
+    handle_i2c_callback(i2c_handle, true);
 }
 
 void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *i2c_handle){
-    handle_i2c_callback(i2c_handle);
+    handle_i2c_callback(i2c_handle, true);
 }
 
 void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c) {
-    handle_i2c_callback(hi2c);
+    handle_i2c_callback(hi2c, true);
 }
 
 void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c) {
-    handle_i2c_callback(hi2c);
+    handle_i2c_callback(hi2c, true);
 }
 
 void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *i2c_handle)
 {
-    handle_i2c_callback(i2c_handle);
+    handle_i2c_callback(i2c_handle, false);
 }
 
 /** Interrupt handlers */
@@ -508,6 +634,16 @@ void I2C1_ER_IRQHandler(void)
     HAL_I2C_ER_IRQHandler(&i2c_hardware.i2c[I2C_BUS_THERMAL].handle);
 }
 
+void DMA1_Channel2_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&i2c_hardware.i2c[I2C_BUS_THERMAL].dma_rx);
+}
+
+void DMA1_Channel3_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&i2c_hardware.i2c[I2C_BUS_THERMAL].dma_tx);
+}
+
 void I2C3_EV_IRQHandler(void)
 {
     HAL_I2C_EV_IRQHandler(&i2c_hardware.i2c[I2C_BUS_LED].handle);
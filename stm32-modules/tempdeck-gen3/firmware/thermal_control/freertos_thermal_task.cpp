@@ -1,6 +1,6 @@
 #include "firmware/freertos_thermal_task.hpp"
 
-#include "firmware/i2c_hardware.h"
+#include "firmware/i2c_bus_hardware.hpp"
 #include "firmware/tachometer_hardware.h"
 #include "firmware/thermal_hardware.h"
 #include "firmware/thermal_policy.hpp"
@@ -28,7 +28,7 @@ auto run(tasks::FirmwareTasks::QueueAggregator* aggregator) -> void {
     _top_task.provide_aggregator(aggregator);
 
     thermal_hardware_init();
-    i2c_hardware_init();
+    i2c_bus_hardware::initialize();
     tachometer_hardware_init();
 
     auto policy = thermal_policy::ThermalPolicy();
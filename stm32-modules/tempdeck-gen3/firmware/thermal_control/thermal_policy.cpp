@@ -1,6 +1,5 @@
 #include "firmware/thermal_policy.hpp"
 
-#include "firmware/i2c_hardware.h"
 #include "firmware/tachometer_hardware.h"
 #include "firmware/thermal_hardware.h"
 
@@ -40,9 +39,20 @@ auto ThermalPolicy::set_write_protect(bool set) -> void {
     thermal_hardware_set_eeprom_write_protect(set);
 }
 
-// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
 auto ThermalPolicy::i2c_write(uint8_t addr, uint8_t data) -> bool {
-    return i2c_hardware_write_data(I2C_BUS_THERMAL, addr, &data, 1);
+    _byte = data;
+    return eeprom_transfer(i2c_bus::Type::WRITE, addr, &_byte, 1);
+}
+
+auto ThermalPolicy::eeprom_transfer(i2c_bus::Type type, uint8_t addr,
+                                    uint8_t* data, size_t length) -> bool {
+    return _transfer.run(
+        i2c_bus_hardware::thermal_bus(),
+        i2c_bus::Transaction{.type = type,
+                             .priority = i2c_bus::Priority::BACKGROUND,
+                             .address = addr,
+                             .data = data,
+                             .length = static_cast<uint16_t>(length)});
 }
 
 }  // namespace thermal_policy
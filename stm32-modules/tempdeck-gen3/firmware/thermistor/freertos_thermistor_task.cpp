@@ -1,7 +1,7 @@
 #include "firmware/freertos_thermistor_task.hpp"
 
 #include "FreeRTOS.h"
-#include "firmware/i2c_hardware.h"
+#include "firmware/i2c_bus_hardware.hpp"
 #include "firmware/internal_adc_hardware.h"
 #include "firmware/thermistor_hardware.h"
 #include "firmware/thermistor_policy.hpp"
@@ -25,7 +25,7 @@ auto run(tasks::FirmwareTasks::QueueAggregator* aggregator) -> void {
                   "FreeRTOS tickrate must be at 1000 Hz");
 
     thermistor_hardware_init();
-    i2c_hardware_init();
+    i2c_bus_hardware::initialize();
     internal_adc_init();
 
     // Thermistor task has no queue, just need to provide aggregator handle
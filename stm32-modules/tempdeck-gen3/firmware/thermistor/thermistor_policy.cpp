@@ -2,7 +2,7 @@
 #include "firmware/thermistor_policy.hpp"
 
 #include "FreeRTOS.h"
-#include "firmware/i2c_hardware.h"
+#include "firmware/i2c_bus_hardware.hpp"
 #include "firmware/internal_adc_hardware.h"
 #include "firmware/thermistor_hardware.h"
 #include "semphr.h"
@@ -35,18 +35,36 @@ auto ThermistorPolicy::ads1115_arm_for_read() -> bool {
     return thermal_arm_adc_for_read();
 }
 
-// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
 auto ThermistorPolicy::ads1115_i2c_write_16(uint8_t reg, uint16_t data)
     -> bool {
-    return i2c_hardware_write_16(I2C_BUS_THERMAL, ADC_ADDRESS, reg, data);
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+    _buffer[0] = static_cast<uint8_t>((data >> 8) & 0xFF);
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+    _buffer[1] = static_cast<uint8_t>(data & 0xFF);
+    return _transfer.run(
+        i2c_bus_hardware::thermal_bus(),
+        i2c_bus::Transaction{.type = i2c_bus::Type::MEM_WRITE,
+                             .priority = i2c_bus::Priority::SENSOR,
+                             .address = ADC_ADDRESS,
+                             .mem_address = reg,
+                             .data = _buffer.data(),
+                             .length = static_cast<uint16_t>(_buffer.size())});
 }
 
-// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
 auto ThermistorPolicy::ads1115_i2c_read_16(uint8_t reg)
     -> std::optional<uint16_t> {
-    uint16_t data = 0;
-    if (i2c_hardware_read_16(I2C_BUS_THERMAL, ADC_ADDRESS, reg, &data)) {
-        return std::optional<uint16_t>(data);
+    auto ret = _transfer.run(
+        i2c_bus_hardware::thermal_bus(),
+        i2c_bus::Transaction{.type = i2c_bus::Type::MEM_READ,
+                             .priority = i2c_bus::Priority::SENSOR,
+                             .address = ADC_ADDRESS,
+                             .mem_address = reg,
+                             .data = _buffer.data(),
+                             .length = static_cast<uint16_t>(_buffer.size())});
+    if (ret) {
+        // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+        return std::optional<uint16_t>(
+            static_cast<uint16_t>((_buffer[0] << 8) | _buffer[1]));
     }
     return std::nullopt;
 }
@@ -7,6 +7,7 @@
 #include <memory>
 #include <string>
 
+#include "simulator/sim_clock.hpp"
 #include "simulator/sim_driver.hpp"
 #include "simulator/socket_sim_driver.hpp"
 #include "simulator/stdin_sim_driver.hpp"
@@ -43,7 +44,7 @@ using namespace cli_parser;
     exit(1);
 }
 
-RT cli_parser::get_sim_driver(int num_args, char* args[]) {
+RT cli_parser::get_sim_driver(int num_args, char* args[], double& speedup) {
     bool use_stdin = false;
     bool use_socket = false;
     bool realtime = false;
@@ -57,7 +58,13 @@ RT cli_parser::get_sim_driver(int num_args, char* args[]) {
                                             std::string>(),
                                         "Use socket to provide G-Codes")
         ("realtime", boost::program_options::bool_switch(&realtime),
-         "Thermal and motor data should run in real time");
+         "Thermal and motor data should run in real time")(
+            "speedup",
+            boost::program_options::value<double>(&speedup)->default_value(
+                sim_clock::SimClock::LOCKSTEP),
+            "Run the simulated clock this many times faster than real time, "
+            "instead of in lockstep with the tasks. Runs at a speedup are "
+            "not repeatable");
 
     boost::program_options::variables_map vm;
     /*
@@ -86,6 +93,13 @@ RT cli_parser::get_sim_driver(int num_args, char* args[]) {
     if (use_stdin && use_socket) {
         both_drivers_specified_error(desc);
     }
+    if (speedup < sim_clock::SimClock::LOCKSTEP) {
+        std::cerr << std::endl
+                  << "ERROR: --speedup can't be negative" << std::endl
+                  << std::endl;
+        std::cerr << desc << std::endl;
+        exit(1);
+    }
 
     if (use_stdin) {
         return RT(std::make_shared<stdin_sim_driver::StdinSimDriver>(),
@@ -1,29 +1,24 @@
 #include "simulator/cli_parser.hpp"
+#include "simulator/sim_clock.hpp"
 #include "simulator/sim_driver.hpp"
+#include "simulator/sim_worker_pool.hpp"
 #include "simulator/simulator_tasks.hpp"
 
+// Threads shared by the tasks
+static constexpr size_t SIMULATOR_WORKERS = 2;
+
 auto main(int argc, char* argv[]) -> int {
-    auto cli_ret = cli_parser::get_sim_driver(argc, argv);
+    auto speedup = sim_clock::SimClock::LOCKSTEP;
+    auto cli_ret = cli_parser::get_sim_driver(argc, argv, speedup);
     auto sim_driver = cli_ret.first;
+    auto realtime =
+        cli_ret.second || cli_parser::check_realtime_environment_variable();
+    auto clock = std::make_shared<sim_clock::SimClock>(
+        realtime ? sim_clock::SimClock::REALTIME : speedup);
+    auto pool = sim_worker_pool::WorkerPool(clock, SIMULATOR_WORKERS);
 
-    auto comms_queue = std::make_shared<tasks::SimTasks::HostCommsQueue>();
-    auto system_queue = std::make_shared<tasks::SimTasks::SystemQueue>();
-    auto ui_queue = std::make_shared<tasks::SimTasks::UIQueue>();
-    auto thermal_queue = std::make_shared<tasks::SimTasks::ThermalQueue>();
-
-    auto aggregator = std::make_shared<tasks::SimTasks::QueueAggregator>(
-        *comms_queue, *system_queue, *ui_queue, *thermal_queue);
-
-    auto comms = std::make_unique<std::jthread>(
-        tasks::run_comms_task, comms_queue, aggregator, sim_driver);
-    auto system = std::make_unique<std::jthread>(tasks::run_system_task,
-                                                 system_queue, aggregator);
-    auto ui = std::make_unique<std::jthread>(tasks::run_ui_task, ui_queue,
-                                             aggregator);
-    auto thermal = std::make_unique<std::jthread>(tasks::run_thermal_task,
-                                                  thermal_queue, aggregator);
-    auto thermistor =
-        std::make_unique<std::jthread>(tasks::run_thermistor_task, aggregator);
+    auto aggregator = tasks::add_to_pool(pool, sim_driver);
+    pool.start();
 
     auto send_to_comms = [&aggregator](messages::IncomingMessageFromHost& msg) {
         aggregator->send(msg);
@@ -31,17 +26,7 @@ auto main(int argc, char* argv[]) -> int {
     sim_driver->read(std::move(send_to_comms));
 
     // Previous line returns when connection is closed
-    comms->request_stop();
-    system->request_stop();
-    ui->request_stop();
-    thermal->request_stop();
-    thermistor->request_stop();
-
-    comms->join();
-    system->join();
-    ui->join();
-    thermal->join();
-    thermistor->join();
+    pool.stop();
 
     return 0;
 }
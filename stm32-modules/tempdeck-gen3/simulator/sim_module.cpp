@@ -0,0 +1,47 @@
+/*
+ * The Tempdeck simulator as a plugin for the sim host, which runs it
+ * alongside other simulated modules on a shared worker pool.
+ */
+#include <boost/system/system_error.hpp>
+#include <memory>
+
+#include "simulator/sim_driver.hpp"
+#include "simulator/sim_module.hpp"
+#include "simulator/sim_worker_pool.hpp"
+#include "simulator/simulator_tasks.hpp"
+#include "simulator/socket_sim_driver.hpp"
+
+namespace {
+
+class TempdeckModule : public sim_module::SimModule {
+  public:
+    TempdeckModule(sim_worker_pool::WorkerPool& pool,
+                   std::shared_ptr<sim_driver::SimDriver> driver)
+        : _driver(std::move(driver)),
+          _aggregator(tasks::add_to_pool(pool, _driver)) {}
+
+    auto read_input() -> void override {
+        auto send_to_comms = [this](messages::IncomingMessageFromHost& msg) {
+            _aggregator->send(msg);
+        };
+        try {
+            _driver->read(std::move(send_to_comms));
+        } catch (const boost::system::system_error&) {
+            // The socket closing ends the read; the other modules keep
+            // running
+        }
+    }
+
+  private:
+    std::shared_ptr<sim_driver::SimDriver> _driver;
+    std::shared_ptr<tasks::SimTasks::QueueAggregator> _aggregator;
+};
+
+}  // namespace
+
+SIM_MODULE_EXPORT auto sim_module_add(sim_worker_pool::WorkerPool& pool,
+                                      const char* socket)
+    -> sim_module::SimModule* {
+    return new TempdeckModule(
+        pool, std::make_shared<socket_sim_driver::SocketSimDriver>(socket));
+}
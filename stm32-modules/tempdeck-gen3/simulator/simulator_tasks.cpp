@@ -12,86 +12,78 @@
 
 using namespace tasks;
 
-auto tasks::run_comms_task(
-    std::stop_token st, std::shared_ptr<SimTasks::HostCommsQueue> queue_ptr,
-    std::shared_ptr<SimTasks::QueueAggregator> aggregator,
-    std::shared_ptr<sim_driver::SimDriver> driver) -> void {
-    auto &queue = *queue_ptr;
-    auto task = host_comms_task::HostCommsTask(queue, aggregator.get());
-    std::string buffer(1024, 'c');
+namespace {
 
-    queue.set_stop_token(st);
-    while (!st.stop_requested()) {
-        try {
-            auto wrote_to = task.run_once(buffer.begin(), buffer.end());
-            driver->write(std::string(buffer.begin(), wrote_to));
-        } catch (const SimTasks::HostCommsQueue::StopDuringMsgWait sdmw) {
-            return;
-        }
-    }
-}
-
-auto tasks::run_system_task(
-    std::stop_token st, std::shared_ptr<SimTasks::SystemQueue> queue_ptr,
-    std::shared_ptr<SimTasks::QueueAggregator> aggregator) -> void {
-    auto &queue = *queue_ptr;
-    auto policy = SimSystemPolicy();
-    auto task = system_task::SystemTask(queue, aggregator.get());
+// Everything one pooled Tempdeck needs, kept alive by the pool's jobs
+struct PooledTempdeck {
+    using HostCommsTask = host_comms_task::HostCommsTask<SimulatorMessageQueue>;
+    using SystemTask = system_task::SystemTask<SimulatorMessageQueue>;
+    using UITask = ui_task::UITask<SimulatorMessageQueue>;
+    using ThermalTask = thermal_task::ThermalTask<SimulatorMessageQueue>;
+    using ThermistorTask =
+        thermistor_task::ThermistorTask<SimulatorMessageQueue>;
 
-    queue.set_stop_token(st);
-    while (!st.stop_requested()) {
-        try {
-            task.run_once(policy);
-        } catch (const SimTasks::SystemQueue::StopDuringMsgWait sdmw) {
-            return;
-        }
-    }
-}
+    PooledTempdeck(std::shared_ptr<sim_driver::SimDriver> driver,
+                   std::shared_ptr<sim_clock::SimClock> clock)
+        : driver(std::move(driver)),
+          aggregator(std::make_shared<SimTasks::QueueAggregator>(
+              comms_queue, system_queue, ui_queue, thermal_queue)),
+          thermal_policy(model),
+          thermistor_policy(model, std::move(clock)),
+          comms(comms_queue, aggregator.get()),
+          system(system_queue, aggregator.get()),
+          ui(ui_queue, aggregator.get()),
+          thermal(thermal_queue, aggregator.get()),
+          thermistor(aggregator.get()) {}
 
-auto tasks::run_ui_task(std::stop_token st,
-                        std::shared_ptr<SimTasks::UIQueue> queue_ptr,
-                        std::shared_ptr<SimTasks::QueueAggregator> aggregator)
-    -> void {
-    auto &queue = *queue_ptr;
-    auto policy = SimUIPolicy();
-    auto task = ui_task::UITask(queue, aggregator.get());
+    std::shared_ptr<sim_driver::SimDriver> driver;
+    std::string buffer = std::string(1024, 'c');
+    SimTasks::HostCommsQueue comms_queue{};
+    SimTasks::SystemQueue system_queue{};
+    SimTasks::UIQueue ui_queue{};
+    SimTasks::ThermalQueue thermal_queue{};
+    std::shared_ptr<SimTasks::QueueAggregator> aggregator;
+    std::shared_ptr<SimThermalModel> model =
+        std::make_shared<SimThermalModel>();
+    SimSystemPolicy system_policy{};
+    SimUIPolicy ui_policy{};
+    SimThermalPolicy thermal_policy;
+    SimThermistorPolicy thermistor_policy;
+    HostCommsTask comms;
+    SystemTask system;
+    UITask ui;
+    ThermalTask thermal;
+    ThermistorTask thermistor;
+};
 
-    queue.set_stop_token(st);
-    while (!st.stop_requested()) {
-        try {
-            task.run_once(policy);
-        } catch (const SimTasks::UIQueue::StopDuringMsgWait sdmw) {
-            return;
-        }
-    }
-}
-
-auto tasks::run_thermal_task(
-    std::stop_token st, std::shared_ptr<SimTasks::ThermalQueue> queue_ptr,
-    std::shared_ptr<SimTasks::QueueAggregator> aggregator) -> void {
-    auto &queue = *queue_ptr;
-    auto policy = SimThermalPolicy();
-    auto task = thermal_task::ThermalTask(queue, aggregator.get());
-
-    queue.set_stop_token(st);
-    while (!st.stop_requested()) {
-        try {
-            task.run_once(policy);
-        } catch (const SimTasks::ThermalQueue::StopDuringMsgWait sdmw) {
-            return;
-        }
-    }
-}
+}  // namespace
 
-auto tasks::run_thermistor_task(
-    std::stop_token st, std::shared_ptr<SimTasks::QueueAggregator> aggregator)
-    -> void {
-    auto policy = SimThermistorPolicy();
-    auto task = thermistor_task::ThermistorTask<SimulatorMessageQueue>(
-        aggregator.get());
+auto tasks::add_to_pool(sim_worker_pool::WorkerPool &pool,
+                        std::shared_ptr<sim_driver::SimDriver> driver)
+    -> std::shared_ptr<SimTasks::QueueAggregator> {
+    using ThermistorTask = PooledTempdeck::ThermistorTask;
+    static constexpr double READ_PERIOD_S =
+        static_cast<double>(ThermistorTask::THERMISTOR_READ_PERIOD_MS) / 1000.0;
+    auto td = std::make_shared<PooledTempdeck>(std::move(driver), pool.clock());
 
-    while (!st.stop_requested()) {
-        policy.sleep_ms(100);
-        task.run_once(policy);
-    }
+    pool.add([td]() { return td->comms_queue.has_message(); },
+             [td]() {
+                 auto wrote_to =
+                     td->comms.run_once(td->buffer.begin(), td->buffer.end());
+                 td->driver->write(std::string(td->buffer.begin(), wrote_to));
+             });
+    pool.add([td]() { return td->system_queue.has_message(); },
+             [td]() { td->system.run_once(td->system_policy); });
+    pool.add([td]() { return td->ui_queue.has_message(); },
+             [td]() { td->ui.run_once(td->ui_policy); });
+    pool.add([td]() { return td->thermal_queue.has_message(); },
+             [td]() { td->thermal.run_once(td->thermal_policy); });
+    // Each read steps the model by a read period first. In lockstep, the
+    // pool doesn't move the clock on to the next read until the thermal task
+    // has handled this one.
+    pool.add_periodic(ThermistorTask::THERMISTOR_READ_PERIOD_MS, [td]() {
+        td->model->step(READ_PERIOD_S);
+        td->thermistor.run_once(td->thermistor_policy);
+    });
+    return td->aggregator;
 }
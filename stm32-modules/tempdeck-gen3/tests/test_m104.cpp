@@ -51,6 +51,26 @@ SCENARIO("SetTemperature (M104) parser works", "[gcode][parse][m104]") {
                              Catch::Matchers::WithinAbs(-5.5, 0.001));
             }
         }
+        WHEN("Setting a target with a ramp rate") {
+            std::string buffer = "M104 S40 R0.5\n";
+            auto parsed =
+                gcode::SetTemperature::parse(buffer.begin(), buffer.end());
+            THEN("the ramp rate is parsed succesfully") {
+                auto &val = parsed.first;
+                REQUIRE(val.has_value());
+                REQUIRE(val.value().target == 40.0f);
+                REQUIRE(val.value().ramp_rate == 0.5f);
+            }
+        }
+        WHEN("Setting a target without a ramp rate") {
+            std::string buffer = "M104 S40\n";
+            auto parsed =
+                gcode::SetTemperature::parse(buffer.begin(), buffer.end());
+            THEN("the setpoint jumps to the target") {
+                REQUIRE(parsed.first.has_value());
+                REQUIRE(parsed.first.value().ramp_rate == 0.0f);
+            }
+        }
     }
     GIVEN("Invalid parameters") {
         WHEN("no target is provided") {
@@ -62,6 +82,15 @@ SCENARIO("SetTemperature (M104) parser works", "[gcode][parse][m104]") {
                 REQUIRE(parsed.second == buffer.begin());
             }
         }
+        WHEN("a negative ramp rate is provided") {
+            std::string buffer = "M104 S40 R-1\n";
+            auto parsed =
+                gcode::SetTemperature::parse(buffer.begin(), buffer.end());
+            THEN("Nothing should be parsed") {
+                REQUIRE(!parsed.first.has_value());
+                REQUIRE(parsed.second == buffer.begin());
+            }
+        }
         WHEN("no argument is provided") {
             std::string buffer = "M104    \n";
             auto parsed =
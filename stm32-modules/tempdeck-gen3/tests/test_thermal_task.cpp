@@ -468,6 +468,33 @@ TEST_CASE("closed loop thermal control") {
             }
         }
     }
+    WHEN("setting temp target to 35ºC with a 0.5ºC/s ramp") {
+        auto target_msg = messages::SetTemperatureMessage{
+            .id = 123, .target = 35, .ramp_rate = 0.5};
+        tasks->_thermal_queue.backing_deque.push_back(target_msg);
+        tasks->_thermal_task.run_once(policy);
+        auto start = tasks->_thermal_task.get_ramp().setpoint();
+        THEN("the ramp starts at the plate temperature") {
+            REQUIRE(tasks->_thermal_task.get_ramp().ramping());
+            REQUIRE_THAT(start, Catch::Matchers::WithinAbs(25, 1.0));
+            REQUIRE(tasks->_thermal_task.get_peltier().target == 35);
+        }
+        AND_WHEN("temperature readings are updated for a second") {
+            for (int i = 0; i < 10; ++i) {
+                temp_message.timestamp += timestamp_increment;
+                tasks->_thermal_queue.backing_deque.push_back(temp_message);
+                tasks->_thermal_task.run_once(policy);
+            }
+            THEN("the setpoint has ramped by 0.5ºC") {
+                REQUIRE_THAT(tasks->_thermal_task.get_ramp().setpoint(),
+                             Catch::Matchers::WithinAbs(start + 0.5, 0.001));
+            }
+            THEN("the peltiers heat towards the ramped setpoint") {
+                REQUIRE(policy._enabled);
+                REQUIRE(policy.is_heating());
+            }
+        }
+    }
     WHEN("setting temp target to -4ºC") {
         auto target_msg =
             messages::SetTemperatureMessage{.id = 123, .target = -4};
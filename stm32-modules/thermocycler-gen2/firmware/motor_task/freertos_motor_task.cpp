@@ -52,6 +52,11 @@ static void handle_lid_stepper() {
         messages::MotorMessage(messages::LidStepperComplete{})));
 }
 
+/** @brief This function is called before every lid motor step.*/
+static auto handle_lid_rate() -> float {
+    return _policy.lid_stepper_next_rpm();
+}
+
 /** @brief This function is called for every seal motor tick, at 1MHz.*/
 static void handle_seal_interrupt() { _policy.seal_tick(); }
 
@@ -106,7 +111,8 @@ void run(void *param) {
         .lid_stepper_complete = handle_lid_stepper,
         .seal_stepper_tick = handle_seal_interrupt,
         .seal_stepper_error = handle_seal_error,
-        .seal_stepper_limit_switch = handle_seal_limit_switch};
+        .seal_stepper_limit_switch = handle_seal_limit_switch,
+        .lid_stepper_rate = handle_lid_rate};
     motor_hardware_setup(&callbacks);
     while (true) {
         _task.run_once(_policy);
@@ -101,8 +101,10 @@ extern "C" {
  */
 #define LID_RPM_TO_FREQ(rpm) ((rpm * 1280) / 3)
 
-/** Above this speed, will get skipping */
+/** Above this speed, will get skipping when starting a movement */
 #define LID_RPM_MAX (125)
+/** Movements that accelerate can reach this speed */
+#define LID_PROFILE_RPM_MAX (250)
 /** Below this speed reduces torque */
 #define LID_RPM_MIN (10)
 
@@ -120,6 +122,10 @@ typedef struct lid_hardware_struct {
     int32_t step_count;
     // Target step count for the lid
     int32_t step_target;
+    // Speed of steps that the rate callback doesn't set
+    float rpm;
+    // Clock of the lid timer, after the prescaler
+    uint32_t timer_clock;
     // Timer for the lid motor
     TIM_HandleTypeDef timer;
     // DAC for lid current control
@@ -163,7 +169,8 @@ static motor_hardware_t _motor_hardware = {
         .lid_stepper_complete = NULL,
         .seal_stepper_tick = NULL,
         .seal_stepper_error = NULL,
-        .seal_stepper_limit_switch = NULL
+        .seal_stepper_limit_switch = NULL,
+        .lid_stepper_rate = NULL
     },
     .lid_stepper = {
         .moving = false,
@@ -171,6 +178,8 @@ static motor_hardware_t _motor_hardware = {
         .overdrive = false,
         .step_count = 0,
         .step_target = 0,
+        .rpm = LID_RPM_MAX,
+        .timer_clock = 0,
         .timer = {0},
         .dac = {0}
     },
@@ -193,6 +202,8 @@ static void init_dac1(DAC_HandleTypeDef* hdac);
 static void init_tim2(TIM_HandleTypeDef* htim);
 static void init_tim6(TIM_HandleTypeDef* htim);
 static bool lid_active();
+static void lid_stepper_set_period(float rpm);
+static void lid_stepper_update_rate(void);
 
 // ----------------------------------------------------------------------------
 // Public function implementation
@@ -239,6 +250,10 @@ void motor_hardware_lid_stepper_start(int32_t steps, bool overdrive) {
         HAL_GPIO_WritePin(LID_STEPPER_CONTROL_Port, LID_STEPPER_DIR_Pin, GPIO_PIN_RESET);
     }
 
+    // Start at the set speed, unless the rate callback sets a speed
+    lid_stepper_set_period(_motor_hardware.lid_stepper.rpm);
+    lid_stepper_update_rate();
+
     HAL_TIM_OC_Start_IT(&_motor_hardware.lid_stepper.timer, LID_STEPPER_STEP_Channel);
 }
 
@@ -272,6 +287,9 @@ void motor_hardware_lid_increment() {
     if(done) {
         motor_hardware_lid_stepper_stop();
         _motor_hardware.callbacks.lid_stepper_complete();
+    } else if((_motor_hardware.lid_stepper.step_count & 1) == 0) {
+        // A full step just finished, so set the speed of the next one
+        lid_stepper_update_rate();
     }
 }
 
@@ -302,13 +320,8 @@ bool motor_hardware_lid_stepper_set_rpm(double rpm) {
         return false;
     }
 
-    /* Compute TIM2 clock */
-    uint32_t uwTimClock = HAL_RCC_GetPCLK1Freq();
-    uint32_t uwPeriodValue = __HAL_TIM_CALC_PERIOD(
-                uwTimClock, 
-                _motor_hardware.lid_stepper.timer.Init.Prescaler, 
-                LID_RPM_TO_FREQ(rpm));
-    __HAL_TIM_SET_AUTORELOAD(&_motor_hardware.lid_stepper.timer, uwPeriodValue);
+    _motor_hardware.lid_stepper.rpm = (float)rpm;
+    lid_stepper_set_period(_motor_hardware.lid_stepper.rpm);
     
     return true;
 }
@@ -576,6 +589,7 @@ static void init_tim2(TIM_HandleTypeDef* htim) {
     /* Compute the prescaler value to have TIM2 counter clock equal to 1MHz */
     uint32_t uwPrescalerValue = (uint32_t) ((uwTimClock / 1000000U) - 1U);
     uint32_t uwPeriodValue = __HAL_TIM_CALC_PERIOD(uwTimClock, uwPrescalerValue, LID_RPM_TO_FREQ(125));
+    _motor_hardware.lid_stepper.timer_clock = uwTimClock / (uwPrescalerValue + 1U);
     
     htim->Instance = TIM2;
     htim->Init.Prescaler = uwPrescalerValue;
@@ -617,6 +631,31 @@ static void init_tim6(TIM_HandleTypeDef* htim) {
     configASSERT(hal_ret == HAL_OK);
 }
 
+// Set the timer period for a speed. The autoreload is preloaded, so this
+// takes effect from the next timer update and is safe while moving.
+static void lid_stepper_set_period(float rpm) {
+    if(rpm > LID_PROFILE_RPM_MAX) {
+        rpm = LID_PROFILE_RPM_MAX;
+    }
+    if(rpm < LID_RPM_MIN) {
+        rpm = LID_RPM_MIN;
+    }
+    uint32_t period = (uint32_t)(
+        (float)_motor_hardware.lid_stepper.timer_clock / LID_RPM_TO_FREQ(rpm));
+    __HAL_TIM_SET_AUTORELOAD(&_motor_hardware.lid_stepper.timer, period - 1U);
+}
+
+// Ask the rate callback for the speed of the next step
+static void lid_stepper_update_rate(void) {
+    if(_motor_hardware.callbacks.lid_stepper_rate == NULL) {
+        return;
+    }
+    float rpm = _motor_hardware.callbacks.lid_stepper_rate();
+    if(rpm > 0.0F) {
+        lid_stepper_set_period(rpm);
+    }
+}
+
 static bool lid_active() {
     return TIM_CHANNEL_STATE_GET
         (&(_motor_hardware.lid_stepper.timer), LID_STEPPER_STEP_Channel) 
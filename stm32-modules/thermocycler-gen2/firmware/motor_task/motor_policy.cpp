@@ -1,6 +1,7 @@
 #include "firmware/motor_policy.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cstdlib>
 
 #include "FreeRTOS.h"
@@ -17,12 +18,16 @@ MotorPolicy::MotorPolicy(bool shared_seal_switch_lines)
       _shared_seal_switch_lines(shared_seal_switch_lines) {}
 
 MotorPolicy::MotorPolicy(MotorPolicy&& other) noexcept
-    : _seal_callback(std::move(other._seal_callback)),
-      _shared_seal_switch_lines(other._shared_seal_switch_lines) {}
+    : _seal_callback(other._seal_callback),
+      _shared_seal_switch_lines(other._shared_seal_switch_lines),
+      _next_lid_profile(other._next_lid_profile),
+      _lid_profile(other._lid_profile) {}
 
 auto MotorPolicy::operator=(MotorPolicy&& other) noexcept -> MotorPolicy& {
-    _seal_callback = std::move(other._seal_callback);
+    _seal_callback = other._seal_callback;
     _shared_seal_switch_lines = other._shared_seal_switch_lines;
+    _next_lid_profile = other._next_lid_profile;
+    _lid_profile = other._lid_profile;
     return *this;
 }
 
@@ -32,8 +37,17 @@ auto MotorPolicy::lid_stepper_set_dac(uint8_t dac_val) -> void {
     motor_hardware_lid_stepper_set_dac(dac_val);
 }
 
-// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+auto MotorPolicy::lid_stepper_set_profile(
+    const motor_util::LidProfile& profile) -> void {
+    _next_lid_profile = profile;
+}
+
 auto MotorPolicy::lid_stepper_start(int32_t steps, bool overdrive) -> void {
+    // The lid isn't moving, so the interrupt won't read the profile while
+    // it changes. A profile only ever applies to one movement.
+    _lid_profile = overdrive ? motor_util::LidProfile() : _next_lid_profile;
+    _lid_profile.reset();
+    _next_lid_profile = motor_util::LidProfile();
     motor_hardware_lid_stepper_start(steps, overdrive);
 }
 
@@ -77,8 +91,8 @@ auto MotorPolicy::lid_read_open_switch() -> bool {
     return motor_hardware_lid_read_open();
 }
 
-auto MotorPolicy::seal_stepper_start(std::function<void()> callback) -> bool {
-    _seal_callback = std::move(callback);
+auto MotorPolicy::seal_stepper_start(Callback callback) -> bool {
+    _seal_callback = callback;
     return motor_hardware_start_seal_movement();
 }
 
@@ -97,6 +111,22 @@ auto MotorPolicy::tmc2130_transmit_receive(tmc2130::MessageT& data)
     return RxTxReturn();
 }
 // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+auto MotorPolicy::tmc2130_transmit_receive_batch(
+    std::span<tmc2130::MessageT> batch) -> bool {
+    std::array<tmc2130::MessageT, tmc2130::MAX_BATCH + 1> received{};
+    if (batch.size() > received.size()) {
+        return false;
+    }
+    if (!motor_spi_sendreceive_batch(batch.front().data(),
+                                     received.front().data(), batch.size(),
+                                     tmc2130::MESSAGE_LEN)) {
+        return false;
+    }
+    std::copy(received.begin(), received.begin() + batch.size(),
+              batch.begin());
+    return true;
+}
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
 auto MotorPolicy::tmc2130_set_enable(bool enable) -> bool {
     return motor_hardware_set_seal_enable(enable);
 }
@@ -33,6 +33,13 @@
 #define MOTOR_SPI_NSS_PIN (GPIO_PIN_15)
 /** Maximum length of a SPI transaction is 5 bytes.*/
 #define MOTOR_MAX_SPI_LEN (5)
+/**
+ * Time the chip select stays high between datagrams, in nanoseconds. The
+ * TMC2130 only latches a datagram on the rising edge of CSN, and needs CSN
+ * high for a cycle of its internal clock (tCSH) before the next one starts.
+ * 1us covers that with margin.
+ */
+#define MOTOR_SPI_CSN_HIGH_NS (1000)
 
 /** Get a single byte out of a 64 bit value. Higher values are
  *  more significant (0 = LSB, 3 = MSB)*/
@@ -45,23 +52,43 @@ struct motor_spi_hardware {
     SPI_HandleTypeDef handle;
     TaskHandle_t task_to_notify;
     bool initialized;
+    /** The rest of the batch being sent, if any.*/
+    uint8_t *batch_in;
+    uint8_t *batch_out;
+    size_t batch_remaining;
+    size_t batch_len;
+    /** MOTOR_SPI_CSN_HIGH_NS in core clock cycles.*/
+    uint32_t csn_high_cycles;
 };
 
 // STATIC VARIABLES
 static struct motor_spi_hardware _spi = {
     .handle = {0},
     .task_to_notify =  NULL,
-    .initialized = false
+    .initialized = false,
+    .batch_in = NULL,
+    .batch_out = NULL,
+    .batch_remaining = 0,
+    .batch_len = 0,
+    .csn_high_cycles = 0,
 };
 
 // STATIC FUNCTION DEFINITIONS
 static void spi_interrupt_service(void);
 static void spi_set_nss(bool selected);
+static void csn_high_delay(void);
 
 // PUBLIC FUNCTION IMPLEMENTATION
 
 void motor_spi_initialize(void) {
     if(!_spi.initialized) {
+        // The chip select delay counts core clock cycles
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+        _spi.csn_high_cycles = (uint32_t)(
+            ((uint64_t)SystemCoreClock * MOTOR_SPI_CSN_HIGH_NS + 999999999ULL) /
+            1000000000ULL);
+
         HAL_StatusTypeDef ret;
         _spi.handle.Instance = SPI2;
         _spi.handle.Init.Mode = SPI_MODE_MASTER;
@@ -122,6 +149,42 @@ bool motor_spi_sendreceive(uint8_t *in, uint8_t *out, size_t len) {
     return true;
 }
 
+bool motor_spi_sendreceive_batch(uint8_t *in, uint8_t *out, size_t count,
+                                 size_t len) {
+    const TickType_t max_block_time = pdMS_TO_TICKS(100);
+    HAL_StatusTypeDef ret;
+    uint32_t notification_val = 0;
+
+    if(!_spi.initialized || (_spi.task_to_notify != NULL) || (len > MOTOR_MAX_SPI_LEN)) {
+        return false;
+    }
+    if(count == 0) {
+        return true;
+    }
+    _spi.batch_in = in + len;
+    _spi.batch_out = out + len;
+    _spi.batch_remaining = count - 1;
+    _spi.batch_len = len;
+    spi_set_nss(true);
+    _spi.task_to_notify = xTaskGetCurrentTaskHandle();
+    ret = HAL_SPI_TransmitReceive_IT(&_spi.handle, in, out, len);
+    if(ret != HAL_OK) {
+        _spi.task_to_notify = NULL;
+        _spi.batch_remaining = 0;
+        spi_set_nss(false);
+        return false;
+    }
+    notification_val = ulTaskNotifyTake(pdTRUE, max_block_time);
+    spi_set_nss(false);
+    if((notification_val != 1) || (_spi.handle.RxXferCount > 0) ||
+       (_spi.batch_remaining > 0)) {
+        _spi.task_to_notify = NULL;
+        _spi.batch_remaining = 0;
+        return false;
+    }
+    return true;
+}
+
 void SPI2_IRQHandler(void)
 {
   HAL_SPI_IRQHandler(&_spi.handle);
@@ -140,16 +203,43 @@ static void spi_interrupt_service(void) {
 }
 
 static void spi_set_nss(bool selected) {
+    if(selected) {
+        // Make sure the chip select has been high for long enough that the
+        // last datagram has been latched
+        HAL_GPIO_WritePin(MOTOR_SPI_NSS_PORT, MOTOR_SPI_NSS_PIN, GPIO_PIN_SET);
+        csn_high_delay();
+    }
     HAL_GPIO_WritePin(MOTOR_SPI_NSS_PORT, MOTOR_SPI_NSS_PIN, 
         (selected) ? GPIO_PIN_RESET : GPIO_PIN_SET);
 }
 
+// Busy wait on the DWT cycle counter. This is called from the SPI
+// interrupt between the datagrams of a batch, and is far too short to
+// block on anything else.
+static void csn_high_delay(void) {
+    const uint32_t start = DWT->CYCCNT;
+    while((DWT->CYCCNT - start) < _spi.csn_high_cycles) {
+    }
+}
+
 /**
  * @brief Overwritten HAL function for SPI TxRx Complete Callback.
  * @details If a task is blocked waiting for the SPI transaction to finish,
  * this function unblocks that task.
  */
 void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi) {
+    if(_spi.batch_remaining > 0) {
+        // Latch this message and start the next one of the batch. Selecting
+        // the driver raises the chip select for tCSH first.
+        spi_set_nss(true);
+        if(HAL_SPI_TransmitReceive_IT(hspi, _spi.batch_in, _spi.batch_out,
+                                      _spi.batch_len) == HAL_OK) {
+            _spi.batch_in += _spi.batch_len;
+            _spi.batch_out += _spi.batch_len;
+            --_spi.batch_remaining;
+            return;
+        }
+    }
     spi_interrupt_service();
 }
 
@@ -159,5 +249,6 @@ void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi) {
  * this function unblocks that task.
  */
 void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi) {
+    _spi.batch_remaining = 0;
     spi_interrupt_service();
 }
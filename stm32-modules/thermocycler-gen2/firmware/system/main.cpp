@@ -1,6 +1,7 @@
 
 
 #include "FreeRTOS.h"
+#include "firmware/dwt_trace_clock.hpp"
 #include "firmware/freertos_comms_task.hpp"
 #include "firmware/freertos_lid_heater_task.hpp"
 #include "firmware/freertos_message_queue.hpp"
@@ -17,6 +18,7 @@ tasks::Tasks<FreeRTOSMessageQueue> tasks_aggregator;
 
 auto main() -> int {
     HardwareInit();
+    dwt_trace_clock::install(SystemCoreClock);
     // Read the board revision here to make sure it's cached for the rest
     // of program execution
     auto revision = board_revision::BoardRevisionIface::get();
@@ -75,10 +75,8 @@ static void run_thermistor_task(void *param) {
     auto last_wake_time = xTaskGetTickCount();
     messages::LidTempReadComplete readings{};
     while (true) {
-        vTaskDelayUntil(
-            &last_wake_time,
-            // NOLINTNEXTLINE(readability-static-accessed-through-instance)
-            _main_task.CONTROL_PERIOD_TICKS);
+        vTaskDelayUntil(&last_wake_time,
+                        _main_task.get_control_period_ticks());
         bool done = false;
         uint8_t retries = 0;
         auto result = _adc.read(_adc_lid_pin);
@@ -8,6 +8,7 @@
 
 #include "FreeRTOS.h"
 #include "core/ads1115.hpp"
+#include "core/trace.hpp"
 #include "firmware/thermal_adc_policy.hpp"
 #include "firmware/thermal_hardware.h"
 #include "firmware/thermal_plate_policy.hpp"
@@ -127,10 +128,9 @@ static void run_thermistor_task(void *param) {
     auto last_wake_time = xTaskGetTickCount();
     messages::ThermalPlateTempReadComplete readings{};
     while (true) {
-        vTaskDelayUntil(
-            &last_wake_time,
-            // NOLINTNEXTLINE(readability-static-accessed-through-instance)
-            _main_task.CONTROL_PERIOD_TICKS);
+        vTaskDelayUntil(&last_wake_time,
+                        _main_task.get_control_period_ticks());
+        trace::begin(trace::THERMISTOR_READ);
         readings.front_right = read_thermistor(
             _adc_map[thermal_general::ThermistorID::THERM_FRONT_RIGHT]);
         readings.front_left = read_thermistor(
@@ -145,6 +145,7 @@ static void run_thermistor_task(void *param) {
             _adc_map[thermal_general::ThermistorID::THERM_BACK_CENTER]);
         readings.heat_sink = read_thermistor(
             _adc_map[thermal_general::ThermistorID::THERM_HEATSINK]);
+        trace::end(trace::THERMISTOR_READ);
         readings.timestamp_ms = xTaskGetTickCount();
 
         auto send_ret = _main_task.get_message_queue().try_send(readings);
@@ -39,6 +39,7 @@
 #include "task.h"
 
 // Local includes
+#include "core/trace_c.h"
 #include "firmware/thermal_fan_hardware.h"
 #include "firmware/thermal_heater_hardware.h"
 #include "firmware/thermal_peltier_hardware.h"
@@ -66,6 +67,8 @@
 /** Local variables */
 
 static _Atomic TaskHandle_t _i2c_task_to_notify = NULL;
+/** Set when the last transfer ended in an error, such as a NACK.*/
+static _Atomic bool _i2c_error = false;
 static atomic_flag _initialization_started = ATOMIC_FLAG_INIT;
 static bool _initialization_done = false;
 
@@ -265,6 +268,7 @@ bool thermal_i2c_write_data(uint16_t addr, uint8_t *data, uint16_t len) {
         return false;
     }
     _i2c_task_to_notify = xTaskGetCurrentTaskHandle();
+    _i2c_error = false;
 
     hal_ret = HAL_I2C_Master_Transmit_IT(&_i2c_handle, addr, data, len);
 
@@ -276,7 +280,9 @@ bool thermal_i2c_write_data(uint16_t addr, uint8_t *data, uint16_t len) {
     // Ignore return, we would not return an error here even if it fails
     (void)xSemaphoreGive(_i2c_semaphore);
 
-    return (notification_val == 1) && (hal_ret == HAL_OK);
+    // A NACK finishes the transfer through the error callback. The EEPROM
+    // NACKs its address while it is busy writing, so this must fail.
+    return (notification_val == 1) && (hal_ret == HAL_OK) && !_i2c_error;
 }
 
 bool thermal_i2c_read_data(uint16_t addr, uint8_t *data, uint16_t len) {
@@ -300,6 +306,7 @@ bool thermal_i2c_read_data(uint16_t addr, uint8_t *data, uint16_t len) {
         return false;
     }
     _i2c_task_to_notify = xTaskGetCurrentTaskHandle();
+    _i2c_error = false;
 
     hal_ret = HAL_I2C_Master_Receive_IT(&_i2c_handle, addr, data, len);
 
@@ -311,7 +318,7 @@ bool thermal_i2c_read_data(uint16_t addr, uint8_t *data, uint16_t len) {
     // Ignore return, we would not return an error here even if it fails
     (void)xSemaphoreGive(_i2c_semaphore);
     
-    return (notification_val == 1) && (hal_ret == HAL_OK);
+    return (notification_val == 1) && (hal_ret == HAL_OK) && !_i2c_error;
 
 }
 
@@ -328,6 +335,7 @@ void thermal_adc_ready_callback(ADC_ITR_T id) {
     // and other pins trigger the same interrupt vector.
     if(__HAL_GPIO_EXTI_GET_IT(_adc_itr_gpio[id]) != 0x00u) {
         __HAL_GPIO_EXTI_CLEAR_IT(_adc_itr_gpio[id]);
+        trace_instant(TRACE_ID_ADC_CONVERSION_COMPLETE);
         // There's a possibility of getting an interrupt when we don't expect
         // one, so just ignore if there's no armed task.
         if(_gpio_task_to_notify[id] != NULL) {
@@ -378,6 +386,7 @@ void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c) {
 
 void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *i2c_handle)
 {
+    _i2c_error = true;
     handle_i2c_callback();
 }
 
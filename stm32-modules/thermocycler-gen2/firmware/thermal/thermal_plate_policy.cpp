@@ -58,14 +58,9 @@ auto ThermalPlatePolicy::get_fan_rpm() -> std::pair<double, double> {
 
 // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
 auto ThermalPlatePolicy::set_write_protect(bool write_protect) -> void {
+    // The EEPROM driver polls the device for the end of each write cycle,
+    // so no delay is needed here
     thermal_eeprom_set_write_protect(write_protect);
-    if (!write_protect) {
-        // When done writing to the EEPROM, it needs some time to perform
-        // the write. We could poll the I2C bus, or we can just add a short
-        // delay since this won't happen during any critical sections.
-        static constexpr const TickType_t delay_ticks = pdMS_TO_TICKS(10);
-        vTaskDelay(delay_ticks);
-    }
 }
 
 // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
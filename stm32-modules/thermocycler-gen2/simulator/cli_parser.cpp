@@ -1,12 +1,14 @@
 #include "simulator/cli_parser.hpp"
 
 #include <boost/algorithm/string.hpp>
+#include <algorithm>
 #include <boost/program_options.hpp>
 #include <cstdlib>
 #include <iostream>
 #include <memory>
 #include <string>
 
+#include "simulator/sim_clock.hpp"
 #include "simulator/sim_driver.hpp"
 #include "simulator/socket_sim_driver.hpp"
 #include "simulator/stdin_sim_driver.hpp"
@@ -43,7 +45,9 @@ using namespace cli_parser;
     exit(1);
 }
 
-RT cli_parser::get_sim_driver(int num_args, char* args[]) {
+RT cli_parser::get_sim_driver(int num_args, char* args[],
+                              periodic_data_thread::SampleOptions& sample,
+                              double& speedup) {
     bool use_stdin = false;
     bool use_socket = false;
     bool realtime = false;
@@ -57,7 +61,20 @@ RT cli_parser::get_sim_driver(int num_args, char* args[]) {
                                             std::string>(),
                                         "Use socket to provide G-Codes")
         ("realtime", boost::program_options::bool_switch(&realtime),
-         "Thermal and motor data should run in real time");
+         "Thermal and motor data should run in real time")(
+            "speedup",
+            boost::program_options::value<double>(&speedup)->default_value(
+                sim_clock::SimClock::LOCKSTEP),
+            "Run the simulated clock this many times faster than real time, "
+            "instead of in lockstep with the tasks. Runs at a speedup are "
+            "not repeatable")(
+            "sample-volume",
+            boost::program_options::value<double>(&sample.volume_ul)
+                ->default_value(sample.volume_ul),
+            "Volume of the simulated sample in the plate wells, in uL")(
+            "log-sample", boost::program_options::bool_switch(&sample.log),
+            "Log the simulated sample and the firmware's estimate of it to "
+            "stderr once every simulated second");
 
     boost::program_options::variables_map vm;
     /*
@@ -86,6 +103,14 @@ RT cli_parser::get_sim_driver(int num_args, char* args[]) {
     if (use_stdin && use_socket) {
         both_drivers_specified_error(desc);
     }
+    if (speedup < sim_clock::SimClock::LOCKSTEP) {
+        std::cerr << std::endl
+                  << "ERROR: --speedup can't be negative" << std::endl
+                  << std::endl;
+        std::cerr << desc << std::endl;
+        exit(1);
+    }
+    sample.volume_ul = std::max(sample.volume_ul, 0.0);
 
     if (use_stdin) {
         return RT(std::make_shared<stdin_sim_driver::StdinSimDriver>(),
@@ -3,9 +3,8 @@
 #include <boost/asio.hpp>
 #include <iostream>
 #include <memory>
-#include <stop_token>
+#include <string>
 #include <string_view>
-#include <thread>
 
 #include "simulator/sim_driver.hpp"
 #include "thermocycler-gen2/host_comms_task.hpp"
@@ -15,31 +14,28 @@
 using namespace comm_thread;
 
 struct comm_thread::TaskControlBlock {
-    TaskControlBlock()
-        : queue(SimCommTask::Queue()), task(SimCommTask(queue)) {}
+    explicit TaskControlBlock(std::shared_ptr<sim_driver::SimDriver> driver)
+        : queue(SimCommTask::Queue()),
+          task(SimCommTask(queue)),
+          driver(std::move(driver)) {}
     SimCommTask::Queue queue;
     SimCommTask task;
+    std::shared_ptr<sim_driver::SimDriver> driver;
+    std::string buffer = std::string(1024, 'c');
 };
 
-auto run(std::stop_token st, std::shared_ptr<TaskControlBlock> tcb,
-         std::shared_ptr<sim_driver::SimDriver> driver) -> void {
-    tcb->queue.set_stop_token(st);
-    std::string buffer(1024, 'c');
-    while (!st.stop_requested()) {
-        try {
-            auto wrote_to = tcb->task.run_once(buffer.begin(), buffer.end());
-            driver->write(std::string(buffer.begin(), wrote_to));
-        } catch (const SimCommTask::Queue::StopDuringMsgWait sdmw) {
-            return;
-        }
-    }
-}
-
-auto comm_thread::build(std::shared_ptr<sim_driver::SimDriver>&& driver)
-    -> tasks::Task<std::unique_ptr<std::jthread>, comm_thread::SimCommTask> {
-    auto tcb = std::make_shared<TaskControlBlock>();
-    return tasks::Task{std::make_unique<std::jthread>(run, tcb, driver),
-                       &tcb->task};
+auto comm_thread::build(sim_worker_pool::WorkerPool& pool,
+                        std::shared_ptr<sim_driver::SimDriver> driver)
+    -> tasks::Task<std::shared_ptr<TaskControlBlock>, SimCommTask> {
+    auto tcb = std::make_shared<TaskControlBlock>(std::move(driver));
+    pool.add([tcb]() { return tcb->queue.has_message(); },
+             [tcb]() {
+                 auto wrote_to =
+                     tcb->task.run_once(tcb->buffer.begin(), tcb->buffer.end());
+                 tcb->driver->write(
+                     std::string(tcb->buffer.begin(), wrote_to));
+             });
+    return tasks::Task{tcb, &tcb->task};
 }
 
 void comm_thread::handle_input(std::shared_ptr<sim_driver::SimDriver>&& driver,
@@ -1,7 +1,7 @@
 #include "simulator/lid_heater_thread.hpp"
 
-#include <chrono>
-#include <stop_token>
+#include <memory>
+#include <utility>
 
 #include "systemwide.h"
 #include "thermocycler-gen2/errors.hpp"
@@ -33,38 +33,22 @@ class SimLidHeaterPolicy {
 };
 
 struct lid_heater_thread::TaskControlBlock {
-    TaskControlBlock()
-        : queue(SimLidHeaterTask::Queue()), task(SimLidHeaterTask(queue)) {}
+    explicit TaskControlBlock(
+        std::shared_ptr<periodic_data_thread::PeriodicDataThread> periodic_data)
+        : queue(SimLidHeaterTask::Queue()),
+          task(SimLidHeaterTask(queue)),
+          policy(std::move(periodic_data)) {}
     SimLidHeaterTask::Queue queue;
     SimLidHeaterTask task;
+    SimLidHeaterPolicy policy;
 };
 
-auto run(
-    std::stop_token st, std::shared_ptr<TaskControlBlock> tcb,
-    std::shared_ptr<periodic_data_thread::PeriodicDataThread> periodic_data)
-    -> void {
-    using namespace std::literals::chrono_literals;
-    auto policy = SimLidHeaterPolicy(periodic_data);
-    tcb->queue.set_stop_token(st);
-    while (!st.stop_requested()) {
-        auto last_update_before = tcb->task.get_last_temp_update();
-        try {
-            tcb->task.run_once(policy);
-        } catch (const SimLidHeaterTask::Queue::StopDuringMsgWait sdmw) {
-            return;
-        }
-        if (last_update_before != tcb->task.get_last_temp_update()) {
-            // The temperature was updated, so let the periodic data thread
-            // know it can send another update
-            periodic_data->signal_lid_thread_ready();
-        }
-    }
-}
-
 auto lid_heater_thread::build(
+    sim_worker_pool::WorkerPool& pool,
     std::shared_ptr<periodic_data_thread::PeriodicDataThread> periodic_data)
-    -> tasks::Task<std::unique_ptr<std::jthread>, SimLidHeaterTask> {
-    auto tcb = std::make_shared<TaskControlBlock>();
-    return tasks::Task(std::make_unique<std::jthread>(run, tcb, periodic_data),
-                       &tcb->task);
+    -> tasks::Task<std::shared_ptr<TaskControlBlock>, SimLidHeaterTask> {
+    auto tcb = std::make_shared<TaskControlBlock>(std::move(periodic_data));
+    pool.add([tcb]() { return tcb->queue.has_message(); },
+             [tcb]() { tcb->task.run_once(tcb->policy); });
+    return tasks::Task{tcb, &tcb->task};
 }
@@ -1,12 +1,15 @@
 #include <iostream>
 #include <memory>
 
+#include "simulator/chrono_trace_clock.hpp"
 #include "simulator/cli_parser.hpp"
 #include "simulator/comm_thread.hpp"
 #include "simulator/lid_heater_thread.hpp"
 #include "simulator/motor_thread.hpp"
 #include "simulator/periodic_data_thread.hpp"
+#include "simulator/sim_clock.hpp"
 #include "simulator/sim_driver.hpp"
+#include "simulator/sim_worker_pool.hpp"
 #include "simulator/simulator_queue.hpp"
 #include "simulator/system_thread.hpp"
 #include "simulator/thermal_plate_thread.hpp"
@@ -14,40 +17,37 @@
 
 using namespace std;
 
+// Threads shared by the tasks
+static constexpr size_t SIMULATOR_WORKERS = 2;
+
 int main(int argc, char *argv[]) {
-    auto cli_ret = cli_parser::get_sim_driver(argc, argv);
+    chrono_trace_clock::install();
+    auto sample = periodic_data_thread::SampleOptions();
+    auto speedup = sim_clock::SimClock::LOCKSTEP;
+    auto cli_ret = cli_parser::get_sim_driver(argc, argv, sample, speedup);
     auto sim_driver = cli_ret.first;
     auto realtime =
         cli_ret.second || cli_parser::check_realtime_environment_variable();
+    auto clock = std::make_shared<sim_clock::SimClock>(
+        realtime ? sim_clock::SimClock::REALTIME : speedup);
+    auto pool = sim_worker_pool::WorkerPool(clock, SIMULATOR_WORKERS);
 
-    auto periodic_data = periodic_data_thread::build(realtime);
+    auto periodic_data = periodic_data_thread::build(pool, sample);
 
-    auto system = system_thread::build();
-    auto thermal_plate = thermal_plate_thread::build(periodic_data.second);
-    auto lid_heater = lid_heater_thread::build(periodic_data.second);
-    auto motor = motor_thread::build();
-    auto comms = comm_thread::build(std::move(sim_driver));
+    auto system = system_thread::build(pool);
+    auto thermal_plate = thermal_plate_thread::build(pool, periodic_data);
+    auto lid_heater = lid_heater_thread::build(pool, periodic_data);
+    auto motor = motor_thread::build(pool);
+    auto comms = comm_thread::build(pool, sim_driver);
     auto tasks = tasks::Tasks<SimulatorMessageQueue>(
         comms.task, system.task, thermal_plate.task, lid_heater.task,
         motor.task);
 
-    periodic_data.second->provide_tasks(&tasks);
+    periodic_data->provide_tasks(&tasks);
 
+    pool.start();
     comm_thread::handle_input(std::move(sim_driver), tasks);
-
-    system.handle->request_stop();
-    comms.handle->request_stop();
-    thermal_plate.handle->request_stop();
-    lid_heater.handle->request_stop();
-    motor.handle->request_stop();
-    periodic_data.first->request_stop();
-
-    system.handle->join();
-    comms.handle->join();
-    thermal_plate.handle->join();
-    lid_heater.handle->join();
-    motor.handle->join();
-    periodic_data.first->join();
+    pool.stop();
 
     return 0;
 }
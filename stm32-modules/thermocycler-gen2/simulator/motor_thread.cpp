@@ -2,7 +2,9 @@
 
 #include <algorithm>
 #include <atomic>
+#include <memory>
 
+#include "core/delegate.hpp"
 #include "simulator/sim_tmc2130_policy.hpp"
 #include "systemwide.h"
 #include "thermocycler-gen2/errors.hpp"
@@ -13,7 +15,7 @@ using namespace motor_thread;
 
 class SimMotorPolicy : public SimTMC2130Policy {
   public:
-    using Callback = std::function<void()>;
+    using Callback = delegate::Delegate<void(SimMotorPolicy &)>;
 
     /** Frequency of the seal motor interrupt in hertz.*/
     static constexpr const uint32_t MotorTickFrequency = 1000000;
@@ -25,44 +27,46 @@ class SimMotorPolicy : public SimTMC2130Policy {
 
     auto lid_stepper_set_dac(uint8_t dac_val) -> void { _dac_val = dac_val; }
 
-    // Simulates the movement occuring immediately
-    auto lid_stepper_start(int32_t steps, bool overdrive) -> void {
-        auto current_position = current_lid_angle();
-
-        // First, check if a switch is already triggered
-        if (!overdrive) {
-            if (steps > 0 && open_switch_triggered(current_position)) {
-                send_lid_done();
-                return;
-            }
-            if (steps < 0 && close_switch_triggered(current_position)) {
-                send_lid_done();
-                return;
-            }
-        }
+    auto lid_stepper_set_profile(const motor_util::LidProfile &profile)
+        -> void {
+        _next_lid_profile = profile;
+    }
 
-        auto target_angle = current_position +
-                            motor_util::LidStepper::microsteps_to_angle(steps);
-        // Now, check if the movement will trigger a switch
-        if (!overdrive) {
-            if (steps > 0) {
-                if (current_position < open_switch_pos_angle &&
-                    target_angle > open_switch_pos_angle - switch_width_angle) {
-                    target_angle = open_switch_pos_angle;
+    // Simulates the movement occuring immediately, one step at a time. Steps
+    // follow the velocity profile, and the movement stops at the first step
+    // that triggers a switch in the direction of travel.
+    auto lid_stepper_start(int32_t steps, bool overdrive) -> void {
+        auto profile =
+            overdrive ? motor_util::LidProfile() : _next_lid_profile;
+        _next_lid_profile = motor_util::LidProfile();
+        profile.reset();
+
+        const int32_t direction = (steps > 0) ? 1 : -1;
+        _lid_move_seconds = 0.0F;
+        for (auto remaining = std::abs(steps); remaining > 0; --remaining) {
+            auto angle = current_lid_angle();
+            if (!overdrive) {
+                if (direction > 0 && open_switch_triggered(angle)) {
+                    break;
                 }
-            } else {
-                if (current_position > close_switch_pos_angle &&
-                    target_angle <
-                        close_switch_pos_angle + switch_width_angle) {
-                    target_angle = close_switch_pos_angle;
+                if (direction < 0 && close_switch_triggered(angle)) {
+                    break;
                 }
             }
+            auto next = _lid_step_position + direction;
+            if (next < min_lid_steps || next > max_lid_steps) {
+                // The lid is against a hard stop
+                break;
+            }
+            auto rpm = static_cast<double>(profile.next_rpm());
+            if (rpm <= 0.0F) {
+                rpm = _lid_rpm;
+            }
+            _lid_move_seconds +=
+                1.0F /
+                (rpm * motor_util::LidStepper::MICROSTEPS_PER_SECOND_PER_RPM);
+            _lid_step_position = next;
         }
-        // Change the angle and send the response
-        auto target_steps =
-            motor_util::LidStepper::angle_to_microsteps(target_angle);
-        _lid_step_position =
-            std::clamp<int32_t>(target_steps, min_lid_steps, max_lid_steps);
         send_lid_done();
     }
     auto lid_stepper_stop() -> void { return; }
@@ -74,7 +78,15 @@ class SimMotorPolicy : public SimTMC2130Policy {
         return true;
     }
 
-    auto lid_stepper_set_rpm(double rpm) -> bool { return true; }
+    auto lid_stepper_set_rpm(double rpm) -> bool {
+        _lid_rpm = rpm;
+        return true;
+    }
+
+    /** How long the last lid movement would have taken, in seconds.*/
+    [[nodiscard]] auto lid_move_seconds() const -> double {
+        return _lid_move_seconds;
+    }
 
     auto lid_solenoid_disengage() -> void { _solenoid_engaged = false; }
     auto lid_solenoid_engage() -> void { _solenoid_engaged = true; }
@@ -92,7 +104,7 @@ class SimMotorPolicy : public SimTMC2130Policy {
         _seal_active = true;
 
         while (_seal_active) {
-            cb();
+            cb(*this);
         }
 
         static_cast<void>(_task_queue.try_send(messages::SealStepperComplete{
@@ -121,10 +133,10 @@ class SimMotorPolicy : public SimTMC2130Policy {
 
   private:
     // Lowest position the lid can move before stalling
-    static constexpr uint32_t min_lid_steps =
+    static constexpr int32_t min_lid_steps =
         motor_util::LidStepper::angle_to_microsteps(-2.0);
     // Max position for the lid before stalling
-    static constexpr uint32_t max_lid_steps =
+    static constexpr int32_t max_lid_steps =
         motor_util::LidStepper::angle_to_microsteps(120.0);
     // Position of center of closed switch
     static constexpr double close_switch_pos_angle = 0.0F;
@@ -156,6 +168,9 @@ class SimMotorPolicy : public SimTMC2130Policy {
     bool _solenoid_engaged = true;
     uint8_t _dac_val = 0;
     int32_t _lid_step_position = 0;
+    double _lid_rpm = 125.0F;
+    double _lid_move_seconds = 0.0F;
+    motor_util::LidProfile _next_lid_profile{};
     std::atomic_bool _seal_active = false;
     std::atomic_bool _seal_switch_armed = false;
     SimMotorTask::Queue &_task_queue;
@@ -163,26 +178,18 @@ class SimMotorPolicy : public SimTMC2130Policy {
 
 struct motor_thread::TaskControlBlock {
     TaskControlBlock()
-        : queue(SimMotorTask::Queue()), task(SimMotorTask(queue)) {}
+        : queue(SimMotorTask::Queue()),
+          task(SimMotorTask(queue)),
+          policy(queue) {}
     SimMotorTask::Queue queue;
     SimMotorTask task;
+    SimMotorPolicy policy;
 };
 
-auto run(std::stop_token st, std::shared_ptr<TaskControlBlock> tcb) -> void {
-    using namespace std::literals::chrono_literals;
-    auto policy = SimMotorPolicy(tcb->queue);
-    tcb->queue.set_stop_token(st);
-    while (!st.stop_requested()) {
-        try {
-            tcb->task.run_once(policy);
-        } catch (const SimMotorTask::Queue::StopDuringMsgWait sdmw) {
-            return;
-        }
-    }
-}
-
-auto motor_thread::build()
-    -> tasks::Task<std::unique_ptr<std::jthread>, SimMotorTask> {
+auto motor_thread::build(sim_worker_pool::WorkerPool& pool)
+    -> tasks::Task<std::shared_ptr<TaskControlBlock>, SimMotorTask> {
     auto tcb = std::make_shared<TaskControlBlock>();
-    return tasks::Task(std::make_unique<std::jthread>(run, tcb), &tcb->task);
+    pool.add([tcb]() { return tcb->queue.has_message(); },
+             [tcb]() { tcb->task.run_once(tcb->policy); });
+    return tasks::Task{tcb, &tcb->task};
 }
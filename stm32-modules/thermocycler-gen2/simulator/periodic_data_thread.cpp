@@ -5,56 +5,57 @@
  * @details
  * This module simulates any periodic data on the Thermocycler system.
  * Specifically, it generates periodic thermistor data for all of the
- * thermal elements and calls the Motor Step tick.
+ * thermal elements and calls the Motor Step tick. It runs once per tick
+ * period of the simulator clock, as a periodic job of the worker pool.
  *
  */
 
 #include "simulator/periodic_data_thread.hpp"
 
 #include <chrono>
-#include <stop_token>
+#include <iomanip>
+#include <iostream>
 
 #include "simulator/lid_heater_thread.hpp"
+#include "simulator/sim_thermal_model.hpp"
 #include "simulator/thermal_plate_thread.hpp"
 #include "thermocycler-gen2/messages.hpp"
 #include "thermocycler-gen2/tasks.hpp"
 
 using namespace periodic_data_thread;
-
-/** Default starting temperature for all thermistors.*/
-static constexpr const double AMBIENT_TEMPERATURE = 23.0F;
-/** Gain term for peltier outputs, from experimental data.*/
-static constexpr const double PELTIER_GAIN = 3.2F;
-/** Gain term for lid heater output, from experimental data.*/
-static constexpr const double HEAT_PAD_GAIN = 0.72;
-/**
- * Gain term for bringing temperature back down to ambient. Scaled against
- * the difference between a temperature and its ambient condition. The
- * constant is derived from rough modeling against the lid heater cooling
- * from 100ºC to ambient temperature.
- */
-static constexpr const double AMBIENT_TEMPERATURE_GAIN = 0.0015;
-
-static constexpr const auto PELTIER_PERIOD =
-    thermal_plate_thread::SimThermalPlateTask::CONTROL_PERIOD_TICKS;
-
-static constexpr const auto LID_PERIOD =
-    lid_heater_thread::SimLidHeaterTask::CONTROL_PERIOD_TICKS;
-
-PeriodicDataThread::PeriodicDataThread(bool realtime)
+using sim_thermal_model::AMBIENT_TEMPERATURE;
+using sim_thermal_model::HEAT_PAD_GAIN;
+
+/** How often the sample temperature is logged, in ticks.*/
+static constexpr const uint32_t SAMPLE_LOG_PERIOD_TICKS = 1000;
+
+static_assert(
+    thermal_plate_thread::SimThermalPlateTask::RAMP_CONTROL_PERIOD_TICKS %
+            PeriodicDataThread::TICK_PERIOD_MS ==
+        0,
+    "Simulated tick step must divide the plate ramp period");
+static_assert(
+    lid_heater_thread::SimLidHeaterTask::RAMP_CONTROL_PERIOD_TICKS %
+            PeriodicDataThread::TICK_PERIOD_MS ==
+        0,
+    "Simulated tick step must divide the lid ramp period");
+
+PeriodicDataThread::PeriodicDataThread(SampleOptions sample)
     : _heat_pad_power(0),
       _peltiers_power{.left = 0, .center = 0, .right = 0},
       _lid_temp(AMBIENT_TEMPERATURE),
       _left_temp(AMBIENT_TEMPERATURE),
       _center_temp(AMBIENT_TEMPERATURE),
       _right_temp(AMBIENT_TEMPERATURE),
+      _sample{.wall = AMBIENT_TEMPERATURE, .liquid = AMBIENT_TEMPERATURE},
+      _sample_estimate(AMBIENT_TEMPERATURE),
+      _sample_options(sample),
+      _tick_sample_log(0),
       _tick_peltiers(0),
       _tick_heater(0),
       _current_tick(0),
       _queue(),
-      _task_registry(nullptr),
-      _realtime(realtime),
-      _init_latch(false) {}
+      _task_registry(nullptr) {}
 
 auto PeriodicDataThread::send_message(PeriodicDataMessage msg) -> bool {
     return _queue.try_send(msg);
@@ -63,94 +64,45 @@ auto PeriodicDataThread::send_message(PeriodicDataMessage msg) -> bool {
 auto PeriodicDataThread::provide_tasks(
     tasks::Tasks<SimulatorMessageQueue>* other_tasks) -> void {
     _task_registry = other_tasks;
-    _init_latch.store(true);
 }
 
-auto PeriodicDataThread::run(std::stop_token& st) -> void {
+auto PeriodicDataThread::tick(uint32_t now_ms) -> void {
     PeriodicDataMessage msg;
 
-    while (!_init_latch.load()) {
-        std::this_thread::yield();
+    if (_task_registry == nullptr) {
+        return;
     }
-
-    auto actual_time = std::chrono::high_resolution_clock::now();
-
-    while (!st.stop_requested()) {
-        // -------------------------------------------------------------------
-        // Update the current time, either based on real time or simulated
-        // time progression.
-
-        if (_realtime) {
-            // Use the high resolution clock to get an idea of the time
-            // difference
-            auto actual_time_new = std::chrono::high_resolution_clock::now();
-            auto tick_diff =
-                std::chrono::duration_cast<std::chrono::milliseconds>(
-                    actual_time_new - actual_time);
-            _current_tick += tick_diff.count();
-            actual_time = actual_time_new;
-        } else {
-            // For simulated time, increment tick by the smallest
-            // increment that should matter
-            _current_tick += std::min(PELTIER_PERIOD, LID_PERIOD);
-        }
-
-        // -------------------------------------------------------------------
-        // Check for any updated control values
-
-        while (_queue.try_recv(&msg)) {
-            if (std::holds_alternative<HeatPadPower>(msg)) {
-                // Update heat pad powers
-                _heat_pad_power = std::get<HeatPadPower>(msg).power;
-            } else if (std::holds_alternative<PeltierPower>(msg)) {
-                // Update peltier temperatures
-                _peltiers_power = std::get<PeltierPower>(msg);
-            } else if (std::holds_alternative<StartMotorMovement>(msg)) {
-                // TODO
-            }
-        }
-
-        // -------------------------------------------------------------------
-        // Update the heat pad & peltiers.
-
-        if (((_current_tick - _tick_heater) > LID_PERIOD)) {
-            // Must set flag BEFORE sending to ensure it is cleared
-            // correctly.
-            _waiting_for_lid_thread = true;
-            if (!update_heat_pad()) {
-                _waiting_for_lid_thread = false;
-            }
-        }
-        if (((_current_tick - _tick_peltiers) > PELTIER_PERIOD)) {
-            // Must set flag BEFORE sending to ensure it is cleared
-            // correctly.
-            _waiting_for_plate_thread = true;
-            if (!update_peltiers()) {
-                _waiting_for_plate_thread = false;
-            }
-        }
-
-        // -------------------------------------------------------------------
-        // Yield at the end of each loop to let other processes run
-        if (_realtime) {
-            // Sleep for 1 millisecond
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
-        } else {
-            // Yield to ensure other processes handle their messages
-            while (_waiting_for_lid_thread.load() ||
-                   _waiting_for_plate_thread.load()) {
-                std::this_thread::yield();
-            }
+    _current_tick = now_ms;
+
+    // -----------------------------------------------------------------------
+    // Check for any updated control values
+
+    while (_queue.try_recv(&msg)) {
+        if (std::holds_alternative<HeatPadPower>(msg)) {
+            // Update heat pad powers
+            _heat_pad_power = std::get<HeatPadPower>(msg).power;
+        } else if (std::holds_alternative<PeltierPower>(msg)) {
+            // Update peltier temperatures
+            _peltiers_power = std::get<PeltierPower>(msg);
+        } else if (std::holds_alternative<StartMotorMovement>(msg)) {
+            // TODO
+        } else if (std::holds_alternative<SampleEstimate>(msg)) {
+            _sample_estimate = std::get<SampleEstimate>(msg).temperature;
         }
     }
-}
 
-auto PeriodicDataThread::signal_lid_thread_ready() -> void {
-    _waiting_for_lid_thread = false;
-}
+    // -----------------------------------------------------------------------
+    // Update the heat pad & peltiers.
 
-auto PeriodicDataThread::signal_plate_thread_ready() -> void {
-    _waiting_for_plate_thread = false;
+    auto lid_period = _task_registry->lid_heater->get_control_period_ticks();
+    auto peltier_period =
+        _task_registry->thermal_plate->get_control_period_ticks();
+    if (((_current_tick - _tick_heater) >= lid_period)) {
+        static_cast<void>(update_heat_pad());
+    }
+    if (((_current_tick - _tick_peltiers) >= peltier_period)) {
+        static_cast<void>(update_peltiers());
+    }
 }
 
 auto PeriodicDataThread::ambient_temp_effect(Temperature temp,
@@ -158,8 +110,7 @@ auto PeriodicDataThread::ambient_temp_effect(Temperature temp,
     -> Temperature {
     using Seconds = std::chrono::duration<double, std::chrono::seconds::period>;
     auto seconds = std::chrono::duration_cast<Seconds>(delta);
-    return (AMBIENT_TEMPERATURE - temp) * AMBIENT_TEMPERATURE_GAIN *
-           seconds.count();
+    return sim_thermal_model::ambient_effect(temp, seconds.count());
 }
 
 auto PeriodicDataThread::scaled_gain_effect(double gain, double power,
@@ -167,8 +118,7 @@ auto PeriodicDataThread::scaled_gain_effect(double gain, double power,
     -> Temperature {
     using Seconds = std::chrono::duration<double, std::chrono::seconds::period>;
     auto seconds = std::chrono::duration_cast<Seconds>(delta);
-
-    return seconds.count() * gain * power;
+    return sim_thermal_model::gain_effect(gain, power, seconds.count());
 }
 
 auto PeriodicDataThread::update_heat_pad() -> bool {
@@ -202,15 +152,17 @@ auto PeriodicDataThread::update_peltiers() -> bool {
 
     auto timedelta = std::chrono::milliseconds(_current_tick - _tick_peltiers);
 
-    _left_temp +=
-        scaled_gain_effect(PELTIER_GAIN, _peltiers_power.left, timedelta) +
-        ambient_temp_effect(_left_temp, timedelta);
-    _center_temp +=
-        scaled_gain_effect(PELTIER_GAIN, _peltiers_power.center, timedelta) +
-        ambient_temp_effect(_center_temp, timedelta);
-    _right_temp +=
-        scaled_gain_effect(PELTIER_GAIN, _peltiers_power.right, timedelta) +
-        ambient_temp_effect(_right_temp, timedelta);
+    using Seconds = std::chrono::duration<double, std::chrono::seconds::period>;
+    auto seconds = std::chrono::duration_cast<Seconds>(timedelta).count();
+    _left_temp = sim_thermal_model::step_peltier(
+        _left_temp, _peltiers_power.left, seconds);
+    _center_temp = sim_thermal_model::step_peltier(
+        _center_temp, _peltiers_power.center, seconds);
+    _right_temp = sim_thermal_model::step_peltier(
+        _right_temp, _peltiers_power.right, seconds);
+
+    update_sample((_left_temp + _center_temp + _right_temp) / 3.0F,
+                  timedelta);
 
     auto message = messages::ThermalPlateTempReadComplete{
         .heat_sink = converter.backconvert(AMBIENT_TEMPERATURE),
@@ -233,20 +185,39 @@ auto PeriodicDataThread::update_peltiers() -> bool {
     return false;
 }
 
-auto PeriodicDataThread::run_motor() -> void {
-    // Todo!!!
+auto PeriodicDataThread::update_sample(Temperature plate_temp,
+                                       std::chrono::milliseconds delta)
+    -> void {
+    using Seconds = std::chrono::duration<double, std::chrono::seconds::period>;
+    auto seconds = std::chrono::duration_cast<Seconds>(delta).count();
+    _sample = sim_thermal_model::step_sample(
+        _sample, plate_temp, _lid_temp, _sample_options.volume_ul, seconds);
+    log_sample(plate_temp);
 }
 
-auto periodic_data_thread::build(bool realtime)
-    -> std::pair<std::unique_ptr<std::jthread>,
-                 std::shared_ptr<PeriodicDataThread>> {
-    auto thread = std::make_shared<PeriodicDataThread>(realtime);
+auto PeriodicDataThread::log_sample(Temperature plate_temp) -> void {
+    if (!_sample_options.log ||
+        (_current_tick - _tick_sample_log) < SAMPLE_LOG_PERIOD_TICKS) {
+        return;
+    }
+    _tick_sample_log = _current_tick;
+    std::clog << std::fixed << std::setprecision(2)
+              << "sample t=" << _current_tick << " plate=" << plate_temp
+              << " actual=" << _sample.liquid
+              << " estimate=" << _sample_estimate << std::endl;
+}
 
-    auto lambda = [](std::stop_token st,
-                     std::shared_ptr<PeriodicDataThread> _thread) {
-        _thread->run(st);
-    };
+auto PeriodicDataThread::run_motor() -> void {
+    // Todo!!!
+}
 
-    return std::make_pair(std::make_unique<std::jthread>(lambda, thread),
-                          thread);
+auto periodic_data_thread::build(sim_worker_pool::WorkerPool& pool,
+                                 SampleOptions sample)
+    -> std::shared_ptr<PeriodicDataThread> {
+    auto data = std::make_shared<PeriodicDataThread>(sample);
+    pool.add_periodic(PeriodicDataThread::TICK_PERIOD_MS,
+                      [data, clock = pool.clock()]() {
+                          data->tick(static_cast<uint32_t>(clock->now_ms()));
+                      });
+    return data;
 }
@@ -0,0 +1,80 @@
+/*
+ * The thermocycler simulator as a plugin for the sim host, which runs it
+ * alongside other simulated modules on a shared worker pool.
+ */
+#include <boost/system/system_error.hpp>
+#include <memory>
+
+#include "simulator/chrono_trace_clock.hpp"
+#include "simulator/comm_thread.hpp"
+#include "simulator/lid_heater_thread.hpp"
+#include "simulator/motor_thread.hpp"
+#include "simulator/periodic_data_thread.hpp"
+#include "simulator/sim_driver.hpp"
+#include "simulator/sim_module.hpp"
+#include "simulator/sim_worker_pool.hpp"
+#include "simulator/simulator_queue.hpp"
+#include "simulator/socket_sim_driver.hpp"
+#include "simulator/system_thread.hpp"
+#include "simulator/thermal_plate_thread.hpp"
+#include "thermocycler-gen2/tasks.hpp"
+
+namespace {
+
+class ThermocyclerModule : public sim_module::SimModule {
+  public:
+    ThermocyclerModule(sim_worker_pool::WorkerPool& pool,
+                       std::shared_ptr<sim_driver::SimDriver> driver)
+        : _driver(std::move(driver)),
+          _periodic_data(periodic_data_thread::build(pool)),
+          _system(system_thread::build(pool)),
+          _thermal_plate(thermal_plate_thread::build(pool, _periodic_data)),
+          _lid_heater(lid_heater_thread::build(pool, _periodic_data)),
+          _motor(motor_thread::build(pool)),
+          _comms(comm_thread::build(pool, _driver)),
+          _tasks(_comms.task, _system.task, _thermal_plate.task,
+                 _lid_heater.task, _motor.task) {
+        _periodic_data->provide_tasks(&_tasks);
+    }
+
+    auto read_input() -> void override {
+        try {
+            comm_thread::handle_input(std::shared_ptr(_driver), _tasks);
+        } catch (const boost::system::system_error&) {
+            // The socket closing ends the read; the other modules keep
+            // running
+        }
+    }
+
+  private:
+    std::shared_ptr<sim_driver::SimDriver> _driver;
+    std::shared_ptr<periodic_data_thread::PeriodicDataThread> _periodic_data;
+    tasks::Task<std::shared_ptr<system_thread::TaskControlBlock>,
+                system_thread::SimSystemTask>
+        _system;
+    tasks::Task<std::shared_ptr<thermal_plate_thread::TaskControlBlock>,
+                thermal_plate_thread::SimThermalPlateTask>
+        _thermal_plate;
+    tasks::Task<std::shared_ptr<lid_heater_thread::TaskControlBlock>,
+                lid_heater_thread::SimLidHeaterTask>
+        _lid_heater;
+    tasks::Task<std::shared_ptr<motor_thread::TaskControlBlock>,
+                motor_thread::SimMotorTask>
+        _motor;
+    tasks::Task<std::shared_ptr<comm_thread::TaskControlBlock>,
+                comm_thread::SimCommTask>
+        _comms;
+    tasks::Tasks<SimulatorMessageQueue> _tasks;
+};
+
+}  // namespace
+
+SIM_MODULE_EXPORT auto sim_module_add(sim_worker_pool::WorkerPool& pool,
+                                      const char* socket)
+    -> sim_module::SimModule* {
+    // Trace timestamps come from the steady clock, as in the standalone
+    // simulator
+    chrono_trace_clock::install();
+    return new ThermocyclerModule(
+        pool, std::make_shared<socket_sim_driver::SocketSimDriver>(socket));
+}
@@ -1,7 +1,7 @@
 #include "simulator/thermal_plate_thread.hpp"
 
-#include <chrono>
-#include <stop_token>
+#include <memory>
+#include <utility>
 
 #include "simulator/sim_at24c0xc_policy.hpp"
 #include "systemwide.h"
@@ -114,40 +114,35 @@ struct SimThermalPlatePolicy
 };
 
 struct thermal_plate_thread::TaskControlBlock {
-    TaskControlBlock()
+    explicit TaskControlBlock(
+        std::shared_ptr<periodic_data_thread::PeriodicDataThread> periodic_data)
         : queue(SimThermalPlateTask::Queue()),
-          task(SimThermalPlateTask(queue)) {}
+          task(SimThermalPlateTask(queue)),
+          policy(periodic_data),
+          periodic_data(std::move(periodic_data)) {}
     SimThermalPlateTask::Queue queue;
     SimThermalPlateTask task;
+    SimThermalPlatePolicy policy;
+    std::shared_ptr<periodic_data_thread::PeriodicDataThread> periodic_data;
 };
 
-auto run(
-    std::stop_token st, std::shared_ptr<TaskControlBlock> tcb,
-    std::shared_ptr<periodic_data_thread::PeriodicDataThread> periodic_data)
-    -> void {
-    using namespace std::literals::chrono_literals;
-    auto policy = SimThermalPlatePolicy(periodic_data);
-    tcb->queue.set_stop_token(st);
-    while (!st.stop_requested()) {
-        auto last_update_before = tcb->task.get_last_temp_update();
-        try {
-            tcb->task.run_once(policy);
-            policy.send_power();
-        } catch (const SimThermalPlateTask::Queue::StopDuringMsgWait sdmw) {
-            return;
-        }
-        if (last_update_before != tcb->task.get_last_temp_update()) {
-            // The temperature was updated, so let the periodic data thread
-            // know it can send another update
-            periodic_data->signal_plate_thread_ready();
-        }
+auto run(thermal_plate_thread::TaskControlBlock& tcb) -> void {
+    auto last_update_before = tcb.task.get_last_temp_update();
+    tcb.task.run_once(tcb.policy);
+    tcb.policy.send_power();
+    if (last_update_before != tcb.task.get_last_temp_update()) {
+        // The temperature was updated, so pass on the new sample estimate
+        tcb.periodic_data->send_message(periodic_data_thread::SampleEstimate{
+            .temperature = tcb.task.get_sample_temp()});
     }
 }
 
 auto thermal_plate_thread::build(
+    sim_worker_pool::WorkerPool& pool,
     std::shared_ptr<periodic_data_thread::PeriodicDataThread> periodic_data)
-    -> tasks::Task<std::unique_ptr<std::jthread>, SimThermalPlateTask> {
-    auto tcb = std::make_shared<TaskControlBlock>();
-    return tasks::Task(std::make_unique<std::jthread>(run, tcb, periodic_data),
-                       &tcb->task);
+    -> tasks::Task<std::shared_ptr<TaskControlBlock>, SimThermalPlateTask> {
+    auto tcb = std::make_shared<TaskControlBlock>(std::move(periodic_data));
+    pool.add([tcb]() { return tcb->queue.has_message(); },
+             [tcb]() { run(*tcb); });
+    return tasks::Task{tcb, &tcb->task};
 }
@@ -76,6 +76,10 @@ const char* const THERMAL_TARGET_BAD =
     "ERR407:thermal:Invalid target temperature OK\n";
 const char* const THERMAL_DRIFT =
     "ERR408:thermal:Thermal drift of more than 4C OK\n";
+const char* const THERMAL_PROTOCOL_INVALID =
+    "ERR409:thermal:Invalid or running protocol OK\n";
+const char* const THERMAL_PROTOCOL_ABORTED =
+    "ERR410:thermal:Protocol aborted by a lid heater error OK\n";
 const char* const LID_MOTOR_BUSY = "ERR501:lid:Lid motor busy OK\n";
 const char* const LID_MOTOR_FAULT = "ERR502:lid:Lid motor fault OK\n";
 const char* const SEAL_MOTOR_SPI_ERROR = "ERR503:seal:SPI error OK\n";
@@ -89,6 +93,8 @@ const char* const SEAL_MOTOR_SWITCH =
 const char* const UNKNOWN_ERROR = "ERR-1:unknown error code OK\n";
 const char* const UNEXPECTED_LID_STATE =
     "ERR509:lid:Lid status does not match expected open/closed status";
+const char* const SEAL_MOTOR_CALIBRATION =
+    "ERR510:seal:Seal StallGuard calibration failed OK\n";
 
 // NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
 #define HANDLE_CASE(errname) \
@@ -138,6 +144,8 @@ auto errors::errorstring(ErrorCode code) -> const char* {
         HANDLE_CASE(THERMAL_CONSTANT_OUT_OF_RANGE);
         HANDLE_CASE(THERMAL_TARGET_BAD);
         HANDLE_CASE(THERMAL_DRIFT);
+        HANDLE_CASE(THERMAL_PROTOCOL_INVALID);
+        HANDLE_CASE(THERMAL_PROTOCOL_ABORTED);
         HANDLE_CASE(LID_MOTOR_BUSY);
         HANDLE_CASE(LID_MOTOR_FAULT);
         HANDLE_CASE(SEAL_MOTOR_SPI_ERROR);
@@ -147,6 +155,7 @@ auto errors::errorstring(ErrorCode code) -> const char* {
         HANDLE_CASE(LID_CLOSED);
         HANDLE_CASE(SEAL_MOTOR_SWITCH);
         HANDLE_CASE(UNEXPECTED_LID_STATE);
+        HANDLE_CASE(SEAL_MOTOR_CALIBRATION);
     }
     return UNKNOWN_ERROR;
 }
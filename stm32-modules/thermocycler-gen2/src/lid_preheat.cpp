@@ -0,0 +1,50 @@
+/**
+ * @file lid_preheat.cpp
+ * @brief Implements the lid preheat timing.
+ */
+
+#include "thermocycler-gen2/lid_preheat.hpp"
+
+#include <cmath>
+
+using namespace lid_preheat;
+
+auto LidPreheat::start(double lead_time) -> void {
+    _waiting = true;
+    _have_temperature = false;
+    _lead_time = lead_time;
+    _rate = 0.0F;
+}
+
+auto LidPreheat::update(double temperature, double target, double time)
+    -> bool {
+    if (!_waiting) {
+        return false;
+    }
+    if (_have_temperature && time > 0.0F) {
+        auto measured = (temperature - _last_temperature) / time;
+        _rate += (measured - _rate) *
+                 (1.0 - std::exp(-time / RATE_TIME_CONSTANT));
+    }
+    _last_temperature = temperature;
+    _have_temperature = true;
+
+    auto remaining = time_to_target(temperature, target);
+    if (remaining < 0.0F || remaining > _lead_time) {
+        return false;
+    }
+    _waiting = false;
+    return true;
+}
+
+auto LidPreheat::time_to_target(double temperature, double target) const
+    -> double {
+    auto distance = target - temperature;
+    if (distance <= ARRIVAL_BAND) {
+        return 0.0F;
+    }
+    if (_rate < MIN_RATE) {
+        return -1.0F;
+    }
+    return distance / _rate;
+}
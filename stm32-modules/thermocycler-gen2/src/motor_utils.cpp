@@ -75,3 +75,45 @@ auto MovementProfile::tick() -> TickReturn {
 [[nodiscard]] auto MovementProfile::current_distance() const -> ticks {
     return _current_distance;
 }
+
+LidProfile::LidProfile(double start_rpm, double peak_rpm, double approach_rpm,
+                       double acceleration, uint32_t fast_steps)
+    : _start_rpm(static_cast<float>(start_rpm)),
+      _peak_rpm(static_cast<float>(std::max(peak_rpm, approach_rpm))),
+      _approach_rpm(static_cast<float>(approach_rpm)),
+      _two_accel(static_cast<float>(
+          2.0F * acceleration / LidStepper::MICROSTEPS_PER_SECOND_PER_RPM)),
+      _fast_steps(fast_steps) {
+    // Without a positive speed and acceleration, the lid would never move
+    if (start_rpm <= 0.0F || approach_rpm <= 0.0F || acceleration <= 0.0F) {
+        _fast_steps = 0;
+    }
+}
+
+auto LidProfile::next_rpm() -> float {
+    if (!enabled()) {
+        return 0.0F;
+    }
+    auto rpm = rpm_at(_step);
+    if (_step < UINT32_MAX) {
+        ++_step;
+    }
+    return rpm;
+}
+
+auto LidProfile::rpm_at(uint32_t step) const -> float {
+    if (!enabled()) {
+        return 0.0F;
+    }
+    auto accelerating =
+        std::sqrt(_start_rpm * _start_rpm +
+                  _two_accel * static_cast<float>(step));
+    auto rpm = std::min(_peak_rpm, accelerating);
+    if (step >= _fast_steps) {
+        return std::min(rpm, _approach_rpm);
+    }
+    auto decelerating =
+        std::sqrt(_approach_rpm * _approach_rpm +
+                  _two_accel * static_cast<float>(_fast_steps - step));
+    return std::min(rpm, decelerating);
+}
@@ -0,0 +1,121 @@
+/**
+ * @file pcr_protocol.cpp
+ * @brief Implements the PCR protocol engine.
+ */
+
+#include "thermocycler-gen2/pcr_protocol.hpp"
+
+using namespace pcr_protocol;
+
+auto ProtocolEngine::clear(double lid_temperature, double volume_ul) -> bool {
+    if (active() || lid_temperature < 0.0F ||
+        lid_temperature > MAX_LID_TEMPERATURE_C || volume_ul < 0.0F) {
+        return false;
+    }
+    _stage_count = 0;
+    _step_count = 0;
+    _lid_temperature = lid_temperature;
+    _volume_ul = volume_ul;
+    _progress = Progress();
+    return true;
+}
+
+auto ProtocolEngine::add_stage(uint32_t cycles) -> bool {
+    if (active() || _stage_count >= MAX_STAGES || cycles == 0 ||
+        cycles > MAX_CYCLES) {
+        return false;
+    }
+    _stages.at(_stage_count) =
+        Stage{.first_step = _step_count, .step_count = 0, .cycles = cycles};
+    ++_stage_count;
+    return true;
+}
+
+auto ProtocolEngine::add_step(const Step& step) -> bool {
+    if (active() || _stage_count == 0 || _step_count >= MAX_STEPS) {
+        return false;
+    }
+    // A zero hold would mean "hold forever" to the plate control, which
+    // would stall the run
+    if (step.temperature < MIN_TEMPERATURE_C ||
+        step.temperature > MAX_TEMPERATURE_C || step.hold_time <= 0.0F ||
+        step.ramp_rate < 0.0F) {
+        return false;
+    }
+    _steps.at(_step_count) = step;
+    ++_step_count;
+    ++_stages.at(_stage_count - 1).step_count;
+    return true;
+}
+
+auto ProtocolEngine::startable() const -> bool {
+    if (running() || _stage_count == 0) {
+        return false;
+    }
+    for (size_t i = 0; i < _stage_count; ++i) {
+        if (_stages.at(i).step_count == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+auto ProtocolEngine::start() -> std::optional<Step> {
+    if (!startable()) {
+        return std::nullopt;
+    }
+    _progress = Progress{.status = Status::RUNNING,
+                         .stage = 0,
+                         .step = 0,
+                         .cycle = 0,
+                         .cycles = _stages.at(0).cycles};
+    return current_step();
+}
+
+auto ProtocolEngine::preheat() -> std::optional<Step> {
+    if (preheating() || !startable()) {
+        return std::nullopt;
+    }
+    _progress = Progress{.status = Status::PREHEATING,
+                         .stage = 0,
+                         .step = 0,
+                         .cycle = 0,
+                         .cycles = _stages.at(0).cycles};
+    return current_step();
+}
+
+auto ProtocolEngine::advance() -> std::optional<Step> {
+    if (!running()) {
+        return std::nullopt;
+    }
+    ++_progress.step;
+    if (_progress.step >= _stages.at(_progress.stage).step_count) {
+        _progress.step = 0;
+        ++_progress.cycle;
+    }
+    if (_progress.cycle >= _progress.cycles) {
+        _progress.cycle = 0;
+        ++_progress.stage;
+        if (_progress.stage >= _stage_count) {
+            // Leave the indices pointing at the final step
+            _progress.stage = _stage_count - 1;
+            _progress.step = _stages.at(_progress.stage).step_count - 1;
+            _progress.cycle = _stages.at(_progress.stage).cycles - 1;
+            _progress.status = Status::COMPLETE;
+            return std::nullopt;
+        }
+        _progress.cycles = _stages.at(_progress.stage).cycles;
+    }
+    return current_step();
+}
+
+auto ProtocolEngine::abort() -> void {
+    if (active()) {
+        _progress.status = Status::ABORTED;
+    }
+}
+
+auto ProtocolEngine::current_step() const -> Step {
+    const auto& stage = _stages.at(_progress.stage);
+    return _steps.at(stage.first_step + _progress.step);
+}
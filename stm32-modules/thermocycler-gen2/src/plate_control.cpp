@@ -11,6 +11,7 @@
 
 #include "thermocycler-gen2/plate_control.hpp"
 
+#include <algorithm>
 #include <utility>
 
 #include "thermocycler-gen2/thermal_general.hpp"
@@ -19,10 +20,41 @@ using namespace plate_control;
 
 auto PlateControl::update_control(Seconds time) -> UpdateRet {
     PlateControlVals values = {0.0F};
+    update_zone(_left, time);
+    update_zone(_right, time);
+    update_zone(_center, time);
+    _sample.update(plate_temp(), _last_power, _fan.current_temp(), _volume_ul,
+                   _model, time);
+    if (_sample_hold) {
+        if (std::abs(_sample.sample_temp() - _setpoint) <
+            SAMPLE_SETPOINT_THRESHOLD) {
+            _sample_at_setpoint = true;
+        }
+        // Once the sample gets there the hold runs regardless of what the
+        // block is doing
+        if (_sample_at_setpoint) {
+            _remaining_hold_time = std::max(_remaining_hold_time - time,
+                                            static_cast<double>(0.0F));
+        }
+    }
     switch (_status) {
         case PlateStatus::INITIAL_HEAT:
         case PlateStatus::INITIAL_COOL: {
             bool heating = _status == PlateStatus::INITIAL_HEAT;
+            if (_feedforward_time > 0.0F) {
+                // The model predicts when to stop driving at full power and
+                // how long the thermistors lag behind, so the thermistors
+                // are not checked until both of those have passed.
+                _feedforward_time -= time;
+                if (_feedforward_time <= 0.0F) {
+                    _feedforward_time = 0.0F;
+                    _status = PlateStatus::OVERSHOOT;
+                    end_feedforward(_left);
+                    end_feedforward(_right);
+                    end_feedforward(_center);
+                }
+                break;
+            }
             // We need to wait for EVERY channel to independently reach its
             // target
             bool at_target =
@@ -59,9 +91,12 @@ auto PlateControl::update_control(Seconds time) -> UpdateRet {
             break;
         case PlateStatus::STEADY_STATE:
             if (temp_within_setpoint()) {
-                // Hold time is ONLY updated in steady state!
-                _remaining_hold_time = std::max(_remaining_hold_time - time,
-                                                static_cast<double>(0.0F));
+                // Hold time is ONLY updated in steady state, and a sample
+                // hold lasts until it's released
+                if (!_sample_hold) {
+                    _remaining_hold_time = std::max(
+                        _remaining_hold_time - time, static_cast<double>(0.0F));
+                }
                 _uniformity_error_timer = std::max(
                     _uniformity_error_timer - time, static_cast<double>(0.0F));
             }
@@ -71,6 +106,9 @@ auto PlateControl::update_control(Seconds time) -> UpdateRet {
     values.left_power = update_pid(_left, time);
     values.right_power = update_pid(_right, time);
     values.center_power = update_pid(_center, time);
+    _last_power =
+        (values.left_power + values.right_power + values.center_power) /
+        PELTIER_COUNT;
 
     // Caller should check whether fan is manual after this function runs
     if (_fan.manual_control) {
@@ -93,17 +131,32 @@ auto PlateControl::set_new_target(double setpoint, double volume_ul,
     _hold_time = hold_time;
     _remaining_hold_time = hold_time;
     _setpoint = setpoint;
+    _volume_ul = volume_ul;
+    _sample_at_setpoint = false;
 
     auto current_temp = plate_temp();
 
     // For heating vs cooling, go based off of the average plate. Might
     // have to reconsider this, see how it works for small changes.
-    _status = (setpoint > current_temp) ? PlateStatus::INITIAL_HEAT
-                                        : PlateStatus::INITIAL_COOL;
+    _heating = setpoint > current_temp;
+    _status = _heating ? PlateStatus::INITIAL_HEAT : PlateStatus::INITIAL_COOL;
 
     auto distance_to_target = std::abs(setpoint - current_temp);
+    _feedforward_time = 0.0F;
     if (distance_to_target > UNDERSHOOT_MIN_DIFFERENCE &&
-        hold_time < MAX_HOLD_TIME_FOR_OVERSHOOT) {
+        ramp_rate == RAMP_INFINITE && _model.valid()) {
+        auto drive_time = _model.full_power_duration(current_temp, setpoint,
+                                                     _fan.current_temp());
+        if (drive_time > 0.0F) {
+            _feedforward_time = drive_time + _model.dead_time;
+        }
+    }
+    if (_feedforward_time > 0.0F) {
+        // The model accounts for the lag of the plate, so there is no need
+        // for an overshoot target
+        _current_setpoint = setpoint;
+    } else if (distance_to_target > UNDERSHOOT_MIN_DIFFERENCE &&
+               hold_time < MAX_HOLD_TIME_FOR_OVERSHOOT) {
         if (_status == PlateStatus::INITIAL_HEAT) {
             _current_setpoint = calculate_overshoot(_setpoint, volume_ul);
             // If we're HEATING to a temp less than the heatsink, adjust
@@ -133,6 +186,27 @@ auto PlateControl::set_new_target(double setpoint, double volume_ul,
     return true;
 }
 
+[[nodiscard]] auto PlateControl::estimate_ramp_time(double setpoint,
+                                                    double ramp_rate) const
+    -> Seconds {
+    auto current_temp = plate_temp();
+    auto distance = std::abs(setpoint - current_temp);
+    if (ramp_rate != RAMP_INFINITE) {
+        return distance / ramp_rate;
+    }
+    if (_model.valid()) {
+        auto drive_time = _model.full_power_duration(current_temp, setpoint,
+                                                     _fan.current_temp());
+        if (drive_time >= 0.0F) {
+            return drive_time + _model.dead_time;
+        }
+    }
+    if (setpoint > current_temp) {
+        return distance / HEATING_RATE_ESTIMATE;
+    }
+    return distance / COOLING_RATE_ESTIMATE;
+}
+
 [[nodiscard]] auto PlateControl::fan_idle_power() const -> double {
     auto temp = _fan.current_temp();
     if (temp < IDLE_FAN_INACTIVE_THRESHOLD) {
@@ -146,6 +220,11 @@ auto PlateControl::set_new_target(double setpoint, double volume_ul,
     return temp * IDLE_FAN_POWER_SLOPE;
 }
 
+[[nodiscard]] auto PlateControl::fan_feedforward() const -> double {
+    // Heating draws heat out of the heatsink, so only cooling counts
+    return FAN_FEEDFORWARD_GAIN * std::clamp(-_last_power, 0.0, 1.0);
+}
+
 // This function *could* be made const, but that obfuscates the intention,
 // which is to update the ramp target of a *member* of the class.
 // NOLINTNEXTLINE(readability-make-member-function-const)
@@ -168,9 +247,20 @@ auto PlateControl::update_ramp(thermal_general::Peltier &peltier, Seconds time,
 // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
 auto PlateControl::update_pid(thermal_general::Peltier &peltier, Seconds time)
     -> double {
-    auto current_temp = peltier.current_temp();
-    if ((_status == PlateStatus::INITIAL_HEAT ||
-         _status == PlateStatus::INITIAL_COOL) &&
+    apply_schedule(peltier);
+    auto current_temp = peltier.control_temp();
+    bool ramping = _status == PlateStatus::INITIAL_HEAT ||
+                   _status == PlateStatus::INITIAL_COOL;
+    if (ramping && _feedforward_time > 0.0F) {
+        if (_feedforward_time > _model.dead_time) {
+            return (_status == PlateStatus::INITIAL_HEAT) ? 1.0 : -1.0;
+        }
+        // The plate has been driven far enough, and the thermistors are
+        // catching up. Feedback would react to the stale readings, so just
+        // hold the plate where the model says it is.
+        return _model.holding_power(_setpoint, _fan.current_temp());
+    }
+    if (ramping &&
         moving_away_from_ambient(current_temp, peltier.temp_target)) {
         if (std::abs(current_temp - peltier.temp_target) >
             proportional_band(peltier.pid)) {
@@ -190,11 +280,15 @@ auto PlateControl::update_fan(Seconds time) -> double {
     // Note that all error calculations are the inverse of peltiers. We have
     // to use the current temperature MINUS the target temperature because
     // fans need to drive with a positive magnitude to lower the temperature.
+    // The feedback loops below only trim whatever the feed-forward term
+    // doesn't account for.
+    auto feedforward = fan_feedforward();
     auto target_zone = temperature_zone(setpoint());
     if (target_zone == TemperatureZone::COLD) {
         if (_status == PlateStatus::INITIAL_COOL) {
-            // Ramping down to a cold temp is always 70% drive
-            return FAN_POWER_RAMP_COLD;
+            // Ramping down to a cold temp is at least 70% drive
+            return std::min(FAN_POWER_RAMP_COLD + feedforward,
+                            FAN_POWER_RAMP_DOWN_MAX);
         }
         // Holding at a cold temp is PID controlling the heatsink to 60ºC
         if (_fan.temp_target != FAN_TARGET_TEMP_COLD) {
@@ -204,13 +298,15 @@ auto PlateControl::update_fan(Seconds time) -> double {
         }
         // Power is clamped in range [0.35,0.7]
         auto power =
-            _fan.pid.compute(_fan.current_temp() - _fan.temp_target, time);
+            _fan.pid.compute(_fan.current_temp() - _fan.temp_target, time) +
+            feedforward;
         return std::clamp(power, FAN_POWER_LIMITS_COLD.first,
                           FAN_POWER_LIMITS_COLD.second);
     }
     if (_status == PlateStatus::INITIAL_COOL) {
-        // Ramping down to a non-cold temp is always just 55% drive
-        return FAN_POWER_RAMP_DOWN_NON_COLD;
+        // Ramping down to a non-cold temp is at least 55% drive
+        return std::min(FAN_POWER_RAMP_DOWN_NON_COLD + feedforward,
+                        FAN_POWER_RAMP_DOWN_MAX);
     }
     // Ramping up OR holding at a warm/hot temperature means we want to
     // regulate the heatsink to stay under (setpoint - 2)º.
@@ -218,13 +314,15 @@ auto PlateControl::update_fan(Seconds time) -> double {
     auto threshold = std::min(HEATSINK_SAFETY_THRESHOLD_WARM,
                               setpoint() + FAN_TARGET_DIFF_WARM);
     if (_fan.current_temp() < threshold) {
-        return FAN_POWER_UNDER_WARM_THRESHOLD;
+        return FAN_POWER_UNDER_WARM_THRESHOLD + feedforward;
     }
     if (_fan.temp_target != threshold) {
         _fan.temp_target = threshold;
         _fan.pid.arm_integrator_reset(_fan.current_temp() - _fan.temp_target);
     }
-    auto power = _fan.pid.compute(_fan.current_temp() - _fan.temp_target, time);
+    auto power =
+        _fan.pid.compute(_fan.current_temp() - _fan.temp_target, time) +
+        feedforward;
     if (target_zone == TemperatureZone::HOT) {
         return std::clamp(power, FAN_POWER_LIMITS_HOT.first,
                           FAN_POWER_LIMITS_HOT.second);
@@ -233,6 +331,28 @@ auto PlateControl::update_fan(Seconds time) -> double {
                       FAN_POWER_LIMITS_WARM.second);
 }
 
+// This function *could* be made const, because the peltier is passed in,
+// but every peltier it is given is a *member* whose control it hands over.
+// NOLINTNEXTLINE(readability-make-member-function-const)
+auto PlateControl::end_feedforward(thermal_general::Peltier &peltier)
+    -> void {
+    peltier.temp_target = _setpoint;
+    // The integrator takes over the holding power the feed-forward was
+    // applying, so the PID output picks up where the model left off.
+    peltier.pid.seed(peltier.temp_target - peltier.control_temp(),
+                     _model.holding_power(_setpoint, _fan.current_temp()));
+}
+
+// This function *could* be made static, but that obfuscates the intention,
+// which is to update the filter of a *member* of the class.
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+auto PlateControl::update_zone(thermal_general::Peltier &peltier, Seconds time)
+    -> void {
+    static_cast<void>(peltier.zone.update(
+        peltier.thermistors.first.temp_c, peltier.thermistors.second.temp_c,
+        peltier.filter.get_last(), _fan.current_temp(), _model, time));
+}
+
 // This function *could* be made const, but that obfuscates the intention,
 // which is to reset a *member* of the class.
 // NOLINTNEXTLINE(readability-make-member-function-const)
@@ -284,21 +404,52 @@ auto PlateControl::reset_control(thermal_general::HeatsinkFan &fan) -> void {
     return TemperatureZone::HOT;
 }
 
+[[nodiscard]] auto PlateControl::schedule_zone(double temp) const
+    -> gain_schedule::Zone {
+    switch (temperature_zone(temp)) {
+        case TemperatureZone::COLD:
+            return gain_schedule::Zone::COLD;
+        case TemperatureZone::WARM:
+            return gain_schedule::Zone::WARM;
+        case TemperatureZone::HOT:
+            return gain_schedule::Zone::HOT;
+    }
+    return gain_schedule::Zone::HOT;
+}
+
+// This function *could* be made static, but that obfuscates the intention,
+// which is to update the PID of a *member* of the class.
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+auto PlateControl::apply_schedule(thermal_general::Peltier &peltier) -> void {
+    if (!_schedule.has_value()) {
+        return;
+    }
+    const auto &gains =
+        _schedule.value().get(schedule_zone(peltier.temp_target), _heating);
+    if (gains.kp != peltier.pid.kp() || gains.ki != peltier.pid.ki() ||
+        gains.kd != peltier.pid.kd()) {
+        peltier.pid.set_gains(gains.kp, gains.ki, gains.kd);
+    }
+}
+
 [[nodiscard]] auto PlateControl::get_hold_time() const
     -> std::pair<Seconds, Seconds> {
     return std::make_pair(_remaining_hold_time, _hold_time);
 }
 
+[[nodiscard]] auto PlateControl::hold_complete() const -> bool {
+    if (_hold_time == HOLD_INFINITE || _remaining_hold_time > 0.0F) {
+        return false;
+    }
+    return _sample_hold || (_status == PlateStatus::STEADY_STATE);
+}
+
 [[nodiscard]] auto PlateControl::temp_within_setpoint() const -> bool {
     return (_status == PlateStatus::STEADY_STATE) &&
            (std::abs(_current_setpoint - plate_temp()) < SETPOINT_THRESHOLD);
 }
 
 [[nodiscard]] auto PlateControl::thermistor_drift_check() const -> bool {
-    if ((_status != PlateStatus::STEADY_STATE) ||
-        (_uniformity_error_timer > 0.0F)) {
-        return true;
-    }
     auto temperatures = get_peltier_temps();
     double min = temperatures.at(0);
     double max = temperatures.at(0);
@@ -306,8 +457,23 @@ auto PlateControl::reset_control(thermal_general::HeatsinkFan &fan) -> void {
         min = std::min(temperature, min);
         max = std::max(temperature, max);
     }
-    return (std::abs(max - min) <= THERMISTOR_DRIFT_MAX_C) ||
-           (max <= DRIFT_CHECK_IGNORE_MAX_TEMP);
+    return drift_within_spec(max - min, max);
+}
+
+[[nodiscard]] auto PlateControl::thermistor_drift_check(
+    const thermistor_stats::ThermistorStats &stats) const -> bool {
+    return drift_within_spec(stats.spread().latest(), stats.hottest());
+}
+
+[[nodiscard]] auto PlateControl::drift_within_spec(double spread,
+                                                   double hottest) const
+    -> bool {
+    if ((_status != PlateStatus::STEADY_STATE) ||
+        (_uniformity_error_timer > 0.0F)) {
+        return true;
+    }
+    return (spread <= THERMISTOR_DRIFT_MAX_C) ||
+           (hottest <= DRIFT_CHECK_IGNORE_MAX_TEMP);
 }
 
 [[nodiscard]] auto PlateControl::get_peltier_temps() const
@@ -0,0 +1,58 @@
+/**
+ * @file plate_model.cpp
+ * @brief Implements the first-order-plus-dead-time plate model.
+ */
+
+#include "thermocycler-gen2/plate_model.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace plate_model;
+
+auto PlateModel::valid() const -> bool {
+    return (gain > 0.0F) && (time_constant > 0.0F) && (dead_time >= 0.0F);
+}
+
+auto PlateModel::steady_state(double power, double ambient) const -> double {
+    return ambient + (gain * power);
+}
+
+auto PlateModel::holding_power(double target, double ambient) const
+    -> double {
+    if (!valid()) {
+        return 0.0F;
+    }
+    return std::clamp((target - ambient) / gain, -1.0, 1.0);
+}
+
+auto PlateModel::full_power_duration(double start, double target,
+                                     double ambient) const -> double {
+    if (!valid()) {
+        return -1.0F;
+    }
+    auto power = (target > start) ? 1.0 : -1.0;
+    auto final_temp = steady_state(power, ambient);
+    // The target must lie strictly between the start and the temperature
+    // the plate would settle at if it were driven at full power forever.
+    auto remaining_at_start = final_temp - start;
+    auto remaining_at_target = final_temp - target;
+    if ((remaining_at_target * power) <= 0.0F ||
+        (remaining_at_start * power) <= 0.0F) {
+        return -1.0F;
+    }
+    // The dead time delays the response to both switching on and switching
+    // off the full power drive by the same amount, so it doesn't change how
+    // long the drive needs to last.
+    return time_constant * std::log(remaining_at_start / remaining_at_target);
+}
+
+auto PlateModel::predict(double start, double power, double ambient,
+                         double time) const -> double {
+    if (!valid() || time <= dead_time) {
+        return start;
+    }
+    auto final_temp = steady_state(power, ambient);
+    return final_temp +
+           (start - final_temp) * std::exp(-(time - dead_time) / time_constant);
+}
@@ -0,0 +1,47 @@
+/**
+ * @file sample_estimator.cpp
+ * @brief Implements the sample temperature observer.
+ */
+
+#include "thermocycler-gen2/sample_estimator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace sample_estimator;
+
+auto SampleEstimator::liquid_time_constant(double volume_ul) -> double {
+    return TIME_CONSTANT_PER_MICROLITER * std::max(volume_ul, 0.0);
+}
+
+/** Move a first-order lag towards its input. Discretized exactly so that
+ * long sample periods can't overshoot.*/
+static auto lag(double state, double input, double time_constant,
+                double time) -> double {
+    if (time_constant <= 0.0F) {
+        return input;
+    }
+    return state + (input - state) * (1.0 - std::exp(-time / time_constant));
+}
+
+auto SampleEstimator::update(double block_temp, double power, double ambient,
+                             double volume_ul,
+                             const plate_model::PlateModel& model, double time)
+    -> double {
+    if (!_initialized) {
+        _block_temp = block_temp;
+        _wall_temp = block_temp;
+        _sample_temp = block_temp;
+        _initialized = true;
+        return _sample_temp;
+    }
+    if (model.valid()) {
+        _block_temp += ((model.gain * power) - (_block_temp - ambient)) /
+                       model.time_constant * time;
+    }
+    _block_temp = lag(_block_temp, block_temp, 1.0 / OBSERVER_GAIN, time);
+    _wall_temp = lag(_wall_temp, _block_temp, WALL_TIME_CONSTANT, time);
+    _sample_temp =
+        lag(_sample_temp, _wall_temp, liquid_time_constant(volume_ul), time);
+    return _sample_temp;
+}
@@ -0,0 +1,52 @@
+/**
+ * @file thermistor_stats.cpp
+ * @brief Implements the plate thermistor statistics.
+ */
+
+#include "thermocycler-gen2/thermistor_stats.hpp"
+
+using namespace thermistor_stats;
+
+static auto summarize(const ThermistorStats::Channel& channel)
+    -> ChannelSummary {
+    return ChannelSummary{.mean = static_cast<float>(channel.mean()),
+                          .stddev = static_cast<float>(channel.stddev()),
+                          .min = static_cast<float>(channel.min()),
+                          .max = static_cast<float>(channel.max())};
+}
+
+auto ThermistorStats::reset() -> void {
+    for (auto& channel : _thermistors) {
+        channel.reset();
+    }
+    _spread.reset();
+    _hottest = 0.0F;
+    _samples = 0;
+}
+
+auto ThermistorStats::update(const Temperatures& temperatures) -> void {
+    double coldest = temperatures.at(0);
+    double hottest = temperatures.at(0);
+    for (size_t i = 0; i < CHANNELS; ++i) {
+        auto temperature = temperatures.at(i);
+        _thermistors.at(i).add(temperature);
+        coldest = std::min(coldest, temperature);
+        hottest = std::max(hottest, temperature);
+    }
+    _spread.add(hottest - coldest);
+    _hottest = hottest;
+    ++_samples;
+}
+
+auto ThermistorStats::pair_spread(size_t first, size_t second) const
+    -> double {
+    return _thermistors.at(first).mean() - _thermistors.at(second).mean();
+}
+
+auto ThermistorStats::summary() const -> Summary {
+    auto ret = Summary{.samples = _samples, .spread = summarize(_spread)};
+    for (size_t i = 0; i < CHANNELS; ++i) {
+        ret.thermistors.at(i) = summarize(_thermistors.at(i));
+    }
+    return ret;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file zone_filter.cpp
+ * @brief Implements the per-zone thermistor fusion filter.
+ */
+
+#include "thermocycler-gen2/zone_filter.hpp"
+
+using namespace zone_filter;
+
+auto ZoneFilter::update(double front, double back, double power,
+                        double heatsink, const plate_model::PlateModel& model,
+                        double time) -> double {
+    if (!_initialized) {
+        _temp = (front + back) / 2.0F;
+        _rate = 0.0F;
+        _p_temp = MEASUREMENT_VARIANCE;
+        _p_cross = 0.0F;
+        _p_rate = INITIAL_RATE_VARIANCE;
+        _initialized = true;
+        return _temp;
+    }
+
+    // Predict: temp += time * (model rate + unmodeled rate). The model
+    // rate is linear in temp, which scales the temp row of the transition.
+    double decay = 1.0F;
+    double input = 0.0F;
+    if (model.valid()) {
+        decay -= time / model.time_constant;
+        input = time * ((model.gain * power) + heatsink) / model.time_constant;
+    }
+    _temp = (decay * _temp) + (time * _rate) + input;
+    auto p_temp = (decay * decay * _p_temp) + (2.0F * decay * time * _p_cross) +
+                  (time * time * _p_rate) + (TEMPERATURE_PROCESS_NOISE * time);
+    auto p_cross = (decay * _p_cross) + (time * _p_rate);
+    _p_temp = p_temp;
+    _p_cross = p_cross;
+    _p_rate += RATE_PROCESS_NOISE * time;
+
+    correct(front);
+    correct(back);
+    return _temp;
+}
+
+auto ZoneFilter::correct(double measurement) -> void {
+    auto innovation = measurement - _temp;
+    auto variance = _p_temp + MEASUREMENT_VARIANCE;
+    auto gain_temp = _p_temp / variance;
+    auto gain_rate = _p_cross / variance;
+    _temp += gain_temp * innovation;
+    _rate += gain_rate * innovation;
+    // Update the rate term first, since it uses the old cross term
+    _p_rate -= gain_rate * _p_cross;
+    _p_cross *= (1.0F - gain_temp);
+    _p_temp *= (1.0F - gain_temp);
+}
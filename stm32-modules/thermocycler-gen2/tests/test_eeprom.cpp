@@ -86,3 +86,148 @@ TEST_CASE("eeprom reading and writing") {
         }
     }
 }
+
+TEST_CASE("eeprom plate model reading and writing") {
+    GIVEN("an EEPROM") {
+        auto policy = TestAT24C0XCPolicy<32>();
+        auto eeprom = Eeprom<32, 0x10>();
+        auto defaults = plate_model::PlateModel{
+            .gain = 1.0, .time_constant = 2.0, .dead_time = 3.0};
+        WHEN("reading before writing anything") {
+            auto readback = eeprom.get_plate_model(defaults, policy);
+            THEN("the defaults are returned") {
+                REQUIRE(readback.gain == defaults.gain);
+                REQUIRE(readback.time_constant == defaults.time_constant);
+                REQUIRE(readback.dead_time == defaults.dead_time);
+            }
+        }
+        WHEN("writing a model and the offset constants") {
+            auto model = plate_model::PlateModel{
+                .gain = 120.5, .time_constant = 45.2, .dead_time = 1.8};
+            REQUIRE(eeprom.write_plate_model(model, policy));
+            REQUIRE(eeprom.write_offset_constants(_default, policy));
+            THEN("the model reads back") {
+                auto readback = eeprom.get_plate_model(defaults, policy);
+                REQUIRE_THAT(readback.gain,
+                             Catch::Matchers::WithinAbs(model.gain, 0.01));
+                REQUIRE_THAT(readback.time_constant,
+                             Catch::Matchers::WithinAbs(model.time_constant,
+                                                        0.01));
+                REQUIRE_THAT(readback.dead_time,
+                             Catch::Matchers::WithinAbs(model.dead_time, 0.01));
+            }
+            THEN("the offset constants are unaffected") {
+                auto readback = eeprom.get_offset_constants(
+                    OffsetConstants{.a = 0}, policy);
+                REQUIRE_THAT(readback.cr,
+                             Catch::Matchers::WithinAbs(_default.cr, 0.01));
+            }
+        }
+    }
+}
+
+TEST_CASE("eeprom PID constant reading and writing") {
+    GIVEN("an EEPROM") {
+        auto policy = TestAT24C0XCPolicy<32>();
+        auto eeprom = Eeprom<32, 0x10>();
+        auto defaults = PIDConstants{.kp = 0.3, .ki = 0.05, .kd = 0.3};
+        WHEN("reading before writing anything") {
+            auto readback = eeprom.get_pid_constants(defaults, policy);
+            THEN("the defaults are returned") {
+                REQUIRE(readback.kp == defaults.kp);
+                REQUIRE(readback.ki == defaults.ki);
+                REQUIRE(readback.kd == defaults.kd);
+            }
+        }
+        WHEN("writing constants along with a plate model") {
+            auto constants = PIDConstants{.kp = 0.85, .ki = 0.041, .kd = 4.4};
+            REQUIRE(eeprom.write_pid_constants(constants, policy));
+            auto model = plate_model::PlateModel{
+                .gain = 120.5, .time_constant = 45.2, .dead_time = 1.8};
+            REQUIRE(eeprom.write_plate_model(model, policy));
+            THEN("the constants read back") {
+                auto readback = eeprom.get_pid_constants(defaults, policy);
+                REQUIRE_THAT(readback.kp,
+                             Catch::Matchers::WithinAbs(constants.kp, 0.001));
+                REQUIRE_THAT(readback.ki,
+                             Catch::Matchers::WithinAbs(constants.ki, 0.001));
+                REQUIRE_THAT(readback.kd,
+                             Catch::Matchers::WithinAbs(constants.kd, 0.001));
+            }
+        }
+    }
+}
+
+TEST_CASE("eeprom gain schedule reading and writing") {
+    GIVEN("an EEPROM") {
+        auto policy = TestAT24C0XCPolicy<32>();
+        auto eeprom = Eeprom<32, 0x10>();
+        auto defaults = gain_schedule::GainSchedule(
+            gain_schedule::Gains{.kp = 0.3, .ki = 0.05, .kd = 0.3});
+        WHEN("reading before writing anything") {
+            auto readback = eeprom.get_gain_schedule(defaults, policy);
+            THEN("the defaults are returned") {
+                REQUIRE(readback.table() == defaults.table());
+            }
+        }
+        WHEN("writing a schedule along with the PID constants") {
+            auto schedule = defaults;
+            schedule.set(gain_schedule::Zone::COLD, false,
+                         gain_schedule::Gains{.kp = 1.5, .ki = 0.2, .kd = 4});
+            schedule.set(
+                gain_schedule::Zone::HOT, true,
+                gain_schedule::Gains{.kp = 0.25, .ki = 0.125, .kd = 2});
+            REQUIRE(eeprom.write_gain_schedule(schedule, policy));
+            auto constants = PIDConstants{.kp = 0.85, .ki = 0.041, .kd = 4.4};
+            REQUIRE(eeprom.write_pid_constants(constants, policy));
+            THEN("the schedule reads back") {
+                auto readback = eeprom.get_gain_schedule(defaults, policy);
+                for (size_t i = 0; i < schedule.table().size(); ++i) {
+                    const auto& expected = schedule.table().at(i);
+                    const auto& actual = readback.table().at(i);
+                    REQUIRE_THAT(actual.kp, Catch::Matchers::WithinAbs(
+                                                 expected.kp, 0.001));
+                    REQUIRE_THAT(actual.ki, Catch::Matchers::WithinAbs(
+                                                 expected.ki, 0.001));
+                    REQUIRE_THAT(actual.kd, Catch::Matchers::WithinAbs(
+                                                 expected.kd, 0.001));
+                }
+            }
+            THEN("the PID constants are not disturbed") {
+                auto readback = eeprom.get_pid_constants(
+                    PIDConstants{.kp = 0, .ki = 0, .kd = 0}, policy);
+                REQUIRE_THAT(readback.kp,
+                             Catch::Matchers::WithinAbs(constants.kp, 0.001));
+            }
+        }
+    }
+}
+
+TEST_CASE("eeprom seal calibration reading and writing") {
+    GIVEN("an EEPROM") {
+        auto policy = TestAT24C0XCPolicy<32>();
+        auto eeprom = Eeprom<32, 0x10>();
+        WHEN("reading before writing anything") {
+            THEN("there is no calibration") {
+                REQUIRE(!eeprom.get_seal_calibration(policy).has_value());
+            }
+        }
+        WHEN("writing a calibration along with the gain schedule") {
+            auto calibration = stall_calibration::Result{
+                .sgt = -7, .min_velocity = 80000, .home_velocity = 240000};
+            REQUIRE(eeprom.write_seal_calibration(calibration, policy));
+            auto schedule = gain_schedule::GainSchedule(
+                gain_schedule::Gains{.kp = 0.3, .ki = 0.05, .kd = 0.3});
+            REQUIRE(eeprom.write_gain_schedule(schedule, policy));
+            THEN("the calibration reads back") {
+                auto readback = eeprom.get_seal_calibration(policy);
+                REQUIRE(readback.has_value());
+                REQUIRE(readback.value().sgt == calibration.sgt);
+                REQUIRE(readback.value().min_velocity ==
+                        calibration.min_velocity);
+                REQUIRE(readback.value().home_velocity ==
+                        calibration.home_velocity);
+            }
+        }
+    }
+}
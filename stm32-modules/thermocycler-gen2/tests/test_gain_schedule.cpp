@@ -0,0 +1,34 @@
+#include "catch2/catch.hpp"
+#include "thermocycler-gen2/gain_schedule.hpp"
+
+using namespace gain_schedule;
+
+SCENARIO("gain schedule lookup") {
+    GIVEN("a schedule created from a single set of gains") {
+        auto gains = Gains{.kp = 0.5, .ki = 0.1, .kd = 0.2};
+        auto schedule = GainSchedule(gains);
+        THEN("every entry uses those gains") {
+            for (const auto& entry : schedule.table()) {
+                REQUIRE(entry == gains);
+            }
+        }
+        WHEN("setting one entry") {
+            auto cold_cooling = Gains{.kp = 1.0, .ki = 2.0, .kd = 3.0};
+            schedule.set(Zone::COLD, false, cold_cooling);
+            THEN("only that entry changes") {
+                REQUIRE(schedule.get(Zone::COLD, false) == cold_cooling);
+                REQUIRE(schedule.get(Zone::COLD, true) == gains);
+                REQUIRE(schedule.get(Zone::WARM, false) == gains);
+                REQUIRE(schedule.get(Zone::HOT, false) == gains);
+            }
+        }
+    }
+    GIVEN("raw zone indices") {
+        THEN("only the defined zones are valid") {
+            REQUIRE(GainSchedule::valid_zone(0));
+            REQUIRE(GainSchedule::valid_zone(2));
+            REQUIRE(!GainSchedule::valid_zone(-1));
+            REQUIRE(!GainSchedule::valid_zone(3));
+        }
+    }
+}
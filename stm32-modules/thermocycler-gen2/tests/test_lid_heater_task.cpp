@@ -1,3 +1,5 @@
+#include <vector>
+
 #include "catch2/catch.hpp"
 #include "systemwide.h"
 #include "test/task_builder.hpp"
@@ -606,4 +608,323 @@ TEST_CASE("lid heater error flag handling") {
             }
         }
     }
-}
\ No newline at end of file
+}
+TEST_CASE("lid heater adaptive control period") {
+    using LidTask = lid_heater_task::LidHeaterTask<TestMessageQueue>;
+    GIVEN("an idle lid heater") {
+        auto tasks = TaskBuilder::build();
+        auto &lid_task = tasks->get_lid_heater_task();
+        auto read_message = messages::LidTempReadComplete{
+            .lid_temp = _valid_adc, .timestamp_ms = TIME_DELTA};
+        tasks->get_lid_heater_queue().backing_deque.push_back(
+            messages::LidHeaterMessage(read_message));
+        tasks->run_lid_heater_task();
+        THEN("the lid is sampled at the hold rate") {
+            REQUIRE(lid_task.get_control_period_ticks() ==
+                    LidTask::HOLD_CONTROL_PERIOD_TICKS);
+        }
+        WHEN("setting a temperature far from the current temperature") {
+            auto message = messages::SetLidTemperatureMessage{
+                .id = 123, .setpoint = 100.0F};
+            tasks->get_lid_heater_queue().backing_deque.push_back(
+                messages::LidHeaterMessage(message));
+            tasks->run_lid_heater_task();
+            THEN("the lid is sampled at the ramp rate") {
+                REQUIRE(lid_task.get_control_period_ticks() ==
+                        LidTask::RAMP_CONTROL_PERIOD_TICKS);
+            }
+        }
+        WHEN("setting a temperature close to the current temperature") {
+            auto message = messages::SetLidTemperatureMessage{
+                .id = 123, .setpoint = _valid_temp + 1.0};
+            tasks->get_lid_heater_queue().backing_deque.push_back(
+                messages::LidHeaterMessage(message));
+            tasks->run_lid_heater_task();
+            THEN("the lid is sampled at the hold rate") {
+                REQUIRE(lid_task.get_control_period_ticks() ==
+                        LidTask::HOLD_CONTROL_PERIOD_TICKS);
+            }
+        }
+    }
+}
+TEST_CASE("lid heater relay autotune") {
+    using LidTask = lid_heater_task::LidHeaterTask<TestMessageQueue>;
+    auto converter = thermistor_conversion::Conversion<lookups::KS103J2G>(
+        LidTask::THERMISTOR_CIRCUIT_BIAS_RESISTANCE_KOHM, LidTask::ADC_BIT_MAX,
+        false);
+    constexpr uint32_t step_ms = LidTask::RAMP_CONTROL_PERIOD_TICKS;
+    uint32_t timestamp = step_ms;
+    GIVEN("an idle lid heater") {
+        auto tasks = TaskBuilder::build();
+        auto &lid_task = tasks->get_lid_heater_task();
+        auto &lid_queue = tasks->get_lid_heater_queue();
+        auto &host_queue = tasks->get_host_comms_queue();
+        auto &policy = tasks->get_lid_heater_policy();
+        double lid_temp = _valid_temp;
+        auto send_temp = [&]() {
+            auto read_message = messages::LidTempReadComplete{
+                .lid_temp = converter.backconvert(lid_temp),
+                .timestamp_ms = timestamp};
+            timestamp += step_ms;
+            static_cast<void>(lid_queue.try_send(read_message));
+            tasks->run_lid_heater_task();
+        };
+        send_temp();
+        WHEN("starting an autotune below the lid temperature") {
+            auto message = messages::StartAutotuneMessage{
+                .id = 123, .target = _valid_temp - 10.0F};
+            static_cast<void>(lid_queue.try_send(message));
+            tasks->run_lid_heater_task();
+            THEN("the task responds with an error") {
+                auto response = std::get<messages::AcknowledgePrevious>(
+                    host_queue.backing_deque.front());
+                REQUIRE(response.with_error ==
+                        errors::ErrorCode::THERMAL_TARGET_BAD);
+            }
+        }
+        WHEN("starting an autotune above the lid temperature") {
+            auto message = messages::StartAutotuneMessage{
+                .id = 123, .target = _valid_temp + 5.0F};
+            static_cast<void>(lid_queue.try_send(message));
+            tasks->run_lid_heater_task();
+            THEN("the task acknowledges the message") {
+                auto response = std::get<messages::AcknowledgePrevious>(
+                    host_queue.backing_deque.front());
+                REQUIRE(response.responding_to_id == 123);
+                REQUIRE(response.with_error == errors::ErrorCode::NO_ERROR);
+                REQUIRE(lid_task.get_control_period_ticks() ==
+                        LidTask::RAMP_CONTROL_PERIOD_TICKS);
+            }
+            AND_WHEN("the lid oscillates under the relay") {
+                // The lid heats at 1ºC/s at full power, cools at 0.25ºC/s,
+                // and lags the heater by half a second
+                std::vector<double> delayed(500 / step_ms, 0.0F);
+                for (int i = 0; i < 5000; ++i) {
+                    delayed.push_back(policy.get_heater_power());
+                    lid_temp += ((delayed.front() * 1.25F) - 0.25F) *
+                                step_ms / 1000.0F;
+                    delayed.erase(delayed.begin());
+                    send_temp();
+                    if (lid_task.get_control_period_ticks() !=
+                        LidTask::RAMP_CONTROL_PERIOD_TICKS) {
+                        break;
+                    }
+                }
+                host_queue.backing_deque.clear();
+                auto get = messages::GetAutotuneResultMessage{.id = 1};
+                static_cast<void>(lid_queue.try_send(get));
+                tasks->run_lid_heater_task();
+                THEN("the autotune completes and the heater turns off") {
+                    auto response =
+                        std::get<messages::GetAutotuneResultResponse>(
+                            host_queue.backing_deque.front());
+                    REQUIRE(response.selection == PidSelection::HEATER);
+                    REQUIRE(response.status == relay_autotune::Status::DONE);
+                    REQUIRE(response.result.kp > 0.0F);
+                    REQUIRE(policy.get_heater_power() == 0.0F);
+                }
+            }
+            AND_WHEN("deactivating the lid") {
+                auto deactivate =
+                    messages::DeactivateLidHeatingMessage{.id = 456};
+                static_cast<void>(lid_queue.try_send(deactivate));
+                tasks->run_lid_heater_task();
+                THEN("the autotune is aborted") {
+                    host_queue.backing_deque.clear();
+                    auto get = messages::GetAutotuneResultMessage{.id = 1};
+                    static_cast<void>(lid_queue.try_send(get));
+                    tasks->run_lid_heater_task();
+                    auto response =
+                        std::get<messages::GetAutotuneResultResponse>(
+                            host_queue.backing_deque.front());
+                    REQUIRE(response.status == relay_autotune::Status::FAILED);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("lid heater preheat for the plate") {
+    using LidTask = lid_heater_task::LidHeaterTask<TestMessageQueue>;
+    auto converter = thermistor_conversion::Conversion<lookups::KS103J2G>(
+        LidTask::THERMISTOR_CIRCUIT_BIAS_RESISTANCE_KOHM, LidTask::ADC_BIT_MAX,
+        false);
+    constexpr double target = 105.0F;
+    constexpr double lead_time = 30.0F;
+    uint32_t timestamp = 0;
+    GIVEN("a lid heater preheating for the plate") {
+        auto tasks = TaskBuilder::build();
+        auto &lid_task = tasks->get_lid_heater_task();
+        auto &lid_queue = tasks->get_lid_heater_queue();
+        auto &plate_queue = tasks->get_thermal_plate_queue();
+        double lid_temp = _valid_temp;
+        auto send_temp = [&]() {
+            timestamp += lid_task.get_control_period_ticks();
+            auto read_message = messages::LidTempReadComplete{
+                .lid_temp = converter.backconvert(lid_temp),
+                .timestamp_ms = timestamp};
+            static_cast<void>(lid_queue.try_send(read_message));
+            tasks->run_lid_heater_task();
+        };
+        send_temp();
+        auto message =
+            messages::SetLidTemperatureMessage{.id = 0,
+                                               .setpoint = target,
+                                               .from_plate = true,
+                                               .preheat_lead_time = lead_time};
+        static_cast<void>(lid_queue.try_send(message));
+        tasks->run_lid_heater_task();
+        send_temp();
+        THEN("the plate is not released straight away") {
+            REQUIRE(plate_queue.backing_deque.empty());
+        }
+        WHEN("the lid heats at 1ºC/s") {
+            double released_at = -1.0F;
+            while (lid_temp < target && plate_queue.backing_deque.empty()) {
+                lid_temp += lid_task.get_control_period_ticks() / 1000.0F;
+                send_temp();
+                released_at = lid_temp;
+            }
+            THEN("the plate is released about its lead time early") {
+                REQUIRE(plate_queue.backing_deque.size() == 1);
+                auto done = std::get<messages::LidPreheatDoneMessage>(
+                    plate_queue.backing_deque.front());
+                REQUIRE(done.at_temperature);
+                REQUIRE(released_at == Approx(target - lead_time).margin(1.0));
+            }
+            AND_THEN("further readings don't release it again") {
+                plate_queue.backing_deque.clear();
+                lid_temp += 1.0F;
+                send_temp();
+                REQUIRE(plate_queue.backing_deque.empty());
+            }
+        }
+        WHEN("the lid is deactivated before it is hot") {
+            auto deactivate = messages::DeactivateLidHeatingMessage{
+                .id = 456, .from_system = false};
+            static_cast<void>(lid_queue.try_send(deactivate));
+            tasks->run_lid_heater_task();
+            THEN("the plate is told the preheat failed") {
+                REQUIRE(plate_queue.backing_deque.size() == 1);
+                auto done = std::get<messages::LidPreheatDoneMessage>(
+                    plate_queue.backing_deque.front());
+                REQUIRE(!done.at_temperature);
+            }
+        }
+    }
+    GIVEN("a lid heater in an error state") {
+        auto tasks = TaskBuilder::build();
+        auto &lid_queue = tasks->get_lid_heater_queue();
+        auto &plate_queue = tasks->get_thermal_plate_queue();
+        auto read_message = messages::LidTempReadComplete{
+            .lid_temp = _shorted_adc, .timestamp_ms = timestamp};
+        static_cast<void>(lid_queue.try_send(read_message));
+        tasks->run_lid_heater_task();
+        WHEN("the plate asks for a preheat") {
+            auto message = messages::SetLidTemperatureMessage{
+                .id = 0,
+                .setpoint = target,
+                .from_plate = true,
+                .preheat_lead_time = lead_time};
+            static_cast<void>(lid_queue.try_send(message));
+            tasks->run_lid_heater_task();
+            THEN("the plate is told of the error, then the preheat failed") {
+                REQUIRE(plate_queue.backing_deque.size() == 2);
+                REQUIRE(std::holds_alternative<
+                        messages::LidProtocolErrorMessage>(
+                    plate_queue.backing_deque.front()));
+                auto done = std::get<messages::LidPreheatDoneMessage>(
+                    plate_queue.backing_deque.back());
+                REQUIRE(!done.at_temperature);
+            }
+        }
+        WHEN("the plate sets a target without a preheat") {
+            auto message = messages::SetLidTemperatureMessage{
+                .id = 0, .setpoint = target, .from_plate = true};
+            static_cast<void>(lid_queue.try_send(message));
+            tasks->run_lid_heater_task();
+            THEN("the plate is told of the error") {
+                REQUIRE(plate_queue.backing_deque.size() == 1);
+                REQUIRE(std::holds_alternative<
+                        messages::LidProtocolErrorMessage>(
+                    plate_queue.backing_deque.front()));
+            }
+        }
+    }
+}
+TEST_CASE("lid heater heating for a plate protocol") {
+    uint32_t timestamp = TIME_DELTA;
+    GIVEN("a lid heater heating for a plate protocol") {
+        auto tasks = TaskBuilder::build();
+        auto &lid_queue = tasks->get_lid_heater_queue();
+        auto &plate_queue = tasks->get_thermal_plate_queue();
+        auto &host_queue = tasks->get_host_comms_queue();
+        auto &policy = tasks->get_lid_heater_policy();
+        auto send_temp = [&](uint16_t adc) {
+            auto read_message = messages::LidTempReadComplete{
+                .lid_temp = adc, .timestamp_ms = timestamp};
+            timestamp += TIME_DELTA;
+            static_cast<void>(lid_queue.try_send(read_message));
+            tasks->run_lid_heater_task();
+        };
+        send_temp(_valid_adc);
+        static_cast<void>(
+            lid_queue.try_send(messages::SetLidTemperatureMessage{
+                .id = 0, .setpoint = 105.0F, .from_plate = true}));
+        tasks->run_lid_heater_task();
+        send_temp(_valid_adc);
+        REQUIRE(policy.get_heater_power() > 0.0F);
+        WHEN("the lid thermistor fails") {
+            send_temp(_shorted_adc);
+            THEN("the plate is told the lid stopped") {
+                REQUIRE(plate_queue.backing_deque.size() == 1);
+                REQUIRE(std::holds_alternative<
+                        messages::LidProtocolErrorMessage>(
+                    plate_queue.backing_deque.front()));
+                REQUIRE(policy.get_heater_power() == 0.0F);
+            }
+            AND_WHEN("the error persists") {
+                plate_queue.backing_deque.clear();
+                send_temp(_shorted_adc);
+                THEN("the plate is only told once") {
+                    REQUIRE(plate_queue.backing_deque.empty());
+                }
+            }
+        }
+        WHEN("the plate releases the lid") {
+            host_queue.backing_deque.clear();
+            static_cast<void>(
+                lid_queue.try_send(messages::DeactivateLidHeatingMessage{
+                    .id = 0, .from_plate = true}));
+            tasks->run_lid_heater_task();
+            send_temp(_valid_adc);
+            THEN("the lid turns off without a response or an error") {
+                REQUIRE(policy.get_heater_power() == 0.0F);
+                REQUIRE(host_queue.backing_deque.empty());
+                REQUIRE(plate_queue.backing_deque.empty());
+            }
+        }
+        WHEN("the host sets its own lid temperature") {
+            static_cast<void>(
+                lid_queue.try_send(messages::SetLidTemperatureMessage{
+                    .id = 123, .setpoint = 90.0F}));
+            tasks->run_lid_heater_task();
+            AND_WHEN("the plate releases the lid") {
+                static_cast<void>(
+                    lid_queue.try_send(messages::DeactivateLidHeatingMessage{
+                        .id = 0, .from_plate = true}));
+                tasks->run_lid_heater_task();
+                send_temp(_valid_adc);
+                THEN("the lid keeps heating for the host") {
+                    REQUIRE(policy.get_heater_power() > 0.0F);
+                }
+            }
+            AND_WHEN("the lid thermistor fails") {
+                send_temp(_shorted_adc);
+                THEN("the plate isn't told") {
+                    REQUIRE(plate_queue.backing_deque.empty());
+                }
+            }
+        }
+    }
+}
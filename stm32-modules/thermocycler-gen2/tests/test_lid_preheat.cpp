@@ -0,0 +1,66 @@
+#include "catch2/catch.hpp"
+#include "thermocycler-gen2/lid_preheat.hpp"
+
+using namespace lid_preheat;
+
+static constexpr double UPDATE_RATE_SEC = 0.1F;
+static constexpr double TARGET = 105.0F;
+
+TEST_CASE("lid preheat timing") {
+    auto subject = LidPreheat();
+    REQUIRE(!subject.waiting());
+    REQUIRE(!subject.update(23.0F, TARGET, UPDATE_RATE_SEC));
+    GIVEN("a preheat with a 30 second lead time") {
+        subject.start(30.0F);
+        REQUIRE(subject.waiting());
+        REQUIRE(subject.lead_time() == 30.0F);
+        WHEN("the lid is not heating") {
+            bool released = false;
+            for (int i = 0; i < 1000; ++i) {
+                released |= subject.update(23.0F, TARGET, UPDATE_RATE_SEC);
+            }
+            THEN("the plate is never released") {
+                REQUIRE(!released);
+                REQUIRE(subject.waiting());
+                REQUIRE(subject.time_to_target(23.0F, TARGET) < 0.0F);
+            }
+        }
+        WHEN("the lid heats at 1ºC/s") {
+            double temp = 23.0F;
+            double released_at = -1.0F;
+            int releases = 0;
+            while (temp < TARGET) {
+                if (subject.update(temp, TARGET, UPDATE_RATE_SEC)) {
+                    released_at = temp;
+                    ++releases;
+                }
+                temp += UPDATE_RATE_SEC;
+            }
+            THEN("the rate estimate converges") {
+                REQUIRE(subject.rate() == Approx(1.0F).epsilon(0.01));
+            }
+            THEN("the plate is released once, 30 seconds before the lid "
+                 "arrives") {
+                REQUIRE(releases == 1);
+                REQUIRE(released_at == Approx(TARGET - 30.0F).margin(0.5));
+                REQUIRE(!subject.waiting());
+            }
+        }
+        WHEN("the lid is already near its target") {
+            THEN("the plate is released on the first reading") {
+                REQUIRE(subject.time_to_target(TARGET - 1.0F, TARGET) ==
+                        0.0F);
+                REQUIRE(subject.update(TARGET - 1.0F, TARGET,
+                                       UPDATE_RATE_SEC));
+                REQUIRE(!subject.waiting());
+            }
+        }
+        WHEN("stopping the preheat") {
+            subject.stop();
+            THEN("the plate is not released") {
+                REQUIRE(!subject.waiting());
+                REQUIRE(!subject.update(TARGET, TARGET, UPDATE_RATE_SEC));
+            }
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#include "catch2/catch.hpp"
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#include "thermocycler-gen2/gcodes.hpp"
+#pragma GCC diagnostic pop
+
+SCENARIO("SetSampleHold (M118) parser works", "[gcode][parse][m118]") {
+    GIVEN("a response buffer large enough for the formatted response") {
+        std::string buffer(64, 'c');
+        WHEN("filling response") {
+            auto written = gcode::SetSampleHold::write_response_into(
+                buffer.begin(), buffer.end());
+            THEN("the response should be written in full") {
+                auto response_str = "M118 OK\n";
+                REQUIRE_THAT(buffer, Catch::Matchers::StartsWith(response_str));
+                REQUIRE(written == buffer.begin() + strlen(response_str));
+            }
+        }
+    }
+    GIVEN("an input enabling sample holds") {
+        std::string buffer = "M118 S1\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::SetSampleHold::parse(buffer.begin(), buffer.end());
+            THEN("a valid gcode should be produced") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(res.first.value().enable);
+                REQUIRE(res.second != buffer.begin());
+            }
+        }
+    }
+    GIVEN("an input disabling sample holds") {
+        std::string buffer = "M118 S0\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::SetSampleHold::parse(buffer.begin(), buffer.end());
+            THEN("a valid gcode should be produced") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(!res.first.value().enable);
+                REQUIRE(res.second != buffer.begin());
+            }
+        }
+    }
+    GIVEN("an input with an invalid mode") {
+        std::string buffer = "M118 S2\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::SetSampleHold::parse(buffer.begin(), buffer.end());
+            THEN("an error should be produced") {
+                REQUIRE(!res.first.has_value());
+                REQUIRE(res.second == buffer.begin());
+            }
+        }
+    }
+    GIVEN("an input without a mode") {
+        std::string buffer = "M118\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::SetSampleHold::parse(buffer.begin(), buffer.end());
+            THEN("an error should be produced") {
+                REQUIRE(!res.first.has_value());
+                REQUIRE(res.second == buffer.begin());
+            }
+        }
+    }
+}
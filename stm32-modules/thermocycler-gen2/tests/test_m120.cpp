@@ -0,0 +1,44 @@
+#include "catch2/catch.hpp"
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#include "thermocycler-gen2/gcodes.hpp"
+#pragma GCC diagnostic pop
+
+SCENARIO("GetSampleEstimate (M120) parser works", "[gcode][parse][m120]") {
+    GIVEN("a response buffer large enough for the formatted response") {
+        std::string buffer(64, 'c');
+        WHEN("filling response") {
+            auto written = gcode::GetSampleEstimate::write_response_into(
+                buffer.begin(), buffer.end(), 72.125, true);
+            THEN("the response should be written in full") {
+                auto response_str = "M120 T:72.12 S:1 OK\n";
+                REQUIRE_THAT(buffer, Catch::Matchers::StartsWith(response_str));
+                REQUIRE(written == buffer.begin() + strlen(response_str));
+            }
+        }
+    }
+    GIVEN("a response buffer not large enough for the formatted response") {
+        std::string buffer(16, 'c');
+        WHEN("filling response") {
+            auto written = gcode::GetSampleEstimate::write_response_into(
+                buffer.begin(), buffer.begin() + 7, 72.125, true);
+            THEN("the response should write only up to the available space") {
+                std::string response = "M120 Tcccccccccc";
+                response.at(6) = '\0';
+                REQUIRE_THAT(buffer, Catch::Matchers::Equals(response));
+                REQUIRE(written == buffer.begin() + 7);
+            }
+        }
+    }
+    GIVEN("a valid input") {
+        std::string buffer = "M120\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::GetSampleEstimate::parse(buffer.begin(), buffer.end());
+            THEN("a valid gcode should be produced") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(res.second != buffer.begin());
+            }
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#include "catch2/catch.hpp"
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#include "thermocycler-gen2/gcodes.hpp"
+#pragma GCC diagnostic pop
+
+SCENARIO("SetPlateModel (M150) parser works", "[gcode][parse][m150]") {
+    GIVEN("a response buffer large enough for the formatted response") {
+        std::string buffer(64, 'c');
+        WHEN("filling response") {
+            auto written = gcode::SetPlateModel::write_response_into(
+                buffer.begin(), buffer.end());
+            THEN("the response should be written in full") {
+                REQUIRE_THAT(buffer, Catch::Matchers::StartsWith("M150 OK\n"));
+                REQUIRE(written == buffer.begin() + 8);
+            }
+        }
+    }
+    GIVEN("a valid input") {
+        std::string buffer = "M150 K120.5 T45.2 D1.8\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::SetPlateModel::parse(buffer.begin(), buffer.end());
+            THEN("all of the parameters are parsed") {
+                REQUIRE(res.first.has_value());
+                REQUIRE_THAT(res.first.value().gain,
+                             Catch::Matchers::WithinAbs(120.5, 0.01));
+                REQUIRE_THAT(res.first.value().time_constant,
+                             Catch::Matchers::WithinAbs(45.2, 0.01));
+                REQUIRE_THAT(res.first.value().dead_time,
+                             Catch::Matchers::WithinAbs(1.8, 0.01));
+                REQUIRE(res.second != buffer.begin());
+            }
+        }
+    }
+    GIVEN("an input that disables the model") {
+        std::string buffer = "M150 K0 T0 D0\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::SetPlateModel::parse(buffer.begin(), buffer.end());
+            THEN("the parameters are all zero") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(res.first.value().gain == 0.0);
+                REQUIRE(res.first.value().time_constant == 0.0);
+                REQUIRE(res.first.value().dead_time == 0.0);
+            }
+        }
+    }
+    GIVEN("an input missing a parameter") {
+        std::string buffer = "M150 K120.5 D1.8\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::SetPlateModel::parse(buffer.begin(), buffer.end());
+            THEN("parsing fails") {
+                REQUIRE(!res.first.has_value());
+                REQUIRE(res.second == buffer.begin());
+            }
+        }
+    }
+    GIVEN("an input with an invalid parameter") {
+        std::string buffer = "M150 Kx T45.2 D1.8\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::SetPlateModel::parse(buffer.begin(), buffer.end());
+            THEN("parsing fails") { REQUIRE(!res.first.has_value()); }
+        }
+    }
+}
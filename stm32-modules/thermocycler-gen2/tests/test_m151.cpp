@@ -0,0 +1,55 @@
+#include "catch2/catch.hpp"
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#include "thermocycler-gen2/gcodes.hpp"
+#pragma GCC diagnostic pop
+
+SCENARIO("GetPlateModel (M151) parser works", "[gcode][parse][m151]") {
+    GIVEN("a response buffer large enough for the formatted response") {
+        std::string buffer(64, 'c');
+        WHEN("filling response") {
+            auto written = gcode::GetPlateModel::write_response_into(
+                buffer.begin(), buffer.end(), 120.5, 45.25, 1.8);
+            THEN("the response should be written in full") {
+                auto response_str = "M151 K:120.500 T:45.250 D:1.800 OK\n";
+                REQUIRE_THAT(buffer, Catch::Matchers::StartsWith(response_str));
+                REQUIRE(written == buffer.begin() + strlen(response_str));
+            }
+        }
+    }
+    GIVEN("a response buffer not large enough for the formatted response") {
+        std::string buffer(16, 'c');
+        WHEN("filling response") {
+            auto written = gcode::GetPlateModel::write_response_into(
+                buffer.begin(), buffer.begin() + 7, 120.5, 45.25, 1.8);
+            THEN("the response should write only up to the available space") {
+                std::string response = "M151 Kcccccccccc";
+                response.at(6) = '\0';
+                REQUIRE_THAT(buffer, Catch::Matchers::Equals(response));
+                REQUIRE(written == buffer.begin() + 7);
+            }
+        }
+    }
+    GIVEN("a valid input") {
+        std::string buffer = "M151\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::GetPlateModel::parse(buffer.begin(), buffer.end());
+            THEN("a valid gcode should be produced") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(res.second != buffer.begin());
+            }
+        }
+    }
+    GIVEN("an invalid input") {
+        std::string buffer = "M150\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::GetPlateModel::parse(buffer.begin(), buffer.end());
+            THEN("an error should be produced") {
+                REQUIRE(!res.first.has_value());
+                REQUIRE(res.second == buffer.begin());
+            }
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#include "catch2/catch.hpp"
+#include "thermocycler-gen2/gcodes.hpp"
+
+SCENARIO("gcode m244.d works", "[gcode][parse][m244d]") {
+    GIVEN("a response buffer large enough for the formatted response") {
+        std::string buffer(64, 'c');
+        WHEN("filling response") {
+            auto written = gcode::CalibrateSealStall::write_response_into(
+                buffer.begin(), buffer.end(),
+                stall_calibration::Result{.sgt = -3,
+                                          .min_velocity = 80000,
+                                          .home_velocity = 240000});
+            THEN("the response should be written in full") {
+                REQUIRE_THAT(buffer,
+                             Catch::Matchers::StartsWith(
+                                 "M244.D T:-3 M:80000 H:240000 OK\n"));
+                REQUIRE(written != buffer.begin());
+            }
+        }
+    }
+    GIVEN("a response buffer not large enough for the formatted response") {
+        std::string buffer(16, 'c');
+        WHEN("filling response") {
+            auto written = gcode::CalibrateSealStall::write_response_into(
+                buffer.begin(), buffer.begin() + 8,
+                stall_calibration::Result{});
+            THEN("the response should write only up to the available space") {
+                std::string response = "M244.D Tcccccccc";
+                response.at(7) = '\0';
+                REQUIRE_THAT(buffer, Catch::Matchers::Equals(response));
+                REQUIRE(written != buffer.begin());
+            }
+        }
+    }
+    GIVEN("a valid input") {
+        std::string buffer = "M244.D\n";
+        WHEN("parsing the command") {
+            auto parsed =
+                gcode::CalibrateSealStall::parse(buffer.begin(), buffer.end());
+            THEN("it should parse") {
+                REQUIRE(parsed.first.has_value());
+                REQUIRE(parsed.second != buffer.begin());
+            }
+        }
+    }
+    GIVEN("an invalid input") {
+        std::string buffer = "M244\n";
+        WHEN("parsing the command") {
+            auto parsed =
+                gcode::CalibrateSealStall::parse(buffer.begin(), buffer.end());
+            THEN("it should not parse") {
+                REQUIRE(!parsed.first.has_value());
+                REQUIRE(parsed.second == buffer.begin());
+            }
+        }
+    }
+}
@@ -0,0 +1,93 @@
+#include "catch2/catch.hpp"
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#include "thermocycler-gen2/gcodes.hpp"
+#pragma GCC diagnostic pop
+
+SCENARIO("StartAutotune (M303) parser works", "[gcode][parse][m303]") {
+    GIVEN("a response buffer large enough for the formatted response") {
+        std::string buffer(64, 'c');
+        WHEN("filling response") {
+            auto written = gcode::StartAutotune::write_response_into(
+                buffer.begin(), buffer.end());
+            THEN("the response should be written in full") {
+                auto response_str = "M303 OK\n";
+                REQUIRE_THAT(buffer, Catch::Matchers::StartsWith(response_str));
+                REQUIRE(written == buffer.begin() + strlen(response_str));
+            }
+        }
+    }
+    GIVEN("a peltier autotune input") {
+        std::string buffer = "M303 SP T70.5\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::StartAutotune::parse(buffer.begin(), buffer.end());
+            THEN("a valid gcode should be produced") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(res.second != buffer.begin());
+                auto val = res.first.value();
+                REQUIRE(val.selection == PidSelection::PELTIERS);
+                REQUIRE_THAT(val.target,
+                             Catch::Matchers::WithinAbs(70.5, 0.001));
+                REQUIRE(!val.write);
+            }
+        }
+    }
+    GIVEN("a peltier autotune input that writes the result") {
+        std::string buffer = "M303 SP T50 W1\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::StartAutotune::parse(buffer.begin(), buffer.end());
+            THEN("the write flag should be set") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(res.first.value().write);
+            }
+        }
+    }
+    GIVEN("a heater autotune input") {
+        std::string buffer = "M303 SH T105\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::StartAutotune::parse(buffer.begin(), buffer.end());
+            THEN("a valid gcode should be produced") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(res.first.value().selection == PidSelection::HEATER);
+                REQUIRE_THAT(res.first.value().target,
+                             Catch::Matchers::WithinAbs(105, 0.001));
+            }
+        }
+    }
+    GIVEN("a heater autotune input that writes the result") {
+        std::string buffer = "M303 SH T105 W1\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::StartAutotune::parse(buffer.begin(), buffer.end());
+            THEN("an error should be produced") {
+                REQUIRE(!res.first.has_value());
+                REQUIRE(res.second == buffer.begin());
+            }
+        }
+    }
+    GIVEN("an input with no target") {
+        std::string buffer = "M303 SP\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::StartAutotune::parse(buffer.begin(), buffer.end());
+            THEN("an error should be produced") {
+                REQUIRE(!res.first.has_value());
+                REQUIRE(res.second == buffer.begin());
+            }
+        }
+    }
+    GIVEN("an input with a fan selection") {
+        std::string buffer = "M303 SF T50\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::StartAutotune::parse(buffer.begin(), buffer.end());
+            THEN("an error should be produced") {
+                REQUIRE(!res.first.has_value());
+                REQUIRE(res.second == buffer.begin());
+            }
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#include "catch2/catch.hpp"
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#include "thermocycler-gen2/gcodes.hpp"
+#pragma GCC diagnostic pop
+
+SCENARIO("GetAutotuneResult (M304) parser works", "[gcode][parse][m304]") {
+    auto result = relay_autotune::Result{.ultimate_gain = 1.5,
+                                         .ultimate_period = 42.25,
+                                         .kp = 0.9,
+                                         .ki = 0.0426,
+                                         .kd = 4.7531};
+    GIVEN("a response buffer large enough for the formatted response") {
+        std::string buffer(128, 'c');
+        WHEN("filling response") {
+            auto written = gcode::GetAutotuneResult::write_response_into(
+                buffer.begin(), buffer.end(), PidSelection::PELTIERS,
+                relay_autotune::Status::DONE, 4, result);
+            THEN("the response should be written in full") {
+                auto response_str =
+                    "M304 S:P R:DONE C:4 U:1.5000 T:42.25 P:0.9000 I:0.0426 "
+                    "D:4.7531 OK\n";
+                REQUIRE_THAT(buffer, Catch::Matchers::StartsWith(response_str));
+                REQUIRE(written == buffer.begin() + strlen(response_str));
+            }
+        }
+    }
+    GIVEN("a response buffer not large enough for the formatted response") {
+        std::string buffer(16, 'c');
+        WHEN("filling response") {
+            auto written = gcode::GetAutotuneResult::write_response_into(
+                buffer.begin(), buffer.begin() + 7, PidSelection::HEATER,
+                relay_autotune::Status::RUNNING, 2, result);
+            THEN("the response should write only up to the available space") {
+                std::string response = "M304 Scccccccccc";
+                response.at(6) = '\0';
+                REQUIRE_THAT(buffer, Catch::Matchers::Equals(response));
+                REQUIRE(written == buffer.begin() + 7);
+            }
+        }
+    }
+    GIVEN("a valid input") {
+        std::string buffer = "M304 SH\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::GetAutotuneResult::parse(buffer.begin(), buffer.end());
+            THEN("a valid gcode should be produced") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(res.second != buffer.begin());
+                REQUIRE(res.first.value().selection == PidSelection::HEATER);
+            }
+        }
+    }
+    GIVEN("an invalid input") {
+        std::string buffer = "M304\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::GetAutotuneResult::parse(buffer.begin(), buffer.end());
+            THEN("an error should be produced") {
+                REQUIRE(!res.first.has_value());
+                REQUIRE(res.second == buffer.begin());
+            }
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#include "catch2/catch.hpp"
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#include "thermocycler-gen2/gcodes.hpp"
+#pragma GCC diagnostic pop
+
+SCENARIO("SetGainSchedule (M305) parser works", "[gcode][parse][m305]") {
+    GIVEN("a response buffer large enough for the formatted response") {
+        std::string buffer(64, 'c');
+        WHEN("filling response") {
+            auto written = gcode::SetGainSchedule::write_response_into(
+                buffer.begin(), buffer.end());
+            THEN("the response should be written in full") {
+                auto response_str = "M305 OK\n";
+                REQUIRE_THAT(buffer, Catch::Matchers::StartsWith(response_str));
+                REQUIRE(written == buffer.begin() + strlen(response_str));
+            }
+        }
+    }
+    GIVEN("a heating input") {
+        std::string buffer = "M305 Z2 C0 P0.4 I0.08 D0.3\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::SetGainSchedule::parse(buffer.begin(), buffer.end());
+            THEN("a valid gcode should be produced") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(res.second != buffer.begin());
+                auto val = res.first.value();
+                REQUIRE(val.zone == 2);
+                REQUIRE(val.heating);
+                REQUIRE_THAT(val.const_p,
+                             Catch::Matchers::WithinAbs(0.4, 0.001));
+                REQUIRE_THAT(val.const_i,
+                             Catch::Matchers::WithinAbs(0.08, 0.001));
+                REQUIRE_THAT(val.const_d,
+                             Catch::Matchers::WithinAbs(0.3, 0.001));
+            }
+        }
+    }
+    GIVEN("a cooling input") {
+        std::string buffer = "M305 Z0 C1 P1 I2 D3\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::SetGainSchedule::parse(buffer.begin(), buffer.end());
+            THEN("a valid gcode should be produced") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(res.first.value().zone == 0);
+                REQUIRE(!res.first.value().heating);
+            }
+        }
+    }
+    GIVEN("an input with an invalid zone") {
+        std::string buffer = "M305 Z3 C0 P1 I2 D3\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::SetGainSchedule::parse(buffer.begin(), buffer.end());
+            THEN("an error should be produced") {
+                REQUIRE(!res.first.has_value());
+                REQUIRE(res.second == buffer.begin());
+            }
+        }
+    }
+    GIVEN("an input with an invalid direction") {
+        std::string buffer = "M305 Z1 C2 P1 I2 D3\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::SetGainSchedule::parse(buffer.begin(), buffer.end());
+            THEN("an error should be produced") {
+                REQUIRE(!res.first.has_value());
+                REQUIRE(res.second == buffer.begin());
+            }
+        }
+    }
+    GIVEN("an input missing a gain") {
+        std::string buffer = "M305 Z1 C0 P1 I2\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::SetGainSchedule::parse(buffer.begin(), buffer.end());
+            THEN("an error should be produced") {
+                REQUIRE(!res.first.has_value());
+                REQUIRE(res.second == buffer.begin());
+            }
+        }
+    }
+}
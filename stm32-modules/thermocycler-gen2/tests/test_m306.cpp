@@ -0,0 +1,58 @@
+#include "catch2/catch.hpp"
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#include "thermocycler-gen2/gcodes.hpp"
+#pragma GCC diagnostic pop
+
+SCENARIO("GetGainSchedule (M306) parser works", "[gcode][parse][m306]") {
+    GIVEN("a response buffer large enough for the formatted response") {
+        std::string buffer(64, 'c');
+        WHEN("filling response") {
+            auto written = gcode::GetGainSchedule::write_response_into(
+                buffer.begin(), buffer.end(), 1, false, 0.5, 0.25, 1.0);
+            THEN("the response should be written in full") {
+                auto response_str =
+                    "M306 Z:1 C:1 P:0.5000 I:0.2500 D:1.0000 OK\n";
+                REQUIRE_THAT(buffer, Catch::Matchers::StartsWith(response_str));
+                REQUIRE(written == buffer.begin() + strlen(response_str));
+            }
+        }
+    }
+    GIVEN("a response buffer not large enough for the formatted response") {
+        std::string buffer(16, 'c');
+        WHEN("filling response") {
+            auto written = gcode::GetGainSchedule::write_response_into(
+                buffer.begin(), buffer.begin() + 7, 1, false, 0.5, 0.25, 1.0);
+            THEN("the response should write only up to the available space") {
+                std::string response = "M306 Zcccccccccc";
+                response.at(6) = '\0';
+                REQUIRE_THAT(buffer, Catch::Matchers::Equals(response));
+                REQUIRE(written == buffer.begin() + 7);
+            }
+        }
+    }
+    GIVEN("a valid input") {
+        std::string buffer = "M306 Z2 C1\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::GetGainSchedule::parse(buffer.begin(), buffer.end());
+            THEN("a valid gcode should be produced") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(res.second != buffer.begin());
+                REQUIRE(res.first.value().zone == 2);
+                REQUIRE(!res.first.value().heating);
+            }
+        }
+    }
+    GIVEN("an input without a direction") {
+        std::string buffer = "M306 Z2\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::GetGainSchedule::parse(buffer.begin(), buffer.end());
+            THEN("an error should be produced") {
+                REQUIRE(!res.first.has_value());
+                REQUIRE(res.second == buffer.begin());
+            }
+        }
+    }
+}
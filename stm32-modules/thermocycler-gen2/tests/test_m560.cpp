@@ -0,0 +1,53 @@
+#include "catch2/catch.hpp"
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#include "thermocycler-gen2/gcodes.hpp"
+#pragma GCC diagnostic pop
+
+SCENARIO("NewProtocol (M560) parser works", "[gcode][parse][m560]") {
+    GIVEN("a response buffer large enough for the formatted response") {
+        std::string buffer(64, 'c');
+        WHEN("filling response") {
+            auto written = gcode::NewProtocol::write_response_into(
+                buffer.begin(), buffer.end());
+            THEN("the response should be written in full") {
+                REQUIRE_THAT(buffer, Catch::Matchers::StartsWith("M560 OK\n"));
+                REQUIRE(written == buffer.begin() + 8);
+            }
+        }
+    }
+    GIVEN("an input with no arguments") {
+        std::string buffer = "M560\n";
+        WHEN("parsing") {
+            auto res = gcode::NewProtocol::parse(buffer.begin(), buffer.end());
+            THEN("the defaults are used") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(res.second != buffer.begin());
+                REQUIRE(res.first.value().lid_temperature == 0.0F);
+                REQUIRE(res.first.value().volume ==
+                        gcode::NewProtocol::default_volume);
+            }
+        }
+    }
+    GIVEN("an input with a lid temperature and volume") {
+        std::string buffer = "M560 L105 V50\n";
+        WHEN("parsing") {
+            auto res = gcode::NewProtocol::parse(buffer.begin(), buffer.end());
+            THEN("a valid gcode should be produced") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(res.first.value().lid_temperature == 105.0F);
+                REQUIRE(res.first.value().volume == 50.0F);
+            }
+        }
+    }
+    GIVEN("an input with a bad lid temperature") {
+        std::string buffer = "M560 Lxyz\n";
+        WHEN("parsing") {
+            auto res = gcode::NewProtocol::parse(buffer.begin(), buffer.end());
+            THEN("an error should be produced") {
+                REQUIRE(!res.first.has_value());
+                REQUIRE(res.second == buffer.begin());
+            }
+        }
+    }
+}
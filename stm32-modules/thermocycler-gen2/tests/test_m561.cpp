@@ -0,0 +1,53 @@
+#include "catch2/catch.hpp"
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#include "thermocycler-gen2/gcodes.hpp"
+#pragma GCC diagnostic pop
+
+SCENARIO("AddProtocolStage (M561) parser works", "[gcode][parse][m561]") {
+    GIVEN("a response buffer large enough for the formatted response") {
+        std::string buffer(64, 'c');
+        WHEN("filling response") {
+            auto written = gcode::AddProtocolStage::write_response_into(
+                buffer.begin(), buffer.end());
+            THEN("the response should be written in full") {
+                REQUIRE_THAT(buffer, Catch::Matchers::StartsWith("M561 OK\n"));
+                REQUIRE(written == buffer.begin() + 8);
+            }
+        }
+    }
+    GIVEN("a valid input") {
+        std::string buffer = "M561 C30\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::AddProtocolStage::parse(buffer.begin(), buffer.end());
+            THEN("a valid gcode should be produced") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(res.second != buffer.begin());
+                REQUIRE(res.first.value().cycles == 30);
+            }
+        }
+    }
+    GIVEN("an input with zero cycles") {
+        std::string buffer = "M561 C0\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::AddProtocolStage::parse(buffer.begin(), buffer.end());
+            THEN("an error should be produced") {
+                REQUIRE(!res.first.has_value());
+                REQUIRE(res.second == buffer.begin());
+            }
+        }
+    }
+    GIVEN("an input without a cycle count") {
+        std::string buffer = "M561\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::AddProtocolStage::parse(buffer.begin(), buffer.end());
+            THEN("an error should be produced") {
+                REQUIRE(!res.first.has_value());
+                REQUIRE(res.second == buffer.begin());
+            }
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#include "catch2/catch.hpp"
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#include "thermocycler-gen2/gcodes.hpp"
+#pragma GCC diagnostic pop
+
+SCENARIO("AddProtocolStep (M562) parser works", "[gcode][parse][m562]") {
+    GIVEN("a response buffer large enough for the formatted response") {
+        std::string buffer(64, 'c');
+        WHEN("filling response") {
+            auto written = gcode::AddProtocolStep::write_response_into(
+                buffer.begin(), buffer.end());
+            THEN("the response should be written in full") {
+                REQUIRE_THAT(buffer, Catch::Matchers::StartsWith("M562 OK\n"));
+                REQUIRE(written == buffer.begin() + 8);
+            }
+        }
+    }
+    GIVEN("an input without a ramp rate") {
+        std::string buffer = "M562 S95 H30\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::AddProtocolStep::parse(buffer.begin(), buffer.end());
+            THEN("the plate moves at full power") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(res.second != buffer.begin());
+                REQUIRE(res.first.value().temperature == 95.0F);
+                REQUIRE(res.first.value().hold_time == 30.0F);
+                REQUIRE(res.first.value().ramp_rate == 0.0F);
+            }
+        }
+    }
+    GIVEN("an input with a ramp rate") {
+        std::string buffer = "M562 S72 H60 R2.5\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::AddProtocolStep::parse(buffer.begin(), buffer.end());
+            THEN("a valid gcode should be produced") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(res.first.value().temperature == 72.0F);
+                REQUIRE(res.first.value().hold_time == 60.0F);
+                REQUIRE(res.first.value().ramp_rate == 2.5F);
+            }
+        }
+    }
+    GIVEN("an input without a hold time") {
+        std::string buffer = "M562 S95\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::AddProtocolStep::parse(buffer.begin(), buffer.end());
+            THEN("an error should be produced") {
+                REQUIRE(!res.first.has_value());
+                REQUIRE(res.second == buffer.begin());
+            }
+        }
+    }
+}
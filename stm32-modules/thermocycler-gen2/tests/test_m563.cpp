@@ -0,0 +1,64 @@
+#include "catch2/catch.hpp"
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#include "thermocycler-gen2/gcodes.hpp"
+#pragma GCC diagnostic pop
+
+SCENARIO("StartProtocol (M563) parser works", "[gcode][parse][m563]") {
+    GIVEN("a response buffer large enough for the formatted response") {
+        std::string buffer(64, 'c');
+        WHEN("filling response") {
+            auto written = gcode::StartProtocol::write_response_into(
+                buffer.begin(), buffer.end());
+            THEN("the response should be written in full") {
+                REQUIRE_THAT(buffer, Catch::Matchers::StartsWith("M563 OK\n"));
+                REQUIRE(written == buffer.begin() + 8);
+            }
+        }
+    }
+    GIVEN("a valid input") {
+        std::string buffer = "M563\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::StartProtocol::parse(buffer.begin(), buffer.end());
+            THEN("a valid gcode should be produced") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(res.second != buffer.begin());
+                REQUIRE(!res.first.value().preheat);
+            }
+        }
+    }
+    GIVEN("an input that preheats the lid") {
+        std::string buffer = "M563 P1\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::StartProtocol::parse(buffer.begin(), buffer.end());
+            THEN("the preheat flag should be set") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(res.first.value().preheat);
+            }
+        }
+    }
+    GIVEN("an input with an invalid preheat flag") {
+        std::string buffer = "M563 P2\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::StartProtocol::parse(buffer.begin(), buffer.end());
+            THEN("an error should be produced") {
+                REQUIRE(!res.first.has_value());
+                REQUIRE(res.second == buffer.begin());
+            }
+        }
+    }
+    GIVEN("an invalid input") {
+        std::string buffer = "M56\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::StartProtocol::parse(buffer.begin(), buffer.end());
+            THEN("an error should be produced") {
+                REQUIRE(!res.first.has_value());
+                REQUIRE(res.second == buffer.begin());
+            }
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#include "catch2/catch.hpp"
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#include "thermocycler-gen2/gcodes.hpp"
+#pragma GCC diagnostic pop
+
+SCENARIO("GetProtocolStatus (M564) parser works", "[gcode][parse][m564]") {
+    auto progress = pcr_protocol::Progress{
+        .status = pcr_protocol::Status::RUNNING,
+        .stage = 1,
+        .step = 2,
+        .cycle = 4,
+        .cycles = 30};
+    GIVEN("a response buffer large enough for the formatted response") {
+        std::string buffer(64, 'c');
+        WHEN("filling response") {
+            auto written = gcode::GetProtocolStatus::write_response_into(
+                buffer.begin(), buffer.end(), progress, 12.5);
+            THEN("the response counts from 1") {
+                auto response_str = "M564 R:RUNNING S:2 P:3 C:5/30 H:12.5 OK\n";
+                REQUIRE_THAT(buffer, Catch::Matchers::StartsWith(response_str));
+                REQUIRE(written == buffer.begin() + strlen(response_str));
+            }
+        }
+    }
+    GIVEN("a response buffer not large enough for the formatted response") {
+        std::string buffer(16, 'c');
+        WHEN("filling response") {
+            auto written = gcode::GetProtocolStatus::write_response_into(
+                buffer.begin(), buffer.begin() + 7, progress, 12.5);
+            THEN("the response should write only up to the available space") {
+                std::string response = "M564 Rcccccccccc";
+                response.at(6) = '\0';
+                REQUIRE_THAT(buffer, Catch::Matchers::Equals(response));
+                REQUIRE(written == buffer.begin() + 7);
+            }
+        }
+    }
+    GIVEN("a valid input") {
+        std::string buffer = "M564\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::GetProtocolStatus::parse(buffer.begin(), buffer.end());
+            THEN("a valid gcode should be produced") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(res.second != buffer.begin());
+            }
+        }
+    }
+}
@@ -0,0 +1,123 @@
+#include "catch2/catch.hpp"
+#include "core/trace.hpp"
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#include "thermocycler-gen2/gcodes.hpp"
+#pragma GCC diagnostic pop
+
+SCENARIO("GetTraceDebug (M931.D) parser works", "[gcode][parse][m931.d]") {
+    GIVEN("a start command") {
+        std::string buffer = "M931.D E\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::GetTraceDebug::parse(buffer.begin(), buffer.end());
+            THEN("recording is requested") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(res.first.value().start_recording);
+                REQUIRE(res.second != buffer.begin());
+            }
+        }
+    }
+    GIVEN("a read command with an index") {
+        std::string buffer = "M931.D S16\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::GetTraceDebug::parse(buffer.begin(), buffer.end());
+            THEN("the index is parsed") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(!res.first.value().start_recording);
+                REQUIRE(res.first.value().index == 16);
+            }
+        }
+    }
+    GIVEN("a plain command") {
+        std::string buffer = "M931.D\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::GetTraceDebug::parse(buffer.begin(), buffer.end());
+            THEN("the first page is requested") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(!res.first.value().start_recording);
+                REQUIRE(res.first.value().index == 0);
+            }
+        }
+    }
+    GIVEN("a read command without a valid index") {
+        std::string buffer = "M931.D Sx\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::GetTraceDebug::parse(buffer.begin(), buffer.end());
+            THEN("parsing fails") {
+                REQUIRE(!res.first.has_value());
+                REQUIRE(res.second == buffer.begin());
+            }
+        }
+    }
+    GIVEN("an incorrect command") {
+        std::string buffer = "M930.D\n";
+        WHEN("parsing") {
+            auto res =
+                gcode::GetTraceDebug::parse(buffer.begin(), buffer.end());
+            THEN("parsing fails") { REQUIRE(!res.first.has_value()); }
+        }
+    }
+}
+
+SCENARIO("GetTraceDebug (M931.D) response works",
+         "[gcode][response][m931.d]") {
+    trace::TraceBuffer<16> events;
+    events.set_enabled(true);
+    events.record(trace::Event{
+        .timestamp = 0x1a2f0, .id = 1, .phase = trace::Phase::BEGIN});
+    events.record(trace::Event{
+        .timestamp = 0x1a9c4, .id = 1, .phase = trace::Phase::END});
+    events.record(trace::Event{
+        .timestamp = 0x1b000, .id = 4, .phase = trace::Phase::INSTANT});
+    events.set_enabled(false);
+    GIVEN("a response buffer large enough for the formatted response") {
+        std::string buffer(256, 'c');
+        WHEN("writing the first page") {
+            auto command = gcode::GetTraceDebug();
+            auto written = command.write_response_into(
+                buffer.begin(), buffer.end(), events, 170);
+            THEN("all of the events are written") {
+                REQUIRE_THAT(buffer,
+                             Catch::Matchers::StartsWith(
+                                 "M931.D T:170 N:3 S:0 0001a2f0:0001B "
+                                 "0001a9c4:0001E 0001b000:0004i OK\n"));
+                REQUIRE(written != buffer.begin());
+            }
+        }
+        WHEN("writing from an offset") {
+            auto command = gcode::GetTraceDebug{.index = 2};
+            command.write_response_into(buffer.begin(), buffer.end(), events,
+                                      170);
+            THEN("only the later events are written") {
+                REQUIRE_THAT(buffer, Catch::Matchers::StartsWith(
+                                         "M931.D T:170 N:3 S:2 "
+                                         "0001b000:0004i OK\n"));
+            }
+        }
+        WHEN("writing the start response") {
+            auto written = gcode::GetTraceDebug::write_response_into(
+                buffer.begin(), buffer.end());
+            THEN("the response is written") {
+                REQUIRE_THAT(buffer,
+                             Catch::Matchers::StartsWith("M931.D OK\n"));
+                REQUIRE(written != buffer.begin());
+            }
+        }
+    }
+    GIVEN("a response buffer not large enough for the formatted response") {
+        std::string buffer(64, 'c');
+        WHEN("writing the response") {
+            auto command = gcode::GetTraceDebug();
+            auto written = command.write_response_into(
+                buffer.begin(), buffer.begin() + 24, events, 170);
+            THEN("the response is truncated") {
+                REQUIRE(written == buffer.begin() + 24);
+                REQUIRE(buffer.at(24) == 'c');
+            }
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#include "catch2/catch.hpp"
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+#include "thermocycler-gen2/gcodes.hpp"
+#pragma GCC diagnostic pop
+
+SCENARIO("GetThermistorStatsDebug (M932.D) parser works",
+         "[gcode][parse][m932.d]") {
+    GIVEN("a plain command") {
+        std::string buffer = "M932.D\n";
+        WHEN("parsing") {
+            auto res = gcode::GetThermistorStatsDebug::parse(buffer.begin(),
+                                                             buffer.end());
+            THEN("the stats are requested without a reset") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(!res.first.value().reset);
+                REQUIRE(res.second != buffer.begin());
+            }
+        }
+    }
+    GIVEN("a command with a reset") {
+        std::string buffer = "M932.D R\n";
+        WHEN("parsing") {
+            auto res = gcode::GetThermistorStatsDebug::parse(buffer.begin(),
+                                                             buffer.end());
+            THEN("a reset is requested") {
+                REQUIRE(res.first.has_value());
+                REQUIRE(res.first.value().reset);
+                REQUIRE(res.second == buffer.begin() + 8);
+            }
+        }
+    }
+    GIVEN("an incorrect command") {
+        std::string buffer = "M931.D\n";
+        WHEN("parsing") {
+            auto res = gcode::GetThermistorStatsDebug::parse(buffer.begin(),
+                                                             buffer.end());
+            THEN("parsing fails") { REQUIRE(!res.first.has_value()); }
+        }
+    }
+}
+
+SCENARIO("GetThermistorStatsDebug (M932.D) response works",
+         "[gcode][response][m932.d]") {
+    auto stats = gcode::GetThermistorStatsDebug::Summary{.samples = 64};
+    stats.spread = thermistor_stats::ChannelSummary{
+        .mean = 1.5, .stddev = 0.25, .min = 1.0, .max = 2.0};
+    for (size_t i = 0; i < stats.thermistors.size(); ++i) {
+        auto temp = 50.0F + static_cast<float>(i) * 0.5F;
+        stats.thermistors.at(i) = thermistor_stats::ChannelSummary{
+            .mean = temp, .stddev = 0.125, .min = temp - 1, .max = temp + 1};
+    }
+    GIVEN("a response buffer large enough for the formatted response") {
+        std::string buffer(512, 'c');
+        WHEN("writing the response") {
+            auto written = gcode::GetThermistorStatsDebug::write_response_into(
+                buffer.begin(), buffer.end(), stats);
+            THEN("every channel and pair is written") {
+                REQUIRE_THAT(
+                    buffer,
+                    Catch::Matchers::StartsWith(
+                        "M932.D N:64 S:1.50,0.250,1.00,2.00 "
+                        "BL:50.00,0.125,49.00,51.00 "
+                        "FL:50.50,0.125,49.50,51.50 "
+                        "BC:51.00,0.125,50.00,52.00 "
+                        "FC:51.50,0.125,50.50,52.50 "
+                        "BR:52.00,0.125,51.00,53.00 "
+                        "FR:52.50,0.125,51.50,53.50 "
+                        "P:-0.50,-1.00,-1.50,-2.00,-2.50,-0.50,-1.00,-1.50,"
+                        "-2.00,-0.50,-1.00,-1.50,-0.50,-1.00,-0.50 OK\n"));
+                REQUIRE(written != buffer.begin());
+            }
+        }
+    }
+    GIVEN("a response buffer not large enough for the formatted response") {
+        std::string buffer(64, 'c');
+        WHEN("writing the response") {
+            auto written = gcode::GetThermistorStatsDebug::write_response_into(
+                buffer.begin(), buffer.begin() + 24, stats);
+            THEN("the response is truncated") {
+                REQUIRE(written == buffer.begin() + 24);
+                REQUIRE(buffer.at(24) == 'c');
+            }
+        }
+    }
+}
@@ -1,3 +1,5 @@
+#include <limits>
+
 #include "catch2/catch.hpp"
 #include "systemwide.h"
 #include "test/task_builder.hpp"
@@ -631,6 +633,9 @@ struct MotorStep {
     std::optional<SealPos> seal_pos = std::nullopt;
     // If this variable is set, check the lid velocity
     std::optional<double> lid_rpm = std::nullopt;
+    // If this variable is set, check whether the lid movement has a
+    // velocity profile
+    std::optional<bool> lid_profiled = std::nullopt;
     // If true, expect an ack in the host comms task
     std::optional<messages::AcknowledgePrevious> ack = std::nullopt;
 };
@@ -677,6 +682,12 @@ void test_motor_state_machine(std::shared_ptr<TaskBuilder> tasks,
                             step.seal_pos.value());
                 }
             }
+            if (step.lid_profiled.has_value()) {
+                THEN("the lid velocity profile is set correctly") {
+                    REQUIRE(motor_policy.get_lid_profile().enabled() ==
+                            step.lid_profiled.value());
+                }
+            }
             if (step.ack.has_value()) {
                 THEN("an ack is sent to host comms") {
                     auto ack = step.ack.value();
@@ -738,7 +749,8 @@ SCENARIO("motor task lid state machine") {
                  .lid_angle_increased = true,
                  .lid_overdrive = false,
                  .lid_rpm =
-                     motor_task::LidStepperState::LID_DEFAULT_VELOCITY_RPM},
+                     motor_task::LidStepperState::LID_DEFAULT_VELOCITY_RPM,
+                 .lid_profiled = true},
                 // Fourth step overdrives hinge
                 {.msg = messages::LidStepperComplete(),
                  .lid_angle_decreased = true,
@@ -886,7 +898,8 @@ SCENARIO("motor task lid state machine") {
                  .lid_angle_decreased = true,
                  .lid_overdrive = false,
                  .lid_rpm =
-                     motor_task::LidStepperState::LID_DEFAULT_VELOCITY_RPM},
+                     motor_task::LidStepperState::LID_DEFAULT_VELOCITY_RPM,
+                 .lid_profiled = true},
                 // Fourth step overdrives hinge
                 {.msg = messages::LidStepperComplete(),
                  .lid_angle_decreased = true,
@@ -1155,7 +1168,8 @@ SCENARIO("motor task lid state machine") {
                  .lid_angle_increased = true,
                  .lid_overdrive = false,
                  .lid_rpm =
-                     motor_task::LidStepperState::LID_DEFAULT_VELOCITY_RPM},
+                     motor_task::LidStepperState::LID_DEFAULT_VELOCITY_RPM,
+                 .lid_profiled = false},
                 // Fourth step overdrives hinge
                 {.msg = messages::LidStepperComplete(),
                  .lid_angle_decreased = true,
@@ -1271,3 +1285,166 @@ SCENARIO("motor task lid state machine") {
         }
     }
 }
+
+SCENARIO("motor task seal stallguard calibration") {
+    GIVEN("a motor task with the lid open") {
+        auto tasks = TaskBuilder::build();
+        auto &motor_policy = tasks->get_motor_policy();
+        auto &motor_queue = tasks->get_motor_queue();
+        auto &comms_queue = tasks->get_host_comms_queue();
+        using Reason = messages::SealStepperComplete::CompletionReason;
+        motor_policy.set_lid_open_switch(true);
+        WHEN("the lid is not open") {
+            motor_policy.set_lid_open_switch(false);
+            motor_queue.backing_deque.push_back(
+                messages::CalibrateSealStallMessage{.id = 123});
+            tasks->run_motor_task();
+            THEN("the calibration is refused") {
+                REQUIRE(!motor_policy.seal_moving());
+                auto response = std::get<messages::CalibrateSealStallResponse>(
+                    comms_queue.backing_deque.front());
+                REQUIRE(response.responding_to_id == 123);
+                REQUIRE(response.with_error == errors::ErrorCode::LID_CLOSED);
+            }
+        }
+        WHEN("starting a calibration") {
+            motor_queue.backing_deque.push_back(
+                messages::CalibrateSealStallMessage{.id = 123});
+            tasks->run_motor_task();
+            THEN("the seal retracts to the switch") {
+                REQUIRE(motor_policy.seal_moving());
+                REQUIRE(motor_policy.get_tmc2130_direction());
+                REQUIRE(motor_policy.retraction_switch_is_armed());
+                REQUIRE(comms_queue.backing_deque.empty());
+            }
+            AND_WHEN("the seal sweeps at each velocity") {
+                motor_queue.backing_deque.push_back(
+                    messages::SealStepperComplete{.reason = Reason::LIMIT});
+                tasks->run_motor_task();
+                motor_queue.backing_deque.push_back(
+                    messages::SealStepperComplete{.reason = Reason::DONE});
+                tasks->run_motor_task();
+                REQUIRE(!motor_policy.get_tmc2130_direction());
+                REQUIRE(motor_policy.read_register(
+                            tmc2130::Registers::TCOOLTHRS) == 0);
+                // The tick interrupt asks for samples while sweeping
+                for (int i = 0; i < 10000; ++i) {
+                    motor_policy.tick();
+                }
+                REQUIRE(
+                    std::holds_alternative<messages::SealStallSampleMessage>(
+                        motor_queue.backing_deque.front()));
+                motor_queue.backing_deque.clear();
+                using Calibration = motor_task::SealCalibrationState;
+                for (auto velocity : Calibration::VELOCITIES) {
+                    motor_policy.write_register(
+                        tmc2130::Registers::TSTEP,
+                        motor_util::SealStepper::velocity_to_tstep(velocity));
+                    motor_policy.write_register(tmc2130::Registers::DRVSTATUS,
+                                                200);
+                    for (int i = 0; i < 10; ++i) {
+                        motor_queue.backing_deque.push_back(
+                            messages::SealStallSampleMessage{});
+                        tasks->run_motor_task();
+                    }
+                    motor_queue.backing_deque.push_back(
+                        messages::SealStepperComplete{.reason = Reason::DONE});
+                    tasks->run_motor_task();
+                }
+                THEN("the calibration is reported and saved") {
+                    REQUIRE(!motor_policy.seal_moving());
+                    auto response =
+                        std::get<messages::CalibrateSealStallResponse>(
+                            comms_queue.backing_deque.front());
+                    REQUIRE(response.responding_to_id == 123);
+                    REQUIRE(response.with_error ==
+                            errors::ErrorCode::NO_ERROR);
+                    REQUIRE(response.calibration.sgt == 4);
+                    REQUIRE(response.calibration.min_velocity == 40000);
+                    REQUIRE(response.calibration.home_velocity == 240000);
+                    auto &plate_queue = tasks->get_thermal_plate_queue();
+                    REQUIRE(std::holds_alternative<
+                            messages::SaveSealCalibrationMessage>(
+                        plate_queue.backing_deque.front()));
+                }
+                AND_WHEN("the seal retracts to open the lid") {
+                    comms_queue.backing_deque.clear();
+                    motor_policy.set_lid_open_switch(false);
+                    motor_queue.backing_deque.push_back(
+                        messages::OpenLidMessage{.id = 456});
+                    tasks->run_motor_task();
+                    THEN("stall detection is on above the minimum velocity") {
+                        REQUIRE(motor_policy.seal_moving());
+                        REQUIRE(motor_policy.retraction_switch_is_armed());
+                        REQUIRE(motor_policy.read_register(
+                                    tmc2130::Registers::TCOOLTHRS) == 400);
+                    }
+                    AND_WHEN("the seal stalls at the retraction switch") {
+                        motor_policy.set_retraction_switch_triggered(true);
+                        motor_queue.backing_deque.push_back(
+                            messages::SealStepperComplete{
+                                .reason = Reason::STALL});
+                        tasks->run_motor_task();
+                        THEN("stall detection is turned off again") {
+                            REQUIRE(motor_policy.read_register(
+                                        tmc2130::Registers::TCOOLTHRS) == 0);
+                            REQUIRE(comms_queue.backing_deque.empty());
+                        }
+                        THEN("the lid carries on opening") {
+                            REQUIRE(tasks->get_motor_task().get_lid_state() !=
+                                    motor_task::LidState::Status::IDLE);
+                        }
+                    }
+                    AND_WHEN("the seal stalls partway through its travel") {
+                        for (int i = 0; i < 1000; ++i) {
+                            motor_policy.tick();
+                        }
+                        motor_queue.backing_deque.push_back(
+                            messages::SealStepperComplete{
+                                .reason = Reason::STALL});
+                        tasks->run_motor_task();
+                        THEN("the lid stops with an error") {
+                            REQUIRE(motor_policy.read_register(
+                                        tmc2130::Registers::TCOOLTHRS) == 0);
+                            REQUIRE(tasks->get_motor_task().get_lid_state() ==
+                                    motor_task::LidState::Status::IDLE);
+                            REQUIRE(tasks->get_motor_task()
+                                        .get_seal_position() ==
+                                    motor_util::SealStepper::Status::UNKNOWN);
+                            auto response =
+                                std::get<messages::AcknowledgePrevious>(
+                                    comms_queue.backing_deque.front());
+                            REQUIRE(response.responding_to_id == 456);
+                            REQUIRE(response.with_error ==
+                                    errors::ErrorCode::SEAL_MOTOR_STALL);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Times the seal stepper tick as the timer interrupt runs it: the policy
+// calls the bound delegate, which runs the motor task's seal step callback
+// against a real movement profile. Hidden from the normal test run; run it
+// with the [benchmark] tag.
+TEST_CASE("seal stepper tick benchmark", "[.][benchmark]") {
+    constexpr int ticks = 1000;
+    auto tasks = TaskBuilder::build();
+    auto &motor_policy = tasks->get_motor_policy();
+    auto &motor_queue = tasks->get_motor_queue();
+    // Long enough that the benchmark never reaches the end of the move
+    motor_queue.backing_deque.push_back(messages::SealStepperDebugMessage{
+        .id = 123, .steps = std::numeric_limits<int32_t>::max()});
+    tasks->run_motor_task();
+    REQUIRE(motor_policy.seal_moving());
+
+    BENCHMARK("seal stepper, 1000 ticks") {
+        for (int i = 0; i < ticks; ++i) {
+            motor_policy.tick();
+        }
+        return motor_policy.get_tmc2130_steps();
+    };
+    REQUIRE(motor_policy.seal_moving());
+}
@@ -382,3 +382,79 @@ SCENARIO("MovementProfile input sanitization") {
         }
     }
 }
+
+SCENARIO("LidProfile functionality") {
+    GIVEN("a profile with room to reach its peak speed") {
+        constexpr uint32_t fast_steps = 100000;
+        auto profile = LidProfile(60, 200, 125, 400, fast_steps);
+        REQUIRE(profile.enabled());
+        THEN("the first step is at the start speed") {
+            REQUIRE(profile.next_rpm() == Approx(60));
+            REQUIRE(profile.steps() == 1);
+        }
+        THEN("the speed rises, holds at the peak, then falls") {
+            float last = 0;
+            bool peaked = false;
+            for (uint32_t step = 0; step < fast_steps; step += 100) {
+                auto rpm = profile.rpm_at(step);
+                REQUIRE(rpm <= 200);
+                if (rpm == Approx(200)) {
+                    peaked = true;
+                } else if (!peaked) {
+                    REQUIRE(rpm > last);
+                } else {
+                    REQUIRE(rpm <= last);
+                }
+                last = rpm;
+            }
+            REQUIRE(peaked);
+        }
+        THEN("the speed follows the acceleration") {
+            // v^2 = v0^2 + 2as, converting RPM/s into RPM^2/step
+            const uint32_t step = 1000;
+            auto expected =
+                std::sqrt(60.0 * 60.0 +
+                          2.0 * 400.0 * step /
+                              LidStepper::MICROSTEPS_PER_SECOND_PER_RPM);
+            REQUIRE(profile.rpm_at(step) == Approx(expected).epsilon(0.001));
+        }
+        THEN("it reaches the approach speed after the fast steps") {
+            REQUIRE(profile.rpm_at(fast_steps) == Approx(125));
+            REQUIRE(profile.rpm_at(fast_steps * 2) == Approx(125));
+        }
+        WHEN("resetting after some steps") {
+            static_cast<void>(profile.next_rpm());
+            static_cast<void>(profile.next_rpm());
+            profile.reset();
+            THEN("it starts over") {
+                REQUIRE(profile.steps() == 0);
+                REQUIRE(profile.next_rpm() == Approx(60));
+            }
+        }
+    }
+    GIVEN("a profile too short to reach its peak speed") {
+        auto profile = LidProfile(60, 200, 125, 400, 1000);
+        THEN("it never goes above the speed it can still slow down from") {
+            for (uint32_t step = 0; step < 1000; ++step) {
+                REQUIRE(profile.rpm_at(step) < 200);
+            }
+            REQUIRE(profile.rpm_at(1000) <= 125);
+        }
+    }
+    GIVEN("invalid profiles") {
+        THEN("the default profile is disabled") {
+            auto profile = LidProfile();
+            REQUIRE(!profile.enabled());
+            REQUIRE(profile.next_rpm() == 0);
+        }
+        THEN("a profile without acceleration is disabled") {
+            REQUIRE(!LidProfile(60, 200, 125, 0, 1000).enabled());
+        }
+        THEN("a profile without a start speed is disabled") {
+            REQUIRE(!LidProfile(0, 200, 125, 400, 1000).enabled());
+        }
+        THEN("a profile without fast steps is disabled") {
+            REQUIRE(!LidProfile(60, 200, 125, 400, 0).enabled());
+        }
+    }
+}
@@ -0,0 +1,167 @@
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "thermocycler-gen2/pcr_protocol.hpp"
+
+using namespace pcr_protocol;
+
+static constexpr Step DENATURE{.temperature = 95.0, .hold_time = 10.0};
+static constexpr Step ANNEAL{.temperature = 55.0, .hold_time = 30.0};
+static constexpr Step EXTEND{
+    .temperature = 72.0, .hold_time = 60.0, .ramp_rate = 2.0};
+
+SCENARIO("pcr protocol engine") {
+    GIVEN("an empty protocol") {
+        auto engine = ProtocolEngine();
+        REQUIRE(engine.status() == Status::IDLE);
+        THEN("it cannot be started") { REQUIRE(!engine.start().has_value()); }
+        THEN("steps cannot be added before a stage") {
+            REQUIRE(!engine.add_step(DENATURE));
+        }
+        THEN("invalid stages are rejected") {
+            REQUIRE(!engine.add_stage(0));
+            REQUIRE(!engine.add_stage(ProtocolEngine::MAX_CYCLES + 1));
+        }
+        THEN("an invalid lid temperature is rejected") {
+            REQUIRE(!engine.clear(
+                ProtocolEngine::MAX_LID_TEMPERATURE_C + 1.0, 25.0));
+            REQUIRE(!engine.clear(-1.0, 25.0));
+        }
+        WHEN("adding a stage without steps") {
+            REQUIRE(engine.add_stage(1));
+            THEN("it cannot be started") {
+                REQUIRE(!engine.start().has_value());
+            }
+            THEN("invalid steps are rejected") {
+                REQUIRE(!engine.add_step(Step{.temperature = 150.0,
+                                              .hold_time = 1.0}));
+                REQUIRE(!engine.add_step(Step{.temperature = 50.0,
+                                              .hold_time = 0.0}));
+                REQUIRE(!engine.add_step(Step{.temperature = 50.0,
+                                              .hold_time = 1.0,
+                                              .ramp_rate = -1.0}));
+                REQUIRE(engine.step_count() == 0);
+            }
+        }
+        WHEN("filling the profile") {
+            for (size_t i = 0; i < ProtocolEngine::MAX_STAGES; ++i) {
+                REQUIRE(engine.add_stage(1));
+            }
+            for (size_t i = 0; i < ProtocolEngine::MAX_STEPS; ++i) {
+                REQUIRE(engine.add_step(DENATURE));
+            }
+            THEN("no more stages or steps fit") {
+                REQUIRE(!engine.add_stage(1));
+                REQUIRE(!engine.add_step(DENATURE));
+            }
+        }
+    }
+    GIVEN("a two stage protocol") {
+        auto engine = ProtocolEngine();
+        REQUIRE(engine.clear(105.0, 50.0));
+        REQUIRE(engine.add_stage(1));
+        REQUIRE(engine.add_step(DENATURE));
+        REQUIRE(engine.add_stage(3));
+        REQUIRE(engine.add_step(DENATURE));
+        REQUIRE(engine.add_step(ANNEAL));
+        REQUIRE(engine.add_step(EXTEND));
+        REQUIRE(engine.stage_count() == 2);
+        REQUIRE(engine.step_count() == 4);
+        REQUIRE(engine.lid_temperature() == 105.0);
+        REQUIRE(engine.volume() == 50.0);
+        WHEN("running it") {
+            auto first = engine.start();
+            THEN("it starts on the first step") {
+                REQUIRE(first.has_value());
+                REQUIRE(first.value().temperature == DENATURE.temperature);
+                REQUIRE(engine.running());
+                REQUIRE(engine.progress().cycles == 1);
+            }
+            THEN("it cannot be changed or restarted") {
+                REQUIRE(!engine.start().has_value());
+                REQUIRE(!engine.clear(0.0, 25.0));
+                REQUIRE(!engine.add_stage(1));
+                REQUIRE(!engine.add_step(DENATURE));
+            }
+            AND_WHEN("advancing through every step") {
+                std::vector<double> temperatures;
+                for (int i = 0; i < 20; ++i) {
+                    auto next = engine.advance();
+                    if (!next.has_value()) {
+                        break;
+                    }
+                    temperatures.push_back(next.value().temperature);
+                }
+                THEN("each cycle of the second stage is run in order") {
+                    auto expected = std::vector<double>{95.0, 55.0, 72.0,
+                                                        95.0, 55.0, 72.0,
+                                                        95.0, 55.0, 72.0};
+                    REQUIRE(temperatures == expected);
+                    REQUIRE(engine.status() == Status::COMPLETE);
+                }
+                THEN("the progress points at the final step") {
+                    auto progress = engine.progress();
+                    REQUIRE(progress.stage == 1);
+                    REQUIRE(progress.step == 2);
+                    REQUIRE(progress.cycle == 2);
+                    REQUIRE(progress.cycles == 3);
+                }
+                THEN("the same protocol can be run again") {
+                    REQUIRE(engine.start().has_value());
+                    REQUIRE(engine.progress().stage == 0);
+                }
+            }
+            AND_WHEN("advancing into the second stage") {
+                static_cast<void>(engine.advance());
+                static_cast<void>(engine.advance());
+                THEN("the progress tracks the position") {
+                    auto progress = engine.progress();
+                    REQUIRE(progress.stage == 1);
+                    REQUIRE(progress.step == 1);
+                    REQUIRE(progress.cycle == 0);
+                    REQUIRE(progress.cycles == 3);
+                }
+            }
+            AND_WHEN("aborting") {
+                engine.abort();
+                THEN("the run stops") {
+                    REQUIRE(engine.status() == Status::ABORTED);
+                    REQUIRE(!engine.advance().has_value());
+                }
+            }
+        }
+        WHEN("preheating it") {
+            auto first = engine.preheat();
+            THEN("the first step is returned without running it") {
+                REQUIRE(first.has_value());
+                REQUIRE(first.value().temperature == DENATURE.temperature);
+                REQUIRE(engine.status() == Status::PREHEATING);
+                REQUIRE(!engine.running());
+                REQUIRE(!engine.advance().has_value());
+            }
+            THEN("it cannot be changed or preheated again") {
+                REQUIRE(!engine.preheat().has_value());
+                REQUIRE(!engine.clear(0.0, 25.0));
+                REQUIRE(!engine.add_stage(1));
+                REQUIRE(!engine.add_step(DENATURE));
+            }
+            AND_WHEN("starting it once the lid is ready") {
+                auto started = engine.start();
+                THEN("it runs from the first step") {
+                    REQUIRE(started.has_value());
+                    REQUIRE(started.value().temperature ==
+                            DENATURE.temperature);
+                    REQUIRE(engine.running());
+                    REQUIRE(engine.progress().stage == 0);
+                }
+            }
+            AND_WHEN("aborting") {
+                engine.abort();
+                THEN("the preheat stops") {
+                    REQUIRE(engine.status() == Status::ABORTED);
+                    REQUIRE(!engine.active());
+                }
+            }
+        }
+    }
+}
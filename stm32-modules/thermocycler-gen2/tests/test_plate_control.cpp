@@ -556,8 +556,11 @@ SCENARIO("PlateControl active fan control works") {
                 plateControl.calculate_undershoot(COLD_TEMP, input_volume);
             auto ctrl = plateControl.update_control(UPDATE_RATE_SEC);
             REQUIRE(ctrl.has_value());
-            THEN("the fan should drive at exactly 0.7") {
-                REQUIRE(ctrl.value().fan_power == 0.7F);
+            THEN("the fan feed-forward drives the fan past 0.7") {
+                REQUIRE(plateControl.fan_feedforward() ==
+                        plate_control::PlateControl::FAN_FEEDFORWARD_GAIN);
+                REQUIRE(ctrl.value().fan_power ==
+                        plate_control::PlateControl::FAN_POWER_RAMP_DOWN_MAX);
             }
             AND_WHEN("the target temperature is reached with heatsink at 60") {
                 set_temp(thermistors, undershot_target, 60.0F);
@@ -574,6 +577,7 @@ SCENARIO("PlateControl active fan control works") {
             auto ctrl = plateControl.update_control(UPDATE_RATE_SEC);
             REQUIRE(ctrl.has_value());
             THEN("the fan should drive at exactly 0.15") {
+                REQUIRE(plateControl.fan_feedforward() == 0.0F);
                 REQUIRE(ctrl.value().fan_power == 0.15F);
             }
             AND_WHEN(
@@ -624,3 +628,352 @@ SCENARIO("PlateControl active fan control works") {
         }
     }
 }
+
+// Get the plate into steady state at WARM_TEMP. The center channel aims
+// a bit past the target while heating, so it has to get there first.
+static void settle_at_target(plate_control::PlateControl &plateControl,
+                             std::vector<Thermistor> &thermistors,
+                             Peltier &center) {
+    set_temp(thermistors, WARM_TEMP, ROOM_TEMP);
+    center.thermistors.first.temp_c = WARM_TEMP + 1.5;
+    center.thermistors.second.temp_c = WARM_TEMP + 1.5;
+    plateControl.update_control(UPDATE_RATE_SEC);
+    set_temp(thermistors, WARM_TEMP, ROOM_TEMP);
+}
+
+SCENARIO("PlateControl fan feed-forward works") {
+    GIVEN("a PlateControl object with room temperature thermistors") {
+        constexpr double input_volume = 20.0F;
+        std::vector<Thermistor> thermistors;
+        for (int i = 0; i < (PeltierID::PELTIER_NUMBER * 2) + 1; ++i) {
+            thermistors.push_back(Thermistor{
+                .temp_c = ROOM_TEMP,
+                .overtemp_limit_c = 105.0,
+                .disconnected_error =
+                    errors::ErrorCode::THERMISTOR_HEATSINK_DISCONNECTED,
+                .short_error = errors::ErrorCode::THERMISTOR_HEATSINK_SHORT,
+                .overtemp_error =
+                    errors::ErrorCode::THERMISTOR_HEATSINK_OVERTEMP,
+                .error_bit = (uint8_t)(1 << i)});
+        }
+        Peltier left{.id = PeltierID::PELTIER_LEFT,
+                     .thermistors = Peltier::ThermistorPair(
+                         thermistors.at(THERM_BACK_LEFT),
+                         thermistors.at(THERM_FRONT_LEFT)),
+                     .pid = PID(1, 0, 0, UPDATE_RATE_SEC, 1.0, -1.0)};
+        Peltier right{.id = PeltierID::PELTIER_RIGHT,
+                      .thermistors = Peltier::ThermistorPair(
+                          thermistors.at(THERM_BACK_RIGHT),
+                          thermistors.at(THERM_FRONT_RIGHT)),
+                      .pid = PID(1, 0, 0, UPDATE_RATE_SEC, 1.0, -1.0)};
+        Peltier center{.id = PeltierID::PELTIER_CENTER,
+                       .thermistors = Peltier::ThermistorPair(
+                           thermistors.at(THERM_BACK_CENTER),
+                           thermistors.at(THERM_FRONT_CENTER)),
+                       .pid = PID(1, 0, 0, UPDATE_RATE_SEC, 1.0, -1.0)};
+        HeatsinkFan fan{.thermistor = thermistors.at(THERM_HEATSINK),
+                        .pid = PID(1, 0, 0, UPDATE_RATE_SEC, 1.0, -1.0)};
+        auto plateControl =
+            plate_control::PlateControl(left, right, center, fan);
+        WHEN("the peltiers cool the plate while holding a warm target") {
+            plateControl.set_new_target(WARM_TEMP, input_volume);
+            settle_at_target(plateControl, thermistors, center);
+            plateControl.update_control(UPDATE_RATE_SEC);
+            REQUIRE(plateControl.status() ==
+                    plate_control::PlateStatus::STEADY_STATE);
+            set_temp(thermistors, WARM_TEMP + 3.0F, ROOM_TEMP);
+            auto ctrl = plateControl.update_control(UPDATE_RATE_SEC);
+            REQUIRE(ctrl.has_value());
+            THEN("the fan speeds up before the heatsink warms up") {
+                REQUIRE(plateControl.fan_feedforward() > 0.0F);
+                REQUIRE_THAT(
+                    ctrl.value().fan_power,
+                    Catch::Matchers::WithinAbs(
+                        plate_control::PlateControl::
+                                FAN_POWER_UNDER_WARM_THRESHOLD +
+                            plateControl.fan_feedforward(),
+                        0.0001));
+            }
+        }
+        WHEN("the peltiers ramp down to a warm target") {
+            set_temp(thermistors, HOT_TEMP, ROOM_TEMP);
+            plateControl.set_new_target(WARM_TEMP, input_volume);
+            auto ctrl = plateControl.update_control(UPDATE_RATE_SEC);
+            REQUIRE(ctrl.has_value());
+            THEN("the fan drives harder than the fixed ramp power") {
+                REQUIRE(
+                    ctrl.value().fan_power >
+                    plate_control::PlateControl::FAN_POWER_RAMP_DOWN_NON_COLD);
+                REQUIRE(ctrl.value().fan_power <=
+                        plate_control::PlateControl::FAN_POWER_RAMP_DOWN_MAX);
+            }
+        }
+    }
+}
+
+SCENARIO("PlateControl sample hold works") {
+    GIVEN("a PlateControl object with room temperature thermistors") {
+        // Small enough that the target isn't overshot
+        constexpr double input_volume = 20.0F;
+        constexpr double hold_time = 5.0F;
+        std::vector<Thermistor> thermistors;
+        for (int i = 0; i < (PeltierID::PELTIER_NUMBER * 2) + 1; ++i) {
+            thermistors.push_back(Thermistor{
+                .temp_c = ROOM_TEMP,
+                .overtemp_limit_c = 105.0,
+                .disconnected_error =
+                    errors::ErrorCode::THERMISTOR_HEATSINK_DISCONNECTED,
+                .short_error = errors::ErrorCode::THERMISTOR_HEATSINK_SHORT,
+                .overtemp_error =
+                    errors::ErrorCode::THERMISTOR_HEATSINK_OVERTEMP,
+                .error_bit = (uint8_t)(1 << i)});
+        }
+        Peltier left{.id = PeltierID::PELTIER_LEFT,
+                     .thermistors = Peltier::ThermistorPair(
+                         thermistors.at(THERM_BACK_LEFT),
+                         thermistors.at(THERM_FRONT_LEFT)),
+                     .pid = PID(1, 0, 0, UPDATE_RATE_SEC, 1.0, -1.0)};
+        Peltier right{.id = PeltierID::PELTIER_RIGHT,
+                      .thermistors = Peltier::ThermistorPair(
+                          thermistors.at(THERM_BACK_RIGHT),
+                          thermistors.at(THERM_FRONT_RIGHT)),
+                      .pid = PID(1, 0, 0, UPDATE_RATE_SEC, 1.0, -1.0)};
+        Peltier center{.id = PeltierID::PELTIER_CENTER,
+                       .thermistors = Peltier::ThermistorPair(
+                           thermistors.at(THERM_BACK_CENTER),
+                           thermistors.at(THERM_FRONT_CENTER)),
+                       .pid = PID(1, 0, 0, UPDATE_RATE_SEC, 1.0, -1.0)};
+        HeatsinkFan fan{.thermistor = thermistors.at(THERM_HEATSINK),
+                        .pid = PID(1, 0, 0, UPDATE_RATE_SEC, 1.0, -1.0)};
+        auto plateControl =
+            plate_control::PlateControl(left, right, center, fan);
+        THEN("sample holds are disabled by default") {
+            REQUIRE(!plateControl.sample_hold());
+        }
+        WHEN("the plate jumps to a target with sample holds enabled") {
+            plateControl.set_sample_hold(true);
+            plateControl.update_control(UPDATE_RATE_SEC);
+            plateControl.set_new_target(WARM_TEMP, input_volume, hold_time);
+            settle_at_target(plateControl, thermistors, center);
+            // Long enough for the plate to settle, but nowhere near long
+            // enough for the sample to catch up
+            for (int i = 0; i < 10; ++i) {
+                plateControl.update_control(UPDATE_RATE_SEC);
+            }
+            THEN("the hold doesn't start until the sample gets there") {
+                REQUIRE(plateControl.status() ==
+                        plate_control::PlateStatus::STEADY_STATE);
+                REQUIRE(plateControl.sample_temp() < WARM_TEMP - 1.0F);
+                REQUIRE(plateControl.get_hold_time().first == hold_time);
+                REQUIRE(!plateControl.hold_complete());
+            }
+            AND_WHEN("the thermistors drift apart during the hold") {
+                for (double t = 0;
+                     t < plate_control::PlateControl::UNIFORMITY_CHECK_DELAY;
+                     t += UPDATE_RATE_SEC) {
+                    plateControl.update_control(UPDATE_RATE_SEC);
+                }
+                thermistors.at(THERM_BACK_LEFT).temp_c = WARM_TEMP - 2.1;
+                thermistors.at(THERM_FRONT_CENTER).temp_c = WARM_TEMP + 2.1;
+                THEN("the drift is flagged") {
+                    REQUIRE(plateControl.status() ==
+                            plate_control::PlateStatus::STEADY_STATE);
+                    REQUIRE(!plateControl.thermistor_drift_check());
+                }
+            }
+            AND_WHEN("the sample settles at the target") {
+                double elapsed = 0.0F;
+                while (plateControl.sample_temp() <
+                       WARM_TEMP -
+                           plate_control::PlateControl::
+                               SAMPLE_SETPOINT_THRESHOLD) {
+                    plateControl.update_control(UPDATE_RATE_SEC);
+                    elapsed += UPDATE_RATE_SEC;
+                    REQUIRE(elapsed < 60.0F);
+                }
+                THEN("the hold counts down") {
+                    plateControl.update_control(UPDATE_RATE_SEC);
+                    REQUIRE(plateControl.get_hold_time().first < hold_time);
+                }
+                THEN("the hold completes after the hold time") {
+                    for (double t = 0; t < hold_time + UPDATE_RATE_SEC;
+                         t += UPDATE_RATE_SEC) {
+                        plateControl.update_control(UPDATE_RATE_SEC);
+                    }
+                    REQUIRE(plateControl.hold_complete());
+                }
+            }
+        }
+        WHEN("the plate jumps to a target with sample holds disabled") {
+            plateControl.set_new_target(WARM_TEMP, input_volume, hold_time);
+            settle_at_target(plateControl, thermistors, center);
+            for (int i = 0; i < 10; ++i) {
+                plateControl.update_control(UPDATE_RATE_SEC);
+            }
+            THEN("the hold starts as soon as the plate settles") {
+                REQUIRE(plateControl.status() ==
+                        plate_control::PlateStatus::STEADY_STATE);
+                REQUIRE(plateControl.get_hold_time().first < hold_time);
+            }
+        }
+    }
+}
+
+SCENARIO("PlateControl gain scheduling works") {
+    GIVEN("a PlateControl object with room temperature thermistors") {
+        constexpr double input_volume = 5.0F;
+        constexpr double ramp_rate = 10.0F;
+        std::vector<Thermistor> thermistors;
+        for (int i = 0; i < (PeltierID::PELTIER_NUMBER * 2) + 1; ++i) {
+            thermistors.push_back(Thermistor{
+                .temp_c = ROOM_TEMP,
+                .overtemp_limit_c = 105.0,
+                .disconnected_error =
+                    errors::ErrorCode::THERMISTOR_HEATSINK_DISCONNECTED,
+                .short_error = errors::ErrorCode::THERMISTOR_HEATSINK_SHORT,
+                .overtemp_error =
+                    errors::ErrorCode::THERMISTOR_HEATSINK_OVERTEMP,
+                .error_bit = (uint8_t)(1 << i)});
+        }
+        Peltier left{.id = PeltierID::PELTIER_LEFT,
+                     .thermistors = Peltier::ThermistorPair(
+                         thermistors.at(THERM_BACK_LEFT),
+                         thermistors.at(THERM_FRONT_LEFT)),
+                     .pid = PID(1, 0, 0, UPDATE_RATE_SEC, 1.0, -1.0)};
+        Peltier right{.id = PeltierID::PELTIER_RIGHT,
+                      .thermistors = Peltier::ThermistorPair(
+                          thermistors.at(THERM_BACK_RIGHT),
+                          thermistors.at(THERM_FRONT_RIGHT)),
+                      .pid = PID(1, 0, 0, UPDATE_RATE_SEC, 1.0, -1.0)};
+        Peltier center{.id = PeltierID::PELTIER_CENTER,
+                       .thermistors = Peltier::ThermistorPair(
+                           thermistors.at(THERM_BACK_CENTER),
+                           thermistors.at(THERM_FRONT_CENTER)),
+                       .pid = PID(1, 0, 0, UPDATE_RATE_SEC, 1.0, -1.0)};
+        HeatsinkFan fan{.thermistor = thermistors.at(THERM_HEATSINK),
+                        .pid = PID(1, 0, 0, UPDATE_RATE_SEC, 1.0, -1.0)};
+        auto plateControl =
+            plate_control::PlateControl(left, right, center, fan);
+        THEN("there is no schedule by default") {
+            REQUIRE(!plateControl.schedule().has_value());
+        }
+        THEN("temperatures map to the fan zones") {
+            REQUIRE(plateControl.schedule_zone(COLD_TEMP) ==
+                    gain_schedule::Zone::COLD);
+            REQUIRE(plateControl.schedule_zone(WARM_TEMP) ==
+                    gain_schedule::Zone::WARM);
+            REQUIRE(plateControl.schedule_zone(HOT_TEMP) ==
+                    gain_schedule::Zone::HOT);
+        }
+        WHEN("moving to a new target without a schedule") {
+            plateControl.set_new_target(COLD_TEMP, input_volume);
+            plateControl.update_control(UPDATE_RATE_SEC);
+            THEN("the gains are left alone") {
+                REQUIRE(left.pid.kp() == 1.0);
+                REQUIRE(center.pid.kp() == 1.0);
+            }
+        }
+        AND_GIVEN("a gain schedule") {
+            auto schedule = gain_schedule::GainSchedule(
+                gain_schedule::Gains{.kp = 1.0, .ki = 0.0, .kd = 0.0});
+            schedule.set(gain_schedule::Zone::WARM, true,
+                         gain_schedule::Gains{.kp = 2.0, .ki = 0, .kd = 0});
+            schedule.set(gain_schedule::Zone::HOT, true,
+                         gain_schedule::Gains{.kp = 3.0, .ki = 0, .kd = 0});
+            schedule.set(gain_schedule::Zone::COLD, false,
+                         gain_schedule::Gains{.kp = 0.5, .ki = 0, .kd = 0});
+            plateControl.set_gain_schedule(schedule);
+            WHEN("cooling to a cold target") {
+                plateControl.set_new_target(COLD_TEMP, input_volume);
+                plateControl.update_control(UPDATE_RATE_SEC);
+                THEN("the cold cooling gains are used") {
+                    REQUIRE(left.pid.kp() == 0.5);
+                    REQUIRE(right.pid.kp() == 0.5);
+                    REQUIRE(center.pid.kp() == 0.5);
+                }
+            }
+            WHEN("ramping up from room temperature to a hot target") {
+                plateControl.set_new_target(HOT_TEMP, input_volume, 0.0F,
+                                            ramp_rate);
+                plateControl.update_control(UPDATE_RATE_SEC);
+                THEN("the warm heating gains are used at first") {
+                    REQUIRE(left.pid.kp() == 2.0);
+                }
+                AND_WHEN("the ramp crosses into the hot zone") {
+                    // Keep the plate just behind the ramp
+                    double last_power = 0.0F;
+                    double switch_step = 0.0F;
+                    while (left.temp_target < WARM_TEMP + 10.0F) {
+                        set_temp(thermistors, left.temp_target - 0.1F,
+                                 ROOM_TEMP);
+                        auto last_kp = left.pid.kp();
+                        auto ctrl =
+                            plateControl.update_control(UPDATE_RATE_SEC);
+                        REQUIRE(ctrl.has_value());
+                        if (left.pid.kp() != last_kp) {
+                            switch_step =
+                                std::abs(ctrl.value().left_power - last_power);
+                        }
+                        last_power = ctrl.value().left_power;
+                    }
+                    THEN("the hot heating gains are used") {
+                        REQUIRE(left.pid.kp() == 3.0);
+                    }
+                    THEN("the output doesn't jump when the gains change") {
+                        REQUIRE(switch_step < 0.01);
+                    }
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("PlateControl ramp time estimate works") {
+    GIVEN("a PlateControl object with room temperature thermistors") {
+        using namespace plate_control;
+        std::vector<Thermistor> thermistors;
+        for (int i = 0; i < (PeltierID::PELTIER_NUMBER * 2) + 1; ++i) {
+            thermistors.push_back(Thermistor{
+                .temp_c = ROOM_TEMP,
+                .overtemp_limit_c = 105.0,
+                .disconnected_error =
+                    errors::ErrorCode::THERMISTOR_HEATSINK_DISCONNECTED,
+                .short_error = errors::ErrorCode::THERMISTOR_HEATSINK_SHORT,
+                .overtemp_error =
+                    errors::ErrorCode::THERMISTOR_HEATSINK_OVERTEMP,
+                .error_bit = (uint8_t)(1 << i)});
+        }
+        Peltier left{.id = PeltierID::PELTIER_LEFT,
+                     .thermistors = Peltier::ThermistorPair(
+                         thermistors.at(THERM_BACK_LEFT),
+                         thermistors.at(THERM_FRONT_LEFT)),
+                     .pid = PID(1, 0, 0, UPDATE_RATE_SEC, 1.0, -1.0)};
+        Peltier right{.id = PeltierID::PELTIER_RIGHT,
+                      .thermistors = Peltier::ThermistorPair(
+                          thermistors.at(THERM_BACK_RIGHT),
+                          thermistors.at(THERM_FRONT_RIGHT)),
+                      .pid = PID(1, 0, 0, UPDATE_RATE_SEC, 1.0, -1.0)};
+        Peltier center{.id = PeltierID::PELTIER_CENTER,
+                       .thermistors = Peltier::ThermistorPair(
+                           thermistors.at(THERM_BACK_CENTER),
+                           thermistors.at(THERM_FRONT_CENTER)),
+                       .pid = PID(1, 0, 0, UPDATE_RATE_SEC, 1.0, -1.0)};
+        HeatsinkFan fan{.thermistor = thermistors.at(THERM_HEATSINK),
+                        .pid = PID(1, 0, 0, UPDATE_RATE_SEC, 1.0, -1.0)};
+        auto plateControl = PlateControl(left, right, center, fan);
+        THEN("a ramped move takes the distance over the ramp rate") {
+            REQUIRE(plateControl.estimate_ramp_time(HOT_TEMP, 2.0F) ==
+                    Approx((HOT_TEMP - ROOM_TEMP) / 2.0F));
+        }
+        THEN("without a plate model, heating uses the rate estimate") {
+            REQUIRE(plateControl.estimate_ramp_time(HOT_TEMP) ==
+                    Approx((HOT_TEMP - ROOM_TEMP) /
+                           PlateControl::HEATING_RATE_ESTIMATE));
+        }
+        THEN("without a plate model, cooling uses the rate estimate") {
+            REQUIRE(plateControl.estimate_ramp_time(COLD_TEMP) ==
+                    Approx((ROOM_TEMP - COLD_TEMP) /
+                           PlateControl::COOLING_RATE_ESTIMATE));
+        }
+    }
+}
@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "simulator/sim_thermal_model.hpp"
+#include "thermocycler-gen2/plate_control.hpp"
+#include "thermocycler-gen2/plate_model.hpp"
+
+using namespace thermal_general;
+using namespace plate_model;
+
+static constexpr double UPDATE_RATE_SEC = 0.05F;
+static constexpr double ROOM_TEMP = 23.0F;
+static constexpr double HOT_TEMP = 95.0F;
+static constexpr double COLD_TEMP = 4.0F;
+
+// Heats at 3.2ºC/s from room temperature at full power, with some thermal
+// lag between the peltiers and the thermistors.
+static const PlateModel PLANT{
+    .gain = 128.0, .time_constant = 40.0, .dead_time = 1.5};
+
+TEST_CASE("plate model calculations") {
+    GIVEN("an empty model") {
+        auto model = PlateModel();
+        THEN("it is not valid") { REQUIRE(!model.valid()); }
+        THEN("it predicts no holding power") {
+            REQUIRE(model.holding_power(HOT_TEMP, ROOM_TEMP) == 0.0F);
+        }
+        THEN("it predicts no full power duration") {
+            REQUIRE(model.full_power_duration(ROOM_TEMP, HOT_TEMP, ROOM_TEMP) <
+                    0.0F);
+        }
+    }
+    GIVEN("a valid model") {
+        auto model = PLANT;
+        REQUIRE(model.valid());
+        THEN("the holding power balances the loss to ambient") {
+            REQUIRE_THAT(model.holding_power(HOT_TEMP, ROOM_TEMP),
+                         Catch::Matchers::WithinAbs(72.0 / 128.0, 0.0001));
+            REQUIRE_THAT(model.holding_power(ROOM_TEMP, ROOM_TEMP),
+                         Catch::Matchers::WithinAbs(0.0, 0.0001));
+        }
+        THEN("the holding power is clamped") {
+            REQUIRE(model.holding_power(500.0, ROOM_TEMP) == 1.0);
+            REQUIRE(model.holding_power(-500.0, ROOM_TEMP) == -1.0);
+        }
+        THEN("a target beyond the full power steady state is unreachable") {
+            REQUIRE(model.full_power_duration(ROOM_TEMP, 200.0, ROOM_TEMP) <
+                    0.0F);
+            REQUIRE(model.full_power_duration(ROOM_TEMP, -120.0, ROOM_TEMP) <
+                    0.0F);
+        }
+        WHEN("driving at full power for the predicted duration") {
+            auto heat =
+                model.full_power_duration(ROOM_TEMP, HOT_TEMP, ROOM_TEMP);
+            auto cool =
+                model.full_power_duration(HOT_TEMP, COLD_TEMP, ROOM_TEMP);
+            THEN("the prediction lands on the target") {
+                REQUIRE(heat > 0.0F);
+                REQUIRE(cool > 0.0F);
+                REQUIRE_THAT(model.predict(ROOM_TEMP, 1.0, ROOM_TEMP,
+                                           heat + model.dead_time),
+                             Catch::Matchers::WithinAbs(HOT_TEMP, 0.001));
+                REQUIRE_THAT(model.predict(HOT_TEMP, -1.0, ROOM_TEMP,
+                                           cool + model.dead_time),
+                             Catch::Matchers::WithinAbs(COLD_TEMP, 0.001));
+            }
+        }
+        THEN("nothing changes during the dead time") {
+            REQUIRE(model.predict(ROOM_TEMP, 1.0, ROOM_TEMP,
+                                  model.dead_time) == ROOM_TEMP);
+        }
+    }
+}
+
+/**
+ * Runs a PlateControl against the simulator's thermal model of the
+ * peltiers, and records the largest excursion past the target.
+ */
+struct ClosedLoop {
+    std::vector<Thermistor> thermistors = std::vector<Thermistor>(
+        (PeltierID::PELTIER_NUMBER * 2) + 1,
+        Thermistor{
+            .temp_c = ROOM_TEMP,
+            .overtemp_limit_c = 105.0,
+            .disconnected_error =
+                errors::ErrorCode::THERMISTOR_HEATSINK_DISCONNECTED,
+            .short_error = errors::ErrorCode::THERMISTOR_HEATSINK_SHORT,
+            .overtemp_error = errors::ErrorCode::THERMISTOR_HEATSINK_OVERTEMP,
+            .error_bit = (uint8_t)(1)});
+    Peltier left{.id = PeltierID::PELTIER_LEFT,
+                 .thermistors =
+                     Peltier::ThermistorPair(thermistors.at(THERM_BACK_LEFT),
+                                             thermistors.at(THERM_FRONT_LEFT)),
+                 .pid = PID(0.3, 0.05, 0.3, UPDATE_RATE_SEC, 1.0, -1.0)};
+    Peltier right{.id = PeltierID::PELTIER_RIGHT,
+                  .thermistors = Peltier::ThermistorPair(
+                      thermistors.at(THERM_BACK_RIGHT),
+                      thermistors.at(THERM_FRONT_RIGHT)),
+                  .pid = PID(0.3, 0.05, 0.3, UPDATE_RATE_SEC, 1.0, -1.0)};
+    Peltier center{.id = PeltierID::PELTIER_CENTER,
+                   .thermistors = Peltier::ThermistorPair(
+                       thermistors.at(THERM_BACK_CENTER),
+                       thermistors.at(THERM_FRONT_CENTER)),
+                   .pid = PID(0.3, 0.05, 0.3, UPDATE_RATE_SEC, 1.0, -1.0)};
+    HeatsinkFan fan{.thermistor = thermistors.at(THERM_HEATSINK),
+                    .pid = PID(0.2, 0.01, 0.05, UPDATE_RATE_SEC, 1.0, -1.0)};
+    plate_control::PlateControl control =
+        plate_control::PlateControl(left, right, center, fan);
+
+    std::vector<double> temps =
+        std::vector<double>(PeltierID::PELTIER_NUMBER, ROOM_TEMP);
+
+    auto step_plant(PeltierID id, double power) -> void {
+        auto &temp = temps.at(id);
+        // The peltier drivers saturate at full power
+        temp = sim_thermal_model::step_peltier(
+            temp, std::clamp(power, -1.0, 1.0), UPDATE_RATE_SEC);
+    }
+
+    /** Start the plate, but not the heatsink, at a temperature.*/
+    auto set_plate_temp(double temp) -> void {
+        std::fill(temps.begin(), temps.end(), temp);
+        for (size_t i = 0; i < thermistors.size(); ++i) {
+            if (i != THERM_HEATSINK) {
+                thermistors.at(i).temp_c = temp;
+            }
+        }
+    }
+
+    /** Run one control update and step the plant with its output.*/
+    auto step() -> plate_control::PlateControlVals {
+        auto ret = control.update_control(UPDATE_RATE_SEC);
+        REQUIRE(ret.has_value());
+        step_plant(PeltierID::PELTIER_LEFT, ret.value().left_power);
+        step_plant(PeltierID::PELTIER_RIGHT, ret.value().right_power);
+        step_plant(PeltierID::PELTIER_CENTER, ret.value().center_power);
+        thermistors.at(THERM_BACK_LEFT).temp_c = temps.at(PELTIER_LEFT);
+        thermistors.at(THERM_FRONT_LEFT).temp_c = temps.at(PELTIER_LEFT);
+        thermistors.at(THERM_BACK_RIGHT).temp_c = temps.at(PELTIER_RIGHT);
+        thermistors.at(THERM_FRONT_RIGHT).temp_c = temps.at(PELTIER_RIGHT);
+        thermistors.at(THERM_BACK_CENTER).temp_c = temps.at(PELTIER_CENTER);
+        thermistors.at(THERM_FRONT_CENTER).temp_c = temps.at(PELTIER_CENTER);
+        return ret.value();
+    }
+
+    /** Run for a duration, returning the worst overshoot of the target.*/
+    auto run(double target, double seconds) -> double {
+        REQUIRE(control.set_new_target(target, 0.0F));
+        bool heating = target > ROOM_TEMP;
+        double worst = 0.0F;
+        for (double t = 0; t < seconds; t += UPDATE_RATE_SEC) {
+            static_cast<void>(step());
+            for (auto temp : temps) {
+                auto past_target = heating ? temp - target : target - temp;
+                worst = std::max(worst, past_target);
+            }
+        }
+        return worst;
+    }
+};
+
+TEST_CASE("plate model feed-forward control") {
+    GIVEN("a plate controlled without a model") {
+        auto without_model = ClosedLoop();
+        auto baseline = without_model.run(HOT_TEMP, 60.0);
+        AND_GIVEN("a plate controlled with a matching model") {
+            auto with_model = ClosedLoop();
+            with_model.control.set_model(sim_thermal_model::PELTIER_MODEL);
+            auto overshoot = with_model.run(HOT_TEMP, 60.0);
+            THEN("the plate lands on the target with less overshoot") {
+                REQUIRE(overshoot < baseline);
+                REQUIRE(overshoot < 0.5);
+                REQUIRE(with_model.control.status() ==
+                        plate_control::PlateStatus::STEADY_STATE);
+                for (auto temp : with_model.temps) {
+                    REQUIRE_THAT(temp, Catch::Matchers::WithinAbs(
+                                           HOT_TEMP, 0.5));
+                }
+            }
+        }
+    }
+    GIVEN("a plate with a matching model heating with feed-forward") {
+        auto loop = ClosedLoop();
+        loop.control.set_model(sim_thermal_model::PELTIER_MODEL);
+        REQUIRE(loop.control.set_new_target(HOT_TEMP, 0.0F));
+        WHEN("the feed-forward hands over to the PID") {
+            auto ramping = [&loop]() {
+                return loop.control.status() ==
+                       plate_control::PlateStatus::INITIAL_HEAT;
+            };
+            for (int i = 0; i < 10000 && ramping(); ++i) {
+                static_cast<void>(loop.step());
+            }
+            REQUIRE(!ramping());
+            THEN("the integrator starts from the holding power") {
+                // One regular integration step has run since the handover
+                auto holding = sim_thermal_model::PELTIER_MODEL.holding_power(
+                    HOT_TEMP, ROOM_TEMP);
+                auto expected =
+                    holding + (UPDATE_RATE_SEC * loop.left.pid.ki() *
+                               loop.left.pid.last_error());
+                REQUIRE_THAT(loop.left.pid.last_iterm(),
+                             Catch::Matchers::WithinAbs(expected, 0.0001));
+            }
+        }
+    }
+    GIVEN("a hot plate with a model and a hot plate without one") {
+        auto with_model = ClosedLoop();
+        with_model.control.set_model(sim_thermal_model::PELTIER_MODEL);
+        with_model.set_plate_temp(HOT_TEMP);
+        auto without_model = ClosedLoop();
+        without_model.set_plate_temp(HOT_TEMP);
+        auto holding = sim_thermal_model::PELTIER_MODEL.holding_power(
+            HOT_TEMP, ROOM_TEMP);
+        REQUIRE(holding > 0.02);
+        WHEN("ramping at a fixed rate, which doesn't use the feed-forward") {
+            REQUIRE(with_model.control.set_new_target(
+                HOT_TEMP + 1.0, 0.0F,
+                plate_control::PlateControl::HOLD_INFINITE, 1.0));
+            REQUIRE(without_model.control.set_new_target(
+                HOT_TEMP + 1.0, 0.0F,
+                plate_control::PlateControl::HOLD_INFINITE, 1.0));
+            THEN("the model adds no holding power bias to the PID output") {
+                auto biased = with_model.step();
+                auto unbiased = without_model.step();
+                // The zone filters use the model too, so the outputs are
+                // only close rather than equal
+                REQUIRE_THAT(biased.left_power,
+                             Catch::Matchers::WithinAbs(unbiased.left_power,
+                                                        holding / 10.0));
+                REQUIRE_THAT(biased.center_power,
+                             Catch::Matchers::WithinAbs(unbiased.center_power,
+                                                        holding / 10.0));
+            }
+        }
+    }
+}
@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <cmath>
+
+#include "catch2/catch.hpp"
+#include "thermocycler-gen2/plate_model.hpp"
+#include "thermocycler-gen2/sample_estimator.hpp"
+
+using namespace sample_estimator;
+
+static constexpr double UPDATE_RATE_SEC = 0.05F;
+static constexpr double ROOM_TEMP = 23.0F;
+static constexpr double HOT_TEMP = 95.0F;
+static constexpr double RAMP_RATE = 3.0F;
+
+/**
+ * A sample that is two lags in series with the estimator's constants: the
+ * well wall follows the block and the liquid follows the wall.
+ */
+struct TwoLagSample {
+    double volume_ul;
+    double wall = ROOM_TEMP;
+    double liquid = ROOM_TEMP;
+
+    /** Integrate in small steps, independently of the estimator's own
+     * discretization.*/
+    auto step(double block, double seconds) -> void {
+        constexpr double substep = 0.001;
+        auto liquid_tau =
+            SampleEstimator::TIME_CONSTANT_PER_MICROLITER * volume_ul;
+        for (double t = 0; t < seconds; t += substep) {
+            wall += (block - wall) / SampleEstimator::WALL_TIME_CONSTANT *
+                    substep;
+            liquid += (wall - liquid) / liquid_tau * substep;
+        }
+    }
+};
+
+TEST_CASE("sample estimator time constant") {
+    THEN("an empty plate only lags by the wall") {
+        REQUIRE(SampleEstimator::liquid_time_constant(0.0F) == 0.0F);
+        REQUIRE(SampleEstimator::liquid_time_constant(-10.0F) == 0.0F);
+    }
+    THEN("larger volumes lag more") {
+        REQUIRE(SampleEstimator::liquid_time_constant(50.0F) >
+                SampleEstimator::liquid_time_constant(25.0F));
+    }
+}
+
+TEST_CASE("sample estimator tracks a sample") {
+    const double volume = GENERATE(10.0F, 25.0F, 50.0F, 100.0F);
+    auto model = plate_model::PlateModel();
+    auto estimator = SampleEstimator();
+    auto sample = TwoLagSample{.volume_ul = volume};
+    REQUIRE(!estimator.initialized());
+    estimator.update(ROOM_TEMP, 0.0F, ROOM_TEMP, volume, model,
+                     UPDATE_RATE_SEC);
+    REQUIRE(estimator.initialized());
+    REQUIRE(estimator.sample_temp() == ROOM_TEMP);
+
+    double block = ROOM_TEMP;
+    // Thermistor noise, alternating so that it averages out
+    double noise = 0.2F;
+    double worst_ramp_error = 0.0F;
+    // Ramp the block to the target, then hold it there
+    for (double t = 0; t < 120.0; t += UPDATE_RATE_SEC) {
+        block = std::min(block + (RAMP_RATE * UPDATE_RATE_SEC), HOT_TEMP);
+        sample.step(block, UPDATE_RATE_SEC);
+        noise = -noise;
+        estimator.update(block + noise, 0.0F, ROOM_TEMP, volume, model,
+                         UPDATE_RATE_SEC);
+        auto error = std::abs(estimator.sample_temp() - sample.liquid);
+        worst_ramp_error = std::max(worst_ramp_error, error);
+    }
+    DYNAMIC_SECTION("volume " << volume) {
+        REQUIRE(worst_ramp_error < 0.75F);
+        REQUIRE_THAT(estimator.sample_temp(),
+                     Catch::Matchers::WithinAbs(sample.liquid, 0.1));
+        REQUIRE_THAT(estimator.sample_temp(),
+                     Catch::Matchers::WithinAbs(HOT_TEMP, 0.1));
+    }
+    WHEN("resetting the estimate") {
+        estimator.reset();
+        REQUIRE(!estimator.initialized());
+        estimator.update(ROOM_TEMP, 0.0F, ROOM_TEMP, volume, model,
+                         UPDATE_RATE_SEC);
+        THEN("it restarts from the block temperature") {
+            REQUIRE(estimator.sample_temp() == ROOM_TEMP);
+        }
+    }
+}
+
+TEST_CASE("sample estimator lags the thermistors during a ramp") {
+    const double volume = GENERATE(0.0F, 25.0F, 100.0F);
+    auto model = plate_model::PlateModel();
+    auto estimator = SampleEstimator();
+    double block = ROOM_TEMP;
+    estimator.update(block, 0.0F, ROOM_TEMP, volume, model, UPDATE_RATE_SEC);
+    // Long enough for every lag to settle into following the ramp
+    for (double t = 0; t < 60.0; t += UPDATE_RATE_SEC) {
+        block += RAMP_RATE * UPDATE_RATE_SEC;
+        estimator.update(block, 0.0F, ROOM_TEMP, volume, model,
+                         UPDATE_RATE_SEC);
+    }
+    DYNAMIC_SECTION("volume " << volume) {
+        THEN("the block estimate follows the thermistors") {
+            REQUIRE(block - estimator.block_temp() > 0.0F);
+            REQUIRE(block - estimator.block_temp() <=
+                    RAMP_RATE / SampleEstimator::OBSERVER_GAIN);
+        }
+        THEN("the sample lags by the ramp rate times every time constant") {
+            // A ramp through first-order lags in series settles to a lag
+            // of the ramp rate times the sum of their time constants
+            auto expected =
+                RAMP_RATE * ((1.0 / SampleEstimator::OBSERVER_GAIN) +
+                             SampleEstimator::WALL_TIME_CONSTANT +
+                             SampleEstimator::liquid_time_constant(volume));
+            REQUIRE_THAT(block - estimator.sample_temp(),
+                         Catch::Matchers::WithinRel(expected, 0.05));
+            REQUIRE(block - estimator.sample_temp() >
+                    RAMP_RATE * SampleEstimator::WALL_TIME_CONSTANT);
+        }
+    }
+}
+
+TEST_CASE("sample estimator uses the plate model") {
+    // Readings that don't move at all, with the peltiers at full power
+    auto model = plate_model::PlateModel{
+        .gain = 128.0, .time_constant = 40.0, .dead_time = 1.5};
+    auto with_model = SampleEstimator();
+    auto without_model = SampleEstimator();
+    for (int i = 0; i < 10; ++i) {
+        with_model.update(ROOM_TEMP, 1.0F, ROOM_TEMP, 25.0F, model,
+                          UPDATE_RATE_SEC);
+        without_model.update(ROOM_TEMP, 1.0F, ROOM_TEMP, 25.0F,
+                             plate_model::PlateModel(), UPDATE_RATE_SEC);
+    }
+    THEN("the model predicts the block heating ahead of the thermistors") {
+        REQUIRE(with_model.block_temp() > ROOM_TEMP);
+        REQUIRE(without_model.block_temp() == ROOM_TEMP);
+    }
+}
@@ -1,5 +1,8 @@
+#include <algorithm>
+#include <array>
 #include <iterator>
 #include <list>
+#include <vector>
 
 #include "catch2/catch.hpp"
 #include "core/thermistor_conversion.hpp"
@@ -507,6 +510,185 @@ SCENARIO("thermal plate task message passing") {
                 }
             }
         }
+        WHEN("sending a SetSampleHold message to enable sample holds") {
+            auto message =
+                messages::SetSampleHoldMessage{.id = 123, .enable = true};
+            plate_queue.backing_deque.push_back(
+                messages::ThermalPlateMessage(message));
+            tasks->run_thermal_plate_task();
+            THEN("the task should acknowledge the message") {
+                REQUIRE(plate_queue.backing_deque.empty());
+                REQUIRE(tasks->get_host_comms_queue().has_message());
+                auto response =
+                    tasks->get_host_comms_queue().backing_deque.front();
+                tasks->get_host_comms_queue().backing_deque.pop_front();
+                REQUIRE(std::holds_alternative<messages::AcknowledgePrevious>(
+                    response));
+                auto ack = std::get<messages::AcknowledgePrevious>(response);
+                REQUIRE(ack.responding_to_id == 123);
+                REQUIRE(ack.with_error == errors::ErrorCode::NO_ERROR);
+                AND_WHEN("sending a GetSampleEstimate message") {
+                    auto query = messages::GetSampleEstimateMessage{.id = 456};
+                    plate_queue.backing_deque.push_back(
+                        messages::ThermalPlateMessage(query));
+                    tasks->run_thermal_plate_task();
+                    THEN("the response shows the new mode") {
+                        REQUIRE(tasks->get_host_comms_queue().has_message());
+                        auto estimate =
+                            std::get<messages::GetSampleEstimateResponse>(
+                                tasks->get_host_comms_queue()
+                                    .backing_deque.front());
+                        REQUIRE(estimate.responding_to_id == 456);
+                        REQUIRE(estimate.sample_hold);
+                    }
+                }
+            }
+        }
+        WHEN("sending a SetGainSchedule message") {
+            auto message = messages::SetGainScheduleMessage{
+                .id = 123, .zone = 0, .heating = false, .p = 2, .i = 1, .d = 3};
+            plate_queue.backing_deque.push_back(
+                messages::ThermalPlateMessage(message));
+            tasks->run_thermal_plate_task();
+            THEN("the task should acknowledge the message") {
+                REQUIRE(plate_queue.backing_deque.empty());
+                REQUIRE(tasks->get_host_comms_queue().has_message());
+                auto response =
+                    tasks->get_host_comms_queue().backing_deque.front();
+                tasks->get_host_comms_queue().backing_deque.pop_front();
+                REQUIRE(std::holds_alternative<messages::AcknowledgePrevious>(
+                    response));
+                auto ack = std::get<messages::AcknowledgePrevious>(response);
+                REQUIRE(ack.responding_to_id == 123);
+                REQUIRE(ack.with_error == errors::ErrorCode::NO_ERROR);
+                AND_WHEN("reading back the entry") {
+                    auto query = messages::GetGainScheduleMessage{
+                        .id = 456, .zone = 0, .heating = false};
+                    plate_queue.backing_deque.push_back(
+                        messages::ThermalPlateMessage(query));
+                    tasks->run_thermal_plate_task();
+                    THEN("the response has the new gains") {
+                        REQUIRE(tasks->get_host_comms_queue().has_message());
+                        auto gains =
+                            std::get<messages::GetGainScheduleResponse>(
+                                tasks->get_host_comms_queue()
+                                    .backing_deque.front());
+                        REQUIRE(gains.responding_to_id == 456);
+                        REQUIRE(gains.zone == 0);
+                        REQUIRE(!gains.heating);
+                        REQUIRE(gains.p == 2);
+                        REQUIRE(gains.i == 1);
+                        REQUIRE(gains.d == 3);
+                    }
+                }
+                AND_WHEN("reading back an entry that wasn't set") {
+                    auto query = messages::GetGainScheduleMessage{
+                        .id = 456, .zone = 0, .heating = true};
+                    plate_queue.backing_deque.push_back(
+                        messages::ThermalPlateMessage(query));
+                    tasks->run_thermal_plate_task();
+                    THEN("the response has the default gains") {
+                        auto gains =
+                            std::get<messages::GetGainScheduleResponse>(
+                                tasks->get_host_comms_queue()
+                                    .backing_deque.front());
+                        using PlateTask = thermal_plate_task::ThermalPlateTask<
+                            TestMessageQueue>;
+                        REQUIRE(gains.p == PlateTask::DEFAULT_KP);
+                        REQUIRE(gains.i == PlateTask::DEFAULT_KI);
+                        REQUIRE(gains.d == PlateTask::DEFAULT_KD);
+                    }
+                }
+            }
+        }
+        WHEN("sending SetPIDConstants after setting a zone's gains") {
+            using PlateTask =
+                thermal_plate_task::ThermalPlateTask<TestMessageQueue>;
+            auto zone = messages::SetGainScheduleMessage{
+                .id = 123, .zone = 0, .heating = false, .p = 2, .i = 1, .d = 3};
+            plate_queue.backing_deque.push_back(
+                messages::ThermalPlateMessage(zone));
+            tasks->run_thermal_plate_task();
+            auto pid = messages::SetPIDConstantsMessage{
+                .id = 124,
+                .selection = PidSelection::PELTIERS,
+                .p = 0.5,
+                .i = 0.25,
+                .d = 0.125};
+            plate_queue.backing_deque.push_back(
+                messages::ThermalPlateMessage(pid));
+            tasks->run_thermal_plate_task();
+            tasks->get_host_comms_queue().backing_deque.clear();
+            AND_WHEN("the plate reloads its settings from the EEPROM") {
+                auto rebooted = PlateTask(plate_queue);
+                rebooted.provide_tasks(&tasks->get_tasks_aggregator());
+                auto query = messages::GetGainScheduleMessage{
+                    .id = 456, .zone = 0, .heating = false};
+                plate_queue.backing_deque.push_back(
+                    messages::ThermalPlateMessage(query));
+                rebooted.run_once(tasks->get_thermal_plate_policy());
+                THEN("the zone has the gains from SetPIDConstants") {
+                    auto gains = std::get<messages::GetGainScheduleResponse>(
+                        tasks->get_host_comms_queue().backing_deque.front());
+                    REQUIRE(gains.responding_to_id == 456);
+                    REQUIRE(gains.p == 0.5);
+                    REQUIRE(gains.i == 0.25);
+                    REQUIRE(gains.d == 0.125);
+                }
+            }
+        }
+        WHEN("sending a SetGainSchedule message with invalid gains") {
+            auto message = messages::SetGainScheduleMessage{.id = 123,
+                                                            .zone = 1,
+                                                            .heating = true,
+                                                            .p = 1000,
+                                                            .i = 1,
+                                                            .d = 1};
+            plate_queue.backing_deque.push_back(
+                messages::ThermalPlateMessage(message));
+            tasks->run_thermal_plate_task();
+            THEN("the task should respond with an error") {
+                REQUIRE(tasks->get_host_comms_queue().has_message());
+                auto ack = std::get<messages::AcknowledgePrevious>(
+                    tasks->get_host_comms_queue().backing_deque.front());
+                REQUIRE(ack.responding_to_id == 123);
+                REQUIRE(ack.with_error ==
+                        errors::ErrorCode::THERMAL_CONSTANT_OUT_OF_RANGE);
+            }
+        }
+        WHEN("sending a GetThermistorStats message with a reset") {
+            auto message =
+                messages::GetThermistorStatsMessage{.id = 123, .reset = true};
+            plate_queue.backing_deque.push_back(
+                messages::ThermalPlateMessage(message));
+            tasks->run_thermal_plate_task();
+            THEN("the response covers the reading so far") {
+                REQUIRE(tasks->get_host_comms_queue().has_message());
+                auto response = std::get<messages::GetThermistorStatsResponse>(
+                    tasks->get_host_comms_queue().backing_deque.front());
+                tasks->get_host_comms_queue().backing_deque.pop_front();
+                REQUIRE(response.responding_to_id == 123);
+                REQUIRE(response.stats.samples == 1);
+                REQUIRE(response.stats.spread.mean == Approx(0.0).margin(0.01));
+                for (auto &thermistor : response.stats.thermistors) {
+                    REQUIRE(thermistor.mean == Approx(_valid_temp).margin(0.1));
+                }
+                AND_WHEN("asking again") {
+                    message.id = 456;
+                    plate_queue.backing_deque.push_back(
+                        messages::ThermalPlateMessage(message));
+                    tasks->run_thermal_plate_task();
+                    THEN("the stats were cleared") {
+                        auto again =
+                            std::get<messages::GetThermistorStatsResponse>(
+                                tasks->get_host_comms_queue()
+                                    .backing_deque.front());
+                        REQUIRE(again.responding_to_id == 456);
+                        REQUIRE(again.stats.samples == 0);
+                    }
+                }
+            }
+        }
         WHEN("Sending a SetPlateTemperature message to enable the plate") {
             auto message = messages::SetPlateTemperatureMessage{
                 .id = 123, .setpoint = 90.0F, .hold_time = 10.0F};
@@ -1290,4 +1472,612 @@ TEST_CASE("thermal plate tick overflow handling") {
             }
         }
     }
-}
\ No newline at end of file
+}
+TEST_CASE("thermal plate adaptive control period") {
+    using PlateTask = thermal_plate_task::ThermalPlateTask<TestMessageQueue>;
+    uint32_t timestamp = TIME_DELTA;
+    GIVEN("an idle thermal plate") {
+        auto tasks = TaskBuilder::build();
+        auto &plate_task = tasks->get_thermal_plate_task();
+        auto &plate_queue = tasks->get_thermal_plate_queue();
+        const double target_temp = 50.0F;  // in ºC
+        auto adc_value = _converter.backconvert(target_temp - 1.0F);
+        auto read_message =
+            messages::ThermalPlateTempReadComplete{.heat_sink = adc_value,
+                                                   .front_right = adc_value,
+                                                   .front_center = adc_value,
+                                                   .front_left = adc_value,
+                                                   .back_right = adc_value,
+                                                   .back_center = adc_value,
+                                                   .back_left = adc_value,
+                                                   .timestamp_ms = timestamp};
+        static_cast<void>(plate_queue.try_send(read_message));
+        tasks->run_thermal_plate_task();
+        THEN("the plate is sampled at the hold rate") {
+            REQUIRE(plate_task.get_control_period_ticks() ==
+                    PlateTask::HOLD_CONTROL_PERIOD_TICKS);
+        }
+        WHEN("setting a new temperature") {
+            auto target_message = messages::SetPlateTemperatureMessage{
+                .id = 456, .setpoint = target_temp, .hold_time = 0.0F};
+            static_cast<void>(plate_queue.try_send(target_message));
+            tasks->run_thermal_plate_task();
+            THEN("the plate is sampled at the ramp rate") {
+                REQUIRE(plate_task.get_control_period_ticks() ==
+                        PlateTask::RAMP_CONTROL_PERIOD_TICKS);
+            }
+            AND_WHEN("the plate overshoots and then settles") {
+                adc_value = _converter.backconvert(target_temp + 1.0F);
+                read_message.front_right = adc_value;
+                read_message.front_center = adc_value;
+                read_message.front_left = adc_value;
+                read_message.back_right = adc_value;
+                read_message.back_center = adc_value;
+                read_message.back_left = adc_value;
+                timestamp += 1 * 1000;  // advance 1 second (enter overshoot)
+                read_message.timestamp_ms = timestamp;
+                static_cast<void>(plate_queue.try_send(read_message));
+                tasks->run_thermal_plate_task();
+                REQUIRE(plate_task.get_control_period_ticks() ==
+                        PlateTask::RAMP_CONTROL_PERIOD_TICKS);
+                timestamp += 11 * 1000;  // advance 11 seconds (end overshoot)
+                read_message.timestamp_ms = timestamp;
+                static_cast<void>(plate_queue.try_send(read_message));
+                tasks->run_thermal_plate_task();
+                THEN("the plate is sampled at the hold rate") {
+                    REQUIRE(plate_task.get_control_period_ticks() ==
+                            PlateTask::HOLD_CONTROL_PERIOD_TICKS);
+                }
+            }
+            AND_WHEN("deactivating the plate") {
+                auto message = messages::DeactivatePlateMessage{.id = 321};
+                static_cast<void>(plate_queue.try_send(message));
+                tasks->run_thermal_plate_task();
+                THEN("the plate is sampled at the hold rate") {
+                    REQUIRE(plate_task.get_control_period_ticks() ==
+                            PlateTask::HOLD_CONTROL_PERIOD_TICKS);
+                }
+            }
+        }
+    }
+}
+TEST_CASE("thermal plate relay autotune") {
+    using PlateTask = thermal_plate_task::ThermalPlateTask<TestMessageQueue>;
+    constexpr double target_temp = 50.0F;
+    constexpr uint32_t step_ms = PlateTask::RAMP_CONTROL_PERIOD_TICKS;
+    uint32_t timestamp = step_ms;
+    GIVEN("an idle thermal plate below the autotune target") {
+        auto tasks = TaskBuilder::build();
+        auto &plate_task = tasks->get_thermal_plate_task();
+        auto &plate_queue = tasks->get_thermal_plate_queue();
+        auto &host_queue = tasks->get_host_comms_queue();
+        auto &policy = tasks->get_thermal_plate_policy();
+        double plate_temp = target_temp - 2.0F;
+        auto read_message = messages::ThermalPlateTempReadComplete{
+            .heat_sink = _converter.backconvert(_valid_temp),
+            .timestamp_ms = timestamp};
+        auto send_temp = [&]() {
+            auto adc = _converter.backconvert(plate_temp);
+            read_message.front_right = adc;
+            read_message.front_center = adc;
+            read_message.front_left = adc;
+            read_message.back_right = adc;
+            read_message.back_center = adc;
+            read_message.back_left = adc;
+            read_message.timestamp_ms = timestamp;
+            timestamp += step_ms;
+            static_cast<void>(plate_queue.try_send(read_message));
+            tasks->run_thermal_plate_task();
+        };
+        auto signed_power = [&]() -> double {
+            auto power = policy.get_peltier(PeltierID::PELTIER_LEFT);
+            return (power.first == PeltierDirection::PELTIER_COOLING)
+                       ? -power.second
+                       : power.second;
+        };
+        send_temp();
+        WHEN("starting an autotune with an out of range target") {
+            auto message = messages::StartAutotuneMessage{
+                .id = 123, .target = 150.0F, .write = false};
+            static_cast<void>(plate_queue.try_send(message));
+            tasks->run_thermal_plate_task();
+            THEN("the task responds with an error") {
+                auto response = std::get<messages::AcknowledgePrevious>(
+                    host_queue.backing_deque.front());
+                REQUIRE(response.responding_to_id == 123);
+                REQUIRE(response.with_error ==
+                        errors::ErrorCode::THERMAL_TARGET_BAD);
+            }
+        }
+        WHEN("starting an autotune with a plate model") {
+            // Holding 50ºC against a 25ºC heatsink takes a quarter power
+            auto model = messages::SetPlateModelMessage{
+                .id = 1, .gain = 100.0F, .time_constant = 10.0F,
+                .dead_time = 1.0F};
+            static_cast<void>(plate_queue.try_send(model));
+            tasks->run_thermal_plate_task();
+            auto message = messages::StartAutotuneMessage{
+                .id = 123, .target = target_temp, .write = false};
+            static_cast<void>(plate_queue.try_send(message));
+            tasks->run_thermal_plate_task();
+            THEN("the relay is centered on the holding power") {
+                send_temp();
+                REQUIRE_THAT(signed_power(),
+                             Catch::Matchers::WithinAbs(
+                                 0.25F + PlateTask::AUTOTUNE_RELAY_POWER,
+                                 0.01));
+                // The peltier output filter takes a few readings to swing
+                plate_temp = target_temp + 2.0F;
+                for (int i = 0; i < 10; ++i) {
+                    send_temp();
+                }
+                REQUIRE_THAT(signed_power(),
+                             Catch::Matchers::WithinAbs(
+                                 0.25F - PlateTask::AUTOTUNE_RELAY_POWER,
+                                 0.01));
+            }
+        }
+        WHEN("starting an autotune that writes the result") {
+            auto message = messages::StartAutotuneMessage{
+                .id = 123, .target = target_temp, .write = true};
+            static_cast<void>(plate_queue.try_send(message));
+            tasks->run_thermal_plate_task();
+            THEN("the task acknowledges the message") {
+                auto response = std::get<messages::AcknowledgePrevious>(
+                    host_queue.backing_deque.front());
+                REQUIRE(response.responding_to_id == 123);
+                REQUIRE(response.with_error == errors::ErrorCode::NO_ERROR);
+                REQUIRE(plate_task.get_control_period_ticks() ==
+                        PlateTask::RAMP_CONTROL_PERIOD_TICKS);
+            }
+            AND_WHEN("sending a temperature below the target") {
+                send_temp();
+                THEN("the peltiers heat") {
+                    REQUIRE(policy._enabled);
+                    REQUIRE(signed_power() > 0.0F);
+                }
+                AND_WHEN("setting a plate temperature") {
+                    host_queue.backing_deque.clear();
+                    auto set_message = messages::SetPlateTemperatureMessage{
+                        .id = 456, .setpoint = 0.0F};
+                    static_cast<void>(plate_queue.try_send(set_message));
+                    tasks->run_thermal_plate_task();
+                    THEN("the autotune is aborted") {
+                        host_queue.backing_deque.clear();
+                        auto get = messages::GetAutotuneResultMessage{.id = 1};
+                        static_cast<void>(plate_queue.try_send(get));
+                        tasks->run_thermal_plate_task();
+                        auto response =
+                            std::get<messages::GetAutotuneResultResponse>(
+                                host_queue.backing_deque.front());
+                        REQUIRE(response.status ==
+                                relay_autotune::Status::FAILED);
+                        REQUIRE(!policy._enabled);
+                    }
+                }
+            }
+            AND_WHEN("the plate oscillates under the relay") {
+                // A slow plate with a one second lag between the peltiers
+                // and the thermistors
+                std::vector<double> delayed(1000 / step_ms, 0.0F);
+                for (int i = 0; i < 5000; ++i) {
+                    delayed.push_back(signed_power());
+                    plate_temp += delayed.front() * step_ms / 1000.0F;
+                    delayed.erase(delayed.begin());
+                    send_temp();
+                    if (!policy._enabled) {
+                        break;
+                    }
+                }
+                host_queue.backing_deque.clear();
+                auto get = messages::GetAutotuneResultMessage{.id = 1};
+                static_cast<void>(plate_queue.try_send(get));
+                tasks->run_thermal_plate_task();
+                THEN("the autotune completes and the plate goes idle") {
+                    auto response =
+                        std::get<messages::GetAutotuneResultResponse>(
+                            host_queue.backing_deque.front());
+                    REQUIRE(response.responding_to_id == 1);
+                    REQUIRE(response.selection == PidSelection::PELTIERS);
+                    REQUIRE(response.status == relay_autotune::Status::DONE);
+                    REQUIRE(response.result.kp > 0.0F);
+                    REQUIRE(response.result.ki > 0.0F);
+                    REQUIRE(response.result.kd > 0.0F);
+                    REQUIRE(!policy._enabled);
+                    REQUIRE(plate_task.get_control_period_ticks() ==
+                            PlateTask::HOLD_CONTROL_PERIOD_TICKS);
+                    AND_THEN("the new constants are stored in the EEPROM") {
+                        using Eeprom =
+                            eeprom::Eeprom<PlateTask::EEPROM_PAGES,
+                                           PlateTask::EEPROM_ADDRESS>;
+                        auto eeprom = Eeprom();
+                        auto stored = eeprom.get_pid_constants(
+                            eeprom::PIDConstants{.kp = 0, .ki = 0, .kd = 0},
+                            policy);
+                        REQUIRE_THAT(stored.kp,
+                                     Catch::Matchers::WithinAbs(
+                                         response.result.kp, 0.0001));
+                        REQUIRE_THAT(stored.ki,
+                                     Catch::Matchers::WithinAbs(
+                                         response.result.ki, 0.0001));
+                        REQUIRE_THAT(stored.kd,
+                                     Catch::Matchers::WithinAbs(
+                                         response.result.kd, 0.0001));
+                    }
+                }
+            }
+            AND_WHEN("the plate flips just past the hysteresis every reading") {
+                // A tiny, fast oscillation gives gains far too high to use.
+                // Each temperature is the first one whose reading, with the
+                // default thermistor offsets, is past the hysteresis.
+                auto reading = [](double temp) {
+                    auto converted = std::get<double>(
+                        _converter.convert(_converter.backconvert(temp)));
+                    return (PlateTask::OFFSET_DEFAULT_CONST_A * _valid_temp) +
+                           ((1.0F + PlateTask::OFFSET_DEFAULT_CONST_B) *
+                            converted) +
+                           PlateTask::OFFSET_DEFAULT_CONST_C;
+                };
+                auto just_past = [&](double threshold, double step) {
+                    // Start a degree short of the threshold
+                    auto temp = threshold - (step * 10000);
+                    while ((reading(temp) - threshold) * step <= 0.0F) {
+                        temp += step;
+                    }
+                    return temp;
+                };
+                auto high = just_past(
+                    target_temp + PlateTask::AUTOTUNE_HYSTERESIS_C, 0.0001);
+                auto low = just_past(
+                    target_temp - PlateTask::AUTOTUNE_HYSTERESIS_C, -0.0001);
+                for (int i = 0; i < 100; ++i) {
+                    plate_temp = (i % 2 == 0) ? high : low;
+                    send_temp();
+                    if (!policy._enabled) {
+                        break;
+                    }
+                }
+                THEN("the result is reported as out of range and not stored") {
+                    REQUIRE(!policy._enabled);
+                    REQUIRE(std::ranges::any_of(
+                        host_queue.backing_deque, [](const auto &msg) {
+                            auto *error =
+                                std::get_if<messages::ErrorMessage>(&msg);
+                            return (error != nullptr) &&
+                                   (error->code ==
+                                    errors::ErrorCode::
+                                        THERMAL_CONSTANT_OUT_OF_RANGE);
+                        }));
+                    using Eeprom =
+                        eeprom::Eeprom<PlateTask::EEPROM_PAGES,
+                                       PlateTask::EEPROM_ADDRESS>;
+                    auto eeprom = Eeprom();
+                    auto stored = eeprom.get_pid_constants(
+                        eeprom::PIDConstants{.kp = 0, .ki = 0, .kd = 0},
+                        policy);
+                    REQUIRE(stored.kp == 0);
+                    REQUIRE(stored.ki == 0);
+                    REQUIRE(stored.kd == 0);
+                    host_queue.backing_deque.clear();
+                    auto get = messages::GetAutotuneResultMessage{.id = 1};
+                    static_cast<void>(plate_queue.try_send(get));
+                    tasks->run_thermal_plate_task();
+                    auto response =
+                        std::get<messages::GetAutotuneResultResponse>(
+                            host_queue.backing_deque.front());
+                    REQUIRE(response.status == relay_autotune::Status::DONE);
+                    REQUIRE(response.result.ki > PlateTask::KI_MAX);
+                }
+            }
+            AND_WHEN("sending SetPIDConstants") {
+                host_queue.backing_deque.clear();
+                auto pid_message = messages::SetPIDConstantsMessage{
+                    .id = 456,
+                    .selection = PidSelection::PELTIERS,
+                    .p = 1,
+                    .i = 1,
+                    .d = 1};
+                static_cast<void>(plate_queue.try_send(pid_message));
+                tasks->run_thermal_plate_task();
+                THEN("the task responds that it is busy") {
+                    auto response = std::get<messages::AcknowledgePrevious>(
+                        host_queue.backing_deque.front());
+                    REQUIRE(response.with_error ==
+                            errors::ErrorCode::THERMAL_PLATE_BUSY);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("thermal plate pcr protocol") {
+    using PlateTask = thermal_plate_task::ThermalPlateTask<TestMessageQueue>;
+    constexpr uint32_t step_ms = PlateTask::RAMP_CONTROL_PERIOD_TICKS;
+    constexpr double ambient = 25.0F;
+    uint32_t timestamp = step_ms;
+    GIVEN("an idle thermal plate with a protocol loaded") {
+        auto tasks = TaskBuilder::build();
+        auto &plate_queue = tasks->get_thermal_plate_queue();
+        auto &host_queue = tasks->get_host_comms_queue();
+        auto &lid_queue = tasks->get_lid_heater_queue();
+        auto &policy = tasks->get_thermal_plate_policy();
+        // Each peltier drives its own pair of thermistors
+        std::vector<double> temps(PeltierID::PELTIER_NUMBER, ambient);
+        auto read_message = messages::ThermalPlateTempReadComplete{
+            .heat_sink = _converter.backconvert(ambient),
+            .timestamp_ms = timestamp};
+        auto send_temp = [&]() {
+            auto left = _converter.backconvert(temps.at(PELTIER_LEFT));
+            auto right = _converter.backconvert(temps.at(PELTIER_RIGHT));
+            auto center = _converter.backconvert(temps.at(PELTIER_CENTER));
+            read_message.front_left = left;
+            read_message.back_left = left;
+            read_message.front_right = right;
+            read_message.back_right = right;
+            read_message.front_center = center;
+            read_message.back_center = center;
+            read_message.timestamp_ms = timestamp;
+            timestamp += step_ms;
+            static_cast<void>(plate_queue.try_send(read_message));
+            tasks->run_thermal_plate_task();
+        };
+        auto step_plant = [&](PeltierID id) {
+            auto power = policy.get_peltier(id);
+            auto signed_power =
+                (power.first == PeltierDirection::PELTIER_COOLING)
+                    ? -power.second
+                    : power.second;
+            auto &temp = temps.at(id);
+            temp += (128.0 * signed_power - (temp - ambient)) / 40.0 *
+                    (step_ms / 1000.0F);
+        };
+        auto send_and_ack = [&](const messages::ThermalPlateMessage &msg) {
+            host_queue.backing_deque.clear();
+            static_cast<void>(plate_queue.try_send(msg));
+            tasks->run_thermal_plate_task();
+            return std::get<messages::AcknowledgePrevious>(
+                host_queue.backing_deque.front());
+        };
+        auto get_status = [&]() {
+            host_queue.backing_deque.clear();
+            auto get = messages::GetProtocolStatusMessage{.id = 1};
+            static_cast<void>(plate_queue.try_send(get));
+            tasks->run_thermal_plate_task();
+            return std::get<messages::GetProtocolStatusResponse>(
+                host_queue.backing_deque.front());
+        };
+        // Clear out the offsets so the plant temperatures are read directly
+        plate_queue.backing_deque.push_back(messages::SetOffsetConstantsMessage{
+            .id = 456,
+            .channel = PeltierSelection::ALL,
+            .a_set = true,
+            .const_a = 0,
+            .b_set = true,
+            .const_b = 0,
+            .c_set = true,
+            .const_c = 0,
+        });
+        tasks->run_thermal_plate_task();
+        send_temp();
+
+        auto accepted = [&](const messages::ThermalPlateMessage &msg) {
+            return send_and_ack(msg).with_error == errors::ErrorCode::NO_ERROR;
+        };
+        auto lid_released = [&]() {
+            return std::ranges::any_of(
+                lid_queue.backing_deque, [](const auto &msg) {
+                    const auto *deactivate =
+                        std::get_if<messages::DeactivateLidHeatingMessage>(
+                            &msg);
+                    return (deactivate != nullptr) && deactivate->from_plate;
+                });
+        };
+        REQUIRE(accepted(messages::NewProtocolMessage{
+            .id = 2, .lid_temperature = 105.0F, .volume = -1.0F}));
+        REQUIRE(accepted(
+            messages::AddProtocolStageMessage{.id = 3, .cycles = 1}));
+        REQUIRE(accepted(messages::AddProtocolStepMessage{
+            .id = 4,
+            .step =
+                pcr_protocol::Step{.temperature = 90.0F, .hold_time = 1.0F}}));
+        REQUIRE(accepted(
+            messages::AddProtocolStageMessage{.id = 5, .cycles = 2}));
+        REQUIRE(accepted(messages::AddProtocolStepMessage{
+            .id = 6,
+            .step =
+                pcr_protocol::Step{.temperature = 60.0F, .hold_time = 1.0F}}));
+        REQUIRE(accepted(messages::AddProtocolStepMessage{
+            .id = 7,
+            .step = pcr_protocol::Step{
+                .temperature = 72.0F, .hold_time = 1.0F, .ramp_rate = 2.0F}}));
+
+        WHEN("adding an invalid step") {
+            auto response = send_and_ack(messages::AddProtocolStepMessage{
+                .id = 8,
+                .step =
+                    pcr_protocol::Step{.temperature = 60.0F, .hold_time = 0}});
+            THEN("the step is rejected") {
+                REQUIRE(response.responding_to_id == 8);
+                REQUIRE(response.with_error ==
+                        errors::ErrorCode::THERMAL_PROTOCOL_INVALID);
+            }
+        }
+        WHEN("starting the protocol") {
+            lid_queue.backing_deque.clear();
+            auto response =
+                send_and_ack(messages::StartProtocolMessage{.id = 9});
+            THEN("the protocol starts and sets the lid temperature") {
+                REQUIRE(response.responding_to_id == 9);
+                REQUIRE(response.with_error == errors::ErrorCode::NO_ERROR);
+                REQUIRE(get_status().progress.status ==
+                        pcr_protocol::Status::RUNNING);
+                REQUIRE(lid_queue.has_message());
+                auto lid_message = std::get<messages::SetLidTemperatureMessage>(
+                    lid_queue.backing_deque.front());
+                REQUIRE(lid_message.setpoint == 105.0F);
+                REQUIRE(lid_message.from_plate);
+            }
+            AND_WHEN("loading a new protocol while it runs") {
+                auto new_response = send_and_ack(messages::NewProtocolMessage{
+                    .id = 10, .lid_temperature = 0, .volume = -1.0F});
+                THEN("the request is rejected") {
+                    REQUIRE(new_response.with_error ==
+                            errors::ErrorCode::THERMAL_PROTOCOL_INVALID);
+                }
+            }
+            AND_WHEN("setting a plate temperature") {
+                static_cast<void>(
+                    send_and_ack(messages::SetPlateTemperatureMessage{
+                        .id = 11, .setpoint = 50.0F, .hold_time = 0}));
+                THEN("the protocol is aborted and the lid released") {
+                    REQUIRE(get_status().progress.status ==
+                            pcr_protocol::Status::ABORTED);
+                    REQUIRE(lid_released());
+                }
+            }
+            AND_WHEN("the lid reports an error") {
+                lid_queue.backing_deque.clear();
+                host_queue.backing_deque.clear();
+                static_cast<void>(
+                    plate_queue.try_send(messages::LidProtocolErrorMessage{}));
+                tasks->run_thermal_plate_task();
+                THEN("the protocol is aborted and the host is told") {
+                    REQUIRE(lid_released());
+                    auto error = std::get<messages::ErrorMessage>(
+                        host_queue.backing_deque.front());
+                    REQUIRE(error.code ==
+                            errors::ErrorCode::THERMAL_PROTOCOL_ABORTED);
+                    REQUIRE(get_status().progress.status ==
+                            pcr_protocol::Status::ABORTED);
+                }
+                THEN("the plate keeps holding its target") {
+                    send_temp();
+                    REQUIRE(policy._enabled);
+                }
+                AND_WHEN("the lid reports another error") {
+                    host_queue.backing_deque.clear();
+                    static_cast<void>(plate_queue.try_send(
+                        messages::LidProtocolErrorMessage{}));
+                    tasks->run_thermal_plate_task();
+                    THEN("it is ignored") {
+                        REQUIRE(host_queue.backing_deque.empty());
+                    }
+                }
+            }
+            AND_WHEN("the plate follows the protocol") {
+                lid_queue.backing_deque.clear();
+                // Record each stage/step/cycle position the run goes through
+                std::vector<std::array<size_t, 3>> positions;
+                auto status = get_status();
+                for (int i = 0; i < 20000; ++i) {
+                    auto position = std::array<size_t, 3>{
+                        status.progress.stage, status.progress.step,
+                        status.progress.cycle};
+                    if (positions.empty() || positions.back() != position) {
+                        positions.push_back(position);
+                    }
+                    if (status.progress.status !=
+                        pcr_protocol::Status::RUNNING) {
+                        break;
+                    }
+                    step_plant(PELTIER_LEFT);
+                    step_plant(PELTIER_RIGHT);
+                    step_plant(PELTIER_CENTER);
+                    send_temp();
+                    status = get_status();
+                }
+                THEN("every step of every cycle is run in order") {
+                    REQUIRE(status.progress.status ==
+                            pcr_protocol::Status::COMPLETE);
+                    REQUIRE(status.hold_remaining == 0.0F);
+                    auto expected = std::vector<std::array<size_t, 3>>{
+                        {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {1, 0, 1}, {1, 1, 1}};
+                    REQUIRE(positions == expected);
+                }
+                THEN("the lid is released") { REQUIRE(lid_released()); }
+                THEN("the plate holds the final step") {
+                    host_queue.backing_deque.clear();
+                    auto get = messages::GetPlateTempMessage{.id = 12};
+                    static_cast<void>(plate_queue.try_send(get));
+                    tasks->run_thermal_plate_task();
+                    auto temp = std::get<messages::GetPlateTempResponse>(
+                        host_queue.backing_deque.front());
+                    REQUIRE(temp.set_temp == 72.0F);
+                    REQUIRE(policy._enabled);
+                }
+            }
+        }
+        WHEN("starting the protocol with a lid preheat") {
+            lid_queue.backing_deque.clear();
+            auto response = send_and_ack(
+                messages::StartProtocolMessage{.id = 9, .preheat = true});
+            THEN("the lid is told how long the plate needs") {
+                REQUIRE(response.with_error == errors::ErrorCode::NO_ERROR);
+                REQUIRE(lid_queue.has_message());
+                auto lid_message = std::get<messages::SetLidTemperatureMessage>(
+                    lid_queue.backing_deque.front());
+                REQUIRE(lid_message.setpoint == 105.0F);
+                REQUIRE(lid_message.from_plate);
+                // 90ºC from ambient at the estimated heating rate
+                REQUIRE_THAT(
+                    lid_message.preheat_lead_time,
+                    Catch::Matchers::WithinAbs(
+                        (90.0F - ambient) /
+                            plate_control::PlateControl::HEATING_RATE_ESTIMATE,
+                        0.5));
+            }
+            THEN("the plate waits for the lid") {
+                REQUIRE(get_status().progress.status ==
+                        pcr_protocol::Status::PREHEATING);
+                send_temp();
+                REQUIRE(!policy._enabled);
+            }
+            AND_WHEN("the lid says to go") {
+                static_cast<void>(plate_queue.try_send(
+                    messages::LidPreheatDoneMessage{.at_temperature = true}));
+                tasks->run_thermal_plate_task();
+                send_temp();
+                THEN("the plate starts the first step") {
+                    REQUIRE(get_status().progress.status ==
+                            pcr_protocol::Status::RUNNING);
+                    REQUIRE(policy._enabled);
+                }
+            }
+            AND_WHEN("the lid stops heating") {
+                static_cast<void>(plate_queue.try_send(
+                    messages::LidPreheatDoneMessage{.at_temperature = false}));
+                tasks->run_thermal_plate_task();
+                THEN("the protocol is aborted") {
+                    REQUIRE(get_status().progress.status ==
+                            pcr_protocol::Status::ABORTED);
+                }
+            }
+            AND_WHEN("the lid reports an error") {
+                static_cast<void>(
+                    plate_queue.try_send(messages::LidProtocolErrorMessage{}));
+                tasks->run_thermal_plate_task();
+                THEN("the protocol is aborted without starting the plate") {
+                    REQUIRE(get_status().progress.status ==
+                            pcr_protocol::Status::ABORTED);
+                    send_temp();
+                    REQUIRE(!policy._enabled);
+                }
+            }
+        }
+        WHEN("starting a preheat while the lid queue is full") {
+            lid_queue.backing_deque.clear();
+            lid_queue.act_full = true;
+            auto response = send_and_ack(
+                messages::StartProtocolMessage{.id = 9, .preheat = true});
+            lid_queue.act_full = false;
+            THEN("the start fails instead of waiting for the lid") {
+                REQUIRE(response.with_error ==
+                        errors::ErrorCode::INTERNAL_QUEUE_FULL);
+                REQUIRE(get_status().progress.status ==
+                        pcr_protocol::Status::ABORTED);
+                send_temp();
+                REQUIRE(!policy._enabled);
+            }
+        }
+    }
+}
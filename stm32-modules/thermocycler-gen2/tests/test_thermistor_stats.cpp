@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <cmath>
+#include <deque>
+
+#include "catch2/catch.hpp"
+#include "thermocycler-gen2/thermistor_stats.hpp"
+
+using namespace thermistor_stats;
+
+// Repeatable test readings, roughly uniform over +/- 1ºC around a base
+struct Readings {
+    uint32_t state = 4321;
+    auto next(double base) -> double {
+        state = (state * 1103515245U) + 12345U;
+        return base +
+               (static_cast<double>((state >> 16U) & 0x7FFFU) / 32767.0 - 0.5) *
+                   2.0;
+    }
+};
+
+TEST_CASE("window stats match a direct computation") {
+    static constexpr size_t WINDOW = 16;
+    auto subject = WindowStats<WINDOW>();
+    auto window = std::deque<double>();
+    auto readings = Readings();
+    // Cover a few full windows, including a step change in the signal
+    for (size_t i = 0; i < WINDOW * 5; ++i) {
+        auto reading = readings.next(i < WINDOW * 2 ? 40.0F : 90.0F);
+        subject.add(reading);
+        window.push_back(static_cast<float>(reading));
+        if (window.size() > WINDOW) {
+            window.pop_front();
+        }
+        double sum = 0.0F;
+        for (auto value : window) {
+            sum += value;
+        }
+        auto mean = sum / static_cast<double>(window.size());
+        double squares = 0.0F;
+        for (auto value : window) {
+            squares += (value - mean) * (value - mean);
+        }
+        auto variance = squares / static_cast<double>(window.size());
+        REQUIRE(subject.count() == window.size());
+        REQUIRE(subject.mean() == Approx(mean).epsilon(1e-9));
+        REQUIRE(subject.variance() == Approx(variance).margin(1e-9));
+        REQUIRE(subject.min() ==
+                *std::min_element(window.begin(), window.end()));
+        REQUIRE(subject.max() ==
+                *std::max_element(window.begin(), window.end()));
+        REQUIRE(subject.latest() == window.back());
+    }
+}
+
+TEST_CASE("window stats with repeated values") {
+    auto subject = WindowStats<4>();
+    for (auto value : {2.0, 2.0, 1.0, 1.0, 2.0, 2.0}) {
+        subject.add(value);
+    }
+    // The window is 1, 1, 2, 2
+    REQUIRE(subject.min() == 1.0);
+    REQUIRE(subject.max() == 2.0);
+    subject.add(2.0);
+    subject.add(2.0);
+    REQUIRE(subject.min() == 2.0);
+    REQUIRE(subject.variance() == Approx(0.0).margin(1e-12));
+    subject.reset();
+    REQUIRE(subject.count() == 0);
+    REQUIRE(subject.mean() == 0.0);
+    REQUIRE(subject.min() == 0.0);
+    REQUIRE(subject.max() == 0.0);
+}
+
+TEST_CASE("thermistor stats track the plate uniformity") {
+    auto subject = ThermistorStats();
+    // Back left runs 1ºC hot and front right runs 0.5ºC cold
+    auto temperatures =
+        ThermistorStats::Temperatures{51.0, 50.0, 50.0, 50.0, 50.0, 49.5};
+    for (size_t i = 0; i < ThermistorStats::WINDOW + 10; ++i) {
+        subject.update(temperatures);
+    }
+    REQUIRE(subject.samples() == ThermistorStats::WINDOW + 10);
+    REQUIRE(subject.thermistor(0).count() == ThermistorStats::WINDOW);
+    REQUIRE(subject.spread().latest() == Approx(1.5));
+    REQUIRE(subject.spread().mean() == Approx(1.5));
+    REQUIRE(subject.hottest() == Approx(51.0));
+    REQUIRE(subject.pair_spread(0, 5) == Approx(1.5));
+    REQUIRE(subject.pair_spread(5, 1) == Approx(-0.5));
+    REQUIRE(subject.pair_spread(1, 2) == Approx(0.0));
+    WHEN("one thermistor spikes") {
+        temperatures.at(3) = 53.0;
+        subject.update(temperatures);
+        THEN("the spread reflects the spike") {
+            REQUIRE(subject.spread().latest() == Approx(3.5));
+            REQUIRE(subject.spread().max() == Approx(3.5));
+            REQUIRE(subject.spread().min() == Approx(1.5));
+            REQUIRE(subject.hottest() == Approx(53.0));
+            REQUIRE(subject.thermistor(3).max() == Approx(53.0));
+        }
+    }
+    WHEN("summarizing the stats") {
+        auto summary = subject.summary();
+        THEN("every channel is included") {
+            REQUIRE(summary.samples == ThermistorStats::WINDOW + 10);
+            REQUIRE(summary.spread.mean == Approx(1.5));
+            REQUIRE(summary.thermistors.at(0).mean == Approx(51.0));
+            REQUIRE(summary.thermistors.at(5).min == Approx(49.5));
+            REQUIRE(summary.thermistors.at(2).stddev == Approx(0.0));
+        }
+    }
+    WHEN("resetting the stats") {
+        subject.reset();
+        THEN("everything is cleared") {
+            REQUIRE(subject.samples() == 0);
+            REQUIRE(subject.spread().count() == 0);
+            REQUIRE(subject.hottest() == 0.0);
+            REQUIRE(subject.thermistor(0).count() == 0);
+        }
+    }
+}
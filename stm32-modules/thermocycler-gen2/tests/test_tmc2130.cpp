@@ -357,3 +357,75 @@ SCENARIO("tmc2130 register API works") {
         }
     }
 }
+
+SCENARIO("tmc2130 shadows its configuration registers") {
+    GIVEN("a tmc2130 that has written its configuration") {
+        tmc2130::TMC2130RegisterMap registers = {
+            .gconfig = {.en_pwm_mode = 1},
+            .ihold_irun = {.hold_current = 0x1,
+                           .run_current = 0x2,
+                           .hold_current_delay = 0x7},
+            .chopconf = {.toff = 5, .hstrt = 5, .hend = 3, .tbl = 2, .mres = 4},
+            .coolconf = {.sgt = 6}};
+        auto tmc = tmc2130::TMC2130(registers);
+        auto policy = TestTMC2130Policy();
+        REQUIRE(tmc.write_config(policy));
+        REQUIRE(policy.get_messages() == 7);
+        REQUIRE(policy.get_batches() == 1);
+        WHEN("writing the same configuration again") {
+            REQUIRE(tmc.write_config(policy));
+            THEN("nothing is sent") {
+                REQUIRE(policy.get_messages() == 7);
+                REQUIRE(policy.get_batches() == 1);
+            }
+        }
+        WHEN("writing a configuration with one register changed") {
+            registers.coolconf.sgt = 10;
+            REQUIRE(tmc.write_config(registers, policy));
+            THEN("only that register is sent") {
+                REQUIRE(policy.get_messages() == 8);
+                REQUIRE(policy.get_batches() == 2);
+                REQUIRE(tmc.get_register_map().coolconf.sgt == 10);
+            }
+        }
+        WHEN("setting a register to the value it already has") {
+            REQUIRE(tmc.set_cool_config(registers.coolconf, policy));
+            THEN("it is still written, and the shadow stays valid") {
+                REQUIRE(policy.get_messages() == 8);
+                REQUIRE(tmc.write_config(policy));
+                REQUIRE(policy.get_messages() == 8);
+            }
+        }
+        WHEN("the shadow is invalidated") {
+            tmc.invalidate();
+            REQUIRE(tmc.write_config(policy));
+            THEN("every register is written again") {
+                REQUIRE(policy.get_messages() == 14);
+                REQUIRE(policy.get_batches() == 2);
+            }
+        }
+        WHEN("a batch fails") {
+            policy.set_fail_batches(true);
+            registers.coolconf.sgt = 10;
+            REQUIRE(!tmc.write_config(registers, policy));
+            policy.set_fail_batches(false);
+            THEN("the next configuration writes every register") {
+                REQUIRE(tmc.write_config(registers, policy));
+                REQUIRE(policy.get_messages() == 14);
+                REQUIRE(tmc.get_register_map().coolconf.sgt == 10);
+            }
+        }
+        WHEN("reading the driver status and step period") {
+            policy.write_register(tmc2130::Registers::DRVSTATUS, 0x1234);
+            policy.write_register(tmc2130::Registers::TSTEP, 0x5678);
+            auto ret = tmc.get_driver_status_and_tstep(policy);
+            THEN("both are read in one batch of three messages") {
+                REQUIRE(ret.has_value());
+                REQUIRE(ret.value().first.sg_result == 0x234);
+                REQUIRE(ret.value().second.value == 0x5678);
+                REQUIRE(policy.get_messages() == 10);
+                REQUIRE(policy.get_batches() == 2);
+            }
+        }
+    }
+}
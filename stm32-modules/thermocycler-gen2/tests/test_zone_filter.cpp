@@ -0,0 +1,113 @@
+#include <cmath>
+#include <deque>
+#include <vector>
+
+#include "catch2/catch.hpp"
+#include "thermocycler-gen2/plate_model.hpp"
+#include "thermocycler-gen2/zone_filter.hpp"
+
+using namespace zone_filter;
+
+static constexpr double UPDATE_RATE_SEC = 0.05F;
+static constexpr double ROOM_TEMP = 23.0F;
+static constexpr double HOT_TEMP = 95.0F;
+static constexpr double RAMP_RATE = 3.0F;
+
+// Repeatable thermistor noise, roughly uniform over +/- 0.15ºC
+struct Noise {
+    uint32_t state = 12345;
+    auto next() -> double {
+        state = (state * 1103515245U) + 12345U;
+        return (static_cast<double>((state >> 16U) & 0x7FFFU) / 32767.0 -
+                0.5) *
+               0.3;
+    }
+};
+
+static auto rms(const std::vector<double> &errors) -> double {
+    double sum = 0.0F;
+    for (auto error : errors) {
+        sum += error * error;
+    }
+    return std::sqrt(sum / static_cast<double>(errors.size()));
+}
+
+TEST_CASE("zone filter initialization") {
+    auto subject = ZoneFilter();
+    REQUIRE(!subject.initialized());
+    subject.update(ROOM_TEMP, ROOM_TEMP + 1.0F, 0.0F, ROOM_TEMP,
+                   plate_model::PlateModel(), UPDATE_RATE_SEC);
+    THEN("the filter starts from the average of the thermistors") {
+        REQUIRE(subject.initialized());
+        REQUIRE(subject.temp() == ROOM_TEMP + 0.5F);
+        REQUIRE(subject.rate() == 0.0F);
+    }
+    WHEN("resetting the filter") {
+        subject.reset();
+        THEN("it restarts on the next update") {
+            REQUIRE(!subject.initialized());
+            subject.update(HOT_TEMP, HOT_TEMP, 0.0F, ROOM_TEMP,
+                           plate_model::PlateModel(), UPDATE_RATE_SEC);
+            REQUIRE(subject.temp() == HOT_TEMP);
+        }
+    }
+}
+
+TEST_CASE("zone filter reduces noise without lag") {
+    auto subject = ZoneFilter();
+    auto noise = Noise();
+    std::vector<double> raw_errors;
+    std::vector<double> filtered_errors;
+    double temp = ROOM_TEMP;
+    // Settle, ramp, then hold
+    for (double t = 0; t < 90.0; t += UPDATE_RATE_SEC) {
+        if (t > 10.0F) {
+            temp = std::min(temp + (RAMP_RATE * UPDATE_RATE_SEC), HOT_TEMP);
+        }
+        auto front = temp + noise.next();
+        auto back = temp + noise.next();
+        subject.update(front, back, 0.0F, ROOM_TEMP,
+                       plate_model::PlateModel(), UPDATE_RATE_SEC);
+        // Skip the corners of the ramp, where the rate changes suddenly
+        bool corner = (t > 9.0F && t < 15.0F) || (t > 32.0F && t < 38.0F);
+        if (t > 5.0F && !corner) {
+            raw_errors.push_back(((front + back) / 2.0F) - temp);
+            filtered_errors.push_back(subject.temp() - temp);
+        }
+    }
+    THEN("the filtered temperature is less noisy") {
+        REQUIRE(rms(filtered_errors) < rms(raw_errors) * 0.6F);
+    }
+    THEN("the filtered temperature doesn't fall behind the ramp") {
+        double mean = 0.0F;
+        for (auto error : filtered_errors) {
+            mean += error;
+        }
+        mean /= static_cast<double>(filtered_errors.size());
+        REQUIRE(std::abs(mean) < 0.05F);
+    }
+    THEN("the filter settles at the final temperature") {
+        REQUIRE_THAT(subject.temp(), Catch::Matchers::WithinAbs(HOT_TEMP, 0.1));
+    }
+}
+
+TEST_CASE("zone filter uses the plate model") {
+    auto model = plate_model::PlateModel{
+        .gain = 128.0, .time_constant = 40.0, .dead_time = 1.5};
+    auto subject = ZoneFilter();
+    auto noise = Noise();
+    double temp = ROOM_TEMP;
+    double worst = 0.0F;
+    // Drive at constant power, starting at room temperature
+    constexpr double power = 0.5F;
+    for (double t = 0; t < 60.0; t += UPDATE_RATE_SEC) {
+        temp += ((model.gain * power) - (temp - ROOM_TEMP)) /
+                model.time_constant * UPDATE_RATE_SEC;
+        subject.update(temp + noise.next(), temp + noise.next(), power,
+                       ROOM_TEMP, model, UPDATE_RATE_SEC);
+        if (t > 5.0F) {
+            worst = std::max(worst, std::abs(subject.temp() - temp));
+        }
+    }
+    THEN("the estimate follows the plate closely") { REQUIRE(worst < 0.15F); }
+}